@@ -12,10 +12,13 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "hudview_memlock.h"
+#include "hudview_metrics.h"
+#include "hudview_trace.h"
 #include "mma8451_pi.h"
 /*--------------------------------------------------------------------------------------------------------------------*/
 
-#define WAIT_TIME_MILLISECONDS ( 500 )
+#define WAIT_TIME_MILLISECONDS ( 50 )
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 static void vSignalHandler( int iSignal );
@@ -27,6 +30,10 @@ int main()
     const int iBus = 1;
     mma8451 xSensor;
     mma8451_vector3 xReading;
+    xHUDViewMetricsComponent_t * pxMetrics = NULL;
+    uint64_t ullReadStart = 0;
+    uint64_t ullWritten = 0;
+    uint32_t ulRecords = 0;
     int iReturn = -1;
 
     /* Install the Ctrl-C handler. */
@@ -35,6 +42,15 @@ int main()
     /* Disable buffering on standard output. */
     setbuf( stdout, NULL );
 
+    /* Keep every page resident if the control application asked for it, so sampling never waits on a page fault. */
+    if ( 0 > iHUDViewLockMemoryIfRequested() )
+    {
+        fprintf( stderr, "Failed to lock memory\n" );
+    }
+
+    /* Report read-to-stdout latency through the control application's metrics page, if it is running. */
+    pxMetrics = pxHUDViewMetricsComponent( pxHUDViewMetricsAttach( 0, 1 ), "Accelerometer" );
+
     /* Initialize the sensor. */
     xSensor = mma8451_initialise( iBus, iSensorAddress );
 
@@ -46,8 +62,13 @@ int main()
 
     for ( ;; )
     {
+        ullReadStart = ullHUDViewMetricsNow();
         mma8451_get_acceleration( &xSensor, &xReading );
-        printf( "%f,%f,%f\n", xReading.x, xReading.y, xReading.z );
+        printf( HUDVIEW_TRACE_STAMP_FORMAT "%f,%f,%f\n", ++ulRecords, ullReadStart, xReading.x, xReading.y,
+                xReading.z );
+        ullWritten = ullHUDViewMetricsNow();
+        vHUDViewMetricsRecord( pxMetrics, eHUDViewMetricsStage_SensorToStdout, ullWritten - ullReadStart );
+        vHUDViewMetricsMarkWrite( pxMetrics, ullWritten );
         usleep( WAIT_TIME_MILLISECONDS *  1000 );
     }
 
@@ -5,6 +5,7 @@ import argparse
 import io
 import os
 import signal
+import threading
 
 class StreamingObject(object):
   def __init__(self):
@@ -20,12 +21,31 @@ class StreamingObject(object):
     return self.buffer.write(buf)
 
 
-def run(self, format, fps):
+def follow_rate_commands(camera, control, max_fps, state):
+  # Control writes "fps N" when the scene or the rider's speed calls for another rate. The sensor stays set up for
+  # max_fps and the delta brings it down, as only the delta can change while recording.
+  try:
+    os.mkfifo(control)
+  except FileExistsError:
+    pass
+
+  # Held open for writing too, so reads wait for the next command rather than end when Control closes its end.
+  with os.fdopen(os.open(control, os.O_RDWR), 'r') as commands:
+    for line in commands:
+      words = line.split()
+      if state['close']:
+        break
+      if len(words) == 2 and words[0] == 'fps' and words[1].isdigit():
+        camera.framerate_delta = min(max(int(words[1]), 1), max_fps) - max_fps
+
+
+def run(resolution, fps, max_fps, frame_format):
   fifo = '/tmp/hudview_camera_output'
-  self.close = False;
+  control = '/tmp/hudview_camera_control'
+  state = {'close': False}
 
   def close_camera(sig, frame):
-    self.close = True
+    state['close'] = True
 
   signal.signal(signal.SIGINT, close_camera)
   signal.signal(signal.SIGTERM, close_camera)
@@ -35,24 +55,26 @@ def run(self, format, fps):
   #except OSError as err:
   #  return err
 
-  with PiCamera(resolution='160x120', framerate=10) as camera:
-    with open(fifo, "w") as file:
-      stream = StreamingObject()
-      camera.hflip = True
-      camera.start_recording(file, format='rgb')
-      if self.close:
-        camera.close()
-        return
+  with PiCamera(resolution=resolution, framerate=max_fps) as camera:
+    camera.framerate_delta = min(fps, max_fps) - max_fps
+    threading.Thread(target=follow_rate_commands, args=(camera, control, max_fps, state), daemon=True).start()
+    with open(fifo, "wb") as file:
+      # Frames go out as captured; Control orients, crops and scales them to the display (Control --camera).
+      # MJPEG is a thirtieth of the bytes and needs Control told so, e.g. --camera 640x480:hflip:mjpeg.
+      camera.start_recording(file, format='mjpeg' if frame_format == 'mjpeg' else 'rgb')
+      while not state['close']:
+        camera.wait_recording(1)
+      camera.stop_recording()
 
 
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
-    parser.add_argument('--format', metavar='N', type=int, nargs="+", help="Video output format")
-    parser.add_argument('--fps', metavar='N', type=int, nargs="+", help="Video framerate")
+    parser.add_argument('--resolution', default='160x120', help="Capture resolution, WIDTHxHEIGHT")
+    parser.add_argument('--fps', type=int, default=10, help="Video framerate until Control asks for another")
+    parser.add_argument('--max-fps', type=int, default=30, help="Highest framerate Control may ask for")
+    parser.add_argument('--format', choices=['rgb', 'mjpeg'], default='rgb', help="Raw RGB888 or MJPEG frames")
 
     args = parser.parse_args()
 
-    run(args.format, args.fps)
-
-
+    run(args.resolution, args.fps, args.max_fps, args.format)
@@ -0,0 +1,268 @@
+/** @file hudview_button.c
+ *  @brief HUDView handlebar button decoding.
+ */
+
+#include <string.h>
+
+#include "hudview_button.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* What a deadline decides. */
+typedef enum {
+    eDeadline_None = 0,
+    eDeadline_Settle,
+    eDeadline_Long,
+    eDeadline_Short
+} eDeadline_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const char * apcRecords[ eHUDViewButtonEventMax ] = { "", HUDVIEW_BUTTON_RECORD_SHORT,
+                                                             HUDVIEW_BUTTON_RECORD_LONG,
+                                                             HUDVIEW_BUTTON_RECORD_DOUBLE };
+static const char * apcNames[ eHUDViewButtonEventMax ] = { "none", "short", "long", "double" };
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint64_t ullNextDeadline( const xHUDViewButton_t * pxButton, eDeadline_t * peDeadline );
+static void vConsider( const xHUDViewButton_t * pxButton, uint64_t ullDeadline, eDeadline_t eDeadline,
+                       uint64_t * pullNext, eDeadline_t * peNext );
+static void vSettle( xHUDViewButton_t * pxButton, uint64_t ullDecided );
+static void vQueue( xHUDViewButton_t * pxButton, eHUDViewButtonEvent_t eEvent, uint64_t ullDecided );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewButtonInit( xHUDViewButton_t * pxButton, uint64_t ullDebounceNanoseconds, uint64_t ullLongNanoseconds,
+                         uint64_t ullDoubleNanoseconds, int bPressed )
+{
+    memset( pxButton, 0, sizeof( *pxButton ) );
+    pxButton->ullDebounceNanoseconds = ullDebounceNanoseconds;
+    pxButton->ullLongNanoseconds = ullLongNanoseconds;
+    pxButton->ullDoubleNanoseconds = ullDoubleNanoseconds;
+    pxButton->bRawPressed = bPressed;
+    pxButton->bPressed = bPressed;
+
+    /* A press already under way at startup was not seen begin, so it is not taken as anything. */
+    pxButton->bLongReported = bPressed;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewButtonEdge( xHUDViewButton_t * pxButton, uint64_t ullTimestamp, int bPressed )
+{
+    /* Edges come in order, but never let one go back before the last. */
+    if ( ullTimestamp < pxButton->ullLastEdge )
+    {
+        ullTimestamp = pxButton->ullLastEdge;
+    }
+
+    vHUDViewButtonAdvance( pxButton, ullTimestamp );
+
+    if ( !pxButton->bBurst )
+    {
+        pxButton->bBurst = 1;
+        pxButton->ullBurstStart = ullTimestamp;
+        pxButton->xStatistics.ulBursts++;
+    }
+
+    pxButton->bRawPressed = ( 0 != bPressed );
+    pxButton->ullLastEdge = ullTimestamp;
+    pxButton->xStatistics.ulEdges++;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewButtonAdvance( xHUDViewButton_t * pxButton, uint64_t ullNow )
+{
+    eDeadline_t eDeadline = eDeadline_None;
+    uint64_t ullDeadline = ullNextDeadline( pxButton, &eDeadline );
+    uint64_t ullDecided = 0;
+
+    /* Deadlines are taken in time order, as each can change what the next one is; one that waited for a burst to
+     * settle was only decided when it did. */
+    while ( ( eDeadline_None != eDeadline ) && ( ullDeadline <= ullNow ) )
+    {
+        if ( ullDeadline > ullDecided )
+        {
+            ullDecided = ullDeadline;
+        }
+
+        switch ( eDeadline )
+        {
+        case eDeadline_Settle:
+            vSettle( pxButton, ullDecided );
+            break;
+
+        case eDeadline_Long:
+            pxButton->bLongReported = 1;
+            vQueue( pxButton, eHUDViewButtonEvent_Long, ullDecided );
+            break;
+
+        case eDeadline_Short:
+            pxButton->bShortPending = 0;
+            vQueue( pxButton, eHUDViewButtonEvent_Short, ullDecided );
+            break;
+
+        default:
+            break;
+        }
+
+        ullDeadline = ullNextDeadline( pxButton, &eDeadline );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint64_t ullHUDViewButtonDeadline( const xHUDViewButton_t * pxButton )
+{
+    eDeadline_t eDeadline = eDeadline_None;
+
+    return ullNextDeadline( pxButton, &eDeadline );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+eHUDViewButtonEvent_t eHUDViewButtonNextEvent( xHUDViewButton_t * pxButton, uint64_t * pullPressed,
+                                               uint64_t * pullDecided )
+{
+    eHUDViewButtonEvent_t eReturn = eHUDViewButtonEvent_None;
+
+    if ( 0 < pxButton->iQueued )
+    {
+        eReturn = pxButton->aeQueue[ pxButton->iQueueHead ];
+
+        if ( NULL != pullPressed )
+        {
+            *pullPressed = pxButton->aullPressed[ pxButton->iQueueHead ];
+        }
+
+        if ( NULL != pullDecided )
+        {
+            *pullDecided = pxButton->aullDecided[ pxButton->iQueueHead ];
+        }
+
+        pxButton->iQueueHead = ( pxButton->iQueueHead + 1 ) % HUDVIEW_BUTTON_QUEUE;
+        pxButton->iQueued--;
+    }
+
+    return eReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewButtonRecord( eHUDViewButtonEvent_t eEvent )
+{
+    return ( ( 0 <= eEvent ) && ( eHUDViewButtonEventMax > eEvent ) ) ? apcRecords[ eEvent ] : "";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewButtonEventName( eHUDViewButtonEvent_t eEvent )
+{
+    return ( ( 0 <= eEvent ) && ( eHUDViewButtonEventMax > eEvent ) ) ? apcNames[ eEvent ] : "none";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint64_t ullNextDeadline( const xHUDViewButton_t * pxButton, eDeadline_t * peDeadline )
+{
+    uint64_t ullNext = 0;
+
+    *peDeadline = eDeadline_None;
+
+    if ( pxButton->bBurst )
+    {
+        vConsider( pxButton, pxButton->ullLastEdge + pxButton->ullDebounceNanoseconds, eDeadline_Settle, &ullNext,
+                   peDeadline );
+    }
+
+    if ( pxButton->bPressed && !pxButton->bLongReported && !pxButton->bDoublePressed )
+    {
+        vConsider( pxButton, pxButton->ullPressed + pxButton->ullLongNanoseconds, eDeadline_Long, &ullNext,
+                   peDeadline );
+    }
+
+    if ( pxButton->bShortPending )
+    {
+        vConsider( pxButton, pxButton->ullReleased + pxButton->ullDoubleNanoseconds, eDeadline_Short, &ullNext,
+                   peDeadline );
+    }
+
+    return ullNext;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vConsider( const xHUDViewButton_t * pxButton, uint64_t ullDeadline, eDeadline_t eDeadline,
+                       uint64_t * pullNext, eDeadline_t * peNext )
+{
+    /* A burst that began by the deadline may yet turn out to be a press or release before it, so the deadline waits
+     * for the burst to settle; one that began after it cannot change what the deadline decides. */
+    if ( ( eDeadline_Settle != eDeadline ) && pxButton->bBurst && ( pxButton->ullBurstStart <= ullDeadline ) )
+    {
+        return;
+    }
+
+    if ( ( eDeadline_None == *peNext ) || ( ullDeadline < *pullNext ) )
+    {
+        *pullNext = ullDeadline;
+        *peNext = eDeadline;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSettle( xHUDViewButton_t * pxButton, uint64_t ullDecided )
+{
+    pxButton->bBurst = 0;
+
+    /* Back where it started: a glitch, not a press. */
+    if ( pxButton->bRawPressed == pxButton->bPressed )
+    {
+        pxButton->xStatistics.ulGlitches++;
+        return;
+    }
+
+    pxButton->bPressed = pxButton->bRawPressed;
+
+    if ( pxButton->bPressed )
+    {
+        pxButton->ullPressed = pxButton->ullBurstStart;
+        pxButton->bLongReported = 0;
+        pxButton->bDoublePressed = 0;
+
+        /* Still waiting to see whether the last press was a short one: this makes it a double. */
+        if ( pxButton->bShortPending )
+        {
+            pxButton->bShortPending = 0;
+            pxButton->bDoublePressed = 1;
+            vQueue( pxButton, eHUDViewButtonEvent_Double, ullDecided );
+        }
+    }
+    else
+    {
+        pxButton->ullReleased = pxButton->ullBurstStart;
+
+        /* A long or double press was reported while it was held; anything else was a short press. */
+        if ( pxButton->bLongReported || pxButton->bDoublePressed )
+        {
+            /* Nothing to do. */
+        }
+        else if ( 0 == pxButton->ullDoubleNanoseconds )
+        {
+            vQueue( pxButton, eHUDViewButtonEvent_Short, ullDecided );
+        }
+        else
+        {
+            pxButton->bShortPending = 1;
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vQueue( xHUDViewButton_t * pxButton, eHUDViewButtonEvent_t eEvent, uint64_t ullDecided )
+{
+    int iTail = 0;
+
+    if ( HUDVIEW_BUTTON_QUEUE <= pxButton->iQueued )
+    {
+        pxButton->xStatistics.ulDropped++;
+        return;
+    }
+
+    iTail = ( pxButton->iQueueHead + pxButton->iQueued ) % HUDVIEW_BUTTON_QUEUE;
+    pxButton->aeQueue[ iTail ] = eEvent;
+    pxButton->aullPressed[ iTail ] = pxButton->ullPressed;
+    pxButton->aullDecided[ iTail ] = ullDecided;
+    pxButton->iQueued++;
+    pxButton->xStatistics.aulEvents[ eEvent ]++;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
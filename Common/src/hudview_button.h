@@ -0,0 +1,118 @@
+/** @file hudview_button.h
+ *  @brief HUDView handlebar button decoding.
+ *
+ *  The button daemon is handed every edge of the button's GPIO line with the kernel's timestamp of it, and decodes
+ *  them into short, long and double presses. All timing is done on those timestamps rather than on when the edges
+ *  were read, so a late wakeup can delay an event but never change which event it is.
+ *
+ *  Debouncing: the first edge after the line has been steady starts a burst, and the burst is over once the line has
+ *  held a level for the debounce time. If it settled at the other level the button was pressed or released at the
+ *  burst's first edge; if it came back to where it was, it was a glitch, such as a spike picked up by the wiring, and
+ *  is dropped. A burst only delays what depends on it: a deadline before the burst began is decided regardless.
+ *
+ *  Decoding: a press held for the long time is a long press, reported as soon as it has been held that long. A press
+ *  that starts within the double time of the last release is a double press, reported once it has settled. Any other
+ *  press is a short press, reported when the double time has passed without another one, or at once on release when
+ *  double presses are not wanted.
+ *
+ *  Everything is fixed-size and nothing is allocated; the caller passes in the time, so edges can be replayed.
+ */
+
+#ifndef HUDVIEW_BUTTON_H
+#define HUDVIEW_BUTTON_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Contacts bounce for a few milliseconds; a second press within a third of a second is a double press. */
+#define HUDVIEW_BUTTON_DEBOUNCE_NS          ( 10000000ULL )
+#define HUDVIEW_BUTTON_LONG_NS              ( 800000000ULL )
+#define HUDVIEW_BUTTON_DOUBLE_NS            ( 300000000ULL )
+
+/* Decoded presses wait here until they are taken. */
+#define HUDVIEW_BUTTON_QUEUE                ( 8 )
+
+/* What the daemon prints for each press, one a line; a short press is "0", as the first button script printed. */
+#define HUDVIEW_BUTTON_RECORD_SHORT         "0"
+#define HUDVIEW_BUTTON_RECORD_LONG          "1"
+#define HUDVIEW_BUTTON_RECORD_DOUBLE        "2"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eHUDViewButtonEvent_None = 0,
+    eHUDViewButtonEvent_Short,
+    eHUDViewButtonEvent_Long,
+    eHUDViewButtonEvent_Double,
+
+    eHUDViewButtonEventMax
+} eHUDViewButtonEvent_t;
+
+typedef struct {
+    unsigned long ulEdges;
+    unsigned long ulBursts;
+    unsigned long ulGlitches;
+    unsigned long ulDropped;
+    unsigned long aulEvents[ eHUDViewButtonEventMax ];
+} xHUDViewButtonStatistics_t;
+
+typedef struct {
+    uint64_t ullDebounceNanoseconds;
+    uint64_t ullLongNanoseconds;
+    uint64_t ullDoubleNanoseconds;
+
+    /* The line as of its last edge, and the burst that edge belongs to, if the line has not settled since. */
+    int bRawPressed;
+    uint64_t ullLastEdge;
+    int bBurst;
+    uint64_t ullBurstStart;
+
+    /* The settled state: when the press or release began, and what the current press has already been taken as. */
+    int bPressed;
+    uint64_t ullPressed;
+    uint64_t ullReleased;
+    int bLongReported;
+    int bDoublePressed;
+    int bShortPending;
+
+    /* Decoded presses, with when each began and when it could first be told apart. */
+    eHUDViewButtonEvent_t aeQueue[ HUDVIEW_BUTTON_QUEUE ];
+    uint64_t aullPressed[ HUDVIEW_BUTTON_QUEUE ];
+    uint64_t aullDecided[ HUDVIEW_BUTTON_QUEUE ];
+    int iQueueHead;
+    int iQueued;
+
+    xHUDViewButtonStatistics_t xStatistics;
+} xHUDViewButton_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Starts with the line settled at bPressed; a zero double time reports short presses on release. */
+void vHUDViewButtonInit( xHUDViewButton_t * pxButton, uint64_t ullDebounceNanoseconds, uint64_t ullLongNanoseconds,
+                         uint64_t ullDoubleNanoseconds, int bPressed );
+
+/* An edge of the line, in timestamp order: whatever was decided before it is decided first. */
+void vHUDViewButtonEdge( xHUDViewButton_t * pxButton, uint64_t ullTimestamp, int bPressed );
+
+/* Decides whatever has become certain by ullNow. */
+void vHUDViewButtonAdvance( xHUDViewButton_t * pxButton, uint64_t ullNow );
+
+/* When vHUDViewButtonAdvance() next has something to decide, or 0 if nothing will happen without another edge. */
+uint64_t ullHUDViewButtonDeadline( const xHUDViewButton_t * pxButton );
+
+/* Takes the oldest decoded press, when it began (the second press of a double) and when it was decided, or returns
+ * eHUDViewButtonEvent_None. */
+eHUDViewButtonEvent_t eHUDViewButtonNextEvent( xHUDViewButton_t * pxButton, uint64_t * pullPressed,
+                                               uint64_t * pullDecided );
+
+const char * pcHUDViewButtonRecord( eHUDViewButtonEvent_t eEvent );
+const char * pcHUDViewButtonEventName( eHUDViewButtonEvent_t eEvent );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_BUTTON_H
@@ -0,0 +1,727 @@
+/** @file hudview_dashcam.c
+ *  @brief HUDView rear camera loop recording.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_dashcam.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define BLOCK_ALIGN( ullValue ) \
+    ( ( ( ullValue ) + HUDVIEW_DASHCAM_BLOCK_BYTES - 1 ) & ~( uint64_t )( HUDVIEW_DASHCAM_BLOCK_BYTES - 1 ) )
+#define NANOSECONDS_PER_SECOND ( 1000000000LL )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void * pvWriterThread( void * pvDashcam );
+static void vAppendFrame( xHUDViewDashcam_t * pxDashcam, const uint8_t * pucFrame, int64_t llNanoseconds );
+static int iOpenSegment( xHUDViewDashcam_t * pxDashcam );
+static void vCloseSegment( xHUDViewDashcam_t * pxDashcam );
+static int iWriteStaged( xHUDViewDashcam_t * pxDashcam );
+static int iWriteHeader( xHUDViewDashcam_t * pxDashcam, int iDescriptor, int iSegment, int bClosed );
+static int iWriteAt( xHUDViewDashcam_t * pxDashcam, int iDescriptor, const void * pvData, size_t ulBytes,
+                     uint64_t ullOffset );
+static void vHandleImpact( xHUDViewDashcam_t * pxDashcam, int64_t llNanoseconds );
+static int bSegmentInEvent( const xHUDViewDashcam_t * pxDashcam, int iSegment );
+static void vKeepSegment( xHUDViewDashcam_t * pxDashcam, int iSegment );
+static void vSegmentPath( const xHUDViewDashcam_t * pxDashcam, int iSegment, char * pcPath, size_t ulSize );
+static void vFree( xHUDViewDashcam_t * pxDashcam );
+static int64_t llMonotonicNanoseconds( void );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewDashcamOpen( xHUDViewDashcam_t * pxDashcam, const char * pcDirectory, const char * pcFormat,
+                         uint32_t ulFrameBytes, uint64_t ullSegmentBytes, int iSegments )
+{
+    xHUDViewDashcamHeader_t xHeader;
+    pthread_condattr_t xConditionAttributes;
+    struct timespec xNow;
+    char acPath[ PATH_MAX ];
+    int64_t llNewest = -1;
+    int iNewest = -1;
+    int iDescriptor = -1;
+    int iSegment = 0;
+
+    memset( pxDashcam, 0, sizeof( xHUDViewDashcam_t ) );
+    pxDashcam->iDescriptor = -1;
+
+    ullSegmentBytes &= ~( uint64_t )( HUDVIEW_DASHCAM_BLOCK_BYTES - 1 );
+
+    if ( ( 0 == ulFrameBytes ) || ( 2 > iSegments ) || ( HUDVIEW_DASHCAM_MAXIMUM_SEGMENTS < iSegments )
+         || ( sizeof( pxDashcam->acDirectory ) <= strlen( pcDirectory ) )
+         || ( HUDVIEW_DASHCAM_FORMAT_LENGTH <= strlen( pcFormat ) )
+         || ( HUDVIEW_DASHCAM_BLOCK_BYTES + sizeof( xHUDViewDashcamFrameHeader_t ) + ulFrameBytes > ullSegmentBytes ) )
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    strcpy( pxDashcam->acDirectory, pcDirectory );
+    strcpy( pxDashcam->acFormat, pcFormat );
+    pxDashcam->ulFrameBytes = ulFrameBytes;
+    pxDashcam->ulRecordBytes = sizeof( xHUDViewDashcamFrameHeader_t ) + ulFrameBytes;
+    pxDashcam->ullSegmentBytes = ullSegmentBytes;
+    pxDashcam->iSegments = iSegments;
+
+    /* Staging holds a full write, the record that tipped it over and the partial block carried over from the last
+     * one, rounded up to whole blocks. Every buffer is allocated here, so recording a frame never allocates. */
+    pxDashcam->ulStagingCapacity =
+        BLOCK_ALIGN( HUDVIEW_DASHCAM_WRITE_BYTES + pxDashcam->ulRecordBytes ) + 2 * HUDVIEW_DASHCAM_BLOCK_BYTES;
+    pxDashcam->pucQueue = malloc( ( size_t )HUDVIEW_DASHCAM_QUEUE_FRAMES * ulFrameBytes );
+
+    if ( ( NULL == pxDashcam->pucQueue )
+         || ( 0 != posix_memalign( ( void ** )&pxDashcam->pucStaging, HUDVIEW_DASHCAM_BLOCK_BYTES,
+                                   pxDashcam->ulStagingCapacity ) )
+         || ( 0 != posix_memalign( ( void ** )&pxDashcam->pucHeaderBlock, HUDVIEW_DASHCAM_BLOCK_BYTES,
+                                   HUDVIEW_DASHCAM_BLOCK_BYTES ) ) )
+    {
+        vFree( pxDashcam );
+        errno = ENOMEM;
+        return -1;
+    }
+
+    /* Every segment is preallocated now, and what each one holds from the last run is read back so the loop carries
+     * on after the newest rather than overwriting it, and so an impact early in the ride can still keep the minute
+     * before it. A segment that was never closed is where the last run stopped. */
+    for ( iSegment = 0; iSegment < iSegments; iSegment++ )
+    {
+        vSegmentPath( pxDashcam, iSegment, acPath, sizeof( acPath ) );
+        iDescriptor = open( acPath, O_RDWR | O_CREAT, 0644 );
+
+        if ( 0 > iDescriptor )
+        {
+            vFree( pxDashcam );
+            return -1;
+        }
+
+        errno = posix_fallocate( iDescriptor, 0, ( off_t )ullSegmentBytes );
+
+        if ( 0 != errno )
+        {
+            close( iDescriptor );
+            vFree( pxDashcam );
+            return -1;
+        }
+
+        if ( ( 0 == iHUDViewDashcamReadHeader( iDescriptor, &xHeader ) ) && ( ulFrameBytes == xHeader.ulFrameBytes ) )
+        {
+            if ( 0 == xHeader.ulClosed )
+            {
+                iNewest = iSegment;
+                llNewest = INT64_MAX;
+            }
+            else
+            {
+                pxDashcam->axSegments[ iSegment ].ullFirstSequence = xHeader.ullFirstSequence;
+                pxDashcam->axSegments[ iSegment ].ullFrames = xHeader.ullFrames;
+                pxDashcam->axSegments[ iSegment ].llFirstNanoseconds = xHeader.llFirstNanoseconds;
+                pxDashcam->axSegments[ iSegment ].llLastNanoseconds = xHeader.llLastNanoseconds;
+
+                if ( llNewest < xHeader.llLastNanoseconds )
+                {
+                    iNewest = iSegment;
+                    llNewest = xHeader.llLastNanoseconds;
+                }
+            }
+        }
+
+        close( iDescriptor );
+    }
+
+    pxDashcam->iSegment = ( iNewest + 1 ) % iSegments;
+
+    /* Sequence numbers start from the wall clock, so records left over from an earlier run never follow on. */
+    clock_gettime( CLOCK_REALTIME, &xNow );
+    pxDashcam->ullSequence = ( uint64_t )xNow.tv_sec * NANOSECONDS_PER_SECOND + ( uint64_t )xNow.tv_nsec;
+
+    pthread_condattr_init( &xConditionAttributes );
+    pthread_condattr_setclock( &xConditionAttributes, CLOCK_MONOTONIC );
+    pthread_mutex_init( &pxDashcam->xMutex, NULL );
+    pthread_cond_init( &pxDashcam->xCondition, &xConditionAttributes );
+    pthread_condattr_destroy( &xConditionAttributes );
+
+    pxDashcam->llOpenedNanoseconds = llMonotonicNanoseconds();
+
+    if ( 0 != pthread_create( &pxDashcam->xThread, NULL, pvWriterThread, pxDashcam ) )
+    {
+        pthread_cond_destroy( &pxDashcam->xCondition );
+        pthread_mutex_destroy( &pxDashcam->xMutex );
+        vFree( pxDashcam );
+        return -1;
+    }
+
+    pxDashcam->bThreadStarted = 1;
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewDashcamRecordFrame( xHUDViewDashcam_t * pxDashcam, const uint8_t * pucFrame, int64_t llNanoseconds )
+{
+    int iSlot = 0;
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->xStatistics.ullFramesOffered++;
+
+    if ( ( pxDashcam->bStopping ) || ( HUDVIEW_DASHCAM_QUEUE_FRAMES <= pxDashcam->iQueueCount ) )
+    {
+        pxDashcam->xStatistics.ullFramesDropped++;
+        pthread_mutex_unlock( &pxDashcam->xMutex );
+        return -1;
+    }
+
+    iSlot = ( pxDashcam->iQueueHead + pxDashcam->iQueueCount ) % HUDVIEW_DASHCAM_QUEUE_FRAMES;
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    /* The writer only ever takes from the head, so the free slot stays free while the frame is copied in. */
+    memcpy( pxDashcam->pucQueue + ( size_t )iSlot * pxDashcam->ulFrameBytes, pucFrame, pxDashcam->ulFrameBytes );
+    pxDashcam->allQueueNanoseconds[ iSlot ] = llNanoseconds;
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->iQueueCount++;
+
+    if ( pxDashcam->xStatistics.iQueueHighWater < pxDashcam->iQueueCount )
+    {
+        pxDashcam->xStatistics.iQueueHighWater = pxDashcam->iQueueCount;
+    }
+
+    pthread_cond_signal( &pxDashcam->xCondition );
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewDashcamReportImpact( xHUDViewDashcam_t * pxDashcam, int64_t llNanoseconds )
+{
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->llPendingEventNanoseconds = llNanoseconds;
+    pthread_cond_signal( &pxDashcam->xCondition );
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewDashcamGetStatistics( xHUDViewDashcam_t * pxDashcam, xHUDViewDashcamStatistics_t * pxStatistics )
+{
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    *pxStatistics = pxDashcam->xStatistics;
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    pxStatistics->llRecordingNanoseconds = llMonotonicNanoseconds() - pxDashcam->llOpenedNanoseconds;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewDashcamInjectStalls( xHUDViewDashcam_t * pxDashcam, int iEveryWrites, int iMilliseconds )
+{
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->iStallEveryWrites = iEveryWrites;
+    pxDashcam->iStallMilliseconds = iMilliseconds;
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewDashcamClose( xHUDViewDashcam_t * pxDashcam )
+{
+    if ( !pxDashcam->bThreadStarted )
+    {
+        return -1;
+    }
+
+    /* The writer empties the queue and closes the segment before it finishes. */
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->bStopping = 1;
+    pthread_cond_signal( &pxDashcam->xCondition );
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    pthread_join( pxDashcam->xThread, NULL );
+    pxDashcam->bThreadStarted = 0;
+
+    pthread_cond_destroy( &pxDashcam->xCondition );
+    pthread_mutex_destroy( &pxDashcam->xMutex );
+    vFree( pxDashcam );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewDashcamReadHeader( int iDescriptor, xHUDViewDashcamHeader_t * pxHeader )
+{
+    if ( ( sizeof( xHUDViewDashcamHeader_t ) != pread( iDescriptor, pxHeader, sizeof( xHUDViewDashcamHeader_t ), 0 ) )
+         || ( HUDVIEW_DASHCAM_MAGIC != pxHeader->ulMagic ) || ( HUDVIEW_DASHCAM_VERSION != pxHeader->ulVersion )
+         || ( ulHUDViewDashcamChecksum( pxHeader ) != pxHeader->ulChecksum ) )
+    {
+        return -1;
+    }
+
+    pxHeader->acFormat[ HUDVIEW_DASHCAM_FORMAT_LENGTH - 1 ] = '\0';
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint32_t ulHUDViewDashcamChecksum( const xHUDViewDashcamHeader_t * pxHeader )
+{
+    const uint8_t * pucData = ( const uint8_t * )pxHeader;
+    size_t ulBytes = offsetof( xHUDViewDashcamHeader_t, ulChecksum );
+    uint32_t ulHash = 2166136261UL;
+    size_t ulIndex = 0;
+
+    /* FNV-1a over everything before the checksum. */
+    for ( ulIndex = 0; ulIndex < ulBytes; ulIndex++ )
+    {
+        ulHash = ( ulHash ^ pucData[ ulIndex ] ) * 16777619UL;
+    }
+
+    return ulHash;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void * pvWriterThread( void * pvDashcam )
+{
+    xHUDViewDashcam_t * pxDashcam = ( xHUDViewDashcam_t * )pvDashcam;
+    struct timespec xDeadline;
+    int64_t llDeadline = 0;
+    int64_t llEvent = 0;
+    int iSlot = 0;
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+
+    for ( ;; )
+    {
+        if ( 0 != pxDashcam->llPendingEventNanoseconds )
+        {
+            llEvent = pxDashcam->llPendingEventNanoseconds;
+            pxDashcam->llPendingEventNanoseconds = 0;
+            pthread_mutex_unlock( &pxDashcam->xMutex );
+            vHandleImpact( pxDashcam, llEvent );
+            pthread_mutex_lock( &pxDashcam->xMutex );
+        }
+        else if ( 0 < pxDashcam->iQueueCount )
+        {
+            /* The frame is staged outside the lock; its slot is not handed back until it has been. */
+            iSlot = pxDashcam->iQueueHead;
+            pthread_mutex_unlock( &pxDashcam->xMutex );
+            vAppendFrame( pxDashcam, pxDashcam->pucQueue + ( size_t )iSlot * pxDashcam->ulFrameBytes,
+                          pxDashcam->allQueueNanoseconds[ iSlot ] );
+            pthread_mutex_lock( &pxDashcam->xMutex );
+            pxDashcam->iQueueHead = ( pxDashcam->iQueueHead + 1 ) % HUDVIEW_DASHCAM_QUEUE_FRAMES;
+            pxDashcam->iQueueCount--;
+        }
+        else if ( pxDashcam->bStopping )
+        {
+            break;
+        }
+        else
+        {
+            /* Frames still staged are written once they have waited long enough, even if the camera has stopped. */
+            llDeadline = llMonotonicNanoseconds() + HUDVIEW_DASHCAM_WRITE_INTERVAL_MS * 1000000LL;
+
+            if ( 0 != pxDashcam->ullUnwrittenBytes )
+            {
+                llDeadline = pxDashcam->llStagedSinceNanoseconds + HUDVIEW_DASHCAM_WRITE_INTERVAL_MS * 1000000LL;
+            }
+
+            xDeadline.tv_sec = llDeadline / NANOSECONDS_PER_SECOND;
+            xDeadline.tv_nsec = llDeadline % NANOSECONDS_PER_SECOND;
+
+            if ( ( ETIMEDOUT == pthread_cond_timedwait( &pxDashcam->xCondition, &pxDashcam->xMutex, &xDeadline ) )
+                 && ( 0 != pxDashcam->ullUnwrittenBytes ) )
+            {
+                pthread_mutex_unlock( &pxDashcam->xMutex );
+                ( void )iWriteStaged( pxDashcam );
+                pthread_mutex_lock( &pxDashcam->xMutex );
+            }
+        }
+    }
+
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+    vCloseSegment( pxDashcam );
+
+    return NULL;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vAppendFrame( xHUDViewDashcam_t * pxDashcam, const uint8_t * pucFrame, int64_t llNanoseconds )
+{
+    xHUDViewDashcamSegment_t * pxSegment = NULL;
+    xHUDViewDashcamFrameHeader_t xFrameHeader;
+    uint8_t * pucRecord = NULL;
+    int64_t llNow = llMonotonicNanoseconds();
+
+    if ( ( 0 <= pxDashcam->iDescriptor )
+         && ( pxDashcam->ullOffset + pxDashcam->ulRecordBytes > pxDashcam->ullSegmentBytes ) )
+    {
+        vCloseSegment( pxDashcam );
+        pxDashcam->iSegment = ( pxDashcam->iSegment + 1 ) % pxDashcam->iSegments;
+    }
+
+    if ( ( 0 > pxDashcam->iDescriptor ) && ( 0 != iOpenSegment( pxDashcam ) ) )
+    {
+        pthread_mutex_lock( &pxDashcam->xMutex );
+        pxDashcam->xStatistics.ullFramesDropped++;
+        pthread_mutex_unlock( &pxDashcam->xMutex );
+        return;
+    }
+
+    if ( pxDashcam->ullOffset + pxDashcam->ulRecordBytes - pxDashcam->ullStagingOffset
+         > pxDashcam->ulStagingCapacity - HUDVIEW_DASHCAM_BLOCK_BYTES )
+    {
+        ( void )iWriteStaged( pxDashcam );
+    }
+
+    xFrameHeader.ullSequence = ++pxDashcam->ullSequence;
+    xFrameHeader.llNanoseconds = llNanoseconds;
+    pucRecord = pxDashcam->pucStaging + ( pxDashcam->ullOffset - pxDashcam->ullStagingOffset );
+    memcpy( pucRecord, &xFrameHeader, sizeof( xFrameHeader ) );
+    memcpy( pucRecord + sizeof( xFrameHeader ), pucFrame, pxDashcam->ulFrameBytes );
+    pxDashcam->ullOffset += pxDashcam->ulRecordBytes;
+
+    pxSegment = &pxDashcam->axSegments[ pxDashcam->iSegment ];
+
+    if ( 0 == pxSegment->ullFrames )
+    {
+        pxSegment->llFirstNanoseconds = llNanoseconds;
+    }
+
+    pxSegment->llLastNanoseconds = llNanoseconds;
+    pxSegment->ullFrames++;
+
+    if ( 0 == pxDashcam->ullUnwrittenBytes )
+    {
+        pxDashcam->llStagedSinceNanoseconds = llNow;
+    }
+
+    pxDashcam->ullUnwrittenBytes += pxDashcam->ulRecordBytes;
+    pxDashcam->ullUnwrittenFrames++;
+
+    if ( ( HUDVIEW_DASHCAM_WRITE_BYTES <= pxDashcam->ullUnwrittenBytes )
+         || ( HUDVIEW_DASHCAM_WRITE_INTERVAL_MS * 1000000LL <= llNow - pxDashcam->llStagedSinceNanoseconds ) )
+    {
+        ( void )iWriteStaged( pxDashcam );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iOpenSegment( xHUDViewDashcam_t * pxDashcam )
+{
+    xHUDViewDashcamSegment_t * pxSegment = &pxDashcam->axSegments[ pxDashcam->iSegment ];
+    char acPath[ PATH_MAX ];
+
+    vSegmentPath( pxDashcam, pxDashcam->iSegment, acPath, sizeof( acPath ) );
+    pxDashcam->bDirect = 1;
+    pxDashcam->iDescriptor = open( acPath, O_WRONLY | O_CREAT | O_DIRECT, 0644 );
+
+    if ( ( 0 > pxDashcam->iDescriptor ) && ( EINVAL == errno ) )
+    {
+        pxDashcam->bDirect = 0;
+        pxDashcam->iDescriptor = open( acPath, O_WRONLY | O_CREAT, 0644 );
+    }
+
+    if ( 0 > pxDashcam->iDescriptor )
+    {
+        return -1;
+    }
+
+    /* Nothing to do unless the segment was kept and this is a fresh file in its place. */
+    if ( 0 != posix_fallocate( pxDashcam->iDescriptor, 0, ( off_t )pxDashcam->ullSegmentBytes ) )
+    {
+        close( pxDashcam->iDescriptor );
+        pxDashcam->iDescriptor = -1;
+        return -1;
+    }
+
+    memset( pxSegment, 0, sizeof( xHUDViewDashcamSegment_t ) );
+    pxSegment->ullFirstSequence = pxDashcam->ullSequence + 1;
+    pxDashcam->ullOffset = HUDVIEW_DASHCAM_BLOCK_BYTES;
+    pxDashcam->ullStagingOffset = HUDVIEW_DASHCAM_BLOCK_BYTES;
+    pxDashcam->ullUnwrittenBytes = 0;
+    pxDashcam->ullUnwrittenFrames = 0;
+
+    /* The header is marked open before anything else, so a power cut from here on never leaves the last lap's. */
+    if ( 0 != iWriteHeader( pxDashcam, pxDashcam->iDescriptor, pxDashcam->iSegment, 0 ) )
+    {
+        close( pxDashcam->iDescriptor );
+        pxDashcam->iDescriptor = -1;
+        return -1;
+    }
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->xStatistics.bDirect = pxDashcam->bDirect;
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vCloseSegment( xHUDViewDashcam_t * pxDashcam )
+{
+    int bKeep = 0;
+
+    if ( 0 > pxDashcam->iDescriptor )
+    {
+        return;
+    }
+
+    ( void )iWriteStaged( pxDashcam );
+
+    bKeep = bSegmentInEvent( pxDashcam, pxDashcam->iSegment );
+    ( void )iWriteHeader( pxDashcam, pxDashcam->iDescriptor, pxDashcam->iSegment, 1 );
+    fdatasync( pxDashcam->iDescriptor );
+    close( pxDashcam->iDescriptor );
+    pxDashcam->iDescriptor = -1;
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->xStatistics.ulSegmentsCompleted++;
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    if ( bKeep )
+    {
+        vKeepSegment( pxDashcam, pxDashcam->iSegment );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iWriteStaged( xHUDViewDashcam_t * pxDashcam )
+{
+    size_t ulValid = ( size_t )( pxDashcam->ullOffset - pxDashcam->ullStagingOffset );
+    size_t ulLength = BLOCK_ALIGN( ulValid );
+    size_t ulWhole = ulValid & ~( size_t )( HUDVIEW_DASHCAM_BLOCK_BYTES - 1 );
+    int64_t llStart = 0;
+    int64_t llElapsed = 0;
+    int iStallMilliseconds = 0;
+    int iReturn = 0;
+
+    if ( 0 == pxDashcam->ullUnwrittenBytes )
+    {
+        return 0;
+    }
+
+    /* The tail is padded out to a whole block, and written again with the records after it next time. */
+    memset( pxDashcam->pucStaging + ulValid, 0, ulLength - ulValid );
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+
+    if ( ( 0 < pxDashcam->iStallEveryWrites )
+         && ( pxDashcam->iStallEveryWrites - 1 == ( int )( pxDashcam->xStatistics.ullWrites
+                                                             % ( uint64_t )pxDashcam->iStallEveryWrites ) ) )
+    {
+        iStallMilliseconds = pxDashcam->iStallMilliseconds;
+    }
+
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    llStart = llMonotonicNanoseconds();
+
+    if ( 0 < iStallMilliseconds )
+    {
+        usleep( ( useconds_t )iStallMilliseconds * 1000 );
+    }
+
+    iReturn = iWriteAt( pxDashcam, pxDashcam->iDescriptor, pxDashcam->pucStaging, ulLength,
+                        pxDashcam->ullStagingOffset );
+    llElapsed = llMonotonicNanoseconds() - llStart;
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->xStatistics.ullWrites++;
+    pxDashcam->xStatistics.llWriteNanoseconds += llElapsed;
+
+    if ( pxDashcam->xStatistics.llMaximumWriteNanoseconds < llElapsed )
+    {
+        pxDashcam->xStatistics.llMaximumWriteNanoseconds = llElapsed;
+    }
+
+    if ( 0 == iReturn )
+    {
+        pxDashcam->xStatistics.ullBytesWritten += ulLength;
+        pxDashcam->xStatistics.ullFramesWritten += pxDashcam->ullUnwrittenFrames;
+    }
+    else
+    {
+        pxDashcam->xStatistics.ullFramesDropped += pxDashcam->ullUnwrittenFrames;
+    }
+
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    memmove( pxDashcam->pucStaging, pxDashcam->pucStaging + ulWhole, ulValid - ulWhole );
+    pxDashcam->ullStagingOffset += ulWhole;
+    pxDashcam->ullUnwrittenBytes = 0;
+    pxDashcam->ullUnwrittenFrames = 0;
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iWriteHeader( xHUDViewDashcam_t * pxDashcam, int iDescriptor, int iSegment, int bClosed )
+{
+    const xHUDViewDashcamSegment_t * pxSegment = &pxDashcam->axSegments[ iSegment ];
+    xHUDViewDashcamHeader_t xHeader;
+
+    memset( &xHeader, 0, sizeof( xHeader ) );
+    xHeader.ulMagic = HUDVIEW_DASHCAM_MAGIC;
+    xHeader.ulVersion = HUDVIEW_DASHCAM_VERSION;
+    xHeader.ulFrameBytes = pxDashcam->ulFrameBytes;
+    xHeader.ulRecordBytes = pxDashcam->ulRecordBytes;
+    xHeader.ullSegmentBytes = pxDashcam->ullSegmentBytes;
+    xHeader.ullFirstSequence = pxSegment->ullFirstSequence;
+    strcpy( xHeader.acFormat, pxDashcam->acFormat );
+
+    if ( bClosed )
+    {
+        xHeader.ullFrames = pxSegment->ullFrames;
+        xHeader.llFirstNanoseconds = pxSegment->llFirstNanoseconds;
+        xHeader.llLastNanoseconds = pxSegment->llLastNanoseconds;
+        xHeader.ulClosed = 1;
+
+        if ( bSegmentInEvent( pxDashcam, iSegment ) )
+        {
+            xHeader.llEventNanoseconds = pxDashcam->llEventNanoseconds;
+        }
+    }
+
+    xHeader.ulChecksum = ulHUDViewDashcamChecksum( &xHeader );
+
+    memset( pxDashcam->pucHeaderBlock, 0, HUDVIEW_DASHCAM_BLOCK_BYTES );
+    memcpy( pxDashcam->pucHeaderBlock, &xHeader, sizeof( xHeader ) );
+
+    return iWriteAt( pxDashcam, iDescriptor, pxDashcam->pucHeaderBlock, HUDVIEW_DASHCAM_BLOCK_BYTES, 0 );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iWriteAt( xHUDViewDashcam_t * pxDashcam, int iDescriptor, const void * pvData, size_t ulBytes,
+                     uint64_t ullOffset )
+{
+    ssize_t lWritten = pwrite( iDescriptor, pvData, ulBytes, ( off_t )ullOffset );
+
+    /* Some filesystems take O_DIRECT at open and only refuse it on the first write; carry on buffered. */
+    if ( ( 0 > lWritten ) && ( EINVAL == errno ) && ( iDescriptor == pxDashcam->iDescriptor ) && pxDashcam->bDirect )
+    {
+        pxDashcam->bDirect = 0;
+        ( void )fcntl( iDescriptor, F_SETFL, fcntl( iDescriptor, F_GETFL ) & ~O_DIRECT );
+        lWritten = pwrite( iDescriptor, pvData, ulBytes, ( off_t )ullOffset );
+
+        pthread_mutex_lock( &pxDashcam->xMutex );
+        pxDashcam->xStatistics.bDirect = 0;
+        pthread_mutex_unlock( &pxDashcam->xMutex );
+    }
+
+    return ( ( ssize_t )ulBytes == lWritten ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vHandleImpact( xHUDViewDashcam_t * pxDashcam, int64_t llNanoseconds )
+{
+    xHUDViewDashcamSegment_t * pxSegment = NULL;
+    char acPath[ PATH_MAX ];
+    int iDescriptor = -1;
+    int iSegment = 0;
+    int iBack = 0;
+
+    /* An impact while the last one is still being kept extends it rather than starting another. */
+    if ( ( 0 == pxDashcam->llEventNanoseconds ) || ( llNanoseconds > pxDashcam->llKeepUntilNanoseconds ) )
+    {
+        pxDashcam->llEventNanoseconds = llNanoseconds;
+        pxDashcam->llKeepFromNanoseconds = llNanoseconds - HUDVIEW_DASHCAM_PRE_ROLL_SECONDS * NANOSECONDS_PER_SECOND;
+        pxDashcam->iEventParts = 0;
+    }
+
+    pxDashcam->llKeepUntilNanoseconds = llNanoseconds + HUDVIEW_DASHCAM_POST_ROLL_SECONDS * NANOSECONDS_PER_SECOND;
+
+    pthread_mutex_lock( &pxDashcam->xMutex );
+    pxDashcam->xStatistics.ulEvents++;
+    pthread_mutex_unlock( &pxDashcam->xMutex );
+
+    /* Closed segments holding the pre-roll are kept straight away, oldest first, before the loop comes back round to
+     * them; the one being written, and those after it, are kept as they are closed. */
+    for ( iBack = pxDashcam->iSegments - 1; iBack > 0; iBack-- )
+    {
+        iSegment = ( pxDashcam->iSegment + pxDashcam->iSegments - iBack ) % pxDashcam->iSegments;
+        pxSegment = &pxDashcam->axSegments[ iSegment ];
+
+        if ( ( 0 == pxSegment->ullFrames ) || !bSegmentInEvent( pxDashcam, iSegment ) )
+        {
+            continue;
+        }
+
+        vSegmentPath( pxDashcam, iSegment, acPath, sizeof( acPath ) );
+        iDescriptor = open( acPath, O_WRONLY );
+
+        if ( 0 <= iDescriptor )
+        {
+            ( void )iWriteHeader( pxDashcam, iDescriptor, iSegment, 1 );
+            fdatasync( iDescriptor );
+            close( iDescriptor );
+            vKeepSegment( pxDashcam, iSegment );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bSegmentInEvent( const xHUDViewDashcam_t * pxDashcam, int iSegment )
+{
+    const xHUDViewDashcamSegment_t * pxSegment = &pxDashcam->axSegments[ iSegment ];
+
+    return ( 0 != pxDashcam->llEventNanoseconds ) && ( 0 != pxSegment->ullFrames )
+           && ( pxSegment->llFirstNanoseconds <= pxDashcam->llKeepUntilNanoseconds )
+           && ( pxSegment->llLastNanoseconds >= pxDashcam->llKeepFromNanoseconds );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vKeepSegment( xHUDViewDashcam_t * pxDashcam, int iSegment )
+{
+    char acFrom[ PATH_MAX ];
+    char acTo[ PATH_MAX ];
+    char acTime[ 32 ];
+    time_t xEvent = ( time_t )( pxDashcam->llEventNanoseconds / NANOSECONDS_PER_SECOND );
+    struct tm xLocal;
+
+    localtime_r( &xEvent, &xLocal );
+    strftime( acTime, sizeof( acTime ), "%Y%m%d_%H%M%S", &xLocal );
+
+    vSegmentPath( pxDashcam, iSegment, acFrom, sizeof( acFrom ) );
+    snprintf( acTo, sizeof( acTo ), "%s/event_%s_%02d.hvd", pxDashcam->acDirectory, acTime,
+              ++pxDashcam->iEventParts );
+
+    /* The loop file is recreated, and preallocated again, when recording next comes round to it. */
+    if ( 0 == rename( acFrom, acTo ) )
+    {
+        memset( &pxDashcam->axSegments[ iSegment ], 0, sizeof( xHUDViewDashcamSegment_t ) );
+
+        pthread_mutex_lock( &pxDashcam->xMutex );
+        pxDashcam->xStatistics.ulSegmentsKept++;
+        pthread_mutex_unlock( &pxDashcam->xMutex );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSegmentPath( const xHUDViewDashcam_t * pxDashcam, int iSegment, char * pcPath, size_t ulSize )
+{
+    snprintf( pcPath, ulSize, "%s/loop_%02d.hvd", pxDashcam->acDirectory, iSegment );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFree( xHUDViewDashcam_t * pxDashcam )
+{
+    free( pxDashcam->pucQueue );
+    free( pxDashcam->pucStaging );
+    free( pxDashcam->pucHeaderBlock );
+    pxDashcam->pucQueue = NULL;
+    pxDashcam->pucStaging = NULL;
+    pxDashcam->pucHeaderBlock = NULL;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llMonotonicNanoseconds( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( int64_t )xNow.tv_sec * NANOSECONDS_PER_SECOND + xNow.tv_nsec;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,168 @@
+/** @file hudview_dashcam.h
+ *  @brief HUDView rear camera loop recording.
+ *
+ *  The dashcam keeps the last few minutes of raw camera frames in a loop of fixed-size segment files, which are
+ *  preallocated when recording starts so the card never has to find space mid-ride. Frames are copied into a small
+ *  queue by the caller, which never waits on the card: a write-behind thread packs them into block-aligned runs and
+ *  writes them with O_DIRECT (buffered where the filesystem does not allow it), and should the card stall for longer
+ *  than the queue holds, frames are dropped and counted rather than held up. When an impact is reported the segments
+ *  holding the HUDVIEW_DASHCAM_PRE_ROLL_SECONDS before it and the HUDVIEW_DASHCAM_POST_ROLL_SECONDS after it are
+ *  taken out of the loop and kept as event_<date>_<time>_<part>.hvd.
+ *
+ *  A segment starts with a header block, followed by records of a frame header and the raw frame, back to back. The
+ *  header is rewritten with the frame count and time span when the segment is closed; a segment that never was (a
+ *  power cut) is read up to the first record whose sequence does not follow on.
+ */
+
+#ifndef HUDVIEW_DASHCAM_H
+#define HUDVIEW_DASHCAM_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_DASHCAM_MAGIC                   ( 0x44435648UL )
+#define HUDVIEW_DASHCAM_VERSION                 ( 1 )
+
+/* O_DIRECT transfers must be aligned to the logical block size in offset, length and memory. */
+#define HUDVIEW_DASHCAM_BLOCK_BYTES             ( 4096 )
+
+/* 8 segments of 32 MiB hold about seven minutes of 160x120 frames at 10 fps. */
+#define HUDVIEW_DASHCAM_DEFAULT_SEGMENT_BYTES   ( 32ULL * 1024 * 1024 )
+#define HUDVIEW_DASHCAM_DEFAULT_SEGMENTS        ( 8 )
+#define HUDVIEW_DASHCAM_MAXIMUM_SEGMENTS        ( 64 )
+
+/* Frames waiting for the writer: three seconds of card stall at 10 fps before any is dropped. */
+#define HUDVIEW_DASHCAM_QUEUE_FRAMES            ( 32 )
+
+/* Frames are written once this much has been gathered, or once the oldest has waited this long. */
+#define HUDVIEW_DASHCAM_WRITE_BYTES             ( 256 * 1024 )
+#define HUDVIEW_DASHCAM_WRITE_INTERVAL_MS       ( 1000 )
+
+#define HUDVIEW_DASHCAM_PRE_ROLL_SECONDS        ( 30 )
+#define HUDVIEW_DASHCAM_POST_ROLL_SECONDS       ( 10 )
+#define HUDVIEW_DASHCAM_FORMAT_LENGTH           ( 64 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    uint32_t ulMagic;
+    uint32_t ulVersion;
+    uint32_t ulFrameBytes;
+    uint32_t ulRecordBytes;
+    uint64_t ullSegmentBytes;
+
+    /* Records follow on from this sequence number; one that does not was left over from an earlier lap or run. */
+    uint64_t ullFirstSequence;
+
+    /* Filled in when the segment is closed; zero while it is being written. */
+    uint64_t ullFrames;
+    int64_t llFirstNanoseconds;
+    int64_t llLastNanoseconds;
+
+    /* The impact a kept segment was kept for, wall-clock like the frame times; zero in the loop. */
+    int64_t llEventNanoseconds;
+
+    /* What the frames are, in the form Control takes with --camera, e.g. "160x120:hflip". */
+    char acFormat[ HUDVIEW_DASHCAM_FORMAT_LENGTH ];
+    uint32_t ulClosed;
+    uint32_t ulChecksum;
+} xHUDViewDashcamHeader_t;
+
+typedef struct {
+    uint64_t ullSequence;
+    int64_t llNanoseconds;
+} xHUDViewDashcamFrameHeader_t;
+
+typedef struct {
+    uint64_t ullFramesOffered;
+    uint64_t ullFramesWritten;
+    uint64_t ullFramesDropped;
+    uint64_t ullBytesWritten;
+    uint64_t ullWrites;
+    int64_t llWriteNanoseconds;
+    int64_t llMaximumWriteNanoseconds;
+    int64_t llRecordingNanoseconds;
+    int iQueueHighWater;
+    int bDirect;
+    unsigned long ulSegmentsCompleted;
+    unsigned long ulEvents;
+    unsigned long ulSegmentsKept;
+} xHUDViewDashcamStatistics_t;
+
+/* What the writer knows of each segment in the loop. */
+typedef struct {
+    uint64_t ullFirstSequence;
+    uint64_t ullFrames;
+    int64_t llFirstNanoseconds;
+    int64_t llLastNanoseconds;
+} xHUDViewDashcamSegment_t;
+
+typedef struct {
+    char acDirectory[ 256 ];
+    char acFormat[ HUDVIEW_DASHCAM_FORMAT_LENGTH ];
+    uint32_t ulFrameBytes;
+    uint32_t ulRecordBytes;
+    uint64_t ullSegmentBytes;
+    int iSegments;
+
+    /* Shared with the writer thread under xMutex: the queue, impact reports, statistics and the stop request. */
+    pthread_mutex_t xMutex;
+    pthread_cond_t xCondition;
+    pthread_t xThread;
+    int bThreadStarted;
+    int bStopping;
+    uint8_t * pucQueue;
+    int64_t allQueueNanoseconds[ HUDVIEW_DASHCAM_QUEUE_FRAMES ];
+    int iQueueHead;
+    int iQueueCount;
+    int64_t llPendingEventNanoseconds;
+    xHUDViewDashcamStatistics_t xStatistics;
+    int64_t llOpenedNanoseconds;
+
+    /* Owned by the writer thread. */
+    int iDescriptor;
+    int bDirect;
+    int iSegment;
+    xHUDViewDashcamSegment_t axSegments[ HUDVIEW_DASHCAM_MAXIMUM_SEGMENTS ];
+    uint64_t ullOffset;
+    uint64_t ullSequence;
+    uint8_t * pucStaging;
+    size_t ulStagingCapacity;
+    uint64_t ullStagingOffset;
+    uint64_t ullUnwrittenBytes;
+    uint64_t ullUnwrittenFrames;
+    int64_t llStagedSinceNanoseconds;
+    uint8_t * pucHeaderBlock;
+    int64_t llKeepFromNanoseconds;
+    int64_t llKeepUntilNanoseconds;
+    int64_t llEventNanoseconds;
+    int iEventParts;
+
+    /* Artificial card stalls for testing: every so many writes, one takes this much longer. */
+    int iStallEveryWrites;
+    int iStallMilliseconds;
+} xHUDViewDashcam_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewDashcamOpen( xHUDViewDashcam_t * pxDashcam, const char * pcDirectory, const char * pcFormat,
+                         uint32_t ulFrameBytes, uint64_t ullSegmentBytes, int iSegments );
+int iHUDViewDashcamRecordFrame( xHUDViewDashcam_t * pxDashcam, const uint8_t * pucFrame, int64_t llNanoseconds );
+void vHUDViewDashcamReportImpact( xHUDViewDashcam_t * pxDashcam, int64_t llNanoseconds );
+void vHUDViewDashcamGetStatistics( xHUDViewDashcam_t * pxDashcam, xHUDViewDashcamStatistics_t * pxStatistics );
+void vHUDViewDashcamInjectStalls( xHUDViewDashcam_t * pxDashcam, int iEveryWrites, int iMilliseconds );
+int iHUDViewDashcamClose( xHUDViewDashcam_t * pxDashcam );
+
+int iHUDViewDashcamReadHeader( int iDescriptor, xHUDViewDashcamHeader_t * pxHeader );
+uint32_t ulHUDViewDashcamChecksum( const xHUDViewDashcamHeader_t * pxHeader );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_DASHCAM_H
@@ -0,0 +1,356 @@
+/** @file hudview_enhance.c
+ *  @brief HUDView rear camera temporal denoise and adaptive tone mapping.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define HUDVIEW_ENHANCE_NEON
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#define HUDVIEW_ENHANCE_SSE2
+#endif
+
+#include "hudview_enhance.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define UNITY_GAIN ( 1 << HUDVIEW_ENHANCE_GAIN_BITS )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFilterRow( xHUDViewEnhance_t * pxEnhance, const uint8_t * pucLuma, const uint16_t * pusPicture,
+                        int iOffset, int iThreshold );
+static void vToneRow( xHUDViewEnhance_t * pxEnhance, uint16_t * pusPicture );
+static void vBuildCurve( xHUDViewEnhance_t * pxEnhance );
+static uint16_t usAverage( uint16_t * pusAverage, int iValue, int iThreshold, int iShift );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewEnhanceInit( xHUDViewEnhance_t * pxEnhance )
+{
+    memset( pxEnhance, 0, sizeof( *pxEnhance ) );
+    pxEnhance->bDenoise = 1;
+    pxEnhance->iShift = HUDVIEW_ENHANCE_DEFAULT_SHIFT;
+    pxEnhance->fStrength = HUDVIEW_ENHANCE_DEFAULT_STRENGTH;
+    vHUDViewEnhanceReset( pxEnhance );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewEnhanceReset( xHUDViewEnhance_t * pxEnhance )
+{
+    /* The next frame starts the averages and the curve afresh, rather than blending with a scene from long ago. */
+    pxEnhance->bPrimed = 0;
+
+    for ( int iLevel = 0; iLevel < 256; iLevel++ )
+    {
+        pxEnhance->afCurve[ iLevel ] = ( float )iLevel;
+        pxEnhance->ausGains[ iLevel ] = UNITY_GAIN;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewEnhanceSetScalar( xHUDViewEnhance_t * pxEnhance, int bScalar )
+{
+    pxEnhance->bScalar = bScalar;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewEnhanceSetDenoise( xHUDViewEnhance_t * pxEnhance, int bDenoise, int iShift )
+{
+    pxEnhance->bDenoise = bDenoise;
+
+    if ( ( 0 < iShift ) && ( HUDVIEW_ENHANCE_MAXIMUM_SHIFT >= iShift ) )
+    {
+        pxEnhance->iShift = iShift;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewEnhanceKernels( void )
+{
+#if defined( HUDVIEW_ENHANCE_NEON )
+    return "NEON";
+#elif defined( HUDVIEW_ENHANCE_SSE2 )
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewEnhanceProcess( xHUDViewEnhance_t * pxEnhance, const uint8_t * pucLuma, uint16_t * pusPicture )
+{
+    /* Until there is an average to compare with, or with the filter off, every pixel takes its new value. */
+    int iThreshold = ( pxEnhance->bDenoise && pxEnhance->bPrimed )
+                     ? ( HUDVIEW_ENHANCE_MOTION_THRESHOLD << HUDVIEW_ENHANCE_FRACTION_BITS ) : -1;
+
+    memset( pxEnhance->aulHistogram, 0, sizeof( pxEnhance->aulHistogram ) );
+
+    for ( int iY = 0; iY < HUDVIEW_ENHANCE_HEIGHT; iY++ )
+    {
+        int iOffset = iY * HUDVIEW_ENHANCE_WIDTH;
+        const uint16_t * pusLuma = pxEnhance->aausRow[ eHUDViewEnhanceChannel_Luma ];
+
+        vFilterRow( pxEnhance, pucLuma + iOffset, pusPicture + iOffset, iOffset, iThreshold );
+
+        /* Counting and the gain lookup are gathers and scatters, which neither instruction set has. */
+        for ( int iX = 0; iX < HUDVIEW_ENHANCE_WIDTH; iX++ )
+        {
+            pxEnhance->aulHistogram[ pusLuma[ iX ] ]++;
+            pxEnhance->ausRowGains[ iX ] = pxEnhance->ausGains[ pusLuma[ iX ] ];
+        }
+
+        vToneRow( pxEnhance, pusPicture + iOffset );
+    }
+
+    vBuildCurve( pxEnhance );
+    pxEnhance->bPrimed = 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFilterRow( xHUDViewEnhance_t * pxEnhance, const uint8_t * pucLuma, const uint16_t * pusPicture,
+                        int iOffset, int iThreshold )
+{
+    uint16_t * apusAverages[ eHUDViewEnhanceChannelMax ];
+    int iShift = pxEnhance->iShift;
+    int iX = 0;
+
+    for ( int iChannel = 0; iChannel < eHUDViewEnhanceChannelMax; iChannel++ )
+    {
+        apusAverages[ iChannel ] = &pxEnhance->aausAverages[ iChannel ][ iOffset ];
+    }
+
+    /* RGB565 is widened to 8 bits a channel by repeating the top bits, as the compositor does; luma comes from the
+     * transform at full precision. */
+#if defined( HUDVIEW_ENHANCE_NEON )
+    if ( !pxEnhance->bScalar )
+    {
+        int16x8_t xThreshold = vdupq_n_s16( ( int16_t )iThreshold );
+        int16x8_t xShift = vdupq_n_s16( ( int16_t )-iShift );
+
+        for ( ; iX + 8 <= HUDVIEW_ENHANCE_WIDTH; iX += 8 )
+        {
+            uint16x8_t xPixel = vld1q_u16( &pusPicture[ iX ] );
+            uint16x8_t xRed = vshrq_n_u16( xPixel, 11 );
+            uint16x8_t xGreen = vandq_u16( vshrq_n_u16( xPixel, 5 ), vdupq_n_u16( 0x3F ) );
+            uint16x8_t xBlue = vandq_u16( xPixel, vdupq_n_u16( 0x1F ) );
+            uint16x8_t axValues[ eHUDViewEnhanceChannelMax ];
+
+            axValues[ eHUDViewEnhanceChannel_Luma ] = vmovl_u8( vld1_u8( &pucLuma[ iX ] ) );
+            axValues[ eHUDViewEnhanceChannel_Red ] = vorrq_u16( vshlq_n_u16( xRed, 3 ), vshrq_n_u16( xRed, 2 ) );
+            axValues[ eHUDViewEnhanceChannel_Green ] = vorrq_u16( vshlq_n_u16( xGreen, 2 ), vshrq_n_u16( xGreen, 4 ) );
+            axValues[ eHUDViewEnhanceChannel_Blue ] = vorrq_u16( vshlq_n_u16( xBlue, 3 ), vshrq_n_u16( xBlue, 2 ) );
+
+            for ( int iChannel = 0; iChannel < eHUDViewEnhanceChannelMax; iChannel++ )
+            {
+                int16x8_t xTarget = vreinterpretq_s16_u16( vshlq_n_u16( axValues[ iChannel ],
+                                                                        HUDVIEW_ENHANCE_FRACTION_BITS ) );
+                int16x8_t xAverage = vreinterpretq_s16_u16( vld1q_u16( &apusAverages[ iChannel ][ iX ] ) );
+                int16x8_t xDifference = vsubq_s16( xTarget, xAverage );
+                uint16x8_t xMoved = vcgtq_s16( vabsq_s16( xDifference ), xThreshold );
+
+                xAverage = vbslq_s16( xMoved, xTarget, vaddq_s16( xAverage, vshlq_s16( xDifference, xShift ) ) );
+                vst1q_u16( &apusAverages[ iChannel ][ iX ], vreinterpretq_u16_s16( xAverage ) );
+                vst1q_u16( &pxEnhance->aausRow[ iChannel ][ iX ],
+                           vrshrq_n_u16( vreinterpretq_u16_s16( xAverage ), HUDVIEW_ENHANCE_FRACTION_BITS ) );
+            }
+        }
+    }
+#elif defined( HUDVIEW_ENHANCE_SSE2 )
+    if ( !pxEnhance->bScalar )
+    {
+        __m128i xThreshold = _mm_set1_epi16( ( short )iThreshold );
+        __m128i xShift = _mm_cvtsi32_si128( iShift );
+        __m128i xRound = _mm_set1_epi16( 1 << ( HUDVIEW_ENHANCE_FRACTION_BITS - 1 ) );
+        __m128i xZero = _mm_setzero_si128();
+
+        for ( ; iX + 8 <= HUDVIEW_ENHANCE_WIDTH; iX += 8 )
+        {
+            __m128i xPixel = _mm_loadu_si128( ( const __m128i * )&pusPicture[ iX ] );
+            __m128i xRed = _mm_srli_epi16( xPixel, 11 );
+            __m128i xGreen = _mm_and_si128( _mm_srli_epi16( xPixel, 5 ), _mm_set1_epi16( 0x3F ) );
+            __m128i xBlue = _mm_and_si128( xPixel, _mm_set1_epi16( 0x1F ) );
+            __m128i axValues[ eHUDViewEnhanceChannelMax ];
+
+            axValues[ eHUDViewEnhanceChannel_Luma ] =
+                _mm_unpacklo_epi8( _mm_loadl_epi64( ( const __m128i * )&pucLuma[ iX ] ), xZero );
+            axValues[ eHUDViewEnhanceChannel_Red ] =
+                _mm_or_si128( _mm_slli_epi16( xRed, 3 ), _mm_srli_epi16( xRed, 2 ) );
+            axValues[ eHUDViewEnhanceChannel_Green ] =
+                _mm_or_si128( _mm_slli_epi16( xGreen, 2 ), _mm_srli_epi16( xGreen, 4 ) );
+            axValues[ eHUDViewEnhanceChannel_Blue ] =
+                _mm_or_si128( _mm_slli_epi16( xBlue, 3 ), _mm_srli_epi16( xBlue, 2 ) );
+
+            /* No absolute value or select in SSE2: |d| is max( d, -d ), and the select is done with masks. */
+            for ( int iChannel = 0; iChannel < eHUDViewEnhanceChannelMax; iChannel++ )
+            {
+                __m128i xTarget = _mm_slli_epi16( axValues[ iChannel ], HUDVIEW_ENHANCE_FRACTION_BITS );
+                __m128i xAverage = _mm_loadu_si128( ( const __m128i * )&apusAverages[ iChannel ][ iX ] );
+                __m128i xDifference = _mm_sub_epi16( xTarget, xAverage );
+                __m128i xMoved = _mm_cmpgt_epi16( _mm_max_epi16( xDifference, _mm_sub_epi16( xZero, xDifference ) ),
+                                                  xThreshold );
+
+                xAverage = _mm_or_si128( _mm_and_si128( xMoved, xTarget ),
+                                         _mm_andnot_si128( xMoved, _mm_add_epi16( xAverage,
+                                                                                  _mm_sra_epi16( xDifference,
+                                                                                                 xShift ) ) ) );
+                _mm_storeu_si128( ( __m128i * )&apusAverages[ iChannel ][ iX ], xAverage );
+                _mm_storeu_si128( ( __m128i * )&pxEnhance->aausRow[ iChannel ][ iX ],
+                                  _mm_srli_epi16( _mm_add_epi16( xAverage, xRound ), HUDVIEW_ENHANCE_FRACTION_BITS ) );
+            }
+        }
+    }
+#endif
+
+    for ( ; iX < HUDVIEW_ENHANCE_WIDTH; iX++ )
+    {
+        int iRed = pusPicture[ iX ] >> 11;
+        int iGreen = ( pusPicture[ iX ] >> 5 ) & 0x3F;
+        int iBlue = pusPicture[ iX ] & 0x1F;
+
+        pxEnhance->aausRow[ eHUDViewEnhanceChannel_Luma ][ iX ] =
+            usAverage( &apusAverages[ eHUDViewEnhanceChannel_Luma ][ iX ], pucLuma[ iX ], iThreshold, iShift );
+        pxEnhance->aausRow[ eHUDViewEnhanceChannel_Red ][ iX ] =
+            usAverage( &apusAverages[ eHUDViewEnhanceChannel_Red ][ iX ], ( iRed << 3 ) | ( iRed >> 2 ), iThreshold,
+                       iShift );
+        pxEnhance->aausRow[ eHUDViewEnhanceChannel_Green ][ iX ] =
+            usAverage( &apusAverages[ eHUDViewEnhanceChannel_Green ][ iX ], ( iGreen << 2 ) | ( iGreen >> 4 ),
+                       iThreshold, iShift );
+        pxEnhance->aausRow[ eHUDViewEnhanceChannel_Blue ][ iX ] =
+            usAverage( &apusAverages[ eHUDViewEnhanceChannel_Blue ][ iX ], ( iBlue << 3 ) | ( iBlue >> 2 ), iThreshold,
+                       iShift );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vToneRow( xHUDViewEnhance_t * pxEnhance, uint16_t * pusPicture )
+{
+    const uint16_t * pusRed = pxEnhance->aausRow[ eHUDViewEnhanceChannel_Red ];
+    const uint16_t * pusGreen = pxEnhance->aausRow[ eHUDViewEnhanceChannel_Green ];
+    const uint16_t * pusBlue = pxEnhance->aausRow[ eHUDViewEnhanceChannel_Blue ];
+    const uint16_t * pusGains = pxEnhance->ausRowGains;
+    int iX = 0;
+
+    /* A channel of at most 255 times a gain of at most 4.0 in 2.6 fixed point fits an unsigned 16-bit lane. */
+#if defined( HUDVIEW_ENHANCE_NEON )
+    if ( !pxEnhance->bScalar )
+    {
+        uint16x8_t xMaximum = vdupq_n_u16( 255 );
+
+        for ( ; iX + 8 <= HUDVIEW_ENHANCE_WIDTH; iX += 8 )
+        {
+            uint16x8_t xGain = vld1q_u16( &pusGains[ iX ] );
+            uint16x8_t xRed = vminq_u16( vshrq_n_u16( vmulq_u16( vld1q_u16( &pusRed[ iX ] ), xGain ),
+                                                      HUDVIEW_ENHANCE_GAIN_BITS ), xMaximum );
+            uint16x8_t xGreen = vminq_u16( vshrq_n_u16( vmulq_u16( vld1q_u16( &pusGreen[ iX ] ), xGain ),
+                                                        HUDVIEW_ENHANCE_GAIN_BITS ), xMaximum );
+            uint16x8_t xBlue = vminq_u16( vshrq_n_u16( vmulq_u16( vld1q_u16( &pusBlue[ iX ] ), xGain ),
+                                                       HUDVIEW_ENHANCE_GAIN_BITS ), xMaximum );
+
+            vst1q_u16( &pusPicture[ iX ],
+                       vorrq_u16( vorrq_u16( vshlq_n_u16( vandq_u16( xRed, vdupq_n_u16( 0xF8 ) ), 8 ),
+                                             vshlq_n_u16( vandq_u16( xGreen, vdupq_n_u16( 0xFC ) ), 3 ) ),
+                                  vshrq_n_u16( xBlue, 3 ) ) );
+        }
+    }
+#elif defined( HUDVIEW_ENHANCE_SSE2 )
+    if ( !pxEnhance->bScalar )
+    {
+        __m128i xMaximum = _mm_set1_epi16( 255 );
+
+        /* The shifted products are at most 1020, so the signed minimum does for an unsigned one. */
+        for ( ; iX + 8 <= HUDVIEW_ENHANCE_WIDTH; iX += 8 )
+        {
+            __m128i xGain = _mm_loadu_si128( ( const __m128i * )&pusGains[ iX ] );
+            __m128i xRed = _mm_mullo_epi16( _mm_loadu_si128( ( const __m128i * )&pusRed[ iX ] ), xGain );
+            __m128i xGreen = _mm_mullo_epi16( _mm_loadu_si128( ( const __m128i * )&pusGreen[ iX ] ), xGain );
+            __m128i xBlue = _mm_mullo_epi16( _mm_loadu_si128( ( const __m128i * )&pusBlue[ iX ] ), xGain );
+
+            xRed = _mm_min_epi16( _mm_srli_epi16( xRed, HUDVIEW_ENHANCE_GAIN_BITS ), xMaximum );
+            xGreen = _mm_min_epi16( _mm_srli_epi16( xGreen, HUDVIEW_ENHANCE_GAIN_BITS ), xMaximum );
+            xBlue = _mm_min_epi16( _mm_srli_epi16( xBlue, HUDVIEW_ENHANCE_GAIN_BITS ), xMaximum );
+            xRed = _mm_slli_epi16( _mm_and_si128( xRed, _mm_set1_epi16( 0xF8 ) ), 8 );
+            xGreen = _mm_slli_epi16( _mm_and_si128( xGreen, _mm_set1_epi16( 0xFC ) ), 3 );
+            _mm_storeu_si128( ( __m128i * )&pusPicture[ iX ],
+                              _mm_or_si128( _mm_or_si128( xRed, xGreen ), _mm_srli_epi16( xBlue, 3 ) ) );
+        }
+    }
+#endif
+
+    for ( ; iX < HUDVIEW_ENHANCE_WIDTH; iX++ )
+    {
+        int iRed = ( pusRed[ iX ] * pusGains[ iX ] ) >> HUDVIEW_ENHANCE_GAIN_BITS;
+        int iGreen = ( pusGreen[ iX ] * pusGains[ iX ] ) >> HUDVIEW_ENHANCE_GAIN_BITS;
+        int iBlue = ( pusBlue[ iX ] * pusGains[ iX ] ) >> HUDVIEW_ENHANCE_GAIN_BITS;
+
+        iRed = ( 255 < iRed ) ? 255 : iRed;
+        iGreen = ( 255 < iGreen ) ? 255 : iGreen;
+        iBlue = ( 255 < iBlue ) ? 255 : iBlue;
+        pusPicture[ iX ] = ( uint16_t )( ( ( iRed & 0xF8 ) << 8 ) | ( ( iGreen & 0xFC ) << 3 ) | ( iBlue >> 3 ) );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vBuildCurve( xHUDViewEnhance_t * pxEnhance )
+{
+    const uint32_t ulClip = HUDVIEW_ENHANCE_CLIP_LIMIT * HUDVIEW_ENHANCE_PIXELS / 256;
+    float fExcess = 0.0f;
+    float fBelow = 0.0f;
+    float fSumBefore = 0.0f;
+    float fSumAfter = 0.0f;
+
+    /* Whatever is clipped off the peaks is spread evenly over every level, which limits the curve's slope. */
+    for ( int iLevel = 0; iLevel < 256; iLevel++ )
+    {
+        if ( ulClip < pxEnhance->aulHistogram[ iLevel ] )
+        {
+            fExcess += ( float )( pxEnhance->aulHistogram[ iLevel ] - ulClip );
+        }
+    }
+
+    for ( int iLevel = 0; iLevel < 256; iLevel++ )
+    {
+        uint32_t ulCount = pxEnhance->aulHistogram[ iLevel ];
+        float fBin = ( float )( ( ulClip < ulCount ) ? ulClip : ulCount ) + fExcess / 256.0f;
+        float fEqualised = ( fBelow + fBin / 2.0f ) * 255.0f / HUDVIEW_ENHANCE_PIXELS;
+        float fTarget = iLevel + pxEnhance->fStrength * ( fEqualised - iLevel );
+        float fGain = 0.0f;
+
+        fBelow += fBin;
+        pxEnhance->afCurve[ iLevel ] = pxEnhance->bPrimed
+                                       ? pxEnhance->afCurve[ iLevel ]
+                                         + HUDVIEW_ENHANCE_CURVE_RATE * ( fTarget - pxEnhance->afCurve[ iLevel ] )
+                                       : fTarget;
+
+        fSumBefore += ( float )ulCount * iLevel;
+        fSumAfter += ( float )ulCount * pxEnhance->afCurve[ iLevel ];
+
+        /* Black stays black whatever its gain; it takes its neighbour's. */
+        if ( 0 < iLevel )
+        {
+            fGain = pxEnhance->afCurve[ iLevel ] * UNITY_GAIN / iLevel + 0.5f;
+            fGain = ( HUDVIEW_ENHANCE_MAXIMUM_GAIN * UNITY_GAIN < fGain ) ? HUDVIEW_ENHANCE_MAXIMUM_GAIN * UNITY_GAIN
+                                                                         : fGain;
+            pxEnhance->ausGains[ iLevel ] = ( uint16_t )fGain;
+        }
+    }
+
+    pxEnhance->ausGains[ 0 ] = pxEnhance->ausGains[ 1 ];
+    pxEnhance->fMeanBefore = fSumBefore / HUDVIEW_ENHANCE_PIXELS;
+    pxEnhance->fMeanAfter = fSumAfter / HUDVIEW_ENHANCE_PIXELS;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint16_t usAverage( uint16_t * pusAverage, int iValue, int iThreshold, int iShift )
+{
+    int iTarget = iValue << HUDVIEW_ENHANCE_FRACTION_BITS;
+    int iDifference = iTarget - *pusAverage;
+
+    /* The shift of a negative difference rounds down, as the vector arithmetic shifts do. */
+    *pusAverage = ( uint16_t )( ( abs( iDifference ) > iThreshold ) ? iTarget
+                                                                     : *pusAverage + ( iDifference >> iShift ) );
+
+    return ( uint16_t )( ( *pusAverage + ( 1 << ( HUDVIEW_ENHANCE_FRACTION_BITS - 1 ) ) )
+                         >> HUDVIEW_ENHANCE_FRACTION_BITS );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
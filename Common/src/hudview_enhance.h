@@ -0,0 +1,104 @@
+/** @file hudview_enhance.h
+ *  @brief HUDView rear camera low-light enhancement.
+ *
+ *  At night the rear view comes out dark and grainy. This stage works on the display picture after the camera
+ *  transform, in place: a recursive temporal filter averages each pixel's channels over the last few frames, starting
+ *  a pixel afresh wherever it changes by more than noise could (so moving things do not smear), and the averaged
+ *  picture is then brightened by a tone curve built from its own luma histogram. The curve is contrast-limited
+ *  equalisation (bins are clipped before the cumulative sum, so a dark scene's noise floor is not stretched to full
+ *  range), blended with the identity and capped at a maximum gain, and it follows the scene smoothly from frame to
+ *  frame; each pixel's channels are scaled by the curve's gain for its luma, which keeps its hue.
+ *
+ *  Each row is filtered, counted and tone-mapped while it is in cache, with NEON or SSE2 when the compiler targets
+ *  them and a scalar fallback that gives the same result. The curve for a frame is the one built from the frame
+ *  before, so the whole stage is a single pass. All state is fixed-size and nothing is allocated.
+ */
+
+#ifndef HUDVIEW_ENHANCE_H
+#define HUDVIEW_ENHANCE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_ENHANCE_WIDTH                   ( 160 )
+#define HUDVIEW_ENHANCE_HEIGHT                  ( 120 )
+#define HUDVIEW_ENHANCE_PIXELS                  ( HUDVIEW_ENHANCE_WIDTH * HUDVIEW_ENHANCE_HEIGHT )
+
+/* Running averages keep four fractional bits, so the arithmetic stays in 16-bit lanes. */
+#define HUDVIEW_ENHANCE_FRACTION_BITS           ( 4 )
+
+/* Each frame moves the average 1 / 2^shift of the way to it; at 2, noise falls to about 40%. */
+#define HUDVIEW_ENHANCE_DEFAULT_SHIFT           ( 2 )
+#define HUDVIEW_ENHANCE_MAXIMUM_SHIFT           ( 4 )
+
+/* A channel this far from its average has moved rather than flickered. */
+#define HUDVIEW_ENHANCE_MOTION_THRESHOLD        ( 24 )
+
+/* Histogram bins are clipped at this multiple of the mean count before equalising. */
+#define HUDVIEW_ENHANCE_CLIP_LIMIT              ( 3 )
+
+/* Gains are 2.6 fixed point and at most 4, so a full channel times the gain still fits 16 bits. */
+#define HUDVIEW_ENHANCE_GAIN_BITS               ( 6 )
+#define HUDVIEW_ENHANCE_MAXIMUM_GAIN            ( 4 )
+
+/* How far the curve moves towards the new frame's each frame, and how much of equalisation (against none) it has. */
+#define HUDVIEW_ENHANCE_CURVE_RATE              ( 0.25f )
+#define HUDVIEW_ENHANCE_DEFAULT_STRENGTH        ( 0.8f )
+
+/* What the stage may cost per frame: a twentieth of a frame at 15 fps on one Pi core. */
+#define HUDVIEW_ENHANCE_BUDGET_US               ( 3300 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eHUDViewEnhanceChannelMin = 0,
+
+    eHUDViewEnhanceChannel_Luma = eHUDViewEnhanceChannelMin,
+    eHUDViewEnhanceChannel_Red,
+    eHUDViewEnhanceChannel_Green,
+    eHUDViewEnhanceChannel_Blue,
+
+    eHUDViewEnhanceChannelMax
+} eHUDViewEnhanceChannel_t;
+
+typedef struct {
+    int bScalar;
+    int bDenoise;
+    int bPrimed;
+    int iShift;
+    float fStrength;
+
+    /* Per pixel running averages of each channel, expanded to 8 bits, with fractional bits. */
+    uint16_t aausAverages[ eHUDViewEnhanceChannelMax ][ HUDVIEW_ENHANCE_PIXELS ];
+
+    /* The tone curve, output level for each luma, and the gain it gives each luma in 2.6 fixed point. */
+    float afCurve[ 256 ];
+    uint16_t ausGains[ 256 ];
+    uint32_t aulHistogram[ 256 ];
+
+    /* One row of filtered channels and its gains, between the passes over it. */
+    uint16_t aausRow[ eHUDViewEnhanceChannelMax ][ HUDVIEW_ENHANCE_WIDTH ];
+    uint16_t ausRowGains[ HUDVIEW_ENHANCE_WIDTH ];
+
+    /* Mean luma of the last frame before and after the tone curve. */
+    float fMeanBefore;
+    float fMeanAfter;
+} xHUDViewEnhance_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewEnhanceInit( xHUDViewEnhance_t * pxEnhance );
+void vHUDViewEnhanceReset( xHUDViewEnhance_t * pxEnhance );
+void vHUDViewEnhanceSetScalar( xHUDViewEnhance_t * pxEnhance, int bScalar );
+void vHUDViewEnhanceSetDenoise( xHUDViewEnhance_t * pxEnhance, int bDenoise, int iShift );
+const char * pcHUDViewEnhanceKernels( void );
+void vHUDViewEnhanceProcess( xHUDViewEnhance_t * pxEnhance, const uint8_t * pucLuma, uint16_t * pusPicture );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_ENHANCE_H
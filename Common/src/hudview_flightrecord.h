@@ -0,0 +1,185 @@
+/** @file hudview_flightrecord.h
+ *  @brief HUDView flight recorder file format.
+ *
+ *  The flight recorder is a preallocated circular file of fixed-size telemetry records, written through a shared
+ *  memory mapping by the control application and read back by hudview_flightdump after a crash.
+ *
+ *  The first page of the file holds two copies of the header in separate sectors. The writer alternates between
+ *  them, so a power loss part-way through a header update always leaves the other copy intact; readers use the valid
+ *  copy with the highest generation. Records carry their own sequence number and checksum, which lets a reader
+ *  recover every record that reached storage, including those written after the last header update, and reject any
+ *  that were torn.
+ */
+
+#ifndef HUDVIEW_FLIGHTRECORD_H
+#define HUDVIEW_FLIGHTRECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_FLIGHT_MAGIC                ( 0x48564652UL )
+#define HUDVIEW_FLIGHT_VERSION              ( 1 )
+#define HUDVIEW_FLIGHT_DATA_OFFSET          ( 4096 )
+#define HUDVIEW_FLIGHT_HEADER_COPIES        ( 2 )
+#define HUDVIEW_FLIGHT_HEADER_STRIDE        ( 512 )
+#define HUDVIEW_FLIGHT_RECORD_SIZE          ( 64 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eHUDViewFlightRecordTypeMin = 0,
+
+    eHUDViewFlightRecordType_Accelerometer,
+    eHUDViewFlightRecordType_GPS,
+    eHUDViewFlightRecordType_LightSensor,
+    eHUDViewFlightRecordType_ButtonPress,
+
+    eHUDViewFlightRecordTypeMax
+} eHUDViewFlightRecordType_t;
+
+typedef struct {
+    uint32_t ulMagic;
+    uint32_t ulVersion;
+    uint32_t ulRecordSize;
+    uint32_t ulDataOffset;
+    uint64_t ullCapacity;
+    int64_t llCreatedNanoseconds;
+    uint64_t ullGeneration;
+    uint64_t ullSyncedSequence;
+    int64_t llSyncedNanoseconds;
+    uint32_t ulReserved;
+    uint32_t ulChecksum;
+} xHUDViewFlightHeader_t;
+
+typedef struct {
+    uint64_t ullSequence;
+    int64_t llTimestampNanoseconds;
+    uint16_t usType;
+    uint16_t usReserved;
+    uint32_t ulChecksum;
+
+    union {
+        struct {
+            float fX;
+            float fY;
+            float fZ;
+        } xAccelerometer;
+
+        struct {
+            double dLatitude;
+            double dLongitude;
+            float fSpeed;
+            float fDirection;
+            uint8_t ucHasFix;
+        } xGPS;
+
+        struct {
+            int32_t lLux;
+        } xLightSensor;
+
+        struct {
+            uint32_t ulPresses;
+        } xButtonPress;
+
+        uint8_t aucRaw[ 40 ];
+    } xData;
+} xHUDViewFlightRecord_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+static_assert( HUDVIEW_FLIGHT_RECORD_SIZE == sizeof( xHUDViewFlightRecord_t ), "Flight record size mismatch" );
+#else
+_Static_assert( HUDVIEW_FLIGHT_RECORD_SIZE == sizeof( xHUDViewFlightRecord_t ), "Flight record size mismatch" );
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* FNV-1a over a structure, skipping its 32-bit checksum field. */
+static inline uint32_t ulHUDViewFlightChecksum( const void * pvData, size_t ulSize, size_t ulChecksumOffset )
+{
+    const uint8_t * pucData = ( const uint8_t * )pvData;
+    uint32_t ulHash = 2166136261UL;
+    size_t ulByte = 0;
+
+    for ( ulByte = 0; ulByte < ulSize; ulByte++ )
+    {
+        if ( ( ulByte >= ulChecksumOffset ) && ( ulByte < ulChecksumOffset + sizeof( uint32_t ) ) )
+        {
+            continue;
+        }
+
+        ulHash = ( ulHash ^ pucData[ ulByte ] ) * 16777619UL;
+    }
+
+    return ulHash;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline uint32_t ulHUDViewFlightHeaderChecksum( const xHUDViewFlightHeader_t * pxHeader )
+{
+    return ulHUDViewFlightChecksum( pxHeader, sizeof( xHUDViewFlightHeader_t ),
+                                    offsetof( xHUDViewFlightHeader_t, ulChecksum ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline uint32_t ulHUDViewFlightRecordChecksum( const xHUDViewFlightRecord_t * pxRecord )
+{
+    return ulHUDViewFlightChecksum( pxRecord, sizeof( xHUDViewFlightRecord_t ),
+                                    offsetof( xHUDViewFlightRecord_t, ulChecksum ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline const xHUDViewFlightHeader_t * pxHUDViewFlightHeaderCopy( const void * pvFile, int iCopy )
+{
+    return ( const xHUDViewFlightHeader_t * )( ( const uint8_t * )pvFile + iCopy * HUDVIEW_FLIGHT_HEADER_STRIDE );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Pick the newest header copy that is intact, or NULL if neither is. */
+static inline const xHUDViewFlightHeader_t * pxHUDViewFlightValidHeader( const void * pvFile, size_t ulFileSize )
+{
+    const xHUDViewFlightHeader_t * pxReturn = NULL;
+    const xHUDViewFlightHeader_t * pxHeader = NULL;
+    int iCopy = 0;
+
+    if ( HUDVIEW_FLIGHT_DATA_OFFSET > ulFileSize )
+    {
+        return NULL;
+    }
+
+    for ( iCopy = 0; iCopy < HUDVIEW_FLIGHT_HEADER_COPIES; iCopy++ )
+    {
+        pxHeader = pxHUDViewFlightHeaderCopy( pvFile, iCopy );
+
+        if ( ( HUDVIEW_FLIGHT_MAGIC == pxHeader->ulMagic ) && ( HUDVIEW_FLIGHT_VERSION == pxHeader->ulVersion )
+             && ( HUDVIEW_FLIGHT_RECORD_SIZE == pxHeader->ulRecordSize )
+             && ( ulHUDViewFlightHeaderChecksum( pxHeader ) == pxHeader->ulChecksum )
+             && ( pxHeader->ulDataOffset + pxHeader->ullCapacity * HUDVIEW_FLIGHT_RECORD_SIZE <= ulFileSize )
+             && ( ( NULL == pxReturn ) || ( pxHeader->ullGeneration > pxReturn->ullGeneration ) ) )
+        {
+            pxReturn = pxHeader;
+        }
+    }
+
+    return pxReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* A slot holds a usable record only if it is complete and sits where its sequence number says it should. */
+static inline int bHUDViewFlightRecordValid( const xHUDViewFlightRecord_t * pxRecord, uint64_t ullCapacity,
+                                             uint64_t ullSlot )
+{
+    return ( 0 != pxRecord->ullSequence ) && ( ( ( pxRecord->ullSequence - 1 ) % ullCapacity ) == ullSlot )
+           && ( eHUDViewFlightRecordTypeMin < pxRecord->usType ) && ( eHUDViewFlightRecordTypeMax > pxRecord->usType )
+           && ( ulHUDViewFlightRecordChecksum( pxRecord ) == pxRecord->ulChecksum );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_FLIGHTRECORD_H
@@ -0,0 +1,508 @@
+/** @file hudview_flow.c
+ *  @brief HUDView rear camera optical flow, looming and time to contact.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define HUDVIEW_FLOW_NEON
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#define HUDVIEW_FLOW_SSE2
+#endif
+
+#include "hudview_flow.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const int aiLevelOffsets[ HUDVIEW_FLOW_LEVELS ] = {
+    0,
+    HUDVIEW_FLOW_WIDTH * HUDVIEW_FLOW_HEIGHT,
+    HUDVIEW_FLOW_WIDTH * HUDVIEW_FLOW_HEIGHT * 5 / 4
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t ulSAD8x8( const uint8_t * pucA, const uint8_t * pucB, int iStride, int bScalar );
+static void vDownsample( const uint8_t * pucSource, int iWidth, int iHeight, uint8_t * pucDestination, int bScalar );
+static uint32_t ulTexture( const uint8_t * pucBlock, int iStride );
+static int bTrackBlock( const xHUDViewFlow_t * pxFlow, const uint8_t * pucPrevious, const uint8_t * pucCurrent,
+                        int iBlockX, int iBlockY, float * pfFlowX, float * pfFlowY );
+static double dSubpixel( uint32_t ulBefore, uint32_t ulBest, uint32_t ulAfter );
+static void vFindLooming( const xHUDViewFlow_t * pxFlow, double dFrameSeconds, xHUDViewFlowResult_t * pxResult );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFlowInit( xHUDViewFlow_t * pxFlow )
+{
+    memset( pxFlow, 0, sizeof( *pxFlow ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFlowSetScalar( xHUDViewFlow_t * pxFlow, int bScalar )
+{
+    pxFlow->bScalar = bScalar;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewFlowKernels( void )
+{
+#if defined( HUDVIEW_FLOW_NEON )
+    return "NEON";
+#elif defined( HUDVIEW_FLOW_SSE2 )
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFlowLumaFromRGB888( const uint8_t * pucRGB, uint8_t * pucLuma, int iPixels )
+{
+    for ( int iPixel = 0; iPixel < iPixels; iPixel++ )
+    {
+        pucLuma[ iPixel ] = HUDVIEW_FLOW_LUMA( pucRGB[ 0 ], pucRGB[ 1 ], pucRGB[ 2 ] );
+        pucRGB += 3;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFlowProcess( xHUDViewFlow_t * pxFlow, const uint8_t * pucLuma, int64_t llMicroseconds,
+                         xHUDViewFlowResult_t * pxResult )
+{
+    int iNext = 1 - pxFlow->iCurrent;
+    uint8_t * pucPyramid = pxFlow->aaucPyramids[ iNext ];
+    const uint8_t * pucPrevious = pxFlow->aaucPyramids[ pxFlow->iCurrent ];
+    int64_t llGap = llMicroseconds - pxFlow->llPreviousMicroseconds;
+    int bCompare = pxFlow->bHasPrevious && ( 0 < llGap ) && ( HUDVIEW_FLOW_MAXIMUM_FRAME_GAP_US >= llGap );
+    int iBlock = 0;
+
+    memset( pxResult, 0, sizeof( *pxResult ) );
+
+    /* The new frame becomes the previous one for the next call, so it is kept rather than referenced. */
+    memcpy( pucPyramid, pucLuma, HUDVIEW_FLOW_WIDTH * HUDVIEW_FLOW_HEIGHT );
+
+    for ( int iLevel = 1; iLevel < HUDVIEW_FLOW_LEVELS; iLevel++ )
+    {
+        vDownsample( &pucPyramid[ aiLevelOffsets[ iLevel - 1 ] ], HUDVIEW_FLOW_WIDTH >> ( iLevel - 1 ),
+                     HUDVIEW_FLOW_HEIGHT >> ( iLevel - 1 ), &pucPyramid[ aiLevelOffsets[ iLevel ] ], pxFlow->bScalar );
+    }
+
+    pxFlow->iCurrent = iNext;
+    pxFlow->bHasPrevious = 1;
+    pxFlow->llPreviousMicroseconds = llMicroseconds;
+    pxFlow->ulFrames++;
+
+    if ( !bCompare )
+    {
+        pxResult->bAlert = pxFlow->bAlert;
+        return 0;
+    }
+
+    for ( int iRow = 0; iRow < HUDVIEW_FLOW_BLOCK_ROWS; iRow++ )
+    {
+        for ( int iColumn = 0; iColumn < HUDVIEW_FLOW_BLOCK_COLUMNS; iColumn++ )
+        {
+            pxFlow->aucValid[ iBlock ] = ( uint8_t )bTrackBlock( pxFlow, pucPrevious, pucPyramid,
+                                                                 HUDVIEW_FLOW_BLOCK_SPACING * ( iColumn + 1 ) - 4,
+                                                                 HUDVIEW_FLOW_BLOCK_SPACING * ( iRow + 1 ) - 4,
+                                                                 &pxFlow->afFlowX[ iBlock ],
+                                                                 &pxFlow->afFlowY[ iBlock ] );
+            pxResult->iTrackedBlocks += pxFlow->aucValid[ iBlock ];
+            iBlock++;
+        }
+    }
+
+    vFindLooming( pxFlow, llGap / 1e6, pxResult );
+
+    /* Raise the alert on the first frame that shows an approach; drop it once none has been seen for a while. */
+    if ( pxResult->bLooming )
+    {
+        pxFlow->iFramesSinceLooming = 0;
+
+        if ( !pxFlow->bAlert )
+        {
+            pxFlow->bAlert = 1;
+            pxFlow->ulAlerts++;
+            pxResult->bAlertChanged = 1;
+        }
+    }
+    else if ( pxFlow->bAlert && ( HUDVIEW_FLOW_ALERT_HOLD_FRAMES <= ++pxFlow->iFramesSinceLooming ) )
+    {
+        pxFlow->bAlert = 0;
+        pxResult->bAlertChanged = 1;
+    }
+
+    pxResult->bAlert = pxFlow->bAlert;
+
+    return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t ulSAD8x8( const uint8_t * pucA, const uint8_t * pucB, int iStride, int bScalar )
+{
+    uint32_t ulSum = 0;
+
+    if ( !bScalar )
+    {
+#if defined( HUDVIEW_FLOW_NEON )
+        /* Widening absolute differences of each 8-pixel row, accumulated in 16 bits (at most 8 x 255 per lane). */
+        uint16x8_t xAccumulator = vabdl_u8( vld1_u8( pucA ), vld1_u8( pucB ) );
+        uint64x2_t xPairs;
+
+        for ( int iRow = 1; iRow < HUDVIEW_FLOW_BLOCK_SIZE; iRow++ )
+        {
+            xAccumulator = vabal_u8( xAccumulator, vld1_u8( pucA + iRow * iStride ), vld1_u8( pucB + iRow * iStride ) );
+        }
+
+        xPairs = vpaddlq_u32( vpaddlq_u16( xAccumulator ) );
+
+        return ( uint32_t )( vgetq_lane_u64( xPairs, 0 ) + vgetq_lane_u64( xPairs, 1 ) );
+#elif defined( HUDVIEW_FLOW_SSE2 )
+        /* Two rows per register; PSADBW sums each half into a 64-bit lane. */
+        __m128i xAccumulator = _mm_setzero_si128();
+
+        for ( int iRow = 0; iRow < HUDVIEW_FLOW_BLOCK_SIZE; iRow += 2 )
+        {
+            __m128i xA = _mm_unpacklo_epi64( _mm_loadl_epi64( ( const __m128i * )( pucA + iRow * iStride ) ),
+                                             _mm_loadl_epi64( ( const __m128i * )( pucA + ( iRow + 1 ) * iStride ) ) );
+            __m128i xB = _mm_unpacklo_epi64( _mm_loadl_epi64( ( const __m128i * )( pucB + iRow * iStride ) ),
+                                             _mm_loadl_epi64( ( const __m128i * )( pucB + ( iRow + 1 ) * iStride ) ) );
+
+            xAccumulator = _mm_add_epi64( xAccumulator, _mm_sad_epu8( xA, xB ) );
+        }
+
+        return ( uint32_t )( _mm_cvtsi128_si32( xAccumulator )
+                             + _mm_cvtsi128_si32( _mm_unpackhi_epi64( xAccumulator, xAccumulator ) ) );
+#endif
+    }
+
+    for ( int iRow = 0; iRow < HUDVIEW_FLOW_BLOCK_SIZE; iRow++ )
+    {
+        for ( int iColumn = 0; iColumn < HUDVIEW_FLOW_BLOCK_SIZE; iColumn++ )
+        {
+            ulSum += ( uint32_t )abs( pucA[ iColumn ] - pucB[ iColumn ] );
+        }
+
+        pucA += iStride;
+        pucB += iStride;
+    }
+
+    return ulSum;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDownsample( const uint8_t * pucSource, int iWidth, int iHeight, uint8_t * pucDestination, int bScalar )
+{
+    int iHalfWidth = iWidth / 2;
+
+    for ( int iRow = 0; iRow < iHeight / 2; iRow++ )
+    {
+        const uint8_t * pucTop = &pucSource[ 2 * iRow * iWidth ];
+        const uint8_t * pucBottom = pucTop + iWidth;
+        uint8_t * pucOut = &pucDestination[ iRow * iHalfWidth ];
+        int iColumn = 0;
+
+        /* Every path rounds the same way: the two rows are averaged first, then each pair of columns. */
+        if ( !bScalar )
+        {
+#if defined( HUDVIEW_FLOW_NEON )
+            for ( ; iColumn + 8 <= iHalfWidth; iColumn += 8 )
+            {
+                uint8x16_t xRows = vrhaddq_u8( vld1q_u8( pucTop + 2 * iColumn ), vld1q_u8( pucBottom + 2 * iColumn ) );
+                uint16x8_t xPairs = vpaddlq_u8( xRows );
+
+                vst1_u8( pucOut + iColumn, vrshrn_n_u16( xPairs, 1 ) );
+            }
+#elif defined( HUDVIEW_FLOW_SSE2 )
+            const __m128i xLowBytes = _mm_set1_epi16( 0x00FF );
+            const __m128i xOne = _mm_set1_epi16( 1 );
+
+            for ( ; iColumn + 8 <= iHalfWidth; iColumn += 8 )
+            {
+                __m128i xRows = _mm_avg_epu8( _mm_loadu_si128( ( const __m128i * )( pucTop + 2 * iColumn ) ),
+                                              _mm_loadu_si128( ( const __m128i * )( pucBottom + 2 * iColumn ) ) );
+                __m128i xSum = _mm_add_epi16( _mm_add_epi16( _mm_and_si128( xRows, xLowBytes ),
+                                                             _mm_srli_epi16( xRows, 8 ) ), xOne );
+
+                _mm_storel_epi64( ( __m128i * )( pucOut + iColumn ),
+                                  _mm_packus_epi16( _mm_srli_epi16( xSum, 1 ), _mm_setzero_si128() ) );
+            }
+#endif
+        }
+
+        for ( ; iColumn < iHalfWidth; iColumn++ )
+        {
+            int iLeft = ( pucTop[ 2 * iColumn ] + pucBottom[ 2 * iColumn ] + 1 ) >> 1;
+            int iRight = ( pucTop[ 2 * iColumn + 1 ] + pucBottom[ 2 * iColumn + 1 ] + 1 ) >> 1;
+
+            pucOut[ iColumn ] = ( uint8_t )( ( iLeft + iRight + 1 ) >> 1 );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t ulTexture( const uint8_t * pucBlock, int iStride )
+{
+    uint32_t ulSum = 0;
+
+    for ( int iRow = 0; iRow < HUDVIEW_FLOW_BLOCK_SIZE; iRow++ )
+    {
+        for ( int iColumn = 0; iColumn < HUDVIEW_FLOW_BLOCK_SIZE; iColumn++ )
+        {
+            const uint8_t * pucPixel = &pucBlock[ iRow * iStride + iColumn ];
+
+            if ( HUDVIEW_FLOW_BLOCK_SIZE - 1 > iColumn )
+            {
+                ulSum += ( uint32_t )abs( pucPixel[ 1 ] - pucPixel[ 0 ] );
+            }
+
+            if ( HUDVIEW_FLOW_BLOCK_SIZE - 1 > iRow )
+            {
+                ulSum += ( uint32_t )abs( pucPixel[ iStride ] - pucPixel[ 0 ] );
+            }
+        }
+    }
+
+    return ulSum;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bTrackBlock( const xHUDViewFlow_t * pxFlow, const uint8_t * pucPrevious, const uint8_t * pucCurrent,
+                        int iBlockX, int iBlockY, float * pfFlowX, float * pfFlowY )
+{
+    int iFlowX = 0;
+    int iFlowY = 0;
+    uint32_t ulBest = 0;
+    int iX = 0;
+    int iY = 0;
+
+    *pfFlowX = 0.0f;
+    *pfFlowY = 0.0f;
+
+    /* A flat block matches anywhere equally well; leave it out rather than guess. */
+    if ( HUDVIEW_FLOW_MINIMUM_TEXTURE > ulTexture( &pucPrevious[ iBlockY * HUDVIEW_FLOW_WIDTH + iBlockX ],
+                                                   HUDVIEW_FLOW_WIDTH ) )
+    {
+        return 0;
+    }
+
+    /* Search coarse to fine, each level starting from twice the displacement found at the one above. */
+    for ( int iLevel = HUDVIEW_FLOW_LEVELS - 1; iLevel >= 0; iLevel-- )
+    {
+        int iWidth = HUDVIEW_FLOW_WIDTH >> iLevel;
+        int iHeight = HUDVIEW_FLOW_HEIGHT >> iLevel;
+        int iRadius = ( HUDVIEW_FLOW_LEVELS - 1 == iLevel ) ? HUDVIEW_FLOW_COARSE_RADIUS : HUDVIEW_FLOW_FINE_RADIUS;
+        const uint8_t * pucFrom = &pucPrevious[ aiLevelOffsets[ iLevel ] ];
+        const uint8_t * pucTo = &pucCurrent[ aiLevelOffsets[ iLevel ] ];
+        int iBestX = iFlowX;
+        int iBestY = iFlowY;
+
+        /* Coarser levels track the same block centre, kept inside the smaller image. */
+        iX = ( ( iBlockX + HUDVIEW_FLOW_BLOCK_SIZE / 2 ) >> iLevel ) - HUDVIEW_FLOW_BLOCK_SIZE / 2;
+        iY = ( ( iBlockY + HUDVIEW_FLOW_BLOCK_SIZE / 2 ) >> iLevel ) - HUDVIEW_FLOW_BLOCK_SIZE / 2;
+        iX = ( 0 > iX ) ? 0 : ( ( iWidth - HUDVIEW_FLOW_BLOCK_SIZE < iX ) ? iWidth - HUDVIEW_FLOW_BLOCK_SIZE : iX );
+        iY = ( 0 > iY ) ? 0 : ( ( iHeight - HUDVIEW_FLOW_BLOCK_SIZE < iY ) ? iHeight - HUDVIEW_FLOW_BLOCK_SIZE : iY );
+        ulBest = UINT32_MAX;
+
+        for ( int iDY = iFlowY - iRadius; iDY <= iFlowY + iRadius; iDY++ )
+        {
+            for ( int iDX = iFlowX - iRadius; iDX <= iFlowX + iRadius; iDX++ )
+            {
+                uint32_t ulSAD = 0;
+
+                if ( ( 0 > iX + iDX ) || ( iWidth - HUDVIEW_FLOW_BLOCK_SIZE < iX + iDX ) || ( 0 > iY + iDY )
+                     || ( iHeight - HUDVIEW_FLOW_BLOCK_SIZE < iY + iDY ) )
+                {
+                    continue;
+                }
+
+                ulSAD = ulSAD8x8( &pucFrom[ iY * iWidth + iX ], &pucTo[ ( iY + iDY ) * iWidth + iX + iDX ], iWidth,
+                                  pxFlow->bScalar );
+
+                if ( ulSAD < ulBest )
+                {
+                    ulBest = ulSAD;
+                    iBestX = iDX;
+                    iBestY = iDY;
+                }
+            }
+        }
+
+        iFlowX = ( 0 < iLevel ) ? 2 * iBestX : iBestX;
+        iFlowY = ( 0 < iLevel ) ? 2 * iBestY : iBestY;
+    }
+
+    /* Occluded or newly uncovered content has no good match. */
+    if ( ( UINT32_MAX == ulBest )
+         || ( HUDVIEW_FLOW_MAXIMUM_MATCH_ERROR * HUDVIEW_FLOW_BLOCK_SIZE * HUDVIEW_FLOW_BLOCK_SIZE < ulBest ) )
+    {
+        return 0;
+    }
+
+    *pfFlowX = ( float )iFlowX;
+    *pfFlowY = ( float )iFlowY;
+
+    /* Refine to a fraction of a pixel with a parabola through the neighbouring costs, where they are in the image. */
+    if ( ( 0 < iX + iFlowX ) && ( HUDVIEW_FLOW_WIDTH - HUDVIEW_FLOW_BLOCK_SIZE > iX + iFlowX ) )
+    {
+        const uint8_t * pucTo = &pucCurrent[ ( iY + iFlowY ) * HUDVIEW_FLOW_WIDTH + iX + iFlowX ];
+
+        *pfFlowX += ( float )dSubpixel( ulSAD8x8( &pucPrevious[ iY * HUDVIEW_FLOW_WIDTH + iX ], pucTo - 1,
+                                                  HUDVIEW_FLOW_WIDTH, pxFlow->bScalar ), ulBest,
+                                        ulSAD8x8( &pucPrevious[ iY * HUDVIEW_FLOW_WIDTH + iX ], pucTo + 1,
+                                                  HUDVIEW_FLOW_WIDTH, pxFlow->bScalar ) );
+    }
+
+    if ( ( 0 < iY + iFlowY ) && ( HUDVIEW_FLOW_HEIGHT - HUDVIEW_FLOW_BLOCK_SIZE > iY + iFlowY ) )
+    {
+        const uint8_t * pucTo = &pucCurrent[ ( iY + iFlowY ) * HUDVIEW_FLOW_WIDTH + iX + iFlowX ];
+
+        *pfFlowY += ( float )dSubpixel( ulSAD8x8( &pucPrevious[ iY * HUDVIEW_FLOW_WIDTH + iX ],
+                                                  pucTo - HUDVIEW_FLOW_WIDTH, HUDVIEW_FLOW_WIDTH, pxFlow->bScalar ),
+                                        ulBest,
+                                        ulSAD8x8( &pucPrevious[ iY * HUDVIEW_FLOW_WIDTH + iX ],
+                                                  pucTo + HUDVIEW_FLOW_WIDTH, HUDVIEW_FLOW_WIDTH, pxFlow->bScalar ) );
+    }
+
+    return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dSubpixel( uint32_t ulBefore, uint32_t ulBest, uint32_t ulAfter )
+{
+    double dCurvature = ( double )ulBefore - 2.0 * ulBest + ( double )ulAfter;
+    double dOffset = 0.0;
+
+    if ( 0.0 < dCurvature )
+    {
+        dOffset = ( ( double )ulBefore - ( double )ulAfter ) / ( 2.0 * dCurvature );
+    }
+
+    return fmax( -0.5, fmin( 0.5, dOffset ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFindLooming( const xHUDViewFlow_t * pxFlow, double dFrameSeconds, xHUDViewFlowResult_t * pxResult )
+{
+    const int iWindow = HUDVIEW_FLOW_WINDOW_BLOCKS;
+
+    for ( int iTop = 0; iTop + iWindow <= HUDVIEW_FLOW_BLOCK_ROWS; iTop++ )
+    {
+        for ( int iLeft = 0; iLeft + iWindow <= HUDVIEW_FLOW_BLOCK_COLUMNS; iLeft++ )
+        {
+            double dN = 0.0;
+            double dX = 0.0;
+            double dY = 0.0;
+            double dXX = 0.0;
+            double dXY = 0.0;
+            double dYY = 0.0;
+            double dU = 0.0;
+            double dUX = 0.0;
+            double dUY = 0.0;
+            double dV = 0.0;
+            double dVX = 0.0;
+            double dVY = 0.0;
+            double dDeterminant = 0.0;
+            double adU[ 3 ];
+            double adV[ 3 ];
+            double dResidual = 0.0;
+            double dDivergence = 0.0;
+
+            /* Least squares fit of u = a0 + a1 x + a2 y and v = b0 + b1 x + b2 y about the window centre. */
+            for ( int iRow = iTop; iRow < iTop + iWindow; iRow++ )
+            {
+                for ( int iColumn = iLeft; iColumn < iLeft + iWindow; iColumn++ )
+                {
+                    int iBlock = iRow * HUDVIEW_FLOW_BLOCK_COLUMNS + iColumn;
+                    double dBlockX = ( iColumn - iLeft - iWindow / 2 ) * ( double )HUDVIEW_FLOW_BLOCK_SPACING;
+                    double dBlockY = ( iRow - iTop - iWindow / 2 ) * ( double )HUDVIEW_FLOW_BLOCK_SPACING;
+
+                    if ( !pxFlow->aucValid[ iBlock ] )
+                    {
+                        continue;
+                    }
+
+                    dN += 1.0;
+                    dX += dBlockX;
+                    dY += dBlockY;
+                    dXX += dBlockX * dBlockX;
+                    dXY += dBlockX * dBlockY;
+                    dYY += dBlockY * dBlockY;
+                    dU += pxFlow->afFlowX[ iBlock ];
+                    dUX += pxFlow->afFlowX[ iBlock ] * dBlockX;
+                    dUY += pxFlow->afFlowX[ iBlock ] * dBlockY;
+                    dV += pxFlow->afFlowY[ iBlock ];
+                    dVX += pxFlow->afFlowY[ iBlock ] * dBlockX;
+                    dVY += pxFlow->afFlowY[ iBlock ] * dBlockY;
+                }
+            }
+
+            if ( HUDVIEW_FLOW_MINIMUM_WINDOW_BLOCKS > dN )
+            {
+                continue;
+            }
+
+            /* Cramer's rule on the shared 3x3 normal equations. */
+            dDeterminant = dN * ( dXX * dYY - dXY * dXY ) - dX * ( dX * dYY - dXY * dY ) + dY * ( dX * dXY - dXX * dY );
+
+            if ( 1e-9 > fabs( dDeterminant ) )
+            {
+                continue;
+            }
+
+            adU[ 0 ] = ( dU * ( dXX * dYY - dXY * dXY ) - dX * ( dUX * dYY - dXY * dUY )
+                         + dY * ( dUX * dXY - dXX * dUY ) ) / dDeterminant;
+            adU[ 1 ] = ( dN * ( dUX * dYY - dXY * dUY ) - dU * ( dX * dYY - dXY * dY ) + dY * ( dX * dUY - dUX * dY ) )
+                       / dDeterminant;
+            adU[ 2 ] = ( dN * ( dXX * dUY - dUX * dXY ) - dX * ( dX * dUY - dUX * dY ) + dU * ( dX * dXY - dXX * dY ) )
+                       / dDeterminant;
+            adV[ 0 ] = ( dV * ( dXX * dYY - dXY * dXY ) - dX * ( dVX * dYY - dXY * dVY )
+                         + dY * ( dVX * dXY - dXX * dVY ) ) / dDeterminant;
+            adV[ 1 ] = ( dN * ( dVX * dYY - dXY * dVY ) - dV * ( dX * dYY - dXY * dY ) + dY * ( dX * dVY - dVX * dY ) )
+                       / dDeterminant;
+            adV[ 2 ] = ( dN * ( dXX * dVY - dVX * dXY ) - dX * ( dX * dVY - dVX * dY ) + dV * ( dX * dXY - dXX * dY ) )
+                       / dDeterminant;
+
+            /* A window spanning two differently moving things fits badly; its divergence means nothing. */
+            for ( int iRow = iTop; iRow < iTop + iWindow; iRow++ )
+            {
+                for ( int iColumn = iLeft; iColumn < iLeft + iWindow; iColumn++ )
+                {
+                    int iBlock = iRow * HUDVIEW_FLOW_BLOCK_COLUMNS + iColumn;
+                    double dBlockX = ( iColumn - iLeft - iWindow / 2 ) * ( double )HUDVIEW_FLOW_BLOCK_SPACING;
+                    double dBlockY = ( iRow - iTop - iWindow / 2 ) * ( double )HUDVIEW_FLOW_BLOCK_SPACING;
+                    double dErrorU = pxFlow->afFlowX[ iBlock ] - ( adU[ 0 ] + adU[ 1 ] * dBlockX + adU[ 2 ] * dBlockY );
+                    double dErrorV = pxFlow->afFlowY[ iBlock ] - ( adV[ 0 ] + adV[ 1 ] * dBlockX + adV[ 2 ] * dBlockY );
+
+                    if ( pxFlow->aucValid[ iBlock ] )
+                    {
+                        dResidual += dErrorU * dErrorU + dErrorV * dErrorV;
+                    }
+                }
+            }
+
+            dDivergence = adU[ 1 ] + adV[ 2 ];
+
+            if ( ( HUDVIEW_FLOW_MAXIMUM_FIT_ERROR * HUDVIEW_FLOW_MAXIMUM_FIT_ERROR < dResidual / dN )
+                 || ( dDivergence <= pxResult->dDivergence ) )
+            {
+                continue;
+            }
+
+            pxResult->dDivergence = dDivergence;
+            pxResult->iRegionX = HUDVIEW_FLOW_BLOCK_SPACING * ( iLeft + 1 ) - 4;
+            pxResult->iRegionY = HUDVIEW_FLOW_BLOCK_SPACING * ( iTop + 1 ) - 4;
+            pxResult->iRegionWidth = HUDVIEW_FLOW_BLOCK_SPACING * ( iWindow - 1 ) + HUDVIEW_FLOW_BLOCK_SIZE;
+            pxResult->iRegionHeight = pxResult->iRegionWidth;
+        }
+    }
+
+    /* An object growing by D / 2 of its size per frame reaches the camera in 2 / D frames. */
+    if ( 0.0 < pxResult->dDivergence )
+    {
+        pxResult->dTimeToContact = 2.0 / pxResult->dDivergence * dFrameSeconds;
+        pxResult->bLooming = ( HUDVIEW_FLOW_ALERT_SECONDS >= pxResult->dTimeToContact );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,116 @@
+/** @file hudview_flow.h
+ *  @brief HUDView rear camera optical flow and approaching vehicle detection.
+ *
+ *  Each camera frame is reduced to luma and a three level pyramid. Blocks on a fixed grid of the previous frame are
+ *  tracked into the current one by coarse-to-fine block matching (sum of absolute differences, refined to a fraction
+ *  of a pixel at the finest level), which gives a sparse flow field. Something closing in on the camera grows in the
+ *  image, so its flow diverges: an affine fit of the flow over every 3x3 window of blocks gives the divergence D per
+ *  frame, and for an object expanding at that rate the time to contact is 2 / D frames. Riding forward makes the
+ *  scene behind recede, which only ever contracts the flow, so any window expanding fast enough is something
+ *  approaching from behind.
+ *
+ *  The SAD and pyramid kernels use NEON or SSE2 when the compiler targets them, and a scalar fallback otherwise; the
+ *  scalar path can also be selected at run time to compare the two. All state is fixed-size and nothing is allocated.
+ */
+
+#ifndef HUDVIEW_FLOW_H
+#define HUDVIEW_FLOW_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_FLOW_WIDTH                  ( 160 )
+#define HUDVIEW_FLOW_HEIGHT                 ( 120 )
+#define HUDVIEW_FLOW_LEVELS                 ( 3 )
+#define HUDVIEW_FLOW_PYRAMID_BYTES          ( HUDVIEW_FLOW_WIDTH * HUDVIEW_FLOW_HEIGHT * 21 / 16 )
+
+/* Tracked blocks: 8x8 pixels every 12 pixels, clear of the frame edges. */
+#define HUDVIEW_FLOW_BLOCK_SIZE             ( 8 )
+#define HUDVIEW_FLOW_BLOCK_SPACING          ( 12 )
+#define HUDVIEW_FLOW_BLOCK_COLUMNS          ( 12 )
+#define HUDVIEW_FLOW_BLOCK_ROWS             ( 9 )
+#define HUDVIEW_FLOW_BLOCKS                 ( HUDVIEW_FLOW_BLOCK_COLUMNS * HUDVIEW_FLOW_BLOCK_ROWS )
+#define HUDVIEW_FLOW_WINDOW_BLOCKS          ( 3 )
+
+/* Search radius in pixels at the coarsest level and at each finer one; flow of up to 15 pixels a frame is tracked. */
+#define HUDVIEW_FLOW_COARSE_RADIUS          ( 3 )
+#define HUDVIEW_FLOW_FINE_RADIUS            ( 1 )
+
+/* Blocks with less texture than this (summed absolute gradient) cannot be matched reliably. */
+#define HUDVIEW_FLOW_MINIMUM_TEXTURE        ( 640 )
+
+/* Blocks whose best match still differs by more than this much per pixel are taken to be occluded. */
+#define HUDVIEW_FLOW_MAXIMUM_MATCH_ERROR    ( 24 )
+
+/* A window needs this many tracked blocks and an affine fit this good (pixels RMS) for its divergence to count. */
+#define HUDVIEW_FLOW_MINIMUM_WINDOW_BLOCKS  ( 7 )
+#define HUDVIEW_FLOW_MAXIMUM_FIT_ERROR      ( 1.0 )
+
+/* An alert is raised as soon as something is this close in time, and held for a while after it was last seen. */
+#define HUDVIEW_FLOW_ALERT_SECONDS          ( 3.0 )
+#define HUDVIEW_FLOW_ALERT_HOLD_FRAMES      ( 10 )
+
+/* Frame gaps longer than this (e.g. a camera restart) start the flow over rather than matching across them. */
+#define HUDVIEW_FLOW_MAXIMUM_FRAME_GAP_US   ( 500000LL )
+
+/* Integer BT.601 luma, shared with the camera feed so both produce the same image. */
+#define HUDVIEW_FLOW_LUMA( ucRed, ucGreen, ucBlue ) \
+    ( ( uint8_t )( ( 77U * ( ucRed ) + 150U * ( ucGreen ) + 29U * ( ucBlue ) + 128U ) >> 8 ) )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    int bScalar;
+
+    /* Pyramids of the previous and current frame, finest level first. */
+    uint8_t aaucPyramids[ 2 ][ HUDVIEW_FLOW_PYRAMID_BYTES ];
+    int iCurrent;
+    int bHasPrevious;
+    int64_t llPreviousMicroseconds;
+
+    /* Flow of each block from the previous frame to the current one, in pixels. */
+    float afFlowX[ HUDVIEW_FLOW_BLOCKS ];
+    float afFlowY[ HUDVIEW_FLOW_BLOCKS ];
+    uint8_t aucValid[ HUDVIEW_FLOW_BLOCKS ];
+
+    int bAlert;
+    int iFramesSinceLooming;
+    unsigned long ulFrames;
+    unsigned long ulAlerts;
+} xHUDViewFlow_t;
+
+typedef struct {
+    int iTrackedBlocks;
+
+    /* The most strongly expanding window, its divergence per frame and time to contact; zero when none expands. */
+    double dDivergence;
+    double dTimeToContact;
+    int iRegionX;
+    int iRegionY;
+    int iRegionWidth;
+    int iRegionHeight;
+
+    /* Whether this frame showed something closing in, whether the alert is up, and whether it just went up or down. */
+    int bLooming;
+    int bAlert;
+    int bAlertChanged;
+} xHUDViewFlowResult_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFlowInit( xHUDViewFlow_t * pxFlow );
+void vHUDViewFlowSetScalar( xHUDViewFlow_t * pxFlow, int bScalar );
+const char * pcHUDViewFlowKernels( void );
+
+void vHUDViewFlowLumaFromRGB888( const uint8_t * pucRGB, uint8_t * pucLuma, int iPixels );
+int iHUDViewFlowProcess( xHUDViewFlow_t * pxFlow, const uint8_t * pucLuma, int64_t llMicroseconds,
+                         xHUDViewFlowResult_t * pxResult );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_FLOW_H
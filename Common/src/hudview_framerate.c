@@ -0,0 +1,204 @@
+/** @file hudview_framerate.c
+ *  @brief HUDView adaptive camera frame rate.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hudview_framerate.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const int aiSteps[ HUDVIEW_FRAMERATE_STEPS ] = { HUDVIEW_FRAMERATE_IDLE_FPS, 5, HUDVIEW_FRAMERATE_DEFAULT_FPS,
+                                                        15, 20, HUDVIEW_FRAMERATE_MAXIMUM_FPS };
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iQuantise( double dRate, int iCeiling );
+static int iStepIndex( int iRate );
+static double dBetween( double dValue, double dLow, double dHigh );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRateInit( xHUDViewFrameRate_t * pxRate )
+{
+    memset( pxRate, 0, sizeof( *pxRate ) );
+    pxRate->iRate = HUDVIEW_FRAMERATE_DEFAULT_FPS;
+    pxRate->iDemand = HUDVIEW_FRAMERATE_DEFAULT_FPS;
+    pxRate->llLowerSince = -1;
+    pxRate->llMicroseconds = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+double dHUDViewFrameRateMotion( const uint8_t * pucPrevious, const uint8_t * pucCurrent, int iWidth, int iHeight )
+{
+    unsigned long ulChanged = 0;
+    unsigned long ulSampled = 0;
+
+    /* Every other pixel of every other row is plenty to tell a still scene from a moving one. */
+    for ( int iY = 0; iY < iHeight; iY += 2 )
+    {
+        const uint8_t * pucA = pucPrevious + iY * iWidth;
+        const uint8_t * pucB = pucCurrent + iY * iWidth;
+
+        for ( int iX = 0; iX < iWidth; iX += 2 )
+        {
+            ulChanged += ( HUDVIEW_FRAMERATE_CHANGE_LEVELS < abs( pucA[ iX ] - pucB[ iX ] ) ) ? 1 : 0;
+            ulSampled++;
+        }
+    }
+
+    return ( 0 < ulSampled ) ? ( double )ulChanged / ulSampled : 0.0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRatePushed( xHUDViewFrameRate_t * pxRate, uint64_t ullNanoseconds )
+{
+    double dSeconds = ullNanoseconds / 1e9;
+
+    if ( 0.0 >= pxRate->dPushSeconds )
+    {
+        pxRate->dPushSeconds = dSeconds;
+    }
+    else
+    {
+        pxRate->dPushSeconds += HUDVIEW_FRAMERATE_PUSH_SMOOTHING * ( dSeconds - pxRate->dPushSeconds );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRateCeiling( const xHUDViewFrameRate_t * pxRate )
+{
+    double dCeiling = HUDVIEW_FRAMERATE_MAXIMUM_FPS;
+
+    if ( 0.0 < pxRate->dPushSeconds )
+    {
+        dCeiling = HUDVIEW_FRAMERATE_LINK_SHARE / pxRate->dPushSeconds;
+    }
+
+    return ( HUDVIEW_FRAMERATE_MAXIMUM_FPS < dCeiling ) ? HUDVIEW_FRAMERATE_MAXIMUM_FPS
+           : ( HUDVIEW_FRAMERATE_IDLE_FPS > dCeiling ) ? HUDVIEW_FRAMERATE_IDLE_FPS : ( int )dCeiling;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRateUpdate( xHUDViewFrameRate_t * pxRate, int64_t llMicroseconds, double dMotion, double dSpeed,
+                             int bAlert )
+{
+    const double dSpan = HUDVIEW_FRAMERATE_MAXIMUM_FPS - HUDVIEW_FRAMERATE_DEFAULT_FPS;
+    int iCeiling = iHUDViewFrameRateCeiling( pxRate );
+    int iPrevious = pxRate->iRate;
+    double dSpeedDemand = HUDVIEW_FRAMERATE_DEFAULT_FPS;
+    double dMotionDemand = HUDVIEW_FRAMERATE_MAXIMUM_FPS;
+    int64_t llHold = HUDVIEW_FRAMERATE_HOLD_US;
+
+    if ( 0 <= pxRate->llMicroseconds )
+    {
+        pxRate->allMicrosecondsAt[ iStepIndex( pxRate->iRate ) ] += llMicroseconds - pxRate->llMicroseconds;
+    }
+
+    pxRate->llMicroseconds = llMicroseconds;
+    pxRate->dMotion = dMotion;
+
+    /* Without a speed (no fix yet, or a stale one) the bike may be moving, so it is never taken as stationary. */
+    if ( 0.0 <= dSpeed )
+    {
+        dSpeedDemand = ( HUDVIEW_FRAMERATE_STATIONARY_SPEED > dSpeed )
+                       ? HUDVIEW_FRAMERATE_IDLE_FPS
+                       : HUDVIEW_FRAMERATE_DEFAULT_FPS
+                         + dSpan * dBetween( dSpeed, HUDVIEW_FRAMERATE_STATIONARY_SPEED, HUDVIEW_FRAMERATE_FAST_SPEED );
+    }
+
+    if ( HUDVIEW_FRAMERATE_STILL_MOTION > dMotion )
+    {
+        dMotionDemand = HUDVIEW_FRAMERATE_IDLE_FPS;
+    }
+    else if ( HUDVIEW_FRAMERATE_BUSY_MOTION > dMotion )
+    {
+        dMotionDemand = HUDVIEW_FRAMERATE_DEFAULT_FPS
+                        + dSpan * dBetween( dMotion, HUDVIEW_FRAMERATE_STILL_MOTION, HUDVIEW_FRAMERATE_BUSY_MOTION );
+    }
+
+    pxRate->iDemand = iQuantise( bAlert ? HUDVIEW_FRAMERATE_MAXIMUM_FPS
+                                        : ( ( dSpeedDemand > dMotionDemand ) ? dSpeedDemand : dMotionDemand ),
+                                 iCeiling );
+
+    /* The link running short takes effect at once, and so does a demand for more frames; fewer are only taken once
+     * the demand has stayed lower for the hold, and then the most it asked for over that time. */
+    if ( iCeiling < pxRate->iRate )
+    {
+        pxRate->iRate = iQuantise( pxRate->iRate, iCeiling );
+    }
+
+    if ( pxRate->iDemand >= pxRate->iRate )
+    {
+        pxRate->iRate = pxRate->iDemand;
+        pxRate->llLowerSince = -1;
+    }
+    else if ( 0 > pxRate->llLowerSince )
+    {
+        pxRate->llLowerSince = llMicroseconds;
+        pxRate->iLowerDemand = pxRate->iDemand;
+    }
+    else
+    {
+        pxRate->iLowerDemand = ( pxRate->iDemand > pxRate->iLowerDemand ) ? pxRate->iDemand : pxRate->iLowerDemand;
+        llHold = ( HUDVIEW_FRAMERATE_IDLE_FPS == pxRate->iLowerDemand ) ? HUDVIEW_FRAMERATE_IDLE_HOLD_US
+                                                                         : HUDVIEW_FRAMERATE_HOLD_US;
+
+        if ( llMicroseconds - pxRate->llLowerSince >= llHold )
+        {
+            pxRate->iRate = pxRate->iLowerDemand;
+            pxRate->llLowerSince = -1;
+        }
+    }
+
+    pxRate->bChanged = ( iPrevious != pxRate->iRate );
+    pxRate->ulChanges += pxRate->bChanged ? 1 : 0;
+
+    return pxRate->iRate;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRateStep( int iStep )
+{
+    return ( ( 0 <= iStep ) && ( HUDVIEW_FRAMERATE_STEPS > iStep ) ) ? aiSteps[ iStep ] : 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iQuantise( double dRate, int iCeiling )
+{
+    int iStep = 0;
+
+    /* The nearest step to the rate asked for, the higher one when halfway, then down to the highest the link can
+     * carry. */
+    while ( ( HUDVIEW_FRAMERATE_STEPS - 1 > iStep ) && ( ( aiSteps[ iStep ] + aiSteps[ iStep + 1 ] ) / 2.0 <= dRate ) )
+    {
+        iStep++;
+    }
+
+    while ( ( 0 < iStep ) && ( aiSteps[ iStep ] > iCeiling ) )
+    {
+        iStep--;
+    }
+
+    return aiSteps[ iStep ];
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iStepIndex( int iRate )
+{
+    int iStep = 0;
+
+    while ( ( HUDVIEW_FRAMERATE_STEPS - 1 > iStep ) && ( aiSteps[ iStep ] < iRate ) )
+    {
+        iStep++;
+    }
+
+    return iStep;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dBetween( double dValue, double dLow, double dHigh )
+{
+    double dFraction = ( dValue - dLow ) / ( dHigh - dLow );
+
+    return ( 0.0 > dFraction ) ? 0.0 : ( 1.0 < dFraction ) ? 1.0 : dFraction;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
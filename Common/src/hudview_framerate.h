@@ -0,0 +1,90 @@
+/** @file hudview_framerate.h
+ *  @brief HUDView adaptive camera frame rate.
+ *
+ *  A fixed 10 fps is too many frames at a red light and too few in fast traffic. The rate controller picks the
+ *  camera's frame rate, from a handful of steps, from what the rear view and the rider are doing:
+ *
+ *  - the rear scene's motion, the share of sampled pixels that changed between the last two frames by more than
+ *    sensor noise would, from the idle rate for a still scene to the maximum for a busy one,
+ *  - the rider's speed, from the default rate when moving off to the maximum at motorway speed,
+ *  - an approach alert, which always takes the maximum.
+ *
+ *  The highest of these is taken straight away, so a car pulling up behind is seen at the higher rate from the next
+ *  frame. A lower rate is only taken once nothing has asked for more for a while, and the idle rate only once the
+ *  bike has been stationary with a still scene for longer, so the rate does not hunt at every flicker of the scene.
+ *  Whatever the demand, the rate is capped by what the display link can carry: the time each camera frame took to push
+ *  is averaged, and the camera is allowed a fixed share of the link.
+ *
+ *  Everything is fixed-size and nothing is allocated; the caller passes in the time, so rides can be replayed.
+ */
+
+#ifndef HUDVIEW_FRAMERATE_H
+#define HUDVIEW_FRAMERATE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* The rates the camera is asked for; between 2 and 5 fps when idle, 10 fps as before, and up to 30 fps. */
+#define HUDVIEW_FRAMERATE_STEPS                 ( 6 )
+#define HUDVIEW_FRAMERATE_IDLE_FPS              ( 3 )
+#define HUDVIEW_FRAMERATE_DEFAULT_FPS           ( 10 )
+#define HUDVIEW_FRAMERATE_MAXIMUM_FPS           ( 30 )
+
+/* A sampled pixel has changed when it moved by more than this many levels; below the first share of changed pixels
+ * the scene is still, above the second it is busy. */
+#define HUDVIEW_FRAMERATE_CHANGE_LEVELS         ( 16 )
+#define HUDVIEW_FRAMERATE_STILL_MOTION          ( 0.005 )
+#define HUDVIEW_FRAMERATE_BUSY_MOTION           ( 0.05 )
+
+/* Speeds in m/s: stationary below the first, the maximum rate from the second (90 km/h). */
+#define HUDVIEW_FRAMERATE_STATIONARY_SPEED      ( 1.0 )
+#define HUDVIEW_FRAMERATE_FAST_SPEED            ( 25.0 )
+
+/* How long the demand must stay lower before the rate follows it down, and before it drops to idle. */
+#define HUDVIEW_FRAMERATE_HOLD_US               ( 2000000LL )
+#define HUDVIEW_FRAMERATE_IDLE_HOLD_US          ( 5000000LL )
+
+/* The share of the display link the camera may take, the rest kept for HUD redraws, and how quickly the measured
+ * push time follows the link. */
+#define HUDVIEW_FRAMERATE_LINK_SHARE            ( 0.7 )
+#define HUDVIEW_FRAMERATE_PUSH_SMOOTHING        ( 0.1 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    /* The rate asked for, and whether the last update changed it. */
+    int iRate;
+    int bChanged;
+
+    /* What the inputs last asked for, and since when (and for how much at most) it has been lower than the rate. */
+    int iDemand;
+    int iLowerDemand;
+    int64_t llLowerSince;
+    int64_t llMicroseconds;
+
+    /* Mean time to push a camera frame to the display, in seconds; zero until one has been measured. */
+    double dPushSeconds;
+    double dMotion;
+
+    unsigned long ulChanges;
+    int64_t allMicrosecondsAt[ HUDVIEW_FRAMERATE_STEPS ];
+} xHUDViewFrameRate_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRateInit( xHUDViewFrameRate_t * pxRate );
+double dHUDViewFrameRateMotion( const uint8_t * pucPrevious, const uint8_t * pucCurrent, int iWidth, int iHeight );
+void vHUDViewFrameRatePushed( xHUDViewFrameRate_t * pxRate, uint64_t ullNanoseconds );
+int iHUDViewFrameRateCeiling( const xHUDViewFrameRate_t * pxRate );
+int iHUDViewFrameRateUpdate( xHUDViewFrameRate_t * pxRate, int64_t llMicroseconds, double dMotion, double dSpeed,
+                             int bAlert );
+int iHUDViewFrameRateStep( int iStep );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_FRAMERATE_H
@@ -0,0 +1,654 @@
+/** @file hudview_framering.c
+ *  @brief HUDView shared camera frame ring.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_framering.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define ALIGN_UP( ullValue, ullAlignment ) \
+    ( ( ( ullValue ) + ( ullAlignment ) - 1 ) / ( ullAlignment ) * ( ullAlignment ) )
+
+/* Frames start on cache lines so no two slots share one. */
+#define SLOT_ALIGNMENT ( 64 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Every consumer may hold a slot and the producer fill another, and the newest published frame must survive that. */
+_Static_assert( HUDVIEW_FRAMERING_SLOTS >= HUDVIEW_FRAMERING_MAX_CONSUMERS + 2, "Too few slots for the consumers" );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iMap( xHUDViewFrameRing_t * pxRing, int iDescriptor, int bProducer );
+static void vUnmap( xHUDViewFrameRing_t * pxRing );
+static int iClaimConsumer( xHUDViewFrameRing_t * pxRing, const char * pcConsumer );
+static int bProcessGone( int32_t lPid );
+static int64_t llMonotonicNanoseconds( void );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRingCreate( xHUDViewFrameRing_t * pxRing, const char * pcName, const char * pcFormat,
+                             uint32_t ulFrameBytes )
+{
+    xHUDViewFrameRingHeader_t * pxHeader = NULL;
+    size_t ulPage = ( size_t )sysconf( _SC_PAGESIZE );
+    uint64_t ullStride = ALIGN_UP( ( uint64_t )ulFrameBytes, SLOT_ALIGNMENT );
+    uint64_t ullDataOffset = ALIGN_UP( ( uint64_t )sizeof( xHUDViewFrameRingHeader_t ), ulPage );
+    uint64_t ullTotalBytes = ullDataOffset + ullStride * HUDVIEW_FRAMERING_SLOTS;
+    int iDescriptor = -1;
+    int iSlot = 0;
+
+    memset( pxRing, 0, sizeof( xHUDViewFrameRing_t ) );
+    pxRing->iWriting = -1;
+    pxRing->iConsumer = -1;
+    pxRing->iHeld = -1;
+
+    if ( ( 0 == ulFrameBytes ) || ( sizeof( pxRing->acName ) <= strlen( pcName ) )
+         || ( HUDVIEW_FRAMERING_FORMAT_LENGTH <= strlen( pcFormat ) ) )
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* A ring left behind by a run that did not shut down is replaced; anyone still attached to it keeps their
+     * mapping until they detach. */
+    ( void )shm_unlink( pcName );
+    iDescriptor = shm_open( pcName, O_RDWR | O_CREAT | O_EXCL, 0666 );
+
+    if ( 0 > iDescriptor )
+    {
+        return -1;
+    }
+
+    strcpy( pxRing->acName, pcName );
+    pxRing->bProducer = 1;
+    pxRing->ulHeaderMapping = ( size_t )ullDataOffset;
+    pxRing->ulDataMapping = ( size_t )( ullTotalBytes - ullDataOffset );
+
+    if ( ( 0 != ftruncate( iDescriptor, ( off_t )ullTotalBytes ) ) || ( 0 != iMap( pxRing, iDescriptor, 1 ) ) )
+    {
+        close( iDescriptor );
+        ( void )shm_unlink( pcName );
+        return -1;
+    }
+
+    close( iDescriptor );
+
+    /* The object is new, so already zeroed; the magic goes in last, once everything else is in place. */
+    pxHeader = pxRing->pxHeader;
+    pxHeader->ulVersion = HUDVIEW_FRAMERING_VERSION;
+    pxHeader->ulSlots = HUDVIEW_FRAMERING_SLOTS;
+    pxHeader->ulFrameCapacity = ulFrameBytes;
+    pxHeader->ullSlotStride = ullStride;
+    pxHeader->ullDataOffset = ullDataOffset;
+    pxHeader->ullTotalBytes = ullTotalBytes;
+    pxHeader->lProducerPid = ( int32_t )getpid();
+    strcpy( pxHeader->acFormat, pcFormat );
+
+    for ( iSlot = 0; iSlot < HUDVIEW_FRAMERING_MAX_CONSUMERS; iSlot++ )
+    {
+        pxHeader->axConsumers[ iSlot ].lHeldSlot = -1;
+    }
+
+    __atomic_store_n( &pxHeader->ulMagic, HUDVIEW_FRAMERING_MAGIC, __ATOMIC_RELEASE );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint8_t * pucHUDViewFrameRingBeginWrite( xHUDViewFrameRing_t * pxRing )
+{
+    xHUDViewFrameRingHeader_t * pxHeader = pxRing->pxHeader;
+    xHUDViewFrameRingSlot_t * pxSlot = NULL;
+    uint32_t ulExpected = 0;
+    uint32_t ulTried = 0;
+    uint64_t ullOldest = 0;
+    int iOldest = -1;
+    int iPass = 0;
+    int iSlot = 0;
+
+    if ( 0 <= pxRing->iWriting )
+    {
+        return pxRing->pucData + ( size_t )pxRing->iWriting * pxHeader->ullSlotStride;
+    }
+
+    /* The oldest slot nobody holds; a consumer may take one between the scan and the claim, so try the next. Should
+     * every slot be held, consumers that have died may be holding some. */
+    for ( iPass = 0; iPass < 2; iPass++ )
+    {
+        ulTried = 0;
+
+        for ( ;; )
+        {
+            iOldest = -1;
+
+            for ( iSlot = 0; iSlot < HUDVIEW_FRAMERING_SLOTS; iSlot++ )
+            {
+                pxSlot = &pxHeader->axSlots[ iSlot ];
+
+                if ( ( 0 == ( ulTried & ( 1UL << iSlot ) ) )
+                     && ( 0 == __atomic_load_n( &pxSlot->ulReferences, __ATOMIC_ACQUIRE ) )
+                     && ( ( 0 > iOldest ) || ( pxSlot->ullSequence < ullOldest ) ) )
+                {
+                    iOldest = iSlot;
+                    ullOldest = pxSlot->ullSequence;
+                }
+            }
+
+            if ( 0 > iOldest )
+            {
+                break;
+            }
+
+            ulExpected = 0;
+            ulTried |= 1UL << iOldest;
+
+            if ( __atomic_compare_exchange_n( &pxHeader->axSlots[ iOldest ].ulReferences, &ulExpected,
+                                              HUDVIEW_FRAMERING_WRITING, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) )
+            {
+                /* No longer the frame it was, should this write be abandoned. */
+                __atomic_store_n( &pxHeader->axSlots[ iOldest ].ullSequence, 0, __ATOMIC_RELAXED );
+                pxRing->iWriting = iOldest;
+
+                return pxRing->pucData + ( size_t )iOldest * pxHeader->ullSlotStride;
+            }
+        }
+
+        if ( ( 0 != iPass ) || ( 0 == iHUDViewFrameRingReap( pxRing ) ) )
+        {
+            break;
+        }
+    }
+
+    __atomic_fetch_add( &pxHeader->ullProducerDropped, 1, __ATOMIC_RELAXED );
+
+    return NULL;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRingCommit( xHUDViewFrameRing_t * pxRing, uint32_t ulBytes, int64_t llNanoseconds )
+{
+    xHUDViewFrameRingHeader_t * pxHeader = pxRing->pxHeader;
+    xHUDViewFrameRingSlot_t * pxSlot = NULL;
+    uint64_t ullSequence = 0;
+
+    if ( 0 > pxRing->iWriting )
+    {
+        return;
+    }
+
+    pxSlot = &pxHeader->axSlots[ pxRing->iWriting ];
+    ullSequence = pxHeader->ullPublished + 1;
+    pxSlot->ulBytes = ( ulBytes < pxHeader->ulFrameCapacity ) ? ulBytes : pxHeader->ulFrameCapacity;
+    pxSlot->llNanoseconds = llNanoseconds;
+    __atomic_store_n( &pxSlot->ullSequence, ullSequence, __ATOMIC_RELAXED );
+
+    /* Releasing the slot makes the frame and its details visible to whoever takes it next. */
+    __atomic_store_n( &pxSlot->ulReferences, 0, __ATOMIC_RELEASE );
+    __atomic_store_n( &pxHeader->ullPublished, ullSequence, __ATOMIC_RELEASE );
+    __atomic_add_fetch( &pxHeader->ulFutex, 1, __ATOMIC_RELEASE );
+
+    if ( 0 != __atomic_load_n( &pxHeader->ulWaiters, __ATOMIC_ACQUIRE ) )
+    {
+        syscall( SYS_futex, &pxHeader->ulFutex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0 );
+    }
+
+    pxRing->iWriting = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRingAbort( xHUDViewFrameRing_t * pxRing )
+{
+    if ( 0 <= pxRing->iWriting )
+    {
+        __atomic_store_n( &pxRing->pxHeader->axSlots[ pxRing->iWriting ].ulReferences, 0, __ATOMIC_RELEASE );
+        pxRing->iWriting = -1;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRingDestroy( xHUDViewFrameRing_t * pxRing )
+{
+    if ( NULL == pxRing->pxHeader )
+    {
+        return;
+    }
+
+    vHUDViewFrameRingAbort( pxRing );
+
+    /* Waiting consumers are woken to find the ring closed. */
+    __atomic_store_n( &pxRing->pxHeader->ulClosed, 1, __ATOMIC_RELEASE );
+    __atomic_add_fetch( &pxRing->pxHeader->ulFutex, 1, __ATOMIC_RELEASE );
+    syscall( SYS_futex, &pxRing->pxHeader->ulFutex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0 );
+
+    vUnmap( pxRing );
+    ( void )shm_unlink( pxRing->acName );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRingAttach( xHUDViewFrameRing_t * pxRing, const char * pcName, const char * pcConsumer )
+{
+    struct stat xStat;
+    int iDescriptor = -1;
+
+    memset( pxRing, 0, sizeof( xHUDViewFrameRing_t ) );
+    pxRing->iWriting = -1;
+    pxRing->iConsumer = -1;
+    pxRing->iHeld = -1;
+
+    if ( ( sizeof( pxRing->acName ) <= strlen( pcName ) )
+         || ( ( NULL != pcConsumer ) && ( HUDVIEW_FRAMERING_NAME_LENGTH <= strlen( pcConsumer ) ) ) )
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    iDescriptor = shm_open( pcName, O_RDWR, 0 );
+
+    if ( 0 > iDescriptor )
+    {
+        return -1;
+    }
+
+    strcpy( pxRing->acName, pcName );
+    pxRing->ulHeaderMapping = ALIGN_UP( sizeof( xHUDViewFrameRingHeader_t ), ( size_t )sysconf( _SC_PAGESIZE ) );
+
+    if ( ( 0 != fstat( iDescriptor, &xStat ) ) || ( ( off_t )pxRing->ulHeaderMapping >= xStat.st_size ) )
+    {
+        close( iDescriptor );
+        errno = EPROTO;
+        return -1;
+    }
+
+    pxRing->ulDataMapping = ( size_t )xStat.st_size - pxRing->ulHeaderMapping;
+
+    if ( 0 != iMap( pxRing, iDescriptor, 0 ) )
+    {
+        close( iDescriptor );
+        return -1;
+    }
+
+    close( iDescriptor );
+
+    /* Only a complete ring of this version, laid out as mapped, is used. */
+    if ( ( HUDVIEW_FRAMERING_MAGIC != __atomic_load_n( &pxRing->pxHeader->ulMagic, __ATOMIC_ACQUIRE ) )
+         || ( HUDVIEW_FRAMERING_VERSION != pxRing->pxHeader->ulVersion )
+         || ( HUDVIEW_FRAMERING_SLOTS != pxRing->pxHeader->ulSlots )
+         || ( pxRing->ulHeaderMapping != pxRing->pxHeader->ullDataOffset )
+         || ( ( uint64_t )xStat.st_size != pxRing->pxHeader->ullTotalBytes ) )
+    {
+        vUnmap( pxRing );
+        errno = EPROTO;
+        return -1;
+    }
+
+    /* Without a consumer name the ring is only watched, as hudview_camera consumers does. */
+    if ( ( NULL != pcConsumer ) && ( 0 != iClaimConsumer( pxRing, pcConsumer ) ) )
+    {
+        vUnmap( pxRing );
+        errno = EBUSY;
+        return -1;
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRingWait( xHUDViewFrameRing_t * pxRing, int iTimeoutMilliseconds )
+{
+    xHUDViewFrameRingHeader_t * pxHeader = pxRing->pxHeader;
+    int64_t llDeadline = llMonotonicNanoseconds() + ( int64_t )iTimeoutMilliseconds * 1000000LL;
+    int64_t llRemaining = 0;
+    struct timespec xTimeout;
+    uint32_t ulFutex = 0;
+
+    if ( 0 > pxRing->iConsumer )
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* The futex is read before the ring is checked, so a frame published in between makes the wait return at once. */
+    for ( ;; )
+    {
+        ulFutex = __atomic_load_n( &pxHeader->ulFutex, __ATOMIC_ACQUIRE );
+
+        if ( 0 != __atomic_load_n( &pxHeader->ulClosed, __ATOMIC_ACQUIRE ) )
+        {
+            errno = EPIPE;
+            return -1;
+        }
+
+        if ( __atomic_load_n( &pxHeader->ullPublished, __ATOMIC_ACQUIRE )
+             >= pxHeader->axConsumers[ pxRing->iConsumer ].ullCursor )
+        {
+            return 0;
+        }
+
+        llRemaining = llDeadline - llMonotonicNanoseconds();
+
+        if ( 0 >= llRemaining )
+        {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+
+        xTimeout.tv_sec = ( time_t )( llRemaining / 1000000000LL );
+        xTimeout.tv_nsec = ( long )( llRemaining % 1000000000LL );
+        __atomic_fetch_add( &pxHeader->ulWaiters, 1, __ATOMIC_ACQ_REL );
+        syscall( SYS_futex, &pxHeader->ulFutex, FUTEX_WAIT, ulFutex, &xTimeout, NULL, 0 );
+        __atomic_fetch_sub( &pxHeader->ulWaiters, 1, __ATOMIC_ACQ_REL );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRingAcquire( xHUDViewFrameRing_t * pxRing, int bNewest, xHUDViewFrame_t * pxFrame )
+{
+    xHUDViewFrameRingHeader_t * pxHeader = pxRing->pxHeader;
+    xHUDViewFrameRingConsumer_t * pxConsumer = NULL;
+    xHUDViewFrameRingSlot_t * pxSlot = NULL;
+    uint64_t ullPublished = 0;
+    uint64_t ullSequence = 0;
+    uint64_t ullChosen = 0;
+    uint32_t ulReferences = 0;
+    int iChosen = -1;
+    int iAttempt = 0;
+    int iSlot = 0;
+
+    if ( 0 > pxRing->iConsumer )
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pxConsumer = &pxHeader->axConsumers[ pxRing->iConsumer ];
+    ullPublished = __atomic_load_n( &pxHeader->ullPublished, __ATOMIC_ACQUIRE );
+
+    /* Nothing new: the frame already held stays held. */
+    if ( ullPublished < pxConsumer->ullCursor )
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    /* Holding one slot at most is what guarantees the producer a free one. */
+    vHUDViewFrameRingRelease( pxRing );
+
+    /* The frame wanted is the newest, or the next in order if it is still there, else the oldest still there. The
+     * producer may refill the chosen slot before it is claimed, which shows in its sequence; then choose again. */
+    for ( iAttempt = 0; iAttempt < 2 * HUDVIEW_FRAMERING_SLOTS; iAttempt++ )
+    {
+        iChosen = -1;
+
+        for ( iSlot = 0; iSlot < HUDVIEW_FRAMERING_SLOTS; iSlot++ )
+        {
+            pxSlot = &pxHeader->axSlots[ iSlot ];
+
+            if ( 0 != ( __atomic_load_n( &pxSlot->ulReferences, __ATOMIC_ACQUIRE ) & HUDVIEW_FRAMERING_WRITING ) )
+            {
+                continue;
+            }
+
+            ullSequence = __atomic_load_n( &pxSlot->ullSequence, __ATOMIC_RELAXED );
+
+            if ( ( ullSequence >= pxConsumer->ullCursor )
+                 && ( ( 0 > iChosen ) || ( bNewest ? ( ullSequence > ullChosen ) : ( ullSequence < ullChosen ) ) ) )
+            {
+                iChosen = iSlot;
+                ullChosen = ullSequence;
+            }
+        }
+
+        if ( 0 > iChosen )
+        {
+            break;
+        }
+
+        pxSlot = &pxHeader->axSlots[ iChosen ];
+        ulReferences = __atomic_load_n( &pxSlot->ulReferences, __ATOMIC_RELAXED );
+
+        if ( ( 0 == ( ulReferences & HUDVIEW_FRAMERING_WRITING ) )
+             && __atomic_compare_exchange_n( &pxSlot->ulReferences, &ulReferences, ulReferences + 1, 0,
+                                             __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) )
+        {
+            if ( ullChosen == __atomic_load_n( &pxSlot->ullSequence, __ATOMIC_RELAXED ) )
+            {
+                /* Recorded only once the reference is taken: a consumer that dies in between leaks the slot rather
+                 * than having it released twice. */
+                pxConsumer->lHeldSlot = iChosen;
+                pxRing->iHeld = iChosen;
+
+                ullPublished = __atomic_load_n( &pxHeader->ullPublished, __ATOMIC_ACQUIRE );
+                pxFrame->pucData = pxRing->pucData + ( size_t )iChosen * pxHeader->ullSlotStride;
+                pxFrame->ulBytes = pxSlot->ulBytes;
+                pxFrame->ullSequence = ullChosen;
+                pxFrame->llNanoseconds = pxSlot->llNanoseconds;
+                pxFrame->ullLag = ullPublished - ullChosen;
+
+                pxConsumer->ullFramesDropped += ullChosen - pxConsumer->ullCursor;
+                pxConsumer->ullFramesRead++;
+                pxConsumer->ullCursor = ullChosen + 1;
+                pxConsumer->ullLag = pxFrame->ullLag;
+                pxConsumer->llAgeNanoseconds = llMonotonicNanoseconds() - pxFrame->llNanoseconds;
+
+                if ( pxConsumer->ullLag > pxConsumer->ullMaximumLag )
+                {
+                    pxConsumer->ullMaximumLag = pxConsumer->ullLag;
+                }
+
+                if ( pxConsumer->llAgeNanoseconds > pxConsumer->llMaximumAgeNanoseconds )
+                {
+                    pxConsumer->llMaximumAgeNanoseconds = pxConsumer->llAgeNanoseconds;
+                }
+
+                return 0;
+            }
+
+            __atomic_fetch_sub( &pxSlot->ulReferences, 1, __ATOMIC_RELEASE );
+        }
+    }
+
+    errno = EAGAIN;
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRingRelease( xHUDViewFrameRing_t * pxRing )
+{
+    if ( ( 0 > pxRing->iConsumer ) || ( 0 > pxRing->iHeld ) )
+    {
+        return;
+    }
+
+    /* Forgotten before it is released, for the same reason it is recorded after it is taken. */
+    __atomic_store_n( &pxRing->pxHeader->axConsumers[ pxRing->iConsumer ].lHeldSlot, -1, __ATOMIC_RELEASE );
+    __atomic_fetch_sub( &pxRing->pxHeader->axSlots[ pxRing->iHeld ].ulReferences, 1, __ATOMIC_RELEASE );
+    pxRing->iHeld = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRingDetach( xHUDViewFrameRing_t * pxRing )
+{
+    if ( NULL == pxRing->pxHeader )
+    {
+        return;
+    }
+
+    if ( 0 <= pxRing->iConsumer )
+    {
+        vHUDViewFrameRingRelease( pxRing );
+        __atomic_store_n( &pxRing->pxHeader->axConsumers[ pxRing->iConsumer ].ulState,
+                          HUDVIEW_FRAMERING_CONSUMER_FREE, __ATOMIC_RELEASE );
+        pxRing->iConsumer = -1;
+    }
+
+    vUnmap( pxRing );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRingReap( xHUDViewFrameRing_t * pxRing )
+{
+    xHUDViewFrameRingHeader_t * pxHeader = pxRing->pxHeader;
+    xHUDViewFrameRingConsumer_t * pxConsumer = NULL;
+    uint32_t ulExpected = 0;
+    int32_t lHeld = -1;
+    int iReaped = 0;
+    int iConsumer = 0;
+
+    for ( iConsumer = 0; iConsumer < HUDVIEW_FRAMERING_MAX_CONSUMERS; iConsumer++ )
+    {
+        pxConsumer = &pxHeader->axConsumers[ iConsumer ];
+        ulExpected = HUDVIEW_FRAMERING_CONSUMER_READY;
+
+        /* Claiming the entry back first means only one process ever releases what a dead consumer held. */
+        if ( ( HUDVIEW_FRAMERING_CONSUMER_READY != __atomic_load_n( &pxConsumer->ulState, __ATOMIC_ACQUIRE ) )
+             || !bProcessGone( pxConsumer->lPid )
+             || !__atomic_compare_exchange_n( &pxConsumer->ulState, &ulExpected, HUDVIEW_FRAMERING_CONSUMER_CLAIMING,
+                                              0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) )
+        {
+            continue;
+        }
+
+        lHeld = __atomic_exchange_n( &pxConsumer->lHeldSlot, -1, __ATOMIC_ACQ_REL );
+
+        if ( ( 0 <= lHeld ) && ( HUDVIEW_FRAMERING_SLOTS > lHeld ) )
+        {
+            __atomic_fetch_sub( &pxHeader->axSlots[ lHeld ].ulReferences, 1, __ATOMIC_RELEASE );
+        }
+
+        __atomic_fetch_add( &pxHeader->ullReclaimed, 1, __ATOMIC_RELAXED );
+        __atomic_store_n( &pxConsumer->ulState, HUDVIEW_FRAMERING_CONSUMER_FREE, __ATOMIC_RELEASE );
+        iReaped++;
+    }
+
+    return iReaped;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFrameRingGetConsumer( const xHUDViewFrameRing_t * pxRing, int iConsumer,
+                                   xHUDViewFrameRingConsumer_t * pxConsumer )
+{
+    const xHUDViewFrameRingConsumer_t * pxShared = &pxRing->pxHeader->axConsumers[ iConsumer ];
+
+    /* The counters are only written by their consumer; a copy taken while it runs is near enough for reporting. */
+    memcpy( pxConsumer, pxShared, sizeof( xHUDViewFrameRingConsumer_t ) );
+    pxConsumer->ulState = __atomic_load_n( &pxShared->ulState, __ATOMIC_ACQUIRE );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iMap( xHUDViewFrameRing_t * pxRing, int iDescriptor, int bProducer )
+{
+    void * pvHeader = mmap( NULL, pxRing->ulHeaderMapping, PROT_READ | PROT_WRITE, MAP_SHARED, iDescriptor, 0 );
+    void * pvData = MAP_FAILED;
+
+    if ( MAP_FAILED == pvHeader )
+    {
+        return -1;
+    }
+
+    /* Consumers get the frames read-only. */
+    pvData = mmap( NULL, pxRing->ulDataMapping, PROT_READ | ( bProducer ? PROT_WRITE : 0 ), MAP_SHARED, iDescriptor,
+                   ( off_t )pxRing->ulHeaderMapping );
+
+    if ( MAP_FAILED == pvData )
+    {
+        munmap( pvHeader, pxRing->ulHeaderMapping );
+        return -1;
+    }
+
+    pxRing->pxHeader = ( xHUDViewFrameRingHeader_t * )pvHeader;
+    pxRing->pucData = ( uint8_t * )pvData;
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUnmap( xHUDViewFrameRing_t * pxRing )
+{
+    if ( NULL != pxRing->pucData )
+    {
+        munmap( pxRing->pucData, pxRing->ulDataMapping );
+        pxRing->pucData = NULL;
+    }
+
+    if ( NULL != pxRing->pxHeader )
+    {
+        munmap( pxRing->pxHeader, pxRing->ulHeaderMapping );
+        pxRing->pxHeader = NULL;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iClaimConsumer( xHUDViewFrameRing_t * pxRing, const char * pcConsumer )
+{
+    xHUDViewFrameRingHeader_t * pxHeader = pxRing->pxHeader;
+    xHUDViewFrameRingConsumer_t * pxConsumer = NULL;
+    uint32_t ulExpected = 0;
+    int iPass = 0;
+    int iConsumer = 0;
+
+    /* As the metrics page does its component slots; should they all be taken, some may belong to dead consumers. */
+    for ( iPass = 0; iPass < 2; iPass++ )
+    {
+        for ( iConsumer = 0; iConsumer < HUDVIEW_FRAMERING_MAX_CONSUMERS; iConsumer++ )
+        {
+            pxConsumer = &pxHeader->axConsumers[ iConsumer ];
+            ulExpected = HUDVIEW_FRAMERING_CONSUMER_FREE;
+
+            if ( __atomic_compare_exchange_n( &pxConsumer->ulState, &ulExpected, HUDVIEW_FRAMERING_CONSUMER_CLAIMING,
+                                              0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) )
+            {
+                memset( pxConsumer->acName, 0, sizeof( pxConsumer->acName ) );
+                strcpy( pxConsumer->acName, pcConsumer );
+                pxConsumer->lPid = ( int32_t )getpid();
+                pxConsumer->lHeldSlot = -1;
+                pxConsumer->ullFramesRead = 0;
+                pxConsumer->ullFramesDropped = 0;
+                pxConsumer->ullLag = 0;
+                pxConsumer->ullMaximumLag = 0;
+                pxConsumer->llAgeNanoseconds = 0;
+                pxConsumer->llMaximumAgeNanoseconds = 0;
+
+                /* A new consumer starts with the next frame published. */
+                pxConsumer->ullCursor = __atomic_load_n( &pxHeader->ullPublished, __ATOMIC_ACQUIRE ) + 1;
+                __atomic_store_n( &pxConsumer->ulState, HUDVIEW_FRAMERING_CONSUMER_READY, __ATOMIC_RELEASE );
+                pxRing->iConsumer = iConsumer;
+
+                return 0;
+            }
+        }
+
+        if ( 0 == iHUDViewFrameRingReap( pxRing ) )
+        {
+            break;
+        }
+    }
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bProcessGone( int32_t lPid )
+{
+    return ( 0 >= lPid ) || ( ( 0 != kill( ( pid_t )lPid, 0 ) ) && ( ESRCH == errno ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llMonotonicNanoseconds( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( int64_t )xNow.tv_sec * 1000000000LL + xNow.tv_nsec;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,145 @@
+/** @file hudview_framering.h
+ *  @brief HUDView shared camera frame ring.
+ *
+ *  The control application publishes every raw camera frame once into a ring of slots in POSIX shared memory, and
+ *  any number of consumers, in the control application or in other processes, map the frames read-only and take
+ *  them from there without copying. Each slot carries a reference count: a consumer holds at most one slot at a time,
+ *  and the producer only ever refills a slot nobody holds, the oldest one first, so a slow or stuck consumer keeps
+ *  its one frame and falls behind, but never holds up the producer or the other consumers. With more slots than
+ *  consumers there is always one free.
+ *
+ *  Each consumer has its own cursor, the next sequence number it wants, and takes either the next frame in order
+ *  (a recorder) or the newest one (a display); frames the ring has moved past are counted as dropped, and the lag
+ *  behind the producer is recorded in frames and in age. Consumers wait for new frames on a futex in the header.
+ *
+ *  The header with the slot and consumer tables is mapped read-write by everyone, the frame data read-only by
+ *  consumers. A consumer that dies holding a slot is found by its process id and its reference released the next
+ *  time the producer or a new consumer runs short.
+ */
+
+#ifndef HUDVIEW_FRAMERING_H
+#define HUDVIEW_FRAMERING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_FRAMERING_SHM_NAME              "/hudview_frames"
+#define HUDVIEW_FRAMERING_MAGIC                 ( 0x48564652UL )
+#define HUDVIEW_FRAMERING_VERSION               ( 1 )
+#define HUDVIEW_FRAMERING_SLOTS                 ( 8 )
+#define HUDVIEW_FRAMERING_MAX_CONSUMERS         ( 6 )
+#define HUDVIEW_FRAMERING_NAME_LENGTH           ( 24 )
+#define HUDVIEW_FRAMERING_FORMAT_LENGTH         ( 64 )
+
+/* Set in a slot's reference count while the producer fills it; consumers cannot take it until it is published. */
+#define HUDVIEW_FRAMERING_WRITING               ( 0x80000000UL )
+
+#define HUDVIEW_FRAMERING_CONSUMER_FREE         ( 0 )
+#define HUDVIEW_FRAMERING_CONSUMER_CLAIMING     ( 1 )
+#define HUDVIEW_FRAMERING_CONSUMER_READY        ( 2 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    uint32_t ulReferences;
+    uint32_t ulBytes;
+
+    /* Zero until the slot is first published. */
+    uint64_t ullSequence;
+    int64_t llNanoseconds;
+} xHUDViewFrameRingSlot_t;
+
+typedef struct {
+    uint32_t ulState;
+    int32_t lPid;
+    char acName[ HUDVIEW_FRAMERING_NAME_LENGTH ];
+    int32_t lHeldSlot;
+    uint32_t ulReserved;
+
+    /* The next sequence this consumer wants. */
+    uint64_t ullCursor;
+    uint64_t ullFramesRead;
+    uint64_t ullFramesDropped;
+
+    /* How far behind the newest frame the last one taken was, in frames and in time since it was published. */
+    uint64_t ullLag;
+    uint64_t ullMaximumLag;
+    int64_t llAgeNanoseconds;
+    int64_t llMaximumAgeNanoseconds;
+} xHUDViewFrameRingConsumer_t;
+
+typedef struct {
+    uint32_t ulMagic;
+    uint32_t ulVersion;
+    uint32_t ulSlots;
+    uint32_t ulFrameCapacity;
+    uint64_t ullSlotStride;
+    uint64_t ullDataOffset;
+    uint64_t ullTotalBytes;
+    int32_t lProducerPid;
+    uint32_t ulClosed;
+
+    /* What the frames are, in the form Control takes with --camera, e.g. "160x120:hflip". */
+    char acFormat[ HUDVIEW_FRAMERING_FORMAT_LENGTH ];
+
+    /* Bumped on every publish; consumers wait on it while there is nothing new. */
+    uint32_t ulFutex;
+    uint32_t ulWaiters;
+    uint64_t ullPublished;
+    uint64_t ullProducerDropped;
+    uint64_t ullReclaimed;
+    xHUDViewFrameRingSlot_t axSlots[ HUDVIEW_FRAMERING_SLOTS ];
+    xHUDViewFrameRingConsumer_t axConsumers[ HUDVIEW_FRAMERING_MAX_CONSUMERS ];
+} xHUDViewFrameRingHeader_t;
+
+typedef struct {
+    const uint8_t * pucData;
+    uint32_t ulBytes;
+    uint64_t ullSequence;
+    int64_t llNanoseconds;
+    uint64_t ullLag;
+} xHUDViewFrame_t;
+
+typedef struct {
+    char acName[ 64 ];
+    xHUDViewFrameRingHeader_t * pxHeader;
+    size_t ulHeaderMapping;
+    uint8_t * pucData;
+    size_t ulDataMapping;
+    int bProducer;
+
+    /* The producer's slot being filled, and a consumer's entry and the slot it holds; -1 for none. */
+    int iWriting;
+    int iConsumer;
+    int iHeld;
+} xHUDViewFrameRing_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewFrameRingCreate( xHUDViewFrameRing_t * pxRing, const char * pcName, const char * pcFormat,
+                             uint32_t ulFrameBytes );
+uint8_t * pucHUDViewFrameRingBeginWrite( xHUDViewFrameRing_t * pxRing );
+void vHUDViewFrameRingCommit( xHUDViewFrameRing_t * pxRing, uint32_t ulBytes, int64_t llNanoseconds );
+void vHUDViewFrameRingAbort( xHUDViewFrameRing_t * pxRing );
+void vHUDViewFrameRingDestroy( xHUDViewFrameRing_t * pxRing );
+
+int iHUDViewFrameRingAttach( xHUDViewFrameRing_t * pxRing, const char * pcName, const char * pcConsumer );
+int iHUDViewFrameRingWait( xHUDViewFrameRing_t * pxRing, int iTimeoutMilliseconds );
+int iHUDViewFrameRingAcquire( xHUDViewFrameRing_t * pxRing, int bNewest, xHUDViewFrame_t * pxFrame );
+void vHUDViewFrameRingRelease( xHUDViewFrameRing_t * pxRing );
+void vHUDViewFrameRingDetach( xHUDViewFrameRing_t * pxRing );
+
+int iHUDViewFrameRingReap( xHUDViewFrameRing_t * pxRing );
+void vHUDViewFrameRingGetConsumer( const xHUDViewFrameRing_t * pxRing, int iConsumer,
+                                   xHUDViewFrameRingConsumer_t * pxConsumer );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_FRAMERING_H
@@ -0,0 +1,284 @@
+/** @file hudview_fusion.c
+ *  @brief HUDView GPS and accelerometer fusion filter.
+ */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <string.h>
+
+#include "hudview_fusion.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Starting uncertainty of the accelerometer bias (m^2/s^4), and the heading uncertainty past which it means nothing. */
+#define INITIAL_BIAS_VARIANCE       ( 0.25 )
+#define MAXIMUM_HEADING_VARIANCE    ( M_PI * M_PI )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dWrapAngle( double dAngle );
+static double dAngleDifference( double dAngle, double dReference );
+static int bSteersByLateral( const xHUDViewFusion_t * pxFusion );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFusionInit( xHUDViewFusion_t * pxFusion )
+{
+    memset( pxFusion, 0, sizeof( *pxFusion ) );
+    pxFusion->dYawVariance = HUDVIEW_FUSION_INITIAL_UNEXPLAINED_YAW;
+    pxFusion->dUnexplainedYawVariance = HUDVIEW_FUSION_INITIAL_UNEXPLAINED_YAW;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFusionPredict( xHUDViewFusion_t * pxFusion, int64_t llMicroseconds )
+{
+    double dSeconds = 0.0;
+    double dHeldSeconds = 0.0;
+    double dHeldStart = 0.0;
+    double dHeldEnd = 0.0;
+    double dQuadratic = 0.0;
+    double dTurn = 0.0;
+    double dTurnSeconds = 0.0;
+    double dYawVariance = 0.0;
+    int bSteer = 0;
+
+    /* Time only moves forward; the first call just sets the clock. */
+    if ( ( 0 == pxFusion->llMicroseconds ) || ( llMicroseconds <= pxFusion->llMicroseconds ) )
+    {
+        if ( 0 == pxFusion->llMicroseconds )
+        {
+            pxFusion->llMicroseconds = llMicroseconds;
+        }
+
+        return;
+    }
+
+    dSeconds = ( llMicroseconds - pxFusion->llMicroseconds ) / 1e6;
+
+    /* The latest acceleration only counts for the part of the step that lies within its hold time. */
+    if ( 0 != pxFusion->llAccelerationMicroseconds )
+    {
+        dHeldStart = fmax( 0.0, ( pxFusion->llAccelerationMicroseconds - pxFusion->llMicroseconds ) / 1e6 );
+        dHeldEnd = fmin( dSeconds, ( pxFusion->llAccelerationMicroseconds - pxFusion->llMicroseconds ) / 1e6
+                                   + HUDVIEW_FUSION_MAXIMUM_HOLD_SECONDS );
+        dHeldSeconds = fmax( 0.0, dHeldEnd - dHeldStart );
+    }
+
+    if ( pxFusion->bHasSpeed )
+    {
+        /* x' = F x with F = [ 1 -dt ; 0 1 ], P' = F P F' + Q for white acceleration noise and a random-walk bias. */
+        dQuadratic = dSeconds * dSeconds;
+        pxFusion->dSpeed += ( pxFusion->dLongitudinal - pxFusion->dBias ) * dHeldSeconds;
+        pxFusion->dSpeedVariance += -2.0 * dSeconds * pxFusion->dCovariance + dQuadratic * pxFusion->dBiasVariance
+                                    + HUDVIEW_FUSION_ACCELERATION_NOISE * dSeconds
+                                    + HUDVIEW_FUSION_BIAS_NOISE * dQuadratic * dSeconds / 3.0;
+        pxFusion->dCovariance += -dSeconds * pxFusion->dBiasVariance - HUDVIEW_FUSION_BIAS_NOISE * dQuadratic / 2.0;
+        pxFusion->dBiasVariance += HUDVIEW_FUSION_BIAS_NOISE * dSeconds;
+
+        /* Riding backwards is not a thing; do not let drift suggest otherwise. */
+        if ( 0.0 > pxFusion->dSpeed )
+        {
+            pxFusion->dSpeed = 0.0;
+        }
+    }
+
+    if ( pxFusion->bHasHeading )
+    {
+        dTurnSeconds = pxFusion->dTurnSeconds;
+
+        /* Steer by the lateral acceleration only where it has been seen to follow the turns, and otherwise hold the
+         * last course. */
+        bSteer = bSteersByLateral( pxFusion );
+        dYawVariance = fmax( 0.0, bSteer ? pxFusion->dUnexplainedYawVariance : pxFusion->dYawVariance );
+
+        /* A lateral acceleration a at speed v means a yaw rate of a / v, turning right for a positive a. */
+        if ( pxFusion->bHasSpeed && ( HUDVIEW_FUSION_MINIMUM_TURN_SPEED < pxFusion->dSpeed ) )
+        {
+            dTurn = pxFusion->dLateral / pxFusion->dSpeed * dHeldSeconds;
+            pxFusion->dHeading = bSteer ? dWrapAngle( pxFusion->dHeading + dTurn ) : pxFusion->dHeading;
+            pxFusion->dLateralTurn += dTurn;
+            pxFusion->dTurnSeconds += dSeconds;
+        }
+
+        /* A turn the filter cannot see keeps going, so its share grows with the square of the time moved since the
+         * last course rather than with the time itself. */
+        pxFusion->dHeadingVariance = fmin( MAXIMUM_HEADING_VARIANCE,
+                                           pxFusion->dHeadingVariance + HUDVIEW_FUSION_HEADING_NOISE * dSeconds
+                                           + dYawVariance * ( pxFusion->dTurnSeconds * pxFusion->dTurnSeconds
+                                                              - dTurnSeconds * dTurnSeconds ) );
+    }
+
+    pxFusion->llMicroseconds = llMicroseconds;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFusionAccelerometer( xHUDViewFusion_t * pxFusion, int64_t llMicroseconds, double dLongitudinal,
+                                  double dLateral )
+{
+    /* The previous sample holds up to this one, which then holds from here on. */
+    vHUDViewFusionPredict( pxFusion, llMicroseconds );
+
+    pxFusion->dLongitudinal = dLongitudinal;
+    pxFusion->dLateral = dLateral;
+    pxFusion->llAccelerationMicroseconds = llMicroseconds;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFusionGPS( xHUDViewFusion_t * pxFusion, int64_t llMicroseconds, double dSpeed, double dHeading )
+{
+    const double dSpeedNoise = HUDVIEW_FUSION_GPS_SPEED_SIGMA * HUDVIEW_FUSION_GPS_SPEED_SIGMA;
+    double dInnovation = 0.0;
+    double dInnovationVariance = 0.0;
+    double dSpeedGain = 0.0;
+    double dBiasGain = 0.0;
+    double dHeadingNoise = 0.0;
+    double dHeadingGain = 0.0;
+    double dCourseGap = 0.0;
+    double dTurn = 0.0;
+    double dUnexplained = 0.0;
+    double dNoise = 0.0;
+
+    vHUDViewFusionPredict( pxFusion, llMicroseconds );
+
+    dInnovation = dSpeed - pxFusion->dSpeed;
+    dInnovationVariance = pxFusion->dSpeedVariance + dSpeedNoise;
+
+    if ( !pxFusion->bHasSpeed )
+    {
+        pxFusion->dSpeed = dSpeed;
+        pxFusion->dBias = 0.0;
+        pxFusion->dSpeedVariance = dSpeedNoise;
+        pxFusion->dCovariance = 0.0;
+        pxFusion->dBiasVariance = INITIAL_BIAS_VARIANCE;
+        pxFusion->bHasSpeed = 1;
+    }
+    else if ( ( HUDVIEW_FUSION_GATE_SIGMAS * HUDVIEW_FUSION_GATE_SIGMAS * dInnovationVariance
+                < dInnovation * dInnovation ) && ( HUDVIEW_FUSION_MAXIMUM_REJECTIONS > pxFusion->iRejections ) )
+    {
+        /* A lone outlier is dropped, and leaves the age of the last fix as it was. */
+        pxFusion->iRejections++;
+        pxFusion->ulGPSRejected++;
+        return;
+    }
+    else if ( HUDVIEW_FUSION_MAXIMUM_REJECTIONS <= pxFusion->iRejections )
+    {
+        /* Several outliers in a row mean the estimate has gone wrong rather than the GPS; start over from the fix. */
+        pxFusion->dSpeed = dSpeed;
+        pxFusion->dSpeedVariance = dSpeedNoise;
+        pxFusion->dCovariance = 0.0;
+    }
+    else
+    {
+        /* K = P H' / ( H P H' + R ) with H = [ 1 0 ], then P' = ( I - K H ) P. */
+        dSpeedGain = pxFusion->dSpeedVariance / dInnovationVariance;
+        dBiasGain = pxFusion->dCovariance / dInnovationVariance;
+        pxFusion->dSpeed += dSpeedGain * dInnovation;
+        pxFusion->dBias += dBiasGain * dInnovation;
+        pxFusion->dBiasVariance -= dBiasGain * pxFusion->dCovariance;
+        pxFusion->dCovariance *= 1.0 - dSpeedGain;
+        pxFusion->dSpeedVariance *= 1.0 - dSpeedGain;
+
+        if ( 0.0 > pxFusion->dSpeed )
+        {
+            pxFusion->dSpeed = 0.0;
+        }
+    }
+
+    pxFusion->iRejections = 0;
+    pxFusion->llGPSMicroseconds = llMicroseconds;
+    pxFusion->ulGPSUpdates++;
+
+    /* The course is only worth anything while moving, and is better the faster the ride. */
+    if ( HUDVIEW_FUSION_MINIMUM_COURSE_SPEED <= dSpeed )
+    {
+        dHeadingNoise = HUDVIEW_FUSION_GPS_SPEED_SIGMA / dSpeed;
+        dHeadingNoise *= dHeadingNoise;
+
+        if ( !pxFusion->bHasHeading )
+        {
+            pxFusion->dHeading = dWrapAngle( dHeading * M_PI / 180.0 );
+            pxFusion->dHeadingVariance = dHeadingNoise;
+            pxFusion->bHasHeading = 1;
+        }
+        else
+        {
+            dCourseGap = ( llMicroseconds - pxFusion->llCourseMicroseconds ) / 1e6;
+
+            /* How far the course turned since the last one, as it is and beyond what the lateral acceleration said,
+             * less what the noise of the two courses accounts for, samples the variance of each yaw rate. */
+            if ( ( HUDVIEW_FUSION_MINIMUM_TURN_SPEED < dSpeed ) && ( 0.0 < pxFusion->dTurnSeconds )
+                 && ( HUDVIEW_FUSION_MAXIMUM_COURSE_GAP_SECONDS >= dCourseGap ) )
+            {
+                dTurn = dAngleDifference( dHeading * M_PI / 180.0, pxFusion->dCourse );
+                dUnexplained = dAngleDifference( dTurn, pxFusion->dLateralTurn );
+                dNoise = pxFusion->dCourseVariance + dHeadingNoise;
+                pxFusion->dYawVariance += HUDVIEW_FUSION_UNEXPLAINED_YAW_WEIGHT
+                                          * ( ( dTurn * dTurn - dNoise ) / ( dCourseGap * dCourseGap )
+                                              - pxFusion->dYawVariance );
+                pxFusion->dUnexplainedYawVariance += HUDVIEW_FUSION_UNEXPLAINED_YAW_WEIGHT
+                                                     * ( ( dUnexplained * dUnexplained - dNoise )
+                                                         / ( dCourseGap * dCourseGap )
+                                                         - pxFusion->dUnexplainedYawVariance );
+            }
+
+            /* Without the lateral acceleration to steer by, the prior heading would only lag a turn behind the course,
+             * so the course is taken as it is. */
+            if ( bSteersByLateral( pxFusion ) )
+            {
+                dHeadingGain = pxFusion->dHeadingVariance / ( pxFusion->dHeadingVariance + dHeadingNoise );
+                dInnovation = dAngleDifference( dHeading * M_PI / 180.0, pxFusion->dHeading );
+                pxFusion->dHeading = dWrapAngle( pxFusion->dHeading + dHeadingGain * dInnovation );
+                pxFusion->dHeadingVariance *= 1.0 - dHeadingGain;
+            }
+            else
+            {
+                pxFusion->dHeading = dWrapAngle( dHeading * M_PI / 180.0 );
+                pxFusion->dHeadingVariance = dHeadingNoise;
+            }
+        }
+
+        pxFusion->dCourse = dWrapAngle( dHeading * M_PI / 180.0 );
+        pxFusion->dCourseVariance = dHeadingNoise;
+        pxFusion->llCourseMicroseconds = llMicroseconds;
+        pxFusion->dLateralTurn = 0.0;
+        pxFusion->dTurnSeconds = 0.0;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFusionEstimate( const xHUDViewFusion_t * pxFusion, int64_t llMicroseconds,
+                             xHUDViewFusionEstimate_t * pxEstimate )
+{
+    pxEstimate->dSpeed = pxFusion->dSpeed;
+    pxEstimate->dSpeedSigma = sqrt( fmax( 0.0, pxFusion->dSpeedVariance ) );
+    pxEstimate->dHeading = pxFusion->dHeading * 180.0 / M_PI;
+    pxEstimate->dHeadingSigma = sqrt( fmax( 0.0, pxFusion->dHeadingVariance ) ) * 180.0 / M_PI;
+    pxEstimate->dGPSAgeSeconds = pxFusion->bHasSpeed ? ( llMicroseconds - pxFusion->llGPSMicroseconds ) / 1e6 : 0.0;
+
+    /* Dead reckoning is only trusted for so long, however confident the filter still is. */
+    pxEstimate->bValid = pxFusion->bHasSpeed && ( HUDVIEW_FUSION_MAXIMUM_SPEED_SIGMA >= pxEstimate->dSpeedSigma )
+                         && ( HUDVIEW_FUSION_MAXIMUM_GPS_AGE_SECONDS >= pxEstimate->dGPSAgeSeconds );
+    pxEstimate->bHeadingValid = pxEstimate->bValid && pxFusion->bHasHeading
+                                && ( HUDVIEW_FUSION_MAXIMUM_HEADING_SIGMA >= pxEstimate->dHeadingSigma );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dWrapAngle( double dAngle )
+{
+    /* Into [ 0, 2 pi ) without a loop, so the cost does not depend on how far out the angle was. */
+    dAngle = fmod( dAngle, 2.0 * M_PI );
+
+    return ( 0.0 > dAngle ) ? dAngle + 2.0 * M_PI : dAngle;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dAngleDifference( double dAngle, double dReference )
+{
+    /* Within [ -pi, pi ), the short way round. */
+    return dWrapAngle( dAngle - dReference + M_PI ) - M_PI;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bSteersByLateral( const xHUDViewFusion_t * pxFusion )
+{
+    return pxFusion->dUnexplainedYawVariance
+           < ( 1.0 - HUDVIEW_FUSION_MINIMUM_EXPLAINED_YAW ) * pxFusion->dYawVariance;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
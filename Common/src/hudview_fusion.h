@@ -0,0 +1,134 @@
+/** @file hudview_fusion.h
+ *  @brief HUDView GPS and accelerometer fusion.
+ *
+ *  The GPS reports speed and course about once a second, and not at all in a tunnel; the accelerometer samples many
+ *  times a second but drifts. A small Kalman filter combines the two into speed and heading estimates that can be
+ *  read at any rate, each with a standard deviation that grows while the GPS is away:
+ *
+ *  - speed is a two-state filter of [speed, longitudinal accelerometer bias], propagated by the longitudinal
+ *    acceleration and corrected by every GPS speed, which also estimates the bias left by mounting tilt,
+ *  - heading is a one-state filter propagated by the yaw rate implied by the lateral acceleration (a / v) and
+ *    corrected by the GPS course whenever the GPS speed is high enough for the course to mean anything.
+ *
+ *  Every call runs in constant time on the fixed-size state below and never allocates. The accelerometer is taken to
+ *  be mounted with x pointing forward and y pointing right. On a leaning two-wheeler the lateral axis sees little of
+ *  a turn, so the filter learns from consecutive GPS courses how fast the heading turns, both as it is and beyond what
+ *  the lateral acceleration accounted for. The lateral acceleration only steers the heading while it explains the
+ *  courses better than holding the last one does. A turn the filter cannot see persists, so what is left of the yaw
+ *  rate grows the heading variance with the square of the time moved since the last course, and a dropout soon leaves
+ *  the heading invalid rather than held.
+ */
+
+#ifndef HUDVIEW_FUSION_H
+#define HUDVIEW_FUSION_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_FUSION_GRAVITY                    ( 9.80665 )
+#define HUDVIEW_FUSION_KNOTS_TO_METRES_PER_SECOND ( 0.514444 )
+
+/* Speed noise from the accelerometer (m^2/s^3) and the random walk of its bias (m^2/s^5). */
+#define HUDVIEW_FUSION_ACCELERATION_NOISE         ( 0.02 )
+#define HUDVIEW_FUSION_BIAS_NOISE                 ( 0.0001 )
+
+/* Heading random walk (rad^2/s), covering small wanders between fixes. */
+#define HUDVIEW_FUSION_HEADING_NOISE              ( 0.02 )
+
+/* Variance of the yaw rate (rad^2/s^2), assumed at first to be that of everyday riding with none of it explained by
+ * the lateral acceleration, and how much each pair of consecutive GPS courses at most this far apart (s) moves the
+ * learned variances towards what they show. The mounting does not change during a ride, so they are learned slowly. */
+#define HUDVIEW_FUSION_INITIAL_UNEXPLAINED_YAW    ( 0.02 )
+#define HUDVIEW_FUSION_UNEXPLAINED_YAW_WEIGHT     ( 0.02 )
+#define HUDVIEW_FUSION_MAXIMUM_COURSE_GAP_SECONDS ( 2.0 )
+
+/* The lateral acceleration only steers the heading once it explains at least this share of the yaw rate's variance. */
+#define HUDVIEW_FUSION_MINIMUM_EXPLAINED_YAW      ( 0.5 )
+
+/* Standard deviation of a GPS speed (m/s); the course error follows from it as speed sigma / speed. */
+#define HUDVIEW_FUSION_GPS_SPEED_SIGMA            ( 0.3 )
+
+/* Below these speeds (m/s) the GPS course is noise and the lateral acceleration says nothing about the yaw rate. */
+#define HUDVIEW_FUSION_MINIMUM_COURSE_SPEED       ( 1.0 )
+#define HUDVIEW_FUSION_MINIMUM_TURN_SPEED         ( 2.0 )
+
+/* An acceleration is held for at most this long (s) when samples stop; beyond it only the uncertainty grows. */
+#define HUDVIEW_FUSION_MAXIMUM_HOLD_SECONDS       ( 0.5 )
+
+/* GPS speeds further than this many standard deviations from the estimate are rejected, unless several in a row are. */
+#define HUDVIEW_FUSION_GATE_SIGMAS                ( 5.0 )
+#define HUDVIEW_FUSION_MAXIMUM_REJECTIONS         ( 3 )
+
+/* An estimate stops being valid when it is this uncertain (m/s, degrees) or the last fix is this old (s). */
+#define HUDVIEW_FUSION_MAXIMUM_SPEED_SIGMA        ( 1.5 )
+#define HUDVIEW_FUSION_MAXIMUM_HEADING_SIGMA      ( 30.0 )
+#define HUDVIEW_FUSION_MAXIMUM_GPS_AGE_SECONDS    ( 30.0 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    int bHasSpeed;
+    int bHasHeading;
+    int64_t llMicroseconds;
+    int64_t llGPSMicroseconds;
+
+    /* Speed (m/s), accelerometer bias (m/s^2) and their covariance. */
+    double dSpeed;
+    double dBias;
+    double dSpeedVariance;
+    double dCovariance;
+    double dBiasVariance;
+
+    /* Heading (rad, clockwise from north) and its variance. */
+    double dHeading;
+    double dHeadingVariance;
+
+    /* The last GPS course applied (rad) and its variance, the heading change the lateral acceleration accounted for
+     * since (rad), the time moved since (s), and the learned variances of the yaw rate as a whole and of what the
+     * lateral acceleration does not explain of it. */
+    double dCourse;
+    double dCourseVariance;
+    int64_t llCourseMicroseconds;
+    double dLateralTurn;
+    double dTurnSeconds;
+    double dYawVariance;
+    double dUnexplainedYawVariance;
+
+    /* Latest acceleration along and across the direction of travel (m/s^2). */
+    double dLongitudinal;
+    double dLateral;
+    int64_t llAccelerationMicroseconds;
+
+    int iRejections;
+    unsigned long ulGPSUpdates;
+    unsigned long ulGPSRejected;
+} xHUDViewFusion_t;
+
+typedef struct {
+    int bValid;
+    int bHeadingValid;
+    double dSpeed;
+    double dSpeedSigma;
+    double dHeading;
+    double dHeadingSigma;
+    double dGPSAgeSeconds;
+} xHUDViewFusionEstimate_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewFusionInit( xHUDViewFusion_t * pxFusion );
+void vHUDViewFusionPredict( xHUDViewFusion_t * pxFusion, int64_t llMicroseconds );
+void vHUDViewFusionAccelerometer( xHUDViewFusion_t * pxFusion, int64_t llMicroseconds, double dLongitudinal,
+                                  double dLateral );
+void vHUDViewFusionGPS( xHUDViewFusion_t * pxFusion, int64_t llMicroseconds, double dSpeed, double dHeading );
+void vHUDViewFusionEstimate( const xHUDViewFusion_t * pxFusion, int64_t llMicroseconds,
+                             xHUDViewFusionEstimate_t * pxEstimate );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_FUSION_H
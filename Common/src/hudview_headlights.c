@@ -0,0 +1,634 @@
+/** @file hudview_headlights.c
+ *  @brief HUDView rear camera headlight labelling, pairing and tracking.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define HUDVIEW_HEADLIGHTS_NEON
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#define HUDVIEW_HEADLIGHTS_SSE2
+#endif
+
+#include "hudview_headlights.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    double dX;
+    double dY;
+    double dSize;
+    int bPaired;
+    int iX;
+    int iY;
+    int iWidth;
+    int iHeight;
+    uint32_t ulArea;
+} xDetection_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bThreshold( const uint8_t * pucLuma, uint8_t * pucMask, int bScalar );
+static int iLabelFrame( xHUDViewHeadlights_t * pxHeadlights, const uint8_t * pucLuma );
+static uint16_t usFind( uint16_t * pusParents, uint16_t usLabel );
+static void vUnion( uint16_t * pusParents, uint16_t usA, uint16_t usB );
+static int iCollectBlobs( xHUDViewHeadlights_t * pxHeadlights, int iLabels, xDetection_t * pxBlobs );
+static int iPairBlobs( xDetection_t * pxBlobs, int iBlobs, xDetection_t * pxVehicles );
+static void vUpdateTracks( xHUDViewHeadlights_t * pxHeadlights, const xDetection_t * pxVehicles, int iVehicles,
+                           double dSeconds );
+static void vUpdateTimeToContact( xHUDViewHeadlightsTrack_t * pxTrack );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewHeadlightsInit( xHUDViewHeadlights_t * pxHeadlights )
+{
+    memset( pxHeadlights, 0, sizeof( *pxHeadlights ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewHeadlightsSetScalar( xHUDViewHeadlights_t * pxHeadlights, int bScalar )
+{
+    pxHeadlights->bScalar = bScalar;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewHeadlightsKernels( void )
+{
+#if defined( HUDVIEW_HEADLIGHTS_NEON )
+    return "NEON";
+#elif defined( HUDVIEW_HEADLIGHTS_SSE2 )
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewHeadlightsProcess( xHUDViewHeadlights_t * pxHeadlights, const uint8_t * pucLuma, int64_t llMicroseconds,
+                               xHUDViewHeadlightsResult_t * pxResult )
+{
+    xDetection_t axBlobs[ HUDVIEW_HEADLIGHTS_MAXIMUM_BLOBS ];
+    xDetection_t axVehicles[ HUDVIEW_HEADLIGHTS_MAXIMUM_BLOBS ];
+    int64_t llGap = llMicroseconds - pxHeadlights->llPreviousMicroseconds;
+    int iLabels = 0;
+    int iVehicles = 0;
+    int bClosing = 0;
+
+    memset( pxResult, 0, sizeof( *pxResult ) );
+    pxHeadlights->ulFrames++;
+
+    /* Sizes are only comparable across a continuous run of frames, so a stalled camera drops every track. */
+    if ( !pxHeadlights->bHasPrevious || ( 0 >= llGap ) || ( HUDVIEW_HEADLIGHTS_MAXIMUM_FRAME_GAP_US < llGap ) )
+    {
+        memset( pxHeadlights->axTracks, 0, sizeof( pxHeadlights->axTracks ) );
+    }
+
+    pxHeadlights->bHasPrevious = 1;
+    pxHeadlights->llPreviousMicroseconds = llMicroseconds;
+
+    iLabels = iLabelFrame( pxHeadlights, pucLuma );
+
+    /* Too many bright components to label means this is no night scene; leave the tracks and alert as they are. */
+    if ( 0 > iLabels )
+    {
+        pxHeadlights->ulOverflows++;
+        pxResult->bAlert = pxHeadlights->bAlert;
+        return 0;
+    }
+
+    pxResult->iBlobs = iCollectBlobs( pxHeadlights, iLabels, axBlobs );
+    iVehicles = iPairBlobs( axBlobs, pxResult->iBlobs, axVehicles );
+    vUpdateTracks( pxHeadlights, axVehicles, iVehicles, llMicroseconds / 1e6 );
+
+    for ( int iTrack = 0; iTrack < HUDVIEW_HEADLIGHTS_MAXIMUM_TRACKS; iTrack++ )
+    {
+        const xHUDViewHeadlightsTrack_t * pxTrack = &pxHeadlights->axTracks[ iTrack ];
+        xHUDViewHeadlightsMarker_t * pxMarker = &pxResult->axMarkers[ pxResult->iMarkers ];
+
+        if ( !pxTrack->bActive || ( 0 != pxTrack->iMissed ) )
+        {
+            continue;
+        }
+
+        pxMarker->iX = pxTrack->iX;
+        pxMarker->iY = pxTrack->iY;
+        pxMarker->iWidth = pxTrack->iWidth;
+        pxMarker->iHeight = pxTrack->iHeight;
+        pxMarker->bClosing = pxTrack->bClosing;
+        pxMarker->dTimeToContact = pxTrack->dTimeToContact;
+        pxResult->iMarkers++;
+
+        if ( pxTrack->bClosing )
+        {
+            bClosing = 1;
+
+            if ( ( 0.0 == pxResult->dTimeToContact ) || ( pxTrack->dTimeToContact < pxResult->dTimeToContact ) )
+            {
+                pxResult->dTimeToContact = pxTrack->dTimeToContact;
+            }
+        }
+    }
+
+    pxResult->bClosing = bClosing;
+
+    /* Raise the alert on the first frame that shows an approach; drop it once none has been seen for a while. */
+    if ( bClosing )
+    {
+        pxHeadlights->iFramesSinceClosing = 0;
+
+        if ( !pxHeadlights->bAlert )
+        {
+            pxHeadlights->bAlert = 1;
+            pxHeadlights->ulAlerts++;
+            pxResult->bAlertChanged = 1;
+        }
+    }
+    else if ( pxHeadlights->bAlert
+              && ( HUDVIEW_HEADLIGHTS_ALERT_HOLD_FRAMES <= ++pxHeadlights->iFramesSinceClosing ) )
+    {
+        pxHeadlights->bAlert = 0;
+        pxResult->bAlertChanged = 1;
+    }
+
+    pxResult->bAlert = pxHeadlights->bAlert;
+
+    return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bThreshold( const uint8_t * pucLuma, uint8_t * pucMask, int bScalar )
+{
+    int bAny = 0;
+    int iX = 0;
+
+    /* Mask bytes are 0xFF for a lit pixel and 0 otherwise; the return value says whether the row has any at all, so
+     * the labeller can skip the dark rows that make up most of a night frame. */
+#if defined( HUDVIEW_HEADLIGHTS_NEON )
+    if ( !bScalar )
+    {
+        uint8x16_t xThreshold = vdupq_n_u8( HUDVIEW_HEADLIGHTS_THRESHOLD );
+        uint8x16_t xAny = vdupq_n_u8( 0 );
+
+        for ( ; iX + 16 <= HUDVIEW_HEADLIGHTS_WIDTH; iX += 16 )
+        {
+            uint8x16_t xMask = vcgeq_u8( vld1q_u8( &pucLuma[ iX ] ), xThreshold );
+
+            vst1q_u8( &pucMask[ iX ], xMask );
+            xAny = vorrq_u8( xAny, xMask );
+        }
+
+        bAny = ( 0 != ( vgetq_lane_u64( vreinterpretq_u64_u8( xAny ), 0 )
+                        | vgetq_lane_u64( vreinterpretq_u64_u8( xAny ), 1 ) ) );
+    }
+#elif defined( HUDVIEW_HEADLIGHTS_SSE2 )
+    if ( !bScalar )
+    {
+        __m128i xThreshold = _mm_set1_epi8( ( char )HUDVIEW_HEADLIGHTS_THRESHOLD );
+        __m128i xAny = _mm_setzero_si128();
+
+        /* There is no unsigned byte compare; x >= t exactly when max( x, t ) == x. */
+        for ( ; iX + 16 <= HUDVIEW_HEADLIGHTS_WIDTH; iX += 16 )
+        {
+            __m128i xLuma = _mm_loadu_si128( ( const __m128i * )&pucLuma[ iX ] );
+            __m128i xMask = _mm_cmpeq_epi8( _mm_max_epu8( xLuma, xThreshold ), xLuma );
+
+            _mm_storeu_si128( ( __m128i * )&pucMask[ iX ], xMask );
+            xAny = _mm_or_si128( xAny, xMask );
+        }
+
+        bAny = ( 0 != _mm_movemask_epi8( xAny ) );
+    }
+#else
+    ( void )bScalar;
+#endif
+
+    for ( ; iX < HUDVIEW_HEADLIGHTS_WIDTH; iX++ )
+    {
+        pucMask[ iX ] = ( HUDVIEW_HEADLIGHTS_THRESHOLD <= pucLuma[ iX ] ) ? 0xFF : 0x00;
+        bAny |= pucMask[ iX ];
+    }
+
+    return ( 0 != bAny );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iLabelFrame( xHUDViewHeadlights_t * pxHeadlights, const uint8_t * pucLuma )
+{
+    uint16_t * pusParents = pxHeadlights->ausParents;
+    uint16_t * pusPrevious = pxHeadlights->aausRowLabels[ 0 ];
+    uint16_t * pusCurrent = pxHeadlights->aausRowLabels[ 1 ];
+    uint8_t * pucMask = pxHeadlights->aucMask;
+    uint16_t usLabels = 0;
+
+    memset( pusPrevious, 0, sizeof( pxHeadlights->aausRowLabels[ 0 ] ) );
+    memset( pusCurrent, 0, sizeof( pxHeadlights->aausRowLabels[ 1 ] ) );
+
+    for ( int iY = 0; iY < HUDVIEW_HEADLIGHTS_HEIGHT; iY++ )
+    {
+        uint16_t * pusSwap = NULL;
+
+        if ( !bThreshold( &pucLuma[ iY * HUDVIEW_HEADLIGHTS_WIDTH ], pucMask, pxHeadlights->bScalar ) )
+        {
+            memset( pusCurrent, 0, sizeof( pxHeadlights->aausRowLabels[ 1 ] ) );
+        }
+        else
+        {
+            /* Label index x + 1 is pixel x, so the neighbours of the edge pixels are the background columns. */
+            for ( int iX = 0; iX < HUDVIEW_HEADLIGHTS_WIDTH; iX++ )
+            {
+                uint16_t usNorth = pusPrevious[ iX + 1 ];
+                uint16_t usNorthEast = pusPrevious[ iX + 2 ];
+                uint16_t usNorthWest = pusPrevious[ iX ];
+                uint16_t usWest = pusCurrent[ iX ];
+                uint16_t usLabel = 0;
+                xHUDViewHeadlightsComponent_t * pxComponent = NULL;
+
+                if ( !pucMask[ iX ] )
+                {
+                    pusCurrent[ iX + 1 ] = 0;
+                    continue;
+                }
+
+                /* With 8-connectivity the north pixel touches every other labelled neighbour, which were therefore
+                 * merged with it already; only the north-east one can join two components that are still apart. */
+                if ( 0 != usNorth )
+                {
+                    usLabel = usNorth;
+                }
+                else if ( 0 != usNorthEast )
+                {
+                    usLabel = usNorthEast;
+
+                    if ( 0 != usWest )
+                    {
+                        vUnion( pusParents, usNorthEast, usWest );
+                    }
+                    else if ( 0 != usNorthWest )
+                    {
+                        vUnion( pusParents, usNorthEast, usNorthWest );
+                    }
+                }
+                else if ( 0 != usWest )
+                {
+                    usLabel = usWest;
+                }
+                else if ( 0 != usNorthWest )
+                {
+                    usLabel = usNorthWest;
+                }
+                else
+                {
+                    if ( HUDVIEW_HEADLIGHTS_MAXIMUM_LABELS <= usLabels + 1 )
+                    {
+                        return -1;
+                    }
+
+                    usLabel = ++usLabels;
+                    pusParents[ usLabel ] = usLabel;
+                    pxComponent = &pxHeadlights->axComponents[ usLabel ];
+                    memset( pxComponent, 0, sizeof( *pxComponent ) );
+                    pxComponent->ucMinX = ( uint8_t )iX;
+                    pxComponent->ucMaxX = ( uint8_t )iX;
+                    pxComponent->ucMinY = ( uint8_t )iY;
+                }
+
+                /* Statistics accumulate on the provisional label and are merged into the root once the frame is done,
+                 * so no pixel is ever visited twice. */
+                pusCurrent[ iX + 1 ] = usLabel;
+                pxComponent = &pxHeadlights->axComponents[ usLabel ];
+                pxComponent->ulArea++;
+                pxComponent->ulSumX += ( uint32_t )iX;
+                pxComponent->ulSumY += ( uint32_t )iY;
+                pxComponent->ucMinX = ( iX < pxComponent->ucMinX ) ? ( uint8_t )iX : pxComponent->ucMinX;
+                pxComponent->ucMaxX = ( iX > pxComponent->ucMaxX ) ? ( uint8_t )iX : pxComponent->ucMaxX;
+                pxComponent->ucMaxY = ( uint8_t )iY;
+            }
+        }
+
+        pusSwap = pusPrevious;
+        pusPrevious = pusCurrent;
+        pusCurrent = pusSwap;
+    }
+
+    return usLabels;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint16_t usFind( uint16_t * pusParents, uint16_t usLabel )
+{
+    /* Path halving keeps the trees flat without a second pass. */
+    while ( pusParents[ usLabel ] != usLabel )
+    {
+        pusParents[ usLabel ] = pusParents[ pusParents[ usLabel ] ];
+        usLabel = pusParents[ usLabel ];
+    }
+
+    return usLabel;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUnion( uint16_t * pusParents, uint16_t usA, uint16_t usB )
+{
+    uint16_t usRootA = usFind( pusParents, usA );
+    uint16_t usRootB = usFind( pusParents, usB );
+
+    /* The lower label always becomes the root, so every label's root is found before it in label order. */
+    if ( usRootA < usRootB )
+    {
+        pusParents[ usRootB ] = usRootA;
+    }
+    else if ( usRootB < usRootA )
+    {
+        pusParents[ usRootA ] = usRootB;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iCollectBlobs( xHUDViewHeadlights_t * pxHeadlights, int iLabels, xDetection_t * pxBlobs )
+{
+    xHUDViewHeadlightsComponent_t * pxComponents = pxHeadlights->axComponents;
+    int iBlobs = 0;
+
+    /* Fold every provisional label into its root. */
+    for ( int iLabel = 1; iLabel <= iLabels; iLabel++ )
+    {
+        uint16_t usRoot = usFind( pxHeadlights->ausParents, ( uint16_t )iLabel );
+        xHUDViewHeadlightsComponent_t * pxRoot = &pxComponents[ usRoot ];
+        const xHUDViewHeadlightsComponent_t * pxComponent = &pxComponents[ iLabel ];
+
+        if ( usRoot == iLabel )
+        {
+            continue;
+        }
+
+        pxRoot->ulArea += pxComponent->ulArea;
+        pxRoot->ulSumX += pxComponent->ulSumX;
+        pxRoot->ulSumY += pxComponent->ulSumY;
+        pxRoot->ucMinX = ( pxComponent->ucMinX < pxRoot->ucMinX ) ? pxComponent->ucMinX : pxRoot->ucMinX;
+        pxRoot->ucMaxX = ( pxComponent->ucMaxX > pxRoot->ucMaxX ) ? pxComponent->ucMaxX : pxRoot->ucMaxX;
+        pxRoot->ucMinY = ( pxComponent->ucMinY < pxRoot->ucMinY ) ? pxComponent->ucMinY : pxRoot->ucMinY;
+        pxRoot->ucMaxY = ( pxComponent->ucMaxY > pxRoot->ucMaxY ) ? pxComponent->ucMaxY : pxRoot->ucMaxY;
+    }
+
+    /* Keep the largest blobs in range, largest first, which is also the order they are paired in. */
+    for ( int iLabel = 1; iLabel <= iLabels; iLabel++ )
+    {
+        const xHUDViewHeadlightsComponent_t * pxComponent = &pxComponents[ iLabel ];
+        xDetection_t xBlob;
+        int iSlot = 0;
+
+        if ( ( iLabel != pxHeadlights->ausParents[ iLabel ] )
+             || ( HUDVIEW_HEADLIGHTS_MINIMUM_AREA > pxComponent->ulArea )
+             || ( HUDVIEW_HEADLIGHTS_MAXIMUM_AREA < pxComponent->ulArea ) )
+        {
+            continue;
+        }
+
+        xBlob.ulArea = pxComponent->ulArea;
+        xBlob.dX = pxComponent->ulSumX / ( double )pxComponent->ulArea;
+        xBlob.dY = pxComponent->ulSumY / ( double )pxComponent->ulArea;
+        xBlob.dSize = sqrt( ( double )pxComponent->ulArea );
+        xBlob.bPaired = 0;
+        xBlob.iX = pxComponent->ucMinX;
+        xBlob.iY = pxComponent->ucMinY;
+        xBlob.iWidth = pxComponent->ucMaxX - pxComponent->ucMinX + 1;
+        xBlob.iHeight = pxComponent->ucMaxY - pxComponent->ucMinY + 1;
+
+        if ( HUDVIEW_HEADLIGHTS_MAXIMUM_BLOBS > iBlobs )
+        {
+            iBlobs++;
+        }
+        else if ( pxBlobs[ iBlobs - 1 ].ulArea >= xBlob.ulArea )
+        {
+            continue;
+        }
+
+        for ( iSlot = iBlobs - 1; ( 0 < iSlot ) && ( pxBlobs[ iSlot - 1 ].ulArea < xBlob.ulArea ); iSlot-- )
+        {
+            pxBlobs[ iSlot ] = pxBlobs[ iSlot - 1 ];
+        }
+
+        pxBlobs[ iSlot ] = xBlob;
+    }
+
+    return iBlobs;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iPairBlobs( xDetection_t * pxBlobs, int iBlobs, xDetection_t * pxVehicles )
+{
+    uint8_t aucUsed[ HUDVIEW_HEADLIGHTS_MAXIMUM_BLOBS ] = { 0 };
+    int iVehicles = 0;
+
+    for ( int iBlob = 0; iBlob < iBlobs; iBlob++ )
+    {
+        const xDetection_t * pxBlob = &pxBlobs[ iBlob ];
+        xDetection_t * pxVehicle = NULL;
+        double dBestGap = HUDVIEW_HEADLIGHTS_PAIR_MAXIMUM_GAP;
+        int iPartner = -1;
+
+        if ( aucUsed[ iBlob ] )
+        {
+            continue;
+        }
+
+        aucUsed[ iBlob ] = 1;
+        pxVehicle = &pxVehicles[ iVehicles++ ];
+
+        /* The partner is the nearest smaller blob at the same height whose area is comparable. */
+        for ( int iOther = iBlob + 1; iOther < iBlobs; iOther++ )
+        {
+            const xDetection_t * pxOther = &pxBlobs[ iOther ];
+            double dGap = fabs( pxOther->dX - pxBlob->dX );
+            double dRise = fabs( pxOther->dY - pxBlob->dY );
+
+            if ( aucUsed[ iOther ] || ( pxBlob->ulArea > HUDVIEW_HEADLIGHTS_PAIR_AREA_RATIO * pxOther->ulArea )
+                 || ( dRise > 0.5 * ( pxBlob->iHeight + pxOther->iHeight ) ) || ( dGap >= dBestGap ) )
+            {
+                continue;
+            }
+
+            dBestGap = dGap;
+            iPartner = iOther;
+        }
+
+        *pxVehicle = *pxBlob;
+
+        if ( 0 <= iPartner )
+        {
+            const xDetection_t * pxPartner = &pxBlobs[ iPartner ];
+            int iRight = pxBlob->iX + pxBlob->iWidth;
+            int iBottom = pxBlob->iY + pxBlob->iHeight;
+
+            /* The separation of a pair scales with distance just like its size does, and is measured to a fraction
+             * of a pixel from the centroids, which makes it the better size while both lights are small. */
+            aucUsed[ iPartner ] = 1;
+            pxVehicle->bPaired = 1;
+            pxVehicle->dX = 0.5 * ( pxBlob->dX + pxPartner->dX );
+            pxVehicle->dY = 0.5 * ( pxBlob->dY + pxPartner->dY );
+            pxVehicle->dSize = hypot( pxBlob->dX - pxPartner->dX, pxBlob->dY - pxPartner->dY );
+            pxVehicle->iX = ( pxPartner->iX < pxBlob->iX ) ? pxPartner->iX : pxBlob->iX;
+            pxVehicle->iY = ( pxPartner->iY < pxBlob->iY ) ? pxPartner->iY : pxBlob->iY;
+            iRight = ( pxPartner->iX + pxPartner->iWidth > iRight ) ? pxPartner->iX + pxPartner->iWidth : iRight;
+            iBottom = ( pxPartner->iY + pxPartner->iHeight > iBottom ) ? pxPartner->iY + pxPartner->iHeight : iBottom;
+            pxVehicle->iWidth = iRight - pxVehicle->iX;
+            pxVehicle->iHeight = iBottom - pxVehicle->iY;
+            pxVehicle->ulArea += pxPartner->ulArea;
+        }
+    }
+
+    return iVehicles;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUpdateTracks( xHUDViewHeadlights_t * pxHeadlights, const xDetection_t * pxVehicles, int iVehicles,
+                           double dSeconds )
+{
+    uint8_t aucAssigned[ HUDVIEW_HEADLIGHTS_MAXIMUM_BLOBS ] = { 0 };
+
+    /* Each track takes the nearest vehicle within its gate, and tracks that find none age out. */
+    for ( int iTrack = 0; iTrack < HUDVIEW_HEADLIGHTS_MAXIMUM_TRACKS; iTrack++ )
+    {
+        xHUDViewHeadlightsTrack_t * pxTrack = &pxHeadlights->axTracks[ iTrack ];
+        double dBestDistance = HUDVIEW_HEADLIGHTS_TRACK_GATE + pxTrack->iWidth;
+        int iBest = -1;
+
+        if ( !pxTrack->bActive )
+        {
+            continue;
+        }
+
+        for ( int iVehicle = 0; iVehicle < iVehicles; iVehicle++ )
+        {
+            double dDistance = hypot( pxVehicles[ iVehicle ].dX - pxTrack->dX,
+                                      pxVehicles[ iVehicle ].dY - pxTrack->dY );
+
+            if ( !aucAssigned[ iVehicle ] && ( dDistance < dBestDistance ) )
+            {
+                dBestDistance = dDistance;
+                iBest = iVehicle;
+            }
+        }
+
+        if ( 0 > iBest )
+        {
+            if ( HUDVIEW_HEADLIGHTS_MAXIMUM_MISSED < ++pxTrack->iMissed )
+            {
+                memset( pxTrack, 0, sizeof( *pxTrack ) );
+            }
+
+            continue;
+        }
+
+        aucAssigned[ iBest ] = 1;
+
+        /* A pair that splits or a light that gains a partner changes what size means; start its history over. So does a
+         * single light too small to measure. */
+        if ( ( pxTrack->bPaired != pxVehicles[ iBest ].bPaired )
+             || ( !pxVehicles[ iBest ].bPaired
+                  && ( HUDVIEW_HEADLIGHTS_MINIMUM_SINGLE_AREA > pxVehicles[ iBest ].ulArea ) ) )
+        {
+            pxTrack->iHistory = 0;
+        }
+
+        pxTrack->bPaired = pxVehicles[ iBest ].bPaired;
+        pxTrack->dX = pxVehicles[ iBest ].dX;
+        pxTrack->dY = pxVehicles[ iBest ].dY;
+        pxTrack->iX = pxVehicles[ iBest ].iX;
+        pxTrack->iY = pxVehicles[ iBest ].iY;
+        pxTrack->iWidth = pxVehicles[ iBest ].iWidth;
+        pxTrack->iHeight = pxVehicles[ iBest ].iHeight;
+        pxTrack->iMissed = 0;
+        pxTrack->iAge++;
+
+        if ( HUDVIEW_HEADLIGHTS_HISTORY == pxTrack->iHistory )
+        {
+            memmove( &pxTrack->adSeconds[ 0 ], &pxTrack->adSeconds[ 1 ],
+                     ( HUDVIEW_HEADLIGHTS_HISTORY - 1 ) * sizeof( double ) );
+            memmove( &pxTrack->adLogSizes[ 0 ], &pxTrack->adLogSizes[ 1 ],
+                     ( HUDVIEW_HEADLIGHTS_HISTORY - 1 ) * sizeof( double ) );
+            pxTrack->iHistory--;
+        }
+
+        pxTrack->adSeconds[ pxTrack->iHistory ] = dSeconds;
+        pxTrack->adLogSizes[ pxTrack->iHistory ] = log( pxVehicles[ iBest ].dSize );
+        pxTrack->iHistory++;
+        vUpdateTimeToContact( pxTrack );
+    }
+
+    /* Vehicles no track claimed start new tracks while there is room. */
+    for ( int iVehicle = 0; iVehicle < iVehicles; iVehicle++ )
+    {
+        for ( int iTrack = 0; ( iTrack < HUDVIEW_HEADLIGHTS_MAXIMUM_TRACKS ) && !aucAssigned[ iVehicle ]; iTrack++ )
+        {
+            xHUDViewHeadlightsTrack_t * pxTrack = &pxHeadlights->axTracks[ iTrack ];
+
+            if ( pxTrack->bActive )
+            {
+                continue;
+            }
+
+            memset( pxTrack, 0, sizeof( *pxTrack ) );
+            pxTrack->bActive = 1;
+            pxTrack->bPaired = pxVehicles[ iVehicle ].bPaired;
+            pxTrack->iAge = 1;
+            pxTrack->dX = pxVehicles[ iVehicle ].dX;
+            pxTrack->dY = pxVehicles[ iVehicle ].dY;
+            pxTrack->iX = pxVehicles[ iVehicle ].iX;
+            pxTrack->iY = pxVehicles[ iVehicle ].iY;
+            pxTrack->iWidth = pxVehicles[ iVehicle ].iWidth;
+            pxTrack->iHeight = pxVehicles[ iVehicle ].iHeight;
+            pxTrack->adSeconds[ 0 ] = dSeconds;
+            pxTrack->adLogSizes[ 0 ] = log( pxVehicles[ iVehicle ].dSize );
+            pxTrack->iHistory = 1;
+            aucAssigned[ iVehicle ] = 1;
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUpdateTimeToContact( xHUDViewHeadlightsTrack_t * pxTrack )
+{
+    double dMeanSeconds = 0.0;
+    double dMeanLogSize = 0.0;
+    double dCovariance = 0.0;
+    double dVariance = 0.0;
+    double dSlope = 0.0;
+
+    pxTrack->dTimeToContact = 0.0;
+    pxTrack->bClosing = 0;
+
+    if ( HUDVIEW_HEADLIGHTS_HISTORY > pxTrack->iHistory )
+    {
+        return;
+    }
+
+    /* Size is proportional to 1 / distance, so d( ln size ) / dt = closing speed / distance = 1 / time to contact. */
+    for ( int iSample = 0; iSample < pxTrack->iHistory; iSample++ )
+    {
+        dMeanSeconds += pxTrack->adSeconds[ iSample ] / pxTrack->iHistory;
+        dMeanLogSize += pxTrack->adLogSizes[ iSample ] / pxTrack->iHistory;
+    }
+
+    for ( int iSample = 0; iSample < pxTrack->iHistory; iSample++ )
+    {
+        double dSeconds = pxTrack->adSeconds[ iSample ] - dMeanSeconds;
+
+        dCovariance += dSeconds * ( pxTrack->adLogSizes[ iSample ] - dMeanLogSize );
+        dVariance += dSeconds * dSeconds;
+    }
+
+    dSlope = ( 0.0 < dVariance ) ? dCovariance / dVariance : 0.0;
+
+    /* The fit gives the time to contact at the middle of the history; at a steady closing speed it has run down by
+     * the time since then, and the newest frame is the one that matters. */
+    if ( 0.0 < dSlope )
+    {
+        pxTrack->dTimeToContact = 1.0 / dSlope - ( pxTrack->adSeconds[ pxTrack->iHistory - 1 ] - dMeanSeconds );
+        pxTrack->dTimeToContact = ( 0.0 < pxTrack->dTimeToContact ) ? pxTrack->dTimeToContact : 0.0;
+        pxTrack->bClosing = ( 0.0 < pxTrack->dTimeToContact )
+                            && ( HUDVIEW_HEADLIGHTS_ALERT_SECONDS >= pxTrack->dTimeToContact );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
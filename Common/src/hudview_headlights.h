@@ -0,0 +1,150 @@
+/** @file hudview_headlights.h
+ *  @brief HUDView rear camera headlight tracking for night riding.
+ *
+ *  At night the rear camera sees little but lights, and the block matching of hudview_flow has no texture to work
+ *  with. Instead, each luma row is thresholded (NEON or SSE2 when the compiler targets them) and labelled as it
+ *  streams past, in a single pass of union-find connected components that keeps only two rows of labels and
+ *  accumulates each component's area, centroid and bounds as it goes. Bright blobs at the same height and of similar
+ *  size are paired into a vehicle, and vehicles are tracked from frame to frame by nearest neighbour. The apparent
+ *  size of a vehicle is inversely proportional to its distance, so the slope of its log size over the last few
+ *  frames is the inverse of its time to contact; a track expanding fast enough raises the same alert as the flow.
+ *
+ *  All state is fixed-size and nothing is allocated.
+ */
+
+#ifndef HUDVIEW_HEADLIGHTS_H
+#define HUDVIEW_HEADLIGHTS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_HEADLIGHTS_WIDTH                ( 160 )
+#define HUDVIEW_HEADLIGHTS_HEIGHT               ( 120 )
+
+/* Lights saturate the sensor at night exposures; anything dimmer is road, sky or reflections. */
+#define HUDVIEW_HEADLIGHTS_THRESHOLD            ( 200 )
+
+/* With 8-connectivity no more than one component can start in every other pixel of every other row. */
+#define HUDVIEW_HEADLIGHTS_MAXIMUM_LABELS       ( HUDVIEW_HEADLIGHTS_WIDTH * HUDVIEW_HEADLIGHTS_HEIGHT / 4 + 1 )
+
+/* Blobs outside this area range are sensor noise, or a light so close or a scene so bright that it is not night. */
+#define HUDVIEW_HEADLIGHTS_MINIMUM_AREA         ( 3 )
+#define HUDVIEW_HEADLIGHTS_MAXIMUM_AREA         ( 2000 )
+#define HUDVIEW_HEADLIGHTS_MAXIMUM_BLOBS        ( 32 )
+
+/* Two blobs are a pair of headlights when their areas are within this ratio and they sit side by side. */
+#define HUDVIEW_HEADLIGHTS_PAIR_AREA_RATIO      ( 4.0 )
+#define HUDVIEW_HEADLIGHTS_PAIR_MAXIMUM_GAP     ( 80 )
+
+/* Tracks follow a vehicle within this many pixels plus its width, and are dropped after a few frames unseen. */
+#define HUDVIEW_HEADLIGHTS_MAXIMUM_TRACKS       ( 8 )
+#define HUDVIEW_HEADLIGHTS_TRACK_GATE           ( 8.0 )
+#define HUDVIEW_HEADLIGHTS_MAXIMUM_MISSED       ( 3 )
+
+/* Time to contact is fitted over this many frames of size history, and only once a track has all of them. The area
+ * of a small single light jumps with every subpixel shift, so those are only judged once they are large enough. */
+#define HUDVIEW_HEADLIGHTS_HISTORY              ( 10 )
+#define HUDVIEW_HEADLIGHTS_MINIMUM_SINGLE_AREA  ( 12 )
+
+/* Alerting matches the optical flow path, so the HUD behaves the same whichever one is running. */
+#define HUDVIEW_HEADLIGHTS_ALERT_SECONDS        ( 3.0 )
+#define HUDVIEW_HEADLIGHTS_ALERT_HOLD_FRAMES    ( 10 )
+#define HUDVIEW_HEADLIGHTS_MAXIMUM_FRAME_GAP_US ( 500000LL )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    uint32_t ulArea;
+    uint32_t ulSumX;
+    uint32_t ulSumY;
+    uint8_t ucMinX;
+    uint8_t ucMaxX;
+    uint8_t ucMinY;
+    uint8_t ucMaxY;
+} xHUDViewHeadlightsComponent_t;
+
+typedef struct {
+    int bActive;
+    int bPaired;
+    int iAge;
+    int iMissed;
+
+    /* Centre and bounds of the vehicle's lights, in pixels. */
+    double dX;
+    double dY;
+    int iX;
+    int iY;
+    int iWidth;
+    int iHeight;
+
+    /* Log of the apparent size (light separation for a pair, square root of area for a single light) over time. */
+    double adSeconds[ HUDVIEW_HEADLIGHTS_HISTORY ];
+    double adLogSizes[ HUDVIEW_HEADLIGHTS_HISTORY ];
+    int iHistory;
+
+    double dTimeToContact;
+    int bClosing;
+} xHUDViewHeadlightsTrack_t;
+
+typedef struct {
+    int bScalar;
+
+    /* Union-find forest and per-label statistics; labels start at 1, 0 is background. */
+    uint16_t ausParents[ HUDVIEW_HEADLIGHTS_MAXIMUM_LABELS ];
+    xHUDViewHeadlightsComponent_t axComponents[ HUDVIEW_HEADLIGHTS_MAXIMUM_LABELS ];
+
+    /* Labels of the previous and current row, with a background column on either side. */
+    uint16_t aausRowLabels[ 2 ][ HUDVIEW_HEADLIGHTS_WIDTH + 2 ];
+    uint8_t aucMask[ HUDVIEW_HEADLIGHTS_WIDTH ];
+
+    xHUDViewHeadlightsTrack_t axTracks[ HUDVIEW_HEADLIGHTS_MAXIMUM_TRACKS ];
+    int bHasPrevious;
+    int64_t llPreviousMicroseconds;
+
+    int bAlert;
+    int iFramesSinceClosing;
+    unsigned long ulFrames;
+    unsigned long ulAlerts;
+    unsigned long ulOverflows;
+} xHUDViewHeadlights_t;
+
+typedef struct {
+    int iX;
+    int iY;
+    int iWidth;
+    int iHeight;
+    int bClosing;
+    double dTimeToContact;
+} xHUDViewHeadlightsMarker_t;
+
+typedef struct {
+    int iBlobs;
+
+    /* Every vehicle seen in this frame, for drawing on the camera feed. */
+    xHUDViewHeadlightsMarker_t axMarkers[ HUDVIEW_HEADLIGHTS_MAXIMUM_TRACKS ];
+    int iMarkers;
+
+    /* The nearest time to contact of any closing vehicle; zero when none is closing. */
+    double dTimeToContact;
+    int bClosing;
+    int bAlert;
+    int bAlertChanged;
+} xHUDViewHeadlightsResult_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewHeadlightsInit( xHUDViewHeadlights_t * pxHeadlights );
+void vHUDViewHeadlightsSetScalar( xHUDViewHeadlights_t * pxHeadlights, int bScalar );
+const char * pcHUDViewHeadlightsKernels( void );
+
+int iHUDViewHeadlightsProcess( xHUDViewHeadlights_t * pxHeadlights, const uint8_t * pucLuma, int64_t llMicroseconds,
+                               xHUDViewHeadlightsResult_t * pxResult );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_HEADLIGHTS_H
@@ -0,0 +1,262 @@
+/** @file hudview_jpeg.c
+ *  @brief HUDView camera MJPEG framing and reduced-scale decoding.
+ */
+
+#include <string.h>
+
+#include "hudview_flow.h"
+#include "hudview_jpeg.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Enough rows for one call to jpeg_read_scanlines() whatever the sampling factors. */
+#define MAXIMUM_ROWS_PER_READ ( 16 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vErrorExit( j_common_ptr pxCommon );
+static void vOutputMessage( j_common_ptr pxCommon );
+static void vLumaFromRGB565( const uint16_t * pusRow, uint8_t * pucLuma, int iWidth );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+size_t ulHUDViewJpegFindMarker( const uint8_t * pucData, size_t ulBytes, size_t ulFrom, uint8_t ucMarker )
+{
+    const uint8_t * pucFound = NULL;
+
+    while ( ulFrom + 1 < ulBytes )
+    {
+        pucFound = memchr( pucData + ulFrom, 0xFF, ulBytes - ulFrom - 1 );
+
+        if ( NULL == pucFound )
+        {
+            break;
+        }
+
+        ulFrom = ( size_t )( pucFound - pucData );
+
+        if ( ucMarker == pucData[ ulFrom + 1 ] )
+        {
+            return ulFrom;
+        }
+
+        ulFrom++;
+    }
+
+    return ulBytes;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewJpegPlan( const xHUDViewTransformConfig_t * pxCapture, xHUDViewTransformConfig_t * pxDecoded,
+                      int * piDenominator )
+{
+    xHUDViewTransform_t xTransform;
+    const xHUDViewTransformConfig_t * pxResolved = &xTransform.xConfig;
+    int iNeedWidth = 0;
+    int iNeedHeight = 0;
+    int iDenominator = HUDVIEW_JPEG_MAXIMUM_DENOMINATOR;
+
+    /* The capture's transform fills in the region of interest, and says which way round it meets the output. */
+    if ( 0 != iHUDViewTransformInit( &xTransform, pxCapture ) )
+    {
+        return -1;
+    }
+
+    iNeedWidth = xTransform.bTranspose ? pxResolved->iDestinationHeight : pxResolved->iDestinationWidth;
+    iNeedHeight = xTransform.bTranspose ? pxResolved->iDestinationWidth : pxResolved->iDestinationHeight;
+
+    /* The smallest picture the DCT can produce that still has a pixel for every output pixel. */
+    while ( ( 1 < iDenominator ) && ( ( pxResolved->iCropWidth / iDenominator < iNeedWidth )
+                                      || ( pxResolved->iCropHeight / iDenominator < iNeedHeight ) ) )
+    {
+        iDenominator /= 2;
+    }
+
+    *pxDecoded = *pxResolved;
+    pxDecoded->bMJPEG = 0;
+
+    /* libjpeg rounds scaled dimensions up; the decoded frame is laid out as the camera would send one that size. */
+    pxDecoded->iSourceWidth = ( pxResolved->iSourceWidth + iDenominator - 1 ) / iDenominator;
+    pxDecoded->iSourceHeight = ( pxResolved->iSourceHeight + iDenominator - 1 ) / iDenominator;
+    pxDecoded->iSourceStride = 0;
+    pxDecoded->iCropX = pxResolved->iCropX / iDenominator;
+    pxDecoded->iCropY = pxResolved->iCropY / iDenominator;
+    pxDecoded->iCropWidth = pxResolved->iCropWidth / iDenominator;
+    pxDecoded->iCropHeight = pxResolved->iCropHeight / iDenominator;
+
+    if ( 0 != iHUDViewTransformInit( &xTransform, pxDecoded ) )
+    {
+        return -1;
+    }
+
+    *piDenominator = iDenominator;
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewJpegInit( xHUDViewJpeg_t * pxJpeg, int bFast )
+{
+    memset( pxJpeg, 0, sizeof( xHUDViewJpeg_t ) );
+    pxJpeg->bFast = bFast;
+
+    /* A corrupt frame ends in vErrorExit(), which jumps back to the decode that hit it rather than exiting. */
+    pxJpeg->xDecompress.err = jpeg_std_error( &pxJpeg->xError.xManager );
+    pxJpeg->xError.xManager.error_exit = vErrorExit;
+    pxJpeg->xError.xManager.output_message = vOutputMessage;
+
+    if ( 0 != setjmp( pxJpeg->xError.xJump ) )
+    {
+        return -1;
+    }
+
+    jpeg_create_decompress( &pxJpeg->xDecompress );
+    pxJpeg->bCreated = 1;
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewJpegDestroy( xHUDViewJpeg_t * pxJpeg )
+{
+    if ( pxJpeg->bCreated )
+    {
+        jpeg_destroy_decompress( &pxJpeg->xDecompress );
+        pxJpeg->bCreated = 0;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewJpegDecode( xHUDViewJpeg_t * pxJpeg, const uint8_t * pucData, size_t ulBytes, int iDenominator,
+                        eHUDViewJpegOutput_t eOutput, uint8_t * pucOutput, int iStride, int iMaximumWidth,
+                        int iMaximumHeight, uint8_t * pucLuma, int * piWidth, int * piHeight )
+{
+    struct jpeg_decompress_struct * pxDecompress = &pxJpeg->xDecompress;
+    JSAMPROW apucRows[ MAXIMUM_ROWS_PER_READ ];
+    JDIMENSION ulFirstRow = 0;
+    JDIMENSION ulRead = 0;
+    int iRows = 0;
+    int iRow = 0;
+
+    if ( !pxJpeg->bCreated )
+    {
+        return -1;
+    }
+
+    /* Nothing set up after this point is relied on once a corrupt frame has jumped back here. */
+    if ( 0 != setjmp( pxJpeg->xError.xJump ) )
+    {
+        jpeg_abort_decompress( pxDecompress );
+        return -1;
+    }
+
+    jpeg_mem_src( pxDecompress, pucData, ( unsigned long )ulBytes );
+
+    if ( JPEG_HEADER_OK != jpeg_read_header( pxDecompress, TRUE ) )
+    {
+        jpeg_abort_decompress( pxDecompress );
+        return -1;
+    }
+
+    pxDecompress->scale_num = 1;
+    pxDecompress->scale_denom = ( unsigned int )iDenominator;
+
+    /* RGB565 is truncated, not dithered, to match what the transform produces from RGB888. */
+    if ( eHUDViewJpegOutput_RGB565 == eOutput )
+    {
+        pxDecompress->out_color_space = JCS_RGB565;
+        pxDecompress->dither_mode = JDITHER_NONE;
+    }
+    else
+    {
+        pxDecompress->out_color_space = JCS_EXT_RGB;
+    }
+
+    if ( pxJpeg->bFast )
+    {
+        pxDecompress->dct_method = JDCT_IFAST;
+        pxDecompress->do_fancy_upsampling = FALSE;
+    }
+
+    jpeg_start_decompress( pxDecompress );
+
+    /* A frame larger than expected (the camera reconfigured under us) must not run off the end of the buffer. */
+    if ( ( ( int )pxDecompress->output_width > iMaximumWidth )
+         || ( ( int )pxDecompress->output_height > iMaximumHeight ) )
+    {
+        snprintf( pxJpeg->xError.acMessage, sizeof( pxJpeg->xError.acMessage ), "Frame of %ux%u exceeds %dx%d",
+                  pxDecompress->output_width, pxDecompress->output_height, iMaximumWidth, iMaximumHeight );
+        jpeg_abort_decompress( pxDecompress );
+        return -1;
+    }
+
+    iRows = ( MAXIMUM_ROWS_PER_READ < pxDecompress->rec_outbuf_height )
+            ? MAXIMUM_ROWS_PER_READ : pxDecompress->rec_outbuf_height;
+
+    while ( pxDecompress->output_scanline < pxDecompress->output_height )
+    {
+        ulFirstRow = pxDecompress->output_scanline;
+
+        for ( iRow = 0; iRow < iRows; iRow++ )
+        {
+            apucRows[ iRow ] = pucOutput + ( size_t )( ulFirstRow + ( JDIMENSION )iRow ) * ( size_t )iStride;
+        }
+
+        ulRead = jpeg_read_scanlines( pxDecompress, apucRows, ( JDIMENSION )iRows );
+
+        /* Luma is taken from each row while it is still in cache. */
+        if ( ( eHUDViewJpegOutput_RGB565 == eOutput ) && ( NULL != pucLuma ) )
+        {
+            for ( iRow = 0; iRow < ( int )ulRead; iRow++ )
+            {
+                vLumaFromRGB565( ( const uint16_t * )apucRows[ iRow ],
+                                 pucLuma + ( size_t )( ulFirstRow + ( JDIMENSION )iRow ) * pxDecompress->output_width,
+                                 ( int )pxDecompress->output_width );
+            }
+        }
+    }
+
+    *piWidth = ( int )pxDecompress->output_width;
+    *piHeight = ( int )pxDecompress->output_height;
+    jpeg_finish_decompress( pxDecompress );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewJpegError( const xHUDViewJpeg_t * pxJpeg )
+{
+    return pxJpeg->xError.acMessage;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vErrorExit( j_common_ptr pxCommon )
+{
+    xHUDViewJpegError_t * pxError = ( xHUDViewJpegError_t * )pxCommon->err;
+
+    ( *pxCommon->err->format_message )( pxCommon, pxError->acMessage );
+    longjmp( pxError->xJump, 1 );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vOutputMessage( j_common_ptr pxCommon )
+{
+    xHUDViewJpegError_t * pxError = ( xHUDViewJpegError_t * )pxCommon->err;
+
+    /* Warnings about damaged frames are kept for the caller rather than printed at frame rate. */
+    ( *pxCommon->err->format_message )( pxCommon, pxError->acMessage );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vLumaFromRGB565( const uint16_t * pusRow, uint8_t * pucLuma, int iWidth )
+{
+    int iX = 0;
+
+    for ( iX = 0; iX < iWidth; iX++ )
+    {
+        uint16_t usPixel = pusRow[ iX ];
+        uint8_t ucRed = ( uint8_t )( ( ( usPixel >> 8 ) & 0xF8 ) | ( usPixel >> 13 ) );
+        uint8_t ucGreen = ( uint8_t )( ( ( usPixel >> 3 ) & 0xFC ) | ( ( usPixel >> 9 ) & 0x03 ) );
+        uint8_t ucBlue = ( uint8_t )( ( ( usPixel << 3 ) & 0xF8 ) | ( ( usPixel >> 2 ) & 0x07 ) );
+
+        pucLuma[ iX ] = HUDVIEW_FLOW_LUMA( ucRed, ucGreen, ucBlue );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
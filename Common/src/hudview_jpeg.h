@@ -0,0 +1,78 @@
+/** @file hudview_jpeg.h
+ *  @brief HUDView camera MJPEG framing and reduced-scale decoding.
+ *
+ *  In MJPEG mode the camera sends each frame as a JPEG, a fraction of the size of the raw RGB888 frame, back to back
+ *  on the FIFO. Frames are found by their SOI and EOI markers (entropy-coded data never contains an unescaped marker)
+ *  and decoded with libjpeg-turbo, which can scale by 1/2, 1/4 or 1/8 in the DCT itself: a scaled decode does the
+ *  inverse transform, upsampling and colour conversion on that fraction of the pixels, so it costs little more than
+ *  the entropy decoding. iHUDViewJpegPlan() picks the smallest scale that still covers the display picture for a
+ *  camera specification, and the transform of the decoded frame, which is laid out exactly as raw camera output of
+ *  the scaled size would be, so everything downstream of the decoder is unchanged. The decoder can also write RGB565
+ *  (with luma alongside) directly, for when the decoded picture needs no further transform.
+ */
+
+#ifndef HUDVIEW_JPEG_H
+#define HUDVIEW_JPEG_H
+
+#include <setjmp.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <jpeglib.h>
+
+#include "hudview_transform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_JPEG_MARKER_SOI                 ( 0xD8 )
+#define HUDVIEW_JPEG_MARKER_EOI                 ( 0xD9 )
+
+/* The largest reduction libjpeg-turbo makes in the DCT. */
+#define HUDVIEW_JPEG_MAXIMUM_DENOMINATOR        ( 8 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eHUDViewJpegOutputMin = 0,
+
+    eHUDViewJpegOutput_RGB888 = eHUDViewJpegOutputMin,
+    eHUDViewJpegOutput_RGB565,
+
+    eHUDViewJpegOutputMax
+} eHUDViewJpegOutput_t;
+
+typedef struct {
+    struct jpeg_error_mgr xManager;
+    jmp_buf xJump;
+    char acMessage[ JMSG_LENGTH_MAX ];
+} xHUDViewJpegError_t;
+
+typedef struct {
+    struct jpeg_decompress_struct xDecompress;
+    xHUDViewJpegError_t xError;
+    int bCreated;
+
+    /* The fast integer DCT and plain upsampling; a little softer, noticeably quicker on the Pi. */
+    int bFast;
+} xHUDViewJpeg_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+size_t ulHUDViewJpegFindMarker( const uint8_t * pucData, size_t ulBytes, size_t ulFrom, uint8_t ucMarker );
+int iHUDViewJpegPlan( const xHUDViewTransformConfig_t * pxCapture, xHUDViewTransformConfig_t * pxDecoded,
+                      int * piDenominator );
+
+int iHUDViewJpegInit( xHUDViewJpeg_t * pxJpeg, int bFast );
+void vHUDViewJpegDestroy( xHUDViewJpeg_t * pxJpeg );
+int iHUDViewJpegDecode( xHUDViewJpeg_t * pxJpeg, const uint8_t * pucData, size_t ulBytes, int iDenominator,
+                        eHUDViewJpegOutput_t eOutput, uint8_t * pucOutput, int iStride, int iMaximumWidth,
+                        int iMaximumHeight, uint8_t * pucLuma, int * piWidth, int * piHeight );
+const char * pcHUDViewJpegError( const xHUDViewJpeg_t * pxJpeg );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_JPEG_H
@@ -0,0 +1,42 @@
+/** @file hudview_memlock.h
+ *  @brief HUDView memory locking on request of the control application.
+ *
+ *  Memory locks do not survive exec(), so the control application cannot lock a component's memory for it. Instead
+ *  it sets HUDVIEW_MLOCK=1 in the environment of every component configured with "Name.mlock=1", and the component
+ *  locks its own pages as soon as it starts, before it touches the sensor, so a page fault can never stall a sample.
+ */
+
+#ifndef HUDVIEW_MEMLOCK_H
+#define HUDVIEW_MEMLOCK_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_MLOCK_ENVIRONMENT_VARIABLE  "HUDVIEW_MLOCK"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Returns 1 if memory was locked, 0 if locking was not requested and -1 if it was requested but failed. */
+static inline int iHUDViewLockMemoryIfRequested( void )
+{
+    const char * pcValue = getenv( HUDVIEW_MLOCK_ENVIRONMENT_VARIABLE );
+
+    if ( ( NULL == pcValue ) || ( 0 != strcmp( pcValue, "1" ) ) )
+    {
+        return 0;
+    }
+
+    return ( 0 == mlockall( MCL_CURRENT | MCL_FUTURE ) ) ? 1 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_MEMLOCK_H
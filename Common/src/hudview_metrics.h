@@ -0,0 +1,374 @@
+/** @file hudview_metrics.h
+ *  @brief HUDView shared-memory metrics page.
+ *
+ *  Every HUDView process records per-stage latencies and counters into a single shared-memory page created by the
+ *  control application. Recording is lock-free (relaxed atomic adds on fixed slots), so it is cheap enough to do on
+ *  every sample, and readers such as hudview_metrics can attach at any time to print live percentiles.
+ *
+ *  Latencies are kept in log-linear (HDR-style) histograms: values below 16 ns are counted exactly, larger values
+ *  fall into one of 16 sub-buckets per power of two, bounding the error of any reported percentile to about 6%.
+ */
+
+#ifndef HUDVIEW_METRICS_H
+#define HUDVIEW_METRICS_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_METRICS_SHM_NAME            "/hudview_metrics"
+#define HUDVIEW_METRICS_MAGIC               ( 0x4856524DUL )
+#define HUDVIEW_METRICS_VERSION             ( 2 )
+#define HUDVIEW_METRICS_MAX_COMPONENTS      ( 16 )
+#define HUDVIEW_METRICS_NAME_LENGTH         ( 24 )
+#define HUDVIEW_METRICS_SUB_BUCKET_BITS     ( 4 )
+#define HUDVIEW_METRICS_SUB_BUCKETS         ( 1 << HUDVIEW_METRICS_SUB_BUCKET_BITS )
+#define HUDVIEW_METRICS_MAX_EXPONENT        ( 40 )
+#define HUDVIEW_METRICS_BUCKETS             ( HUDVIEW_METRICS_SUB_BUCKETS \
+                                              * ( HUDVIEW_METRICS_MAX_EXPONENT - HUDVIEW_METRICS_SUB_BUCKET_BITS + 2 ) )
+
+/* A slot being named holds the process ID of the process naming it, so a slot left half named by a process that died
+ * can be told apart and freed again. */
+#define HUDVIEW_METRICS_SLOT_FREE           ( 0 )
+#define HUDVIEW_METRICS_SLOT_READY          ( 0xFFFFFFFFUL )
+
+/* How long to wait for a live process to finish naming a slot, which takes it well under a microsecond when it runs,
+ * before passing the slot by. */
+#define HUDVIEW_METRICS_CLAIM_WAIT_NS       ( 10000000ULL )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eHUDViewMetricsStage_SensorToStdout = 0,
+    eHUDViewMetricsStage_PipeToHandler,
+    eHUDViewMetricsStage_Parse,
+    eHUDViewMetricsStage_ModelUpdate,
+    eHUDViewMetricsStage_RenderToSPI,
+
+    eHUDViewMetricsStageMax
+} eHUDViewMetricsStage_t;
+
+typedef enum {
+    eHUDViewMetricsCounter_RecordsIn = 0,
+    eHUDViewMetricsCounter_RecordsApplied,
+    eHUDViewMetricsCounter_Bytes,
+    eHUDViewMetricsCounter_FramesPushed,
+
+    eHUDViewMetricsCounterMax
+} eHUDViewMetricsCounter_t;
+
+typedef struct {
+    uint64_t ullCount;
+    uint64_t ullSum;
+    uint64_t ullMaximum;
+    uint64_t aullBuckets[ HUDVIEW_METRICS_BUCKETS ];
+} xHUDViewHistogram_t;
+
+typedef struct {
+    uint32_t ulState;
+    char acName[ HUDVIEW_METRICS_NAME_LENGTH ];
+    uint64_t ullLastWriteNanoseconds;
+    uint64_t aullCounters[ eHUDViewMetricsCounterMax ];
+    xHUDViewHistogram_t axHistograms[ eHUDViewMetricsStageMax ];
+} xHUDViewMetricsComponent_t;
+
+typedef struct {
+    uint32_t ulMagic;
+    uint32_t ulVersion;
+    uint64_t ullCreatedNanoseconds;
+    xHUDViewMetricsComponent_t axComponents[ HUDVIEW_METRICS_MAX_COMPONENTS ];
+} xHUDViewMetricsPage_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline uint64_t ullHUDViewMetricsNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( uint64_t )xNow.tv_sec * 1000000000ULL + ( uint64_t )xNow.tv_nsec;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline const char * pcHUDViewMetricsStageName( eHUDViewMetricsStage_t eStage )
+{
+    static const char * const apcNames[ eHUDViewMetricsStageMax ] =
+    {
+        "sensor->stdout", "pipe->handler", "parse", "model update", "render->spi"
+    };
+
+    return ( eHUDViewMetricsStageMax > eStage ) ? apcNames[ eStage ] : "unknown";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Map the page, creating and initializing it when bCreate is set (control application only). */
+static inline xHUDViewMetricsPage_t * pxHUDViewMetricsAttach( int bCreate, int bWritable )
+{
+    xHUDViewMetricsPage_t * pxPage = NULL;
+    void * pvMapping = MAP_FAILED;
+    struct stat xStat;
+    int iDescriptor = shm_open( HUDVIEW_METRICS_SHM_NAME, ( bWritable ? O_RDWR : O_RDONLY ) | ( bCreate ? O_CREAT : 0 ),
+                                0666 );
+
+    if ( 0 <= iDescriptor )
+    {
+        if ( bCreate && ( 0 == fstat( iDescriptor, &xStat ) ) && ( sizeof( xHUDViewMetricsPage_t ) != xStat.st_size ) )
+        {
+            ( void )ftruncate( iDescriptor, sizeof( xHUDViewMetricsPage_t ) );
+        }
+
+        if ( ( 0 == fstat( iDescriptor, &xStat ) ) && ( sizeof( xHUDViewMetricsPage_t ) == xStat.st_size ) )
+        {
+            pvMapping = mmap( NULL, sizeof( xHUDViewMetricsPage_t ), PROT_READ | ( bWritable ? PROT_WRITE : 0 ),
+                              MAP_SHARED, iDescriptor, 0 );
+        }
+
+        close( iDescriptor );
+    }
+
+    if ( MAP_FAILED != pvMapping )
+    {
+        pxPage = ( xHUDViewMetricsPage_t * )pvMapping;
+
+        /* Start every control application run from a clean page. */
+        if ( bCreate )
+        {
+            memset( pxPage, 0, sizeof( xHUDViewMetricsPage_t ) );
+            pxPage->ullCreatedNanoseconds = ullHUDViewMetricsNow();
+            pxPage->ulVersion = HUDVIEW_METRICS_VERSION;
+            __atomic_store_n( &pxPage->ulMagic, HUDVIEW_METRICS_MAGIC, __ATOMIC_RELEASE );
+        }
+        else if ( ( HUDVIEW_METRICS_MAGIC != __atomic_load_n( &pxPage->ulMagic, __ATOMIC_ACQUIRE ) )
+                  || ( HUDVIEW_METRICS_VERSION != pxPage->ulVersion ) )
+        {
+            munmap( pvMapping, sizeof( xHUDViewMetricsPage_t ) );
+            pxPage = NULL;
+        }
+    }
+
+    return pxPage;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline void vHUDViewMetricsDetach( xHUDViewMetricsPage_t * pxPage )
+{
+    if ( NULL != pxPage )
+    {
+        munmap( pxPage, sizeof( xHUDViewMetricsPage_t ) );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Wait for the given process to finish naming a slot, returning non-zero once it has or the slot is free again, and
+ * zero if it is still being named once the wait is up. */
+static inline int iHUDViewMetricsAwaitClaim( xHUDViewMetricsComponent_t * pxSlot, uint32_t ulClaimer )
+{
+    uint64_t ullDeadline = ullHUDViewMetricsNow() + HUDVIEW_METRICS_CLAIM_WAIT_NS;
+
+    while ( ulClaimer == __atomic_load_n( &pxSlot->ulState, __ATOMIC_ACQUIRE ) )
+    {
+        /* A claimer that died half way through naming the slot would otherwise hold it for good. */
+        if ( ( 0 != kill( ( pid_t )ulClaimer, 0 ) ) && ( ESRCH == errno ) )
+        {
+            ( void )__atomic_compare_exchange_n( &pxSlot->ulState, &ulClaimer, HUDVIEW_METRICS_SLOT_FREE, 0,
+                                                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+            return 1;
+        }
+
+        /* One that is alive but not running, e.g. stopped, costs a slot rather than hanging every later attach. */
+        if ( ullHUDViewMetricsNow() > ullDeadline )
+        {
+            return 0;
+        }
+
+        sched_yield();
+    }
+
+    return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Find the named component's slot, claiming a free one if it has not been registered yet. */
+static inline xHUDViewMetricsComponent_t * pxHUDViewMetricsComponent( xHUDViewMetricsPage_t * pxPage,
+                                                                      const char * pcName )
+{
+    xHUDViewMetricsComponent_t * pxReturn = NULL;
+    uint32_t ulExpected = HUDVIEW_METRICS_SLOT_FREE;
+    int iSlot = 0;
+
+    if ( NULL == pxPage )
+    {
+        return NULL;
+    }
+
+    for ( iSlot = 0; ( iSlot < HUDVIEW_METRICS_MAX_COMPONENTS ) && ( NULL == pxReturn ); iSlot++ )
+    {
+        xHUDViewMetricsComponent_t * pxSlot = &pxPage->axComponents[ iSlot ];
+
+        if ( HUDVIEW_METRICS_SLOT_READY == __atomic_load_n( &pxSlot->ulState, __ATOMIC_ACQUIRE ) )
+        {
+            if ( 0 == strncmp( pxSlot->acName, pcName, HUDVIEW_METRICS_NAME_LENGTH ) )
+            {
+                pxReturn = pxSlot;
+            }
+        }
+        else
+        {
+            ulExpected = HUDVIEW_METRICS_SLOT_FREE;
+
+            if ( __atomic_compare_exchange_n( &pxSlot->ulState, &ulExpected, ( uint32_t )getpid(), 0,
+                                              __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+            {
+                strncpy( pxSlot->acName, pcName, HUDVIEW_METRICS_NAME_LENGTH - 1 );
+                __atomic_store_n( &pxSlot->ulState, HUDVIEW_METRICS_SLOT_READY, __ATOMIC_RELEASE );
+                pxReturn = pxSlot;
+            }
+            else if ( ( HUDVIEW_METRICS_SLOT_READY != ulExpected ) && iHUDViewMetricsAwaitClaim( pxSlot, ulExpected ) )
+            {
+                /* Another process was naming this slot; look at it again now that it is named or free. */
+                iSlot--;
+            }
+        }
+    }
+
+    return pxReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline uint32_t ulHUDViewMetricsBucket( uint64_t ullValue )
+{
+    uint32_t ulExponent = 0;
+
+    if ( HUDVIEW_METRICS_SUB_BUCKETS > ullValue )
+    {
+        return ( uint32_t )ullValue;
+    }
+
+    ulExponent = 63 - ( uint32_t )__builtin_clzll( ullValue );
+
+    if ( HUDVIEW_METRICS_MAX_EXPONENT < ulExponent )
+    {
+        return HUDVIEW_METRICS_BUCKETS - 1;
+    }
+
+    return ( ( ulExponent - HUDVIEW_METRICS_SUB_BUCKET_BITS + 1 ) << HUDVIEW_METRICS_SUB_BUCKET_BITS )
+           | ( uint32_t )( ( ullValue >> ( ulExponent - HUDVIEW_METRICS_SUB_BUCKET_BITS ) )
+                           & ( HUDVIEW_METRICS_SUB_BUCKETS - 1 ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Midpoint of the values that land in a bucket, used when reporting percentiles. */
+static inline uint64_t ullHUDViewMetricsBucketValue( uint32_t ulBucket )
+{
+    uint32_t ulExponent = 0;
+    uint64_t ullLower = 0;
+
+    if ( HUDVIEW_METRICS_SUB_BUCKETS > ulBucket )
+    {
+        return ulBucket;
+    }
+
+    ulExponent = ( ulBucket >> HUDVIEW_METRICS_SUB_BUCKET_BITS ) + HUDVIEW_METRICS_SUB_BUCKET_BITS - 1;
+    ullLower = ( uint64_t )( HUDVIEW_METRICS_SUB_BUCKETS | ( ulBucket & ( HUDVIEW_METRICS_SUB_BUCKETS - 1 ) ) )
+               << ( ulExponent - HUDVIEW_METRICS_SUB_BUCKET_BITS );
+
+    return ullLower + ( ( 1ULL << ( ulExponent - HUDVIEW_METRICS_SUB_BUCKET_BITS ) ) >> 1 );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Histograms outside the page, such as the control application's latency tracer, are recorded the same way. */
+static inline void vHUDViewHistogramRecord( xHUDViewHistogram_t * pxHistogram, uint64_t ullNanoseconds )
+{
+    uint64_t ullMaximum = 0;
+
+    __atomic_fetch_add( &pxHistogram->aullBuckets[ ulHUDViewMetricsBucket( ullNanoseconds ) ], 1, __ATOMIC_RELAXED );
+    __atomic_fetch_add( &pxHistogram->ullSum, ullNanoseconds, __ATOMIC_RELAXED );
+    __atomic_fetch_add( &pxHistogram->ullCount, 1, __ATOMIC_RELAXED );
+
+    ullMaximum = __atomic_load_n( &pxHistogram->ullMaximum, __ATOMIC_RELAXED );
+
+    while ( ( ullNanoseconds > ullMaximum )
+            && !__atomic_compare_exchange_n( &pxHistogram->ullMaximum, &ullMaximum, ullNanoseconds, 1,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+    {
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline void vHUDViewMetricsRecord( xHUDViewMetricsComponent_t * pxComponent, eHUDViewMetricsStage_t eStage,
+                                          uint64_t ullNanoseconds )
+{
+    if ( ( NULL != pxComponent ) && ( eHUDViewMetricsStageMax > eStage ) )
+    {
+        vHUDViewHistogramRecord( &pxComponent->axHistograms[ eStage ], ullNanoseconds );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline void vHUDViewMetricsCount( xHUDViewMetricsComponent_t * pxComponent, eHUDViewMetricsCounter_t eCounter,
+                                         uint64_t ullAmount )
+{
+    if ( ( NULL != pxComponent ) && ( eHUDViewMetricsCounterMax > eCounter ) )
+    {
+        __atomic_fetch_add( &pxComponent->aullCounters[ eCounter ], ullAmount, __ATOMIC_RELAXED );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Stamp the moment a record was handed to stdout, so the reader can measure how long it sat in the pipe. */
+static inline void vHUDViewMetricsMarkWrite( xHUDViewMetricsComponent_t * pxComponent, uint64_t ullNanoseconds )
+{
+    if ( NULL != pxComponent )
+    {
+        __atomic_store_n( &pxComponent->ullLastWriteNanoseconds, ullNanoseconds, __ATOMIC_RELEASE );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static inline uint64_t ullHUDViewMetricsPercentile( const xHUDViewHistogram_t * pxHistogram, double dPercentile )
+{
+    uint64_t ullCount = __atomic_load_n( &pxHistogram->ullCount, __ATOMIC_RELAXED );
+    uint64_t ullTarget = ( uint64_t )( ( dPercentile / 100.0 ) * ( double )ullCount + 0.5 );
+    uint64_t ullSeen = 0;
+    uint32_t ulBucket = 0;
+
+    if ( 0 == ullCount )
+    {
+        return 0;
+    }
+
+    if ( 0 == ullTarget )
+    {
+        ullTarget = 1;
+    }
+
+    for ( ulBucket = 0; ulBucket < HUDVIEW_METRICS_BUCKETS; ulBucket++ )
+    {
+        ullSeen += __atomic_load_n( &pxHistogram->aullBuckets[ ulBucket ], __ATOMIC_RELAXED );
+
+        if ( ullSeen >= ullTarget )
+        {
+            return ullHUDViewMetricsBucketValue( ulBucket );
+        }
+    }
+
+    return __atomic_load_n( &pxHistogram->ullMaximum, __ATOMIC_RELAXED );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_METRICS_H
@@ -0,0 +1,274 @@
+/** @file hudview_rgb444.c
+ *  @brief HUDView 12-bit pixel packing for the display link.
+ */
+
+#include <string.h>
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define HUDVIEW_RGB444_NEON
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#define HUDVIEW_RGB444_SSE2
+#endif
+
+#include "hudview_rgb444.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Ordered dither thresholds out of 16; a channel losing n bits adds the top n bits of its pixel's threshold. */
+static const uint8_t aaucBayer[ 4 ][ 4 ] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPackRun( const xHUDViewRGB444_t * pxPacker, const uint16_t * pusPixels, int iPixels, int iX, int iY,
+                      uint8_t * pucPacked );
+static void vThresholds( const xHUDViewRGB444_t * pxPacker, int iX, int iY, uint16_t * pusRedBlue, uint16_t * pusGreen,
+                         int iCount );
+static uint16_t usToRGB444( uint16_t usPixel, int iRedBlue, int iGreen );
+static void vPutPair( uint16_t usFirst, uint16_t usSecond, uint8_t * pucPacked );
+#if defined( HUDVIEW_RGB444_NEON )
+static uint16x8_t xToRGB444( uint16x8_t xPixels, uint16x8_t xRedBlue, uint16x8_t xGreen );
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewRGB444Init( xHUDViewRGB444_t * pxPacker, int bDither )
+{
+    memset( pxPacker, 0, sizeof( *pxPacker ) );
+    pxPacker->bDither = bDither;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewRGB444SetScalar( xHUDViewRGB444_t * pxPacker, int bScalar )
+{
+    pxPacker->bScalar = bScalar;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewRGB444Kernels( void )
+{
+#if defined( HUDVIEW_RGB444_NEON )
+    return "NEON";
+#elif defined( HUDVIEW_RGB444_SSE2 )
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long ulHUDViewRGB444Pack( const xHUDViewRGB444_t * pxPacker, const uint16_t * pusPixels, int iStride, int iX,
+                                   int iY, int iWidth, int iHeight, uint8_t * pucPacked )
+{
+    uint8_t * pucOut = pucPacked;
+    uint16_t usCarry = 0;
+    int bCarry = 0;
+
+    for ( int iRow = 0; iRow < iHeight; iRow++ )
+    {
+        const uint16_t * pusRow = pusPixels + iRow * iStride;
+        uint16_t usRedBlue = 0;
+        uint16_t usGreen = 0;
+        int iColumn = 0;
+        int iPairs = 0;
+
+        /* The odd pixel left over from the row above goes out with this row's first. */
+        if ( bCarry && ( 0 < iWidth ) )
+        {
+            vThresholds( pxPacker, iX, iY + iRow, &usRedBlue, &usGreen, 1 );
+            vPutPair( usCarry, usToRGB444( pusRow[ 0 ], usRedBlue, usGreen ), pucOut );
+            pucOut += 3;
+            iColumn = 1;
+            bCarry = 0;
+        }
+
+        iPairs = ( iWidth - iColumn ) / 2;
+        vPackRun( pxPacker, pusRow + iColumn, iPairs * 2, iX + iColumn, iY + iRow, pucOut );
+        pucOut += iPairs * 3;
+        iColumn += iPairs * 2;
+
+        if ( iColumn < iWidth )
+        {
+            vThresholds( pxPacker, iX + iColumn, iY + iRow, &usRedBlue, &usGreen, 1 );
+            usCarry = usToRGB444( pusRow[ iColumn ], usRedBlue, usGreen );
+            bCarry = 1;
+        }
+    }
+
+    /* The panel takes a last odd pixel with its blue in the top of a byte of its own. */
+    if ( bCarry )
+    {
+        *pucOut++ = ( uint8_t )( usCarry >> 4 );
+        *pucOut++ = ( uint8_t )( ( usCarry & 0x0F ) << 4 );
+    }
+
+    return ( unsigned long )( pucOut - pucPacked );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewRGB444Unpack( const uint8_t * pucPacked, unsigned long ulPixels, uint16_t * pusPixels )
+{
+    for ( unsigned long ulPixel = 0; ulPixel < ulPixels; ulPixel++ )
+    {
+        const uint8_t * pucPair = pucPacked + ( ulPixel / 2 ) * 3;
+        unsigned int uiPixel = ( 0 == ( ulPixel & 1 ) ) ? ( ( pucPair[ 0 ] << 4 ) | ( pucPair[ 1 ] >> 4 ) )
+                                                         : ( ( ( pucPair[ 1 ] & 0x0F ) << 8 ) | pucPair[ 2 ] );
+        unsigned int uiRed = ( uiPixel >> 8 ) & 0x0F;
+        unsigned int uiGreen = ( uiPixel >> 4 ) & 0x0F;
+        unsigned int uiBlue = uiPixel & 0x0F;
+
+        /* Repeating each channel's top bits fills its range, so white stays white. */
+        pusPixels[ ulPixel ] = ( uint16_t )( ( ( ( uiRed << 1 ) | ( uiRed >> 3 ) ) << 11 )
+                                             | ( ( ( uiGreen << 2 ) | ( uiGreen >> 2 ) ) << 5 )
+                                             | ( ( uiBlue << 1 ) | ( uiBlue >> 3 ) ) );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPackRun( const xHUDViewRGB444_t * pxPacker, const uint16_t * pusPixels, int iPixels, int iX, int iY,
+                      uint8_t * pucPacked )
+{
+    uint16_t ausRedBlue[ 16 ];
+    uint16_t ausGreen[ 16 ];
+    int iPixel = 0;
+
+    /* The thresholds repeat every four pixels, so one set serves every block of 8 or 16 along the row. */
+    vThresholds( pxPacker, iX, iY, ausRedBlue, ausGreen, 16 );
+
+#if defined( HUDVIEW_RGB444_NEON )
+    if ( !pxPacker->bScalar )
+    {
+        uint16_t aausPairs[ 4 ][ 8 ];
+
+        for ( int iLane = 0; iLane < 8; iLane++ )
+        {
+            aausPairs[ 0 ][ iLane ] = ausRedBlue[ 2 * iLane ];
+            aausPairs[ 1 ][ iLane ] = ausGreen[ 2 * iLane ];
+            aausPairs[ 2 ][ iLane ] = ausRedBlue[ 2 * iLane + 1 ];
+            aausPairs[ 3 ][ iLane ] = ausGreen[ 2 * iLane + 1 ];
+        }
+
+        uint16x8_t xEvenRedBlue = vld1q_u16( aausPairs[ 0 ] );
+        uint16x8_t xEvenGreen = vld1q_u16( aausPairs[ 1 ] );
+        uint16x8_t xOddRedBlue = vld1q_u16( aausPairs[ 2 ] );
+        uint16x8_t xOddGreen = vld1q_u16( aausPairs[ 3 ] );
+        uint16x8_t xLowNibble = vdupq_n_u16( 0x0F );
+
+        /* Loading in pairs splits the even pixels from the odd, and storing in threes lays each pair's bytes out. */
+        for ( ; iPixel + 16 <= iPixels; iPixel += 16 )
+        {
+            uint16x8x2_t xPixels = vld2q_u16( &pusPixels[ iPixel ] );
+            uint16x8_t xEven = xToRGB444( xPixels.val[ 0 ], xEvenRedBlue, xEvenGreen );
+            uint16x8_t xOdd = xToRGB444( xPixels.val[ 1 ], xOddRedBlue, xOddGreen );
+            uint8x8x3_t xBytes;
+
+            xBytes.val[ 0 ] = vmovn_u16( vshrq_n_u16( xEven, 4 ) );
+            xBytes.val[ 1 ] = vmovn_u16( vorrq_u16( vshlq_n_u16( vandq_u16( xEven, xLowNibble ), 4 ),
+                                                    vshrq_n_u16( xOdd, 8 ) ) );
+            xBytes.val[ 2 ] = vmovn_u16( xOdd );
+            vst3_u8( pucPacked, xBytes );
+            pucPacked += 24;
+        }
+    }
+#elif defined( HUDVIEW_RGB444_SSE2 )
+    if ( !pxPacker->bScalar )
+    {
+        __m128i xRedBlueThresholds = _mm_loadu_si128( ( const __m128i * )ausRedBlue );
+        __m128i xGreenThresholds = _mm_loadu_si128( ( const __m128i * )ausGreen );
+        __m128i xFifteen = _mm_set1_epi16( 15 );
+        __m128i xFiveBits = _mm_set1_epi16( 0x1F );
+        __m128i xSixBits = _mm_set1_epi16( 0x3F );
+        __m128i xLowHalves = _mm_set1_epi32( 0xFFFF );
+        uint32_t aulPairs[ 4 ];
+
+        for ( ; iPixel + 8 <= iPixels; iPixel += 8 )
+        {
+            __m128i xPixels = _mm_loadu_si128( ( const __m128i * )&pusPixels[ iPixel ] );
+            __m128i xRed = _mm_srli_epi16( _mm_add_epi16( _mm_srli_epi16( xPixels, 11 ), xRedBlueThresholds ), 1 );
+            __m128i xGreen = _mm_and_si128( _mm_srli_epi16( xPixels, 5 ), xSixBits );
+            __m128i xBlue = _mm_and_si128( xPixels, xFiveBits );
+            __m128i xPacked;
+
+            xGreen = _mm_min_epi16( _mm_srli_epi16( _mm_add_epi16( xGreen, xGreenThresholds ), 2 ), xFifteen );
+            xBlue = _mm_min_epi16( _mm_srli_epi16( _mm_add_epi16( xBlue, xRedBlueThresholds ), 1 ), xFifteen );
+            xPacked = _mm_or_si128( _mm_slli_epi16( _mm_min_epi16( xRed, xFifteen ), 8 ), _mm_slli_epi16( xGreen, 4 ) );
+            xPacked = _mm_or_si128( xPacked, xBlue );
+
+            /* Each 32-bit lane holds an even pixel low and the odd one high; as 24 bits, the even pixel comes first.
+             * Without a byte shuffle in SSE2 the three bytes of each pair are written out one by one. */
+            xPacked = _mm_or_si128( _mm_slli_epi32( _mm_and_si128( xPacked, xLowHalves ), 12 ),
+                                    _mm_srli_epi32( xPacked, 16 ) );
+            _mm_storeu_si128( ( __m128i * )aulPairs, xPacked );
+
+            for ( int iPair = 0; iPair < 4; iPair++ )
+            {
+                pucPacked[ 0 ] = ( uint8_t )( aulPairs[ iPair ] >> 16 );
+                pucPacked[ 1 ] = ( uint8_t )( aulPairs[ iPair ] >> 8 );
+                pucPacked[ 2 ] = ( uint8_t )aulPairs[ iPair ];
+                pucPacked += 3;
+            }
+        }
+    }
+#endif
+
+    for ( ; iPixel + 2 <= iPixels; iPixel += 2 )
+    {
+        vPutPair( usToRGB444( pusPixels[ iPixel ], ausRedBlue[ iPixel & 15 ], ausGreen[ iPixel & 15 ] ),
+                  usToRGB444( pusPixels[ iPixel + 1 ], ausRedBlue[ ( iPixel + 1 ) & 15 ],
+                              ausGreen[ ( iPixel + 1 ) & 15 ] ),
+                  pucPacked );
+        pucPacked += 3;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vThresholds( const xHUDViewRGB444_t * pxPacker, int iX, int iY, uint16_t * pusRedBlue, uint16_t * pusGreen,
+                         int iCount )
+{
+    /* Red and blue lose one bit and green two; undithered, each is rounded to the nearest level. */
+    for ( int iPixel = 0; iPixel < iCount; iPixel++ )
+    {
+        int iThreshold = aaucBayer[ iY & 3 ][ ( iX + iPixel ) & 3 ];
+
+        pusRedBlue[ iPixel ] = ( uint16_t )( pxPacker->bDither ? ( iThreshold >> 3 ) : 1 );
+        pusGreen[ iPixel ] = ( uint16_t )( pxPacker->bDither ? ( iThreshold >> 2 ) : 2 );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint16_t usToRGB444( uint16_t usPixel, int iRedBlue, int iGreen )
+{
+    int iRed = ( ( usPixel >> 11 ) + iRedBlue ) >> 1;
+    int iGreenLevel = ( ( ( usPixel >> 5 ) & 0x3F ) + iGreen ) >> 2;
+    int iBlue = ( ( usPixel & 0x1F ) + iRedBlue ) >> 1;
+
+    iRed = ( 15 < iRed ) ? 15 : iRed;
+    iGreenLevel = ( 15 < iGreenLevel ) ? 15 : iGreenLevel;
+    iBlue = ( 15 < iBlue ) ? 15 : iBlue;
+
+    return ( uint16_t )( ( iRed << 8 ) | ( iGreenLevel << 4 ) | iBlue );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPutPair( uint16_t usFirst, uint16_t usSecond, uint8_t * pucPacked )
+{
+    pucPacked[ 0 ] = ( uint8_t )( usFirst >> 4 );
+    pucPacked[ 1 ] = ( uint8_t )( ( ( usFirst & 0x0F ) << 4 ) | ( usSecond >> 8 ) );
+    pucPacked[ 2 ] = ( uint8_t )( usSecond & 0xFF );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#if defined( HUDVIEW_RGB444_NEON )
+static uint16x8_t xToRGB444( uint16x8_t xPixels, uint16x8_t xRedBlue, uint16x8_t xGreen )
+{
+    uint16x8_t xFifteen = vdupq_n_u16( 15 );
+    uint16x8_t xRed = vshrq_n_u16( vaddq_u16( vshrq_n_u16( xPixels, 11 ), xRedBlue ), 1 );
+    uint16x8_t xGreenLevel = vandq_u16( vshrq_n_u16( xPixels, 5 ), vdupq_n_u16( 0x3F ) );
+    uint16x8_t xBlue = vandq_u16( xPixels, vdupq_n_u16( 0x1F ) );
+
+    xGreenLevel = vminq_u16( vshrq_n_u16( vaddq_u16( xGreenLevel, xGreen ), 2 ), xFifteen );
+    xBlue = vminq_u16( vshrq_n_u16( vaddq_u16( xBlue, xRedBlue ), 1 ), xFifteen );
+
+    return vorrq_u16( vorrq_u16( vshlq_n_u16( vminq_u16( xRed, xFifteen ), 8 ), vshlq_n_u16( xGreenLevel, 4 ) ),
+                      xBlue );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+#endif
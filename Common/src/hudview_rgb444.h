@@ -0,0 +1,58 @@
+/** @file hudview_rgb444.h
+ *  @brief HUDView 12-bit pixel packing for the display link.
+ *
+ *  The ST7735 takes 12 bits a pixel (COLMOD 0x03) as well as 16, two pixels to three bytes, so a camera picture goes
+ *  over SPI in three quarters of the bytes. Everything up to the wire stays RGB565; pixels are only cut down to four
+ *  bits a channel as they are packed, red and blue losing one bit and green two.
+ *
+ *  That loss bands smooth gradients such as the sky, so packing can dither first with a 4x4 ordered (Bayer) matrix.
+ *  The threshold depends only on where the pixel is on the panel, so a pixel that has not changed is always packed
+ *  the same way and the compositor's change tracking still holds; without dithering each channel is rounded.
+ *
+ *  A window's pixels reach the panel as one stream, so a row of odd width shares a byte with the next; a stream of an
+ *  odd number of pixels ends with half a byte of padding. NEON and SSE2 kernels convert and pack 16 or 8 pixels at a
+ *  time, with a scalar fallback that gives the same bytes.
+ */
+
+#ifndef HUDVIEW_RGB444_H
+#define HUDVIEW_RGB444_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Bytes on the wire for a stream of pixels. */
+#define HUDVIEW_RGB444_BYTES( ulPixels )        ( ( ( ulPixels ) * 3 + 1 ) / 2 )
+
+/* The ST7735 COLMOD command, and its argument for 12 and 16 bits a pixel. */
+#define HUDVIEW_RGB444_COLMOD_COMMAND           ( 0x3A )
+#define HUDVIEW_RGB444_COLMOD_12BIT             ( 0x03 )
+#define HUDVIEW_RGB444_COLMOD_16BIT             ( 0x05 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    int bScalar;
+    int bDither;
+} xHUDViewRGB444_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewRGB444Init( xHUDViewRGB444_t * pxPacker, int bDither );
+void vHUDViewRGB444SetScalar( xHUDViewRGB444_t * pxPacker, int bScalar );
+const char * pcHUDViewRGB444Kernels( void );
+
+/* Packs a region of RGB565 pixels whose top left is at (iX, iY) on the panel; returns the bytes written. */
+unsigned long ulHUDViewRGB444Pack( const xHUDViewRGB444_t * pxPacker, const uint16_t * pusPixels, int iStride, int iX,
+                                   int iY, int iWidth, int iHeight, uint8_t * pucPacked );
+
+/* What the panel shows for a packed stream, back in RGB565 with each channel's bits repeated. */
+void vHUDViewRGB444Unpack( const uint8_t * pucPacked, unsigned long ulPixels, uint16_t * pusPixels );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_RGB444_H
@@ -0,0 +1,907 @@
+/** @file hudview_ridelog.c
+ *  @brief HUDView columnar ride log writer, index and decoder.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_ridelog.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Worst case per sample is a 2-bit control, 5-bit leading count, 6-bit length and 64 meaningful bits. */
+#define COLUMN_BUFFER_BYTES ( HUDVIEW_RIDELOG_CHUNK_SAMPLES * 10 + 16 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    const uint8_t * pucData;
+    size_t ulBytes;
+    size_t ulPosition;
+    uint64_t ullAccumulator;
+    int iBits;
+} xBitReader_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const int aiStreamColumns[ eHUDViewRideLogStreamMax ] = { 0, 3, 5, 1 };
+static const char * const apcStreamNames[ eHUDViewRideLogStreamMax ] = { "", "accelerometer", "gps", "light" };
+static const double adPowersOfTen[ HUDVIEW_RIDELOG_MAX_DECIMALS + 1 ] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vWriteBits( xHUDViewRideLogBitWriter_t * pxWriter, uint64_t ullValue, int iCount );
+static void vFinishBits( xHUDViewRideLogBitWriter_t * pxWriter );
+static uint64_t ullReadBits( xBitReader_t * pxReader, int iCount );
+static int64_t llSignExtend( uint64_t ullValue, int iBits );
+static void vEncodeTimestamps( xHUDViewRideLogBitWriter_t * pxColumn, const int64_t * pllMicroseconds,
+                               uint32_t ulSamples );
+static int iFindDecimals( const double * pdValues, int iStride, uint32_t ulSamples );
+static void vEncodeDecimals( xHUDViewRideLogBitWriter_t * pxColumn, const double * pdValues, int iStride,
+                             uint32_t ulSamples, int iDecimals );
+static void vEncodeDoubles( xHUDViewRideLogBitWriter_t * pxColumn, const double * pdValues, int iStride,
+                            uint32_t ulSamples );
+static void vDecodeDecimals( xBitReader_t * pxReader, double * pdValues, int iStride, uint32_t ulSamples,
+                             int iDecimals );
+static void vDecodeDoubles( xBitReader_t * pxReader, double * pdValues, int iStride, uint32_t ulSamples );
+static int iFlushStream( xHUDViewRideLogWriter_t * pxWriter, eHUDViewRideLogStream_t eStream );
+static int iWriteAll( int iDescriptor, const void * pvData, size_t ulBytes );
+static uint32_t ulChecksum( const uint8_t * pucData, size_t ulBytes );
+static int bChunkValid( const uint8_t * pucFile, size_t ulFileSize, uint64_t ullOffset );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogColumns( eHUDViewRideLogStream_t eStream )
+{
+    return ( ( eHUDViewRideLogStreamMin < eStream ) && ( eHUDViewRideLogStreamMax > eStream ) )
+           ? aiStreamColumns[ eStream ] : 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewRideLogStreamName( eHUDViewRideLogStream_t eStream )
+{
+    return ( ( eHUDViewRideLogStreamMin < eStream ) && ( eHUDViewRideLogStreamMax > eStream ) )
+           ? apcStreamNames[ eStream ] : "unknown";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogOpen( xHUDViewRideLogWriter_t * pxWriter, const char * pcPath )
+{
+    xHUDViewRideLogHeader_t xHeader;
+    struct timespec xNow;
+    int iStream = 0;
+    int iColumn = 0;
+
+    memset( pxWriter, 0, sizeof( xHUDViewRideLogWriter_t ) );
+    pxWriter->iDescriptor = open( pcPath, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+    if ( 0 > pxWriter->iDescriptor )
+    {
+        return -1;
+    }
+
+    /* Every buffer is allocated here, so appending a sample never allocates. */
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        pxWriter->axStreams[ iStream ].pllMicroseconds = malloc( HUDVIEW_RIDELOG_CHUNK_SAMPLES * sizeof( int64_t ) );
+        pxWriter->axStreams[ iStream ].pdValues =
+            malloc( HUDVIEW_RIDELOG_CHUNK_SAMPLES * aiStreamColumns[ iStream ] * sizeof( double ) );
+
+        if ( ( NULL == pxWriter->axStreams[ iStream ].pllMicroseconds )
+             || ( NULL == pxWriter->axStreams[ iStream ].pdValues ) )
+        {
+            ( void )iHUDViewRideLogClose( pxWriter );
+            return -1;
+        }
+
+        for ( iColumn = 0; iColumn <= aiStreamColumns[ iStream ]; iColumn++ )
+        {
+            pxWriter->axStreams[ iStream ].axColumns[ iColumn ].pucData = malloc( COLUMN_BUFFER_BYTES );
+
+            if ( NULL == pxWriter->axStreams[ iStream ].axColumns[ iColumn ].pucData )
+            {
+                ( void )iHUDViewRideLogClose( pxWriter );
+                return -1;
+            }
+        }
+    }
+
+    clock_gettime( CLOCK_REALTIME, &xNow );
+    xHeader.ulMagic = HUDVIEW_RIDELOG_MAGIC;
+    xHeader.ulVersion = HUDVIEW_RIDELOG_VERSION;
+    xHeader.llCreatedMicroseconds = ( int64_t )xNow.tv_sec * 1000000LL + xNow.tv_nsec / 1000;
+
+    if ( 0 != iWriteAll( pxWriter->iDescriptor, &xHeader, sizeof( xHeader ) ) )
+    {
+        ( void )iHUDViewRideLogClose( pxWriter );
+        return -1;
+    }
+
+    pxWriter->ullOffset = sizeof( xHeader );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogAppend( xHUDViewRideLogWriter_t * pxWriter, eHUDViewRideLogStream_t eStream,
+                           int64_t llMicroseconds, const double * pdValues )
+{
+    xHUDViewRideLogStreamState_t * pxState = NULL;
+    int iColumns = iHUDViewRideLogColumns( eStream );
+    int iColumn = 0;
+    int iReturn = 0;
+
+    if ( ( 0 > pxWriter->iDescriptor ) || ( 0 == iColumns ) )
+    {
+        return -1;
+    }
+
+    pxState = &pxWriter->axStreams[ eStream ];
+
+    /* Keep each stream's time monotonic so its chunks stay sorted for the index, even across clock steps. */
+    if ( ( 0 < pxState->ulSamples ) && ( llMicroseconds < pxState->pllMicroseconds[ pxState->ulSamples - 1 ] ) )
+    {
+        llMicroseconds = pxState->pllMicroseconds[ pxState->ulSamples - 1 ];
+    }
+
+    /* Bound each chunk by time as well, so a slow stream such as the light sensor is not held in memory for long. */
+    if ( ( HUDVIEW_RIDELOG_CHUNK_SAMPLES <= pxState->ulSamples )
+         || ( ( 0 < pxState->ulSamples )
+              && ( HUDVIEW_RIDELOG_CHUNK_SPAN_US < llMicroseconds - pxState->pllMicroseconds[ 0 ] ) ) )
+    {
+        iReturn = iFlushStream( pxWriter, eStream );
+    }
+
+    pxState->pllMicroseconds[ pxState->ulSamples ] = llMicroseconds;
+
+    for ( iColumn = 0; iColumn < iColumns; iColumn++ )
+    {
+        pxState->pdValues[ pxState->ulSamples * iColumns + iColumn ] = pdValues[ iColumn ];
+    }
+
+    pxState->ulSamples++;
+    pxWriter->ullSamples++;
+    pxWriter->ullRawBytes += sizeof( int64_t ) + iColumns * sizeof( double );
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogFlush( xHUDViewRideLogWriter_t * pxWriter )
+{
+    int iStream = 0;
+    int iReturn = 0;
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        iReturn |= iFlushStream( pxWriter, ( eHUDViewRideLogStream_t )iStream );
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogClose( xHUDViewRideLogWriter_t * pxWriter )
+{
+    xHUDViewRideLogFooter_t xFooter;
+    int iStream = 0;
+    int iColumn = 0;
+    int iReturn = 0;
+
+    if ( 0 <= pxWriter->iDescriptor )
+    {
+        iReturn = iHUDViewRideLogFlush( pxWriter );
+
+        /* The index goes last; without it a reader falls back to walking the chunk headers. */
+        xFooter.ulMagic = HUDVIEW_RIDELOG_INDEX_MAGIC;
+        xFooter.ulEntries = pxWriter->ulIndexEntries;
+        xFooter.ullIndexOffset = pxWriter->ullOffset;
+
+        if ( ( 0 == iReturn ) && ( 0 < pxWriter->ulIndexEntries ) )
+        {
+            iReturn = iWriteAll( pxWriter->iDescriptor, pxWriter->pxIndex,
+                                 pxWriter->ulIndexEntries * sizeof( xHUDViewRideLogIndexEntry_t ) );
+        }
+
+        if ( 0 == iReturn )
+        {
+            iReturn = iWriteAll( pxWriter->iDescriptor, &xFooter, sizeof( xFooter ) );
+        }
+
+        ( void )fdatasync( pxWriter->iDescriptor );
+        close( pxWriter->iDescriptor );
+        pxWriter->iDescriptor = -1;
+    }
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        for ( iColumn = 0; iColumn <= HUDVIEW_RIDELOG_MAX_COLUMNS; iColumn++ )
+        {
+            free( pxWriter->axStreams[ iStream ].axColumns[ iColumn ].pucData );
+            pxWriter->axStreams[ iStream ].axColumns[ iColumn ].pucData = NULL;
+        }
+
+        free( pxWriter->axStreams[ iStream ].pllMicroseconds );
+        free( pxWriter->axStreams[ iStream ].pdValues );
+        pxWriter->axStreams[ iStream ].pllMicroseconds = NULL;
+        pxWriter->axStreams[ iStream ].pdValues = NULL;
+    }
+
+    free( pxWriter->pxIndex );
+    pxWriter->pxIndex = NULL;
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogLoadIndex( const uint8_t * pucFile, size_t ulFileSize, xHUDViewRideLogIndexEntry_t ** ppxEntries,
+                              uint32_t * pulEntries )
+{
+    const xHUDViewRideLogHeader_t * pxHeader = ( const xHUDViewRideLogHeader_t * )pucFile;
+    const xHUDViewRideLogFooter_t * pxFooter = NULL;
+    const xHUDViewRideLogChunk_t * pxChunk = NULL;
+    xHUDViewRideLogIndexEntry_t * pxEntries = NULL;
+    uint32_t ulEntries = 0;
+    uint32_t ulCapacity = 0;
+    uint64_t ullOffset = sizeof( xHUDViewRideLogHeader_t );
+
+    *ppxEntries = NULL;
+    *pulEntries = 0;
+
+    if ( ( sizeof( xHUDViewRideLogHeader_t ) > ulFileSize ) || ( HUDVIEW_RIDELOG_MAGIC != pxHeader->ulMagic )
+         || ( HUDVIEW_RIDELOG_VERSION != pxHeader->ulVersion ) )
+    {
+        return -1;
+    }
+
+    /* A closed log ends with its index. */
+    if ( sizeof( xHUDViewRideLogHeader_t ) + sizeof( xHUDViewRideLogFooter_t ) <= ulFileSize )
+    {
+        pxFooter = ( const xHUDViewRideLogFooter_t * )( pucFile + ulFileSize - sizeof( xHUDViewRideLogFooter_t ) );
+
+        if ( ( HUDVIEW_RIDELOG_INDEX_MAGIC == pxFooter->ulMagic )
+             && ( pxFooter->ullIndexOffset + ( uint64_t )pxFooter->ulEntries * sizeof( xHUDViewRideLogIndexEntry_t )
+                  + sizeof( xHUDViewRideLogFooter_t ) == ulFileSize ) )
+        {
+            pxEntries = malloc( ( pxFooter->ulEntries + 1 ) * sizeof( xHUDViewRideLogIndexEntry_t ) );
+
+            if ( NULL == pxEntries )
+            {
+                return -1;
+            }
+
+            memcpy( pxEntries, pucFile + pxFooter->ullIndexOffset,
+                    pxFooter->ulEntries * sizeof( xHUDViewRideLogIndexEntry_t ) );
+            *ppxEntries = pxEntries;
+            *pulEntries = pxFooter->ulEntries;
+
+            return 0;
+        }
+    }
+
+    /* Otherwise the log was cut short; rebuild the index from the chunks that made it to the card intact. */
+    while ( bChunkValid( pucFile, ulFileSize, ullOffset ) )
+    {
+        pxChunk = ( const xHUDViewRideLogChunk_t * )( pucFile + ullOffset );
+
+        if ( ulEntries == ulCapacity )
+        {
+            xHUDViewRideLogIndexEntry_t * pxGrown = NULL;
+
+            ulCapacity = ( 0 == ulCapacity ) ? 256 : ulCapacity * 2;
+            pxGrown = realloc( pxEntries, ulCapacity * sizeof( xHUDViewRideLogIndexEntry_t ) );
+
+            if ( NULL == pxGrown )
+            {
+                free( pxEntries );
+                return -1;
+            }
+
+            pxEntries = pxGrown;
+        }
+
+        pxEntries[ ulEntries ].llFirstMicroseconds = pxChunk->llFirstMicroseconds;
+        pxEntries[ ulEntries ].llLastMicroseconds = pxChunk->llLastMicroseconds;
+        pxEntries[ ulEntries ].ullOffset = ullOffset;
+        pxEntries[ ulEntries ].usStream = pxChunk->usStream;
+        pxEntries[ ulEntries ].usReserved = 0;
+        pxEntries[ ulEntries ].ulSamples = pxChunk->ulSamples;
+        ulEntries++;
+
+        ullOffset += sizeof( xHUDViewRideLogChunk_t ) + pxChunk->ulPayloadBytes;
+    }
+
+    *ppxEntries = pxEntries;
+    *pulEntries = ulEntries;
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint32_t ulHUDViewRideLogSeek( const xHUDViewRideLogIndexEntry_t * pxEntries, uint32_t ulEntries,
+                               int64_t llMicroseconds )
+{
+    uint32_t ulLow = 0;
+    uint32_t ulHigh = ulEntries;
+    uint32_t ulMiddle = 0;
+
+    /* First chunk of a single stream's (time-ordered) entries that ends at or after the requested time. */
+    while ( ulLow < ulHigh )
+    {
+        ulMiddle = ulLow + ( ulHigh - ulLow ) / 2;
+
+        if ( pxEntries[ ulMiddle ].llLastMicroseconds < llMicroseconds )
+        {
+            ulLow = ulMiddle + 1;
+        }
+        else
+        {
+            ulHigh = ulMiddle;
+        }
+    }
+
+    return ulLow;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogDecode( const uint8_t * pucFile, size_t ulFileSize, const xHUDViewRideLogIndexEntry_t * pxEntry,
+                           int64_t * pllMicroseconds, double * pdValues )
+{
+    const xHUDViewRideLogChunk_t * pxChunk = ( const xHUDViewRideLogChunk_t * )( pucFile + pxEntry->ullOffset );
+    const uint8_t * pucColumn = NULL;
+    xBitReader_t xReader;
+    int64_t llDelta = 0;
+    int iEncoding = 0;
+    int iColumn = 0;
+    uint32_t ulSample = 0;
+
+    if ( ( pxEntry->ullOffset + sizeof( xHUDViewRideLogChunk_t ) > ulFileSize )
+         || ( HUDVIEW_RIDELOG_CHUNK_MAGIC != pxChunk->ulMagic )
+         || ( pxEntry->ullOffset + sizeof( xHUDViewRideLogChunk_t ) + pxChunk->ulPayloadBytes > ulFileSize )
+         || ( HUDVIEW_RIDELOG_CHUNK_SAMPLES < pxChunk->ulSamples ) || ( 0 == pxChunk->ulSamples )
+         || ( HUDVIEW_RIDELOG_MAX_COLUMNS < pxChunk->usColumns ) )
+    {
+        return -1;
+    }
+
+    pucColumn = ( const uint8_t * )( pxChunk + 1 );
+
+    for ( iColumn = 0; iColumn <= pxChunk->usColumns; iColumn++ )
+    {
+        memset( &xReader, 0, sizeof( xReader ) );
+        xReader.pucData = pucColumn;
+        xReader.ulBytes = pxChunk->aulColumnBytes[ iColumn ];
+
+        if ( 0 == iColumn )
+        {
+            /* Timestamps: the first is in the header, then delta-of-delta codes. */
+            pllMicroseconds[ 0 ] = pxChunk->llFirstMicroseconds;
+            llDelta = 0;
+
+            for ( ulSample = 1; ulSample < pxChunk->ulSamples; ulSample++ )
+            {
+                if ( 0 == ullReadBits( &xReader, 1 ) )
+                {
+                    /* Same interval as before. */
+                }
+                else if ( 0 == ullReadBits( &xReader, 1 ) )
+                {
+                    llDelta += llSignExtend( ullReadBits( &xReader, 7 ), 7 );
+                }
+                else if ( 0 == ullReadBits( &xReader, 1 ) )
+                {
+                    llDelta += llSignExtend( ullReadBits( &xReader, 9 ), 9 );
+                }
+                else if ( 0 == ullReadBits( &xReader, 1 ) )
+                {
+                    llDelta += llSignExtend( ullReadBits( &xReader, 12 ), 12 );
+                }
+                else
+                {
+                    llDelta += ( int64_t )ullReadBits( &xReader, 64 );
+                }
+
+                pllMicroseconds[ ulSample ] = pllMicroseconds[ ulSample - 1 ] + llDelta;
+            }
+        }
+        else
+        {
+            iEncoding = ( int )( ( pxChunk->ulColumnEncodings >> ( 4 * ( iColumn - 1 ) ) ) & 0xF );
+
+            if ( 0 == iEncoding )
+            {
+                vDecodeDoubles( &xReader, &pdValues[ iColumn - 1 ], pxChunk->usColumns, pxChunk->ulSamples );
+            }
+            else
+            {
+                vDecodeDecimals( &xReader, &pdValues[ iColumn - 1 ], pxChunk->usColumns, pxChunk->ulSamples,
+                                 iEncoding - 1 );
+            }
+        }
+
+        pucColumn += pxChunk->aulColumnBytes[ iColumn ];
+    }
+
+    return ( int )pxChunk->ulSamples;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vWriteBits( xHUDViewRideLogBitWriter_t * pxWriter, uint64_t ullValue, int iCount )
+{
+    /* Bits go out most significant first; wide values are split so the accumulator never overflows. */
+    if ( 32 < iCount )
+    {
+        vWriteBits( pxWriter, ullValue >> 32, iCount - 32 );
+        iCount = 32;
+    }
+
+    pxWriter->ullAccumulator = ( pxWriter->ullAccumulator << iCount ) | ( ullValue & ( ( 1ULL << iCount ) - 1 ) );
+    pxWriter->iBits += iCount;
+
+    while ( 8 <= pxWriter->iBits )
+    {
+        pxWriter->iBits -= 8;
+        pxWriter->pucData[ pxWriter->ulBytes++ ] = ( uint8_t )( pxWriter->ullAccumulator >> pxWriter->iBits );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFinishBits( xHUDViewRideLogBitWriter_t * pxWriter )
+{
+    if ( 0 < pxWriter->iBits )
+    {
+        pxWriter->pucData[ pxWriter->ulBytes++ ] = ( uint8_t )( pxWriter->ullAccumulator << ( 8 - pxWriter->iBits ) );
+        pxWriter->iBits = 0;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint64_t ullReadBits( xBitReader_t * pxReader, int iCount )
+{
+    uint64_t ullReturn = 0;
+
+    if ( 32 < iCount )
+    {
+        ullReturn = ullReadBits( pxReader, iCount - 32 ) << 32;
+        iCount = 32;
+    }
+
+    while ( pxReader->iBits < iCount )
+    {
+        pxReader->ullAccumulator <<= 8;
+
+        /* A truncated column reads as zeros rather than running off the end of the chunk. */
+        if ( pxReader->ulPosition < pxReader->ulBytes )
+        {
+            pxReader->ullAccumulator |= pxReader->pucData[ pxReader->ulPosition++ ];
+        }
+
+        pxReader->iBits += 8;
+    }
+
+    pxReader->iBits -= iCount;
+
+    return ullReturn | ( ( pxReader->ullAccumulator >> pxReader->iBits ) & ( ( 1ULL << iCount ) - 1 ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llSignExtend( uint64_t ullValue, int iBits )
+{
+    uint64_t ullSign = 1ULL << ( iBits - 1 );
+
+    return ( int64_t )( ( ullValue ^ ullSign ) - ullSign );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vEncodeTimestamps( xHUDViewRideLogBitWriter_t * pxColumn, const int64_t * pllMicroseconds,
+                               uint32_t ulSamples )
+{
+    int64_t llPreviousDelta = 0;
+    int64_t llDelta = 0;
+    int64_t llDeltaOfDelta = 0;
+    uint32_t ulSample = 0;
+
+    /* The chunk header carries the first timestamp. */
+    for ( ulSample = 1; ulSample < ulSamples; ulSample++ )
+    {
+        llDelta = pllMicroseconds[ ulSample ] - pllMicroseconds[ ulSample - 1 ];
+        llDeltaOfDelta = llDelta - llPreviousDelta;
+        llPreviousDelta = llDelta;
+
+        /* Regular sample intervals collapse to a single bit; jitter costs progressively wider codes. */
+        if ( 0 == llDeltaOfDelta )
+        {
+            vWriteBits( pxColumn, 0x0, 1 );
+        }
+        else if ( ( -64 <= llDeltaOfDelta ) && ( 63 >= llDeltaOfDelta ) )
+        {
+            vWriteBits( pxColumn, 0x2, 2 );
+            vWriteBits( pxColumn, ( uint64_t )llDeltaOfDelta, 7 );
+        }
+        else if ( ( -256 <= llDeltaOfDelta ) && ( 255 >= llDeltaOfDelta ) )
+        {
+            vWriteBits( pxColumn, 0x6, 3 );
+            vWriteBits( pxColumn, ( uint64_t )llDeltaOfDelta, 9 );
+        }
+        else if ( ( -2048 <= llDeltaOfDelta ) && ( 2047 >= llDeltaOfDelta ) )
+        {
+            vWriteBits( pxColumn, 0xE, 4 );
+            vWriteBits( pxColumn, ( uint64_t )llDeltaOfDelta, 12 );
+        }
+        else
+        {
+            vWriteBits( pxColumn, 0xF, 4 );
+            vWriteBits( pxColumn, ( uint64_t )llDeltaOfDelta, 64 );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iFindDecimals( const double * pdValues, int iStride, uint32_t ulSamples )
+{
+    double dScaled = 0.0;
+    double dRestored = 0.0;
+    int iDecimals = 0;
+    uint32_t ulSample = 0;
+
+    /* Find the fewest decimal digits that reproduce every sample bit for bit, as a value parsed from "%.Nf" does. */
+    for ( iDecimals = 0; iDecimals <= HUDVIEW_RIDELOG_MAX_DECIMALS; iDecimals++ )
+    {
+        for ( ulSample = 0; ulSample < ulSamples; ulSample++ )
+        {
+            dScaled = pdValues[ ulSample * iStride ] * adPowersOfTen[ iDecimals ];
+
+            /* Beyond 2^53 integers are no longer exact, and NaN fails the comparison. */
+            if ( !( ( -9e15 < dScaled ) && ( 9e15 > dScaled ) ) )
+            {
+                break;
+            }
+
+            dRestored = ( double )( int64_t )( dScaled + ( ( 0.0 <= dScaled ) ? 0.5 : -0.5 ) );
+            dRestored /= adPowersOfTen[ iDecimals ];
+
+            if ( 0 != memcmp( &dRestored, &pdValues[ ulSample * iStride ], sizeof( double ) ) )
+            {
+                break;
+            }
+        }
+
+        if ( ulSample == ulSamples )
+        {
+            return iDecimals;
+        }
+    }
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vEncodeDecimals( xHUDViewRideLogBitWriter_t * pxColumn, const double * pdValues, int iStride,
+                             uint32_t ulSamples, int iDecimals )
+{
+    double dScaled = 0.0;
+    int64_t llPrevious = 0;
+    int64_t llValue = 0;
+    uint64_t ullZigZag = 0;
+    int iBits = 0;
+    uint32_t ulSample = 0;
+
+    for ( ulSample = 0; ulSample < ulSamples; ulSample++ )
+    {
+        dScaled = pdValues[ ulSample * iStride ] * adPowersOfTen[ iDecimals ];
+        llValue = ( int64_t )( dScaled + ( ( 0.0 <= dScaled ) ? 0.5 : -0.5 ) );
+
+        if ( 0 == ulSample )
+        {
+            vWriteBits( pxColumn, ( uint64_t )llValue, 64 );
+        }
+        else if ( llValue == llPrevious )
+        {
+            vWriteBits( pxColumn, 0x0, 1 );
+        }
+        else
+        {
+            /* Small steps of either sign get short codes: a 6-bit length followed by the zigzagged difference. */
+            ullZigZag = ( ( uint64_t )( llValue - llPrevious ) << 1 ) ^ ( uint64_t )( ( llValue - llPrevious ) >> 63 );
+            iBits = 64 - __builtin_clzll( ullZigZag );
+            vWriteBits( pxColumn, 0x1, 1 );
+            vWriteBits( pxColumn, ( uint64_t )( iBits - 1 ), 6 );
+            vWriteBits( pxColumn, ullZigZag, iBits );
+        }
+
+        llPrevious = llValue;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vEncodeDoubles( xHUDViewRideLogBitWriter_t * pxColumn, const double * pdValues, int iStride,
+                            uint32_t ulSamples )
+{
+    uint64_t ullPrevious = 0;
+    uint64_t ullValue = 0;
+    uint64_t ullXor = 0;
+    int iPreviousLeading = -1;
+    int iPreviousTrailing = 0;
+    int iLeading = 0;
+    int iTrailing = 0;
+    int iMeaningful = 0;
+    uint32_t ulSample = 0;
+
+    memcpy( &ullPrevious, &pdValues[ 0 ], sizeof( ullPrevious ) );
+    vWriteBits( pxColumn, ullPrevious, 64 );
+
+    for ( ulSample = 1; ulSample < ulSamples; ulSample++ )
+    {
+        memcpy( &ullValue, &pdValues[ ulSample * iStride ], sizeof( ullValue ) );
+        ullXor = ullValue ^ ullPrevious;
+        ullPrevious = ullValue;
+
+        if ( 0 == ullXor )
+        {
+            vWriteBits( pxColumn, 0x0, 1 );
+            continue;
+        }
+
+        iLeading = __builtin_clzll( ullXor );
+        iTrailing = __builtin_ctzll( ullXor );
+
+        /* The leading count has five bits to live in. */
+        if ( 31 < iLeading )
+        {
+            iLeading = 31;
+        }
+
+        if ( ( 0 <= iPreviousLeading ) && ( iLeading >= iPreviousLeading ) && ( iTrailing >= iPreviousTrailing ) )
+        {
+            /* The changed bits fit in the previous window, so reuse it. */
+            iMeaningful = 64 - iPreviousLeading - iPreviousTrailing;
+            vWriteBits( pxColumn, 0x2, 2 );
+            vWriteBits( pxColumn, ullXor >> iPreviousTrailing, iMeaningful );
+        }
+        else
+        {
+            iMeaningful = 64 - iLeading - iTrailing;
+            vWriteBits( pxColumn, 0x3, 2 );
+            vWriteBits( pxColumn, ( uint64_t )iLeading, 5 );
+            vWriteBits( pxColumn, ( uint64_t )( iMeaningful - 1 ), 6 );
+            vWriteBits( pxColumn, ullXor >> iTrailing, iMeaningful );
+            iPreviousLeading = iLeading;
+            iPreviousTrailing = iTrailing;
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDecodeDecimals( xBitReader_t * pxReader, double * pdValues, int iStride, uint32_t ulSamples,
+                             int iDecimals )
+{
+    int64_t llValue = ( int64_t )ullReadBits( pxReader, 64 );
+    uint64_t ullZigZag = 0;
+    uint32_t ulSample = 0;
+
+    pdValues[ 0 ] = ( double )llValue / adPowersOfTen[ iDecimals ];
+
+    for ( ulSample = 1; ulSample < ulSamples; ulSample++ )
+    {
+        if ( 0 != ullReadBits( pxReader, 1 ) )
+        {
+            ullZigZag = ullReadBits( pxReader, ( int )ullReadBits( pxReader, 6 ) + 1 );
+            llValue += ( int64_t )( ( ullZigZag >> 1 ) ^ ( 0 - ( ullZigZag & 1 ) ) );
+        }
+
+        pdValues[ ulSample * iStride ] = ( double )llValue / adPowersOfTen[ iDecimals ];
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDecodeDoubles( xBitReader_t * pxReader, double * pdValues, int iStride, uint32_t ulSamples )
+{
+    uint64_t ullPrevious = ullReadBits( pxReader, 64 );
+    int iLeading = 0;
+    int iMeaningful = 64;
+    uint32_t ulSample = 0;
+
+    memcpy( &pdValues[ 0 ], &ullPrevious, sizeof( double ) );
+
+    for ( ulSample = 1; ulSample < ulSamples; ulSample++ )
+    {
+        if ( 0 != ullReadBits( pxReader, 1 ) )
+        {
+            if ( 0 != ullReadBits( pxReader, 1 ) )
+            {
+                iLeading = ( int )ullReadBits( pxReader, 5 );
+                iMeaningful = ( int )ullReadBits( pxReader, 6 ) + 1;
+            }
+
+            ullPrevious ^= ullReadBits( pxReader, iMeaningful ) << ( 64 - iLeading - iMeaningful );
+        }
+
+        memcpy( &pdValues[ ulSample * iStride ], &ullPrevious, sizeof( double ) );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iFlushStream( xHUDViewRideLogWriter_t * pxWriter, eHUDViewRideLogStream_t eStream )
+{
+    xHUDViewRideLogStreamState_t * pxState = &pxWriter->axStreams[ eStream ];
+    struct iovec axVectors[ HUDVIEW_RIDELOG_MAX_COLUMNS + 2 ];
+    xHUDViewRideLogChunk_t xChunk;
+    int iColumns = aiStreamColumns[ eStream ];
+    int iColumn = 0;
+    int iDecimals = 0;
+    uint32_t ulFNV = 2166136261UL;
+    size_t ulByte = 0;
+    size_t ulTotal = 0;
+    ssize_t lWritten = 0;
+
+    if ( 0 == pxState->ulSamples )
+    {
+        return 0;
+    }
+
+    memset( &xChunk, 0, sizeof( xChunk ) );
+    xChunk.ulMagic = HUDVIEW_RIDELOG_CHUNK_MAGIC;
+    xChunk.usStream = ( uint16_t )eStream;
+    xChunk.usColumns = ( uint16_t )iColumns;
+    xChunk.ulSamples = pxState->ulSamples;
+    xChunk.llFirstMicroseconds = pxState->pllMicroseconds[ 0 ];
+    xChunk.llLastMicroseconds = pxState->pllMicroseconds[ pxState->ulSamples - 1 ];
+    axVectors[ 0 ].iov_base = &xChunk;
+    axVectors[ 0 ].iov_len = sizeof( xChunk );
+
+    vEncodeTimestamps( &pxState->axColumns[ 0 ], pxState->pllMicroseconds, pxState->ulSamples );
+
+    /* Each column is stored exactly; the decimal form is chosen wherever it reproduces every sample. */
+    for ( iColumn = 0; iColumn < iColumns; iColumn++ )
+    {
+        iDecimals = iFindDecimals( &pxState->pdValues[ iColumn ], iColumns, pxState->ulSamples );
+
+        if ( 0 <= iDecimals )
+        {
+            vEncodeDecimals( &pxState->axColumns[ iColumn + 1 ], &pxState->pdValues[ iColumn ], iColumns,
+                             pxState->ulSamples, iDecimals );
+            xChunk.ulColumnEncodings |= ( uint32_t )( iDecimals + 1 ) << ( 4 * iColumn );
+        }
+        else
+        {
+            vEncodeDoubles( &pxState->axColumns[ iColumn + 1 ], &pxState->pdValues[ iColumn ], iColumns,
+                            pxState->ulSamples );
+        }
+    }
+
+    for ( iColumn = 0; iColumn <= iColumns; iColumn++ )
+    {
+        xHUDViewRideLogBitWriter_t * pxColumn = &pxState->axColumns[ iColumn ];
+
+        vFinishBits( pxColumn );
+        xChunk.aulColumnBytes[ iColumn ] = ( uint32_t )pxColumn->ulBytes;
+        xChunk.ulPayloadBytes += ( uint32_t )pxColumn->ulBytes;
+
+        for ( ulByte = 0; ulByte < pxColumn->ulBytes; ulByte++ )
+        {
+            ulFNV = ( ulFNV ^ pxColumn->pucData[ ulByte ] ) * 16777619UL;
+        }
+
+        axVectors[ iColumn + 1 ].iov_base = pxColumn->pucData;
+        axVectors[ iColumn + 1 ].iov_len = pxColumn->ulBytes;
+    }
+
+    xChunk.ulChecksum = ulFNV;
+    ulTotal = sizeof( xChunk ) + xChunk.ulPayloadBytes;
+
+    /* One append per chunk keeps SD card writes large and infrequent. */
+    do
+    {
+        lWritten = writev( pxWriter->iDescriptor, axVectors, iColumns + 2 );
+    } while ( ( -1 == lWritten ) && ( EINTR == errno ) );
+
+    if ( ( ssize_t )ulTotal != lWritten )
+    {
+        return -1;
+    }
+
+    if ( pxWriter->ulIndexEntries == pxWriter->ulIndexCapacity )
+    {
+        xHUDViewRideLogIndexEntry_t * pxGrown = NULL;
+        uint32_t ulCapacity = ( 0 == pxWriter->ulIndexCapacity ) ? 256 : pxWriter->ulIndexCapacity * 2;
+
+        pxGrown = realloc( pxWriter->pxIndex, ulCapacity * sizeof( xHUDViewRideLogIndexEntry_t ) );
+
+        if ( NULL == pxGrown )
+        {
+            return -1;
+        }
+
+        pxWriter->pxIndex = pxGrown;
+        pxWriter->ulIndexCapacity = ulCapacity;
+    }
+
+    pxWriter->pxIndex[ pxWriter->ulIndexEntries ].llFirstMicroseconds = xChunk.llFirstMicroseconds;
+    pxWriter->pxIndex[ pxWriter->ulIndexEntries ].llLastMicroseconds = xChunk.llLastMicroseconds;
+    pxWriter->pxIndex[ pxWriter->ulIndexEntries ].ullOffset = pxWriter->ullOffset;
+    pxWriter->pxIndex[ pxWriter->ulIndexEntries ].usStream = xChunk.usStream;
+    pxWriter->pxIndex[ pxWriter->ulIndexEntries ].usReserved = 0;
+    pxWriter->pxIndex[ pxWriter->ulIndexEntries ].ulSamples = xChunk.ulSamples;
+    pxWriter->ulIndexEntries++;
+    pxWriter->ullOffset += ulTotal;
+
+    /* Start the next chunk afresh. */
+    for ( iColumn = 0; iColumn <= iColumns; iColumn++ )
+    {
+        pxState->axColumns[ iColumn ].ulBytes = 0;
+        pxState->axColumns[ iColumn ].ullAccumulator = 0;
+        pxState->axColumns[ iColumn ].iBits = 0;
+    }
+
+    pxState->ulSamples = 0;
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iWriteAll( int iDescriptor, const void * pvData, size_t ulBytes )
+{
+    const uint8_t * pucData = ( const uint8_t * )pvData;
+    ssize_t lWritten = 0;
+
+    while ( 0 < ulBytes )
+    {
+        lWritten = write( iDescriptor, pucData, ulBytes );
+
+        if ( 0 > lWritten )
+        {
+            if ( EINTR == errno )
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        pucData += lWritten;
+        ulBytes -= ( size_t )lWritten;
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t ulChecksum( const uint8_t * pucData, size_t ulBytes )
+{
+    uint32_t ulHash = 2166136261UL;
+    size_t ulByte = 0;
+
+    for ( ulByte = 0; ulByte < ulBytes; ulByte++ )
+    {
+        ulHash = ( ulHash ^ pucData[ ulByte ] ) * 16777619UL;
+    }
+
+    return ulHash;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bChunkValid( const uint8_t * pucFile, size_t ulFileSize, uint64_t ullOffset )
+{
+    const xHUDViewRideLogChunk_t * pxChunk = ( const xHUDViewRideLogChunk_t * )( pucFile + ullOffset );
+    uint32_t ulColumnTotal = 0;
+    int iColumn = 0;
+
+    if ( ( ullOffset + sizeof( xHUDViewRideLogChunk_t ) > ulFileSize )
+         || ( HUDVIEW_RIDELOG_CHUNK_MAGIC != pxChunk->ulMagic )
+         || ( iHUDViewRideLogColumns( ( eHUDViewRideLogStream_t )pxChunk->usStream ) != pxChunk->usColumns )
+         || ( 0 == pxChunk->ulSamples ) || ( HUDVIEW_RIDELOG_CHUNK_SAMPLES < pxChunk->ulSamples )
+         || ( ullOffset + sizeof( xHUDViewRideLogChunk_t ) + pxChunk->ulPayloadBytes > ulFileSize ) )
+    {
+        return 0;
+    }
+
+    for ( iColumn = 0; iColumn <= pxChunk->usColumns; iColumn++ )
+    {
+        ulColumnTotal += pxChunk->aulColumnBytes[ iColumn ];
+    }
+
+    return ( ulColumnTotal == pxChunk->ulPayloadBytes )
+           && ( ulChecksum( ( const uint8_t * )( pxChunk + 1 ), pxChunk->ulPayloadBytes ) == pxChunk->ulChecksum );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,135 @@
+/** @file hudview_ridelog.h
+ *  @brief HUDView columnar ride log format.
+ *
+ *  A ride log keeps the long-term telemetry history of a ride compactly enough to live on the SD card. Samples of
+ *  each stream (accelerometer, GPS, light sensor) are gathered into chunks of up to HUDVIEW_RIDELOG_CHUNK_SAMPLES
+ *  samples or HUDVIEW_RIDELOG_CHUNK_SPAN_US of time, and each chunk stores its columns separately:
+ *
+ *  - timestamps (microseconds since the epoch) as Gorilla-style delta-of-delta bit codes,
+ *  - value columns whose samples are all exact decimals of up to HUDVIEW_RIDELOG_MAX_DECIMALS digits, which is what
+ *    the components print, as variable-length deltas of the scaled integers,
+ *  - any other value column as Gorilla-style XOR-compressed doubles.
+ *
+ *  Chunks are written with a single write each, so the card sees a few large appends rather than a stream of small
+ *  ones. When the log is closed a time index of every chunk and a footer pointing at it are appended; a log that
+ *  was never closed is still readable, since every chunk header is self-describing and checksummed and the index can
+ *  be rebuilt by walking them.
+ */
+
+#ifndef HUDVIEW_RIDELOG_H
+#define HUDVIEW_RIDELOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_RIDELOG_MAGIC               ( 0x4C525648UL )
+#define HUDVIEW_RIDELOG_CHUNK_MAGIC         ( 0x4B435648UL )
+#define HUDVIEW_RIDELOG_INDEX_MAGIC         ( 0x49525648UL )
+#define HUDVIEW_RIDELOG_VERSION             ( 1 )
+#define HUDVIEW_RIDELOG_CHUNK_SAMPLES       ( 1024 )
+#define HUDVIEW_RIDELOG_CHUNK_SPAN_US       ( 60LL * 1000000LL )
+#define HUDVIEW_RIDELOG_MAX_COLUMNS         ( 5 )
+#define HUDVIEW_RIDELOG_MAX_DECIMALS        ( 6 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eHUDViewRideLogStreamMin = 0,
+
+    eHUDViewRideLogStream_Accelerometer,
+    eHUDViewRideLogStream_GPS,
+    eHUDViewRideLogStream_LightSensor,
+
+    eHUDViewRideLogStreamMax
+} eHUDViewRideLogStream_t;
+
+typedef struct {
+    uint32_t ulMagic;
+    uint32_t ulVersion;
+    int64_t llCreatedMicroseconds;
+} xHUDViewRideLogHeader_t;
+
+typedef struct {
+    uint32_t ulMagic;
+    uint16_t usStream;
+    uint16_t usColumns;
+    uint32_t ulSamples;
+    uint32_t ulPayloadBytes;
+    int64_t llFirstMicroseconds;
+    int64_t llLastMicroseconds;
+    uint32_t ulChecksum;
+    uint32_t aulColumnBytes[ HUDVIEW_RIDELOG_MAX_COLUMNS + 1 ];
+
+    /* Four bits per value column: 0 for XOR-compressed doubles, 1 + d for decimals with d digits. */
+    uint32_t ulColumnEncodings;
+} xHUDViewRideLogChunk_t;
+
+typedef struct {
+    int64_t llFirstMicroseconds;
+    int64_t llLastMicroseconds;
+    uint64_t ullOffset;
+    uint16_t usStream;
+    uint16_t usReserved;
+    uint32_t ulSamples;
+} xHUDViewRideLogIndexEntry_t;
+
+typedef struct {
+    uint32_t ulMagic;
+    uint32_t ulEntries;
+    uint64_t ullIndexOffset;
+} xHUDViewRideLogFooter_t;
+
+/* Bit-level column being built; the buffer is sized for a full chunk of worst-case codes up front. */
+typedef struct {
+    uint8_t * pucData;
+    size_t ulBytes;
+    uint64_t ullAccumulator;
+    int iBits;
+} xHUDViewRideLogBitWriter_t;
+
+/* Samples of the chunk being gathered; they are encoded when it is flushed, once each column's precision is known. */
+typedef struct {
+    uint32_t ulSamples;
+    int64_t * pllMicroseconds;
+    double * pdValues;
+    xHUDViewRideLogBitWriter_t axColumns[ HUDVIEW_RIDELOG_MAX_COLUMNS + 1 ];
+} xHUDViewRideLogStreamState_t;
+
+typedef struct {
+    int iDescriptor;
+    uint64_t ullOffset;
+    xHUDViewRideLogStreamState_t axStreams[ eHUDViewRideLogStreamMax ];
+    xHUDViewRideLogIndexEntry_t * pxIndex;
+    uint32_t ulIndexEntries;
+    uint32_t ulIndexCapacity;
+    uint64_t ullSamples;
+    uint64_t ullRawBytes;
+} xHUDViewRideLogWriter_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewRideLogColumns( eHUDViewRideLogStream_t eStream );
+const char * pcHUDViewRideLogStreamName( eHUDViewRideLogStream_t eStream );
+
+int iHUDViewRideLogOpen( xHUDViewRideLogWriter_t * pxWriter, const char * pcPath );
+int iHUDViewRideLogAppend( xHUDViewRideLogWriter_t * pxWriter, eHUDViewRideLogStream_t eStream,
+                           int64_t llMicroseconds, const double * pdValues );
+int iHUDViewRideLogFlush( xHUDViewRideLogWriter_t * pxWriter );
+int iHUDViewRideLogClose( xHUDViewRideLogWriter_t * pxWriter );
+
+int iHUDViewRideLogLoadIndex( const uint8_t * pucFile, size_t ulFileSize, xHUDViewRideLogIndexEntry_t ** ppxEntries,
+                              uint32_t * pulEntries );
+uint32_t ulHUDViewRideLogSeek( const xHUDViewRideLogIndexEntry_t * pxEntries, uint32_t ulEntries,
+                               int64_t llMicroseconds );
+int iHUDViewRideLogDecode( const uint8_t * pucFile, size_t ulFileSize, const xHUDViewRideLogIndexEntry_t * pxEntry,
+                           int64_t * pllMicroseconds, double * pdValues );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_RIDELOG_H
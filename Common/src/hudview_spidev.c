@@ -0,0 +1,857 @@
+/** @file hudview_spidev.c
+ *  @brief HUDView ST7735 link over spidev.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_rgb444.h"
+#include "hudview_spidev.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Probing writes and reads back a small window in the top left corner, before anything else is drawn. */
+#define PROBE_WIDTH         ( 32 )
+#define PROBE_HEIGHT        ( 4 )
+#define PROBE_PIXELS        ( PROBE_WIDTH * PROBE_HEIGHT )
+
+/* RAMRD answers three bytes a pixel after a dummy clock cycle, so a little more is read and the pattern is looked
+ * for at every bit offset. */
+#define PROBE_READ_BYTES    ( PROBE_PIXELS * 3 + 2 )
+#define PROBE_MAXIMUM_SHIFT ( 16 )
+
+/* The first byte of every line of the table is a command, then its argument count and arguments; a count with this
+ * bit set is followed by a delay in milliseconds. */
+#define INIT_DELAY          ( 0x80 )
+
+/* The stand-in garbles every this many bytes written above its stable clock. */
+#define STANDIN_GARBLE_EVERY ( 7 )
+
+/* A 12-bit pixel's four bits a channel, as the panel widens them to six. */
+#define WIDEN_NIBBLE( iNibble ) ( ( ( iNibble ) << 2 ) | ( ( iNibble ) >> 2 ) )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+struct xHUDViewSpidevPanel {
+    unsigned long ulStableHz;
+    unsigned long ulGarble;
+    uint8_t ucCommand;
+    int iArgument;
+    uint8_t aucArguments[ 4 ];
+    int aiColumns[ 2 ];
+    int aiRows[ 2 ];
+    int iColumn;
+    int iRow;
+    int b12Bit;
+    uint8_t aucPartial[ 3 ];
+    int iPartial;
+
+    /* Each pixel as the panel holds it, six bits a channel. */
+    uint8_t aucMemory[ HUDVIEW_SPIDEV_WIDTH * HUDVIEW_SPIDEV_HEIGHT * 3 ];
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* The ST7735R bring-up: out of sleep, frame rate, power and gamma as the display library set them, landscape
+ * (MX | MV, as st7735_setRotation( 1 )), 16 bits a pixel, and on. */
+static const uint8_t aucInit[] = {
+    0x01, INIT_DELAY | 0, 150,
+    0x11, INIT_DELAY | 0, 255,
+    0xB1, 3, 0x01, 0x2C, 0x2D,
+    0xB2, 3, 0x01, 0x2C, 0x2D,
+    0xB3, 6, 0x01, 0x2C, 0x2D, 0x01, 0x2C, 0x2D,
+    0xB4, 1, 0x07,
+    0xC0, 3, 0xA2, 0x02, 0x84,
+    0xC1, 1, 0xC5,
+    0xC2, 2, 0x0A, 0x00,
+    0xC3, 2, 0x8A, 0x2A,
+    0xC4, 2, 0x8A, 0xEE,
+    0xC5, 1, 0x0E,
+    0x20, 0,
+    0x36, 1, 0x60,
+    HUDVIEW_SPIDEV_COLMOD, 1, HUDVIEW_RGB444_COLMOD_16BIT,
+    0xE0, 16, 0x02, 0x1C, 0x07, 0x12, 0x37, 0x32, 0x29, 0x2D, 0x29, 0x25, 0x2B, 0x39, 0x00, 0x01, 0x03, 0x10,
+    0xE1, 16, 0x03, 0x1D, 0x07, 0x06, 0x2E, 0x2C, 0x29, 0x2D, 0x2E, 0x2E, 0x37, 0x3F, 0x00, 0x00, 0x02, 0x10,
+    0x13, INIT_DELAY | 0, 10,
+    0x29, INIT_DELAY | 0, 100
+};
+
+/* Dividers of the core clock the probe tries, fastest first. */
+static const unsigned long aulDividers[] = { 4, 6, 8, 10, 12, 14, 16, 20, 24, 32 };
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vReset( xHUDViewSpidev_t * pxLink );
+static int iSetLines( xHUDViewSpidev_t * pxLink, int iDataMode, int iReset );
+static int iSetDataMode( xHUDViewSpidev_t * pxLink, int iDataMode );
+static int iQueue( xHUDViewSpidev_t * pxLink, const uint8_t * pucData, size_t ulBytes, int bCopy );
+static int iSend( xHUDViewSpidev_t * pxLink, struct spi_ioc_transfer * pxTransfers, int iTransfers );
+static int iRead( xHUDViewSpidev_t * pxLink, uint8_t ucCommand, uint8_t * pucData, size_t ulBytes );
+static int bProbeRound( xHUDViewSpidev_t * pxLink, unsigned long ulClockHz, unsigned int uiSeed );
+static void vSleepMilliseconds( const xHUDViewSpidev_t * pxLink, int iMilliseconds );
+static int iCompareRegions( const void * pvA, const void * pvB );
+static void vPanelWrite( xHUDViewSpidevPanel_t * pxPanel, int iDataMode, unsigned long ulClockHz,
+                         const uint8_t * pucData, size_t ulBytes );
+static void vPanelPixel( xHUDViewSpidevPanel_t * pxPanel, int iRed, int iGreen, int iBlue );
+static void vPanelRead( const xHUDViewSpidevPanel_t * pxPanel, uint8_t * pucData, size_t ulBytes );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevOpen( xHUDViewSpidev_t * pxLink, const char * pcDevice, unsigned long ulClockHz )
+{
+    struct gpio_v2_line_request xRequest;
+    uint8_t ucMode = SPI_MODE_0;
+    uint8_t ucBits = 8;
+    int iChip = -1;
+    int iReturn = -1;
+    FILE * pFile = NULL;
+
+    vReset( pxLink );
+    pxLink->ulClockHz = ulClockHz;
+    pxLink->iSPI = open( pcDevice, O_RDWR | O_CLOEXEC );
+
+    /* A larger bufsiz (spidev.bufsiz= on the kernel command line) means fewer messages a frame. */
+    pFile = fopen( HUDVIEW_SPIDEV_BUFSIZ_PATH, "r" );
+
+    if ( NULL != pFile )
+    {
+        unsigned long ulBufferSize = 0;
+
+        if ( ( 1 == fscanf( pFile, "%lu", &ulBufferSize ) ) && ( 0 < ulBufferSize ) )
+        {
+            pxLink->ulBufferSize = ulBufferSize;
+        }
+
+        fclose( pFile );
+    }
+
+    memset( &xRequest, 0, sizeof( xRequest ) );
+    xRequest.offsets[ 0 ] = HUDVIEW_SPIDEV_DC_LINE;
+    xRequest.offsets[ 1 ] = HUDVIEW_SPIDEV_RESET_LINE;
+    xRequest.num_lines = 2;
+    xRequest.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+    snprintf( xRequest.consumer, sizeof( xRequest.consumer ), "hudview-display" );
+
+    if ( ( 0 <= pxLink->iSPI )
+         && ( 0 <= ioctl( pxLink->iSPI, SPI_IOC_WR_MODE, &ucMode ) )
+         && ( 0 <= ioctl( pxLink->iSPI, SPI_IOC_WR_BITS_PER_WORD, &ucBits ) )
+         && ( 0 == iHUDViewSpidevSetClock( pxLink, ulClockHz ) )
+         && ( 0 <= ( iChip = open( HUDVIEW_SPIDEV_GPIO_CHIP, O_RDWR | O_CLOEXEC ) ) )
+         && ( 0 <= ioctl( iChip, GPIO_V2_GET_LINE_IOCTL, &xRequest ) ) )
+    {
+        pxLink->iLines = xRequest.fd;
+        iReturn = 0;
+    }
+
+    if ( 0 <= iChip )
+    {
+        close( iChip );
+    }
+
+    if ( 0 != iReturn )
+    {
+        int iError = errno;
+
+        vHUDViewSpidevClose( pxLink );
+        errno = iError;
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevOpenStandIn( xHUDViewSpidev_t * pxLink, unsigned long ulClockHz, size_t ulBufferSize )
+{
+    int iReturn = -1;
+
+    vReset( pxLink );
+    pxLink->ulClockHz = ulClockHz;
+    pxLink->ulBufferSize = ( 0 < ulBufferSize ) ? ulBufferSize : HUDVIEW_SPIDEV_DEFAULT_BUFSIZ;
+    pxLink->pxPanel = calloc( 1, sizeof( xHUDViewSpidevPanel_t ) );
+
+    if ( NULL != pxLink->pxPanel )
+    {
+        pxLink->pxPanel->ulStableHz = HUDVIEW_SPIDEV_STANDIN_STABLE_HZ;
+        pxLink->pxPanel->aiColumns[ 1 ] = HUDVIEW_SPIDEV_WIDTH - 1;
+        pxLink->pxPanel->aiRows[ 1 ] = HUDVIEW_SPIDEV_HEIGHT - 1;
+        iReturn = 0;
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewSpidevClose( xHUDViewSpidev_t * pxLink )
+{
+    if ( 0 <= pxLink->iSPI )
+    {
+        close( pxLink->iSPI );
+    }
+
+    if ( 0 <= pxLink->iLines )
+    {
+        close( pxLink->iLines );
+    }
+
+    free( pxLink->pxPanel );
+    pxLink->iSPI = -1;
+    pxLink->iLines = -1;
+    pxLink->pxPanel = NULL;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewSpidevSetBatch( xHUDViewSpidev_t * pxLink, int bBatch )
+{
+    ( void )iHUDViewSpidevFlush( pxLink );
+    pxLink->bBatch = bBatch;
+    pxLink->aiWindow[ 0 ] = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevSetClock( xHUDViewSpidev_t * pxLink, unsigned long ulClockHz )
+{
+    uint32_t ulMaximumHz = ( uint32_t )ulClockHz;
+    int iReturn = iHUDViewSpidevFlush( pxLink );
+
+    /* Each transfer carries the clock too, but the device's maximum caps it. */
+    if ( ( 0 == iReturn ) && ( 0 <= pxLink->iSPI ) && ( 0 > ioctl( pxLink->iSPI, SPI_IOC_WR_MAX_SPEED_HZ,
+                                                                     &ulMaximumHz ) ) )
+    {
+        iReturn = -1;
+    }
+
+    if ( 0 == iReturn )
+    {
+        pxLink->ulClockHz = ulClockHz;
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevInitPanel( xHUDViewSpidev_t * pxLink )
+{
+    size_t ulIndex = 0;
+    int iReturn = iHUDViewSpidevFlush( pxLink );
+
+    /* A hardware reset first, so the panel starts from a known state whatever ran before. */
+    if ( 0 == iReturn )
+    {
+        iReturn = iSetLines( pxLink, 1, 0 );
+        vSleepMilliseconds( pxLink, 20 );
+    }
+
+    if ( 0 == iReturn )
+    {
+        iReturn = iSetLines( pxLink, 1, 1 );
+        vSleepMilliseconds( pxLink, 150 );
+    }
+
+    while ( ( 0 == iReturn ) && ( ulIndex + 1 < sizeof( aucInit ) ) )
+    {
+        uint8_t ucCommand = aucInit[ ulIndex ];
+        size_t ulArguments = aucInit[ ulIndex + 1 ] & ~INIT_DELAY;
+        int bDelay = ( 0 != ( aucInit[ ulIndex + 1 ] & INIT_DELAY ) );
+
+        iReturn = iHUDViewSpidevCommand( pxLink, ucCommand, &aucInit[ ulIndex + 2 ], ulArguments );
+        ulIndex += 2 + ulArguments;
+
+        if ( ( 0 == iReturn ) && bDelay )
+        {
+            iReturn = iHUDViewSpidevFlush( pxLink );
+            vSleepMilliseconds( pxLink, aucInit[ ulIndex ] );
+            ulIndex++;
+        }
+    }
+
+    pxLink->aiWindow[ 0 ] = -1;
+    pxLink->b12Bit = 0;
+
+    return ( 0 == iReturn ) ? iHUDViewSpidevFlush( pxLink ) : iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long ulHUDViewSpidevProbeClock( xHUDViewSpidev_t * pxLink, unsigned long ulMaximumHz )
+{
+    const size_t ulDividers = sizeof( aulDividers ) / sizeof( aulDividers[ 0 ] );
+    unsigned long ulClockHz = pxLink->ulClockHz;
+    unsigned long ulReturn = 0;
+    int bReadable = bProbeRound( pxLink, HUDVIEW_SPIDEV_READ_CLOCK_HZ, 0 );
+
+    /* Without a working read back at the read clock itself there is nothing to probe with. */
+    for ( size_t ulDivider = 0; bReadable && ( 0 == ulReturn ) && ( ulDivider < ulDividers ); ulDivider++ )
+    {
+        unsigned long ulCandidateHz = HUDVIEW_SPIDEV_CORE_CLOCK_HZ / aulDividers[ ulDivider ];
+        int bStable = ( ulCandidateHz <= ulMaximumHz );
+
+        for ( unsigned int uiRound = 1; bStable && ( uiRound <= HUDVIEW_SPIDEV_PROBE_ROUNDS ); uiRound++ )
+        {
+            bStable = bProbeRound( pxLink, ulCandidateHz, uiRound + ( unsigned int )ulDivider * 16 );
+        }
+
+        if ( bStable )
+        {
+            ulReturn = HUDVIEW_SPIDEV_CORE_CLOCK_HZ / aulDividers[ ( ulDivider + 1 < ulDividers ) ? ulDivider + 1
+                                                                                                   : ulDivider ];
+        }
+    }
+
+    ( void )iHUDViewSpidevSetClock( pxLink, ulClockHz );
+    pxLink->aiWindow[ 0 ] = -1;
+
+    return ulReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevCommand( xHUDViewSpidev_t * pxLink, uint8_t ucCommand, const uint8_t * pucArguments,
+                           size_t ulArguments )
+{
+    int iReturn = iSetDataMode( pxLink, 0 );
+
+    if ( 0 == iReturn )
+    {
+        iReturn = iQueue( pxLink, &ucCommand, 1, 1 );
+    }
+
+    if ( ( 0 == iReturn ) && ( 0 < ulArguments ) )
+    {
+        iReturn = iSetDataMode( pxLink, 1 );
+    }
+
+    if ( ( 0 == iReturn ) && ( 0 < ulArguments ) )
+    {
+        iReturn = iQueue( pxLink, pucArguments, ulArguments, 1 );
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevWindow( xHUDViewSpidev_t * pxLink, int iX, int iY, int iWidth, int iHeight )
+{
+    uint8_t aucColumns[ 4 ] = { ( uint8_t )( iX >> 8 ), ( uint8_t )iX, ( uint8_t )( ( iX + iWidth - 1 ) >> 8 ),
+                                ( uint8_t )( iX + iWidth - 1 ) };
+    uint8_t aucRows[ 4 ] = { ( uint8_t )( iY >> 8 ), ( uint8_t )iY, ( uint8_t )( ( iY + iHeight - 1 ) >> 8 ),
+                             ( uint8_t )( iY + iHeight - 1 ) };
+    int iReturn = 0;
+
+    pxLink->xStatistics.ulWindows++;
+
+    /* Runs of whole rows share their columns from one window to the next, so CASET is often left out; RASET could
+     * be too, but a window rarely repeats its rows within a frame. */
+    if ( pxLink->bBatch && ( iX == pxLink->aiWindow[ 0 ] ) && ( iWidth == pxLink->aiWindow[ 2 ] ) )
+    {
+        pxLink->xStatistics.ulWindowsReused++;
+    }
+    else
+    {
+        iReturn = iHUDViewSpidevCommand( pxLink, HUDVIEW_SPIDEV_CASET, aucColumns, sizeof( aucColumns ) );
+    }
+
+    if ( 0 == iReturn )
+    {
+        iReturn = iHUDViewSpidevCommand( pxLink, HUDVIEW_SPIDEV_RASET, aucRows, sizeof( aucRows ) );
+    }
+
+    if ( 0 == iReturn )
+    {
+        iReturn = iHUDViewSpidevCommand( pxLink, HUDVIEW_SPIDEV_RAMWR, NULL, 0 );
+    }
+
+    pxLink->aiWindow[ 0 ] = ( 0 == iReturn ) ? iX : -1;
+    pxLink->aiWindow[ 1 ] = iY;
+    pxLink->aiWindow[ 2 ] = iWidth;
+    pxLink->aiWindow[ 3 ] = iHeight;
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevScrollArea( xHUDViewSpidev_t * pxLink, int iFirst, int iLines )
+{
+    int iBottom = HUDVIEW_SPIDEV_WIDTH - iFirst - iLines;
+    uint8_t aucArea[ 6 ] = { ( uint8_t )( iFirst >> 8 ), ( uint8_t )iFirst, ( uint8_t )( iLines >> 8 ),
+                             ( uint8_t )iLines, ( uint8_t )( iBottom >> 8 ), ( uint8_t )iBottom };
+
+    return iHUDViewSpidevCommand( pxLink, HUDVIEW_SPIDEV_VSCRDEF, aucArea, sizeof( aucArea ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevScroll( xHUDViewSpidev_t * pxLink, int iStart )
+{
+    uint8_t aucStart[ 2 ] = { ( uint8_t )( iStart >> 8 ), ( uint8_t )iStart };
+
+    return iHUDViewSpidevCommand( pxLink, HUDVIEW_SPIDEV_VSCSAD, aucStart, sizeof( aucStart ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevData( xHUDViewSpidev_t * pxLink, const uint8_t * pucData, size_t ulBytes )
+{
+    int iReturn = iSetDataMode( pxLink, 1 );
+
+    return ( 0 == iReturn ) ? iQueue( pxLink, pucData, ulBytes, 0 ) : iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevFlush( xHUDViewSpidev_t * pxLink )
+{
+    int iReturn = 0;
+
+    if ( 0 < pxLink->iTransfers )
+    {
+        iReturn = iSend( pxLink, pxLink->axTransfers, pxLink->iTransfers );
+    }
+
+    pxLink->iTransfers = 0;
+    pxLink->ulPending = 0;
+    pxLink->ulBytes = 0;
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewSpidevPushRegions( xHUDViewSpidev_t * pxLink, xHUDViewSpidevRegion_t * pxRegions, int iRegions )
+{
+    int iReturn = 0;
+    int iRegion = 0;
+
+    while ( ( 0 == iReturn ) && ( iRegion < iRegions ) )
+    {
+        int iEnd = iRegion + 1;
+        int iWindowEnd = 0;
+        int iHeight = 0;
+
+        /* Within a run in one format the order does not matter, as no two regions overlap; in column order, the
+         * rows of tiles on either side of the HUD's text line up into a window each. */
+        while ( ( iEnd < iRegions ) && ( pxRegions[ iEnd ].b12Bit == pxRegions[ iRegion ].b12Bit ) )
+        {
+            iEnd++;
+        }
+
+        if ( pxLink->bBatch )
+        {
+            qsort( &pxRegions[ iRegion ], ( size_t )( iEnd - iRegion ), sizeof( xHUDViewSpidevRegion_t ),
+                   iCompareRegions );
+        }
+
+        if ( pxRegions[ iRegion ].b12Bit != pxLink->b12Bit )
+        {
+            uint8_t ucColmod = pxRegions[ iRegion ].b12Bit ? HUDVIEW_RGB444_COLMOD_12BIT : HUDVIEW_RGB444_COLMOD_16BIT;
+
+            iReturn = iHUDViewSpidevCommand( pxLink, HUDVIEW_SPIDEV_COLMOD, &ucColmod, 1 );
+            pxLink->b12Bit = pxRegions[ iRegion ].b12Bit;
+        }
+
+        while ( ( 0 == iReturn ) && ( iRegion < iEnd ) )
+        {
+            const xHUDViewSpidevRegion_t * pxFirst = &pxRegions[ iRegion ];
+
+            /* A region joins the window above it unless a half-filled 12-bit byte would sit between them. */
+            iWindowEnd = iRegion + 1;
+            iHeight = pxFirst->iHeight;
+
+            while ( pxLink->bBatch && ( iWindowEnd < iEnd ) && ( pxRegions[ iWindowEnd ].iX == pxFirst->iX )
+                    && ( pxRegions[ iWindowEnd ].iWidth == pxFirst->iWidth )
+                    && ( pxRegions[ iWindowEnd ].iY == pxFirst->iY + iHeight )
+                    && ( !pxFirst->b12Bit || ( 0 == ( pxFirst->iWidth * iHeight ) % 2 ) ) )
+            {
+                iHeight += pxRegions[ iWindowEnd++ ].iHeight;
+            }
+
+            iReturn = iHUDViewSpidevWindow( pxLink, pxFirst->iX, pxFirst->iY, pxFirst->iWidth, iHeight );
+
+            while ( ( 0 == iReturn ) && ( iRegion < iWindowEnd ) )
+            {
+                iReturn = iHUDViewSpidevData( pxLink, pxRegions[ iRegion ].pucData, pxRegions[ iRegion ].ulBytes );
+                iRegion++;
+            }
+        }
+    }
+
+    if ( 0 == iReturn )
+    {
+        iReturn = iHUDViewSpidevFlush( pxLink );
+    }
+    else
+    {
+        /* Nothing of a failed frame is kept: its data goes with the caller's buffer, and the window is unknown. */
+        pxLink->iTransfers = 0;
+        pxLink->ulPending = 0;
+        pxLink->ulBytes = 0;
+        pxLink->aiWindow[ 0 ] = -1;
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vReset( xHUDViewSpidev_t * pxLink )
+{
+    memset( pxLink, 0, sizeof( *pxLink ) );
+    pxLink->iSPI = -1;
+    pxLink->iLines = -1;
+    pxLink->bBatch = 1;
+    pxLink->ulBufferSize = HUDVIEW_SPIDEV_DEFAULT_BUFSIZ;
+    pxLink->iDataMode = -1;
+    pxLink->aiWindow[ 0 ] = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iSetLines( xHUDViewSpidev_t * pxLink, int iDataMode, int iReset )
+{
+    struct gpio_v2_line_values xValues;
+    int iReturn = 0;
+
+    /* Bit 0 is D/C and bit 1 reset, in the order the lines were requested. */
+    xValues.bits = ( iDataMode ? 1 : 0 ) | ( iReset ? 2 : 0 );
+    xValues.mask = 3;
+
+    if ( ( 0 <= pxLink->iLines ) && ( 0 > ioctl( pxLink->iLines, GPIO_V2_LINE_SET_VALUES_IOCTL, &xValues ) ) )
+    {
+        iReturn = -1;
+    }
+
+    pxLink->iDataMode = iDataMode;
+    pxLink->xStatistics.ulLineChanges++;
+    pxLink->xStatistics.dWireSeconds += HUDVIEW_SPIDEV_IOCTL_NS / 1e9;
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iSetDataMode( xHUDViewSpidev_t * pxLink, int iDataMode )
+{
+    int iReturn = 0;
+
+    /* Whatever is pending was meant for the level it was queued at, so it goes out before the line changes. */
+    if ( iDataMode != pxLink->iDataMode )
+    {
+        iReturn = iHUDViewSpidevFlush( pxLink );
+
+        if ( 0 == iReturn )
+        {
+            iReturn = iSetLines( pxLink, iDataMode, 1 );
+        }
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iQueue( xHUDViewSpidev_t * pxLink, const uint8_t * pucData, size_t ulBytes, int bCopy )
+{
+    int iReturn = 0;
+
+    while ( ( 0 == iReturn ) && ( 0 < ulBytes ) )
+    {
+        size_t ulChunk = pxLink->ulBufferSize - pxLink->ulPending;
+        const uint8_t * pucChunk = pucData;
+        struct spi_ioc_transfer * pxLast = ( 0 < pxLink->iTransfers ) ? &pxLink->axTransfers[ pxLink->iTransfers - 1 ]
+                                                                      : NULL;
+
+        ulChunk = ( ulBytes < ulChunk ) ? ulBytes : ulChunk;
+        ulChunk = ( bCopy && ( HUDVIEW_SPIDEV_COMMAND_BYTES - pxLink->ulBytes < ulChunk ) )
+                  ? HUDVIEW_SPIDEV_COMMAND_BYTES - pxLink->ulBytes : ulChunk;
+
+        if ( bCopy )
+        {
+            pucChunk = &pxLink->aucBytes[ pxLink->ulBytes ];
+            memcpy( &pxLink->aucBytes[ pxLink->ulBytes ], pucData, ulChunk );
+            pxLink->ulBytes += ulChunk;
+        }
+
+        /* Bytes that carry on where the last transfer ended join it. */
+        if ( ( 0 < ulChunk ) && ( NULL != pxLast )
+             && ( ( uintptr_t )pucChunk == ( uintptr_t )pxLast->tx_buf + pxLast->len ) )
+        {
+            pxLast->len += ( uint32_t )ulChunk;
+        }
+        else if ( 0 < ulChunk )
+        {
+            struct spi_ioc_transfer * pxTransfer = &pxLink->axTransfers[ pxLink->iTransfers++ ];
+
+            memset( pxTransfer, 0, sizeof( *pxTransfer ) );
+            pxTransfer->tx_buf = ( uintptr_t )pucChunk;
+            pxTransfer->len = ( uint32_t )ulChunk;
+        }
+
+        pxLink->ulPending += ulChunk;
+        pucData += ulChunk;
+        ulBytes -= ulChunk;
+
+        /* A full buffer, a full message or the generic path's one message a call all send what is pending. */
+        if ( ( pxLink->ulPending == pxLink->ulBufferSize ) || ( HUDVIEW_SPIDEV_MAXIMUM_TRANSFERS == pxLink->iTransfers )
+             || ( bCopy && ( HUDVIEW_SPIDEV_COMMAND_BYTES == pxLink->ulBytes ) ) || !pxLink->bBatch )
+        {
+            iReturn = iHUDViewSpidevFlush( pxLink );
+        }
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iSend( xHUDViewSpidev_t * pxLink, struct spi_ioc_transfer * pxTransfers, int iTransfers )
+{
+    int iReturn = 0;
+
+    for ( int iTransfer = 0; iTransfer < iTransfers; iTransfer++ )
+    {
+        pxTransfers[ iTransfer ].speed_hz = ( uint32_t )pxLink->ulClockHz;
+        pxTransfers[ iTransfer ].bits_per_word = 8;
+        pxLink->xStatistics.ullBytes += pxTransfers[ iTransfer ].len;
+        pxLink->xStatistics.dWireSeconds += pxTransfers[ iTransfer ].len * 8.0 / pxLink->ulClockHz;
+
+        if ( NULL != pxLink->pxPanel )
+        {
+            if ( 0 != pxTransfers[ iTransfer ].tx_buf )
+            {
+                vPanelWrite( pxLink->pxPanel, pxLink->iDataMode, pxLink->ulClockHz,
+                             ( const uint8_t * )( uintptr_t )pxTransfers[ iTransfer ].tx_buf,
+                             pxTransfers[ iTransfer ].len );
+            }
+
+            if ( 0 != pxTransfers[ iTransfer ].rx_buf )
+            {
+                vPanelRead( pxLink->pxPanel, ( uint8_t * )( uintptr_t )pxTransfers[ iTransfer ].rx_buf,
+                            pxTransfers[ iTransfer ].len );
+            }
+        }
+    }
+
+    if ( ( 0 <= pxLink->iSPI ) && ( 0 > ioctl( pxLink->iSPI, SPI_IOC_MESSAGE( iTransfers ), pxTransfers ) ) )
+    {
+        iReturn = -1;
+    }
+
+    pxLink->xStatistics.ulMessages++;
+    pxLink->xStatistics.dWireSeconds += HUDVIEW_SPIDEV_IOCTL_NS / 1e9;
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iRead( xHUDViewSpidev_t * pxLink, uint8_t ucCommand, uint8_t * pucData, size_t ulBytes )
+{
+    struct spi_ioc_transfer axTransfers[ 2 ];
+    int iReturn = iHUDViewSpidevFlush( pxLink );
+
+    /* The command and the answer in one message, so chip select stays down between them; D/C only matters for the
+     * command. */
+    memset( axTransfers, 0, sizeof( axTransfers ) );
+    axTransfers[ 0 ].tx_buf = ( uintptr_t )&ucCommand;
+    axTransfers[ 0 ].len = 1;
+    axTransfers[ 1 ].rx_buf = ( uintptr_t )pucData;
+    axTransfers[ 1 ].len = ( uint32_t )ulBytes;
+
+    if ( 0 == iReturn )
+    {
+        iReturn = iSetDataMode( pxLink, 0 );
+    }
+
+    return ( 0 == iReturn ) ? iSend( pxLink, axTransfers, 2 ) : iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bProbeRound( xHUDViewSpidev_t * pxLink, unsigned long ulClockHz, unsigned int uiSeed )
+{
+    static uint16_t ausPattern[ PROBE_PIXELS ];
+    static uint8_t aucWritten[ PROBE_PIXELS * 2 ];
+    static uint8_t aucRead[ PROBE_READ_BYTES ];
+    unsigned int uiState = uiSeed * 2654435761U + 1;
+    int bBatch = pxLink->bBatch;
+    int bReturn = 0;
+
+    for ( int iPixel = 0; iPixel < PROBE_PIXELS; iPixel++ )
+    {
+        uiState = uiState * 1103515245U + 12345U;
+        ausPattern[ iPixel ] = ( uint16_t )( uiState >> 12 );
+        aucWritten[ iPixel * 2 ] = ( uint8_t )( ausPattern[ iPixel ] >> 8 );
+        aucWritten[ iPixel * 2 + 1 ] = ( uint8_t )ausPattern[ iPixel ];
+    }
+
+    /* Written at the clock under test with the window sent afresh, then read back at the read clock. */
+    pxLink->bBatch = 0;
+
+    if ( ( 0 == iHUDViewSpidevSetClock( pxLink, ulClockHz ) )
+         && ( 0 == iHUDViewSpidevWindow( pxLink, 0, 0, PROBE_WIDTH, PROBE_HEIGHT ) )
+         && ( 0 == iHUDViewSpidevData( pxLink, aucWritten, sizeof( aucWritten ) ) )
+         && ( 0 == iHUDViewSpidevSetClock( pxLink, HUDVIEW_SPIDEV_READ_CLOCK_HZ ) )
+         && ( 0 == iHUDViewSpidevWindow( pxLink, 0, 0, PROBE_WIDTH, PROBE_HEIGHT ) )
+         && ( 0 == iRead( pxLink, HUDVIEW_SPIDEV_RAMRD, aucRead, sizeof( aucRead ) ) ) )
+    {
+        /* The panel widens five-bit channels in a way of its own, so only the bits written are compared. */
+        for ( int iShift = 0; !bReturn && ( iShift < PROBE_MAXIMUM_SHIFT ); iShift++ )
+        {
+            bReturn = 1;
+
+            for ( int iPixel = 0; bReturn && ( iPixel < PROBE_PIXELS ); iPixel++ )
+            {
+                int aiRead[ 3 ];
+
+                for ( int iChannel = 0; iChannel < 3; iChannel++ )
+                {
+                    int iBit = ( iPixel * 3 + iChannel ) * 8 + iShift;
+                    int iByte = iBit / 8;
+
+                    aiRead[ iChannel ] = ( ( aucRead[ iByte ] << ( iBit % 8 ) )
+                                           | ( aucRead[ iByte + 1 ] >> ( 8 - iBit % 8 ) ) ) & 0xFF;
+                }
+
+                bReturn = ( ( aiRead[ 0 ] >> 3 ) == ( ausPattern[ iPixel ] >> 11 ) )
+                          && ( ( aiRead[ 1 ] >> 2 ) == ( ( ausPattern[ iPixel ] >> 5 ) & 0x3F ) )
+                          && ( ( aiRead[ 2 ] >> 3 ) == ( ausPattern[ iPixel ] & 0x1F ) );
+            }
+        }
+    }
+
+    pxLink->bBatch = bBatch;
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iCompareRegions( const void * pvA, const void * pvB )
+{
+    const xHUDViewSpidevRegion_t * pxA = ( const xHUDViewSpidevRegion_t * )pvA;
+    const xHUDViewSpidevRegion_t * pxB = ( const xHUDViewSpidevRegion_t * )pvB;
+
+    return ( pxA->iX != pxB->iX ) ? pxA->iX - pxB->iX
+           : ( pxA->iWidth != pxB->iWidth ) ? pxA->iWidth - pxB->iWidth : pxA->iY - pxB->iY;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSleepMilliseconds( const xHUDViewSpidev_t * pxLink, int iMilliseconds )
+{
+    struct timespec xDelay = { iMilliseconds / 1000, ( iMilliseconds % 1000 ) * 1000000L };
+
+    /* The stand-in has no panel to wait for. */
+    if ( NULL == pxLink->pxPanel )
+    {
+        nanosleep( &xDelay, NULL );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPanelWrite( xHUDViewSpidevPanel_t * pxPanel, int iDataMode, unsigned long ulClockHz,
+                         const uint8_t * pucData, size_t ulBytes )
+{
+    for ( size_t ulByte = 0; ulByte < ulBytes; ulByte++ )
+    {
+        uint8_t ucByte = pucData[ ulByte ];
+
+        /* Too fast a clock flips a bit now and then, as a marginal link would. */
+        if ( ( ulClockHz > pxPanel->ulStableHz ) && ( 0 == ++pxPanel->ulGarble % STANDIN_GARBLE_EVERY ) )
+        {
+            ucByte ^= 0x10;
+        }
+
+        if ( !iDataMode )
+        {
+            pxPanel->ucCommand = ucByte;
+            pxPanel->iArgument = 0;
+            pxPanel->iPartial = 0;
+
+            if ( HUDVIEW_SPIDEV_RAMWR == ucByte )
+            {
+                pxPanel->iColumn = pxPanel->aiColumns[ 0 ];
+                pxPanel->iRow = pxPanel->aiRows[ 0 ];
+            }
+        }
+        else if ( ( HUDVIEW_SPIDEV_CASET == pxPanel->ucCommand ) || ( HUDVIEW_SPIDEV_RASET == pxPanel->ucCommand ) )
+        {
+            int * piRange = ( HUDVIEW_SPIDEV_CASET == pxPanel->ucCommand ) ? pxPanel->aiColumns : pxPanel->aiRows;
+
+            if ( 4 > pxPanel->iArgument )
+            {
+                pxPanel->aucArguments[ pxPanel->iArgument++ ] = ucByte;
+            }
+
+            if ( 4 == pxPanel->iArgument )
+            {
+                piRange[ 0 ] = ( pxPanel->aucArguments[ 0 ] << 8 ) | pxPanel->aucArguments[ 1 ];
+                piRange[ 1 ] = ( pxPanel->aucArguments[ 2 ] << 8 ) | pxPanel->aucArguments[ 3 ];
+            }
+        }
+        else if ( HUDVIEW_SPIDEV_COLMOD == pxPanel->ucCommand )
+        {
+            pxPanel->b12Bit = ( HUDVIEW_RGB444_COLMOD_12BIT == ( ucByte & 0x07 ) );
+        }
+        else if ( HUDVIEW_SPIDEV_RAMWR == pxPanel->ucCommand )
+        {
+            pxPanel->aucPartial[ pxPanel->iPartial++ ] = ucByte;
+
+            if ( !pxPanel->b12Bit && ( 2 == pxPanel->iPartial ) )
+            {
+                int iPixel = ( pxPanel->aucPartial[ 0 ] << 8 ) | pxPanel->aucPartial[ 1 ];
+
+                vPanelPixel( pxPanel, ( iPixel >> 11 ) << 1 | ( iPixel >> 15 ), ( iPixel >> 5 ) & 0x3F,
+                             ( iPixel & 0x1F ) << 1 | ( ( iPixel >> 4 ) & 1 ) );
+                pxPanel->iPartial = 0;
+            }
+            else if ( pxPanel->b12Bit && ( 3 == pxPanel->iPartial ) )
+            {
+                const uint8_t * pucPair = pxPanel->aucPartial;
+
+                vPanelPixel( pxPanel, WIDEN_NIBBLE( pucPair[ 0 ] >> 4 ), WIDEN_NIBBLE( pucPair[ 0 ] & 0x0F ),
+                             WIDEN_NIBBLE( pucPair[ 1 ] >> 4 ) );
+                vPanelPixel( pxPanel, WIDEN_NIBBLE( pucPair[ 1 ] & 0x0F ), WIDEN_NIBBLE( pucPair[ 2 ] >> 4 ),
+                             WIDEN_NIBBLE( pucPair[ 2 ] & 0x0F ) );
+                pxPanel->iPartial = 0;
+            }
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPanelPixel( xHUDViewSpidevPanel_t * pxPanel, int iRed, int iGreen, int iBlue )
+{
+    if ( ( HUDVIEW_SPIDEV_WIDTH > pxPanel->iColumn ) && ( HUDVIEW_SPIDEV_HEIGHT > pxPanel->iRow ) )
+    {
+        uint8_t * pucPixel = &pxPanel->aucMemory[ ( pxPanel->iRow * HUDVIEW_SPIDEV_WIDTH + pxPanel->iColumn ) * 3 ];
+
+        pucPixel[ 0 ] = ( uint8_t )iRed;
+        pucPixel[ 1 ] = ( uint8_t )iGreen;
+        pucPixel[ 2 ] = ( uint8_t )iBlue;
+    }
+
+    /* Across the window, then down, and back to the top once it is full. */
+    if ( pxPanel->aiColumns[ 1 ] < ++pxPanel->iColumn )
+    {
+        pxPanel->iColumn = pxPanel->aiColumns[ 0 ];
+        pxPanel->iRow = ( pxPanel->aiRows[ 1 ] > pxPanel->iRow ) ? pxPanel->iRow + 1 : pxPanel->aiRows[ 0 ];
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPanelRead( const xHUDViewSpidevPanel_t * pxPanel, uint8_t * pucData, size_t ulBytes )
+{
+    int iColumn = pxPanel->aiColumns[ 0 ];
+    int iRow = pxPanel->aiRows[ 0 ];
+    int iCarry = 0;
+
+    /* RAMRD: six bits a channel at the top of each byte, after a dummy clock cycle that shifts it all by a bit. */
+    for ( size_t ulByte = 0; ulByte < ulBytes; ulByte++ )
+    {
+        int iChannel = ( int )( ulByte % 3 );
+        int iValue = 0;
+
+        if ( ( HUDVIEW_SPIDEV_WIDTH > iColumn ) && ( HUDVIEW_SPIDEV_HEIGHT > iRow ) )
+        {
+            iValue = pxPanel->aucMemory[ ( iRow * HUDVIEW_SPIDEV_WIDTH + iColumn ) * 3 + iChannel ] << 2;
+        }
+
+        pucData[ ulByte ] = ( uint8_t )( iCarry | ( iValue >> 1 ) );
+        iCarry = ( iValue << 7 ) & 0x80;
+
+        if ( ( 2 == iChannel ) && ( pxPanel->aiColumns[ 1 ] < ++iColumn ) )
+        {
+            iColumn = pxPanel->aiColumns[ 0 ];
+            iRow = ( pxPanel->aiRows[ 1 ] > iRow ) ? iRow + 1 : pxPanel->aiRows[ 0 ];
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,159 @@
+/** @file hudview_spidev.h
+ *  @brief HUDView ST7735 link over spidev, with batched transfers.
+ *
+ *  Drives the display straight through /dev/spidev and the GPIO character device instead of the display library's
+ *  generic SPI path. Commands, their arguments and pixel data are gathered into SPI_IOC_MESSAGE batches of up to the
+ *  spidev bufsiz, so a batch only ends where the D/C line has to change or the buffer is full, and the column and row
+ *  window is only sent again when it changes. D/C and reset are driven through one GPIO line request and only
+ *  written when their level changes.
+ *
+ *  The highest stable SPI clock can be probed: a test pattern is written at each clock the Pi can make, fastest
+ *  first, and read back with RAMRD at a slow clock; the first clock that passes every round is taken one step down
+ *  for margin. Modules without a MISO line cannot be read back, and keep the configured clock.
+ *
+ *  A stand-in takes the place of the device on a desktop: it counts the ioctls and bytes a real link would make,
+ *  estimates the wire time from the clock and a fixed cost per ioctl, and emulates enough of the panel (window,
+ *  RAMWR, RAMRD, COLMOD) that probing can be exercised, garbling writes above a stable clock of its own.
+ */
+
+#ifndef HUDVIEW_SPIDEV_H
+#define HUDVIEW_SPIDEV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/spi/spidev.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* The panel, rotated into landscape as the display library had it. */
+#define HUDVIEW_SPIDEV_WIDTH                ( 160 )
+#define HUDVIEW_SPIDEV_HEIGHT               ( 128 )
+
+/* Where the display is wired: CE1, with D/C and reset on BCM 23 and 22, as st7735_128x160_spi_init( 22, 1, 23 ). */
+#define HUDVIEW_SPIDEV_DEFAULT_DEVICE       "/dev/spidev0.1"
+#define HUDVIEW_SPIDEV_GPIO_CHIP            "/dev/gpiochip0"
+#define HUDVIEW_SPIDEV_DC_LINE              ( 23 )
+#define HUDVIEW_SPIDEV_RESET_LINE           ( 22 )
+
+/* The most spidev takes in one message, unless its module parameter says otherwise. */
+#define HUDVIEW_SPIDEV_BUFSIZ_PATH          "/sys/module/spidev/parameters/bufsiz"
+#define HUDVIEW_SPIDEV_DEFAULT_BUFSIZ       ( 4096 )
+#define HUDVIEW_SPIDEV_MAXIMUM_TRANSFERS    ( 32 )
+#define HUDVIEW_SPIDEV_COMMAND_BYTES        ( 256 )
+
+/* Clocks: the one used when probing is not possible, the most probing tries, and RAMRD's, well inside the panel's
+ * read cycle. The Pi divides its 250 MHz core clock by an even number. */
+#define HUDVIEW_SPIDEV_DEFAULT_CLOCK_HZ     ( 16000000UL )
+#define HUDVIEW_SPIDEV_MAXIMUM_CLOCK_HZ     ( 62500000UL )
+#define HUDVIEW_SPIDEV_READ_CLOCK_HZ        ( 3906250UL )
+#define HUDVIEW_SPIDEV_CORE_CLOCK_HZ        ( 250000000UL )
+#define HUDVIEW_SPIDEV_PROBE_ROUNDS         ( 3 )
+
+/* What an ioctl costs the link on the Pi (the syscall, chip select and D/C), and the stand-in panel's limit. */
+#define HUDVIEW_SPIDEV_IOCTL_NS             ( 20000 )
+#define HUDVIEW_SPIDEV_STANDIN_STABLE_HZ    ( 31250000UL )
+
+/* ST7735 commands. */
+#define HUDVIEW_SPIDEV_CASET                ( 0x2A )
+#define HUDVIEW_SPIDEV_RASET                ( 0x2B )
+#define HUDVIEW_SPIDEV_RAMWR                ( 0x2C )
+#define HUDVIEW_SPIDEV_RAMRD                ( 0x2E )
+#define HUDVIEW_SPIDEV_VSCRDEF              ( 0x33 )
+#define HUDVIEW_SPIDEV_VSCSAD               ( 0x37 )
+#define HUDVIEW_SPIDEV_COLMOD               ( 0x3A )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    unsigned long ulMessages;
+    unsigned long ulLineChanges;
+    unsigned long long ullBytes;
+    unsigned long ulWindows;
+    unsigned long ulWindowsReused;
+    double dWireSeconds;
+} xHUDViewSpidevStatistics_t;
+
+/* A region of a frame and its pixels as they go on the wire, big-endian RGB565 or packed to 12 bits. */
+typedef struct {
+    int iX;
+    int iY;
+    int iWidth;
+    int iHeight;
+    int b12Bit;
+    const uint8_t * pucData;
+    size_t ulBytes;
+} xHUDViewSpidevRegion_t;
+
+typedef struct xHUDViewSpidevPanel xHUDViewSpidevPanel_t;
+
+typedef struct {
+    int iSPI;
+    int iLines;
+    int bBatch;
+    unsigned long ulClockHz;
+    size_t ulBufferSize;
+
+    /* The D/C level of the pending transfers (-1 before the first), the last window sent, and whether the panel
+     * takes 12 bits a pixel. */
+    int iDataMode;
+    int aiWindow[ 4 ];
+    int b12Bit;
+
+    /* Transfers waiting for the next message, all at the same D/C level; command and argument bytes are kept here,
+     * pixel data is sent from the caller's buffer. */
+    struct spi_ioc_transfer axTransfers[ HUDVIEW_SPIDEV_MAXIMUM_TRANSFERS ];
+    int iTransfers;
+    size_t ulPending;
+    uint8_t aucBytes[ HUDVIEW_SPIDEV_COMMAND_BYTES ];
+    size_t ulBytes;
+
+    /* The emulated panel, when this is the stand-in. */
+    xHUDViewSpidevPanel_t * pxPanel;
+
+    xHUDViewSpidevStatistics_t xStatistics;
+} xHUDViewSpidev_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Opens the device and the D/C and reset lines; returns 0, or -1 with errno set. */
+int iHUDViewSpidevOpen( xHUDViewSpidev_t * pxLink, const char * pcDevice, unsigned long ulClockHz );
+int iHUDViewSpidevOpenStandIn( xHUDViewSpidev_t * pxLink, unsigned long ulClockHz, size_t ulBufferSize );
+void vHUDViewSpidevClose( xHUDViewSpidev_t * pxLink );
+
+/* Batching on (the default) ends a message only where it must; off, every call is a message of its own and the
+ * window is always sent, as a generic path would. */
+void vHUDViewSpidevSetBatch( xHUDViewSpidev_t * pxLink, int bBatch );
+int iHUDViewSpidevSetClock( xHUDViewSpidev_t * pxLink, unsigned long ulClockHz );
+
+/* Resets the panel and brings it up in landscape at 16 bits a pixel. */
+int iHUDViewSpidevInitPanel( xHUDViewSpidev_t * pxLink );
+
+/* The highest clock up to ulMaximumHz at which the panel reads back what was written, a step down for margin; 0 if
+ * it cannot be read back or nothing passed. The clock in use is left as it was. */
+unsigned long ulHUDViewSpidevProbeClock( xHUDViewSpidev_t * pxLink, unsigned long ulMaximumHz );
+
+int iHUDViewSpidevCommand( xHUDViewSpidev_t * pxLink, uint8_t ucCommand, const uint8_t * pucArguments,
+                           size_t ulArguments );
+int iHUDViewSpidevWindow( xHUDViewSpidev_t * pxLink, int iX, int iY, int iWidth, int iHeight );
+
+/* Hardware scrolling along the panel's lines, the landscape x axis: lines [iFirst, iFirst + iLines) scroll and the
+ * rest stay put, and the scrolling area starts showing memory from line iStart. */
+int iHUDViewSpidevScrollArea( xHUDViewSpidev_t * pxLink, int iFirst, int iLines );
+int iHUDViewSpidevScroll( xHUDViewSpidev_t * pxLink, int iStart );
+
+/* Pixel data for the open window; it is sent from pucData, which must stay as it is until the next flush. */
+int iHUDViewSpidevData( xHUDViewSpidev_t * pxLink, const uint8_t * pucData, size_t ulBytes );
+int iHUDViewSpidevFlush( xHUDViewSpidev_t * pxLink );
+
+/* Sends a frame's regions, switching the pixel format where it changes, and flushes. Batched, the regions of each
+ * run in one format are put in column order and those that continue one another down the panel share a window; the
+ * regions must not overlap, and are reordered in place. */
+int iHUDViewSpidevPushRegions( xHUDViewSpidev_t * pxLink, xHUDViewSpidevRegion_t * pxRegions, int iRegions );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_SPIDEV_H
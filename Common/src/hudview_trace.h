@@ -0,0 +1,89 @@
+/** @file hudview_trace.h
+ *  @brief HUDView input-to-photon trace stamps.
+ *
+ *  Every component starts each record it prints with a stamp, "@<sequence>:<nanoseconds> ": the record's sequence
+ *  number, counting from 1, and the CLOCK_MONOTONIC time at which what it reports happened, such as the start of a
+ *  sensor read, the first byte of a GPS sentence or the first edge of a button press. The control application strips
+ *  the stamp before parsing the record and follows the source time through parse, data model update and render to
+ *  the end of the SPI transfer that shows it, and the sequence numbers show records lost on the way.
+ *
+ *  A record without a stamp is taken as it is, so components and recordings from before the stamp still work.
+ */
+
+#ifndef HUDVIEW_TRACE_H
+#define HUDVIEW_TRACE_H
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Goes ahead of the record's own format, e.g. printf( HUDVIEW_TRACE_STAMP_FORMAT "%ld\n", ulRecord, ullRead, lLux ). */
+#define HUDVIEW_TRACE_STAMP_FORMAT          "@%" PRIu32 ":%" PRIu64 " "
+#define HUDVIEW_TRACE_STAMP_MARKER          '@'
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    uint32_t ulSequence;
+    uint64_t ullSourceNanoseconds;
+} xHUDViewTraceStamp_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Reads the stamp at the start of a record, returning its length including the space after it, or 0 if the record
+ * does not start with one. */
+static inline size_t ulHUDViewTraceParse( const char * pcRecord, size_t ulLength, xHUDViewTraceStamp_t * pxStamp )
+{
+    uint64_t ullSequence = 0;
+    uint64_t ullSource = 0;
+    size_t ulIndex = 1;
+    size_t ulDigits = 0;
+
+    if ( ( 0 == ulLength ) || ( HUDVIEW_TRACE_STAMP_MARKER != pcRecord[ 0 ] ) )
+    {
+        return 0;
+    }
+
+    for ( ulDigits = 0; ( ulIndex < ulLength ) && ( '0' <= pcRecord[ ulIndex ] ) && ( '9' >= pcRecord[ ulIndex ] );
+          ulIndex++, ulDigits++ )
+    {
+        ullSequence = ullSequence * 10 + ( uint64_t )( pcRecord[ ulIndex ] - '0' );
+    }
+
+    if ( ( 0 == ulDigits ) || ( 10 < ulDigits ) || ( UINT32_MAX < ullSequence ) || ( ulIndex >= ulLength )
+         || ( ':' != pcRecord[ ulIndex ] ) )
+    {
+        return 0;
+    }
+
+    for ( ulIndex++, ulDigits = 0;
+          ( ulIndex < ulLength ) && ( '0' <= pcRecord[ ulIndex ] ) && ( '9' >= pcRecord[ ulIndex ] );
+          ulIndex++, ulDigits++ )
+    {
+        ullSource = ullSource * 10 + ( uint64_t )( pcRecord[ ulIndex ] - '0' );
+    }
+
+    /* Nineteen digits always fit; a record that is nothing but a stamp carries nothing to trace. */
+    if ( ( 0 == ulDigits ) || ( 19 < ulDigits ) || ( ulIndex >= ulLength ) || ( ' ' != pcRecord[ ulIndex ] ) )
+    {
+        return 0;
+    }
+
+    if ( NULL != pxStamp )
+    {
+        pxStamp->ulSequence = ( uint32_t )ullSequence;
+        pxStamp->ullSourceNanoseconds = ullSource;
+    }
+
+    return ulIndex + 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_TRACE_H
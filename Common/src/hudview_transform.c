@@ -0,0 +1,689 @@
+/** @file hudview_transform.c
+ *  @brief HUDView camera frame orientation, crop and scaling.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define HUDVIEW_TRANSFORM_NEON
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#define HUDVIEW_TRANSFORM_SSE2
+#endif
+
+#include "hudview_flow.h"
+#include "hudview_transform.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Same packing as the display compositor, so a transformed frame can be shown as is. */
+#define RGB565( ucRed, ucGreen, ucBlue ) \
+    ( ( uint16_t )( ( ( ( ucRed ) & 0xF8 ) << 8 ) | ( ( ( ucGreen ) & 0xFC ) << 3 ) | ( ( ucBlue ) >> 3 ) ) )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFillTaps( xHUDViewTransformTap_t * pxTaps, int iOutput, int iLength, int iOrigin, int iStep,
+                       int bReverse, eHUDViewTransformFilter_t eFilter );
+static void vTileNearest( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                          uint8_t * pucLuma, int iX0, int iY0, int iX1, int iY1 );
+static void vTileBilinear( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                           uint8_t * pucLuma, int iX0, int iY0, int iX1, int iY1 );
+static void vTileArea( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                       uint8_t * pucLuma, int iX0, int iY0, int iX1, int iY1 );
+#if defined( HUDVIEW_TRANSFORM_NEON ) || defined( HUDVIEW_TRANSFORM_SSE2 )
+static void vTileExact( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                        uint8_t * pucLuma, int iX0, int iY0 );
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewTransformDefaultConfig( xHUDViewTransformConfig_t * pxConfig, int iDestinationWidth,
+                                     int iDestinationHeight )
+{
+    memset( pxConfig, 0, sizeof( *pxConfig ) );
+    pxConfig->iSourceWidth = iDestinationWidth;
+    pxConfig->iSourceHeight = iDestinationHeight;
+    pxConfig->eFilter = eHUDViewTransformFilter_Area;
+    pxConfig->iDestinationWidth = iDestinationWidth;
+    pxConfig->iDestinationHeight = iDestinationHeight;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewTransformParse( const char * pcSpecification, xHUDViewTransformConfig_t * pxConfig )
+{
+    char acSpecification[ 128 ];
+    char * pcSaved = NULL;
+    char * pcToken = NULL;
+    char cTrailing = 0;
+
+    if ( strlen( pcSpecification ) >= sizeof( acSpecification ) )
+    {
+        return -1;
+    }
+
+    strcpy( acSpecification, pcSpecification );
+    pcToken = strtok_r( acSpecification, ":", &pcSaved );
+
+    /* The camera geometry comes first, e.g. "320x240:rotate=90:hflip:crop=180x240+70+0:area". */
+    if ( ( NULL == pcToken )
+         || ( 2 != sscanf( pcToken, "%dx%d%c", &pxConfig->iSourceWidth, &pxConfig->iSourceHeight, &cTrailing ) ) )
+    {
+        return -1;
+    }
+
+    pxConfig->iSourceStride = 0;
+
+    while ( NULL != ( pcToken = strtok_r( NULL, ":", &pcSaved ) ) )
+    {
+        if ( 0 == strcmp( pcToken, "hflip" ) )
+        {
+            pxConfig->bFlipHorizontal = 1;
+        }
+        else if ( 0 == strcmp( pcToken, "vflip" ) )
+        {
+            pxConfig->bFlipVertical = 1;
+        }
+        else if ( 0 == strcmp( pcToken, "nearest" ) )
+        {
+            pxConfig->eFilter = eHUDViewTransformFilter_Nearest;
+        }
+        else if ( 0 == strcmp( pcToken, "bilinear" ) )
+        {
+            pxConfig->eFilter = eHUDViewTransformFilter_Bilinear;
+        }
+        else if ( 0 == strcmp( pcToken, "area" ) )
+        {
+            pxConfig->eFilter = eHUDViewTransformFilter_Area;
+        }
+        else if ( 0 == strcmp( pcToken, "mjpeg" ) )
+        {
+            pxConfig->bMJPEG = 1;
+        }
+        else if ( ( 1 != sscanf( pcToken, "rotate=%d%c", &pxConfig->iRotation, &cTrailing ) )
+                  && ( 4 != sscanf( pcToken, "crop=%dx%d+%d+%d%c", &pxConfig->iCropWidth, &pxConfig->iCropHeight,
+                                    &pxConfig->iCropX, &pxConfig->iCropY, &cTrailing ) ) )
+        {
+            /* A misspelt option would otherwise go unnoticed until the picture came out the wrong way round. */
+            return -1;
+        }
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewTransformFormat( const xHUDViewTransformConfig_t * pxConfig, char * pcSpecification, int iLength )
+{
+    int iUsed = snprintf( pcSpecification, ( size_t )iLength, "%dx%d", pxConfig->iSourceWidth,
+                          pxConfig->iSourceHeight );
+
+    /* The inverse of iHUDViewTransformParse(), leaving out whatever is the default. */
+    if ( ( 0 != pxConfig->iRotation ) && ( iUsed < iLength ) )
+    {
+        iUsed += snprintf( pcSpecification + iUsed, ( size_t )( iLength - iUsed ), ":rotate=%d", pxConfig->iRotation );
+    }
+
+    if ( pxConfig->bFlipHorizontal && ( iUsed < iLength ) )
+    {
+        iUsed += snprintf( pcSpecification + iUsed, ( size_t )( iLength - iUsed ), ":hflip" );
+    }
+
+    if ( pxConfig->bFlipVertical && ( iUsed < iLength ) )
+    {
+        iUsed += snprintf( pcSpecification + iUsed, ( size_t )( iLength - iUsed ), ":vflip" );
+    }
+
+    if ( ( 0 != pxConfig->iCropWidth ) && ( iUsed < iLength ) )
+    {
+        iUsed += snprintf( pcSpecification + iUsed, ( size_t )( iLength - iUsed ), ":crop=%dx%d+%d+%d",
+                           pxConfig->iCropWidth, pxConfig->iCropHeight, pxConfig->iCropX, pxConfig->iCropY );
+    }
+
+    if ( ( eHUDViewTransformFilter_Area != pxConfig->eFilter ) && ( iUsed < iLength ) )
+    {
+        iUsed += snprintf( pcSpecification + iUsed, ( size_t )( iLength - iUsed ), ":%s",
+                           pcHUDViewTransformFilterName( pxConfig->eFilter ) );
+    }
+
+    if ( pxConfig->bMJPEG && ( iUsed < iLength ) )
+    {
+        iUsed += snprintf( pcSpecification + iUsed, ( size_t )( iLength - iUsed ), ":mjpeg" );
+    }
+
+    return ( iUsed < iLength ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewTransformSourceBytes( const xHUDViewTransformConfig_t * pxConfig )
+{
+    int iStride = pxConfig->iSourceStride;
+
+    if ( 0 == iStride )
+    {
+        iStride = HUDVIEW_TRANSFORM_ALIGN( pxConfig->iSourceWidth, HUDVIEW_TRANSFORM_CAPTURE_WIDTH_ALIGN ) * 3;
+    }
+
+    return iStride * HUDVIEW_TRANSFORM_ALIGN( pxConfig->iSourceHeight, HUDVIEW_TRANSFORM_CAPTURE_HEIGHT_ALIGN );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewTransformFilterName( eHUDViewTransformFilter_t eFilter )
+{
+    switch ( eFilter )
+    {
+    case eHUDViewTransformFilter_Nearest:
+        return "nearest";
+
+    case eHUDViewTransformFilter_Bilinear:
+        return "bilinear";
+
+    case eHUDViewTransformFilter_Area:
+        return "area";
+
+    default:
+        return "unknown";
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int iHUDViewTransformInit( xHUDViewTransform_t * pxTransform, const xHUDViewTransformConfig_t * pxConfig )
+{
+    xHUDViewTransformConfig_t * pxOwn = &pxTransform->xConfig;
+    int bQuarter = ( 90 == pxConfig->iRotation ) || ( 270 == pxConfig->iRotation );
+    int iColumnLength = 0;
+    int iRowLength = 0;
+    int iColumnOrigin = 0;
+    int iRowOrigin = 0;
+    int bReverseColumns = 0;
+    int bReverseRows = 0;
+
+    memset( pxTransform, 0, sizeof( *pxTransform ) );
+    *pxOwn = *pxConfig;
+
+    if ( ( 0 >= pxOwn->iSourceWidth ) || ( HUDVIEW_TRANSFORM_MAXIMUM_SOURCE < pxOwn->iSourceWidth )
+         || ( 0 >= pxOwn->iSourceHeight ) || ( HUDVIEW_TRANSFORM_MAXIMUM_SOURCE < pxOwn->iSourceHeight )
+         || ( 0 >= pxOwn->iDestinationWidth ) || ( HUDVIEW_TRANSFORM_MAXIMUM_OUTPUT < pxOwn->iDestinationWidth )
+         || ( 0 >= pxOwn->iDestinationHeight ) || ( HUDVIEW_TRANSFORM_MAXIMUM_OUTPUT < pxOwn->iDestinationHeight )
+         || ( 0 != pxOwn->iRotation % 90 ) || ( 0 > pxOwn->iRotation ) || ( 270 < pxOwn->iRotation )
+         || ( eHUDViewTransformFilterMin > pxOwn->eFilter ) || ( eHUDViewTransformFilterMax <= pxOwn->eFilter ) )
+    {
+        return -1;
+    }
+
+    if ( 0 == pxOwn->iSourceStride )
+    {
+        pxOwn->iSourceStride = 3 * HUDVIEW_TRANSFORM_ALIGN( pxOwn->iSourceWidth,
+                                                            HUDVIEW_TRANSFORM_CAPTURE_WIDTH_ALIGN );
+    }
+
+    /* Without a region of interest, take the largest centred one that has the output's shape once rotated. */
+    if ( 0 == pxOwn->iCropWidth )
+    {
+        int iAspectWidth = bQuarter ? pxOwn->iDestinationHeight : pxOwn->iDestinationWidth;
+        int iAspectHeight = bQuarter ? pxOwn->iDestinationWidth : pxOwn->iDestinationHeight;
+
+        if ( pxOwn->iSourceWidth * iAspectHeight >= pxOwn->iSourceHeight * iAspectWidth )
+        {
+            pxOwn->iCropHeight = pxOwn->iSourceHeight;
+            pxOwn->iCropWidth = ( pxOwn->iSourceHeight * iAspectWidth + iAspectHeight / 2 ) / iAspectHeight;
+        }
+        else
+        {
+            pxOwn->iCropWidth = pxOwn->iSourceWidth;
+            pxOwn->iCropHeight = ( pxOwn->iSourceWidth * iAspectHeight + iAspectWidth / 2 ) / iAspectWidth;
+        }
+
+        pxOwn->iCropX = ( pxOwn->iSourceWidth - pxOwn->iCropWidth ) / 2;
+        pxOwn->iCropY = ( pxOwn->iSourceHeight - pxOwn->iCropHeight ) / 2;
+    }
+
+    if ( ( pxOwn->iSourceStride < pxOwn->iSourceWidth * 3 ) || ( 0 >= pxOwn->iCropWidth )
+         || ( 0 >= pxOwn->iCropHeight ) || ( 0 > pxOwn->iCropX ) || ( 0 > pxOwn->iCropY )
+         || ( pxOwn->iSourceWidth < pxOwn->iCropX + pxOwn->iCropWidth )
+         || ( pxOwn->iSourceHeight < pxOwn->iCropY + pxOwn->iCropHeight ) )
+    {
+        return -1;
+    }
+
+    /* A quarter turn sends output columns down the source's columns and output rows along its rows. Turning clockwise
+     * reads the source bottom to top across the output, anticlockwise right to left down it, and a half turn both;
+     * mirroring the result reverses the direction again. */
+    pxTransform->bTranspose = bQuarter;
+    pxTransform->iColumnStep = bQuarter ? pxOwn->iSourceStride : 3;
+    pxTransform->iRowStep = bQuarter ? 3 : pxOwn->iSourceStride;
+    iColumnLength = bQuarter ? pxOwn->iCropHeight : pxOwn->iCropWidth;
+    iRowLength = bQuarter ? pxOwn->iCropWidth : pxOwn->iCropHeight;
+    iColumnOrigin = bQuarter ? pxOwn->iCropY : pxOwn->iCropX;
+    iRowOrigin = bQuarter ? pxOwn->iCropX : pxOwn->iCropY;
+    bReverseColumns = ( ( 90 == pxOwn->iRotation ) || ( 180 == pxOwn->iRotation ) ) != !!pxOwn->bFlipHorizontal;
+    bReverseRows = ( ( 180 == pxOwn->iRotation ) || ( 270 == pxOwn->iRotation ) ) != !!pxOwn->bFlipVertical;
+    pxTransform->bReverseColumns = bReverseColumns;
+    pxTransform->bReverseRows = bReverseRows;
+    pxTransform->bExact = ( iColumnLength == pxOwn->iDestinationWidth ) && ( iRowLength == pxOwn->iDestinationHeight );
+
+    vFillTaps( pxTransform->axColumns, pxOwn->iDestinationWidth, iColumnLength, iColumnOrigin,
+               pxTransform->iColumnStep, bReverseColumns,
+               pxTransform->bExact ? eHUDViewTransformFilter_Nearest : pxOwn->eFilter );
+    vFillTaps( pxTransform->axRows, pxOwn->iDestinationHeight, iRowLength, iRowOrigin, pxTransform->iRowStep,
+               bReverseRows, pxTransform->bExact ? eHUDViewTransformFilter_Nearest : pxOwn->eFilter );
+
+    /* A single sample along an axis has no neighbour to filter with. */
+    pxTransform->iColumnStep = ( 1 < iColumnLength ) ? pxTransform->iColumnStep : 0;
+    pxTransform->iRowStep = ( 1 < iRowLength ) ? pxTransform->iRowStep : 0;
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewTransformSetScalar( xHUDViewTransform_t * pxTransform, int bScalar )
+{
+    pxTransform->bScalar = bScalar;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * pcHUDViewTransformKernels( void )
+{
+#if defined( HUDVIEW_TRANSFORM_NEON )
+    return "NEON";
+#elif defined( HUDVIEW_TRANSFORM_SSE2 )
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewTransformApply( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource,
+                             uint16_t * pusRGB565, uint8_t * pucLuma )
+{
+    int iWidth = pxTransform->xConfig.iDestinationWidth;
+    int iHeight = pxTransform->xConfig.iDestinationHeight;
+    eHUDViewTransformFilter_t eFilter = pxTransform->bExact ? eHUDViewTransformFilter_Nearest
+                                                            : pxTransform->xConfig.eFilter;
+
+    /* Tile by tile, so that however the source is walked, the rows of it in use at any one time stay in cache. */
+    for ( int iY0 = 0; iY0 < iHeight; iY0 += HUDVIEW_TRANSFORM_TILE_SIZE )
+    {
+        int iY1 = ( iY0 + HUDVIEW_TRANSFORM_TILE_SIZE < iHeight ) ? iY0 + HUDVIEW_TRANSFORM_TILE_SIZE : iHeight;
+
+        for ( int iX0 = 0; iX0 < iWidth; iX0 += HUDVIEW_TRANSFORM_TILE_SIZE )
+        {
+            int iX1 = ( iX0 + HUDVIEW_TRANSFORM_TILE_SIZE < iWidth ) ? iX0 + HUDVIEW_TRANSFORM_TILE_SIZE : iWidth;
+
+#if defined( HUDVIEW_TRANSFORM_NEON ) || defined( HUDVIEW_TRANSFORM_SSE2 )
+            if ( pxTransform->bExact && !pxTransform->bScalar && ( HUDVIEW_TRANSFORM_TILE_SIZE == iX1 - iX0 )
+                 && ( HUDVIEW_TRANSFORM_TILE_SIZE == iY1 - iY0 ) )
+            {
+                vTileExact( pxTransform, pucSource, pusRGB565, pucLuma, iX0, iY0 );
+                continue;
+            }
+#endif
+
+            switch ( eFilter )
+            {
+            case eHUDViewTransformFilter_Bilinear:
+                vTileBilinear( pxTransform, pucSource, pusRGB565, pucLuma, iX0, iY0, iX1, iY1 );
+                break;
+
+            case eHUDViewTransformFilter_Area:
+                vTileArea( pxTransform, pucSource, pusRGB565, pucLuma, iX0, iY0, iX1, iY1 );
+                break;
+
+            default:
+                vTileNearest( pxTransform, pucSource, pusRGB565, pucLuma, iX0, iY0, iX1, iY1 );
+                break;
+            }
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFillTaps( xHUDViewTransformTap_t * pxTaps, int iOutput, int iLength, int iOrigin, int iStep,
+                       int bReverse, eHUDViewTransformFilter_t eFilter )
+{
+    /* Samples are placed as if the region of interest had first been turned and mirrored exactly and then scaled, so
+     * reading backwards mirrors the source position rather than the output one. Taps always run forwards. */
+    for ( int iPosition = 0; iPosition < iOutput; iPosition++ )
+    {
+        int64_t llFirst = 0;
+        int64_t llLast = 0;
+        int iWeight = 0;
+        int iTaps = 1;
+
+        switch ( eFilter )
+        {
+        case eHUDViewTransformFilter_Bilinear:
+            /* Pixel centres line up: output centre i + 0.5 samples the source at ( i + 0.5 ) * scale - 0.5. */
+            llFirst = ( ( 2 * ( int64_t )iPosition + 1 ) * iLength * 256 ) / ( 2 * iOutput ) - 128;
+            llFirst = ( 0 > llFirst ) ? 0 : llFirst;
+            llFirst = ( ( iLength - 1 ) * 256 < llFirst ) ? ( iLength - 1 ) * 256 : llFirst;
+            llFirst = bReverse ? ( iLength - 1 ) * 256 - llFirst : llFirst;
+            iWeight = ( int )( llFirst & 255 );
+            llFirst >>= 8;
+
+            if ( llFirst >= iLength - 1 )
+            {
+                llFirst = ( 1 < iLength ) ? iLength - 2 : 0;
+                iWeight = ( 1 < iLength ) ? 256 : 0;
+            }
+            break;
+
+        case eHUDViewTransformFilter_Area:
+            /* Each output pixel averages the source pixels whose left edges fall within it, at least one. */
+            llFirst = ( int64_t )iPosition * iLength / iOutput;
+            llLast = ( ( int64_t )iPosition + 1 ) * iLength / iOutput;
+            llFirst = ( llFirst >= iLength ) ? iLength - 1 : llFirst;
+            llLast = ( llLast > llFirst ) ? llLast : llFirst + 1;
+            iTaps = ( int )( llLast - llFirst );
+            llFirst = bReverse ? iLength - llLast : llFirst;
+            break;
+
+        default:
+            llFirst = ( ( 2 * ( int64_t )iPosition + 1 ) * iLength ) / ( 2 * iOutput );
+            llFirst = ( llFirst >= iLength ) ? iLength - 1 : llFirst;
+            llFirst = bReverse ? iLength - 1 - llFirst : llFirst;
+            break;
+        }
+
+        pxTaps[ iPosition ].lOffset = ( int32_t )( ( iOrigin + llFirst ) * iStep );
+        pxTaps[ iPosition ].usWeight = ( uint16_t )iWeight;
+        pxTaps[ iPosition ].usTaps = ( uint16_t )iTaps;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vTileNearest( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                          uint8_t * pucLuma, int iX0, int iY0, int iX1, int iY1 )
+{
+    int iWidth = pxTransform->xConfig.iDestinationWidth;
+
+    for ( int iY = iY0; iY < iY1; iY++ )
+    {
+        const uint8_t * pucRow = pucSource + pxTransform->axRows[ iY ].lOffset;
+
+        for ( int iX = iX0; iX < iX1; iX++ )
+        {
+            const uint8_t * pucPixel = pucRow + pxTransform->axColumns[ iX ].lOffset;
+
+            pusRGB565[ iY * iWidth + iX ] = RGB565( pucPixel[ 0 ], pucPixel[ 1 ], pucPixel[ 2 ] );
+
+            if ( NULL != pucLuma )
+            {
+                pucLuma[ iY * iWidth + iX ] = HUDVIEW_FLOW_LUMA( pucPixel[ 0 ], pucPixel[ 1 ], pucPixel[ 2 ] );
+            }
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vTileBilinear( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                           uint8_t * pucLuma, int iX0, int iY0, int iX1, int iY1 )
+{
+    int iWidth = pxTransform->xConfig.iDestinationWidth;
+    int iColumnStep = pxTransform->iColumnStep;
+    int iRowStep = pxTransform->iRowStep;
+
+    for ( int iY = iY0; iY < iY1; iY++ )
+    {
+        const uint8_t * pucRow = pucSource + pxTransform->axRows[ iY ].lOffset;
+        uint32_t ulRowWeight = pxTransform->axRows[ iY ].usWeight;
+
+        for ( int iX = iX0; iX < iX1; iX++ )
+        {
+            const uint8_t * pucPixel = pucRow + pxTransform->axColumns[ iX ].lOffset;
+            uint32_t ulColumnWeight = pxTransform->axColumns[ iX ].usWeight;
+            uint8_t aucChannels[ 3 ];
+
+            /* 8-bit fixed point weights along each axis, rounded once at the end. */
+            for ( int iChannel = 0; iChannel < 3; iChannel++ )
+            {
+                uint32_t ulNear = pucPixel[ iChannel ] * ( 256 - ulColumnWeight )
+                                  + pucPixel[ iColumnStep + iChannel ] * ulColumnWeight;
+                uint32_t ulFar = pucPixel[ iRowStep + iChannel ] * ( 256 - ulColumnWeight )
+                                 + pucPixel[ iRowStep + iColumnStep + iChannel ] * ulColumnWeight;
+
+                aucChannels[ iChannel ] = ( uint8_t )( ( ulNear * ( 256 - ulRowWeight ) + ulFar * ulRowWeight
+                                                         + 32768 ) >> 16 );
+            }
+
+            pusRGB565[ iY * iWidth + iX ] = RGB565( aucChannels[ 0 ], aucChannels[ 1 ], aucChannels[ 2 ] );
+
+            if ( NULL != pucLuma )
+            {
+                pucLuma[ iY * iWidth + iX ] = HUDVIEW_FLOW_LUMA( aucChannels[ 0 ], aucChannels[ 1 ],
+                                                                 aucChannels[ 2 ] );
+            }
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vTileArea( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                       uint8_t * pucLuma, int iX0, int iY0, int iX1, int iY1 )
+{
+    int iWidth = pxTransform->xConfig.iDestinationWidth;
+    int iColumnStep = pxTransform->iColumnStep;
+    int iRowStep = pxTransform->iRowStep;
+
+    for ( int iY = iY0; iY < iY1; iY++ )
+    {
+        const uint8_t * pucRow = pucSource + pxTransform->axRows[ iY ].lOffset;
+        int iRowTaps = pxTransform->axRows[ iY ].usTaps;
+
+        for ( int iX = iX0; iX < iX1; iX++ )
+        {
+            const uint8_t * pucBox = pucRow + pxTransform->axColumns[ iX ].lOffset;
+            int iColumnTaps = pxTransform->axColumns[ iX ].usTaps;
+            uint32_t ulCount = ( uint32_t )( iRowTaps * iColumnTaps );
+            uint32_t aulSums[ 3 ] = { 0, 0, 0 };
+            uint8_t aucChannels[ 3 ];
+
+            for ( int iRowTap = 0; iRowTap < iRowTaps; iRowTap++ )
+            {
+                const uint8_t * pucPixel = pucBox + iRowTap * iRowStep;
+
+                for ( int iColumnTap = 0; iColumnTap < iColumnTaps; iColumnTap++ )
+                {
+                    aulSums[ 0 ] += pucPixel[ 0 ];
+                    aulSums[ 1 ] += pucPixel[ 1 ];
+                    aulSums[ 2 ] += pucPixel[ 2 ];
+                    pucPixel += iColumnStep;
+                }
+            }
+
+            for ( int iChannel = 0; iChannel < 3; iChannel++ )
+            {
+                aucChannels[ iChannel ] = ( uint8_t )( ( aulSums[ iChannel ] + ulCount / 2 ) / ulCount );
+            }
+
+            pusRGB565[ iY * iWidth + iX ] = RGB565( aucChannels[ 0 ], aucChannels[ 1 ], aucChannels[ 2 ] );
+
+            if ( NULL != pucLuma )
+            {
+                pucLuma[ iY * iWidth + iX ] = HUDVIEW_FLOW_LUMA( aucChannels[ 0 ], aucChannels[ 1 ],
+                                                                 aucChannels[ 2 ] );
+            }
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#if defined( HUDVIEW_TRANSFORM_NEON )
+static void vTranspose8x8( uint16x8_t * pxRows )
+{
+    uint16x8x2_t x01 = vtrnq_u16( pxRows[ 0 ], pxRows[ 1 ] );
+    uint16x8x2_t x23 = vtrnq_u16( pxRows[ 2 ], pxRows[ 3 ] );
+    uint16x8x2_t x45 = vtrnq_u16( pxRows[ 4 ], pxRows[ 5 ] );
+    uint16x8x2_t x67 = vtrnq_u16( pxRows[ 6 ], pxRows[ 7 ] );
+    uint32x4x2_t x02 = vtrnq_u32( vreinterpretq_u32_u16( x01.val[ 0 ] ), vreinterpretq_u32_u16( x23.val[ 0 ] ) );
+    uint32x4x2_t x13 = vtrnq_u32( vreinterpretq_u32_u16( x01.val[ 1 ] ), vreinterpretq_u32_u16( x23.val[ 1 ] ) );
+    uint32x4x2_t x46 = vtrnq_u32( vreinterpretq_u32_u16( x45.val[ 0 ] ), vreinterpretq_u32_u16( x67.val[ 0 ] ) );
+    uint32x4x2_t x57 = vtrnq_u32( vreinterpretq_u32_u16( x45.val[ 1 ] ), vreinterpretq_u32_u16( x67.val[ 1 ] ) );
+
+    /* Pairs and then quads of lanes are swapped in place; swapping the halves across rows four apart finishes it. */
+    pxRows[ 0 ] = vreinterpretq_u16_u32( vcombine_u32( vget_low_u32( x02.val[ 0 ] ), vget_low_u32( x46.val[ 0 ] ) ) );
+    pxRows[ 1 ] = vreinterpretq_u16_u32( vcombine_u32( vget_low_u32( x13.val[ 0 ] ), vget_low_u32( x57.val[ 0 ] ) ) );
+    pxRows[ 2 ] = vreinterpretq_u16_u32( vcombine_u32( vget_low_u32( x02.val[ 1 ] ), vget_low_u32( x46.val[ 1 ] ) ) );
+    pxRows[ 3 ] = vreinterpretq_u16_u32( vcombine_u32( vget_low_u32( x13.val[ 1 ] ), vget_low_u32( x57.val[ 1 ] ) ) );
+    pxRows[ 4 ] = vreinterpretq_u16_u32( vcombine_u32( vget_high_u32( x02.val[ 0 ] ),
+                                                       vget_high_u32( x46.val[ 0 ] ) ) );
+    pxRows[ 5 ] = vreinterpretq_u16_u32( vcombine_u32( vget_high_u32( x13.val[ 0 ] ),
+                                                       vget_high_u32( x57.val[ 0 ] ) ) );
+    pxRows[ 6 ] = vreinterpretq_u16_u32( vcombine_u32( vget_high_u32( x02.val[ 1 ] ),
+                                                       vget_high_u32( x46.val[ 1 ] ) ) );
+    pxRows[ 7 ] = vreinterpretq_u16_u32( vcombine_u32( vget_high_u32( x13.val[ 1 ] ),
+                                                       vget_high_u32( x57.val[ 1 ] ) ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vTileExact( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                        uint8_t * pucLuma, int iX0, int iY0 )
+{
+    int iWidth = pxTransform->xConfig.iDestinationWidth;
+    int iStride = pxTransform->xConfig.iSourceStride;
+    const uint8_t * pucTile = pucSource
+                              + pxTransform->axColumns[ pxTransform->bReverseColumns ? iX0 + 7 : iX0 ].lOffset
+                              + pxTransform->axRows[ pxTransform->bReverseRows ? iY0 + 7 : iY0 ].lOffset;
+    uint16x8_t axColours[ HUDVIEW_TRANSFORM_TILE_SIZE ];
+    uint16x8_t axLuma[ HUDVIEW_TRANSFORM_TILE_SIZE ];
+
+    /* Deinterleave and convert each row of the source tile: RGB565 by shift-insert, luma by widening multiplies. */
+    for ( int iRow = 0; iRow < HUDVIEW_TRANSFORM_TILE_SIZE; iRow++ )
+    {
+        uint8x8x3_t xPixels = vld3_u8( pucTile + iRow * iStride );
+        uint16x8_t xColour = vshll_n_u8( xPixels.val[ 0 ], 8 );
+        uint16x8_t xLuma = vmull_u8( xPixels.val[ 0 ], vdup_n_u8( 77 ) );
+
+        xColour = vsriq_n_u16( xColour, vshll_n_u8( xPixels.val[ 1 ], 8 ), 5 );
+        xColour = vsriq_n_u16( xColour, vshll_n_u8( xPixels.val[ 2 ], 8 ), 11 );
+        xLuma = vmlal_u8( xLuma, xPixels.val[ 1 ], vdup_n_u8( 150 ) );
+        xLuma = vmlal_u8( xLuma, xPixels.val[ 2 ], vdup_n_u8( 29 ) );
+        axColours[ iRow ] = xColour;
+        axLuma[ iRow ] = vrshrq_n_u16( xLuma, 8 );
+    }
+
+    if ( pxTransform->bTranspose )
+    {
+        vTranspose8x8( axColours );
+        vTranspose8x8( axLuma );
+    }
+
+    for ( int iRow = 0; iRow < HUDVIEW_TRANSFORM_TILE_SIZE; iRow++ )
+    {
+        int iFrom = pxTransform->bReverseRows ? HUDVIEW_TRANSFORM_TILE_SIZE - 1 - iRow : iRow;
+        uint16x8_t xColour = axColours[ iFrom ];
+        uint16x8_t xLuma = axLuma[ iFrom ];
+
+        if ( pxTransform->bReverseColumns )
+        {
+            xColour = vrev64q_u16( xColour );
+            xColour = vcombine_u16( vget_high_u16( xColour ), vget_low_u16( xColour ) );
+            xLuma = vrev64q_u16( xLuma );
+            xLuma = vcombine_u16( vget_high_u16( xLuma ), vget_low_u16( xLuma ) );
+        }
+
+        vst1q_u16( pusRGB565 + ( iY0 + iRow ) * iWidth + iX0, xColour );
+
+        if ( NULL != pucLuma )
+        {
+            vst1_u8( pucLuma + ( iY0 + iRow ) * iWidth + iX0, vmovn_u16( xLuma ) );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+#elif defined( HUDVIEW_TRANSFORM_SSE2 )
+static void vTranspose8x8( __m128i * pxRows )
+{
+    __m128i x0 = _mm_unpacklo_epi16( pxRows[ 0 ], pxRows[ 1 ] );
+    __m128i x1 = _mm_unpackhi_epi16( pxRows[ 0 ], pxRows[ 1 ] );
+    __m128i x2 = _mm_unpacklo_epi16( pxRows[ 2 ], pxRows[ 3 ] );
+    __m128i x3 = _mm_unpackhi_epi16( pxRows[ 2 ], pxRows[ 3 ] );
+    __m128i x4 = _mm_unpacklo_epi16( pxRows[ 4 ], pxRows[ 5 ] );
+    __m128i x5 = _mm_unpackhi_epi16( pxRows[ 4 ], pxRows[ 5 ] );
+    __m128i x6 = _mm_unpacklo_epi16( pxRows[ 6 ], pxRows[ 7 ] );
+    __m128i x7 = _mm_unpackhi_epi16( pxRows[ 6 ], pxRows[ 7 ] );
+    __m128i y0 = _mm_unpacklo_epi32( x0, x2 );
+    __m128i y1 = _mm_unpackhi_epi32( x0, x2 );
+    __m128i y2 = _mm_unpacklo_epi32( x1, x3 );
+    __m128i y3 = _mm_unpackhi_epi32( x1, x3 );
+    __m128i y4 = _mm_unpacklo_epi32( x4, x6 );
+    __m128i y5 = _mm_unpackhi_epi32( x4, x6 );
+    __m128i y6 = _mm_unpacklo_epi32( x5, x7 );
+    __m128i y7 = _mm_unpackhi_epi32( x5, x7 );
+
+    /* Interleave lanes, then pairs of lanes, then halves: each step doubles the run of one column kept together. */
+    pxRows[ 0 ] = _mm_unpacklo_epi64( y0, y4 );
+    pxRows[ 1 ] = _mm_unpackhi_epi64( y0, y4 );
+    pxRows[ 2 ] = _mm_unpacklo_epi64( y1, y5 );
+    pxRows[ 3 ] = _mm_unpackhi_epi64( y1, y5 );
+    pxRows[ 4 ] = _mm_unpacklo_epi64( y2, y6 );
+    pxRows[ 5 ] = _mm_unpackhi_epi64( y2, y6 );
+    pxRows[ 6 ] = _mm_unpacklo_epi64( y3, y7 );
+    pxRows[ 7 ] = _mm_unpackhi_epi64( y3, y7 );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vTileExact( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource, uint16_t * pusRGB565,
+                        uint8_t * pucLuma, int iX0, int iY0 )
+{
+    int iWidth = pxTransform->xConfig.iDestinationWidth;
+    int iStride = pxTransform->xConfig.iSourceStride;
+    const uint8_t * pucTile = pucSource
+                              + pxTransform->axColumns[ pxTransform->bReverseColumns ? iX0 + 7 : iX0 ].lOffset
+                              + pxTransform->axRows[ pxTransform->bReverseRows ? iY0 + 7 : iY0 ].lOffset;
+    __m128i axColours[ HUDVIEW_TRANSFORM_TILE_SIZE ];
+    __m128i axLuma[ HUDVIEW_TRANSFORM_TILE_SIZE ];
+
+    /* SSE2 has no three-way deinterleave, so channels are gathered a pixel at a time and converted eight at once. */
+    for ( int iRow = 0; iRow < HUDVIEW_TRANSFORM_TILE_SIZE; iRow++ )
+    {
+        const uint8_t * pucPixel = pucTile + iRow * iStride;
+        __m128i xRed;
+        __m128i xGreen;
+        __m128i xBlue;
+        __m128i xLuma;
+
+        xRed = _mm_setr_epi16( pucPixel[ 0 ], pucPixel[ 3 ], pucPixel[ 6 ], pucPixel[ 9 ], pucPixel[ 12 ],
+                               pucPixel[ 15 ], pucPixel[ 18 ], pucPixel[ 21 ] );
+        xGreen = _mm_setr_epi16( pucPixel[ 1 ], pucPixel[ 4 ], pucPixel[ 7 ], pucPixel[ 10 ], pucPixel[ 13 ],
+                                 pucPixel[ 16 ], pucPixel[ 19 ], pucPixel[ 22 ] );
+        xBlue = _mm_setr_epi16( pucPixel[ 2 ], pucPixel[ 5 ], pucPixel[ 8 ], pucPixel[ 11 ], pucPixel[ 14 ],
+                                pucPixel[ 17 ], pucPixel[ 20 ], pucPixel[ 23 ] );
+
+        axColours[ iRow ] = _mm_or_si128( _mm_or_si128( _mm_slli_epi16( _mm_srli_epi16( xRed, 3 ), 11 ),
+                                                        _mm_slli_epi16( _mm_srli_epi16( xGreen, 2 ), 5 ) ),
+                                          _mm_srli_epi16( xBlue, 3 ) );
+        xLuma = _mm_add_epi16( _mm_mullo_epi16( xRed, _mm_set1_epi16( 77 ) ),
+                               _mm_mullo_epi16( xGreen, _mm_set1_epi16( 150 ) ) );
+        xLuma = _mm_add_epi16( xLuma, _mm_mullo_epi16( xBlue, _mm_set1_epi16( 29 ) ) );
+        axLuma[ iRow ] = _mm_srli_epi16( _mm_add_epi16( xLuma, _mm_set1_epi16( 128 ) ), 8 );
+    }
+
+    if ( pxTransform->bTranspose )
+    {
+        vTranspose8x8( axColours );
+        vTranspose8x8( axLuma );
+    }
+
+    for ( int iRow = 0; iRow < HUDVIEW_TRANSFORM_TILE_SIZE; iRow++ )
+    {
+        int iFrom = pxTransform->bReverseRows ? HUDVIEW_TRANSFORM_TILE_SIZE - 1 - iRow : iRow;
+        __m128i xColour = axColours[ iFrom ];
+        __m128i xLuma = axLuma[ iFrom ];
+
+        if ( pxTransform->bReverseColumns )
+        {
+            xColour = _mm_shuffle_epi32( _mm_shufflehi_epi16( _mm_shufflelo_epi16( xColour, 0x1B ), 0x1B ), 0x4E );
+            xLuma = _mm_shuffle_epi32( _mm_shufflehi_epi16( _mm_shufflelo_epi16( xLuma, 0x1B ), 0x1B ), 0x4E );
+        }
+
+        _mm_storeu_si128( ( __m128i * )( pusRGB565 + ( iY0 + iRow ) * iWidth + iX0 ), xColour );
+
+        if ( NULL != pucLuma )
+        {
+            _mm_storel_epi64( ( __m128i * )( pucLuma + ( iY0 + iRow ) * iWidth + iX0 ),
+                              _mm_packus_epi16( xLuma, xLuma ) );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+#endif
@@ -0,0 +1,120 @@
+/** @file hudview_transform.h
+ *  @brief HUDView camera frame orientation, crop and scaling.
+ *
+ *  Raw RGB888 frames from the camera are cropped to a region of interest, rotated by a multiple of 90 degrees,
+ *  mirrored and scaled to the display geometry, and converted to RGB565 for the display and to luma for the rear
+ *  vision, all in a single pass over the frame. Whatever the orientation, each output column maps onto one source
+ *  axis and each output row onto the other, so the whole transform reduces to two small tables of source offsets
+ *  (and filter weights) worked out once when it is configured. The output is produced in 8x8 tiles so that a rotated
+ *  frame, which reads the source down its columns, stays within a few cache lines at a time. When the region of
+ *  interest is the size of the output, each tile is a straight rotation and/or mirror of a source tile, which is
+ *  converted row by row and transposed and reversed in registers (NEON or SSE2 when the compiler targets them); the
+ *  scalar path can be selected at run time to compare the two. All state is fixed-size and nothing is allocated.
+ */
+
+#ifndef HUDVIEW_TRANSFORM_H
+#define HUDVIEW_TRANSFORM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define HUDVIEW_TRANSFORM_TILE_SIZE             ( 8 )
+#define HUDVIEW_TRANSFORM_MAXIMUM_OUTPUT        ( 256 )
+#define HUDVIEW_TRANSFORM_MAXIMUM_SOURCE        ( 4096 )
+
+/* The camera pads raw output to a multiple of 32 pixels across and 16 lines down. */
+#define HUDVIEW_TRANSFORM_CAPTURE_WIDTH_ALIGN   ( 32 )
+#define HUDVIEW_TRANSFORM_CAPTURE_HEIGHT_ALIGN  ( 16 )
+#define HUDVIEW_TRANSFORM_ALIGN( iValue, iAlign ) ( ( ( iValue ) + ( iAlign ) - 1 ) / ( iAlign ) * ( iAlign ) )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eHUDViewTransformFilterMin = 0,
+
+    eHUDViewTransformFilter_Nearest = eHUDViewTransformFilterMin,
+    eHUDViewTransformFilter_Bilinear,
+    eHUDViewTransformFilter_Area,
+
+    eHUDViewTransformFilterMax
+} eHUDViewTransformFilter_t;
+
+typedef struct {
+    /* Camera geometry; a zero stride means the camera's padded stride for the width. */
+    int iSourceWidth;
+    int iSourceHeight;
+    int iSourceStride;
+
+    /* Region of interest in camera pixels, before rotation; a zero width means the largest centred region with the
+     * aspect ratio of the output, so the picture is never stretched. */
+    int iCropX;
+    int iCropY;
+    int iCropWidth;
+    int iCropHeight;
+
+    /* Clockwise rotation in degrees, then mirroring of the rotated picture. */
+    int iRotation;
+    int bFlipHorizontal;
+    int bFlipVertical;
+
+    eHUDViewTransformFilter_t eFilter;
+
+    /* The camera sends MJPEG rather than raw RGB888; the frames are decoded (see hudview_jpeg.h) before this. */
+    int bMJPEG;
+
+    int iDestinationWidth;
+    int iDestinationHeight;
+} xHUDViewTransformConfig_t;
+
+/* Where an output column (or row) samples along its source axis: the byte offset of the first sample, the weight of
+ * the next one out of 256 for bilinear filtering, and how many samples are averaged for area filtering. */
+typedef struct {
+    int32_t lOffset;
+    uint16_t usWeight;
+    uint16_t usTaps;
+} xHUDViewTransformTap_t;
+
+typedef struct {
+    int bScalar;
+    xHUDViewTransformConfig_t xConfig;
+
+    xHUDViewTransformTap_t axColumns[ HUDVIEW_TRANSFORM_MAXIMUM_OUTPUT ];
+    xHUDViewTransformTap_t axRows[ HUDVIEW_TRANSFORM_MAXIMUM_OUTPUT ];
+
+    /* Bytes between neighbouring samples along the source axis that output columns and output rows map onto. */
+    int iColumnStep;
+    int iRowStep;
+
+    /* Output rows run down source columns (a quarter turn), and the source is read backwards along either axis. */
+    int bTranspose;
+    int bReverseColumns;
+    int bReverseRows;
+
+    /* The region of interest is the size of the output, so every pixel is copied rather than filtered. */
+    int bExact;
+} xHUDViewTransform_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void vHUDViewTransformDefaultConfig( xHUDViewTransformConfig_t * pxConfig, int iDestinationWidth,
+                                     int iDestinationHeight );
+int iHUDViewTransformParse( const char * pcSpecification, xHUDViewTransformConfig_t * pxConfig );
+int iHUDViewTransformFormat( const xHUDViewTransformConfig_t * pxConfig, char * pcSpecification, int iLength );
+int iHUDViewTransformSourceBytes( const xHUDViewTransformConfig_t * pxConfig );
+const char * pcHUDViewTransformFilterName( eHUDViewTransformFilter_t eFilter );
+
+int iHUDViewTransformInit( xHUDViewTransform_t * pxTransform, const xHUDViewTransformConfig_t * pxConfig );
+void vHUDViewTransformSetScalar( xHUDViewTransform_t * pxTransform, int bScalar );
+const char * pcHUDViewTransformKernels( void );
+
+void vHUDViewTransformApply( const xHUDViewTransform_t * pxTransform, const uint8_t * pucSource,
+                             uint16_t * pusRGB565, uint8_t * pucLuma );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+} //extern "C"
+#endif
+
+#endif // HUDVIEW_TRANSFORM_H
@@ -15,21 +15,23 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
-    src/main.cpp \
-    src/controlengine.cpp
+    src/main.cpp
+
+# Everything except main() lives in control.pri so the benchmarks can build against the same sources.
+include(control.pri)
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
-HEADERS += \
-    src/controlengine.h \
-    src/ubuntumono.h
-
-unix:!macx: LIBS += -L$$PWD/../Display/ssd1306/bld/ -lssd1306
-
-INCLUDEPATH += $$PWD/../Display/ssd1306/src
-DEPENDPATH += $$PWD/../Display/ssd1306/bld
+# "make bench" builds the microbenchmarks against the same configuration and writes their results as JSON.
+headless: BENCH_QMAKE_ARGS = CONFIG+=headless
+bench.commands = $(MKDIR) bench && cd bench && $(QMAKE) $$PWD/bench/bench.pro $$BENCH_QMAKE_ARGS && $(MAKE) \
+                 && ./ControlBench --output $$OUT_PWD/bench_results.json
+QMAKE_EXTRA_TARGETS += bench
 
-unix:!macx: PRE_TARGETDEPS += $$PWD/../Display/ssd1306/bld/libssd1306.a
+# "make golden" renders the display screens headless and fails if any differs from its frame in bench/golden.
+golden.commands = $(MKDIR) bench && cd bench && $(QMAKE) $$PWD/bench/bench.pro $$BENCH_QMAKE_ARGS && $(MAKE) \
+                  && ./ControlBench --golden $$PWD/bench/golden
+QMAKE_EXTRA_TARGETS += golden
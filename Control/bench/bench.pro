@@ -0,0 +1,18 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = ControlBench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    src/goldenframes.cpp \
+    src/main.cpp
+
+HEADERS += \
+    src/goldenframes.h
+
+# Benchmark the same sources the application is built from.
+include(../control.pri)
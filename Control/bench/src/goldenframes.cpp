@@ -0,0 +1,255 @@
+#include <cstdio>
+#include <vector>
+
+#include "displaycompositor.h"
+#include "framebufferbackend.h"
+#include "goldenframes.h"
+#include "hudlayout.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* The camera feed's picture size. */
+static const int GOLDEN_CAMERA_WIDTH = 160;
+static const int GOLDEN_CAMERA_HEIGHT = 120;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+enum eGoldenScreen_t {
+    eGoldenScreenMin = 0,
+
+    eGoldenScreen_Splash,
+    eGoldenScreen_HUD,
+    eGoldenScreen_HUDAlert,
+    eGoldenScreen_HUDSlide,
+    eGoldenScreen_Camera,
+    eGoldenScreen_CameraRGB444,
+
+    eGoldenScreenMax
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const char * pcGoldenScreenName( eGoldenScreen_t eScreen );
+static void vDrawGoldenScreen( DisplayCompositor & Compositor, eGoldenScreen_t eScreen );
+static void vFillCameraFrame( std::vector<uint16_t> & ausFrame );
+static bool bReadPPM( const std::string & sPath, std::vector<uint8_t> & aucRGB );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int GoldenFrames::iCheck( const std::string & sDirectory, bool bUpdate )
+{
+    int iFailures = 0;
+
+    for ( int iScreen = eGoldenScreenMin + 1; iScreen < eGoldenScreenMax; iScreen++ )
+    {
+        eGoldenScreen_t eScreen = static_cast<eGoldenScreen_t>( iScreen );
+        std::string sName = pcGoldenScreenName( eScreen );
+        std::string sReferencePath = sDirectory + "/" + sName + ".ppm";
+        FramebufferDisplayBackend Framebuffer;
+        DisplayCompositor Compositor;
+        std::vector<uint8_t> aucActual;
+        std::vector<uint8_t> aucReference;
+        long lDifferences = 0;
+
+        /* Every screen starts from a blank panel, so none depends on what was drawn before it. */
+        Framebuffer.bInit();
+        Compositor.bInit( &Framebuffer );
+        vDrawGoldenScreen( Compositor, eScreen );
+        Framebuffer.vToRGB888( aucActual );
+
+        if ( bUpdate )
+        {
+            if ( Framebuffer.bWritePPM( sReferencePath ) )
+            {
+                fprintf( stderr, "%-32s written\n", sName.c_str() );
+            }
+            else
+            {
+                fprintf( stderr, "%-32s failed to write %s\n", sName.c_str(), sReferencePath.c_str() );
+                iFailures++;
+            }
+        }
+        else if ( !bReadPPM( sReferencePath, aucReference ) || ( aucReference.size() != aucActual.size() ) )
+        {
+            fprintf( stderr, "%-32s no usable reference frame %s\n", sName.c_str(), sReferencePath.c_str() );
+            iFailures++;
+        }
+        else
+        {
+            for ( size_t ulPixel = 0; ulPixel < aucActual.size() / 3; ulPixel++ )
+            {
+                if ( ( aucActual[ ulPixel * 3 + 0 ] != aucReference[ ulPixel * 3 + 0 ] )
+                     || ( aucActual[ ulPixel * 3 + 1 ] != aucReference[ ulPixel * 3 + 1 ] )
+                     || ( aucActual[ ulPixel * 3 + 2 ] != aucReference[ ulPixel * 3 + 2 ] ) )
+                {
+                    lDifferences++;
+                }
+            }
+
+            if ( 0 == lDifferences )
+            {
+                fprintf( stderr, "%-32s matches\n", sName.c_str() );
+            }
+            else
+            {
+                fprintf( stderr, "%-32s %ld pixels differ, see %s.actual.ppm\n", sName.c_str(), lDifferences,
+                         sName.c_str() );
+                ( void )Framebuffer.bWritePPM( sName + ".actual.ppm" );
+                iFailures++;
+            }
+        }
+    }
+
+    return iFailures;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const char * pcGoldenScreenName( eGoldenScreen_t eScreen )
+{
+    const char * pcReturn = "unknown";
+
+    switch ( eScreen )
+    {
+        case eGoldenScreen_Splash:
+            pcReturn = "splash";
+            break;
+
+        case eGoldenScreen_HUD:
+            pcReturn = "hud";
+            break;
+
+        case eGoldenScreen_HUDAlert:
+            pcReturn = "hud_alert";
+            break;
+
+        case eGoldenScreen_HUDSlide:
+            pcReturn = "hud_slide";
+            break;
+
+        case eGoldenScreen_Camera:
+            pcReturn = "camera";
+            break;
+
+        case eGoldenScreen_CameraRGB444:
+            pcReturn = "camera_rgb444";
+            break;
+
+        default:
+            break;
+    }
+
+    return pcReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDrawGoldenScreen( DisplayCompositor & Compositor, eGoldenScreen_t eScreen )
+{
+    uint16_t usWhite = DisplayCompositor::usRGB565( 255, 255, 255 );
+    std::vector<uint16_t> ausFrame;
+    xHUDViewHeadlightsMarker_t xMarker = xHUDViewHeadlightsMarker_t();
+
+    switch ( eScreen )
+    {
+        case eGoldenScreen_Splash:
+            HUDLayout::vDrawSplash( Compositor );
+            break;
+
+        case eGoldenScreen_HUD:
+            HUDLayout::vDrawReading( Compositor, HUDLayout::READING_X, "12:34", usWhite );
+            break;
+
+        /* In the dark the reading turns red and dims; the alert stays bright. */
+        case eGoldenScreen_HUDAlert:
+            HUDLayout::vDrawReading( Compositor, HUDLayout::READING_X, "27?", DisplayCompositor::usRGB565( 96, 0, 0 ) );
+            HUDLayout::vDrawRearAlert( Compositor );
+            break;
+
+        /* Halfway through a mode change on the panel's own scrolling, as ControlEngine::vSlideMode() leaves it. */
+        case eGoldenScreen_HUDSlide:
+            HUDLayout::vDrawReading( Compositor, HUDLayout::READING_X, "12:34", usWhite );
+            Compositor.vCompose();
+            Compositor.vScroll( DisplayCompositor::DISPLAY_WIDTH / 2 );
+            Compositor.vClearOverlay();
+            HUDLayout::vDrawReading( Compositor, HUDLayout::READING_X - DisplayCompositor::DISPLAY_WIDTH / 2, "12:34",
+                                     usWhite );
+            HUDLayout::vDrawReading( Compositor, HUDLayout::READING_X + DisplayCompositor::DISPLAY_WIDTH / 2, "45",
+                                     usWhite );
+            break;
+
+        case eGoldenScreen_Camera:
+        case eGoldenScreen_CameraRGB444:
+            if ( eGoldenScreen_CameraRGB444 == eScreen )
+            {
+                ( void )Compositor.bSetCameraPixelFormat( DisplayBackend::ePixelFormat_RGB444, true );
+            }
+
+            vFillCameraFrame( ausFrame );
+            Compositor.vSetCameraFrame( ausFrame.data(), GOLDEN_CAMERA_WIDTH, GOLDEN_CAMERA_HEIGHT );
+
+            /* One vehicle closing in and one holding back, as the headlight tracker marks them at night. */
+            xMarker.iX = 20;
+            xMarker.iY = 20;
+            xMarker.iWidth = 24;
+            xMarker.iHeight = 8;
+            xMarker.bClosing = 1;
+            HUDLayout::vDrawHeadlightMarker( Compositor, xMarker );
+            xMarker.iX = 104;
+            xMarker.iY = 60;
+            xMarker.iWidth = 12;
+            xMarker.iHeight = 4;
+            xMarker.bClosing = 0;
+            HUDLayout::vDrawHeadlightMarker( Compositor, xMarker );
+
+            HUDLayout::vDrawReading( Compositor, HUDLayout::READING_X, "45", usWhite );
+            HUDLayout::vDrawRearAlert( Compositor );
+            break;
+
+        default:
+            break;
+    }
+
+    Compositor.vCompose();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFillCameraFrame( std::vector<uint16_t> & ausFrame )
+{
+    ausFrame.resize( GOLDEN_CAMERA_WIDTH * GOLDEN_CAMERA_HEIGHT );
+
+    /* Smooth gradients to show banding and dither, and a bright block with hard edges to show scaling. */
+    for ( int iY = 0; iY < GOLDEN_CAMERA_HEIGHT; iY++ )
+    {
+        for ( int iX = 0; iX < GOLDEN_CAMERA_WIDTH; iX++ )
+        {
+            bool bBlock = ( 64 <= iX ) && ( 96 > iX ) && ( 16 <= iY ) && ( 40 > iY );
+
+            ausFrame[ iY * GOLDEN_CAMERA_WIDTH + iX ] =
+                bBlock ? DisplayCompositor::usRGB565( 240, 240, 200 )
+                       : DisplayCompositor::usRGB565( static_cast<uint8_t>( iX * 255 / ( GOLDEN_CAMERA_WIDTH - 1 ) ),
+                                                      static_cast<uint8_t>( iY * 255 / ( GOLDEN_CAMERA_HEIGHT - 1 ) ),
+                                                      96 );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static bool bReadPPM( const std::string & sPath, std::vector<uint8_t> & aucRGB )
+{
+    FILE * pFile = fopen( sPath.c_str(), "rb" );
+    int iWidth = 0;
+    int iHeight = 0;
+    int iMaximum = 0;
+    bool bReturn = false;
+
+    if ( nullptr != pFile )
+    {
+        /* Only what FramebufferDisplayBackend::bWritePPM() writes: binary, 8 bits a channel, one whitespace after. */
+        if ( ( 3 == fscanf( pFile, "P6 %d %d %d", &iWidth, &iHeight, &iMaximum ) ) && ( 255 == iMaximum )
+             && ( 0 < iWidth ) && ( 0 < iHeight ) && ( EOF != fgetc( pFile ) ) )
+        {
+            aucRGB.resize( static_cast<size_t>( iWidth ) * iHeight * 3 );
+            bReturn = ( aucRGB.size() == fread( aucRGB.data(), 1, aucRGB.size(), pFile ) );
+        }
+
+        fclose( pFile );
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
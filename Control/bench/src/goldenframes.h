@@ -0,0 +1,16 @@
+#ifndef GOLDENFRAMES_H
+#define GOLDENFRAMES_H
+
+#include <string>
+
+/* Renders the screens Control shows through the compositor into the framebuffer backend, headless, and compares each
+ * with its reference frame <directory>/<screen>.ppm. A frame that differs is written to <screen>.actual.ppm in the
+ * working directory for inspection. With bUpdate set the reference frames are rewritten instead. */
+class GoldenFrames
+{
+public:
+    /* Returns the number of screens that did not match, or could not be checked or written. */
+    static int iCheck( const std::string & sDirectory, bool bUpdate );
+};
+
+#endif // GOLDENFRAMES_H
@@ -0,0 +1,952 @@
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <functional>
+#include <sched.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "approachdetector.h"
+#include "componenthandler.h"
+#include "componentprocess.h"
+#include "controlengine.h"
+#include "displaycompositor.h"
+#include "flightrecorder.h"
+#include "framebufferbackend.h"
+#include "goldenframes.h"
+#include "hudview_rgb444.h"
+#include "hudview_trace.h"
+#include "hudview_transform.h"
+#include "latencytracer.h"
+#include "motionestimator.h"
+#include "timingbackend.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Each benchmark is timed over several batches of at least this long, and the median batch is reported. */
+static const qint64 MINIMUM_BATCH_NANOSECONDS = 100000000;
+static const int BATCH_COUNT = 5;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+struct xBenchmarkResult_t {
+    QString sName;
+    qint64 llIterations;
+    double dMedianNanoseconds;
+    double dMinimumNanoseconds;
+};
+
+/* Display frames are paced like the camera path, and a frame counts as late once it slips by more than 1 ms. */
+static const qint64 JITTER_FRAME_PERIOD_NANOSECONDS = 1000000000LL / 30;
+static const qint64 JITTER_LATE_NANOSECONDS = 1000000;
+
+struct xJitterResult_t {
+    QString sName;
+    QString sOptions;
+    long lFrames;
+    long lLateFrames;
+    double dMeanIntervalMicroseconds;
+    double dStandardDeviationMicroseconds;
+    double dP99DeviationMicroseconds;
+    double dMaximumDeviationMicroseconds;
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* What a picture that moves sideways costs the display link: a mode change made at once, or slid in over a quarter
+ * of a second, and the heading tape and speed strip. Each is drawn by repainting the whole panel every frame, as
+ * clear-and-redraw did, by pushing only the changed columns, and with the panel's hardware scrolling. */
+enum eScrollScene_t {
+    eScrollSceneMin = 0,
+
+    eScrollScene_ModeChange,
+    eScrollScene_ModeSlide,
+    eScrollScene_HeadingTape,
+    eScrollScene_SpeedStrip,
+
+    eScrollSceneMax
+};
+
+enum eScrollMethod_t {
+    eScrollMethodMin = 0,
+
+    eScrollMethod_Clear,
+    eScrollMethod_Columns,
+    eScrollMethod_Scroll,
+
+    eScrollMethodMax
+};
+
+static const int SCROLL_SLIDE_STEP_PIXELS = 16;
+static const int SCROLL_TAPE_PIXELS_PER_DEGREE = 4;
+static const int SCROLL_TAPE_FRAMES = 90;
+static const int SCROLL_STRIP_X = 64;
+static const int SCROLL_STRIP_BAR_PIXELS = 2;
+static const int SCROLL_STRIP_FRAMES = 120;
+
+struct xScrollResult_t {
+    QString sName;
+    long lFrames;
+    double dKilobytes;
+    unsigned long ulTransfers;
+    double dWireMilliseconds;
+    double dMaximumFrameMilliseconds;
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Results are accumulated here so the compiler cannot discard the work being measured. */
+static volatile double dSink = 0.0;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDiscardMessages( QtMsgType eType, const QMessageLogContext & xContext, const QString & sMessage );
+static xBenchmarkResult_t xRunBenchmark( const QString & sName, const std::function<void()> & fnOperation );
+static QList<pid_t> lstStartLoad( int iProcesses, const ComponentProcess::xSchedulingOptions_t & xOptions );
+static void vStopLoad( const QList<pid_t> & lstProcesses );
+static xJitterResult_t xRunJitter( const QString & sName, const ComponentProcess::xSchedulingOptions_t & xOptions,
+                                   const ComponentProcess::xSchedulingOptions_t & xLoadOptions, qint64 llNanoseconds );
+static xScrollResult_t xRunScroll( eScrollScene_t eScene, eScrollMethod_t eMethod );
+static int iDrawScrollScene( DisplayCompositor & Compositor, eScrollScene_t eScene, int iFrame );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char * argv[] )
+{
+    QCoreApplication App( argc, argv );
+    QCoreApplication::setApplicationName( "HUDView Control Benchmarks" );
+    QCoreApplication::setApplicationVersion( "1.0.0" );
+
+    /* Parse the command line arguments. */
+    QCommandLineParser Parser;
+    QCommandLineOption OutputOption( QStringList() << "o" << "output",
+                                     QCoreApplication::translate( "main", "Write the JSON results to the specified "
+                                                                  "file." ),
+                                     QCoreApplication::translate( "main", "path" ) );
+    QCommandLineOption FilterOption( QStringList() << "f" << "filter",
+                                     QCoreApplication::translate( "main", "Only run benchmarks whose name contains the "
+                                                                  "specified text." ),
+                                     QCoreApplication::translate( "main", "text" ) );
+    QCommandLineOption CommitOption( QStringList() << "commit",
+                                     QCoreApplication::translate( "main", "Tag the results with the specified "
+                                                                  "commit." ),
+                                     QCoreApplication::translate( "main", "id" ) );
+    QCommandLineOption JitterOption( QStringList() << "jitter",
+                                     QCoreApplication::translate( "main", "Also measure display frame interval jitter "
+                                                                  "under CPU load for the specified number of seconds "
+                                                                  "per scheduling configuration." ),
+                                     QCoreApplication::translate( "main", "seconds" ) );
+    QCommandLineOption GoldenOption( QStringList() << "golden",
+                                     QCoreApplication::translate( "main", "Instead of benchmarking, render the display "
+                                                                  "screens and compare them with the reference frames "
+                                                                  "in the specified directory." ),
+                                     QCoreApplication::translate( "main", "directory" ) );
+    QCommandLineOption UpdateGoldenOption( QStringList() << "update-golden",
+                                           QCoreApplication::translate( "main", "With --golden, rewrite the reference "
+                                                                        "frames from what is rendered now." ) );
+    Parser.setApplicationDescription( "HUDView Control Microbenchmarks" );
+    Parser.addHelpOption();
+    Parser.addVersionOption();
+    Parser.addOption( OutputOption );
+    Parser.addOption( FilterOption );
+    Parser.addOption( CommitOption );
+    Parser.addOption( JitterOption );
+    Parser.addOption( GoldenOption );
+    Parser.addOption( UpdateGoldenOption );
+    Parser.process( App );
+
+    /* The golden check stands alone, so a mismatch fails the run without waiting for the benchmarks. */
+    if ( Parser.isSet( GoldenOption ) )
+    {
+        return ( 0 == GoldenFrames::iCheck( Parser.value( GoldenOption ).toStdString(),
+                                            Parser.isSet( UpdateGoldenOption ) ) ) ? 0 : 1;
+    }
+
+    QList<QPair<QString, std::function<void()>>> lstBenchmarks;
+    QJsonArray Results;
+    QTemporaryDir TemporaryDirectory;
+
+    if ( !TemporaryDirectory.isValid() )
+    {
+        fprintf( stderr, "Failed to create a temporary directory: %s\n",
+                 TemporaryDirectory.errorString().toLocal8Bit().constData() );
+        return -1;
+    }
+
+    /* The code under test logs on every sample; keep that cost but not the output. */
+    qInstallMessageHandler( vDiscardMessages );
+
+    /* Representative component output. */
+    const QByteArray AccelerometerSample( "0.012345,-0.987654,9.806650\n" );
+    const QByteArray GPSSample( "GPRMC,194509.000,A,4042.6142,N,07400.4168,W,2.03,221.11,160412,,,A\n" );
+
+    /* A config file registering every sensor component, pointing at a program that is guaranteed to exist. */
+    const QString sConfigPath = TemporaryDirectory.filePath( "bench.conf" );
+    const QString sProgram = QCoreApplication::applicationFilePath();
+    QFile ConfigFile( sConfigPath );
+
+    if ( !ConfigFile.open( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        fprintf( stderr, "Failed to write the bench config file %s\n", sConfigPath.toLocal8Bit().constData() );
+        return -1;
+    }
+
+    QTextStream Stream( &ConfigFile );
+    Stream << "Accelerometer:" << sProgram << "\n"
+           << "GPS:" << sProgram << "\n"
+           << "HandlebarButtons:" << sProgram << "\n"
+           << "LightSensor:" << sProgram << "\n";
+    Stream.flush();
+    ConfigFile.close();
+
+    /* The dispatch benchmarks look components up among those the config registered, so there must be some. */
+    ControlEngine Engine;
+
+    if ( !Engine.bParseConfig( sConfigPath ) || Engine.lstGetRegisteredComponents().isEmpty() )
+    {
+        fprintf( stderr, "Failed to register any component from the bench config file %s\n",
+                 sConfigPath.toLocal8Bit().constData() );
+        return -1;
+    }
+
+    FramebufferDisplayBackend Framebuffer;
+    DisplayCompositor Compositor;
+    Compositor.bInit( &Framebuffer );
+
+    lstBenchmarks.append( qMakePair( QString( "accelerometer_parse" ), std::function<void()>( [&]() {
+        ControlEngine::xAccelerationInformation_t xInformation;
+        ControlEngine::bParseAccelerometerData( AccelerometerSample, xInformation );
+        dSink = dSink + xInformation.dZ;
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "gps_regex_parse" ), std::function<void()>( [&]() {
+        ControlEngine::xGPSInformation_t xInformation;
+        ControlEngine::bParseGPSData( GPSSample, xInformation );
+        dSink = dSink + xInformation.dSpeed;
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "gps_direction_to_string" ), std::function<void()>( [&]() {
+        static double dDirection = 0.0;
+        dSink = dSink + ControlEngine::sGPSDirectionToString( dDirection ).length();
+        dDirection = ( 360.0 <= dDirection ) ? 0.0 : dDirection + 7.5;
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "component_program_lookup" ), std::function<void()>( [&]() {
+        dSink = dSink + Engine.eComponentProgramToEnumValue( sProgram );
+    } ) ) );
+
+    QProcess * pLastProcess = Engine.lstGetRegisteredComponents().last().pProcess;
+
+    lstBenchmarks.append( qMakePair( QString( "component_dispatch_lookup" ), std::function<void()>( [&]() {
+        dSink = dSink + ( nullptr != Engine.pGetComponentHandler( pLastProcess ) );
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "glyph_render_ram" ), std::function<void()>( [&]() {
+        Compositor.vClearOverlay();
+        Compositor.vDrawText( 16, 48, "12:34", 0xFFFF );
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "overlay_compose_framebuffer" ), std::function<void()>( [&]() {
+        static int iMinute = 0;
+        char acText[ 8 ];
+        snprintf( acText, sizeof( acText ), "12:%02d", iMinute );
+        iMinute = ( iMinute + 1 ) % 60;
+        Compositor.vClearOverlay();
+        Compositor.vDrawText( 16, 48, acText, 0xFFFF );
+        Compositor.vCompose();
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "accelerometer_handle_framed" ), std::function<void()>( [&]() {
+        static ComponentHandler * pHandler =
+            ComponentHandler::pCreate( ControlEngine::eHUDViewComponentID_Accelerometer );
+        static ControlEngine::xHUDViewDataModel_t xModel;
+        dSink = dSink + pHandler->ulHandleData( AccelerometerSample, xModel );
+    } ) ) );
+
+    /* The same record stamped by the component and followed to the panel, a frame every ten records. */
+    LatencyTracer Tracer;
+
+    lstBenchmarks.append( qMakePair( QString( "accelerometer_handle_traced" ), std::function<void()>( [&]() {
+        static ComponentHandler * pHandler =
+            ComponentHandler::pCreate( ControlEngine::eHUDViewComponentID_Accelerometer );
+        static ControlEngine::xHUDViewDataModel_t xModel;
+        static uint32_t ulSequence = 0;
+        char acRecord[ 96 ];
+
+        pHandler->vSetLatencyTracer( &Tracer );
+        snprintf( acRecord, sizeof( acRecord ), HUDVIEW_TRACE_STAMP_FORMAT "%s", ++ulSequence, ullHUDViewMetricsNow(),
+                  AccelerometerSample.constData() );
+        dSink = dSink + pHandler->ulHandleData( QByteArray( acRecord ), xModel );
+
+        if ( 0 == ulSequence % 10 )
+        {
+            Tracer.vNoteRendered( ullHUDViewMetricsNow(), ullHUDViewMetricsNow(), true );
+        }
+    } ) ) );
+
+    /* Only the parsing; creating the component processes and handlers is left out. */
+    lstBenchmarks.append( qMakePair( QString( "config_parse" ), std::function<void()>( [&]() {
+        ControlEngine::xHUDViewConfig_t xConfig;
+        dSink = dSink + ControlEngine::bParseConfigFile( sConfigPath, xConfig );
+    } ) ) );
+
+    /* At 800 Hz, staying under 1% CPU leaves the flight recorder 12.5 us per accelerometer record. */
+    FlightRecorder Flight;
+    Flight.bOpen( TemporaryDirectory.filePath( "bench.rec" ), 65536 );
+
+    lstBenchmarks.append( qMakePair( QString( "flight_record_accelerometer" ), std::function<void()>( [&]() {
+        static double dValue = 0.0;
+        Flight.vRecordAccelerometer( dValue, -dValue, 9.80665 );
+        dValue += 0.001;
+    } ) ) );
+
+    /* The estimator runs on every accelerometer sample and every 50 ms tick, so its cost must not depend on history. */
+    MotionEstimator Motion;
+    Motion.vRecordGPS( true, 4042.6142, 7400.4168, 20.0, 90.0 );
+
+    lstBenchmarks.append( qMakePair( QString( "motion_accelerometer_update" ), std::function<void()>( [&]() {
+        static double dValue = 0.0;
+        Motion.vRecordAccelerometer( 0.05 + dValue, -dValue, 1.0 );
+        dValue = ( 0.1 <= dValue ) ? -0.1 : dValue + 0.001;
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "motion_gps_update" ), std::function<void()>( [&]() {
+        static double dSpeed = 20.0;
+        Motion.vRecordGPS( true, 4042.6142, 7400.4168, dSpeed, 90.0 );
+        dSpeed = ( 21.0 <= dSpeed ) ? 19.0 : dSpeed + 0.01;
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "motion_estimate" ), std::function<void()>( [&]() {
+        dSink = dSink + Motion.xUpdate().dSpeed;
+    } ) ) );
+
+    /* Rear vision runs inline on every camera frame; it has 30 ms on one core, and any more delays the HUD. Two
+     * textured frames a pixel apart alternate, so every block is tracked and every window is fitted. */
+    ApproachDetector Approach;
+    std::vector<uint8_t> aucLumaFrames( 2 * CameraFeed::FRAME_WIDTH * CameraFeed::FRAME_HEIGHT, 0 );
+    int iLumaFrame = 0;
+
+    for ( int iY = 0; iY < CameraFeed::FRAME_HEIGHT; iY++ )
+    {
+        for ( int iX = 0; iX < CameraFeed::FRAME_WIDTH; iX++ )
+        {
+            for ( int iFrame = 0; iFrame < 2; iFrame++ )
+            {
+                aucLumaFrames[ ( iFrame * CameraFeed::FRAME_HEIGHT + iY ) * CameraFeed::FRAME_WIDTH + iX ] =
+                    static_cast<uint8_t>( 128 + 60 * std::sin( ( iX + iFrame ) * 0.7 ) * std::cos( iY * 0.5 ) );
+            }
+        }
+    }
+
+    lstBenchmarks.append( qMakePair( QString( "flow_process_frame" ), std::function<void()>( [&]() {
+        Approach.bProcessFrame( &aucLumaFrames[ iLumaFrame * CameraFeed::FRAME_WIDTH * CameraFeed::FRAME_HEIGHT ] );
+        iLumaFrame ^= 1;
+    } ) ) );
+
+    /* At night the headlight tracker replaces the flow and should cost a fraction of it: a dark frame with a pair of
+     * headlights and a street light, moving a pixel between frames. */
+    ApproachDetector NightApproach;
+    std::vector<uint8_t> aucNightFrames( 2 * CameraFeed::FRAME_WIDTH * CameraFeed::FRAME_HEIGHT, 12 );
+    int iNightFrame = 0;
+
+    NightApproach.vSetNight( true );
+
+    for ( int iY = 0; iY < CameraFeed::FRAME_HEIGHT; iY++ )
+    {
+        for ( int iX = 0; iX < CameraFeed::FRAME_WIDTH; iX++ )
+        {
+            for ( int iFrame = 0; iFrame < 2; iFrame++ )
+            {
+                bool bLit = ( 16 >= ( iX - 60 - iFrame ) * ( iX - 60 - iFrame ) + ( iY - 64 ) * ( iY - 64 ) )
+                            || ( 16 >= ( iX - 100 - iFrame ) * ( iX - 100 - iFrame ) + ( iY - 64 ) * ( iY - 64 ) )
+                            || ( 4 >= ( iX - 30 ) * ( iX - 30 ) + ( iY - 20 + iFrame ) * ( iY - 20 + iFrame ) );
+
+                if ( bLit )
+                {
+                    aucNightFrames[ ( iFrame * CameraFeed::FRAME_HEIGHT + iY ) * CameraFeed::FRAME_WIDTH + iX ] = 255;
+                }
+            }
+        }
+    }
+
+    lstBenchmarks.append( qMakePair( QString( "headlights_process_frame" ), std::function<void()>( [&]() {
+        NightApproach.bProcessFrame( &aucNightFrames[ iNightFrame * CameraFeed::FRAME_WIDTH
+                                                      * CameraFeed::FRAME_HEIGHT ] );
+        iNightFrame ^= 1;
+    } ) ) );
+
+    /* Every camera frame is oriented, cropped and scaled to the display before anything else sees it: as shipped, a
+     * portrait capture turned a quarter, and a VGA capture turned and scaled down. */
+    static const char * apcCameraTransforms[] = { "160x120:hflip", "120x160:rotate=90", "640x480:rotate=270:area" };
+    std::vector<xHUDViewTransform_t> axCameraTransforms( 3 );
+    std::vector<uint8_t> aucCameraFrame( 640 * 480 * 3 );
+    std::vector<uint16_t> ausCameraPicture( CameraFeed::FRAME_WIDTH * CameraFeed::FRAME_HEIGHT );
+    std::vector<uint8_t> aucCameraLuma( CameraFeed::FRAME_WIDTH * CameraFeed::FRAME_HEIGHT );
+
+    for ( size_t ulByte = 0; ulByte < aucCameraFrame.size(); ulByte++ )
+    {
+        aucCameraFrame[ ulByte ] = static_cast<uint8_t>( ulByte * 7 + ( ulByte >> 9 ) );
+    }
+
+    for ( size_t ulTransform = 0; ulTransform < axCameraTransforms.size(); ulTransform++ )
+    {
+        xHUDViewTransformConfig_t xConfig;
+        xHUDViewTransform_t * pxTransform = &axCameraTransforms[ ulTransform ];
+
+        vHUDViewTransformDefaultConfig( &xConfig, CameraFeed::FRAME_WIDTH, CameraFeed::FRAME_HEIGHT );
+        iHUDViewTransformParse( apcCameraTransforms[ ulTransform ], &xConfig );
+        iHUDViewTransformInit( pxTransform, &xConfig );
+
+        lstBenchmarks.append( qMakePair( QString( "camera_transform_%1" ).arg( apcCameraTransforms[ ulTransform ] )
+                                                                          .replace( ':', '_' ),
+                                         std::function<void()>( [&, pxTransform]() {
+            vHUDViewTransformApply( pxTransform, aucCameraFrame.data(), ausCameraPicture.data(),
+                                    aucCameraLuma.data() );
+        } ) ) );
+    }
+
+    /* Camera pixels can go to the panel in 12 bits instead of 16; packing them must cost less CPU than the quarter of
+     * the SPI time it saves. Two camera pictures alternate so every tile changes on every frame. */
+    static const char * apcPixelFormats[] = { "rgb565", "rgb444", "rgb444_dither" };
+    std::vector<uint16_t> ausCameraPictures( 2 * CameraFeed::FRAME_WIDTH * CameraFeed::FRAME_HEIGHT );
+    std::vector<uint8_t> aucPackedPicture( HUDVIEW_RGB444_BYTES( CameraFeed::FRAME_WIDTH * CameraFeed::FRAME_HEIGHT ) );
+    std::vector<FramebufferDisplayBackend> aCameraFramebuffers( 3 );
+    std::vector<DisplayCompositor> aCameraCompositors( 3 );
+    xHUDViewRGB444_t xPacker;
+    xHUDViewRGB444_t xScalarPacker;
+    int iCameraPicture = 0;
+
+    for ( size_t ulPixel = 0; ulPixel < ausCameraPictures.size(); ulPixel++ )
+    {
+        ausCameraPictures[ ulPixel ] = static_cast<uint16_t>( ulPixel * 37 + ( ulPixel >> 7 ) );
+    }
+
+    vHUDViewRGB444Init( &xPacker, 1 );
+    vHUDViewRGB444Init( &xScalarPacker, 1 );
+    vHUDViewRGB444SetScalar( &xScalarPacker, 1 );
+
+    lstBenchmarks.append( qMakePair( QString( "rgb444_pack_frame" ), std::function<void()>( [&]() {
+        dSink = dSink + ulHUDViewRGB444Pack( &xPacker, ausCameraPictures.data(), CameraFeed::FRAME_WIDTH, 0, 0,
+                                             CameraFeed::FRAME_WIDTH, CameraFeed::FRAME_HEIGHT,
+                                             aucPackedPicture.data() );
+    } ) ) );
+
+    lstBenchmarks.append( qMakePair( QString( "rgb444_pack_frame_scalar" ), std::function<void()>( [&]() {
+        dSink = dSink + ulHUDViewRGB444Pack( &xScalarPacker, ausCameraPictures.data(), CameraFeed::FRAME_WIDTH, 0, 0,
+                                             CameraFeed::FRAME_WIDTH, CameraFeed::FRAME_HEIGHT,
+                                             aucPackedPicture.data() );
+    } ) ) );
+
+    for ( size_t ulFormat = 0; ulFormat < aCameraCompositors.size(); ulFormat++ )
+    {
+        DisplayCompositor * pCompositor = &aCameraCompositors[ ulFormat ];
+
+        pCompositor->bInit( &aCameraFramebuffers[ ulFormat ] );
+        pCompositor->bSetCameraPixelFormat( ( 0 == ulFormat ) ? DisplayBackend::ePixelFormat_RGB565
+                                                              : DisplayBackend::ePixelFormat_RGB444,
+                                            ( 2 == ulFormat ) );
+
+        lstBenchmarks.append( qMakePair( QString( "camera_compose_framebuffer_%1" ).arg( apcPixelFormats[ ulFormat ] ),
+                                         std::function<void()>( [&, pCompositor]() {
+            iCameraPicture ^= 1;
+            pCompositor->vSetCameraFrame( &ausCameraPictures[ iCameraPicture * CameraFeed::FRAME_WIDTH
+                                                              * CameraFeed::FRAME_HEIGHT ],
+                                          CameraFeed::FRAME_WIDTH, CameraFeed::FRAME_HEIGHT );
+            pCompositor->vCompose();
+        } ) ) );
+    }
+
+    for ( const QPair<QString, std::function<void()>> & xBenchmark : lstBenchmarks )
+    {
+        if ( Parser.isSet( "filter" ) && !xBenchmark.first.contains( Parser.value( "filter" ) ) )
+        {
+            continue;
+        }
+
+        xBenchmarkResult_t xResult = xRunBenchmark( xBenchmark.first, xBenchmark.second );
+        QJsonObject Result;
+
+        Result[ "name" ] = xResult.sName;
+        Result[ "iterations" ] = static_cast<double>( xResult.llIterations );
+        Result[ "ns_per_op" ] = xResult.dMedianNanoseconds;
+        Result[ "min_ns_per_op" ] = xResult.dMinimumNanoseconds;
+        Result[ "ops_per_sec" ] = ( 0.0 < xResult.dMedianNanoseconds ) ? 1e9 / xResult.dMedianNanoseconds : 0.0;
+        Results.append( Result );
+
+        fprintf( stderr, "%-32s %12.1f ns/op\n", xResult.sName.toLocal8Bit().constData(), xResult.dMedianNanoseconds );
+    }
+
+    /* Frame pacing under load with the render loop left to CFS or made SCHED_FIFO, each unpinned and pinned. */
+    QJsonArray JitterResults;
+
+    if ( Parser.isSet( "jitter" ) )
+    {
+        long lCPUs = sysconf( _SC_NPROCESSORS_ONLN );
+        qint64 llJitterNanoseconds = static_cast<qint64>( Parser.value( "jitter" ).toDouble() * 1e9 );
+        ComponentProcess::xSchedulingOptions_t xRender = ComponentProcess::xDefaultSchedulingOptions();
+        ComponentProcess::xSchedulingOptions_t xLoad = ComponentProcess::xDefaultSchedulingOptions();
+        QList<xJitterResult_t> lstJitter;
+
+        lstJitter.append( xRunJitter( "display_jitter_cfs", xRender, xLoad, llJitterNanoseconds ) );
+
+        xRender.iFifoPriority = 50;
+        lstJitter.append( xRunJitter( "display_jitter_fifo", xRender, xLoad, llJitterNanoseconds ) );
+        xRender.iFifoPriority = 0;
+
+        /* Pinning needs a CPU to spare; as in the config file, the render loop gets the last one to itself. */
+        if ( 1 < lCPUs )
+        {
+            xRender.ullAffinityMask = 1ULL << ( lCPUs - 1 );
+            xLoad.ullAffinityMask = xRender.ullAffinityMask - 1;
+            lstJitter.append( xRunJitter( "display_jitter_pinned", xRender, xLoad, llJitterNanoseconds ) );
+
+            xRender.iFifoPriority = 50;
+            lstJitter.append( xRunJitter( "display_jitter_pinned_fifo", xRender, xLoad, llJitterNanoseconds ) );
+        }
+        else
+        {
+            fprintf( stderr, "Only one CPU online, skipping the pinned jitter runs\n" );
+        }
+
+        for ( const xJitterResult_t & xResult : lstJitter )
+        {
+            QJsonObject Result;
+
+            Result[ "name" ] = xResult.sName;
+            Result[ "options" ] = xResult.sOptions;
+            Result[ "frames" ] = static_cast<double>( xResult.lFrames );
+            Result[ "late_frames" ] = static_cast<double>( xResult.lLateFrames );
+            Result[ "mean_interval_us" ] = xResult.dMeanIntervalMicroseconds;
+            Result[ "stddev_us" ] = xResult.dStandardDeviationMicroseconds;
+            Result[ "p99_deviation_us" ] = xResult.dP99DeviationMicroseconds;
+            Result[ "max_deviation_us" ] = xResult.dMaximumDeviationMicroseconds;
+            JitterResults.append( Result );
+
+            fprintf( stderr, "%-32s %8ld frames %10.1f us stddev %10.1f us p99 %10.1f us max %6ld late (%s)\n",
+                     xResult.sName.toLocal8Bit().constData(), xResult.lFrames, xResult.dStandardDeviationMicroseconds,
+                     xResult.dP99DeviationMicroseconds, xResult.dMaximumDeviationMicroseconds, xResult.lLateFrames,
+                     xResult.sOptions.toLocal8Bit().constData() );
+        }
+    }
+
+    /* Moving pictures over the modelled link, as each way of drawing them would send them. */
+    QJsonArray ScrollResults;
+    QList<xScrollResult_t> lstScroll;
+
+    lstScroll.append( xRunScroll( eScrollScene_ModeChange, eScrollMethod_Clear ) );
+    lstScroll.append( xRunScroll( eScrollScene_ModeChange, eScrollMethod_Columns ) );
+    lstScroll.append( xRunScroll( eScrollScene_ModeSlide, eScrollMethod_Columns ) );
+    lstScroll.append( xRunScroll( eScrollScene_ModeSlide, eScrollMethod_Scroll ) );
+
+    for ( int iScene = eScrollScene_HeadingTape; iScene <= eScrollScene_SpeedStrip; iScene++ )
+    {
+        for ( int iMethod = eScrollMethodMin + 1; iMethod < eScrollMethodMax; iMethod++ )
+        {
+            lstScroll.append( xRunScroll( static_cast<eScrollScene_t>( iScene ),
+                                          static_cast<eScrollMethod_t>( iMethod ) ) );
+        }
+    }
+
+    for ( const xScrollResult_t & xResult : lstScroll )
+    {
+        QJsonObject Result;
+
+        Result[ "name" ] = xResult.sName;
+        Result[ "frames" ] = static_cast<double>( xResult.lFrames );
+        Result[ "kib" ] = xResult.dKilobytes;
+        Result[ "transfers" ] = static_cast<double>( xResult.ulTransfers );
+        Result[ "wire_ms" ] = xResult.dWireMilliseconds;
+        Result[ "max_frame_ms" ] = xResult.dMaximumFrameMilliseconds;
+        ScrollResults.append( Result );
+
+        fprintf( stderr, "%-32s %4ld frames %8.1f KiB %5lu transfers %8.2f ms wire %6.2f ms worst frame\n",
+                 xResult.sName.toLocal8Bit().constData(), xResult.lFrames, xResult.dKilobytes, xResult.ulTransfers,
+                 xResult.dWireMilliseconds, xResult.dMaximumFrameMilliseconds );
+    }
+
+    /* Tag the results so they can be compared across commits and between the Pi and x86 hosts. */
+    QJsonObject Report;
+    Report[ "suite" ] = "HUDView Control";
+    Report[ "timestamp" ] = QDateTime::currentDateTimeUtc().toString( Qt::ISODate );
+    Report[ "commit" ] = Parser.value( "commit" );
+    Report[ "architecture" ] = QSysInfo::currentCpuArchitecture();
+    Report[ "build_abi" ] = QSysInfo::buildAbi();
+    Report[ "kernel" ] = QSysInfo::kernelVersion();
+    Report[ "qt_version" ] = QString( qVersion() );
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    Report[ "simd" ] = "neon";
+#else
+    Report[ "simd" ] = "scalar";
+#endif
+    Report[ "benchmarks" ] = Results;
+    Report[ "scroll" ] = ScrollResults;
+
+    if ( !JitterResults.isEmpty() )
+    {
+        Report[ "jitter" ] = JitterResults;
+    }
+
+    QByteArray Json = QJsonDocument( Report ).toJson();
+
+    if ( Parser.isSet( "output" ) )
+    {
+        QFile OutputFile( Parser.value( "output" ) );
+
+        if ( !OutputFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) || ( -1 == OutputFile.write( Json ) ) )
+        {
+            fprintf( stderr, "Failed to write results to %s\n", Parser.value( "output" ).toLocal8Bit().constData() );
+            return -1;
+        }
+    }
+    else
+    {
+        fwrite( Json.constData(), 1, Json.size(), stdout );
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDiscardMessages( QtMsgType eType, const QMessageLogContext & xContext, const QString & sMessage )
+{
+    Q_UNUSED( eType );
+    Q_UNUSED( xContext );
+    Q_UNUSED( sMessage );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static xBenchmarkResult_t xRunBenchmark( const QString & sName, const std::function<void()> & fnOperation )
+{
+    QList<double> lstBatchNanoseconds;
+    QElapsedTimer Timer;
+    qint64 llIterations = 1;
+    qint64 llTotalIterations = 0;
+
+    /* Warm up and grow the batch until a single batch is long enough to time reliably. */
+    for ( ;; )
+    {
+        Timer.start();
+
+        for ( qint64 llIteration = 0; llIteration < llIterations; llIteration++ )
+        {
+            fnOperation();
+        }
+
+        if ( MINIMUM_BATCH_NANOSECONDS <= Timer.nsecsElapsed() )
+        {
+            break;
+        }
+
+        llIterations *= 2;
+    }
+
+    for ( int iBatch = 0; iBatch < BATCH_COUNT; iBatch++ )
+    {
+        Timer.start();
+
+        for ( qint64 llIteration = 0; llIteration < llIterations; llIteration++ )
+        {
+            fnOperation();
+        }
+
+        lstBatchNanoseconds.append( static_cast<double>( Timer.nsecsElapsed() ) / llIterations );
+        llTotalIterations += llIterations;
+    }
+
+    std::sort( lstBatchNanoseconds.begin(), lstBatchNanoseconds.end() );
+
+    return { sName, llTotalIterations, lstBatchNanoseconds.at( BATCH_COUNT / 2 ), lstBatchNanoseconds.first() };
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static QList<pid_t> lstStartLoad( int iProcesses, const ComponentProcess::xSchedulingOptions_t & xOptions )
+{
+    QList<pid_t> lstProcesses;
+    pid_t xPid = 0;
+    volatile unsigned long ulSpin = 0;
+
+    /* Busy processes stand in for the GPS reader and the camera competing with the render loop. */
+    for ( int iProcess = 0; iProcess < iProcesses; iProcess++ )
+    {
+        xPid = fork();
+
+        if ( 0 == xPid )
+        {
+            ComponentProcess::bApplySchedulingOptions( xOptions );
+
+            for ( ;; )
+            {
+                ulSpin = ulSpin + 1;
+            }
+        }
+        else if ( 0 < xPid )
+        {
+            lstProcesses.append( xPid );
+        }
+    }
+
+    return lstProcesses;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vStopLoad( const QList<pid_t> & lstProcesses )
+{
+    for ( pid_t xPid : lstProcesses )
+    {
+        kill( xPid, SIGKILL );
+        waitpid( xPid, nullptr, 0 );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static xJitterResult_t xRunJitter( const QString & sName, const ComponentProcess::xSchedulingOptions_t & xOptions,
+                                   const ComponentProcess::xSchedulingOptions_t & xLoadOptions, qint64 llNanoseconds )
+{
+    TimingDisplayBackend Backend( TimingDisplayBackend::DEFAULT_SPI_CLOCK_HZ, true );
+    DisplayCompositor Compositor;
+    QList<pid_t> lstLoad;
+    QList<double> lstDeviations;
+    struct sched_param xParameters;
+    struct timespec xDeadline;
+    struct timespec xNow;
+    qint64 llStart = 0;
+    qint64 llLast = 0;
+    qint64 llFrameEnd = 0;
+    double dInterval = 0.0;
+    double dSum = 0.0;
+    double dSumOfSquares = 0.0;
+    char acText[ 8 ];
+    xJitterResult_t xResult = { sName, ComponentProcess::sDescribe( xOptions ), 0, 0, 0.0, 0.0, 0.0, 0.0 };
+
+    Compositor.bInit( &Backend );
+
+    /* Two load processes per CPU keep every run queue contended. */
+    lstLoad = lstStartLoad( 2 * static_cast<int>( sysconf( _SC_NPROCESSORS_ONLN ) ), xLoadOptions );
+
+    if ( !ComponentProcess::bApplySchedulingOptions( xOptions ) )
+    {
+        xResult.sOptions += " (not applied)";
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xDeadline );
+    llStart = xDeadline.tv_sec * 1000000000LL + xDeadline.tv_nsec;
+
+    /* Each frame redraws a changing value so the compositor pushes real tiles over the modelled SPI bus. */
+    for ( long lFrame = 0; ( llLast - llStart ) < llNanoseconds; lFrame++ )
+    {
+        xDeadline.tv_nsec += JITTER_FRAME_PERIOD_NANOSECONDS;
+
+        while ( 1000000000L <= xDeadline.tv_nsec )
+        {
+            xDeadline.tv_nsec -= 1000000000L;
+            xDeadline.tv_sec++;
+        }
+
+        clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xDeadline, nullptr );
+
+        snprintf( acText, sizeof( acText ), "%ld", lFrame % 1000 );
+        Compositor.vClearOverlay();
+        Compositor.vDrawText( 16, 48, acText, 0xFFFF );
+        Compositor.vCompose();
+
+        clock_gettime( CLOCK_MONOTONIC, &xNow );
+        llFrameEnd = xNow.tv_sec * 1000000000LL + xNow.tv_nsec;
+
+        if ( 0 < lFrame )
+        {
+            dInterval = static_cast<double>( llFrameEnd - llLast );
+            dSum += dInterval;
+            dSumOfSquares += dInterval * dInterval;
+            lstDeviations.append( std::fabs( dInterval - JITTER_FRAME_PERIOD_NANOSECONDS ) );
+
+            if ( JITTER_LATE_NANOSECONDS < ( dInterval - JITTER_FRAME_PERIOD_NANOSECONDS ) )
+            {
+                xResult.lLateFrames++;
+            }
+        }
+
+        llLast = llFrameEnd;
+    }
+
+    /* Drop back to the default scheduler before the load goes, so the next configuration starts clean. */
+    xParameters.sched_priority = 0;
+    sched_setscheduler( 0, SCHED_OTHER, &xParameters );
+    ComponentProcess::bApplySchedulingOptions( ComponentProcess::xDefaultSchedulingOptions() );
+    vStopLoad( lstLoad );
+
+    xResult.lFrames = lstDeviations.length();
+
+    if ( 0 < xResult.lFrames )
+    {
+        std::sort( lstDeviations.begin(), lstDeviations.end() );
+        dInterval = dSum / xResult.lFrames;
+        xResult.dMeanIntervalMicroseconds = dInterval / 1000.0;
+        xResult.dStandardDeviationMicroseconds =
+            std::sqrt( std::max( 0.0, dSumOfSquares / xResult.lFrames - dInterval * dInterval ) ) / 1000.0;
+        xResult.dP99DeviationMicroseconds = lstDeviations.at( ( xResult.lFrames * 99 ) / 100 ) / 1000.0;
+        xResult.dMaximumDeviationMicroseconds = lstDeviations.last() / 1000.0;
+    }
+
+    return xResult;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static xScrollResult_t xRunScroll( eScrollScene_t eScene, eScrollMethod_t eMethod )
+{
+    static const char * apcScenes[] = { "", "mode_change", "mode_slide", "heading_tape", "speed_strip" };
+    static const char * apcMethods[] = { "", "clear", "columns", "scroll" };
+    TimingDisplayBackend Backend( TimingDisplayBackend::DEFAULT_SPI_CLOCK_HZ, false );
+    DisplayCompositor Compositor;
+    unsigned long long ullBytes = 0;
+    unsigned long ulTransfers = 0;
+    unsigned long ulFrames = 0;
+    double dSeconds = 0.0;
+    int iFrames = 1;
+    xScrollResult_t xResult = { QString( "%1_%2" ).arg( apcScenes[ eScene ] ).arg( apcMethods[ eMethod ] ), 0, 0.0, 0,
+                                0.0, 0.0 };
+
+    Compositor.bInit( &Backend );
+
+    /* The strip scrolls beside the speed, which stays put on the left. */
+    if ( ( eScrollMethod_Scroll == eMethod ) && ( eScrollScene_SpeedStrip == eScene ) )
+    {
+        Compositor.bSetScrollArea( SCROLL_STRIP_X, DisplayCompositor::DISPLAY_WIDTH - SCROLL_STRIP_X );
+    }
+
+    /* Frame 0 is what was on the panel before, and is not counted. */
+    iDrawScrollScene( Compositor, eScene, 0 );
+    Compositor.vCompose();
+
+    ullBytes = Backend.ullGetTotalBytes();
+    ulTransfers = Backend.xGetStatistics().ulTransfers;
+    ulFrames = Backend.xGetStatistics().ulFrames;
+    dSeconds = Backend.dGetSimulatedSeconds();
+
+    switch ( eScene )
+    {
+    case eScrollScene_ModeSlide:
+        iFrames = DisplayCompositor::DISPLAY_WIDTH / SCROLL_SLIDE_STEP_PIXELS;
+        break;
+
+    case eScrollScene_HeadingTape:
+        iFrames = SCROLL_TAPE_FRAMES;
+        break;
+
+    case eScrollScene_SpeedStrip:
+        iFrames = SCROLL_STRIP_FRAMES;
+        break;
+
+    default:
+        break;
+    }
+
+    for ( int iFrame = 1; iFrame <= iFrames; iFrame++ )
+    {
+        int iPixels = iDrawScrollScene( Compositor, eScene, iFrame );
+
+        if ( eScrollMethod_Clear == eMethod )
+        {
+            Compositor.vInvalidate();
+        }
+        else if ( eScrollMethod_Scroll == eMethod )
+        {
+            Compositor.vScroll( iPixels );
+        }
+
+        Compositor.vCompose();
+
+        if ( Backend.xGetStatistics().ulFrames != ulFrames + xResult.lFrames )
+        {
+            xResult.dMaximumFrameMilliseconds = std::max( xResult.dMaximumFrameMilliseconds,
+                                                          Backend.ullGetLastFrameNanoseconds() / 1e6 );
+        }
+
+        xResult.lFrames = static_cast<long>( Backend.xGetStatistics().ulFrames - ulFrames );
+    }
+
+    xResult.dKilobytes = ( Backend.ullGetTotalBytes() - ullBytes ) / 1024.0;
+    xResult.ulTransfers = Backend.xGetStatistics().ulTransfers - ulTransfers;
+    xResult.dWireMilliseconds = ( Backend.dGetSimulatedSeconds() - dSeconds ) * 1e3;
+
+    return xResult;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iDrawScrollScene( DisplayCompositor & Compositor, eScrollScene_t eScene, int iFrame )
+{
+    const int iWidth = DisplayCompositor::DISPLAY_WIDTH;
+    int iReturn = 0;
+    char acText[ 8 ];
+
+    Compositor.vClearOverlay();
+
+    switch ( eScene )
+    {
+    case eScrollScene_ModeChange:
+        Compositor.vDrawText( 16, 48, ( 0 == iFrame ) ? "12:34" : "37", 0xFFFF );
+        break;
+
+    case eScrollScene_ModeSlide:
+        /* The time goes out to the left as the speed comes in from the right. */
+        iReturn = SCROLL_SLIDE_STEP_PIXELS;
+        Compositor.vDrawText( 16 - iFrame * SCROLL_SLIDE_STEP_PIXELS, 48, "12:34", 0xFFFF );
+        Compositor.vDrawText( 16 + iWidth - iFrame * SCROLL_SLIDE_STEP_PIXELS, 48, "37", 0xFFFF );
+        break;
+
+    case eScrollScene_HeadingTape:
+        /* Turning right a degree a frame; a tick every 5 degrees, a longer one every 10 and a letter every 90, under
+         * a marker that stays in the middle. */
+        iReturn = SCROLL_TAPE_PIXELS_PER_DEGREE;
+
+        for ( int iDegree = iFrame - 25; iDegree <= iFrame + 25; iDegree++ )
+        {
+            int iX = iWidth / 2 + ( iDegree - iFrame ) * SCROLL_TAPE_PIXELS_PER_DEGREE;
+
+            if ( 0 == ( ( iDegree + 360 ) % 90 ) )
+            {
+                acText[ 0 ] = "NESW"[ ( ( iDegree + 360 ) % 360 ) / 90 ];
+                acText[ 1 ] = '\0';
+                Compositor.vDrawText( iX - 12, 40, acText, 0xFFFF );
+            }
+
+            if ( 0 == ( ( iDegree + 360 ) % 5 ) )
+            {
+                Compositor.vFillOverlay( iX - 1, 96, 2, ( 0 == ( ( iDegree + 360 ) % 10 ) ) ? 16 : 8, 0xFFFF );
+            }
+        }
+
+        Compositor.vFillOverlay( iWidth / 2 - 1, 84, 2, 8, DisplayCompositor::usRGB565( 255, 0, 0 ) );
+        break;
+
+    case eScrollScene_SpeedStrip:
+        /* A bar a frame for the speed, the newest on the right, beside the speed itself. */
+        iReturn = SCROLL_STRIP_BAR_PIXELS;
+
+        for ( int iX = iWidth - SCROLL_STRIP_BAR_PIXELS, iSample = iFrame; SCROLL_STRIP_X <= iX;
+              iX -= SCROLL_STRIP_BAR_PIXELS, iSample-- )
+        {
+            int iSpeed = static_cast<int>( 40.0 + 20.0 * std::sin( iSample / 12.0 ) );
+
+            Compositor.vFillOverlay( iX, 120 - iSpeed, SCROLL_STRIP_BAR_PIXELS, iSpeed, 0xFFFF );
+        }
+
+        snprintf( acText, sizeof( acText ), "%d", static_cast<int>( 40.0 + 20.0 * std::sin( iFrame / 12.0 ) ) );
+        Compositor.vDrawText( 6, 48, acText, 0xFFFF );
+        break;
+
+    default:
+        break;
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,105 @@
+SOURCES += \
+    $$PWD/src/approachdetector.cpp \
+    $$PWD/src/camerafeed.cpp \
+    $$PWD/src/componenthandler.cpp \
+    $$PWD/src/componentprocess.cpp \
+    $$PWD/src/componentsupervisor.cpp \
+    $$PWD/src/controlengine.cpp \
+    $$PWD/src/dashcam.cpp \
+    $$PWD/src/displaybackend.cpp \
+    $$PWD/src/displaycompositor.cpp \
+    $$PWD/src/flightrecorder.cpp \
+    $$PWD/src/framebufferbackend.cpp \
+    $$PWD/src/hudlayout.cpp \
+    $$PWD/src/latencytracer.cpp \
+    $$PWD/src/metricsregistry.cpp \
+    $$PWD/src/motionestimator.cpp \
+    $$PWD/src/ridelog.cpp \
+    $$PWD/src/riderecorder.cpp \
+    $$PWD/src/spidevbackend.cpp \
+    $$PWD/src/timingbackend.cpp \
+    $$PWD/../Common/src/hudview_dashcam.c \
+    $$PWD/../Common/src/hudview_enhance.c \
+    $$PWD/../Common/src/hudview_flow.c \
+    $$PWD/../Common/src/hudview_framerate.c \
+    $$PWD/../Common/src/hudview_framering.c \
+    $$PWD/../Common/src/hudview_fusion.c \
+    $$PWD/../Common/src/hudview_headlights.c \
+    $$PWD/../Common/src/hudview_jpeg.c \
+    $$PWD/../Common/src/hudview_ridelog.c \
+    $$PWD/../Common/src/hudview_rgb444.c \
+    $$PWD/../Common/src/hudview_spidev.c \
+    $$PWD/../Common/src/hudview_transform.c
+
+HEADERS += \
+    $$PWD/src/approachdetector.h \
+    $$PWD/src/camerafeed.h \
+    $$PWD/src/componenthandler.h \
+    $$PWD/src/componentprocess.h \
+    $$PWD/src/componentsupervisor.h \
+    $$PWD/src/controlengine.h \
+    $$PWD/src/dashcam.h \
+    $$PWD/src/displaybackend.h \
+    $$PWD/src/displaycompositor.h \
+    $$PWD/src/flightrecorder.h \
+    $$PWD/src/framebufferbackend.h \
+    $$PWD/src/hudlayout.h \
+    $$PWD/src/latencytracer.h \
+    $$PWD/src/metricsregistry.h \
+    $$PWD/src/motionestimator.h \
+    $$PWD/src/ridelog.h \
+    $$PWD/src/riderecorder.h \
+    $$PWD/src/spidevbackend.h \
+    $$PWD/src/telemetrysink.h \
+    $$PWD/src/timingbackend.h \
+    $$PWD/src/ubuntumono.h \
+    $$PWD/../Common/src/hudview_button.h \
+    $$PWD/../Common/src/hudview_dashcam.h \
+    $$PWD/../Common/src/hudview_enhance.h \
+    $$PWD/../Common/src/hudview_flightrecord.h \
+    $$PWD/../Common/src/hudview_flow.h \
+    $$PWD/../Common/src/hudview_framerate.h \
+    $$PWD/../Common/src/hudview_framering.h \
+    $$PWD/../Common/src/hudview_fusion.h \
+    $$PWD/../Common/src/hudview_headlights.h \
+    $$PWD/../Common/src/hudview_jpeg.h \
+    $$PWD/../Common/src/hudview_memlock.h \
+    $$PWD/../Common/src/hudview_metrics.h \
+    $$PWD/../Common/src/hudview_ridelog.h \
+    $$PWD/../Common/src/hudview_rgb444.h \
+    $$PWD/../Common/src/hudview_spidev.h \
+    $$PWD/../Common/src/hudview_trace.h \
+    $$PWD/../Common/src/hudview_transform.h
+
+INCLUDEPATH += $$PWD/src $$PWD/../Common/src
+
+# The metrics page shared with the component processes lives in POSIX shared memory.
+unix: LIBS += -lrt
+
+# MJPEG camera frames are decoded with libjpeg-turbo (libjpeg-turbo8-dev / libjpeg62-turbo-dev).
+unix: LIBS += -ljpeg
+
+# The SIMD paths in Common/src are only built when __ARM_NEON is defined, which the 32-bit armhf compiler never does on
+# its own: Raspbian's targets the ARMv6 Pi 1. HUDView runs on a Pi 2 or later, so build for its NEON unit. 64-bit ARM
+# always has NEON. Tools/src/Makefile builds the tools with the same flags, and its neon-check target compiles these
+# kernels for armhf from any machine.
+equals(QT_ARCH, arm) {
+    QMAKE_CFLAGS += -march=armv7-a -mfpu=neon-vfpv4 -mfloat-abi=hard
+    QMAKE_CXXFLAGS += -march=armv7-a -mfpu=neon-vfpv4 -mfloat-abi=hard
+}
+
+# Build with "qmake CONFIG+=headless" to leave out the ST7735 hardware backend and the display library, so the
+# framebuffer and timing backends can be used on a development machine without GPIO or SPI.
+headless {
+    DEFINES += HUDVIEW_HEADLESS
+} else {
+    SOURCES += $$PWD/src/st7735backend.cpp
+    HEADERS += $$PWD/src/st7735backend.h
+
+    unix:!macx: LIBS += -L$$PWD/../Display/ssd1306/bld/ -lssd1306
+
+    INCLUDEPATH += $$PWD/../Display/ssd1306/src
+    DEPENDPATH += $$PWD/../Display/ssd1306/bld
+
+    unix:!macx: PRE_TARGETDEPS += $$PWD/../Display/ssd1306/bld/libssd1306.a
+}
@@ -0,0 +1,116 @@
+#include <cstring>
+
+#include "approachdetector.h"
+#include "hudview_metrics.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ApproachDetector::ApproachDetector()
+{
+    m_bNight = false;
+    m_bAlert = false;
+    m_ulAlerts = 0;
+    vHUDViewFlowInit( &m_xFlow );
+    vHUDViewHeadlightsInit( &m_xHeadlights );
+    memset( &m_xFlowResult, 0, sizeof( m_xFlowResult ) );
+    memset( &m_xHeadlightsResult, 0, sizeof( m_xHeadlightsResult ) );
+    memset( m_axStatistics, 0, sizeof( m_axStatistics ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ApproachDetector::vSetNight( bool bNight )
+{
+    if ( bNight == m_bNight )
+    {
+        return;
+    }
+
+    /* The path taking over starts from scratch rather than from whatever it last saw, possibly hours ago. */
+    if ( bNight )
+    {
+        vHUDViewHeadlightsInit( &m_xHeadlights );
+        memset( &m_xHeadlightsResult, 0, sizeof( m_xHeadlightsResult ) );
+    }
+    else
+    {
+        vHUDViewFlowInit( &m_xFlow );
+        memset( &m_xFlowResult, 0, sizeof( m_xFlowResult ) );
+    }
+
+    m_bNight = bNight;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ApproachDetector::bIsNight() const
+{
+    return m_bNight;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ApproachDetector::bProcessFrame( const uint8_t * pucLuma )
+{
+    xStatistics_t & xStatistics = m_axStatistics[ m_bNight ? 1 : 0 ];
+    uint64_t ullStart = ullHUDViewMetricsNow();
+    int64_t llMicroseconds = static_cast<int64_t>( ullStart / 1000ULL );
+    uint64_t ullElapsed = 0;
+    bool bWasAlerting = m_bAlert;
+
+    /* Frames are stamped on arrival, so a stalled camera shows up as a gap and the path starts over after it. */
+    if ( m_bNight )
+    {
+        iHUDViewHeadlightsProcess( &m_xHeadlights, pucLuma, llMicroseconds, &m_xHeadlightsResult );
+        m_bAlert = ( 0 != m_xHeadlights.bAlert );
+    }
+    else
+    {
+        iHUDViewFlowProcess( &m_xFlow, pucLuma, llMicroseconds, &m_xFlowResult );
+        m_bAlert = ( 0 != m_xFlow.bAlert );
+    }
+
+    ullElapsed = ullHUDViewMetricsNow() - ullStart;
+    xStatistics.ulFrames++;
+    xStatistics.ullNanoseconds += ullElapsed;
+
+    if ( xStatistics.ullMaximumNanoseconds < ullElapsed )
+    {
+        xStatistics.ullMaximumNanoseconds = ullElapsed;
+    }
+
+    /* Switching paths can also drop an alert, so the change is judged on the outcome rather than on either path. */
+    if ( m_bAlert && !bWasAlerting )
+    {
+        m_ulAlerts++;
+    }
+
+    return ( bWasAlerting != m_bAlert );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ApproachDetector::bIsAlerting() const
+{
+    return m_bAlert;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+double ApproachDetector::dGetTimeToContact() const
+{
+    return m_bNight ? m_xHeadlightsResult.dTimeToContact : m_xFlowResult.dTimeToContact;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const xHUDViewHeadlightsResult_t & ApproachDetector::xGetHeadlights() const
+{
+    return m_xHeadlightsResult;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long ApproachDetector::ulGetAlerts() const
+{
+    return m_ulAlerts;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const ApproachDetector::xStatistics_t & ApproachDetector::xGetStatistics( bool bNight ) const
+{
+    return m_axStatistics[ bNight ? 1 : 0 ];
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,46 @@
+#ifndef APPROACHDETECTOR_H
+#define APPROACHDETECTOR_H
+
+#include <cstdint>
+
+#include "hudview_flow.h"
+#include "hudview_headlights.h"
+
+/* Watches the rear camera for anything closing in from behind, and says when to warn the rider about it. By day that
+ * is the optical flow of the whole scene; at night, when there is no texture to track, it is the headlights. */
+class ApproachDetector
+{
+public:
+    struct xStatistics_t {
+        unsigned long ulFrames;
+        uint64_t ullNanoseconds;
+        uint64_t ullMaximumNanoseconds;
+    };
+
+    ApproachDetector();
+
+    void vSetNight( bool bNight );
+    bool bIsNight() const;
+
+    bool bProcessFrame( const uint8_t * pucLuma );
+    bool bIsAlerting() const;
+    double dGetTimeToContact() const;
+    const xHUDViewHeadlightsResult_t & xGetHeadlights() const;
+
+    unsigned long ulGetAlerts() const;
+    const xStatistics_t & xGetStatistics( bool bNight ) const;
+
+private:
+    bool m_bNight;
+    bool m_bAlert;
+    unsigned long m_ulAlerts;
+
+    xHUDViewFlow_t m_xFlow;
+    xHUDViewFlowResult_t m_xFlowResult;
+    xHUDViewHeadlights_t m_xHeadlights;
+    xHUDViewHeadlightsResult_t m_xHeadlightsResult;
+
+    xStatistics_t m_axStatistics[ 2 ];
+};
+
+#endif // APPROACHDETECTOR_H
@@ -0,0 +1,653 @@
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <QDebug>
+
+#include "camerafeed.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+CameraFeed::CameraFeed( QObject * pParent ) : QObject( pParent ),
+    m_ausFrame( FRAME_WIDTH * FRAME_HEIGHT, 0 ),
+    m_aucLuma( FRAME_WIDTH * FRAME_HEIGHT, 0 ),
+    m_aucPreviousLuma( FRAME_WIDTH * FRAME_HEIGHT, 0 )
+{
+    m_iReadDescriptor = -1;
+    m_iWriteDescriptor = -1;
+    m_pNotifier = nullptr;
+    m_bRing = false;
+    m_pucFilling = nullptr;
+    m_pucRawFrame = nullptr;
+    m_ulRawBytes = 0;
+    m_ulFramesReceived = 0;
+    m_ulFramesDropped = 0;
+    m_iFrameRate = HUDVIEW_FRAMERATE_DEFAULT_FPS;
+    m_ullLastFrameNanoseconds = 0;
+    m_ulFramesPaced = 0;
+    m_dMotion = 0.0;
+    m_bMJPEG = false;
+    m_iJpegDenominator = 1;
+    m_ulJpegBytes = 0;
+    m_ulJpegScanned = 0;
+    m_bLowLight = false;
+    m_pxEnhance = new xHUDViewEnhance_t;
+    m_iEnhanceOverruns = 0;
+    m_iEnhanceBudgetMicroseconds = HUDVIEW_ENHANCE_BUDGET_US;
+    m_ulFramesEnhanced = 0;
+    m_dEnhanceTotalMicroseconds = 0.0;
+    m_dEnhanceMaximumMicroseconds = 0.0;
+
+    static_assert( ( HUDVIEW_ENHANCE_WIDTH == FRAME_WIDTH ) && ( HUDVIEW_ENHANCE_HEIGHT == FRAME_HEIGHT ),
+                   "The low-light stage works on the display picture" );
+    vHUDViewEnhanceInit( m_pxEnhance );
+
+    /* The fast DCT is used: the picture is scaled down after decoding, which hides the difference. */
+    iHUDViewJpegInit( &m_xJpeg, 1 );
+    bSetTransform( DEFAULT_TRANSFORM );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+CameraFeed::~CameraFeed()
+{
+    vClose();
+    vHUDViewJpegDestroy( &m_xJpeg );
+    delete m_pxEnhance;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool CameraFeed::bSetTransform( const QString & sSpecification )
+{
+    QByteArray Specification = sSpecification.toLocal8Bit();
+    xHUDViewTransformConfig_t xCapture;
+    xHUDViewTransformConfig_t xConfig;
+    xHUDViewTransform_t xTransform;
+    char acRawFormat[ 128 ];
+    int iDenominator = 1;
+    bool bReturn = false;
+
+    vHUDViewTransformDefaultConfig( &xCapture, FRAME_WIDTH, FRAME_HEIGHT );
+
+    if ( 0 != iHUDViewTransformParse( Specification.constData(), &xCapture ) )
+    {
+        return false;
+    }
+
+    xConfig = xCapture;
+
+    /* Compressed frames are decoded at the smallest scale that still covers the picture, and transformed from there. */
+    if ( xCapture.bMJPEG && ( 0 != iHUDViewJpegPlan( &xCapture, &xConfig, &iDenominator ) ) )
+    {
+        return false;
+    }
+
+    /* Only replace the current transform once the new specification is known to be usable. */
+    if ( ( 0 == iHUDViewTransformInit( &xTransform, &xConfig ) )
+         && ( 0 == iHUDViewTransformFormat( &xConfig, acRawFormat, sizeof( acRawFormat ) ) ) )
+    {
+        m_sRawFormat = acRawFormat;
+        m_xTransform = xTransform;
+        m_aucRawFrame.assign( static_cast<size_t>( iHUDViewTransformSourceBytes( &xConfig ) ), 0 );
+        m_pucRawFrame = m_aucRawFrame.data();
+        m_ulRawBytes = 0;
+        m_bMJPEG = xCapture.bMJPEG;
+        m_iJpegDenominator = iDenominator;
+
+        /* A JPEG frame is never larger than the raw frame it encodes. */
+        m_aucJpeg.assign( m_bMJPEG ? static_cast<size_t>( iHUDViewTransformSourceBytes( &xCapture ) ) : 0, 0 );
+        m_ulJpegBytes = 0;
+        m_ulJpegScanned = 0;
+
+        qDebug() << "Camera" << sSpecification << "using region"
+                 << QString( "%1x%2+%3+%4" ).arg( xTransform.xConfig.iCropWidth ).arg( xTransform.xConfig.iCropHeight )
+                                            .arg( xTransform.xConfig.iCropX ).arg( xTransform.xConfig.iCropY )
+                 << ( xTransform.bExact ? "as is" : pcHUDViewTransformFilterName( xConfig.eFilter ) )
+                 << "with" << pcHUDViewTransformKernels() << "kernels";
+
+        if ( m_bMJPEG )
+        {
+            qDebug() << "Camera MJPEG decoded at 1 /" << iDenominator << "scale as" << m_sRawFormat;
+        }
+
+        /* Slots are sized for the frame, so a ring already shared is replaced. */
+        if ( m_bRing )
+        {
+            vOpenRing();
+        }
+
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool CameraFeed::bOpen( const QString & sPath )
+{
+    QByteArray Path = sPath.toLocal8Bit();
+    bool bReturn = false;
+
+    vClose();
+
+    /* Create the FIFO if the camera has not done so already. */
+    if ( ( 0 == mkfifo( Path.constData(), 0666 ) ) || ( EEXIST == errno ) )
+    {
+        m_iReadDescriptor = open( Path.constData(), O_RDONLY | O_NONBLOCK );
+
+        if ( 0 <= m_iReadDescriptor )
+        {
+            /* Hold a write end open as well so the FIFO does not report EOF while the camera is not running. */
+            m_iWriteDescriptor = open( Path.constData(), O_WRONLY | O_NONBLOCK );
+
+            m_pNotifier = new QSocketNotifier( m_iReadDescriptor, QSocketNotifier::Read, this );
+            connect( m_pNotifier, SIGNAL( activated( int ) ), this, SLOT( vHandleReadable() ) );
+            vOpenRing();
+            bReturn = true;
+        }
+        else
+        {
+            qDebug() << "Failed to open camera FIFO: " << sPath;
+        }
+    }
+    else
+    {
+        qDebug() << "Failed to create camera FIFO: " << sPath;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vClose()
+{
+    if ( nullptr != m_pNotifier )
+    {
+        delete m_pNotifier;
+        m_pNotifier = nullptr;
+    }
+
+    if ( 0 <= m_iWriteDescriptor )
+    {
+        close( m_iWriteDescriptor );
+        m_iWriteDescriptor = -1;
+    }
+
+    if ( 0 <= m_iReadDescriptor )
+    {
+        close( m_iReadDescriptor );
+        m_iReadDescriptor = -1;
+    }
+
+    vCloseRing();
+    m_ulRawBytes = 0;
+    m_ulJpegBytes = 0;
+    m_ulJpegScanned = 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const uint16_t * CameraFeed::pusGetFrame() const
+{
+    return m_ausFrame.data();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const uint8_t * CameraFeed::pucGetLuma() const
+{
+    return m_aucLuma.data();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const uint8_t * CameraFeed::pucGetRawFrame() const
+{
+    return m_pucRawFrame;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+size_t CameraFeed::ulGetRawFrameBytes() const
+{
+    return m_aucRawFrame.size();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const QString & CameraFeed::sGetRawFormat() const
+{
+    return m_sRawFormat;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long CameraFeed::ulGetFramesReceived() const
+{
+    return m_ulFramesReceived;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long CameraFeed::ulGetFramesDropped() const
+{
+    return m_ulFramesDropped;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vSetFrameRate( int iFramesPerSecond )
+{
+    QByteArray Path = DEFAULT_CONTROL_PATH.toLocal8Bit();
+    QByteArray Command = QString( "fps %1\n" ).arg( iFramesPerSecond ).toLocal8Bit();
+    int iDescriptor = -1;
+
+    if ( ( 0 >= iFramesPerSecond ) || ( iFramesPerSecond == m_iFrameRate ) )
+    {
+        return;
+    }
+
+    m_iFrameRate = iFramesPerSecond;
+
+    /* The low-light stage keeps to the same share of a frame, whatever the frame's length. */
+    m_iEnhanceBudgetMicroseconds = 1000000 / ( ENHANCE_BUDGET_DIVISOR * iFramesPerSecond );
+
+    /* Without camera.py reading its end, the command is lost and the rate kept by pacing alone. */
+    iDescriptor = open( Path.constData(), O_WRONLY | O_NONBLOCK );
+
+    if ( ( 0 > iDescriptor ) || ( Command.size() != write( iDescriptor, Command.constData(), Command.size() ) ) )
+    {
+        qDebug() << "Camera frame rate" << iFramesPerSecond << "fps, paced here:" << strerror( errno );
+    }
+
+    if ( 0 <= iDescriptor )
+    {
+        close( iDescriptor );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int CameraFeed::iGetFrameRate() const
+{
+    return m_iFrameRate;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+double CameraFeed::dGetMotion() const
+{
+    return m_dMotion;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long CameraFeed::ulGetFramesPaced() const
+{
+    return m_ulFramesPaced;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vSetLowLight( bool bLowLight )
+{
+    if ( bLowLight == m_bLowLight )
+    {
+        return;
+    }
+
+    /* Each time it comes on it starts from the scene in front of it, with the filter back on. */
+    if ( bLowLight )
+    {
+        vHUDViewEnhanceReset( m_pxEnhance );
+        vHUDViewEnhanceSetDenoise( m_pxEnhance, 1, 0 );
+        m_iEnhanceOverruns = 0;
+    }
+
+    m_bLowLight = bLowLight;
+    qDebug() << "Camera low-light enhancement" << ( bLowLight ? "on" : "off" );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool CameraFeed::bIsLowLight() const
+{
+    return m_bLowLight;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vReportStatistics() const
+{
+    xHUDViewFrameRingConsumer_t xConsumer;
+
+    if ( 0 < m_ulFramesEnhanced )
+    {
+        qDebug() << "Camera low-light enhancement:" << m_ulFramesEnhanced << "frames with"
+                 << pcHUDViewEnhanceKernels() << "kernels,"
+                 << m_dEnhanceTotalMicroseconds / m_ulFramesEnhanced << "us mean,"
+                 << m_dEnhanceMaximumMicroseconds << "us max, mean luma" << m_pxEnhance->fMeanBefore << "->"
+                 << m_pxEnhance->fMeanAfter << ( m_pxEnhance->bDenoise ? "" : ", temporal filter off over budget" );
+    }
+
+    if ( !m_bRing )
+    {
+        return;
+    }
+
+    qDebug() << "Camera frame ring:" << m_xRing.pxHeader->ullPublished << "frames published,"
+             << m_xRing.pxHeader->ullProducerDropped << "kept private with no slot free,"
+             << m_xRing.pxHeader->ullReclaimed << "consumers reclaimed";
+
+    for ( int iConsumer = 0; iConsumer < HUDVIEW_FRAMERING_MAX_CONSUMERS; iConsumer++ )
+    {
+        vHUDViewFrameRingGetConsumer( &m_xRing, iConsumer, &xConsumer );
+
+        if ( HUDVIEW_FRAMERING_CONSUMER_READY == xConsumer.ulState )
+        {
+            qDebug() << "Camera frame consumer" << xConsumer.acName << "( pid" << xConsumer.lPid << "):"
+                     << xConsumer.ullFramesRead << "read," << xConsumer.ullFramesDropped << "dropped, lag"
+                     << xConsumer.ullLag << "frames (" << xConsumer.ullMaximumLag << "max),"
+                     << xConsumer.llMaximumAgeNanoseconds / 1e6 << "ms oldest";
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vOpenRing()
+{
+    QByteArray Format = m_sRawFormat.toLocal8Bit();
+
+    vCloseRing();
+
+    if ( 0 == iHUDViewFrameRingCreate( &m_xRing, HUDVIEW_FRAMERING_SHM_NAME, Format.constData(),
+                                       static_cast<uint32_t>( m_aucRawFrame.size() ) ) )
+    {
+        if ( 0 == iHUDViewFrameRingAttach( &m_xDisplay, HUDVIEW_FRAMERING_SHM_NAME, "display" ) )
+        {
+            qDebug() << "Camera frames shared in" << HUDVIEW_FRAMERING_SHM_NAME << "as" << m_sRawFormat;
+            m_bRing = true;
+        }
+        else
+        {
+            vHUDViewFrameRingDestroy( &m_xRing );
+        }
+    }
+
+    if ( !m_bRing )
+    {
+        qDebug() << "Camera frame ring unavailable (" << strerror( errno ) << "), frames kept private";
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vCloseRing()
+{
+    if ( m_bRing )
+    {
+        vHUDViewFrameRingDetach( &m_xDisplay );
+        vHUDViewFrameRingDestroy( &m_xRing );
+        m_bRing = false;
+    }
+
+    m_pucFilling = nullptr;
+    m_pucRawFrame = m_aucRawFrame.data();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint8_t * CameraFeed::pucBeginFrame()
+{
+    uint8_t * pucSlot = m_bRing ? pucHUDViewFrameRingBeginWrite( &m_xRing ) : nullptr;
+
+    return ( nullptr != pucSlot ) ? pucSlot : m_aucRawFrame.data();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool CameraFeed::bPaceFrame()
+{
+    struct timespec xNow;
+    uint64_t ullNow = 0;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+    ullNow = static_cast<uint64_t>( xNow.tv_sec ) * 1000000000ULL + static_cast<uint64_t>( xNow.tv_nsec );
+
+    /* A frame well ahead of the rate asked for is dropped before it costs anything more; the slack lets a camera
+     * running at the rate through, jitter and all. */
+    if ( ( 0 < m_ullLastFrameNanoseconds )
+         && ( ullNow - m_ullLastFrameNanoseconds < 750000000ULL / static_cast<uint64_t>( m_iFrameRate ) ) )
+    {
+        m_ulFramesPaced++;
+        return true;
+    }
+
+    m_ullLastFrameNanoseconds = ullNow;
+
+    return false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vPublishFrame()
+{
+    xHUDViewFrame_t xFrame;
+    struct timespec xNow;
+
+    /* A frame filled in the ring is published to every consumer, and taken back by the display like any other. */
+    if ( m_aucRawFrame.data() != m_pucFilling )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &xNow );
+        vHUDViewFrameRingCommit( &m_xRing, static_cast<uint32_t>( m_aucRawFrame.size() ),
+                                 static_cast<int64_t>( xNow.tv_sec ) * 1000000000LL + xNow.tv_nsec );
+
+        if ( 0 != iHUDViewFrameRingAcquire( &m_xDisplay, 1, &xFrame ) )
+        {
+            m_pucFilling = nullptr;
+            m_ulFramesDropped++;
+            return;
+        }
+
+        m_pucRawFrame = xFrame.pucData;
+    }
+    else
+    {
+        m_pucRawFrame = m_aucRawFrame.data();
+    }
+
+    m_pucFilling = nullptr;
+    vConvertFrame();
+    m_ulFramesReceived++;
+    emit frameReady();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vAbandonFrame()
+{
+    if ( m_aucRawFrame.data() != m_pucFilling )
+    {
+        vHUDViewFrameRingAbort( &m_xRing );
+    }
+
+    m_pucFilling = nullptr;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vHandleReadable()
+{
+    if ( m_bMJPEG )
+    {
+        vReadCompressed();
+    }
+    else
+    {
+        vReadRaw();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vReadRaw()
+{
+    ssize_t lBytesRead = 0;
+
+    /* Drain everything available, publishing each frame as soon as it is complete. A frame is read where it will be
+     * shared from, so the read from the FIFO is its only copy. */
+    do
+    {
+        if ( nullptr == m_pucFilling )
+        {
+            m_pucFilling = pucBeginFrame();
+        }
+
+        lBytesRead = read( m_iReadDescriptor, m_pucFilling + m_ulRawBytes, m_aucRawFrame.size() - m_ulRawBytes );
+
+        if ( 0 < lBytesRead )
+        {
+            m_ulRawBytes += static_cast<size_t>( lBytesRead );
+
+            if ( m_aucRawFrame.size() == m_ulRawBytes )
+            {
+                m_ulRawBytes = 0;
+
+                if ( bPaceFrame() )
+                {
+                    vAbandonFrame();
+                }
+                else
+                {
+                    vPublishFrame();
+                }
+            }
+        }
+    } while ( 0 < lBytesRead );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vReadCompressed()
+{
+    ssize_t lBytesRead = 0;
+
+    do
+    {
+        /* A whole buffer without the end of a frame means the stream is out of step; start again from the next one. */
+        if ( m_aucJpeg.size() == m_ulJpegBytes )
+        {
+            m_ulJpegBytes = 0;
+            m_ulJpegScanned = 0;
+            m_ulFramesDropped++;
+        }
+
+        lBytesRead = read( m_iReadDescriptor, &m_aucJpeg[ m_ulJpegBytes ], m_aucJpeg.size() - m_ulJpegBytes );
+
+        if ( 0 < lBytesRead )
+        {
+            m_ulJpegBytes += static_cast<size_t>( lBytesRead );
+            vExtractCompressedFrames();
+        }
+    } while ( 0 < lBytesRead );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vExtractCompressedFrames()
+{
+    uint8_t * pucBuffer = m_aucJpeg.data();
+    size_t ulStart = 0;
+    size_t ulEnd = 0;
+    size_t ulNewestStart = 0;
+    size_t ulNewestEnd = 0;
+    unsigned long ulComplete = 0;
+    int iWidth = 0;
+    int iHeight = 0;
+
+    /* Find every complete frame in the buffer; the search for the end of an incomplete one resumes where it stopped. */
+    for ( ;; )
+    {
+        ulStart = ulHUDViewJpegFindMarker( pucBuffer, m_ulJpegBytes, ulStart, HUDVIEW_JPEG_MARKER_SOI );
+
+        if ( m_ulJpegBytes == ulStart )
+        {
+            break;
+        }
+
+        ulEnd = ulHUDViewJpegFindMarker( pucBuffer, m_ulJpegBytes, std::max( ulStart + 2, m_ulJpegScanned ),
+                                         HUDVIEW_JPEG_MARKER_EOI );
+
+        if ( m_ulJpegBytes == ulEnd )
+        {
+            m_ulJpegScanned = m_ulJpegBytes - 1;
+            break;
+        }
+
+        ulNewestStart = ulStart;
+        ulNewestEnd = ulEnd + 2;
+        ulStart = ulNewestEnd;
+        m_ulJpegScanned = 0;
+        ulComplete++;
+    }
+
+    if ( 0 == ulComplete )
+    {
+        return;
+    }
+
+    /* Only the newest frame is shown; decoding any older one that is still waiting would only add latency. */
+    m_ulFramesDropped += ulComplete - 1;
+
+    /* Nor is a frame the pacing would drop; it is not worth decoding either. */
+    if ( !bPaceFrame() )
+    {
+        m_pucFilling = pucBeginFrame();
+
+        if ( ( 0 == iHUDViewJpegDecode( &m_xJpeg, pucBuffer + ulNewestStart, ulNewestEnd - ulNewestStart,
+                                        m_iJpegDenominator, eHUDViewJpegOutput_RGB888, m_pucFilling,
+                                        HUDVIEW_TRANSFORM_ALIGN( m_xTransform.xConfig.iSourceWidth,
+                                                                 HUDVIEW_TRANSFORM_CAPTURE_WIDTH_ALIGN ) * 3,
+                                        m_xTransform.xConfig.iSourceWidth, m_xTransform.xConfig.iSourceHeight,
+                                        nullptr, &iWidth, &iHeight ) )
+             && ( m_xTransform.xConfig.iSourceWidth == iWidth ) && ( m_xTransform.xConfig.iSourceHeight == iHeight ) )
+        {
+            vPublishFrame();
+        }
+        else
+        {
+            vAbandonFrame();
+            m_ulFramesDropped++;
+        }
+    }
+
+    /* Keep whatever follows the newest frame, the start of the next. */
+    memmove( pucBuffer, pucBuffer + ulNewestEnd, m_ulJpegBytes - ulNewestEnd );
+    m_ulJpegBytes -= ulNewestEnd;
+    m_ulJpegScanned = ( m_ulJpegScanned > ulNewestEnd ) ? m_ulJpegScanned - ulNewestEnd : 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vConvertFrame()
+{
+    /* The padding at the bottom of the frame is never read. The luma plane for the rear vision is produced in the same
+     * pass, while the pixels are in cache. */
+    m_aucPreviousLuma.swap( m_aucLuma );
+    vHUDViewTransformApply( &m_xTransform, m_pucRawFrame, m_ausFrame.data(), m_aucLuma.data() );
+
+    /* The first frame has nothing to compare with. */
+    m_dMotion = ( 0 < m_ulFramesReceived )
+                ? dHUDViewFrameRateMotion( m_aucPreviousLuma.data(), m_aucLuma.data(), FRAME_WIDTH, FRAME_HEIGHT )
+                : 0.0;
+
+    if ( m_bLowLight )
+    {
+        vEnhanceFrame();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void CameraFeed::vEnhanceFrame()
+{
+    struct timespec xStart;
+    struct timespec xEnd;
+    double dMicroseconds;
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+    vHUDViewEnhanceProcess( m_pxEnhance, m_aucLuma.data(), m_ausFrame.data() );
+    clock_gettime( CLOCK_MONOTONIC, &xEnd );
+
+    dMicroseconds = ( xEnd.tv_sec - xStart.tv_sec ) * 1e6 + ( xEnd.tv_nsec - xStart.tv_nsec ) / 1e3;
+    m_ulFramesEnhanced++;
+    m_dEnhanceTotalMicroseconds += dMicroseconds;
+    m_dEnhanceMaximumMicroseconds = std::max( m_dEnhanceMaximumMicroseconds, dMicroseconds );
+
+    /* The odd slow frame is the scheduler; a run of them is the machine, and the tone curve alone is cheaper. */
+    m_iEnhanceOverruns = ( m_iEnhanceBudgetMicroseconds < dMicroseconds ) ? m_iEnhanceOverruns + 1 : 0;
+
+    if ( m_pxEnhance->bDenoise && ( ENHANCE_OVERRUN_LIMIT <= m_iEnhanceOverruns ) )
+    {
+        qDebug() << "Camera low-light enhancement over its" << m_iEnhanceBudgetMicroseconds << "us budget for"
+                 << m_iEnhanceOverruns << "frames, temporal filter off";
+        vHUDViewEnhanceSetDenoise( m_pxEnhance, 0, 0 );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
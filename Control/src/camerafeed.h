@@ -0,0 +1,131 @@
+#ifndef CAMERAFEED_H
+#define CAMERAFEED_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QObject>
+#include <QSocketNotifier>
+
+#include "hudview_enhance.h"
+#include "hudview_framerate.h"
+#include "hudview_framering.h"
+#include "hudview_jpeg.h"
+#include "hudview_transform.h"
+
+class CameraFeed : public QObject
+{
+    Q_OBJECT
+
+public:
+    const QString DEFAULT_FIFO_PATH = "/tmp/hudview_camera_output";
+
+    /* Where camera.py takes frame rate commands, one "fps N" line each. */
+    const QString DEFAULT_CONTROL_PATH = "/tmp/hudview_camera_control";
+
+    /* The camera sends 160x120 RGB888 as captured, padded to 160x128; mirrored, the rear view reads like a mirror. */
+    const QString DEFAULT_TRANSFORM = "160x120:hflip";
+
+    /* Geometry of the picture handed on, whatever the camera captures: the display's and the rear vision's. */
+    static const int FRAME_WIDTH = 160;
+    static const int FRAME_HEIGHT = 120;
+
+    /* Frames in a row over budget before the low-light stage gives up its temporal filter, which may take this
+     * fraction of a frame period. */
+    static const int ENHANCE_OVERRUN_LIMIT = 5;
+    static const int ENHANCE_BUDGET_DIVISOR = 20;
+
+    explicit CameraFeed( QObject * pParent = nullptr );
+    ~CameraFeed();
+
+    bool bSetTransform( const QString & sSpecification );
+    bool bOpen( const QString & sPath );
+    void vClose();
+
+    const uint16_t * pusGetFrame() const;
+    const uint8_t * pucGetLuma() const;
+    const uint8_t * pucGetRawFrame() const;
+    size_t ulGetRawFrameBytes() const;
+    const QString & sGetRawFormat() const;
+    unsigned long ulGetFramesReceived() const;
+    unsigned long ulGetFramesDropped() const;
+    void vSetFrameRate( int iFramesPerSecond );
+    int iGetFrameRate() const;
+    double dGetMotion() const;
+    unsigned long ulGetFramesPaced() const;
+    void vSetLowLight( bool bLowLight );
+    bool bIsLowLight() const;
+    void vReportStatistics() const;
+
+signals:
+    void frameReady();
+
+private slots:
+    void vHandleReadable();
+
+private:
+    int m_iReadDescriptor;
+    int m_iWriteDescriptor;
+    QSocketNotifier * m_pNotifier;
+
+    /* Raw frames are read (or decoded) straight into a slot of the shared frame ring, which other processes can map
+     * as well; the display is one of the ring's consumers, and holds the frame it took while it is handed on to the
+     * recorder, dashcam and rear vision. Without the ring, or with no slot free, the private frame is used. */
+    bool m_bRing;
+    xHUDViewFrameRing_t m_xRing;
+    xHUDViewFrameRing_t m_xDisplay;
+    uint8_t * m_pucFilling;
+    const uint8_t * m_pucRawFrame;
+    std::vector<uint8_t> m_aucRawFrame;
+    size_t m_ulRawBytes;
+    std::vector<uint16_t> m_ausFrame;
+    std::vector<uint8_t> m_aucLuma;
+    unsigned long m_ulFramesReceived;
+    unsigned long m_ulFramesDropped;
+
+    /* The rate asked of the camera. Frames that come much sooner than it, from a camera that does not take rate
+     * commands, are read but go no further. The motion is the share of the picture that changed since the last frame,
+     * from the luma of both. */
+    int m_iFrameRate;
+    uint64_t m_ullLastFrameNanoseconds;
+    unsigned long m_ulFramesPaced;
+    std::vector<uint8_t> m_aucPreviousLuma;
+    double m_dMotion;
+
+    /* Orientation, crop and scaling from the raw frame's geometry to the picture's, all in one pass. */
+    QString m_sRawFormat;
+    xHUDViewTransform_t m_xTransform;
+
+    /* In MJPEG mode, compressed frames are gathered here and the newest is decoded, scaled down in the DCT, into the
+     * raw frame, laid out as the camera would send a raw frame that size. */
+    bool m_bMJPEG;
+    int m_iJpegDenominator;
+    xHUDViewJpeg_t m_xJpeg;
+    std::vector<uint8_t> m_aucJpeg;
+    size_t m_ulJpegBytes;
+    size_t m_ulJpegScanned;
+
+    /* In low light the display picture is denoised and tone mapped after the transform; the luma for the rear vision
+     * stays as captured. If the stage keeps running over its budget it carries on without the temporal filter. */
+    bool m_bLowLight;
+    xHUDViewEnhance_t * m_pxEnhance;
+    int m_iEnhanceOverruns;
+    int m_iEnhanceBudgetMicroseconds;
+    unsigned long m_ulFramesEnhanced;
+    double m_dEnhanceTotalMicroseconds;
+    double m_dEnhanceMaximumMicroseconds;
+
+    void vOpenRing();
+    void vCloseRing();
+    uint8_t * pucBeginFrame();
+    bool bPaceFrame();
+    void vPublishFrame();
+    void vAbandonFrame();
+    void vReadRaw();
+    void vReadCompressed();
+    void vExtractCompressedFrames();
+    void vConvertFrame();
+    void vEnhanceFrame();
+};
+
+#endif // CAMERAFEED_H
@@ -0,0 +1,365 @@
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include "componenthandler.h"
+#include "hudview_button.h"
+#include "hudview_trace.h"
+#include "latencytracer.h"
+#include "telemetrysink.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Every parsed record, tens of lines a second; off unless asked for with --verbose or QT_LOGGING_RULES. */
+Q_LOGGING_CATEGORY( HUDViewRecords, "hudview.records", QtWarningMsg )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+template <class T> static ComponentHandler * pCreateHandler();
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Factories for each component type; new types register here instead of extending a switch in the engine. */
+static ComponentHandler::pfnComponentHandlerFactory_t apfnFactories[ ControlEngine::eHUDViewComponentIDMax ] =
+{
+    nullptr
+};
+static bool bBuiltInFactoriesRegistered = false;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentHandler::ComponentHandler( ControlEngine::eHUDViewComponentID_t eID )
+{
+    m_eID = eID;
+    m_ulRecordsFramed = 0;
+    m_pxMetrics = nullptr;
+    m_pTracer = nullptr;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentHandler::~ComponentHandler()
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ControlEngine::eHUDViewComponentID_t ComponentHandler::eGetID() const
+{
+    return m_eID;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentHandler::bReadyWhenStarted() const
+{
+    return false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long ComponentHandler::ulGetRecordsFramed() const
+{
+    return m_ulRecordsFramed;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentHandler::vSetMetrics( xHUDViewMetricsComponent_t * pxMetrics )
+{
+    m_pxMetrics = pxMetrics;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentHandler::vAddTelemetrySink( TelemetrySink * pSink )
+{
+    m_lstTelemetrySinks.append( pSink );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentHandler::vSetLatencyTracer( LatencyTracer * pTracer )
+{
+    m_pTracer = pTracer;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentHandler::vReset()
+{
+    m_PendingData.clear();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long ComponentHandler::ulHandleData( const QByteArray & Data, ControlEngine::xHUDViewDataModel_t & xModel,
+                                              uint64_t ullArrival )
+{
+    unsigned long ulApplied = 0;
+    uint64_t ullParseStart = 0;
+    uint64_t ullUpdated = 0;
+    xHUDViewTraceStamp_t xStamp;
+    QByteArray Record;
+    size_t ulStamp = 0;
+    bool bApplied = false;
+    int iStart = 0;
+    int iEnd = -1;
+
+    m_PendingData.append( Data );
+
+    /* Hand over every complete line, keeping any partial record until the rest of it arrives. */
+    while ( -1 != ( iEnd = m_PendingData.indexOf( '\n', iStart ) ) )
+    {
+        m_ulRecordsFramed++;
+        ullParseStart = ullHUDViewMetricsNow();
+        Record = m_PendingData.mid( iStart, iEnd - iStart ).trimmed();
+
+        /* The component's trace stamp is not part of the record. */
+        ulStamp = ulHUDViewTraceParse( Record.constData(), static_cast<size_t>( Record.size() ), &xStamp );
+
+        if ( 0 < ulStamp )
+        {
+            Record.remove( 0, static_cast<int>( ulStamp ) );
+        }
+
+        bApplied = bHandleRecord( Record, xModel );
+
+        if ( bApplied )
+        {
+            ulApplied++;
+
+            /* Capture every applied sample, not just the latest state, so a crash or a ride can be reconstructed. */
+            for ( TelemetrySink * pSink : m_lstTelemetrySinks )
+            {
+                if ( pSink->bIsOpen() )
+                {
+                    vRecordTelemetry( *pSink, xModel );
+                }
+            }
+        }
+
+        ullUpdated = ullHUDViewMetricsNow();
+        vHUDViewMetricsRecord( m_pxMetrics, eHUDViewMetricsStage_Parse, ullUpdated - ullParseStart );
+
+        if ( ( nullptr != m_pTracer ) && ( 0 < ulStamp ) )
+        {
+            m_pTracer->vNoteRecord( m_eID, xStamp, ( 0 != ullArrival ) ? ullArrival : ullParseStart, ullParseStart,
+                                    ullUpdated, bApplied );
+        }
+
+        iStart = iEnd + 1;
+    }
+
+    m_PendingData.remove( 0, iStart );
+
+    /* A component that never terminates its output must not grow the buffer without bound. */
+    if ( MAXIMUM_RECORD_LENGTH < m_PendingData.size() )
+    {
+        qDebug() << "Discarding unterminated output from component: "
+                 << ControlEngine::sEnumValueToComponentName( m_eID );
+        m_PendingData.clear();
+    }
+
+    return ulApplied;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentHandler::vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    Q_UNUSED( Sink );
+    Q_UNUSED( xModel );
+
+    /* Components without telemetry worth keeping record nothing. */
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentHandler::bRegisterFactory( ControlEngine::eHUDViewComponentID_t eID,
+                                         pfnComponentHandlerFactory_t pfnFactory )
+{
+    bool bReturn = false;
+
+    if ( ( ControlEngine::eHUDViewComponentIDMin < eID ) && ( ControlEngine::eHUDViewComponentID_Unknown > eID ) )
+    {
+        apfnFactories[ eID ] = pfnFactory;
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentHandler * ComponentHandler::pCreate( ControlEngine::eHUDViewComponentID_t eID )
+{
+    ComponentHandler * pReturn = nullptr;
+
+    if ( !bBuiltInFactoriesRegistered )
+    {
+        bBuiltInFactoriesRegistered = true;
+        ( void )bRegisterFactory( ControlEngine::eHUDViewComponentID_Accelerometer,
+                                  pCreateHandler<AccelerometerHandler> );
+        ( void )bRegisterFactory( ControlEngine::eHUDViewComponentID_GPS, pCreateHandler<GPSHandler> );
+        ( void )bRegisterFactory( ControlEngine::eHUDViewComponentID_HandlebarButtons,
+                                  pCreateHandler<HandlebarButtonsHandler> );
+        ( void )bRegisterFactory( ControlEngine::eHUDViewComponentID_LightSensor, pCreateHandler<LightSensorHandler> );
+    }
+
+    if ( ( ControlEngine::eHUDViewComponentIDMin < eID ) && ( ControlEngine::eHUDViewComponentIDMax > eID )
+         && ( nullptr != apfnFactories[ eID ] ) )
+    {
+        pReturn = apfnFactories[ eID ]();
+    }
+    else
+    {
+        /* Components without a dedicated parser still get framed and logged. */
+        pReturn = new GenericHandler( eID );
+    }
+
+    return pReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+AccelerometerHandler::AccelerometerHandler() : ComponentHandler( ControlEngine::eHUDViewComponentID_Accelerometer )
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool AccelerometerHandler::bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    bool bReturn = ControlEngine::bParseAccelerometerData( Record, xModel.xAccelerometer );
+
+    if ( bReturn )
+    {
+        qCDebug( HUDViewRecords ) << "Accelerometer:" << xModel.xAccelerometer.dX << xModel.xAccelerometer.dY
+                                  << xModel.xAccelerometer.dZ;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void AccelerometerHandler::vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    Sink.vRecordAccelerometer( xModel.xAccelerometer.dX, xModel.xAccelerometer.dY, xModel.xAccelerometer.dZ );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+GPSHandler::GPSHandler() : ComponentHandler( ControlEngine::eHUDViewComponentID_GPS )
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool GPSHandler::bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    bool bReturn = ControlEngine::bParseGPSData( Record, xModel.xGPS );
+
+    if ( bReturn )
+    {
+        qCDebug( HUDViewRecords ) << "GPS: Latitude:" << xModel.xGPS.dLatitude << "Longitude:" << xModel.xGPS.dLongitude
+                                  << "Speed:" << xModel.xGPS.dSpeed << "Direction:" << xModel.xGPS.dDirection;
+    }
+    else
+    {
+        qCDebug( HUDViewRecords ) << "GPS: No fix!";
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void GPSHandler::vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    Sink.vRecordGPS( xModel.xGPS.bHasFix, xModel.xGPS.dLatitude, xModel.xGPS.dLongitude, xModel.xGPS.dSpeed,
+                     xModel.xGPS.dDirection );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+HandlebarButtonsHandler::HandlebarButtonsHandler() :
+    ComponentHandler( ControlEngine::eHUDViewComponentID_HandlebarButtons )
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool HandlebarButtonsHandler::bReadyWhenStarted() const
+{
+    /* The daemon prints nothing until the first press, which may not come for the whole ride. */
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool HandlebarButtonsHandler::bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    bool bReturn = false;
+
+    /* The button daemon debounces the line and decodes each press; anything else is not a press. */
+    if ( HUDVIEW_BUTTON_RECORD_SHORT == Record )
+    {
+        xModel.ulButtonPresses++;
+        bReturn = true;
+    }
+    else if ( HUDVIEW_BUTTON_RECORD_LONG == Record )
+    {
+        xModel.ulButtonPresses++;
+        xModel.ulButtonLongPresses++;
+        bReturn = true;
+    }
+    else if ( HUDVIEW_BUTTON_RECORD_DOUBLE == Record )
+    {
+        xModel.ulButtonPresses++;
+        xModel.ulButtonDoublePresses++;
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void HandlebarButtonsHandler::vRecordTelemetry( TelemetrySink & Sink,
+                                                const ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    Sink.vRecordButtonPress( xModel.ulButtonPresses );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+LightSensorHandler::LightSensorHandler() : ComponentHandler( ControlEngine::eHUDViewComponentID_LightSensor )
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool LightSensorHandler::bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    bool bReturn = false;
+    long lLux = Record.toLong( &bReturn );
+
+    /* Store the value. */
+    if ( bReturn )
+    {
+        xModel.lLightSensorLux = lLux;
+        qCDebug( HUDViewRecords ) << "Light Sensor:" << xModel.lLightSensorLux;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void LightSensorHandler::vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    Sink.vRecordLightSensor( xModel.lLightSensorLux );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+GenericHandler::GenericHandler( ControlEngine::eHUDViewComponentID_t eID ) : ComponentHandler( eID )
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool GenericHandler::bReadyWhenStarted() const
+{
+    /* Nothing it prints is parsed, e.g. the camera sends its frames through a FIFO of its own. */
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool GenericHandler::bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel )
+{
+    Q_UNUSED( xModel );
+
+    /* Nothing to do. */
+    qCDebug( HUDViewRecords ) << "Received data for component: "
+                              << ControlEngine::sEnumValueToComponentName( eGetID() ) << Record;
+
+    return false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+template <class T> static ComponentHandler * pCreateHandler()
+{
+    return new T();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
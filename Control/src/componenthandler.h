@@ -0,0 +1,112 @@
+#ifndef COMPONENTHANDLER_H
+#define COMPONENTHANDLER_H
+
+#include <QByteArray>
+#include <QList>
+
+#include "controlengine.h"
+#include "hudview_metrics.h"
+
+class LatencyTracer;
+class TelemetrySink;
+
+class ComponentHandler
+{
+public:
+    typedef ComponentHandler * ( *pfnComponentHandlerFactory_t )();
+
+    explicit ComponentHandler( ControlEngine::eHUDViewComponentID_t eID );
+    virtual ~ComponentHandler();
+
+    ControlEngine::eHUDViewComponentID_t eGetID() const;
+
+    /* A component that only speaks when something happens, or never does, is ready once its process has started. */
+    virtual bool bReadyWhenStarted() const;
+    unsigned long ulGetRecordsFramed() const;
+    void vSetMetrics( xHUDViewMetricsComponent_t * pxMetrics );
+    void vAddTelemetrySink( TelemetrySink * pSink );
+    void vSetLatencyTracer( LatencyTracer * pTracer );
+    void vReset();
+
+    /* ullArrival is when the data was picked up from the component, or 0 for now. */
+    unsigned long ulHandleData( const QByteArray & Data, ControlEngine::xHUDViewDataModel_t & xModel,
+                                uint64_t ullArrival = 0 );
+
+    static bool bRegisterFactory( ControlEngine::eHUDViewComponentID_t eID, pfnComponentHandlerFactory_t pfnFactory );
+    static ComponentHandler * pCreate( ControlEngine::eHUDViewComponentID_t eID );
+
+protected:
+    /* Longest record accepted before the pending data is discarded as garbage. */
+    static const int MAXIMUM_RECORD_LENGTH = 512;
+
+    virtual bool bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel ) = 0;
+    virtual void vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel );
+
+private:
+    ControlEngine::eHUDViewComponentID_t m_eID;
+    QByteArray m_PendingData;
+    unsigned long m_ulRecordsFramed;
+    xHUDViewMetricsComponent_t * m_pxMetrics;
+    QList<TelemetrySink *> m_lstTelemetrySinks;
+    LatencyTracer * m_pTracer;
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+class AccelerometerHandler : public ComponentHandler
+{
+public:
+    AccelerometerHandler();
+
+protected:
+    bool bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel ) override;
+    void vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel ) override;
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+class GPSHandler : public ComponentHandler
+{
+public:
+    GPSHandler();
+
+protected:
+    bool bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel ) override;
+    void vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel ) override;
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+class HandlebarButtonsHandler : public ComponentHandler
+{
+public:
+    HandlebarButtonsHandler();
+
+    bool bReadyWhenStarted() const override;
+
+protected:
+    bool bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel ) override;
+    void vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel ) override;
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+class LightSensorHandler : public ComponentHandler
+{
+public:
+    LightSensorHandler();
+
+protected:
+    bool bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel ) override;
+    void vRecordTelemetry( TelemetrySink & Sink, const ControlEngine::xHUDViewDataModel_t & xModel ) override;
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+class GenericHandler : public ComponentHandler
+{
+public:
+    explicit GenericHandler( ControlEngine::eHUDViewComponentID_t eID );
+
+    bool bReadyWhenStarted() const override;
+
+protected:
+    bool bHandleRecord( const QByteArray & Record, ControlEngine::xHUDViewDataModel_t & xModel ) override;
+};
+
+#endif // COMPONENTHANDLER_H
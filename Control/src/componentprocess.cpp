@@ -0,0 +1,362 @@
+#include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <QDebug>
+#include <QProcessEnvironment>
+#include <QStringList>
+
+#include "componentprocess.h"
+#include "hudview_memlock.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define IOPRIO_WHO_PROCESS ( 1 )
+#define IOPRIO_CLASS_SHIFT ( 13 )
+#define IOPRIO_LEVELS ( 8 )
+#define MAXIMUM_AFFINITY_CPUS ( 64 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentProcess::ComponentProcess( QObject * pParent ) : QProcess( pParent )
+{
+    m_xSchedulingOptions = xDefaultSchedulingOptions();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentProcess::vSetSchedulingOptions( const xSchedulingOptions_t & xOptions )
+{
+    QProcessEnvironment Environment = QProcessEnvironment::systemEnvironment();
+
+    m_xSchedulingOptions = xOptions;
+
+    /* Memory locks do not survive exec(), so the component is asked to lock its own memory instead. */
+    if ( xOptions.bLockMemory )
+    {
+        Environment.insert( HUDVIEW_MLOCK_ENVIRONMENT_VARIABLE, "1" );
+    }
+    else
+    {
+        Environment.remove( HUDVIEW_MLOCK_ENVIRONMENT_VARIABLE );
+    }
+
+    setProcessEnvironment( Environment );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const ComponentProcess::xSchedulingOptions_t & ComponentProcess::xGetSchedulingOptions() const
+{
+    return m_xSchedulingOptions;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentProcess::bVerifySchedulingOptions() const
+{
+    const xSchedulingOptions_t & xOptions = m_xSchedulingOptions;
+    pid_t xPid = static_cast<pid_t>( processId() );
+    cpu_set_t xCPUs;
+    struct sched_param xParameters;
+    int iPolicy = 0;
+    int iNice = 0;
+    long lIOPriority = 0;
+    bool bReturn = true;
+
+    /* The options are applied in the child after fork(), where failures cannot be reported, so read them back. */
+    if ( 0 != xOptions.ullAffinityMask )
+    {
+        CPU_ZERO( &xCPUs );
+
+        if ( 0 == sched_getaffinity( xPid, sizeof( xCPUs ), &xCPUs ) )
+        {
+            for ( int iCPU = 0; MAXIMUM_AFFINITY_CPUS > iCPU; iCPU++ )
+            {
+                if ( ( 0 != ( xOptions.ullAffinityMask & ( 1ULL << iCPU ) ) ) != ( 0 != CPU_ISSET( iCPU, &xCPUs ) ) )
+                {
+                    qDebug() << "CPU affinity not applied to: " << program();
+                    bReturn = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    if ( 0 < xOptions.iFifoPriority )
+    {
+        iPolicy = sched_getscheduler( xPid );
+
+        if ( ( 0 > iPolicy ) || ( SCHED_FIFO != ( iPolicy & ~SCHED_RESET_ON_FORK ) )
+             || ( 0 != sched_getparam( xPid, &xParameters ) )
+             || ( xOptions.iFifoPriority != xParameters.sched_priority ) )
+        {
+            qDebug() << "SCHED_FIFO priority not applied to: " << program() << "(needs CAP_SYS_NICE)";
+            bReturn = false;
+        }
+    }
+
+    if ( xOptions.bHasNice )
+    {
+        errno = 0;
+        iNice = getpriority( PRIO_PROCESS, static_cast<id_t>( xPid ) );
+
+        if ( ( 0 != errno ) || ( xOptions.iNice != iNice ) )
+        {
+            qDebug() << "Nice value not applied to: " << program();
+            bReturn = false;
+        }
+    }
+
+    if ( eIOClass_Unchanged != xOptions.eIOClass )
+    {
+        lIOPriority = syscall( SYS_ioprio_get, IOPRIO_WHO_PROCESS, xPid );
+
+        if ( ( ( static_cast<long>( xOptions.eIOClass ) << IOPRIO_CLASS_SHIFT ) | xOptions.iIOLevel ) != lIOPriority )
+        {
+            qDebug() << "I/O priority not applied to: " << program();
+            bReturn = false;
+        }
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentProcess::xSchedulingOptions_t ComponentProcess::xDefaultSchedulingOptions()
+{
+    xSchedulingOptions_t xOptions;
+
+    xOptions.ullAffinityMask = 0;
+    xOptions.bHasNice = false;
+    xOptions.iNice = 0;
+    xOptions.iFifoPriority = 0;
+    xOptions.bLockMemory = false;
+    xOptions.eIOClass = eIOClass_Unchanged;
+    xOptions.iIOLevel = 0;
+
+    return xOptions;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentProcess::bIsDefault( const xSchedulingOptions_t & xOptions )
+{
+    return ( 0 == xOptions.ullAffinityMask ) && !xOptions.bHasNice && ( 0 == xOptions.iFifoPriority )
+           && !xOptions.bLockMemory && ( eIOClass_Unchanged == xOptions.eIOClass );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentProcess::bParseSchedulingOption( const QString & sName, const QString & sValue,
+                                               xSchedulingOptions_t & xOptions, QString & sError )
+{
+    long lCPUs = qMin( sysconf( _SC_NPROCESSORS_CONF ), static_cast<long>( MAXIMUM_AFFINITY_CPUS ) );
+    QStringList lstParts;
+    bool bValid = false;
+    int iValue = 0;
+    int iFirst = 0;
+    int iLast = 0;
+
+    if ( "affinity" == sName )
+    {
+        /* A list of CPUs and ranges, e.g. "3" or "0,2-3". */
+        xOptions.ullAffinityMask = 0;
+
+        for ( const QString & sRange : sValue.split( ',' ) )
+        {
+            lstParts = sRange.split( '-' );
+            iFirst = lstParts.at( 0 ).toInt( &bValid );
+
+            if ( bValid )
+            {
+                iLast = ( 2 == lstParts.length() ) ? lstParts.at( 1 ).toInt( &bValid ) : iFirst;
+            }
+
+            if ( !bValid || ( 2 < lstParts.length() ) || ( 0 > iFirst ) || ( iFirst > iLast ) || ( lCPUs <= iLast ) )
+            {
+                sError = QString( "affinity must list CPUs between 0 and %1" ).arg( lCPUs - 1 );
+                return false;
+            }
+
+            for ( int iCPU = iFirst; iLast >= iCPU; iCPU++ )
+            {
+                xOptions.ullAffinityMask |= 1ULL << iCPU;
+            }
+        }
+    }
+    else if ( "nice" == sName )
+    {
+        iValue = sValue.toInt( &bValid );
+
+        if ( !bValid || ( -20 > iValue ) || ( 19 < iValue ) )
+        {
+            sError = "nice must be between -20 and 19";
+            return false;
+        }
+
+        xOptions.bHasNice = true;
+        xOptions.iNice = iValue;
+    }
+    else if ( "fifo" == sName )
+    {
+        iValue = sValue.toInt( &bValid );
+
+        if ( !bValid || ( sched_get_priority_min( SCHED_FIFO ) > iValue )
+             || ( sched_get_priority_max( SCHED_FIFO ) < iValue ) )
+        {
+            sError = QString( "fifo must be between %1 and %2" ).arg( sched_get_priority_min( SCHED_FIFO ) )
+                                                                 .arg( sched_get_priority_max( SCHED_FIFO ) );
+            return false;
+        }
+
+        xOptions.iFifoPriority = iValue;
+    }
+    else if ( "mlock" == sName )
+    {
+        if ( ( "0" != sValue ) && ( "1" != sValue ) )
+        {
+            sError = "mlock must be 0 or 1";
+            return false;
+        }
+
+        xOptions.bLockMemory = ( "1" == sValue );
+    }
+    else if ( "ioprio" == sName )
+    {
+        /* "rt:<level>", "be:<level>" or "idle", with levels from 0 (highest) to 7. */
+        lstParts = sValue.split( ':' );
+        iValue = ( 2 == lstParts.length() ) ? lstParts.at( 1 ).toInt( &bValid ) : 0;
+
+        if ( ( 2 == lstParts.length() ) && bValid && ( 0 <= iValue ) && ( IOPRIO_LEVELS > iValue )
+             && ( ( "rt" == lstParts.at( 0 ) ) || ( "be" == lstParts.at( 0 ) ) ) )
+        {
+            xOptions.eIOClass = ( "rt" == lstParts.at( 0 ) ) ? eIOClass_RealTime : eIOClass_BestEffort;
+            xOptions.iIOLevel = iValue;
+        }
+        else if ( "idle" == sValue )
+        {
+            xOptions.eIOClass = eIOClass_Idle;
+            xOptions.iIOLevel = 0;
+        }
+        else
+        {
+            sError = "ioprio must be rt:<0-7>, be:<0-7> or idle";
+            return false;
+        }
+    }
+    else
+    {
+        sError = "unknown option " + sName;
+        return false;
+    }
+
+    /* A SCHED_FIFO task is never time-shared, so a nice value would silently do nothing. */
+    if ( xOptions.bHasNice && ( 0 < xOptions.iFifoPriority ) )
+    {
+        sError = "nice and fifo cannot both be set";
+        return false;
+    }
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentProcess::bApplySchedulingOptions( const xSchedulingOptions_t & xOptions )
+{
+    cpu_set_t xCPUs;
+    struct sched_param xParameters;
+    bool bReturn = true;
+
+    /* Only system calls from here on, as this also runs in the child between fork() and exec(). An unset affinity
+     * still replaces the inherited one, so a pinned control application does not pin every component with it. */
+    CPU_ZERO( &xCPUs );
+
+    for ( int iCPU = 0; MAXIMUM_AFFINITY_CPUS > iCPU; iCPU++ )
+    {
+        if ( ( 0 == xOptions.ullAffinityMask ) || ( 0 != ( xOptions.ullAffinityMask & ( 1ULL << iCPU ) ) ) )
+        {
+            CPU_SET( iCPU, &xCPUs );
+        }
+    }
+
+    if ( 0 != sched_setaffinity( 0, sizeof( xCPUs ), &xCPUs ) )
+    {
+        bReturn = false;
+    }
+
+    /* Real-time and negative nice settings are not handed down to processes forked later. */
+    if ( 0 < xOptions.iFifoPriority )
+    {
+        xParameters.sched_priority = xOptions.iFifoPriority;
+
+        if ( 0 != sched_setscheduler( 0, SCHED_FIFO | SCHED_RESET_ON_FORK, &xParameters ) )
+        {
+            bReturn = false;
+        }
+    }
+    else if ( xOptions.bHasNice )
+    {
+        xParameters.sched_priority = 0;
+
+        if ( ( 0 != sched_setscheduler( 0, SCHED_OTHER | SCHED_RESET_ON_FORK, &xParameters ) )
+             || ( 0 != setpriority( PRIO_PROCESS, 0, xOptions.iNice ) ) )
+        {
+            bReturn = false;
+        }
+    }
+
+    if ( eIOClass_Unchanged != xOptions.eIOClass )
+    {
+        if ( 0 != syscall( SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+                           ( static_cast<int>( xOptions.eIOClass ) << IOPRIO_CLASS_SHIFT ) | xOptions.iIOLevel ) )
+        {
+            bReturn = false;
+        }
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+QString ComponentProcess::sDescribe( const xSchedulingOptions_t & xOptions )
+{
+    QStringList lstOptions;
+
+    if ( 0 != xOptions.ullAffinityMask )
+    {
+        lstOptions << QString( "affinity=0x%1" ).arg( xOptions.ullAffinityMask, 0, 16 );
+    }
+
+    if ( xOptions.bHasNice )
+    {
+        lstOptions << QString( "nice=%1" ).arg( xOptions.iNice );
+    }
+
+    if ( 0 < xOptions.iFifoPriority )
+    {
+        lstOptions << QString( "fifo=%1" ).arg( xOptions.iFifoPriority );
+    }
+
+    if ( xOptions.bLockMemory )
+    {
+        lstOptions << "mlock=1";
+    }
+
+    if ( eIOClass_RealTime == xOptions.eIOClass )
+    {
+        lstOptions << QString( "ioprio=rt:%1" ).arg( xOptions.iIOLevel );
+    }
+    else if ( eIOClass_BestEffort == xOptions.eIOClass )
+    {
+        lstOptions << QString( "ioprio=be:%1" ).arg( xOptions.iIOLevel );
+    }
+    else if ( eIOClass_Idle == xOptions.eIOClass )
+    {
+        lstOptions << "ioprio=idle";
+    }
+
+    return lstOptions.isEmpty() ? QString( "default" ) : lstOptions.join( ' ' );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentProcess::setupChildProcess()
+{
+    /* Runs in the child just before exec(), so everything the component does inherits the settings. */
+    bApplySchedulingOptions( m_xSchedulingOptions );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,56 @@
+#ifndef COMPONENTPROCESS_H
+#define COMPONENTPROCESS_H
+
+#include <sys/types.h>
+
+#include <QProcess>
+#include <QString>
+
+class ComponentProcess : public QProcess
+{
+    Q_OBJECT
+
+public:
+    /* I/O scheduling classes, as used by ioprio_set(2). */
+    enum eIOClass_t {
+        eIOClass_Unchanged = 0,
+        eIOClass_RealTime,
+        eIOClass_BestEffort,
+        eIOClass_Idle
+    };
+
+    /* Scheduling set in the config file with "Name.option=value" lines. */
+    struct xSchedulingOptions_t {
+        /* One bit per CPU; zero lets the component run on any CPU. */
+        unsigned long long ullAffinityMask;
+        bool bHasNice;
+        int iNice;
+
+        /* A SCHED_FIFO priority, or zero to stay under the default time-sharing scheduler. */
+        int iFifoPriority;
+        bool bLockMemory;
+        eIOClass_t eIOClass;
+        int iIOLevel;
+    };
+
+    explicit ComponentProcess( QObject * pParent = nullptr );
+
+    void vSetSchedulingOptions( const xSchedulingOptions_t & xOptions );
+    const xSchedulingOptions_t & xGetSchedulingOptions() const;
+    bool bVerifySchedulingOptions() const;
+
+    static xSchedulingOptions_t xDefaultSchedulingOptions();
+    static bool bIsDefault( const xSchedulingOptions_t & xOptions );
+    static bool bParseSchedulingOption( const QString & sName, const QString & sValue, xSchedulingOptions_t & xOptions,
+                                        QString & sError );
+    static bool bApplySchedulingOptions( const xSchedulingOptions_t & xOptions );
+    static QString sDescribe( const xSchedulingOptions_t & xOptions );
+
+protected:
+    void setupChildProcess() override;
+
+private:
+    xSchedulingOptions_t m_xSchedulingOptions;
+};
+
+#endif // COMPONENTPROCESS_H
@@ -0,0 +1,367 @@
+#include <QDebug>
+
+#include "componentsupervisor.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const int ComponentSupervisor::STALL_CHECK_INTERVAL_MS;
+const int ComponentSupervisor::RESTART_BACKOFF_INITIAL_MS;
+const int ComponentSupervisor::RESTART_BACKOFF_MAXIMUM_MS;
+const int ComponentSupervisor::STABLE_RUN_MS;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentSupervisor::ComponentSupervisor( QObject * pParent ) : QObject( pParent )
+{
+    m_bRestartAfterExit = true;
+    m_bStallDetection = true;
+    m_bRunning = false;
+
+    m_StallTimer.setInterval( STALL_CHECK_INTERVAL_MS );
+    m_StallTimer.setSingleShot( false );
+    connect( &m_StallTimer, SIGNAL( timeout() ), this, SLOT( vCheckForStalls() ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentSupervisor::~ComponentSupervisor()
+{
+    vStop();
+    qDeleteAll( m_hashComponents );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentSupervisor::bAddComponent( const ControlEngine::xHUDViewComponent_t & xComponent )
+{
+    xSupervisedComponent_t * pxComponent = nullptr;
+
+    if ( !ControlEngine::bIsValidComponent( xComponent ) || m_hashComponents.contains( xComponent.pProcess ) )
+    {
+        return false;
+    }
+
+    pxComponent = new xSupervisedComponent_t();
+    pxComponent->eID = xComponent.eID;
+    pxComponent->pProcess = xComponent.pProcess;
+    pxComponent->pRestartTimer = new QTimer( this );
+    pxComponent->iStallTimeoutMs = iGetStallTimeoutMs( xComponent.eID );
+    pxComponent->iConsecutiveFailures = 0;
+    pxComponent->bRestartPending = false;
+    pxComponent->bKilledForStall = false;
+    pxComponent->ulRestarts = 0;
+    pxComponent->ulStalls = 0;
+    pxComponent->llLastRestartNanoseconds = 0;
+    pxComponent->llMaximumRestartNanoseconds = 0;
+
+    pxComponent->pRestartTimer->setSingleShot( true );
+    connect( pxComponent->pRestartTimer, SIGNAL( timeout() ), this, SLOT( vHandleRestartTimeout() ) );
+
+    connect( xComponent.pProcess, SIGNAL( started() ), this, SLOT( vHandleStarted() ) );
+    connect( xComponent.pProcess, SIGNAL( finished( int, QProcess::ExitStatus ) ),
+             this, SLOT( vHandleFinished( int, QProcess::ExitStatus ) ) );
+    connect( xComponent.pProcess, SIGNAL( errorOccurred( QProcess::ProcessError ) ),
+             this, SLOT( vHandleError( QProcess::ProcessError ) ) );
+
+    m_hashComponents.insert( xComponent.pProcess, pxComponent );
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vSetRestartAfterExit( bool bRestart )
+{
+    m_bRestartAfterExit = bRestart;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vSetStallDetection( bool bEnabled )
+{
+    m_bStallDetection = bEnabled;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vStart()
+{
+    m_bRunning = true;
+    m_StallTimer.start();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vStop()
+{
+    /* Processes killed during shutdown must not be brought back. */
+    m_bRunning = false;
+    m_StallTimer.stop();
+
+    for ( xSupervisedComponent_t * pxComponent : m_hashComponents )
+    {
+        pxComponent->pRestartTimer->stop();
+        pxComponent->bRestartPending = false;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vNoteActivity( QProcess * pProcess )
+{
+    xSupervisedComponent_t * pxComponent = m_hashComponents.value( pProcess, nullptr );
+
+    if ( nullptr != pxComponent )
+    {
+        pxComponent->LastActivity.start();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentSupervisor::bIsStale( ControlEngine::eHUDViewComponentID_t eID ) const
+{
+    bool bReturn = false;
+
+    for ( const xSupervisedComponent_t * pxComponent : m_hashComponents )
+    {
+        if ( eID != pxComponent->eID )
+        {
+            continue;
+        }
+
+        /* Whatever the component last reported is stale once it is down or has been silent for too long. */
+        if ( pxComponent->bRestartPending || ( QProcess::Running != pxComponent->pProcess->state() ) )
+        {
+            bReturn = true;
+        }
+        else if ( ( 0 < pxComponent->iStallTimeoutMs ) && pxComponent->LastActivity.isValid()
+                  && ( pxComponent->iStallTimeoutMs < pxComponent->LastActivity.elapsed() ) )
+        {
+            bReturn = true;
+        }
+
+        break;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ComponentSupervisor::bIsRestartPending( QProcess * pProcess ) const
+{
+    xSupervisedComponent_t * pxComponent = m_hashComponents.value( pProcess, nullptr );
+
+    return ( nullptr != pxComponent ) && pxComponent->bRestartPending;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vReportStatistics() const
+{
+    for ( const xSupervisedComponent_t * pxComponent : m_hashComponents )
+    {
+        if ( ( 0 == pxComponent->ulRestarts ) && ( 0 == pxComponent->ulStalls ) )
+        {
+            continue;
+        }
+
+        qDebug() << "   " << ControlEngine::sEnumValueToComponentName( pxComponent->eID ) << ":"
+                 << pxComponent->ulRestarts << "restarts," << pxComponent->ulStalls << "stalls,"
+                 << pxComponent->llMaximumRestartNanoseconds / 1e6 << "ms max restart latency";
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int ComponentSupervisor::iGetStallTimeoutMs( ControlEngine::eHUDViewComponentID_t eID )
+{
+    int iReturn = 0;
+
+    /* Allow a few missed output periods; event-driven components such as the buttons are never silent by fault. */
+    switch ( eID )
+    {
+    case ControlEngine::eHUDViewComponentID_Accelerometer:
+        /* Samples every 50 ms, or every 500 ms in rides recorded before the motion estimator needed 20 Hz. */
+        iReturn = 2000;
+        break;
+
+    case ControlEngine::eHUDViewComponentID_GPS:
+        /* NMEA sentences arrive every second, with or without a fix. */
+        iReturn = 3000;
+        break;
+
+    case ControlEngine::eHUDViewComponentID_LightSensor:
+        /* Samples every 10 s. */
+        iReturn = 30000;
+        break;
+
+    default:
+        /* No stall detection. */
+        break;
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vHandleStarted()
+{
+    xSupervisedComponent_t * pxComponent = pxGetComponent( QObject::sender() );
+
+    if ( nullptr == pxComponent )
+    {
+        return;
+    }
+
+    pxComponent->Uptime.start();
+    pxComponent->LastActivity.start();
+
+    if ( pxComponent->bRestartPending )
+    {
+        pxComponent->bRestartPending = false;
+        pxComponent->ulRestarts++;
+        pxComponent->llLastRestartNanoseconds = pxComponent->Failure.nsecsElapsed();
+
+        if ( pxComponent->llLastRestartNanoseconds > pxComponent->llMaximumRestartNanoseconds )
+        {
+            pxComponent->llMaximumRestartNanoseconds = pxComponent->llLastRestartNanoseconds;
+        }
+
+        qDebug() << "Restarted component: " << ControlEngine::sEnumValueToComponentName( pxComponent->eID ) << "after"
+                 << pxComponent->llLastRestartNanoseconds / 1e6 << "ms, restart" << pxComponent->ulRestarts;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vHandleFinished( int iExitCode, QProcess::ExitStatus eExitStatus )
+{
+    xSupervisedComponent_t * pxComponent = pxGetComponent( QObject::sender() );
+    QString sReason = "";
+
+    if ( !m_bRunning || ( nullptr == pxComponent ) )
+    {
+        return;
+    }
+
+    if ( pxComponent->bKilledForStall )
+    {
+        /* The failure was timed from the moment the stall was detected. */
+        pxComponent->bKilledForStall = false;
+        vHandleFailure( *pxComponent, "stalled" );
+    }
+    else if ( ( QProcess::NormalExit == eExitStatus ) && !m_bRestartAfterExit )
+    {
+        /* A replay stand-in exits once its trace has played out; only crashes are worth restarting. */
+        emit componentStopped();
+    }
+    else
+    {
+        pxComponent->Failure.start();
+        sReason = ( QProcess::CrashExit == eExitStatus ) ? QString( "crashed" )
+                                                         : QString( "exited with code %1" ).arg( iExitCode );
+        vHandleFailure( *pxComponent, sReason.toLatin1().constData() );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vHandleError( QProcess::ProcessError eError )
+{
+    xSupervisedComponent_t * pxComponent = pxGetComponent( QObject::sender() );
+
+    /* Every other error is followed by finished(); a process that never started will not report finishing. */
+    if ( !m_bRunning || ( nullptr == pxComponent ) || ( QProcess::FailedToStart != eError ) )
+    {
+        return;
+    }
+
+    if ( m_bRestartAfterExit )
+    {
+        pxComponent->Failure.start();
+        vHandleFailure( *pxComponent, "failed to start" );
+    }
+    else
+    {
+        pxComponent->bRestartPending = false;
+        emit componentStopped();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vHandleRestartTimeout()
+{
+    xSupervisedComponent_t * pxComponent = pxGetComponent( QObject::sender() );
+
+    if ( m_bRunning && ( nullptr != pxComponent ) && ( QProcess::NotRunning == pxComponent->pProcess->state() ) )
+    {
+        pxComponent->pProcess->start();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vCheckForStalls()
+{
+    if ( !m_bStallDetection )
+    {
+        return;
+    }
+
+    for ( xSupervisedComponent_t * pxComponent : m_hashComponents )
+    {
+        if ( ( 0 >= pxComponent->iStallTimeoutMs ) || pxComponent->bRestartPending || pxComponent->bKilledForStall
+             || ( QProcess::Running != pxComponent->pProcess->state() ) || !pxComponent->LastActivity.isValid() )
+        {
+            continue;
+        }
+
+        /* A wedged component, e.g. blocked in a serial read or a sensor driver loop, is killed and then restarted. */
+        if ( pxComponent->iStallTimeoutMs < pxComponent->LastActivity.elapsed() )
+        {
+            qDebug() << "Component stalled: " << ControlEngine::sEnumValueToComponentName( pxComponent->eID )
+                     << "silent for" << pxComponent->LastActivity.elapsed() << "ms";
+
+            pxComponent->Failure.start();
+            pxComponent->bKilledForStall = true;
+            pxComponent->ulStalls++;
+            pxComponent->pProcess->kill();
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+ComponentSupervisor::xSupervisedComponent_t * ComponentSupervisor::pxGetComponent( QObject * pSender ) const
+{
+    xSupervisedComponent_t * pxReturn = m_hashComponents.value( qobject_cast<QProcess *>( pSender ), nullptr );
+
+    /* Restart timers are not keyed, but there are only a handful of components. */
+    if ( nullptr == pxReturn )
+    {
+        for ( xSupervisedComponent_t * pxComponent : m_hashComponents )
+        {
+            if ( pSender == pxComponent->pRestartTimer )
+            {
+                pxReturn = pxComponent;
+                break;
+            }
+        }
+    }
+
+    return pxReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ComponentSupervisor::vHandleFailure( xSupervisedComponent_t & xComponent, const char * pcReason )
+{
+    int iDelayMs = 0;
+
+    /* A long healthy run clears the failure history, so an occasional fault is always recovered immediately. */
+    if ( xComponent.Uptime.isValid() && ( STABLE_RUN_MS <= xComponent.Uptime.elapsed() ) )
+    {
+        xComponent.iConsecutiveFailures = 0;
+    }
+
+    if ( 0 < xComponent.iConsecutiveFailures )
+    {
+        iDelayMs = RESTART_BACKOFF_INITIAL_MS << qMin( xComponent.iConsecutiveFailures - 1, 16 );
+        iDelayMs = qMin( iDelayMs, RESTART_BACKOFF_MAXIMUM_MS );
+    }
+
+    xComponent.iConsecutiveFailures++;
+    xComponent.bRestartPending = true;
+    xComponent.Uptime.invalidate();
+
+    qDebug() << "Component" << ControlEngine::sEnumValueToComponentName( xComponent.eID ) << pcReason
+             << ", restarting in" << iDelayMs << "ms";
+
+    /* Even an immediate restart goes through the event loop, so the process is fully torn down first. */
+    xComponent.pRestartTimer->start( iDelayMs );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,81 @@
+#ifndef COMPONENTSUPERVISOR_H
+#define COMPONENTSUPERVISOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+
+#include "controlengine.h"
+
+class ComponentSupervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    /* Stalls are looked for this often, which bounds how late a wedged component is noticed past its timeout. */
+    static const int STALL_CHECK_INTERVAL_MS = 100;
+
+    /* The first restart after a failure is immediate; repeated failures back off exponentially up to the maximum. */
+    static const int RESTART_BACKOFF_INITIAL_MS = 100;
+    static const int RESTART_BACKOFF_MAXIMUM_MS = 10000;
+
+    /* A component that ran this long before failing is considered healthy again, so its backoff starts over. */
+    static const int STABLE_RUN_MS = 10000;
+
+    explicit ComponentSupervisor( QObject * pParent = nullptr );
+    ~ComponentSupervisor();
+
+    bool bAddComponent( const ControlEngine::xHUDViewComponent_t & xComponent );
+    void vSetRestartAfterExit( bool bRestart );
+    void vSetStallDetection( bool bEnabled );
+    void vStart();
+    void vStop();
+
+    void vNoteActivity( QProcess * pProcess );
+    bool bIsStale( ControlEngine::eHUDViewComponentID_t eID ) const;
+    bool bIsRestartPending( QProcess * pProcess ) const;
+    void vReportStatistics() const;
+
+    static int iGetStallTimeoutMs( ControlEngine::eHUDViewComponentID_t eID );
+
+signals:
+    void componentStopped();
+
+private slots:
+    void vHandleStarted();
+    void vHandleFinished( int iExitCode, QProcess::ExitStatus eExitStatus );
+    void vHandleError( QProcess::ProcessError eError );
+    void vHandleRestartTimeout();
+    void vCheckForStalls();
+
+private:
+    struct xSupervisedComponent_t {
+        ControlEngine::eHUDViewComponentID_t eID;
+        QProcess * pProcess;
+        QTimer * pRestartTimer;
+        int iStallTimeoutMs;
+        QElapsedTimer LastActivity;
+        QElapsedTimer Uptime;
+        QElapsedTimer Failure;
+        int iConsecutiveFailures;
+        bool bRestartPending;
+        bool bKilledForStall;
+        unsigned long ulRestarts;
+        unsigned long ulStalls;
+        qint64 llLastRestartNanoseconds;
+        qint64 llMaximumRestartNanoseconds;
+    };
+
+    QHash<QProcess *, xSupervisedComponent_t *> m_hashComponents;
+    QTimer m_StallTimer;
+    bool m_bRestartAfterExit;
+    bool m_bStallDetection;
+    bool m_bRunning;
+
+    xSupervisedComponent_t * pxGetComponent( QObject * pSender ) const;
+    void vHandleFailure( xSupervisedComponent_t & xComponent, const char * pcReason );
+};
+
+#endif // COMPONENTSUPERVISOR_H
@@ -1,14 +1,21 @@
+#include <errno.h>
 #include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QRegularExpression>
 #include <QTime>
 
-#include <ssd1306.h>
-
+#include "componenthandler.h"
+#include "componentsupervisor.h"
 #include "controlengine.h"
-#include "ubuntumono.h"
+#include "hudlayout.h"
+#include "latencytracer.h"
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 static void vSignalHandler( int iSignal );
@@ -17,7 +24,44 @@ static void vSignalHandler( int iSignal );
 ControlEngine::ControlEngine( QObject * pParent ) : QObject( pParent )
 {
     m_sConfigPath = "";
+    m_sRecordDirectory = "";
+    m_sFlightRecorderPath = DEFAULT_FLIGHT_RECORDER_PATH;
+    m_sRideLogDirectory = DEFAULT_RIDE_LOG_DIRECTORY;
+    m_sDashcamDirectory = DEFAULT_DASHCAM_DIRECTORY;
+    m_sLatencyTracePath = "";
+    m_bExitWhenFinished = false;
+    m_xSchedulingOptions = ComponentProcess::xDefaultSchedulingOptions();
+    m_pDisplayBackend = nullptr;
+    m_pSupervisor = new ComponentSupervisor( this );
+    m_pTracer = new LatencyTracer();
+    memset( m_axComponentStatistics, 0, sizeof( m_axComponentStatistics ) );
+    memset( m_apxMetrics, 0, sizeof( m_apxMetrics ) );
+    m_xDataModel = xHUDViewDataModel_t();
     m_eDisplayMode = eControlDisplayMode_Time;
+    m_ePreviousDisplayMode = eControlDisplayMode_Time;
+    m_iModeSlidePixels = 0;
+    m_bShowingSplash = false;
+    m_bBootReported = false;
+    m_iFixedFrameRate = 0;
+    m_eCameraPixelFormat = DisplayBackend::ePixelFormat_RGB565;
+    m_bCameraDither = false;
+    m_ullLastVisionNanoseconds = 0;
+    m_ullLastCameraNanoseconds = 0;
+    vHUDViewFrameRateInit( &m_xFrameRate );
+    m_xBootTimeline.llDisplayReady = -1;
+    m_xBootTimeline.llSplashShown = -1;
+    m_xBootTimeline.llFirstHUDFrame = -1;
+
+    for ( int iComponent = eHUDViewComponentIDMin; eHUDViewComponentIDMax > iComponent; iComponent++ )
+    {
+        m_xBootTimeline.allComponentStarted[ iComponent ] = -1;
+        m_xBootTimeline.allComponentReady[ iComponent ] = -1;
+    }
+
+    /* Publish fused speed and heading at a steady rate, however irregularly the sensors deliver. */
+    m_MotionTimer.setInterval( MotionEstimator::UPDATE_INTERVAL_MS );
+    m_MotionTimer.setSingleShot( false );
+    connect( &m_MotionTimer, SIGNAL( timeout() ), this, SLOT( vUpdateMotion() ) );
 
     /* Set up the refresh timer for the display. */
     m_DisplayRefreshTimer.setInterval( 500 );
@@ -28,6 +72,29 @@ ControlEngine::ControlEngine( QObject * pParent ) : QObject( pParent )
     m_ModeSwitchTimer.setSingleShot( false );
     connect( &m_ModeSwitchTimer, SIGNAL( timeout() ), this, SLOT( vChangeMode() ) );
 
+    m_ModeSlideTimer.setInterval( MODE_SLIDE_INTERVAL_MS );
+    m_ModeSlideTimer.setSingleShot( false );
+    connect( &m_ModeSlideTimer, SIGNAL( timeout() ), this, SLOT( vSlideMode() ) );
+
+    m_StatisticsTimer.setInterval( 10000 );
+    m_StatisticsTimer.setSingleShot( false );
+    connect( &m_StatisticsTimer, SIGNAL( timeout() ), this, SLOT( vReportStatistics() ) );
+
+    /* The splash gives way to the HUD once a component is ready, or after a bounded wait regardless. */
+    m_SplashTimer.setInterval( BOOT_SPLASH_MAXIMUM_MS );
+    m_SplashTimer.setSingleShot( true );
+    connect( &m_SplashTimer, SIGNAL( timeout() ), this, SLOT( vShowHUD() ) );
+
+    m_BootReportTimer.setInterval( BOOT_REPORT_TIMEOUT_MS );
+    m_BootReportTimer.setSingleShot( true );
+    connect( &m_BootReportTimer, SIGNAL( timeout() ), this, SLOT( vReportBootTimeline() ) );
+
+    /* Components the supervisor does not restart count towards the end of a replay. */
+    connect( m_pSupervisor, SIGNAL( componentStopped() ), this, SLOT( vHandleProcessFinished() ) );
+
+    /* Composite camera frames beneath the HUD as they arrive. */
+    connect( &m_CameraFeed, SIGNAL( frameReady() ), this, SLOT( vHandleCameraFrame() ) );
+
     /* Install the Ctrl-C handler. */
     signal( SIGINT, vSignalHandler );
 }
@@ -35,7 +102,9 @@ ControlEngine::ControlEngine( QObject * pParent ) : QObject( pParent )
 
 ControlEngine::~ControlEngine()
 {
-    /* Kill any running processes. */
+    /* Kill any running processes, without the supervisor bringing them back. */
+    m_pSupervisor->vStop();
+
     for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
     {
         qDebug() << "Terminating process for component: " << sEnumValueToComponentName( xComponent.eID );
@@ -43,6 +112,10 @@ ControlEngine::~ControlEngine()
         xComponent.pProcess->waitForFinished();
         delete xComponent.pProcess;
     }
+
+    qDeleteAll( m_hashComponentHandlers );
+    delete m_pTracer;
+    delete m_pDisplayBackend;
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
@@ -51,34 +124,71 @@ int ControlEngine::iRun( QCoreApplication * pApp )
     QString sConfigFile = m_sConfigPath.isEmpty() ? DEFAULT_CONFIG_FILE_PATH : m_sConfigPath;
     int iReturn = 0;
 
+    m_BootTimer.start();
+
     /* Populate the list of registered components. */
     if ( bParseConfig( sConfigFile ) )
     {
         qDebug() << "Loaded config file: " << sConfigFile;
 
-        /* Start the registered component processes. */
-        for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
+        /* Start capturing component output if a ride is being recorded. A ride that cannot be recorded starts nothing,
+         * so it neither runs unrecorded nor displaces the last flight recording. */
+        if ( !m_sRecordDirectory.isEmpty() )
         {
-            xComponent.pProcess->start();
-
-            if ( xComponent.pProcess->waitForStarted( PROCESS_START_WAIT_TIMEOUT_MS ) )
+            if ( m_Recorder.bOpen( m_sRecordDirectory ) )
             {
-                qDebug() << "Started process for component: " << sEnumValueToComponentName( xComponent.eID );
+                qDebug() << "Recording ride to: " << m_sRecordDirectory;
             }
             else
             {
-                qDebug() << "Failed to start process for component: " << sEnumValueToComponentName( xComponent.eID );
+                qDebug() << "Failed to record ride to: " << m_sRecordDirectory;
                 iReturn = -1;
             }
         }
 
-        /* Initialize the display. */
-        vDisplayInit();
-
-        /* Execute the application loop. */
         if ( 0 == iReturn )
         {
+            /* Pin and prioritise the render loop before anything else competes with it. */
+            vSchedulingInit();
+
+            /* Bring the display up first, so the rider sees a splash rather than a blank panel while components
+             * boot. */
+            vDisplayInit();
+
+            /* The metrics page must exist before the components start so they can attach to it. */
+            vMetricsInit();
+
+            m_RunTimer.start();
+
+            /* Replay stand-ins exit at the end of their trace and may pause for as long as the recording did. */
+            m_pSupervisor->vSetRestartAfterExit( !m_bExitWhenFinished );
+            m_pSupervisor->vSetStallDetection( !m_bExitWhenFinished );
+            m_pSupervisor->vStart();
+
+            /* Launch every component at once; each is ready when its first valid sample arrives, not when it starts. */
+            for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
+            {
+                xComponent.pProcess->start();
+            }
+
+            m_BootReportTimer.start();
+
+            /* Preallocating the recordings overlaps with the components booting; no sample is handled before exec(). */
+            vFlightRecorderInit();
+            vRideLogInit();
+            vDashcamInit();
+            vMotionInit();
+            vLatencyTracerInit();
+
+            /* Execute the application loop. */
             iReturn = pApp->exec();
+            vReportRunStatistics();
+
+            /* Index the ride log and close the dashcam segment as soon as the loop ends, before the slower component
+             * teardown. */
+            m_RideLog.vClose();
+            m_Dashcam.vClose();
+            m_pTracer->vClose();
         }
     }
     else
@@ -100,9 +210,113 @@ void ControlEngine::vSetConfigFile( const QString & sPath )
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
+void ControlEngine::vSetRecordDirectory( const QString & sDirectory )
+{
+    m_sRecordDirectory = sDirectory;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vSetFlightRecorderPath( const QString & sPath )
+{
+    m_sFlightRecorderPath = sPath;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vSetRideLogDirectory( const QString & sDirectory )
+{
+    m_sRideLogDirectory = sDirectory;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vSetDashcamDirectory( const QString & sDirectory )
+{
+    m_sDashcamDirectory = sDirectory;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vSetLatencyTracePath( const QString & sPath )
+{
+    m_sLatencyTracePath = sPath;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vSetExitWhenFinished( bool bExit )
+{
+    m_bExitWhenFinished = bExit;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ControlEngine::bSetDisplayBackend( const QString & sSpecification )
+{
+    DisplayBackend * pBackend = DisplayBackend::pCreate( sSpecification.toStdString() );
+    bool bReturn = false;
+
+    /* Only replace the current backend once the new specification is known to be usable. */
+    if ( nullptr != pBackend )
+    {
+        delete m_pDisplayBackend;
+        m_pDisplayBackend = pBackend;
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ControlEngine::bSetCameraTransform( const QString & sSpecification )
+{
+    return m_CameraFeed.bSetTransform( sSpecification );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ControlEngine::bSetCameraFrameRate( const QString & sSpecification )
+{
+    bool bValid = false;
+    int iFramesPerSecond = sSpecification.toInt( &bValid );
+
+    if ( "auto" == sSpecification )
+    {
+        m_iFixedFrameRate = 0;
+        return true;
+    }
+
+    if ( !bValid || ( 0 >= iFramesPerSecond ) || ( HUDVIEW_FRAMERATE_MAXIMUM_FPS < iFramesPerSecond ) )
+    {
+        return false;
+    }
+
+    m_iFixedFrameRate = iFramesPerSecond;
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ControlEngine::bSetCameraPixelFormat( const QString & sSpecification )
+{
+    bool bReturn = true;
+
+    if ( "rgb565" == sSpecification )
+    {
+        m_eCameraPixelFormat = DisplayBackend::ePixelFormat_RGB565;
+        m_bCameraDither = false;
+    }
+    else if ( ( "rgb444" == sSpecification ) || ( "rgb444:dither" == sSpecification ) )
+    {
+        m_eCameraPixelFormat = DisplayBackend::ePixelFormat_RGB444;
+        m_bCameraDither = ( "rgb444:dither" == sSpecification );
+    }
+    else
+    {
+        bReturn = false;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
 bool ControlEngine::bIsValidComponent( const xHUDViewComponent_t & xComponent )
 {
-    return ( eHUDViewComponentID_Unknown == xComponent.eID ) || ( nullptr == xComponent.pProcess );
+    return ( eHUDViewComponentID_Unknown != xComponent.eID ) && ( nullptr != xComponent.pProcess );
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
@@ -174,7 +388,7 @@ ControlEngine::eHUDViewComponentID_t ControlEngine::eComponentProgramToEnumValue
 {
     eHUDViewComponentID_t eReturn = eHUDViewComponentID_Unknown;
 
-    for ( xHUDViewComponent_t xComponent : m_lstRegisteredComponents )
+    for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
     {
         if ( 0 == QString::compare( xComponent.pProcess->program(), sProgram ) )
         {
@@ -187,111 +401,197 @@ ControlEngine::eHUDViewComponentID_t ControlEngine::eComponentProgramToEnumValue
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
-void ControlEngine::vHandleData()
+ComponentHandler * ControlEngine::pGetComponentHandler( QProcess * pProcess ) const
 {
-    QObject *pSender = QObject::sender();
-    QProcess *pCaller = nullptr;
+    return m_hashComponentHandlers.value( pProcess, nullptr );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const QList<ControlEngine::xHUDViewComponent_t> & ControlEngine::lstGetRegisteredComponents() const
+{
+    return m_lstRegisteredComponents;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
 
-    if ( nullptr != pSender )
+void ControlEngine::vHandleData()
+{
+    QProcess *pCaller = qobject_cast<QProcess *>( QObject::sender() );
+    ComponentHandler *pHandler = nullptr;
+    QElapsedTimer HandleTimer;
+    QByteArray Data;
+    unsigned long ulRecordsFramed = 0;
+    unsigned long ulRecordsParsed = 0;
+    unsigned long ulButtonPresses = m_xDataModel.ulButtonPresses;
+    unsigned long ulLongPresses = m_xDataModel.ulButtonLongPresses;
+    unsigned long ulDoublePresses = m_xDataModel.ulButtonDoublePresses;
+    xHUDViewMetricsComponent_t * pxMetrics = nullptr;
+    uint64_t ullArrival = ullHUDViewMetricsNow();
+    uint64_t ullLastWrite = 0;
+
+    /* Ensure the caller is supported. */
+    if ( nullptr != pCaller )
     {
-        pCaller = qobject_cast<QProcess *>( pSender );
+        pHandler = pGetComponentHandler( pCaller );
 
-        /* Ensure the caller is supported. */
-        if ( nullptr != pCaller )
+        if ( nullptr != pHandler )
         {
-            /* Act on the corresponding component. */
-            switch ( eComponentProgramToEnumValue( pCaller->program() ) )
-            {
-            case eHUDViewComponentID_Accelerometer:
-            {
-                QStringList lstData = QString( pCaller->readAll() ).trimmed().split( ',' );
-                qDebug() << "Accelerometer:" << lstData;
+            HandleTimer.start();
+            pxMetrics = m_apxMetrics[ pHandler->eGetID() ];
 
-                /* Update the data model. */
-                m_xAccelerometerData.dX = lstData.at( 0 ).toDouble();
-                m_xAccelerometerData.dX = lstData.at( 1 ).toDouble();
-                m_xAccelerometerData.dX = lstData.at( 2 ).toDouble();
+            /* Components stamp each write, so the time the newest record spent in the pipe is known. */
+            if ( nullptr != pxMetrics )
+            {
+                ullLastWrite = __atomic_load_n( &pxMetrics->ullLastWriteNanoseconds, __ATOMIC_ACQUIRE );
 
-                break;
+                if ( ( 0 != ullLastWrite ) && ( ullArrival >= ullLastWrite ) )
+                {
+                    vHUDViewMetricsRecord( pxMetrics, eHUDViewMetricsStage_PipeToHandler, ullArrival - ullLastWrite );
+                }
             }
 
-            case eHUDViewComponentID_GPS:
+            Data = pCaller->readAll();
+
+            /* Any output at all shows the component is alive, even if none of it parses. */
+            m_pSupervisor->vNoteActivity( pCaller );
+
+            /* Keep a timestamped copy of the raw output when recording a ride. */
+            if ( m_Recorder.bIsOpen() )
             {
-                /* Parse out the individual pieces of data. */
-                QRegularExpression Regex( "GPRMC,([\\d\\.\\d]+),([A|V]),([\\d\\.\\d]+),N,([\\d\\.\\d]+),W,([\\d\\.\\d]+),([\\d\\.\\d]+),([\\d]+),,,A" );
-                QRegularExpressionMatch Matches = Regex.match( pCaller->readAll() );
+                m_Recorder.vRecord( sEnumValueToComponentName( pHandler->eGetID() ), Data );
+            }
 
-                if ( Matches.hasMatch() )
-                {
-                    qDebug() << "GPS:";
-                    qDebug() << "    Time: " << Matches.captured( 1 );
-                    qDebug() << "    Valid: " << Matches.captured( 2 );
-                    qDebug() << "    Latitude: " << Matches.captured( 3 );
-                    qDebug() << "    Longitude: " << Matches.captured( 4 );
-                    qDebug() << "    Speed: " << Matches.captured( 5 );
-                    qDebug() << "    Direction: " << Matches.captured( 6 );
-                    qDebug() << "    Date: " << Matches.captured( 7 );
-
-                    /* Update the data model. */
-                    m_xGPSData.bHasFix = true;
-                    m_xGPSData.dLatitude = Matches.captured( 3 ).toDouble();
-                    m_xGPSData.dLongitude = Matches.captured( 4 ).toDouble();
-                    m_xGPSData.dSpeed = Matches.captured( 5 ).toDouble();
-                    m_xGPSData.dDirection = Matches.captured( 6 ).toDouble();
-                }
-                else
-                {
-                    qDebug() << "GPS: No fix!";
-                    m_xGPSData.bHasFix = false;
-                }
+            /* Let the component's handler frame and parse the data into the data model. */
+            ulRecordsFramed = pHandler->ulGetRecordsFramed();
+            ulRecordsParsed = pHandler->ulHandleData( Data, m_xDataModel, ullArrival );
+            ulRecordsFramed = pHandler->ulGetRecordsFramed() - ulRecordsFramed;
 
-                break;
+            /* Handlebar button presses take over from the automatic mode rotation. */
+            if ( ulButtonPresses != m_xDataModel.ulButtonPresses )
+            {
+                vHandleButtonPresses( ulButtonPresses, ulLongPresses, ulDoublePresses );
             }
 
-            case eHUDViewComponentID_HandlebarButtons:
-                /* Filter out spurious input. */
-#if 0
-                if ( "0\n" == pCaller->readAll() )
-                {
-                    /* Update the display mode. */
-                    if ( eControlDisplayMode_Time == m_eDisplayMode )
-                    {
-                        m_eDisplayMode = eControlDisplayMode_Speed;
-                    }
-                    else if ( eControlDisplayMode_Speed == m_eDisplayMode )
-                    {
-                        m_eDisplayMode = eControlDisplayMode_Direction;
-                    }
-                    else
-                    {
-                        m_eDisplayMode = eControlDisplayMode_Time;
-                    }
+            /* Records that were framed but did not reach the data model count as dropped. */
+            xComponentStatistics_t & xStatistics = m_axComponentStatistics[ pHandler->eGetID() ];
+            qint64 llNanoseconds = HandleTimer.nsecsElapsed();
 
-                    /* Clear the display and immediately refresh. */
-                    ssd1306_clearScreen8();
-                    vUpdateDisplay();
-                }
-#endif
+            xStatistics.ulRecordsReceived += ulRecordsFramed;
+            xStatistics.ulRecordsParsed += ulRecordsParsed;
+            xStatistics.ullBytesReceived += static_cast<unsigned long long>( Data.size() );
+            xStatistics.llHandleNanoseconds += llNanoseconds;
 
-                break;
+            if ( ( 0 < ulRecordsParsed ) && ( llNanoseconds > xStatistics.llMaximumUpdateNanoseconds ) )
+            {
+                xStatistics.llMaximumUpdateNanoseconds = llNanoseconds;
+            }
 
-            case eHUDViewComponentID_LightSensor:
-                /* Store the value. */
-                m_LightSensorData = pCaller->readAll();
-                qDebug() << "Light Sensor:" << m_LightSensorData;
-                break;
+            if ( ( 0 < ulRecordsParsed ) && ( 0 > m_xBootTimeline.allComponentReady[ pHandler->eGetID() ] ) )
+            {
+                vMarkComponentReady( pHandler->eGetID(), true );
+            }
 
-            default:
-                /* Nothing to do. */
-                qDebug() << "ControlEngine::vHandleData() received data for process: " << pCaller->program();
-                break;
+            vHUDViewMetricsCount( pxMetrics, eHUDViewMetricsCounter_RecordsIn, ulRecordsFramed );
+            vHUDViewMetricsCount( pxMetrics, eHUDViewMetricsCounter_RecordsApplied, ulRecordsParsed );
+            vHUDViewMetricsCount( pxMetrics, eHUDViewMetricsCounter_Bytes, static_cast<uint64_t>( Data.size() ) );
+
+            if ( 0 < ulRecordsParsed )
+            {
+                vHUDViewMetricsRecord( pxMetrics, eHUDViewMetricsStage_ModelUpdate,
+                                       ullHUDViewMetricsNow() - ullArrival );
             }
         }
+        else
+        {
+            /* Nothing to do. */
+            qDebug() << "ControlEngine::vHandleData() received data for process: " << pCaller->program();
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ControlEngine::bParseAccelerometerData( const QByteArray & Data, xAccelerationInformation_t & xInformation )
+{
+    QStringList lstData = QString( Data ).trimmed().split( ',' );
+    bool bReturn = false;
+
+    /* Expect comma-separated X, Y and Z values. */
+    if ( 3 <= lstData.length() )
+    {
+        xInformation.dX = lstData.at( 0 ).toDouble();
+        xInformation.dY = lstData.at( 1 ).toDouble();
+        xInformation.dZ = lstData.at( 2 ).toDouble();
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ControlEngine::bParseGPSData( const QByteArray & Data, xGPSInformation_t & xInformation )
+{
+    /* Parse out the individual pieces of data. */
+    QRegularExpression Regex( "GPRMC,([\\d\\.\\d]+),([A|V]),([\\d\\.\\d]+),N,([\\d\\.\\d]+),W,([\\d\\.\\d]+),([\\d\\.\\d]+),([\\d]+),,,A" );
+    QRegularExpressionMatch Matches = Regex.match( Data );
+
+    if ( Matches.hasMatch() )
+    {
+        xInformation.bHasFix = true;
+        xInformation.dLatitude = Matches.captured( 3 ).toDouble();
+        xInformation.dLongitude = Matches.captured( 4 ).toDouble();
+        xInformation.dSpeed = Matches.captured( 5 ).toDouble();
+        xInformation.dDirection = Matches.captured( 6 ).toDouble();
+    }
+    else
+    {
+        xInformation.bHasFix = false;
     }
+
+    return xInformation.bHasFix;
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 bool ControlEngine::bParseConfig( const QString & sConfigPath )
+{
+    xHUDViewConfig_t xConfig;
+    xHUDViewComponent_t xComponent = { eHUDViewComponentID_Unknown, nullptr };
+    bool bReturn = bParseConfigFile( sConfigPath, xConfig );
+
+    for ( int i = 0; bReturn && ( i < xConfig.lstComponents.length() ); i++ )
+    {
+        const xHUDViewComponentConfig_t & xComponentConfig = xConfig.lstComponents.at( i );
+
+        /* Set up the component process. */
+        xComponent.eID = xComponentConfig.eID;
+        xComponent.pProcess = new ComponentProcess();
+        xComponent.pProcess->setProgram( xComponentConfig.sProgram );
+        xComponent.pProcess->setArguments( xComponentConfig.lstArguments );
+        xComponent.pProcess->setReadChannel( QProcess::StandardOutput );
+        static_cast<ComponentProcess *>( xComponent.pProcess )->vSetSchedulingOptions(
+            xConfig.axSchedulingOptions[ xComponent.eID ] );
+        connect( xComponent.pProcess, SIGNAL( readyReadStandardOutput() ), this, SLOT( vHandleData() ) );
+        connect( xComponent.pProcess, SIGNAL( started() ), this, SLOT( vHandleProcessStarted() ) );
+        connect( xComponent.pProcess, SIGNAL( errorOccurred( QProcess::ProcessError ) ),
+                 this, SLOT( vHandleProcessError( QProcess::ProcessError ) ) );
+
+        /* Attach the component's handler so its output can be dispatched directly. */
+        m_hashComponentHandlers.insert( xComponent.pProcess, ComponentHandler::pCreate( xComponent.eID ) );
+
+        /* Register the component and have it restarted should it crash or stall. */
+        m_lstRegisteredComponents.append( xComponent );
+        m_pSupervisor->bAddComponent( xComponent );
+    }
+
+    /* The control application applies its own options. */
+    if ( bReturn )
+    {
+        m_xSchedulingOptions = xConfig.axSchedulingOptions[ eHUDViewComponentID_Control ];
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool ControlEngine::bParseConfigFile( const QString & sConfigPath, xHUDViewConfig_t & xConfig )
 {
     QFile ConfigFile( sConfigPath );
     QString sContents = "";
@@ -300,10 +600,18 @@ bool ControlEngine::bParseConfig( const QString & sConfigPath )
     QRegularExpressionMatch Match;
     QString sLine = "";
     eHUDViewComponentID_t eComponentID = eHUDViewComponentID_Unknown;
-    QString sComponentProgram = "";
-    xHUDViewComponent_t xComponent = { eHUDViewComponentID_Unknown, nullptr };
+    xHUDViewComponentConfig_t xComponent = { eHUDViewComponentID_Unknown, QString(), QStringList() };
+    bool abHasSchedulingOptions[ eHUDViewComponentIDMax ] = { false };
+    QString sError = "";
     bool bReturn = false;
 
+    xConfig.lstComponents.clear();
+
+    for ( int iComponent = eHUDViewComponentIDMin; eHUDViewComponentIDMax > iComponent; iComponent++ )
+    {
+        xConfig.axSchedulingOptions[ iComponent ] = ComponentProcess::xDefaultSchedulingOptions();
+    }
+
     if ( ConfigFile.open( QIODevice::ReadOnly | QIODevice::Text ) )
     {
         sContents = ConfigFile.readAll();
@@ -315,8 +623,43 @@ bool ControlEngine::bParseConfig( const QString & sConfigPath )
             /* Store each component name and path. */
             for ( int i = 0; i < lstLines.length(); i++ )
             {
-                sLine = lstLines.at( i );
-                Regex.setPattern( "^(\\S+):" );
+                sLine = lstLines.at( i ).trimmed();
+
+                /* Comments and blank lines are allowed so the options can be documented in place. */
+                if ( sLine.isEmpty() || sLine.startsWith( '#' ) )
+                {
+                    continue;
+                }
+
+                /* Scheduling options take the form "Name.option=value" and may come before or after the program. */
+                Regex.setPattern( "^(\\w+)\\.(\\w+)=(\\S+)$" );
+                Match = Regex.match( sLine );
+
+                if ( Match.hasMatch() )
+                {
+                    eComponentID = eComponentNameToEnumValue( Match.captured( 1 ) );
+
+                    if ( eHUDViewComponentID_Unknown == eComponentID )
+                    {
+                        qDebug() << "Got options for unsupported component when parsing config file.";
+                        bReturn = false;
+                        break;
+                    }
+
+                    if ( !ComponentProcess::bParseSchedulingOption( Match.captured( 2 ), Match.captured( 3 ),
+                                                                    xConfig.axSchedulingOptions[ eComponentID ],
+                                                                    sError ) )
+                    {
+                        qDebug() << "Invalid option for component: " << Match.captured( 1 ) << sError;
+                        bReturn = false;
+                        break;
+                    }
+
+                    abHasSchedulingOptions[ eComponentID ] = true;
+                    continue;
+                }
+
+                Regex.setPattern( "^(\\S+?):" );
                 Match = Regex.match( sLine );
 
                 /* Attempt to extract the component parts. */
@@ -337,15 +680,18 @@ bool ControlEngine::bParseConfig( const QString & sConfigPath )
                         break;
                     }
 
-                    Regex.setPattern( ":(\\S+)$" );
+                    /* The program may be followed by arguments, e.g. a replay stand-in and its trace file. */
+                    Regex.setPattern( "^\\S+?:(\\S+)(\\s+.*)?$" );
                     Match = Regex.match( sLine );
 
                     if ( Match.hasMatch() )
                     {
-                        sComponentProgram = Match.captured( 1 );
+                        xComponent.sProgram = Match.captured( 1 );
+                        xComponent.lstArguments = Match.captured( 2 ).split( QRegularExpression( "\\s+" ),
+                                                                             QString::SkipEmptyParts );
 
                         /* Ensure the program is valid. */
-                        if ( !QFile::exists( sComponentProgram ) )
+                        if ( !QFile::exists( xComponent.sProgram ) )
                         {
                             qDebug() << "Specified program path could not be found for component: "
                                      << sEnumValueToComponentName( xComponent.eID );
@@ -353,14 +699,7 @@ bool ControlEngine::bParseConfig( const QString & sConfigPath )
                             break;
                         }
 
-                        /* Set up the component process. */
-                        xComponent.pProcess = new QProcess();
-                        xComponent.pProcess->setProgram( sComponentProgram );
-                        xComponent.pProcess->setReadChannel( QProcess::StandardOutput );
-                        connect( xComponent.pProcess, SIGNAL( readyReadStandardOutput() ), this, SLOT( vHandleData() ) );
-
-                        /* Register the component. */
-                        m_lstRegisteredComponents.append( xComponent );
+                        xConfig.lstComponents.append( xComponent );
                         bReturn = true;
                     }
                     else
@@ -391,6 +730,24 @@ bool ControlEngine::bParseConfig( const QString & sConfigPath )
             /* Empty config file. */
             bReturn = false;
         }
+
+        /* Options are only of use to components that are registered, and to the control application itself. */
+        for ( const xHUDViewComponentConfig_t & xRegistered : xConfig.lstComponents )
+        {
+            abHasSchedulingOptions[ xRegistered.eID ] = false;
+        }
+
+        abHasSchedulingOptions[ eHUDViewComponentID_Control ] = false;
+
+        for ( int iComponent = eHUDViewComponentIDMin; ( eHUDViewComponentIDMax > iComponent ) && bReturn; iComponent++ )
+        {
+            if ( abHasSchedulingOptions[ iComponent ] )
+            {
+                qDebug() << "Got options for unregistered component: "
+                         << sEnumValueToComponentName( static_cast<eHUDViewComponentID_t>( iComponent ) );
+                bReturn = false;
+            }
+        }
     }
     else
     {
@@ -402,97 +759,690 @@ bool ControlEngine::bParseConfig( const QString & sConfigPath )
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
-void ControlEngine::vDisplayInit()
+void ControlEngine::vSchedulingInit()
 {
-    st7735_128x160_spi_init( 22, 1, 23 );
-    ssd1306_setMode( LCD_MODE_NORMAL );
-    st7735_setRotation( 1 );
-    ssd1306_fillScreen8( 0x00 );
-    ssd1306_setFixedFont( UbuntuMono25x34 );
-    ssd1306_clearScreen8();
-    m_DisplayRefreshTimer.start();
-    m_ModeSwitchTimer.start();
-}
-/*--------------------------------------------------------------------------------------------------------------------*/
+    if ( ComponentProcess::bIsDefault( m_xSchedulingOptions ) )
+    {
+        return;
+    }
 
-void ControlEngine::vUpdateDisplay()
-{
-    /* Set the font color depending on the light sensor value. */
-    if ( LIGHT_SENSOR_DARK_THRESHOLD > m_LightSensorData.left( m_LightSensorData.length() - 1 ).toInt() )
+    /* Unlike a component, the control application can lock its own memory directly. */
+    if ( ComponentProcess::bApplySchedulingOptions( m_xSchedulingOptions )
+         && ( !m_xSchedulingOptions.bLockMemory || ( 0 == mlockall( MCL_CURRENT | MCL_FUTURE ) ) ) )
     {
-        /* Red font for nighttime. */
-        ssd1306_setColor( RGB_COLOR8( 255, 0, 0 ) );
+        qDebug() << "Applied scheduling options: " << ComponentProcess::sDescribe( m_xSchedulingOptions );
     }
     else
     {
-        /* White font for daytimne. */
-        ssd1306_setColor( RGB_COLOR8( 255, 255, 255 ) );
+        qDebug() << "Failed to apply scheduling options: " << ComponentProcess::sDescribe( m_xSchedulingOptions )
+                 << strerror( errno );
     }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
 
-    /* Determine what to display. */
-    switch ( m_eDisplayMode )
+void ControlEngine::vDisplayInit()
+{
+    /* Fall back to the platform default if no backend was requested. */
+    if ( nullptr == m_pDisplayBackend )
     {
-    case eControlDisplayMode_Time:
-        ssd1306_printFixed8( 16, 48, QTime::currentTime().toString( "hh:mm" ).toStdString().c_str(), STYLE_NORMAL );
-        break;
+        m_pDisplayBackend = DisplayBackend::pCreate( DisplayBackend::pcGetDefaultSpecification() );
+    }
 
-    case eControlDisplayMode_Speed:
-        /* Only attempt to display something if there is valid data to process. */
-        if ( m_xGPSData.bHasFix )
-        {
-            ssd1306_printFixed8( 16, 48, QString::number( qRound( m_xGPSData.dSpeed * 1.15078 ) )
-                                 .toStdString().c_str(), STYLE_NORMAL );
-        }
-        else
+    if ( m_Compositor.bInit( m_pDisplayBackend ) )
+    {
+        qDebug() << "Initialized display backend: " << m_pDisplayBackend->pcGetName();
+
+        if ( 0 < m_pDisplayBackend->ulGetClockHz() )
         {
-            ssd1306_printFixed8( 16, 48, "---", STYLE_NORMAL );
+            qDebug() << "Display SPI clock:" << m_pDisplayBackend->ulGetClockHz() / 1e6 << "MHz";
         }
 
-        break;
-
-    case eControlDisplayMode_Direction:
-        /* Only attempt to display something if there is valid data to process. */
-        if ( m_xGPSData.bHasFix )
+        /* A backend that cannot switch the panel's pixel format keeps the camera in RGB565. */
+        if ( !m_Compositor.bSetCameraPixelFormat( m_eCameraPixelFormat, m_bCameraDither ) )
         {
-            ssd1306_printFixed8( 16, 48, sGPSDirectionToString( m_xGPSData.dDirection ).toStdString().c_str(),
-                                 STYLE_NORMAL );
+            qDebug() << "Display backend does not take" << DisplayBackend::pcGetPixelFormatName( m_eCameraPixelFormat )
+                     << "pixels, pushing the camera as RGB565.";
         }
-        else
+        else if ( DisplayBackend::ePixelFormat_RGB565 != m_eCameraPixelFormat )
         {
-            ssd1306_printFixed8( 16, 48, "-- ", STYLE_NORMAL );
+            qDebug() << "Pushing the camera as" << DisplayBackend::pcGetPixelFormatName( m_eCameraPixelFormat )
+                     << ( m_bCameraDither ? "with ordered dithering" : "without dithering" );
         }
+    }
+    else
+    {
+        qDebug() << "Failed to initialize display backend.";
+    }
 
-        break;
+    m_xBootTimeline.llDisplayReady = m_BootTimer.nsecsElapsed();
+    vShowSplash();
 
-    default:
-        /* Nothing to do. */
-        break;
+    /* The camera feed is optional; without it the HUD is composited over black. */
+    if ( !m_CameraFeed.bOpen( m_CameraFeed.DEFAULT_FIFO_PATH ) )
+    {
+        qDebug() << "Camera feed unavailable, continuing without it.";
     }
+
+    /* A fixed rate is asked for once; an adaptive one starts at the default and moves from the first frame. */
+    m_CameraFeed.vSetFrameRate( ( 0 < m_iFixedFrameRate ) ? m_iFixedFrameRate : m_xFrameRate.iRate );
+
+    m_SplashTimer.start();
+    m_StatisticsTimer.start();
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
-void ControlEngine::vChangeMode()
+void ControlEngine::vShowSplash()
 {
-    /* Update the display mode. */
-    if ( eControlDisplayMode_Time == m_eDisplayMode )
+    m_bShowingSplash = true;
+    m_Compositor.vClearOverlay();
+    HUDLayout::vDrawSplash( m_Compositor );
+    vComposeDisplay();
+
+    m_xBootTimeline.llSplashShown = m_BootTimer.nsecsElapsed();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vShowHUD()
+{
+    if ( !m_bShowingSplash )
+    {
+        return;
+    }
+
+    /* Replace the splash with the HUD straight away instead of waiting for the next refresh. */
+    m_bShowingSplash = false;
+    m_SplashTimer.stop();
+    m_Compositor.vClearOverlay();
+    vUpdateDisplay();
+    m_DisplayRefreshTimer.start();
+    m_ModeSwitchTimer.start();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vUpdateMotion()
+{
+    m_xDataModel.xMotion = m_MotionEstimator.xUpdate();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vHandleButtonPresses( unsigned long ulPresses, unsigned long ulLongPresses,
+                                          unsigned long ulDoublePresses )
+{
+    unsigned long ulLong = m_xDataModel.ulButtonLongPresses - ulLongPresses;
+    unsigned long ulDouble = m_xDataModel.ulButtonDoublePresses - ulDoublePresses;
+    unsigned long ulShort = m_xDataModel.ulButtonPresses - ulPresses - ulLong - ulDouble;
+
+    /* Once the rider has pressed the button, the mode only changes when they ask. */
+    m_ModeSwitchTimer.stop();
+
+    /* A short press moves on to the next mode and a double press back to the last; a long press keeps the dashcam's
+     * last stretch as an event, as an impact would. */
+    if ( 0 < ulShort )
+    {
+        vChangeMode();
+    }
+
+    if ( 0 < ulDouble )
     {
-        m_eDisplayMode = eControlDisplayMode_Speed;
+        vChangeModeBack();
+    }
+
+    if ( 0 < ulLong )
+    {
+        m_Dashcam.vKeepEvent();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vUpdateDisplay()
+{
+    uint8_t ucIntensity = 255;
+    QString sText = "";
+    int iX = HUDLayout::READING_X;
+    unsigned long ulFrames = m_Compositor.ulGetFramesPushed();
+    uint64_t ullRenderStart = ullHUDViewMetricsNow();
+
+    /* Leave the splash up until the HUD takes over. */
+    if ( m_bShowingSplash )
+    {
+        return;
+    }
+
+    /* Redraw the overlay; the compositor only pushes the columns whose content actually changed. */
+    m_Compositor.vClearOverlay();
+
+    /* Mid-slide, the last mode's reading goes out to the left as this one comes in from the right, both as far along
+     * as the panel has scrolled. */
+    if ( 0 < m_iModeSlidePixels )
+    {
+        sText = sDisplayText( m_ePreviousDisplayMode, ucIntensity );
+        HUDLayout::vDrawReading( m_Compositor, iX - m_iModeSlidePixels, sText.toStdString().c_str(),
+                                 usDisplayColor( ucIntensity ) );
+        iX += DisplayCompositor::DISPLAY_WIDTH - m_iModeSlidePixels;
+    }
+
+    sText = sDisplayText( m_eDisplayMode, ucIntensity );
+    HUDLayout::vDrawReading( m_Compositor, iX, sText.toStdString().c_str(), usDisplayColor( ucIntensity ) );
+
+    if ( m_ApproachDetector.bIsAlerting() )
+    {
+        HUDLayout::vDrawRearAlert( m_Compositor );
+    }
+
+    vComposeDisplay();
+
+    /* Every record applied so far went into this overlay, and is on the panel if the frame went out. */
+    m_pTracer->vNoteRendered( ullRenderStart, ullHUDViewMetricsNow(), ulFrames != m_Compositor.ulGetFramesPushed() );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vChangeMode()
+{
+    /* Update the display mode. */
+    if ( eControlDisplayMode_Time == m_eDisplayMode )
+    {
+        vSelectMode( eControlDisplayMode_Speed );
     }
     else if ( eControlDisplayMode_Speed == m_eDisplayMode )
     {
-        m_eDisplayMode = eControlDisplayMode_Direction;
+        vSelectMode( eControlDisplayMode_Direction );
+    }
+    else
+    {
+        vSelectMode( eControlDisplayMode_Time );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vChangeModeBack()
+{
+    if ( eControlDisplayMode_Time == m_eDisplayMode )
+    {
+        vSelectMode( eControlDisplayMode_Direction );
+    }
+    else if ( eControlDisplayMode_Speed == m_eDisplayMode )
+    {
+        vSelectMode( eControlDisplayMode_Time );
+    }
+    else
+    {
+        vSelectMode( eControlDisplayMode_Speed );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vSelectMode( eControlDisplayMode_t eMode )
+{
+    m_ePreviousDisplayMode = m_eDisplayMode;
+    m_eDisplayMode = eMode;
+
+    /* Slide the new reading in by scrolling the panel, which only leaves the columns it exposes to push; over a live
+     * camera or an alert, whose pixels would all have to be pushed again at every step, change at once. Nothing
+     * changes while the splash is still up. */
+    if ( m_bShowingSplash )
+    {
+        /* Nothing to do. */
+    }
+    else if ( m_Compositor.bCanScroll() && !m_ApproachDetector.bIsAlerting()
+              && ( MODE_SLIDE_CAMERA_IDLE_NS < ullHUDViewMetricsNow() - m_ullLastCameraNanoseconds ) )
+    {
+        m_iModeSlidePixels = 0;
+        m_ModeSlideTimer.start();
+        vSlideMode();
     }
     else
     {
-        m_eDisplayMode = eControlDisplayMode_Time;
+        m_iModeSlidePixels = 0;
+        m_ModeSlideTimer.stop();
+        vUpdateDisplay();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vSlideMode()
+{
+    m_iModeSlidePixels += MODE_SLIDE_STEP_PIXELS;
+    m_Compositor.vScroll( MODE_SLIDE_STEP_PIXELS );
+
+    /* A whole panel width on, the scroll has come full circle and the reading is back where it always is. */
+    if ( DisplayCompositor::DISPLAY_WIDTH <= m_iModeSlidePixels )
+    {
+        m_iModeSlidePixels = 0;
+        m_ModeSlideTimer.stop();
     }
 
-    /* Clear the display and immediately refresh. */
-    ssd1306_clearScreen8();
     vUpdateDisplay();
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
+QString ControlEngine::sDisplayText( eControlDisplayMode_t eMode, uint8_t & ucIntensity ) const
+{
+    const MotionEstimator::xEstimate_t & xMotion = m_xDataModel.xMotion;
+    bool bGPSStale = m_pSupervisor->bIsStale( eHUDViewComponentID_GPS );
+    QString sText = "";
+
+    ucIntensity = 255;
+
+    /* Determine what to display. */
+    switch ( eMode )
+    {
+    case eControlDisplayMode_Time:
+        sText = QTime::currentTime().toString( "hh:mm" );
+        break;
+
+    case eControlDisplayMode_Speed:
+        /* The fused speed carries on through a GPS dropout for as long as it stays trustworthy. */
+        if ( xMotion.bValid )
+        {
+            sText = QString::number( qRound( xMotion.dSpeed * 1.15078 ) );
+        }
+        else if ( m_xDataModel.xGPS.bHasFix )
+        {
+            sText = QString::number( qRound( m_xDataModel.xGPS.dSpeed * 1.15078 ) );
+
+            /* A frozen speed must not pass for a live one while the GPS is down or silent. */
+            if ( bGPSStale )
+            {
+                sText += "?";
+                ucIntensity = 128;
+            }
+        }
+        else
+        {
+            sText = "---";
+        }
+
+        break;
+
+    case eControlDisplayMode_Direction:
+        if ( xMotion.bHeadingValid )
+        {
+            sText = sGPSDirectionToString( xMotion.dDirection );
+        }
+        else if ( m_xDataModel.xGPS.bHasFix )
+        {
+            sText = sGPSDirectionToString( m_xDataModel.xGPS.dDirection );
+
+            if ( bGPSStale )
+            {
+                sText = sText.trimmed() + "?";
+                ucIntensity = 128;
+            }
+        }
+        else
+        {
+            sText = "-- ";
+        }
+
+        break;
+
+    default:
+        /* Nothing to do. */
+        break;
+    }
+
+    return sText;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint16_t ControlEngine::usDisplayColor( uint8_t ucIntensity ) const
+{
+    uint16_t usColor = 0;
+
+    /* Set the font color depending on the light sensor value, dimmed for stale data. */
+    if ( LIGHT_SENSOR_DARK_THRESHOLD > m_xDataModel.lLightSensorLux )
+    {
+        /* Red font for nighttime. */
+        usColor = DisplayCompositor::usRGB565( ucIntensity, 0, 0 );
+    }
+    else
+    {
+        /* White font for daytimne. */
+        usColor = DisplayCompositor::usRGB565( ucIntensity, ucIntensity, ucIntensity );
+    }
+
+    return usColor;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vHandleCameraFrame()
+{
+    unsigned long ulFramesPushed = m_Compositor.ulGetFramesPushed();
+    uint64_t ullNow = ullHUDViewMetricsNow();
+    uint64_t ullPushed = 0;
+
+    if ( m_Recorder.bIsOpen() )
+    {
+        m_Recorder.vRecordFrame( sEnumValueToComponentName( eHUDViewComponentID_Camera ), m_CameraFeed.pucGetRawFrame(),
+                                 static_cast<int>( m_CameraFeed.ulGetRawFrameBytes() ) );
+    }
+
+    /* Queued for the dashcam's writer thread; the card never holds up the frame on its way to the display. */
+    m_Dashcam.vRecordFrame( m_CameraFeed.pucGetRawFrame(), m_CameraFeed.ulGetRawFrameBytes() );
+
+    /* The low-light stage comes on at the light level that turns the HUD red, but only goes off well above it, so a
+     * rider under street lights does not see the picture pump. It applies from the next frame. */
+    if ( LIGHT_SENSOR_DARK_THRESHOLD > m_xDataModel.lLightSensorLux )
+    {
+        m_CameraFeed.vSetLowLight( true );
+    }
+    else if ( LIGHT_SENSOR_LOW_LIGHT_OFF_THRESHOLD < m_xDataModel.lLightSensorLux )
+    {
+        m_CameraFeed.vSetLowLight( false );
+    }
+
+    /* Only the camera layer changes here; the overlay is blended back in from its retained buffer. */
+    m_ullLastCameraNanoseconds = ullNow;
+    m_Compositor.vSetCameraFrame( m_CameraFeed.pusGetFrame(), CameraFeed::FRAME_WIDTH, CameraFeed::FRAME_HEIGHT );
+
+    /* In the dark the rear view is just lights, which the headlight tracker follows at a fraction of the cost of the
+     * optical flow; the same light level that turns the HUD red switches between the two. */
+    m_ApproachDetector.vSetNight( LIGHT_SENSOR_DARK_THRESHOLD > m_xDataModel.lLightSensorLux );
+
+    /* A new or cleared approach warning redraws the overlay before this frame goes out. Above the rear vision's own
+     * rate, the frames in between are only shown; the slack lets a camera at that rate through, jitter and all. */
+    if ( ullNow - m_ullLastVisionNanoseconds >= 900000000ULL / static_cast<uint64_t>( REAR_VISION_MAXIMUM_FPS ) )
+    {
+        m_ullLastVisionNanoseconds = ullNow;
+
+        if ( m_ApproachDetector.bProcessFrame( m_CameraFeed.pucGetLuma() ) )
+        {
+            qDebug() << "Rear approach alert" << ( m_ApproachDetector.bIsAlerting() ? "raised," : "cleared," )
+                     << "time to contact" << m_ApproachDetector.dGetTimeToContact() << "s";
+            vUpdateDisplay();
+        }
+    }
+
+    /* Mark every vehicle the headlight tracker follows: red once it is closing in, amber otherwise. */
+    if ( m_ApproachDetector.bIsNight() )
+    {
+        const xHUDViewHeadlightsResult_t & xHeadlights = m_ApproachDetector.xGetHeadlights();
+
+        for ( int iMarker = 0; iMarker < xHeadlights.iMarkers; iMarker++ )
+        {
+            HUDLayout::vDrawHeadlightMarker( m_Compositor, xHeadlights.axMarkers[ iMarker ] );
+        }
+    }
+
+    ullPushed = ullHUDViewMetricsNow();
+    vComposeDisplay();
+
+    /* Only a frame that went out says anything about what the link can carry. */
+    ullPushed = ( ulFramesPushed != m_Compositor.ulGetFramesPushed() ) ? ullHUDViewMetricsNow() - ullPushed : 0;
+    vUpdateCameraFrameRate( ullNow, ullPushed );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vUpdateCameraFrameRate( uint64_t ullNow, uint64_t ullPushNanoseconds )
+{
+    const MotionEstimator::xEstimate_t & xMotion = m_xDataModel.xMotion;
+    double dSpeed = -1.0;
+
+    if ( 0 < ullPushNanoseconds )
+    {
+        vHUDViewFrameRatePushed( &m_xFrameRate, ullPushNanoseconds );
+    }
+
+    if ( 0 < m_iFixedFrameRate )
+    {
+        return;
+    }
+
+    /* The fused speed while it holds, the last fix while it is fresh, and otherwise none at all. */
+    if ( xMotion.bValid )
+    {
+        dSpeed = xMotion.dSpeed * HUDVIEW_FUSION_KNOTS_TO_METRES_PER_SECOND;
+    }
+    else if ( m_xDataModel.xGPS.bHasFix && !m_pSupervisor->bIsStale( eHUDViewComponentID_GPS ) )
+    {
+        dSpeed = m_xDataModel.xGPS.dSpeed * HUDVIEW_FUSION_KNOTS_TO_METRES_PER_SECOND;
+    }
+
+    iHUDViewFrameRateUpdate( &m_xFrameRate, static_cast<int64_t>( ullNow / 1000ULL ), m_CameraFeed.dGetMotion(), dSpeed,
+                             m_ApproachDetector.bIsAlerting() );
+
+    if ( m_xFrameRate.bChanged )
+    {
+        qDebug() << "Camera frame rate" << m_xFrameRate.iRate << "fps: scene motion" << m_xFrameRate.dMotion * 100.0
+                 << "%, speed" << dSpeed << "m/s, link ceiling" << iHUDViewFrameRateCeiling( &m_xFrameRate ) << "fps";
+        m_CameraFeed.vSetFrameRate( m_xFrameRate.iRate );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vComposeDisplay()
+{
+    xHUDViewMetricsComponent_t * pxMetrics = m_apxMetrics[ eHUDViewComponentID_ControlDisplay ];
+    unsigned long ulFrames = m_Compositor.ulGetFramesPushed();
+    uint64_t ullStart = ullHUDViewMetricsNow();
+
+    m_Compositor.vCompose();
+
+    /* Transfers are synchronous, so a pushed frame has fully reached the panel once vCompose() returns. */
+    if ( ulFrames != m_Compositor.ulGetFramesPushed() )
+    {
+        vHUDViewMetricsRecord( pxMetrics, eHUDViewMetricsStage_RenderToSPI, ullHUDViewMetricsNow() - ullStart );
+        vHUDViewMetricsCount( pxMetrics, eHUDViewMetricsCounter_FramesPushed, 1 );
+
+        if ( !m_bShowingSplash && ( 0 > m_xBootTimeline.llFirstHUDFrame ) && ( 0 <= m_xBootTimeline.llSplashShown ) )
+        {
+            m_xBootTimeline.llFirstHUDFrame = m_BootTimer.nsecsElapsed();
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vFlightRecorderInit()
+{
+    /* An empty path turns the flight recorder off, e.g. for replays that should not displace a real recording. */
+    if ( m_sFlightRecorderPath.isEmpty() )
+    {
+        return;
+    }
+
+    /* A flight recorder is a safety net, so failing to open one is reported but does not stop the HUD. */
+    if ( QDir().mkpath( QFileInfo( m_sFlightRecorderPath ).absolutePath() )
+         && m_FlightRecorder.bOpen( m_sFlightRecorderPath ) )
+    {
+        qDebug() << "Flight recorder writing to: " << m_sFlightRecorderPath;
+
+        for ( ComponentHandler * pHandler : m_hashComponentHandlers )
+        {
+            pHandler->vAddTelemetrySink( &m_FlightRecorder );
+        }
+    }
+    else
+    {
+        qDebug() << "Flight recorder unavailable: " << m_sFlightRecorderPath;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vRideLogInit()
+{
+    QString sPath;
+
+    /* An empty directory turns the ride log off. */
+    if ( m_sRideLogDirectory.isEmpty() )
+    {
+        return;
+    }
+
+    /* One log per run, named after its start time so rides sort chronologically. */
+    sPath = QDir( m_sRideLogDirectory ).filePath( "ride_" + QDateTime::currentDateTime().toString( "yyyyMMdd_HHmmss" )
+                                                  + ".hrl" );
+
+    if ( QDir().mkpath( m_sRideLogDirectory ) && m_RideLog.bOpen( sPath ) )
+    {
+        qDebug() << "Ride log writing to: " << sPath;
+
+        for ( ComponentHandler * pHandler : m_hashComponentHandlers )
+        {
+            pHandler->vAddTelemetrySink( &m_RideLog );
+        }
+    }
+    else
+    {
+        qDebug() << "Ride log unavailable: " << sPath;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vDashcamInit()
+{
+    /* An empty directory turns the dashcam off. */
+    if ( m_sDashcamDirectory.isEmpty() )
+    {
+        return;
+    }
+
+    /* Frames are kept raw, as captured, so a kept clip is as sharp as the camera allows whatever the HUD shows. */
+    if ( QDir().mkpath( m_sDashcamDirectory )
+         && m_Dashcam.bOpen( m_sDashcamDirectory, m_CameraFeed.sGetRawFormat(), m_CameraFeed.ulGetRawFrameBytes() ) )
+    {
+        qDebug() << "Dashcam loop recording to: " << m_sDashcamDirectory;
+
+        /* Impacts come in through the accelerometer samples. */
+        for ( ComponentHandler * pHandler : m_hashComponentHandlers )
+        {
+            pHandler->vAddTelemetrySink( &m_Dashcam );
+        }
+    }
+    else
+    {
+        qDebug() << "Dashcam unavailable: " << m_sDashcamDirectory;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vMotionInit()
+{
+    /* The estimator sees every sample the model does, at the moment it is applied. */
+    for ( ComponentHandler * pHandler : m_hashComponentHandlers )
+    {
+        pHandler->vAddTelemetrySink( &m_MotionEstimator );
+    }
+
+    m_MotionTimer.start();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vLatencyTracerInit()
+{
+    /* Latencies are always traced for the statistics; the breakdown of every record is only written when asked for. */
+    for ( ComponentHandler * pHandler : m_hashComponentHandlers )
+    {
+        pHandler->vSetLatencyTracer( m_pTracer );
+    }
+
+    if ( !m_sLatencyTracePath.isEmpty() && QDir().mkpath( QFileInfo( m_sLatencyTracePath ).absolutePath() )
+         && m_pTracer->bOpen( m_sLatencyTracePath ) )
+    {
+        qDebug() << "Latency trace writing to: " << m_sLatencyTracePath;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vMetricsInit()
+{
+    QString sDisplayName = sEnumValueToComponentName( eHUDViewComponentID_ControlDisplay );
+
+    if ( m_Metrics.bCreate() )
+    {
+        for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
+        {
+            m_apxMetrics[ xComponent.eID ] =
+                m_Metrics.pxGetComponent( sEnumValueToComponentName( xComponent.eID ).toLatin1().constData() );
+
+            ComponentHandler * pHandler = pGetComponentHandler( xComponent.pProcess );
+
+            if ( nullptr != pHandler )
+            {
+                pHandler->vSetMetrics( m_apxMetrics[ xComponent.eID ] );
+            }
+        }
+
+        /* Render latency is tracked under the display's own name. */
+        m_apxMetrics[ eHUDViewComponentID_ControlDisplay ] =
+            m_Metrics.pxGetComponent( sDisplayName.toLatin1().constData() );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vReportStatistics()
+{
+    unsigned long ulFrames = m_Compositor.ulGetFramesPushed();
+    DisplayBackend * pBackend = m_Compositor.pGetBackend();
+
+    qDebug() << "Display:" << m_Compositor.dGetFramesPerSecond() << "fps,"
+             << m_Compositor.dGetBytesPerSecond() / 1024.0 << "KiB/s SPI,"
+             << ( ( 0 < ulFrames ) ? m_Compositor.ullGetBytesPushed() / ulFrames : 0 ) << "bytes/frame, camera as"
+             << DisplayBackend::pcGetPixelFormatName( m_Compositor.eGetCameraPixelFormat() ) << "with"
+             << ( ( nullptr != pBackend ) ? pBackend->xGetStatistics().ulPixelFormatSwitches : 0 ) << "format switches,"
+             << ( ( nullptr != pBackend ) ? pBackend->xGetStatistics().ulScrolls : 0 ) << "scrolls,"
+             << m_CameraFeed.ulGetFramesReceived() << "camera frames received,"
+             << m_CameraFeed.ulGetFramesDropped() << "dropped," << m_CameraFeed.ulGetFramesPaced() << "paced";
+
+    /* Only backends that drive the panel themselves know what a frame costs in syscalls. */
+    if ( ( nullptr != pBackend ) && ( 0 < pBackend->xGetStatistics().ullSyscalls ) && ( 0 < ulFrames ) )
+    {
+        qDebug() << "Display:" << static_cast<double>( pBackend->xGetStatistics().ullSyscalls ) / ulFrames
+                 << "syscalls/frame at" << pBackend->ulGetClockHz() / 1e6 << "MHz SPI";
+    }
+
+    m_CameraFeed.vReportStatistics();
+
+    if ( 0 == m_iFixedFrameRate )
+    {
+        QStringList lstShares;
+        int64_t llTotal = 0;
+
+        for ( int iStep = 0; iStep < HUDVIEW_FRAMERATE_STEPS; iStep++ )
+        {
+            llTotal += m_xFrameRate.allMicrosecondsAt[ iStep ];
+        }
+
+        for ( int iStep = 0; ( 0 < llTotal ) && ( iStep < HUDVIEW_FRAMERATE_STEPS ); iStep++ )
+        {
+            double dShare = 100.0 * m_xFrameRate.allMicrosecondsAt[ iStep ] / llTotal;
+
+            lstShares << QString( "%1 fps %2%" ).arg( iHUDViewFrameRateStep( iStep ) ).arg( dShare, 0, 'f', 0 );
+        }
+
+        qDebug() << "Camera frame rate:" << m_xFrameRate.iRate << "fps now," << m_xFrameRate.ulChanges << "changes,"
+                 << "link ceiling" << iHUDViewFrameRateCeiling( &m_xFrameRate ) << "fps," << lstShares.join( ", " );
+    }
+
+    if ( m_xDataModel.xMotion.bValid )
+    {
+        qDebug() << "Motion:" << m_xDataModel.xMotion.dSpeed << "+/-" << m_xDataModel.xMotion.dSpeedSigma << "knots,"
+                 << m_xDataModel.xMotion.dDirection << "+/-" << m_xDataModel.xMotion.dDirectionSigma << "degrees,"
+                 << m_xDataModel.xMotion.dGPSAgeSeconds << "s since the last fix,"
+                 << m_MotionEstimator.ulGetGPSRejected() << "fixes rejected";
+    }
+
+    for ( bool bNight : { false, true } )
+    {
+        const ApproachDetector::xStatistics_t & xVision = m_ApproachDetector.xGetStatistics( bNight );
+
+        if ( 0 < xVision.ulFrames )
+        {
+            qDebug() << "Rear vision" << ( bNight ? "(headlights):" : "(optical flow):" ) << xVision.ulFrames
+                     << "frames," << xVision.ullNanoseconds / 1e6 / xVision.ulFrames << "ms mean,"
+                     << xVision.ullMaximumNanoseconds / 1e6 << "ms max";
+        }
+    }
+
+    if ( 0 < m_ApproachDetector.ulGetAlerts() )
+    {
+        qDebug() << "Rear vision:" << m_ApproachDetector.ulGetAlerts() << "approach alerts";
+    }
+
+    m_Dashcam.vReportStatistics();
+    m_pTracer->vReportStatistics();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
 QString ControlEngine::sGPSDirectionToString( const double & dDirection )
 {
     QString sReturn = "-- ";
@@ -576,6 +1526,190 @@ QString ControlEngine::sGPSDirectionToString( const double & dDirection )
 }
 /*--------------------------------------------------------------------------------------------------------------------*/
 
+void ControlEngine::vHandleProcessFinished()
+{
+    bool bAllFinished = true;
+
+    /* When replaying a ride, the run is over once every stand-in has played out its trace. */
+    if ( m_bExitWhenFinished )
+    {
+        for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
+        {
+            if ( ( QProcess::NotRunning != xComponent.pProcess->state() )
+                 || m_pSupervisor->bIsRestartPending( xComponent.pProcess ) )
+            {
+                bAllFinished = false;
+                break;
+            }
+        }
+
+        if ( bAllFinished )
+        {
+            qDebug() << "All component processes have finished, exiting.";
+            QCoreApplication::instance()->quit();
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vHandleProcessStarted()
+{
+    QProcess * pCaller = qobject_cast<QProcess *>( QObject::sender() );
+    ComponentProcess * pProcess = qobject_cast<ComponentProcess *>( pCaller );
+    ComponentHandler * pHandler = ( nullptr != pCaller ) ? pGetComponentHandler( pCaller ) : nullptr;
+
+    if ( nullptr != pHandler )
+    {
+        /* A partial record left behind by a previous instance would corrupt the first record of this one. */
+        pHandler->vReset();
+
+        if ( 0 > m_xBootTimeline.allComponentStarted[ pHandler->eGetID() ] )
+        {
+            m_xBootTimeline.allComponentStarted[ pHandler->eGetID() ] = m_BootTimer.nsecsElapsed();
+        }
+
+        qDebug() << "Started process for component: " << sEnumValueToComponentName( pHandler->eGetID() );
+
+        /* Waiting for a sample from a component that may never send one would hold the boot report until it times
+         * out. */
+        if ( pHandler->bReadyWhenStarted() && ( 0 > m_xBootTimeline.allComponentReady[ pHandler->eGetID() ] ) )
+        {
+            vMarkComponentReady( pHandler->eGetID(), false );
+        }
+    }
+
+    /* Report options the component could not be given, e.g. a real-time priority without CAP_SYS_NICE. */
+    if ( ( nullptr != pProcess ) && !ComponentProcess::bIsDefault( pProcess->xGetSchedulingOptions() ) )
+    {
+        if ( pProcess->bVerifySchedulingOptions() )
+        {
+            qDebug() << "Applied scheduling options: "
+                     << ComponentProcess::sDescribe( pProcess->xGetSchedulingOptions() ) << "to" << pProcess->program();
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vHandleProcessError( QProcess::ProcessError eError )
+{
+    QProcess * pCaller = qobject_cast<QProcess *>( QObject::sender() );
+    ComponentHandler * pHandler = ( nullptr != pCaller ) ? pGetComponentHandler( pCaller ) : nullptr;
+
+    if ( nullptr != pHandler )
+    {
+        qDebug() << "Process error for component: " << sEnumValueToComponentName( pHandler->eGetID() ) << eError
+                 << pCaller->errorString();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vMarkComponentReady( eHUDViewComponentID_t eID, bool bFirstSample )
+{
+    bool bAllReady = true;
+
+    m_xBootTimeline.allComponentReady[ eID ] = m_BootTimer.nsecsElapsed();
+    qDebug() << "Component ready: " << sEnumValueToComponentName( eID ) << "after"
+             << m_xBootTimeline.allComponentReady[ eID ] / 1e6 << "ms";
+
+    /* The first live data is worth more to the rider than the splash; a process merely starting is not. */
+    if ( bFirstSample )
+    {
+        vShowHUD();
+    }
+
+    for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
+    {
+        if ( 0 > m_xBootTimeline.allComponentReady[ xComponent.eID ] )
+        {
+            bAllReady = false;
+            break;
+        }
+    }
+
+    if ( bAllReady )
+    {
+        vReportBootTimeline();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vReportBootTimeline()
+{
+    if ( m_bBootReported )
+    {
+        return;
+    }
+
+    m_bBootReported = true;
+    m_BootReportTimer.stop();
+
+    /* Components that are ready once started, e.g. the camera and the handlebar buttons, report no first sample. */
+    qDebug() << "Boot timeline (ms since start):";
+    qDebug() << "    Display ready:" << m_xBootTimeline.llDisplayReady / 1e6
+             << ", splash shown:" << m_xBootTimeline.llSplashShown / 1e6;
+
+    for ( const xHUDViewComponent_t & xComponent : m_lstRegisteredComponents )
+    {
+        qint64 llStarted = m_xBootTimeline.allComponentStarted[ xComponent.eID ];
+        qint64 llReady = m_xBootTimeline.allComponentReady[ xComponent.eID ];
+        ComponentHandler * pHandler = pGetComponentHandler( xComponent.pProcess );
+
+        if ( ( nullptr != pHandler ) && pHandler->bReadyWhenStarted() )
+        {
+            qDebug() << "   " << sEnumValueToComponentName( xComponent.eID ) << ": started"
+                     << ( ( 0 <= llStarted ) ? QString::number( llStarted / 1e6 ) : QString( "never" ) );
+            continue;
+        }
+
+        qDebug() << "   " << sEnumValueToComponentName( xComponent.eID ) << ": started"
+                 << ( ( 0 <= llStarted ) ? QString::number( llStarted / 1e6 ) : QString( "never" ) )
+                 << ", first valid sample"
+                 << ( ( 0 <= llReady ) ? QString::number( llReady / 1e6 ) : QString( "not yet" ) );
+    }
+
+    qDebug() << "    First HUD frame:"
+             << ( ( 0 <= m_xBootTimeline.llFirstHUDFrame ) ? QString::number( m_xBootTimeline.llFirstHUDFrame / 1e6 )
+                                                           : QString( "not yet" ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void ControlEngine::vReportRunStatistics()
+{
+    double dSeconds = m_RunTimer.nsecsElapsed() / 1e9;
+
+    qDebug() << "Run statistics over" << dSeconds << "s:";
+
+    for ( int iComponent = eHUDViewComponentIDMin; eHUDViewComponentIDMax > iComponent; iComponent++ )
+    {
+        const xComponentStatistics_t & xStatistics = m_axComponentStatistics[ iComponent ];
+        double dHandleSeconds = xStatistics.llHandleNanoseconds / 1e9;
+
+        if ( 0 == xStatistics.ullBytesReceived )
+        {
+            continue;
+        }
+
+        qDebug() << "   " << sEnumValueToComponentName( static_cast<eHUDViewComponentID_t>( iComponent ) ) << ":"
+                 << xStatistics.ulRecordsReceived << "records received,"
+                 << xStatistics.ulRecordsParsed << "applied,"
+                 << ( ( xStatistics.ulRecordsReceived > xStatistics.ulRecordsParsed )
+                      ? xStatistics.ulRecordsReceived - xStatistics.ulRecordsParsed : 0 ) << "dropped,"
+                 << ( ( 0.0 < dHandleSeconds ) ? xStatistics.ulRecordsParsed / dHandleSeconds : 0.0 )
+                 << "records/s parse throughput,"
+                 << ( ( 0 < xStatistics.ulRecordsParsed )
+                      ? xStatistics.llHandleNanoseconds / 1000.0 / xStatistics.ulRecordsParsed : 0.0 )
+                 << "us mean /" << xStatistics.llMaximumUpdateNanoseconds / 1000.0 << "us max model update";
+    }
+
+    qDebug() << "    Display:" << m_Compositor.ulGetFramesPushed() << "frames produced,"
+             << m_Compositor.ullGetBytesPushed() << "SPI bytes";
+
+    m_pTracer->vReportStatistics();
+
+    m_pSupervisor->vReportStatistics();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
 static void vSignalHandler( int iSignal )
 {
     /* Check for a signal to quit. */
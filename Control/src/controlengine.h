@@ -2,18 +2,50 @@
 #define CONTROLENGINE_H
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QProcess>
 #include <QTimer>
 
+#include "approachdetector.h"
+#include "camerafeed.h"
+#include "componentprocess.h"
+#include "dashcam.h"
+#include "displaybackend.h"
+#include "displaycompositor.h"
+#include "flightrecorder.h"
+#include "metricsregistry.h"
+#include "motionestimator.h"
+#include "ridelog.h"
+#include "riderecorder.h"
+
+class ComponentHandler;
+class ComponentSupervisor;
+class LatencyTracer;
+
 class ControlEngine : public QObject
 {
     Q_OBJECT
 
 public:
     const QString DEFAULT_CONFIG_FILE_PATH = "/opt/hudview/control/default.conf";
-    const int PROCESS_START_WAIT_TIMEOUT_MS = 5000;
+    const QString DEFAULT_FLIGHT_RECORDER_PATH = "/opt/hudview/flight/flight.rec";
+    const QString DEFAULT_RIDE_LOG_DIRECTORY = "/opt/hudview/rides";
+    const QString DEFAULT_DASHCAM_DIRECTORY = "/opt/hudview/dashcam";
+    const int BOOT_SPLASH_MAXIMUM_MS = 2000;
+    const int BOOT_REPORT_TIMEOUT_MS = 10000;
     const int LIGHT_SENSOR_DARK_THRESHOLD = 30;
+    const int LIGHT_SENSOR_LOW_LIGHT_OFF_THRESHOLD = 60;
+
+    /* However fast the camera runs, the rear vision looks at no more frames a second than this. */
+    const int REAR_VISION_MAXIMUM_FPS = 15;
+
+    /* A mode change slides the new reading in across the panel this far a step, a quarter of a second in all; only
+     * once the camera has sent nothing for a while, as a live picture would have to be pushed again at every step. */
+    const int MODE_SLIDE_STEP_PIXELS = 16;
+    const int MODE_SLIDE_INTERVAL_MS = 25;
+    const uint64_t MODE_SLIDE_CAMERA_IDLE_NS = 1000000000ULL;
 
     enum eHUDViewComponentID_t {
         eHUDViewComponentIDMin = 0,
@@ -36,22 +68,90 @@ public:
         QProcess *pProcess;
     };
 
+    struct xAccelerationInformation_t {
+        double dX;
+        double dY;
+        double dZ;
+    };
+
+    struct xGPSInformation_t {
+        bool bHasFix;
+        double dLatitude;
+        double dLongitude;
+        double dSpeed;
+        double dDirection;
+    };
+
+    struct xHUDViewDataModel_t {
+        xAccelerationInformation_t xAccelerometer;
+        xGPSInformation_t xGPS;
+
+        /* Speed and heading fused from the GPS and accelerometer, refreshed at MotionEstimator::UPDATE_INTERVAL_MS. */
+        MotionEstimator::xEstimate_t xMotion;
+        long lLightSensorLux;
+
+        /* Every handlebar button press decoded, and how many of them were long and double presses. */
+        unsigned long ulButtonPresses;
+        unsigned long ulButtonLongPresses;
+        unsigned long ulButtonDoublePresses;
+    };
+
+    /* A config file as read, before any component process is created for it. */
+    struct xHUDViewComponentConfig_t {
+        eHUDViewComponentID_t eID;
+        QString sProgram;
+        QStringList lstArguments;
+    };
+
+    struct xHUDViewConfig_t {
+        QList<xHUDViewComponentConfig_t> lstComponents;
+        ComponentProcess::xSchedulingOptions_t axSchedulingOptions[ eHUDViewComponentIDMax ];
+    };
+
     explicit ControlEngine( QObject * pParent = nullptr );
     ~ControlEngine();
 
     int iRun( QCoreApplication * pApp );
     void vSetConfigFile( const QString & sPath );
+    bool bSetDisplayBackend( const QString & sSpecification );
+    bool bSetCameraTransform( const QString & sSpecification );
+    bool bSetCameraFrameRate( const QString & sSpecification );
+    bool bSetCameraPixelFormat( const QString & sSpecification );
+    void vSetRecordDirectory( const QString & sDirectory );
+    void vSetFlightRecorderPath( const QString & sPath );
+    void vSetRideLogDirectory( const QString & sDirectory );
+    void vSetDashcamDirectory( const QString & sDirectory );
+    void vSetLatencyTracePath( const QString & sPath );
+    void vSetExitWhenFinished( bool bExit );
 
     static bool bIsValidComponent( const xHUDViewComponent_t & xComponent );
 
     static QString sEnumValueToComponentName( const eHUDViewComponentID_t & eValue );
     static eHUDViewComponentID_t eComponentNameToEnumValue( const QString & sName );
     eHUDViewComponentID_t eComponentProgramToEnumValue( const QString & sProgram );
+    ComponentHandler * pGetComponentHandler( QProcess * pProcess ) const;
+    const QList<xHUDViewComponent_t> & lstGetRegisteredComponents() const;
+
+    bool bParseConfig( const QString & sConfigPath );
+    static bool bParseConfigFile( const QString & sConfigPath, xHUDViewConfig_t & xConfig );
+
+    static bool bParseAccelerometerData( const QByteArray & Data, xAccelerationInformation_t & xInformation );
+    static bool bParseGPSData( const QByteArray & Data, xGPSInformation_t & xInformation );
+    static QString sGPSDirectionToString( const double & dDirection );
 
 private slots:
     void vHandleData();
+    void vUpdateMotion();
     void vUpdateDisplay();
     void vChangeMode();
+    void vSlideMode();
+    void vHandleCameraFrame();
+    void vReportStatistics();
+    void vHandleProcessFinished();
+    void vHandleProcessStarted();
+    void vHandleProcessError( QProcess::ProcessError eError );
+    void vShowHUD();
+    void vReportBootTimeline();
 
 private:
     enum eControlDisplayMode_t {
@@ -64,31 +164,109 @@ private:
         eControlDisplayModeMax
     } m_eDisplayMode;
 
+    /* While a mode change slides in, how far it has got and the mode going out. */
+    eControlDisplayMode_t m_ePreviousDisplayMode;
+    int m_iModeSlidePixels;
+
     QString m_sConfigPath;
+    QString m_sRecordDirectory;
+    QString m_sFlightRecorderPath;
+    QString m_sRideLogDirectory;
+    QString m_sDashcamDirectory;
+    QString m_sLatencyTracePath;
+    bool m_bExitWhenFinished;
+
+    /* Scheduling for the control application itself, from "Control.option=value" lines in the config file. */
+    ComponentProcess::xSchedulingOptions_t m_xSchedulingOptions;
     QList<xHUDViewComponent_t> m_lstRegisteredComponents;
 
+    /* Built while parsing the config so incoming data is dispatched with a single pointer lookup. */
+    QHash<QProcess *, ComponentHandler *> m_hashComponentHandlers;
+
+    /* Restarts components that crash or stall, and tells the display which data has gone stale. */
+    ComponentSupervisor * m_pSupervisor;
+
+    QTimer m_MotionTimer;
     QTimer m_DisplayRefreshTimer;
     QTimer m_ModeSwitchTimer;
+    QTimer m_ModeSlideTimer;
+    QTimer m_StatisticsTimer;
+    QTimer m_SplashTimer;
+    QTimer m_BootReportTimer;
 
-    struct xAccelerationInformation_t {
-        double dX;
-        double dY;
-        double dZ;
-    } m_xAccelerometerData;
+    DisplayBackend * m_pDisplayBackend;
+    DisplayCompositor m_Compositor;
+    CameraFeed m_CameraFeed;
 
-    QByteArray m_LightSensorData;
+    /* The format camera pixels go to the display in, offered to the backend once it is up. */
+    DisplayBackend::ePixelFormat_t m_eCameraPixelFormat;
+    bool m_bCameraDither;
 
-    struct xGPSInformation_t {
-        bool bHasFix;
-        double dLatitude;
-        double dLongitude;
-        double dSpeed;
-        double dDirection;
-    } m_xGPSData;
+    /* The camera's frame rate follows the rear scene and the rider's speed, unless it is fixed with --camera-fps. */
+    xHUDViewFrameRate_t m_xFrameRate;
+    int m_iFixedFrameRate;
 
-    bool bParseConfig( const QString & sConfigPath );
+    /* Rear vision runs on camera frames as they arrive, so an alert reaches the HUD within the same frame. */
+    ApproachDetector m_ApproachDetector;
+    uint64_t m_ullLastVisionNanoseconds;
+    uint64_t m_ullLastCameraNanoseconds;
+    RideRecorder m_Recorder;
+    FlightRecorder m_FlightRecorder;
+    RideLog m_RideLog;
+    Dashcam m_Dashcam;
+    MotionEstimator m_MotionEstimator;
+
+    /* Live per-stage latency histograms and counters, shared with the components and hudview_metrics. */
+    MetricsRegistry m_Metrics;
+    xHUDViewMetricsComponent_t * m_apxMetrics[ eHUDViewComponentIDMax ];
+
+    /* Follows each stamped record from its component to the panel. */
+    LatencyTracer * m_pTracer;
+
+    /* Per-component accounting used to report replay and load-test runs. */
+    struct xComponentStatistics_t {
+        unsigned long ulRecordsReceived;
+        unsigned long ulRecordsParsed;
+        unsigned long long ullBytesReceived;
+        qint64 llHandleNanoseconds;
+        qint64 llMaximumUpdateNanoseconds;
+    } m_axComponentStatistics[ eHUDViewComponentIDMax ];
+
+    QElapsedTimer m_RunTimer;
+
+    /* Milestones of the boot, in nanoseconds since iRun() was entered; -1 until reached. */
+    struct xBootTimeline_t {
+        qint64 llDisplayReady;
+        qint64 llSplashShown;
+        qint64 llFirstHUDFrame;
+        qint64 allComponentStarted[ eHUDViewComponentIDMax ];
+        qint64 allComponentReady[ eHUDViewComponentIDMax ];
+    } m_xBootTimeline;
+
+    QElapsedTimer m_BootTimer;
+    bool m_bShowingSplash;
+    bool m_bBootReported;
+
+    xHUDViewDataModel_t m_xDataModel;
+
+    void vSchedulingInit();
     void vDisplayInit();
-    QString sGPSDirectionToString( const double & dDirection );
+    void vShowSplash();
+    void vMarkComponentReady( eHUDViewComponentID_t eID, bool bFirstSample );
+    void vMetricsInit();
+    void vFlightRecorderInit();
+    void vRideLogInit();
+    void vDashcamInit();
+    void vMotionInit();
+    void vLatencyTracerInit();
+    void vHandleButtonPresses( unsigned long ulPresses, unsigned long ulLongPresses, unsigned long ulDoublePresses );
+    void vChangeModeBack();
+    void vSelectMode( eControlDisplayMode_t eMode );
+    QString sDisplayText( eControlDisplayMode_t eMode, uint8_t & ucIntensity ) const;
+    uint16_t usDisplayColor( uint8_t ucIntensity ) const;
+    void vComposeDisplay();
+    void vUpdateCameraFrameRate( uint64_t ullNow, uint64_t ullPushNanoseconds );
+    void vReportRunStatistics();
 };
 
 #endif // CONTROLENGINE_H
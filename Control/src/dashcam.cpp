@@ -0,0 +1,176 @@
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <QDebug>
+
+#include "dashcam.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* The accelerometer reads up to 4 g; riding, even over a kerb, stays well below this. */
+#define IMPACT_THRESHOLD_G ( 3.0 )
+
+/* An impact rattles on for a while; later readings extend the clip already being kept rather than being reported. */
+#define IMPACT_HOLD_OFF_NANOSECONDS ( 1000000000LL )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llRealtimeNanoseconds();
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+Dashcam::Dashcam()
+{
+    m_bOpen = false;
+    m_ulFrameBytes = 0;
+    m_llLastImpactNanoseconds = 0;
+    memset( &m_xDashcam, 0, sizeof( m_xDashcam ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+Dashcam::~Dashcam()
+{
+    vClose();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool Dashcam::bOpen( const QString & sDirectory, const QString & sFormat, size_t ulFrameBytes,
+                     unsigned long long ullSegmentBytes, int iSegments )
+{
+    vClose();
+
+    /* Every segment is preallocated here, before the ride, so recording never waits on the card for space. */
+    if ( 0 != iHUDViewDashcamOpen( &m_xDashcam, sDirectory.toLocal8Bit().constData(),
+                                   sFormat.toLocal8Bit().constData(), static_cast<uint32_t>( ulFrameBytes ),
+                                   ullSegmentBytes, iSegments ) )
+    {
+        return false;
+    }
+
+    m_sDirectory = sDirectory;
+    m_ulFrameBytes = ulFrameBytes;
+    m_llLastImpactNanoseconds = 0;
+    m_bOpen = true;
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool Dashcam::bIsOpen() const
+{
+    return m_bOpen;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vClose()
+{
+    if ( m_bOpen )
+    {
+        /* Closing waits for the writer to empty the queue and close the segment, so nothing queued is lost. */
+        vReportStatistics();
+        ( void )iHUDViewDashcamClose( &m_xDashcam );
+        m_bOpen = false;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vRecordFrame( const uint8_t * pucFrame, size_t ulBytes )
+{
+    /* Only copied into the queue here; a frame the writer has no room for is dropped and counted, never waited on. */
+    if ( m_bOpen && ( m_ulFrameBytes == ulBytes ) )
+    {
+        ( void )iHUDViewDashcamRecordFrame( &m_xDashcam, pucFrame, llRealtimeNanoseconds() );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vRecordAccelerometer( double dX, double dY, double dZ )
+{
+    int64_t llNow = 0;
+
+    if ( !m_bOpen || ( IMPACT_THRESHOLD_G > sqrt( dX * dX + dY * dY + dZ * dZ ) ) )
+    {
+        return;
+    }
+
+    llNow = llRealtimeNanoseconds();
+
+    if ( IMPACT_HOLD_OFF_NANOSECONDS <= llNow - m_llLastImpactNanoseconds )
+    {
+        qDebug() << "Dashcam: impact of" << sqrt( dX * dX + dY * dY + dZ * dZ ) << "g, keeping the last"
+                 << HUDVIEW_DASHCAM_PRE_ROLL_SECONDS << "s in" << m_sDirectory;
+    }
+
+    m_llLastImpactNanoseconds = llNow;
+    vHUDViewDashcamReportImpact( &m_xDashcam, llNow );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vKeepEvent()
+{
+    int64_t llNow = llRealtimeNanoseconds();
+
+    if ( !m_bOpen )
+    {
+        return;
+    }
+
+    /* Kept just as an impact's stretch is, and an impact that follows soon after extends it. */
+    qDebug() << "Dashcam: rider asked to keep the last" << HUDVIEW_DASHCAM_PRE_ROLL_SECONDS << "s in" << m_sDirectory;
+    m_llLastImpactNanoseconds = llNow;
+    vHUDViewDashcamReportImpact( &m_xDashcam, llNow );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection )
+{
+    Q_UNUSED( bHasFix );
+    Q_UNUSED( dLatitude );
+    Q_UNUSED( dLongitude );
+    Q_UNUSED( dSpeed );
+    Q_UNUSED( dDirection );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vRecordLightSensor( long lLux )
+{
+    Q_UNUSED( lLux );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vRecordButtonPress( unsigned long ulPresses )
+{
+    Q_UNUSED( ulPresses );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void Dashcam::vReportStatistics()
+{
+    xHUDViewDashcamStatistics_t xStatistics;
+    double dSeconds = 0.0;
+
+    if ( !m_bOpen )
+    {
+        return;
+    }
+
+    vHUDViewDashcamGetStatistics( &m_xDashcam, &xStatistics );
+    dSeconds = xStatistics.llRecordingNanoseconds / 1e9;
+
+    qDebug() << "Dashcam:" << xStatistics.ullFramesWritten << "frames written,"
+             << xStatistics.ullFramesDropped << "dropped of" << xStatistics.ullFramesOffered << "offered,"
+             << ( ( 0.0 < dSeconds ) ? xStatistics.ullBytesWritten / dSeconds / 1024.0 : 0.0 ) << "KiB/s"
+             << ( xStatistics.bDirect ? "direct," : "buffered," )
+             << ( ( 0 < xStatistics.ullWrites ) ? xStatistics.llWriteNanoseconds / 1e6 / xStatistics.ullWrites : 0.0 )
+             << "ms mean write," << xStatistics.llMaximumWriteNanoseconds / 1e6 << "ms max,"
+             << "queue high water" << xStatistics.iQueueHighWater << "of" << HUDVIEW_DASHCAM_QUEUE_FRAMES << ","
+             << xStatistics.ulEvents << "impacts," << xStatistics.ulSegmentsKept << "segments kept";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llRealtimeNanoseconds()
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_REALTIME, &xNow );
+
+    return static_cast<int64_t>( xNow.tv_sec ) * 1000000000LL + xNow.tv_nsec;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,43 @@
+#ifndef DASHCAM_H
+#define DASHCAM_H
+
+#include <cstdint>
+#include <QString>
+
+#include "hudview_dashcam.h"
+#include "telemetrysink.h"
+
+/* Loop-records the raw camera frames, and keeps the stretch around any impact the accelerometer feels. */
+class Dashcam : public TelemetrySink
+{
+public:
+    Dashcam();
+    ~Dashcam() override;
+
+    bool bOpen( const QString & sDirectory, const QString & sFormat, size_t ulFrameBytes,
+                unsigned long long ullSegmentBytes = HUDVIEW_DASHCAM_DEFAULT_SEGMENT_BYTES,
+                int iSegments = HUDVIEW_DASHCAM_DEFAULT_SEGMENTS );
+    bool bIsOpen() const override;
+    void vClose();
+
+    void vRecordFrame( const uint8_t * pucFrame, size_t ulBytes );
+
+    /* Keeps the stretch around now as an event, as an impact would be kept. */
+    void vKeepEvent();
+
+    void vRecordAccelerometer( double dX, double dY, double dZ ) override;
+    void vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection ) override;
+    void vRecordLightSensor( long lLux ) override;
+    void vRecordButtonPress( unsigned long ulPresses ) override;
+
+    void vReportStatistics();
+
+private:
+    bool m_bOpen;
+    QString m_sDirectory;
+    size_t m_ulFrameBytes;
+    int64_t m_llLastImpactNanoseconds;
+    xHUDViewDashcam_t m_xDashcam;
+};
+
+#endif // DASHCAM_H
@@ -0,0 +1,245 @@
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "displaybackend.h"
+#include "framebufferbackend.h"
+#include "spidevbackend.h"
+#include "timingbackend.h"
+
+#ifndef HUDVIEW_HEADLESS
+#include "st7735backend.h"
+#endif
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const int DisplayBackend::DISPLAY_WIDTH;
+const int DisplayBackend::DISPLAY_HEIGHT;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+DisplayBackend::DisplayBackend()
+{
+    m_xStatistics = { 0, 0, 0, 0, 0, 0, 0 };
+    m_ePixelFormat = ePixelFormat_RGB565;
+    m_ePanelPixelFormat = ePixelFormat_RGB565;
+    vHUDViewRGB444Init( &m_xPacker, 0 );
+    m_xScrollArea = { 0, DISPLAY_WIDTH, 0 };
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+DisplayBackend::~DisplayBackend()
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayBackend::vEndFrame()
+{
+    m_xStatistics.ulFrames++;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayBackend::bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const
+{
+    return ( ePixelFormat_RGB565 == ePixelFormat );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long DisplayBackend::ulGetClockHz() const
+{
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayBackend::bSupportsScroll() const
+{
+    return false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayBackend::vScroll( const xScrollArea_t & xArea )
+{
+    ( void )xArea;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayBackend::bSetPixelFormat( ePixelFormat_t ePixelFormat, bool bDither )
+{
+    bool bReturn = false;
+
+    /* The panel itself is only switched before the next transfer, and only if that is in the other format. */
+    if ( bSupportsPixelFormat( ePixelFormat ) )
+    {
+        m_ePixelFormat = ePixelFormat;
+        m_xPacker.bDither = bDither ? 1 : 0;
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+DisplayBackend::ePixelFormat_t DisplayBackend::eGetPixelFormat() const
+{
+    return m_ePixelFormat;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const DisplayBackend::xDisplayStatistics_t & DisplayBackend::xGetStatistics() const
+{
+    return m_xStatistics;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long long DisplayBackend::ullGetTotalBytes() const
+{
+    return m_xStatistics.ullCommandBytes + m_xStatistics.ullPixelBytes;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+DisplayBackend * DisplayBackend::pCreate( const std::string & sSpecification )
+{
+    std::vector<std::string> lstFields;
+    std::stringstream Stream( sSpecification );
+    std::string sField = "";
+    DisplayBackend * pReturn = nullptr;
+
+    /* Specifications take the form "<backend>[:<option>[:<option>]]". */
+    while ( std::getline( Stream, sField, ':' ) )
+    {
+        lstFields.push_back( sField );
+    }
+
+    if ( lstFields.empty() )
+    {
+        /* Nothing to create. */
+    }
+#ifndef HUDVIEW_HEADLESS
+    else if ( "st7735" == lstFields.at( 0 ) )
+    {
+        pReturn = new St7735DisplayBackend();
+    }
+#endif
+    else if ( "framebuffer" == lstFields.at( 0 ) )
+    {
+        FramebufferDisplayBackend * pFramebuffer = new FramebufferDisplayBackend();
+
+        /* Optionally dump every frame into a directory for offline inspection. */
+        if ( 1 < lstFields.size() )
+        {
+            pFramebuffer->vSetDumpDirectory( lstFields.at( 1 ),
+                                             ( 2 < lstFields.size() ) && ( "png" == lstFields.at( 2 ) ) );
+        }
+
+        pReturn = pFramebuffer;
+    }
+    else if ( "spidev" == lstFields.at( 0 ) )
+    {
+        std::string sDevice = HUDVIEW_SPIDEV_DEFAULT_DEVICE;
+        unsigned long ulClockHz = 0;
+
+        /* "spidev[:<device>|standin[:<hz>]]"; without a clock the fastest stable one is probed for. */
+        if ( ( 1 < lstFields.size() ) && !lstFields.at( 1 ).empty() )
+        {
+            sDevice = lstFields.at( 1 );
+        }
+
+        if ( ( 2 < lstFields.size() ) && !lstFields.at( 2 ).empty() )
+        {
+            ulClockHz = strtoul( lstFields.at( 2 ).c_str(), nullptr, 10 );
+        }
+
+        pReturn = new SpidevDisplayBackend( sDevice, ulClockHz );
+    }
+    else if ( "timing" == lstFields.at( 0 ) )
+    {
+        unsigned long ulClockHz = TimingDisplayBackend::DEFAULT_SPI_CLOCK_HZ;
+        bool bSleep = false;
+
+        if ( ( 1 < lstFields.size() ) && !lstFields.at( 1 ).empty() )
+        {
+            ulClockHz = strtoul( lstFields.at( 1 ).c_str(), nullptr, 10 );
+        }
+
+        if ( 2 < lstFields.size() )
+        {
+            bSleep = ( "sleep" == lstFields.at( 2 ) );
+        }
+
+        if ( 0 < ulClockHz )
+        {
+            pReturn = new TimingDisplayBackend( ulClockHz, bSleep );
+        }
+    }
+
+    return pReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * DisplayBackend::pcGetDefaultSpecification()
+{
+#ifdef HUDVIEW_HEADLESS
+    return "framebuffer";
+#else
+    return "st7735";
+#endif
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * DisplayBackend::pcGetPixelFormatName( ePixelFormat_t ePixelFormat )
+{
+    const char * pcReturn = "unknown";
+
+    switch ( ePixelFormat )
+    {
+    case ePixelFormat_RGB565:
+        pcReturn = "RGB565";
+        break;
+
+    case ePixelFormat_RGB444:
+        pcReturn = "RGB444";
+        break;
+
+    default:
+        break;
+    }
+
+    return pcReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayBackend::vCountTransfer( unsigned long long ullCommandBytes, unsigned long long ullPixelBytes )
+{
+    m_xStatistics.ulTransfers++;
+    m_xStatistics.ullCommandBytes += ullCommandBytes;
+    m_xStatistics.ullPixelBytes += ullPixelBytes;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayBackend::bSwitchPixelFormat()
+{
+    bool bReturn = false;
+
+    /* Counted here so every backend accounts for the COLMOD traffic the same way. */
+    if ( m_ePixelFormat != m_ePanelPixelFormat )
+    {
+        m_ePanelPixelFormat = m_ePixelFormat;
+        m_xStatistics.ulPixelFormatSwitches++;
+        m_xStatistics.ullCommandBytes += PIXEL_FORMAT_COMMAND_BYTES;
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayBackend::bSwitchScrollArea( const xScrollArea_t & xArea )
+{
+    bool bReturn = ( xArea.iX != m_xScrollArea.iX ) || ( xArea.iWidth != m_xScrollArea.iWidth );
+
+    /* Moving the picture is one short command; the area only has to be defined again when it changes. */
+    vCountTransfer( SCROLL_COMMAND_BYTES + ( bReturn ? SCROLL_AREA_COMMAND_BYTES : 0 ), 0 );
+    m_xStatistics.ulScrolls++;
+    m_xScrollArea = xArea;
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
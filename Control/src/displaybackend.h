@@ -0,0 +1,108 @@
+#ifndef DISPLAYBACKEND_H
+#define DISPLAYBACKEND_H
+
+#include <cstdint>
+#include <string>
+
+#include "hudview_rgb444.h"
+
+class DisplayBackend
+{
+public:
+    /* Panel geometry with the ST7735 rotated into landscape. */
+    static const int DISPLAY_WIDTH = 160;
+    static const int DISPLAY_HEIGHT = 128;
+
+    /* Bytes of ST7735 command traffic (CASET, RASET, RAMWR) needed to open a window before pushing pixels. */
+    static const int REGION_COMMAND_OVERHEAD_BYTES = 11;
+
+    /* Bytes of ST7735 command traffic (COLMOD and its argument) needed to change the panel's pixel format. */
+    static const int PIXEL_FORMAT_COMMAND_BYTES = 2;
+
+    /* Bytes of ST7735 command traffic to define the scrolling area (VSCRDEF and its six arguments) and to move the
+     * picture within it (VSCSAD and its two). */
+    static const int SCROLL_AREA_COMMAND_BYTES = 7;
+    static const int SCROLL_COMMAND_BYTES = 3;
+
+    /* How pixels go over the wire; they are always handed to the backend as RGB565. */
+    enum ePixelFormat_t {
+        ePixelFormatMin = 0,
+
+        ePixelFormat_RGB565,
+        ePixelFormat_RGB444,
+
+        ePixelFormatMax
+    };
+
+    struct xDisplayRegion_t {
+        int iX;
+        int iY;
+        int iWidth;
+        int iHeight;
+    };
+
+    /* Columns [iX, iX + iWidth) of the panel scroll together, showing its memory rotated left by iOffset columns.
+     * The rotation the display library sets puts the panel's lines along the landscape x axis, so the ST7735's
+     * vertical scroll moves the picture sideways, a whole column at a time. */
+    struct xScrollArea_t {
+        int iX;
+        int iWidth;
+        int iOffset;
+    };
+
+    struct xDisplayStatistics_t {
+        unsigned long ulFrames;
+        unsigned long ulTransfers;
+        unsigned long long ullCommandBytes;
+        unsigned long long ullPixelBytes;
+        unsigned long ulPixelFormatSwitches;
+        unsigned long ulScrolls;
+
+        /* ioctls and GPIO writes made on the way to the panel, for backends that drive it directly. */
+        unsigned long long ullSyscalls;
+    };
+
+    virtual ~DisplayBackend();
+
+    virtual bool bInit() = 0;
+    virtual void vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride ) = 0;
+    virtual void vEndFrame();
+    virtual const char * pcGetName() const = 0;
+    virtual bool bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const;
+
+    /* The SPI clock the panel is driven or modelled at; 0 when the backend does not know it. */
+    virtual unsigned long ulGetClockHz() const;
+
+    /* Backends that can scroll the panel in hardware move its picture straight away; the others ignore this. */
+    virtual bool bSupportsScroll() const;
+    virtual void vScroll( const xScrollArea_t & xArea );
+
+    bool bSetPixelFormat( ePixelFormat_t ePixelFormat, bool bDither );
+    ePixelFormat_t eGetPixelFormat() const;
+
+    const xDisplayStatistics_t & xGetStatistics() const;
+    unsigned long long ullGetTotalBytes() const;
+
+    static DisplayBackend * pCreate( const std::string & sSpecification );
+    static const char * pcGetDefaultSpecification();
+    static const char * pcGetPixelFormatName( ePixelFormat_t ePixelFormat );
+
+protected:
+    DisplayBackend();
+
+    xDisplayStatistics_t m_xStatistics;
+
+    /* The format asked for, the one the panel was last switched to, and how 12-bit pixels are packed. */
+    ePixelFormat_t m_ePixelFormat;
+    ePixelFormat_t m_ePanelPixelFormat;
+    xHUDViewRGB444_t m_xPacker;
+
+    /* Where the panel was last told to scroll; a reset panel scrolls all of its width, and has not moved. */
+    xScrollArea_t m_xScrollArea;
+
+    void vCountTransfer( unsigned long long ullCommandBytes, unsigned long long ullPixelBytes );
+    bool bSwitchPixelFormat();
+    bool bSwitchScrollArea( const xScrollArea_t & xArea );
+};
+
+#endif // DISPLAYBACKEND_H
@@ -0,0 +1,686 @@
+#include <algorithm>
+#include <cstring>
+
+#include "displaycompositor.h"
+
+/* The font table is declared for the display library, which may not be part of a headless build. */
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#include "ubuntumono.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const int DisplayCompositor::DISPLAY_WIDTH;
+const int DisplayCompositor::DISPLAY_HEIGHT;
+const int DisplayCompositor::TILE_SIZE;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* Number of glyphs stored in the fixed font, starting at the first character given in its header. */
+static const int FONT_GLYPH_COUNT = 0x60;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+DisplayCompositor::DisplayCompositor() :
+    m_ausCameraLayer( DISPLAY_WIDTH * DISPLAY_HEIGHT, 0 ),
+    m_ausOverlayLayer( DISPLAY_WIDTH * DISPLAY_HEIGHT, 0 ),
+    m_aucOverlayAlpha( DISPLAY_WIDTH * DISPLAY_HEIGHT, 0 ),
+    m_ausBackBuffer( DISPLAY_WIDTH * DISPLAY_HEIGHT, 0 ),
+    m_ausFrontBuffer( DISPLAY_WIDTH * DISPLAY_HEIGHT, 0 )
+{
+    m_pBackend = nullptr;
+    m_eCameraPixelFormat = DisplayBackend::ePixelFormat_RGB565;
+    m_bCameraDither = false;
+    m_axCameraRuns.reserve( TILE_ROWS * TILE_COLUMNS );
+    m_axOverlayRuns.reserve( TILE_ROWS * TILE_COLUMNS );
+    m_iCameraOffsetX = 0;
+    m_iCameraOffsetY = 0;
+    memset( m_abDirtyTiles, 0, sizeof( m_abDirtyTiles ) );
+    m_bHasOverlayContent = false;
+    m_xOverlayBounds = { 0, 0, 0, 0 };
+    m_xScrollArea = { 0, DISPLAY_WIDTH, 0 };
+    m_bScrollPending = false;
+    m_bRepaint = false;
+
+    m_xWindowStart = std::chrono::steady_clock::now();
+    m_ulWindowFrames = 0;
+    m_ullWindowBytes = 0;
+    m_dFramesPerSecond = 0.0;
+    m_dBytesPerSecond = 0.0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayCompositor::bInit( DisplayBackend * pBackend )
+{
+    bool bReturn = false;
+
+    m_pBackend = pBackend;
+    m_eCameraPixelFormat = DisplayBackend::ePixelFormat_RGB565;
+
+    if ( ( nullptr != m_pBackend ) && m_pBackend->bInit() )
+    {
+        /* The panel now matches the (black) front buffer, so only subsequent changes need to be pushed. */
+        std::fill( m_ausFrontBuffer.begin(), m_ausFrontBuffer.end(), 0 );
+        std::fill( m_ausBackBuffer.begin(), m_ausBackBuffer.end(), 0 );
+        m_xScrollArea = { 0, DISPLAY_WIDTH, 0 };
+        m_bScrollPending = false;
+        m_bRepaint = false;
+        m_xWindowStart = std::chrono::steady_clock::now();
+        bReturn = true;
+    }
+    else
+    {
+        m_pBackend = nullptr;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+DisplayBackend * DisplayCompositor::pGetBackend() const
+{
+    return m_pBackend;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayCompositor::bSetCameraPixelFormat( ePixelFormat_t ePixelFormat, bool bDither )
+{
+    bool bReturn = false;
+
+    /* Only a format the backend can put on the wire is taken; otherwise the camera stays in RGB565. */
+    if ( ( nullptr != m_pBackend ) && m_pBackend->bSupportsPixelFormat( ePixelFormat ) )
+    {
+        m_eCameraPixelFormat = ePixelFormat;
+        m_bCameraDither = bDither;
+        bReturn = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+DisplayCompositor::ePixelFormat_t DisplayCompositor::eGetCameraPixelFormat() const
+{
+    return m_eCameraPixelFormat;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vSetCameraFrame( const uint16_t * pusFrame, int iWidth, int iHeight )
+{
+    /* Center the frame on the display, clipping anything that does not fit. */
+    int iOffsetX = ( DISPLAY_WIDTH - iWidth ) / 2;
+    int iOffsetY = ( DISPLAY_HEIGHT - iHeight ) / 2;
+    int iStartX = std::max( 0, iOffsetX );
+    int iStartY = std::max( 0, iOffsetY );
+    int iEndX = std::min( DISPLAY_WIDTH, iOffsetX + iWidth );
+    int iEndY = std::min( DISPLAY_HEIGHT, iOffsetY + iHeight );
+
+    m_iCameraOffsetX = iOffsetX;
+    m_iCameraOffsetY = iOffsetY;
+
+    if ( ( nullptr != pusFrame ) && ( iEndX > iStartX ) && ( iEndY > iStartY ) )
+    {
+        for ( int iY = iStartY; iY < iEndY; iY++ )
+        {
+            memcpy( &m_ausCameraLayer[ iY * DISPLAY_WIDTH + iStartX ],
+                    &pusFrame[ ( iY - iOffsetY ) * iWidth + ( iStartX - iOffsetX ) ],
+                    ( iEndX - iStartX ) * sizeof( uint16_t ) );
+        }
+
+        vMarkDirty( { iStartX, iStartY, iEndX - iStartX, iEndY - iStartY } );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vDrawCameraBox( int iX, int iY, int iWidth, int iHeight, uint16_t usColor )
+{
+    /* Boxes go into the camera layer itself, so the next frame wipes them and the overlay is left alone. */
+    int iLeft = iX + m_iCameraOffsetX;
+    int iTop = iY + m_iCameraOffsetY;
+    int iRight = iLeft + iWidth - 1;
+    int iBottom = iTop + iHeight - 1;
+    int iStartX = std::max( 0, iLeft );
+    int iStartY = std::max( 0, iTop );
+    int iEndX = std::min( DISPLAY_WIDTH - 1, iRight );
+    int iEndY = std::min( DISPLAY_HEIGHT - 1, iBottom );
+
+    if ( ( iEndX < iStartX ) || ( iEndY < iStartY ) )
+    {
+        return;
+    }
+
+    for ( int iColumn = iStartX; iColumn <= iEndX; iColumn++ )
+    {
+        if ( iTop == iStartY )
+        {
+            m_ausCameraLayer[ iTop * DISPLAY_WIDTH + iColumn ] = usColor;
+        }
+
+        if ( iBottom == iEndY )
+        {
+            m_ausCameraLayer[ iBottom * DISPLAY_WIDTH + iColumn ] = usColor;
+        }
+    }
+
+    for ( int iRow = iStartY; iRow <= iEndY; iRow++ )
+    {
+        if ( iLeft == iStartX )
+        {
+            m_ausCameraLayer[ iRow * DISPLAY_WIDTH + iLeft ] = usColor;
+        }
+
+        if ( iRight == iEndX )
+        {
+            m_ausCameraLayer[ iRow * DISPLAY_WIDTH + iRight ] = usColor;
+        }
+    }
+
+    vMarkDirty( { iStartX, iStartY, iEndX - iStartX + 1, iEndY - iStartY + 1 } );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vClearCamera()
+{
+    std::fill( m_ausCameraLayer.begin(), m_ausCameraLayer.end(), 0 );
+    vMarkDirty( { 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT } );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vClearOverlay()
+{
+    /* Only the area that has been drawn into needs to be cleared and recomposed. */
+    if ( m_bHasOverlayContent )
+    {
+        for ( int iY = m_xOverlayBounds.iY; iY < m_xOverlayBounds.iY + m_xOverlayBounds.iHeight; iY++ )
+        {
+            memset( &m_aucOverlayAlpha[ iY * DISPLAY_WIDTH + m_xOverlayBounds.iX ], 0, m_xOverlayBounds.iWidth );
+        }
+
+        vMarkDirty( m_xOverlayBounds );
+        m_bHasOverlayContent = false;
+        m_xOverlayBounds = { 0, 0, 0, 0 };
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vDrawText( int iX, int iY, const char * pcText, uint16_t usColor )
+{
+    const uint8_t * pucFont = UbuntuMono25x34;
+    const int iHeaderBytes = ( 0x01 == pucFont[ 0 ] ) ? 7 : 4;
+    const int iGlyphWidth = pucFont[ 1 ];
+    const int iGlyphHeight = pucFont[ 2 ];
+    const int iFirstCharacter = pucFont[ 3 ];
+    const int iGlyphBytes = iGlyphWidth * ( ( iGlyphHeight + 7 ) / 8 );
+    int iCursorX = iX;
+
+    for ( const char * pcCharacter = pcText; '\0' != *pcCharacter; pcCharacter++ )
+    {
+        int iIndex = static_cast<unsigned char>( *pcCharacter ) - iFirstCharacter;
+
+        /* Unsupported characters are rendered as blanks. */
+        if ( ( 0 > iIndex ) || ( FONT_GLYPH_COUNT <= iIndex ) )
+        {
+            iIndex = 0;
+        }
+
+        /* Glyphs are stored as pages of 8 vertical pixels, least significant bit at the top. */
+        const uint8_t * pucGlyph = &pucFont[ iHeaderBytes + iIndex * iGlyphBytes ];
+
+        for ( int iRow = 0; iRow < iGlyphHeight; iRow++ )
+        {
+            int iPixelY = iY + iRow;
+
+            if ( ( 0 > iPixelY ) || ( DISPLAY_HEIGHT <= iPixelY ) )
+            {
+                continue;
+            }
+
+            for ( int iColumn = 0; iColumn < iGlyphWidth; iColumn++ )
+            {
+                int iPixelX = iCursorX + iColumn;
+
+                if ( ( 0 > iPixelX ) || ( DISPLAY_WIDTH <= iPixelX ) )
+                {
+                    continue;
+                }
+
+                int iPixel = iPixelY * DISPLAY_WIDTH + iPixelX;
+
+                if ( pucGlyph[ ( iRow / 8 ) * iGlyphWidth + iColumn ] & ( 1 << ( iRow % 8 ) ) )
+                {
+                    m_ausOverlayLayer[ iPixel ] = usColor;
+                    m_aucOverlayAlpha[ iPixel ] = 0xFF;
+                }
+                else
+                {
+                    m_ausOverlayLayer[ iPixel ] = 0x0000;
+                    m_aucOverlayAlpha[ iPixel ] = OVERLAY_TEXT_BACKGROUND_ALPHA;
+                }
+            }
+        }
+
+        iCursorX += iGlyphWidth;
+    }
+
+    /* Clip the drawn area to the display before tracking it. */
+    int iStartX = std::max( 0, iX );
+    int iStartY = std::max( 0, iY );
+    int iEndX = std::min( DISPLAY_WIDTH, iCursorX );
+    int iEndY = std::min( DISPLAY_HEIGHT, iY + iGlyphHeight );
+
+    if ( ( iEndX > iStartX ) && ( iEndY > iStartY ) )
+    {
+        xDisplayRegion_t xRegion = { iStartX, iStartY, iEndX - iStartX, iEndY - iStartY };
+        vMarkDirty( xRegion );
+        vExtendOverlayBounds( xRegion );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vFillOverlay( int iX, int iY, int iWidth, int iHeight, uint16_t usColor )
+{
+    int iStartX = std::max( 0, iX );
+    int iStartY = std::max( 0, iY );
+    int iEndX = std::min( DISPLAY_WIDTH, iX + iWidth );
+    int iEndY = std::min( DISPLAY_HEIGHT, iY + iHeight );
+
+    if ( ( iEndX > iStartX ) && ( iEndY > iStartY ) )
+    {
+        xDisplayRegion_t xRegion = { iStartX, iStartY, iEndX - iStartX, iEndY - iStartY };
+
+        for ( int iRow = iStartY; iRow < iEndY; iRow++ )
+        {
+            std::fill( &m_ausOverlayLayer[ iRow * DISPLAY_WIDTH + iStartX ],
+                       &m_ausOverlayLayer[ iRow * DISPLAY_WIDTH + iEndX ], usColor );
+            memset( &m_aucOverlayAlpha[ iRow * DISPLAY_WIDTH + iStartX ], 0xFF, iEndX - iStartX );
+        }
+
+        vMarkDirty( xRegion );
+        vExtendOverlayBounds( xRegion );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayCompositor::bCanScroll() const
+{
+    return ( nullptr != m_pBackend ) && m_pBackend->bSupportsScroll();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayCompositor::bSetScrollArea( int iX, int iWidth )
+{
+    bool bReturn = bCanScroll() && ( 0 <= iX ) && ( 0 < iWidth ) && ( DISPLAY_WIDTH >= iX + iWidth );
+
+    if ( bReturn && ( ( iX != m_xScrollArea.iX ) || ( iWidth != m_xScrollArea.iWidth ) ) )
+    {
+        /* The panel's memory is laid out for the old area unless it has not been scrolled, so it is pushed afresh. */
+        if ( 0 != m_xScrollArea.iOffset )
+        {
+            vInvalidate();
+        }
+
+        m_xScrollArea = { iX, iWidth, 0 };
+        m_bScrollPending = true;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vScroll( int iPixels )
+{
+    int iWidth = m_xScrollArea.iWidth;
+    int iShift = ( ( iPixels % iWidth ) + iWidth ) % iWidth;
+
+    /* Every row of the area turns round by the same amount on the panel, so the front buffer does too. */
+    if ( bCanScroll() && ( 0 != iShift ) )
+    {
+        for ( int iY = 0; iY < DISPLAY_HEIGHT; iY++ )
+        {
+            std::vector<uint16_t>::iterator xRow = m_ausFrontBuffer.begin() + iY * DISPLAY_WIDTH + m_xScrollArea.iX;
+
+            std::rotate( xRow, xRow + iShift, xRow + iWidth );
+        }
+
+        m_xScrollArea.iOffset = ( m_xScrollArea.iOffset + iShift ) % iWidth;
+        m_bScrollPending = true;
+        vMarkDirty( { m_xScrollArea.iX, 0, iWidth, DISPLAY_HEIGHT } );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vInvalidate()
+{
+    m_bRepaint = true;
+    vMarkDirty( { 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT } );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vCompose()
+{
+    unsigned long long ullFrameBytes = 0;
+    unsigned long ulTransfers = 0;
+
+    /* Without a backend there is nowhere to push, so leave the tiles dirty until one is attached. */
+    if ( nullptr == m_pBackend )
+    {
+        return;
+    }
+
+    ullFrameBytes = m_pBackend->ullGetTotalBytes();
+    ulTransfers = m_pBackend->xGetStatistics().ulTransfers;
+
+    m_axCameraRuns.clear();
+    m_axOverlayRuns.clear();
+
+    /* Blend every dirty tile, then push runs of tiles whose content actually changed on the panel, from the first
+     * column that changed to the last. A run also ends where the overlay starts or stops, when the two go out in
+     * different formats. */
+    for ( int iTileRow = 0; iTileRow < TILE_ROWS; iTileRow++ )
+    {
+        int iRunStart = -1;
+        int iRunEnd = 0;
+        bool bRunOverlay = false;
+
+        for ( int iTileColumn = 0; iTileColumn <= TILE_COLUMNS; iTileColumn++ )
+        {
+            bool bChanged = false;
+            bool bOverlay = false;
+            int iFirstColumn = iTileColumn * TILE_SIZE;
+            int iLastColumn = iFirstColumn + TILE_SIZE - 1;
+
+            if ( ( TILE_COLUMNS > iTileColumn ) && m_abDirtyTiles[ iTileRow ][ iTileColumn ] )
+            {
+                bOverlay = bBlendTile( iTileColumn, iTileRow )
+                           && ( DisplayBackend::ePixelFormat_RGB565 != m_eCameraPixelFormat );
+                m_abDirtyTiles[ iTileRow ][ iTileColumn ] = false;
+                bChanged = m_bRepaint || bTileChanged( iTileColumn, iTileRow, iFirstColumn, iLastColumn );
+            }
+
+            if ( ( 0 <= iRunStart ) && ( !bChanged || ( bOverlay != bRunOverlay ) ) )
+            {
+                xDisplayRegion_t xRun = { iRunStart, iTileRow * TILE_SIZE, iRunEnd - iRunStart, TILE_SIZE };
+
+                if ( bRunOverlay )
+                {
+                    m_axOverlayRuns.push_back( xRun );
+                }
+                else
+                {
+                    m_axCameraRuns.push_back( xRun );
+                }
+
+                iRunStart = -1;
+            }
+
+            if ( bChanged && ( 0 > iRunStart ) )
+            {
+                iRunStart = iFirstColumn;
+                bRunOverlay = bOverlay;
+            }
+
+            if ( bChanged )
+            {
+                iRunEnd = iLastColumn + 1;
+            }
+        }
+    }
+
+    m_bRepaint = false;
+
+    if ( m_pBackend->eGetPixelFormat() == m_eCameraPixelFormat )
+    {
+        vPushRuns( m_axCameraRuns, m_eCameraPixelFormat );
+        vPushRuns( m_axOverlayRuns, DisplayBackend::ePixelFormat_RGB565 );
+    }
+    else
+    {
+        vPushRuns( m_axOverlayRuns, DisplayBackend::ePixelFormat_RGB565 );
+        vPushRuns( m_axCameraRuns, m_eCameraPixelFormat );
+    }
+
+    /* The panel moves its picture once the columns the scroll exposes have been written, so they come into view
+     * already drawn. */
+    if ( m_bScrollPending )
+    {
+        m_pBackend->vScroll( m_xScrollArea );
+        m_bScrollPending = false;
+    }
+
+    /* Only frames that actually put something on the wire count towards the frame rate. */
+    if ( ulTransfers != m_pBackend->xGetStatistics().ulTransfers )
+    {
+        m_pBackend->vEndFrame();
+        vUpdateStatistics( true, m_pBackend->ullGetTotalBytes() - ullFrameBytes );
+    }
+    else
+    {
+        vUpdateStatistics( false, 0 );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+double DisplayCompositor::dGetFramesPerSecond() const
+{
+    return m_dFramesPerSecond;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+double DisplayCompositor::dGetBytesPerSecond() const
+{
+    return m_dBytesPerSecond;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long DisplayCompositor::ulGetFramesPushed() const
+{
+    return ( nullptr != m_pBackend ) ? m_pBackend->xGetStatistics().ulFrames : 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long long DisplayCompositor::ullGetBytesPushed() const
+{
+    return ( nullptr != m_pBackend ) ? m_pBackend->ullGetTotalBytes() : 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint16_t DisplayCompositor::usRGB565( uint8_t ucRed, uint8_t ucGreen, uint8_t ucBlue )
+{
+    return static_cast<uint16_t>( ( ( ucRed & 0xF8 ) << 8 ) | ( ( ucGreen & 0xFC ) << 3 ) | ( ucBlue >> 3 ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+uint16_t DisplayCompositor::usBlendRGB565( uint16_t usForeground, uint16_t usBackground, uint8_t ucAlpha )
+{
+    /* Spread the channels apart so all three can be blended with a single multiply. */
+    uint32_t ulAlpha = ( ucAlpha + 4 ) >> 3;
+    uint32_t ulForeground = ( usForeground | ( usForeground << 16 ) ) & 0x07E0F81F;
+    uint32_t ulBackground = ( usBackground | ( usBackground << 16 ) ) & 0x07E0F81F;
+    uint32_t ulResult = ( ( ( ( ulForeground - ulBackground ) * ulAlpha ) >> 5 ) + ulBackground ) & 0x07E0F81F;
+
+    return static_cast<uint16_t>( ulResult | ( ulResult >> 16 ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vMarkDirty( const xDisplayRegion_t & xRegion )
+{
+    int iFirstColumn = xRegion.iX / TILE_SIZE;
+    int iLastColumn = ( xRegion.iX + xRegion.iWidth - 1 ) / TILE_SIZE;
+    int iFirstRow = xRegion.iY / TILE_SIZE;
+    int iLastRow = ( xRegion.iY + xRegion.iHeight - 1 ) / TILE_SIZE;
+
+    for ( int iTileRow = iFirstRow; iTileRow <= iLastRow; iTileRow++ )
+    {
+        for ( int iTileColumn = iFirstColumn; iTileColumn <= iLastColumn; iTileColumn++ )
+        {
+            m_abDirtyTiles[ iTileRow ][ iTileColumn ] = true;
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vExtendOverlayBounds( const xDisplayRegion_t & xRegion )
+{
+    if ( m_bHasOverlayContent )
+    {
+        int iStartX = std::min( m_xOverlayBounds.iX, xRegion.iX );
+        int iStartY = std::min( m_xOverlayBounds.iY, xRegion.iY );
+        int iEndX = std::max( m_xOverlayBounds.iX + m_xOverlayBounds.iWidth, xRegion.iX + xRegion.iWidth );
+        int iEndY = std::max( m_xOverlayBounds.iY + m_xOverlayBounds.iHeight, xRegion.iY + xRegion.iHeight );
+
+        m_xOverlayBounds = { iStartX, iStartY, iEndX - iStartX, iEndY - iStartY };
+    }
+    else
+    {
+        m_xOverlayBounds = xRegion;
+        m_bHasOverlayContent = true;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayCompositor::bBlendTile( int iTileColumn, int iTileRow )
+{
+    bool bOverlay = false;
+
+    for ( int iY = iTileRow * TILE_SIZE; iY < ( iTileRow + 1 ) * TILE_SIZE; iY++ )
+    {
+        for ( int iX = iTileColumn * TILE_SIZE; iX < ( iTileColumn + 1 ) * TILE_SIZE; iX++ )
+        {
+            int iPixel = iY * DISPLAY_WIDTH + iX;
+            uint8_t ucAlpha = m_aucOverlayAlpha[ iPixel ];
+
+            bOverlay = bOverlay || ( 0x00 != ucAlpha );
+
+            if ( 0x00 == ucAlpha )
+            {
+                m_ausBackBuffer[ iPixel ] = m_ausCameraLayer[ iPixel ];
+            }
+            else if ( 0xFF == ucAlpha )
+            {
+                m_ausBackBuffer[ iPixel ] = m_ausOverlayLayer[ iPixel ];
+            }
+            else
+            {
+                m_ausBackBuffer[ iPixel ] = usBlendRGB565( m_ausOverlayLayer[ iPixel ], m_ausCameraLayer[ iPixel ],
+                                                           ucAlpha );
+            }
+        }
+    }
+
+    return bOverlay;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool DisplayCompositor::bTileChanged( int iTileColumn, int iTileRow, int & iFirstColumn, int & iLastColumn ) const
+{
+    int iLeft = iTileColumn * TILE_SIZE;
+    int iRight = iLeft + TILE_SIZE - 1;
+
+    iFirstColumn = iRight + 1;
+    iLastColumn = iLeft - 1;
+
+    /* Narrow the columns that changed down row by row, stopping once they span the whole tile. */
+    for ( int iY = iTileRow * TILE_SIZE; ( iY < ( iTileRow + 1 ) * TILE_SIZE )
+                                         && ( ( iLeft < iFirstColumn ) || ( iRight > iLastColumn ) ); iY++ )
+    {
+        const uint16_t * pusBack = &m_ausBackBuffer[ iY * DISPLAY_WIDTH ];
+        const uint16_t * pusFront = &m_ausFrontBuffer[ iY * DISPLAY_WIDTH ];
+
+        if ( 0 != memcmp( &pusBack[ iLeft ], &pusFront[ iLeft ], TILE_SIZE * sizeof( uint16_t ) ) )
+        {
+            for ( int iX = iLeft; iX < iFirstColumn; iX++ )
+            {
+                if ( pusBack[ iX ] != pusFront[ iX ] )
+                {
+                    iFirstColumn = iX;
+                    break;
+                }
+            }
+
+            for ( int iX = iRight; iX > iLastColumn; iX-- )
+            {
+                if ( pusBack[ iX ] != pusFront[ iX ] )
+                {
+                    iLastColumn = iX;
+                    break;
+                }
+            }
+        }
+    }
+
+    return ( iFirstColumn <= iLastColumn );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vPushRuns( const std::vector<xDisplayRegion_t> & axRuns, ePixelFormat_t ePixelFormat )
+{
+    if ( !axRuns.empty() )
+    {
+        ( void )m_pBackend->bSetPixelFormat( ePixelFormat, m_bCameraDither );
+
+        for ( const xDisplayRegion_t & xRun : axRuns )
+        {
+            vPushRegion( xRun );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vPushRegion( const xDisplayRegion_t & xRegion )
+{
+    int iOffset = xRegion.iY * DISPLAY_WIDTH + xRegion.iX;
+    int iAreaEnd = m_xScrollArea.iX + m_xScrollArea.iWidth;
+    int iX = xRegion.iX;
+    int iEnd = xRegion.iX + xRegion.iWidth;
+
+    /* Record what the panel will show once the region has been transferred. */
+    for ( int iY = 0; iY < xRegion.iHeight; iY++ )
+    {
+        memcpy( &m_ausFrontBuffer[ iOffset + iY * DISPLAY_WIDTH ], &m_ausBackBuffer[ iOffset + iY * DISPLAY_WIDTH ],
+                xRegion.iWidth * sizeof( uint16_t ) );
+    }
+
+    /* Within a scrolled area the panel shows its memory rotated, so a region goes where the rotation has taken its
+     * columns, in two pieces where it wraps round; outside it, and unscrolled, display and panel columns agree. */
+    while ( iX < iEnd )
+    {
+        int iPanelX = iX;
+        int iPieceEnd = iEnd;
+
+        if ( ( 0 != m_xScrollArea.iOffset ) && ( iX < m_xScrollArea.iX ) )
+        {
+            iPieceEnd = std::min( iEnd, m_xScrollArea.iX );
+        }
+        else if ( ( 0 != m_xScrollArea.iOffset ) && ( iX < iAreaEnd ) )
+        {
+            iPanelX = m_xScrollArea.iX + ( iX - m_xScrollArea.iX + m_xScrollArea.iOffset ) % m_xScrollArea.iWidth;
+            iPieceEnd = std::min( std::min( iEnd, iAreaEnd ), iX + iAreaEnd - iPanelX );
+        }
+
+        m_pBackend->vPushRegion( { iPanelX, xRegion.iY, iPieceEnd - iX, xRegion.iHeight },
+                                 &m_ausBackBuffer[ xRegion.iY * DISPLAY_WIDTH + iX ], DISPLAY_WIDTH );
+        iX = iPieceEnd;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void DisplayCompositor::vUpdateStatistics( bool bPushed, unsigned long long ullFrameBytes )
+{
+    std::chrono::steady_clock::time_point xNow = std::chrono::steady_clock::now();
+    double dElapsed = std::chrono::duration<double>( xNow - m_xWindowStart ).count();
+
+    if ( bPushed )
+    {
+        m_ulWindowFrames++;
+        m_ullWindowBytes += ullFrameBytes;
+    }
+
+    /* Roll the measurement window roughly once per second. */
+    if ( 1.0 <= dElapsed )
+    {
+        m_dFramesPerSecond = m_ulWindowFrames / dElapsed;
+        m_dBytesPerSecond = m_ullWindowBytes / dElapsed;
+        m_xWindowStart = xNow;
+        m_ulWindowFrames = 0;
+        m_ullWindowBytes = 0;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
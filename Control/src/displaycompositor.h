@@ -0,0 +1,107 @@
+#ifndef DISPLAYCOMPOSITOR_H
+#define DISPLAYCOMPOSITOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "displaybackend.h"
+
+class DisplayCompositor
+{
+public:
+    static const int DISPLAY_WIDTH = DisplayBackend::DISPLAY_WIDTH;
+    static const int DISPLAY_HEIGHT = DisplayBackend::DISPLAY_HEIGHT;
+    static const int TILE_SIZE = 16;
+    static const int TILE_COLUMNS = DISPLAY_WIDTH / TILE_SIZE;
+    static const int TILE_ROWS = DISPLAY_HEIGHT / TILE_SIZE;
+
+    typedef DisplayBackend::xDisplayRegion_t xDisplayRegion_t;
+    typedef DisplayBackend::ePixelFormat_t ePixelFormat_t;
+    typedef DisplayBackend::xScrollArea_t xScrollArea_t;
+
+    DisplayCompositor();
+
+    bool bInit( DisplayBackend * pBackend );
+    DisplayBackend * pGetBackend() const;
+    bool bSetCameraPixelFormat( ePixelFormat_t ePixelFormat, bool bDither );
+    ePixelFormat_t eGetCameraPixelFormat() const;
+
+    void vSetCameraFrame( const uint16_t * pusFrame, int iWidth, int iHeight );
+    void vDrawCameraBox( int iX, int iY, int iWidth, int iHeight, uint16_t usColor );
+    void vClearCamera();
+
+    void vClearOverlay();
+    void vDrawText( int iX, int iY, const char * pcText, uint16_t usColor );
+    void vFillOverlay( int iX, int iY, int iWidth, int iHeight, uint16_t usColor );
+
+    /* Hardware scrolling, where the backend has it: columns [iX, iX + iWidth) move sideways together and the rest
+     * stay put. vScroll() moves what the panel shows there iPixels to the left (to the right if negative) with the
+     * next frame, so content redrawn that much further along only has the columns it exposes left to push. */
+    bool bCanScroll() const;
+    bool bSetScrollArea( int iX, int iWidth );
+    void vScroll( int iPixels );
+
+    /* Forgets what the panel shows, so the next frame pushes all of it. */
+    void vInvalidate();
+
+    void vCompose();
+
+    double dGetFramesPerSecond() const;
+    double dGetBytesPerSecond() const;
+    unsigned long ulGetFramesPushed() const;
+    unsigned long long ullGetBytesPushed() const;
+
+    static uint16_t usRGB565( uint8_t ucRed, uint8_t ucGreen, uint8_t ucBlue );
+    static uint16_t usBlendRGB565( uint16_t usForeground, uint16_t usBackground, uint8_t ucAlpha );
+
+private:
+    /* Alpha applied to the glyph cell background so overlay text stays legible on top of the camera feed. */
+    static const uint8_t OVERLAY_TEXT_BACKGROUND_ALPHA = 160;
+
+    std::vector<uint16_t> m_ausCameraLayer;
+    std::vector<uint16_t> m_ausOverlayLayer;
+    std::vector<uint8_t> m_aucOverlayAlpha;
+    std::vector<uint16_t> m_ausBackBuffer;
+    std::vector<uint16_t> m_ausFrontBuffer;
+
+    /* Where the last camera frame was placed, so marks on it can be given in frame coordinates. */
+    int m_iCameraOffsetX;
+    int m_iCameraOffsetY;
+
+    DisplayBackend * m_pBackend;
+
+    /* Tiles with nothing of the overlay on them go out in the camera's pixel format, the rest as RGB565; each frame
+     * pushes the runs in the panel's current format first, so it switches at most once a frame. */
+    ePixelFormat_t m_eCameraPixelFormat;
+    bool m_bCameraDither;
+    std::vector<xDisplayRegion_t> m_axCameraRuns;
+    std::vector<xDisplayRegion_t> m_axOverlayRuns;
+
+    /* The scroll the panel is at, or will be at once the next frame has gone out, and whether to tell it; the front
+     * buffer always holds what it shows, in display columns. */
+    xScrollArea_t m_xScrollArea;
+    bool m_bScrollPending;
+    bool m_bRepaint;
+
+    bool m_abDirtyTiles[TILE_ROWS][TILE_COLUMNS];
+    bool m_bHasOverlayContent;
+    xDisplayRegion_t m_xOverlayBounds;
+
+    /* Sliding window used to derive the achieved frame rate and SPI bandwidth. */
+    std::chrono::steady_clock::time_point m_xWindowStart;
+    unsigned long m_ulWindowFrames;
+    unsigned long long m_ullWindowBytes;
+    double m_dFramesPerSecond;
+    double m_dBytesPerSecond;
+
+    void vMarkDirty( const xDisplayRegion_t & xRegion );
+    void vExtendOverlayBounds( const xDisplayRegion_t & xRegion );
+    bool bBlendTile( int iTileColumn, int iTileRow );
+    bool bTileChanged( int iTileColumn, int iTileRow, int & iFirstColumn, int & iLastColumn ) const;
+    void vPushRuns( const std::vector<xDisplayRegion_t> & axRuns, ePixelFormat_t ePixelFormat );
+    void vPushRegion( const xDisplayRegion_t & xRegion );
+    void vUpdateStatistics( bool bPushed, unsigned long long ullFrameBytes );
+};
+
+#endif // DISPLAYCOMPOSITOR_H
@@ -0,0 +1,373 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <QDebug>
+
+#include "flightrecorder.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const unsigned long long FlightRecorder::DEFAULT_CAPACITY_RECORDS;
+const int FlightRecorder::SYNC_INTERVAL_MS;
+const int FlightRecorder::PREVIOUS_RECORDINGS;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llRealtimeNanoseconds();
+static QString sPreviousRecordingPath( const QString & sPath, int iGeneration );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+FlightRecorder::FlightRecorder() : m_ullCommittedSequence( 0 )
+{
+    m_iDescriptor = -1;
+    m_pucMapping = nullptr;
+    m_ulMappingSize = 0;
+    m_ullCapacity = 0;
+    m_pxRecords = nullptr;
+    m_llCreatedNanoseconds = 0;
+    m_ullSyncedSequence = 0;
+    m_ullGeneration = 0;
+    m_bRotated = false;
+    m_bStopping = false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+FlightRecorder::~FlightRecorder()
+{
+    vClose();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool FlightRecorder::bOpen( const QString & sPath, unsigned long long ullCapacity )
+{
+    QByteArray NewPath = sPath.toLocal8Bit() + ".new";
+    void * pvMapping = MAP_FAILED;
+    int iError = 0;
+
+    vClose();
+
+    if ( 0 == ullCapacity )
+    {
+        return false;
+    }
+
+    /* Never overwrite an earlier recording; it may be the one holding a crash. The new recording only takes the
+     * place of the current one once it holds a record, so runs that recorded nothing, such as a boot loop, cannot
+     * rotate the earlier recordings away. */
+    m_ulMappingSize = HUDVIEW_FLIGHT_DATA_OFFSET + ullCapacity * HUDVIEW_FLIGHT_RECORD_SIZE;
+    m_iDescriptor = open( NewPath.constData(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+
+    if ( 0 > m_iDescriptor )
+    {
+        qDebug() << "Failed to create flight recording: " << sPath;
+        return false;
+    }
+
+    /* Allocate every block up front so a full card shows up now rather than as SIGBUS mid-ride. */
+    iError = posix_fallocate( m_iDescriptor, 0, static_cast<off_t>( m_ulMappingSize ) );
+
+    if ( 0 == iError )
+    {
+        pvMapping = mmap( nullptr, m_ulMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_iDescriptor, 0 );
+    }
+
+    if ( MAP_FAILED == pvMapping )
+    {
+        qDebug() << "Failed to allocate flight recording: " << sPath << strerror( ( 0 != iError ) ? iError : errno );
+        close( m_iDescriptor );
+        m_iDescriptor = -1;
+        return false;
+    }
+
+    m_sPath = sPath;
+    m_pucMapping = static_cast<uint8_t *>( pvMapping );
+    m_pxRecords = reinterpret_cast<xHUDViewFlightRecord_t *>( m_pucMapping + HUDVIEW_FLIGHT_DATA_OFFSET );
+    m_ullCapacity = ullCapacity;
+    m_llCreatedNanoseconds = llRealtimeNanoseconds();
+    m_ullCommittedSequence.store( 0 );
+    m_ullSyncedSequence = 0;
+    m_ullGeneration = 0;
+    m_bRotated = false;
+    m_bStopping = false;
+
+    /* Seed both header copies so the file is readable before the first sync. */
+    vWriteHeader();
+    vWriteHeader();
+    ( void )msync( m_pucMapping, HUDVIEW_FLIGHT_DATA_OFFSET, MS_SYNC );
+
+    m_SyncThread = std::thread( &FlightRecorder::vRunSyncThread, this );
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool FlightRecorder::bIsOpen() const
+{
+    return ( nullptr != m_pucMapping );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vClose()
+{
+    if ( !bIsOpen() )
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock( m_SyncMutex );
+        m_bStopping = true;
+    }
+
+    m_SyncCondition.notify_all();
+
+    if ( m_SyncThread.joinable() )
+    {
+        m_SyncThread.join();
+    }
+
+    /* Make everything recorded so far durable before letting go of the mapping. */
+    vSync();
+
+    munmap( m_pucMapping, m_ulMappingSize );
+    close( m_iDescriptor );
+    m_pucMapping = nullptr;
+    m_pxRecords = nullptr;
+    m_iDescriptor = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vRecordAccelerometer( double dX, double dY, double dZ )
+{
+    xHUDViewFlightRecord_t * pxRecord = pxBeginRecord( eHUDViewFlightRecordType_Accelerometer );
+
+    if ( nullptr != pxRecord )
+    {
+        pxRecord->xData.xAccelerometer.fX = static_cast<float>( dX );
+        pxRecord->xData.xAccelerometer.fY = static_cast<float>( dY );
+        pxRecord->xData.xAccelerometer.fZ = static_cast<float>( dZ );
+        vCommitRecord( pxRecord );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection )
+{
+    xHUDViewFlightRecord_t * pxRecord = pxBeginRecord( eHUDViewFlightRecordType_GPS );
+
+    if ( nullptr != pxRecord )
+    {
+        pxRecord->xData.xGPS.dLatitude = dLatitude;
+        pxRecord->xData.xGPS.dLongitude = dLongitude;
+        pxRecord->xData.xGPS.fSpeed = static_cast<float>( dSpeed );
+        pxRecord->xData.xGPS.fDirection = static_cast<float>( dDirection );
+        pxRecord->xData.xGPS.ucHasFix = bHasFix ? 1 : 0;
+        vCommitRecord( pxRecord );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vRecordLightSensor( long lLux )
+{
+    xHUDViewFlightRecord_t * pxRecord = pxBeginRecord( eHUDViewFlightRecordType_LightSensor );
+
+    if ( nullptr != pxRecord )
+    {
+        pxRecord->xData.xLightSensor.lLux = static_cast<int32_t>( lLux );
+        vCommitRecord( pxRecord );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vRecordButtonPress( unsigned long ulPresses )
+{
+    xHUDViewFlightRecord_t * pxRecord = pxBeginRecord( eHUDViewFlightRecordType_ButtonPress );
+
+    if ( nullptr != pxRecord )
+    {
+        pxRecord->xData.xButtonPress.ulPresses = static_cast<uint32_t>( ulPresses );
+        vCommitRecord( pxRecord );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vSync()
+{
+    std::lock_guard<std::mutex> Lock( m_SyncMutex );
+
+    vSyncLocked();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long long FlightRecorder::ullGetRecordsWritten() const
+{
+    return m_ullCommittedSequence.load( std::memory_order_relaxed );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+xHUDViewFlightRecord_t * FlightRecorder::pxBeginRecord( eHUDViewFlightRecordType_t eType )
+{
+    xHUDViewFlightRecord_t * pxRecord = nullptr;
+    uint64_t ullSequence = 0;
+
+    if ( bIsOpen() )
+    {
+        ullSequence = m_ullCommittedSequence.load( std::memory_order_relaxed ) + 1;
+        pxRecord = &m_pxRecords[ ( ullSequence - 1 ) % m_ullCapacity ];
+
+        /* Records are plain stores into the mapping; nothing here enters the kernel. */
+        memset( pxRecord, 0, sizeof( xHUDViewFlightRecord_t ) );
+        pxRecord->ullSequence = ullSequence;
+        pxRecord->llTimestampNanoseconds = llRealtimeNanoseconds();
+        pxRecord->usType = static_cast<uint16_t>( eType );
+    }
+
+    return pxRecord;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vCommitRecord( xHUDViewFlightRecord_t * pxRecord )
+{
+    pxRecord->ulChecksum = ulHUDViewFlightRecordChecksum( pxRecord );
+    m_ullCommittedSequence.store( pxRecord->ullSequence, std::memory_order_release );
+
+    /* The first record makes this recording worth keeping, so have it rotated in now rather than at the next sync. */
+    if ( 1 == pxRecord->ullSequence )
+    {
+        m_SyncCondition.notify_one();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vSyncRecords( uint64_t ullFirstSequence, uint64_t ullLastSequence )
+{
+    const uintptr_t ulPageSize = static_cast<uintptr_t>( sysconf( _SC_PAGESIZE ) );
+    uint64_t ullFirstSlot = ( ullFirstSequence - 1 ) % m_ullCapacity;
+    uint64_t ullLastSlot = ( ullLastSequence - 1 ) % m_ullCapacity;
+    uintptr_t ulStart = 0;
+    uintptr_t ulEnd = 0;
+
+    /* More than a full lap since the last sync means every slot is dirty. */
+    if ( ( ullLastSequence - ullFirstSequence + 1 ) >= m_ullCapacity )
+    {
+        ullFirstSlot = 0;
+        ullLastSlot = m_ullCapacity - 1;
+    }
+    else if ( ullLastSlot < ullFirstSlot )
+    {
+        /* The dirty range wraps around the end of the file; sync the tail first. */
+        vSyncRecords( ullFirstSequence, ullFirstSequence + ( m_ullCapacity - 1 - ullFirstSlot ) );
+        ullFirstSlot = 0;
+    }
+
+    ulStart = reinterpret_cast<uintptr_t>( &m_pxRecords[ ullFirstSlot ] ) & ~( ulPageSize - 1 );
+    ulEnd = reinterpret_cast<uintptr_t>( &m_pxRecords[ ullLastSlot + 1 ] );
+    ( void )msync( reinterpret_cast<void *>( ulStart ), ulEnd - ulStart, MS_SYNC );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vSyncLocked()
+{
+    uint64_t ullCommitted = m_ullCommittedSequence.load( std::memory_order_acquire );
+
+    if ( ullCommitted == m_ullSyncedSequence )
+    {
+        return;
+    }
+
+    /* Records reach storage before the header claims them, so the header never points past durable data. */
+    vSyncRecords( m_ullSyncedSequence + 1, ullCommitted );
+    m_ullSyncedSequence = ullCommitted;
+    vWriteHeader();
+    ( void )msync( m_pucMapping, HUDVIEW_FLIGHT_DATA_OFFSET, MS_SYNC );
+
+    if ( !m_bRotated )
+    {
+        vRotateLocked();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vRotateLocked()
+{
+    QByteArray NewPath = m_sPath.toLocal8Bit() + ".new";
+
+    m_bRotated = true;
+
+    /* Renaming leaves the open mapping alone, so recording carries on into the same file under its final name. */
+    for ( int iGeneration = PREVIOUS_RECORDINGS; iGeneration > 0; iGeneration-- )
+    {
+        QString sFrom = ( 1 == iGeneration ) ? m_sPath : sPreviousRecordingPath( m_sPath, iGeneration - 1 );
+
+        if ( ( 0 != rename( sFrom.toLocal8Bit().constData(),
+                            sPreviousRecordingPath( m_sPath, iGeneration ).toLocal8Bit().constData() ) )
+             && ( ENOENT != errno ) )
+        {
+            qDebug() << "Failed to preserve previous flight recording: " << sFrom;
+        }
+    }
+
+    if ( 0 != rename( NewPath.constData(), m_sPath.toLocal8Bit().constData() ) )
+    {
+        qDebug() << "Failed to rotate in flight recording: " << m_sPath << strerror( errno );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vWriteHeader()
+{
+    xHUDViewFlightHeader_t xHeader;
+
+    memset( &xHeader, 0, sizeof( xHeader ) );
+    m_ullGeneration++;
+    xHeader.ulMagic = HUDVIEW_FLIGHT_MAGIC;
+    xHeader.ulVersion = HUDVIEW_FLIGHT_VERSION;
+    xHeader.ulRecordSize = HUDVIEW_FLIGHT_RECORD_SIZE;
+    xHeader.ulDataOffset = HUDVIEW_FLIGHT_DATA_OFFSET;
+    xHeader.ullCapacity = m_ullCapacity;
+    xHeader.llCreatedNanoseconds = m_llCreatedNanoseconds;
+    xHeader.ullGeneration = m_ullGeneration;
+    xHeader.ullSyncedSequence = m_ullSyncedSequence;
+    xHeader.llSyncedNanoseconds = llRealtimeNanoseconds();
+    xHeader.ulChecksum = ulHUDViewFlightHeaderChecksum( &xHeader );
+
+    /* Alternate between the copies so the one not being written is always intact. */
+    memcpy( m_pucMapping + ( m_ullGeneration % HUDVIEW_FLIGHT_HEADER_COPIES ) * HUDVIEW_FLIGHT_HEADER_STRIDE,
+            &xHeader, sizeof( xHeader ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FlightRecorder::vRunSyncThread()
+{
+    std::unique_lock<std::mutex> Lock( m_SyncMutex );
+
+    /* msync() blocks on the SD card, so it is kept off the event loop entirely. */
+    while ( !m_bStopping )
+    {
+        /* A first record waiting to be rotated in is not left for the interval, even if it came before the wait. */
+        m_SyncCondition.wait_for( Lock, std::chrono::milliseconds( SYNC_INTERVAL_MS ), [this]() {
+            return m_bStopping || ( !m_bRotated && ( 0 != m_ullCommittedSequence.load( std::memory_order_acquire ) ) );
+        } );
+        vSyncLocked();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llRealtimeNanoseconds()
+{
+    struct timespec xNow;
+
+    /* Wall-clock time so a recording can be lined up with the moment of a crash. */
+    clock_gettime( CLOCK_REALTIME, &xNow );
+
+    return static_cast<int64_t>( xNow.tv_sec ) * 1000000000LL + xNow.tv_nsec;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static QString sPreviousRecordingPath( const QString & sPath, int iGeneration )
+{
+    return ( 1 == iGeneration ) ? sPath + ".prev" : sPath + ".prev." + QString::number( iGeneration );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,70 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <QString>
+
+#include "hudview_flightrecord.h"
+#include "telemetrysink.h"
+
+class FlightRecorder : public TelemetrySink
+{
+public:
+    /* Roughly ten minutes of accelerometer data at 800 Hz, in 32 MiB. */
+    static const unsigned long long DEFAULT_CAPACITY_RECORDS = 524288;
+    static const int SYNC_INTERVAL_MS = 1000;
+
+    /* Earlier recordings kept beside the current one, as <path>.prev, <path>.prev.2 and so on. */
+    static const int PREVIOUS_RECORDINGS = 3;
+
+    FlightRecorder();
+    ~FlightRecorder() override;
+
+    bool bOpen( const QString & sPath, unsigned long long ullCapacity = DEFAULT_CAPACITY_RECORDS );
+    bool bIsOpen() const override;
+    void vClose();
+
+    void vRecordAccelerometer( double dX, double dY, double dZ ) override;
+    void vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection ) override;
+    void vRecordLightSensor( long lLux ) override;
+    void vRecordButtonPress( unsigned long ulPresses ) override;
+
+    void vSync();
+    unsigned long long ullGetRecordsWritten() const;
+
+private:
+    QString m_sPath;
+    int m_iDescriptor;
+    uint8_t * m_pucMapping;
+    size_t m_ulMappingSize;
+    unsigned long long m_ullCapacity;
+    xHUDViewFlightRecord_t * m_pxRecords;
+    int64_t m_llCreatedNanoseconds;
+
+    /* Sequence of the newest complete record; only the event loop writes records, the sync thread only reads this. */
+    std::atomic<uint64_t> m_ullCommittedSequence;
+
+    /* Owned by whichever thread holds m_SyncMutex. */
+    uint64_t m_ullSyncedSequence;
+    uint64_t m_ullGeneration;
+    bool m_bRotated;
+
+    std::thread m_SyncThread;
+    std::mutex m_SyncMutex;
+    std::condition_variable m_SyncCondition;
+    bool m_bStopping;
+
+    xHUDViewFlightRecord_t * pxBeginRecord( eHUDViewFlightRecordType_t eType );
+    void vCommitRecord( xHUDViewFlightRecord_t * pxRecord );
+    void vSyncRecords( uint64_t ullFirstSequence, uint64_t ullLastSequence );
+    void vSyncLocked();
+    void vRotateLocked();
+    void vWriteHeader();
+    void vRunSyncThread();
+};
+
+#endif // FLIGHTRECORDER_H
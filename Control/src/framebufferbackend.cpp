@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "framebufferbackend.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vWriteBigEndian32( std::vector<uint8_t> & aucBuffer, uint32_t ulValue );
+static void vWritePNGChunk( FILE * pFile, const char * pcType, const std::vector<uint8_t> & aucData );
+static uint32_t ulCRC32( uint32_t ulCRC, const uint8_t * pucData, size_t ulLength );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+FramebufferDisplayBackend::FramebufferDisplayBackend() :
+    m_ausPixels( DISPLAY_WIDTH * DISPLAY_HEIGHT, 0 ),
+    m_aucPacked( HUDVIEW_RGB444_BYTES( DISPLAY_WIDTH * DISPLAY_HEIGHT ), 0 ),
+    m_ausUnpacked( DISPLAY_WIDTH * DISPLAY_HEIGHT, 0 )
+{
+    m_sDumpDirectory = "";
+    m_bDumpPNG = false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool FramebufferDisplayBackend::bInit()
+{
+    std::fill( m_ausPixels.begin(), m_ausPixels.end(), 0 );
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FramebufferDisplayBackend::vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels,
+                                             int iStride )
+{
+    unsigned long long ullPixelBytes = xRegion.iWidth * xRegion.iHeight * sizeof( uint16_t );
+    const uint16_t * pusSource = pusPixels;
+    int iSourceStride = iStride;
+
+    ( void )bSwitchPixelFormat();
+
+    if ( ePixelFormat_RGB444 == m_ePixelFormat )
+    {
+        ullPixelBytes = ulHUDViewRGB444Pack( &m_xPacker, pusPixels, iStride, xRegion.iX, xRegion.iY, xRegion.iWidth,
+                                             xRegion.iHeight, m_aucPacked.data() );
+        vHUDViewRGB444Unpack( m_aucPacked.data(), xRegion.iWidth * xRegion.iHeight, m_ausUnpacked.data() );
+        pusSource = m_ausUnpacked.data();
+        iSourceStride = xRegion.iWidth;
+    }
+
+    for ( int iY = 0; iY < xRegion.iHeight; iY++ )
+    {
+        memcpy( &m_ausPixels[ ( xRegion.iY + iY ) * DISPLAY_WIDTH + xRegion.iX ], &pusSource[ iY * iSourceStride ],
+                xRegion.iWidth * sizeof( uint16_t ) );
+    }
+
+    /* Account for the traffic the real panel would have seen. */
+    vCountTransfer( REGION_COMMAND_OVERHEAD_BYTES, ullPixelBytes );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FramebufferDisplayBackend::vEndFrame()
+{
+    char acName[ 32 ];
+
+    DisplayBackend::vEndFrame();
+
+    if ( !m_sDumpDirectory.empty() )
+    {
+        snprintf( acName, sizeof( acName ), "/frame_%06lu.%s", m_xStatistics.ulFrames, m_bDumpPNG ? "png" : "ppm" );
+
+        if ( m_bDumpPNG )
+        {
+            ( void )bWritePNG( m_sDumpDirectory + acName );
+        }
+        else
+        {
+            ( void )bWritePPM( m_sDumpDirectory + acName );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * FramebufferDisplayBackend::pcGetName() const
+{
+    return "framebuffer";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool FramebufferDisplayBackend::bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const
+{
+    return ( ePixelFormat_RGB565 == ePixelFormat ) || ( ePixelFormat_RGB444 == ePixelFormat );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool FramebufferDisplayBackend::bSupportsScroll() const
+{
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FramebufferDisplayBackend::vScroll( const xScrollArea_t & xArea )
+{
+    ( void )bSwitchScrollArea( xArea );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FramebufferDisplayBackend::vSetDumpDirectory( const std::string & sDirectory, bool bPNG )
+{
+    m_sDumpDirectory = sDirectory;
+    m_bDumpPNG = bPNG;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const uint16_t * FramebufferDisplayBackend::pusGetPixels() const
+{
+    return m_ausPixels.data();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool FramebufferDisplayBackend::bWritePPM( const std::string & sPath ) const
+{
+    std::vector<uint8_t> aucRGB;
+    FILE * pFile = fopen( sPath.c_str(), "wb" );
+    bool bReturn = false;
+
+    if ( nullptr != pFile )
+    {
+        vToRGB888( aucRGB );
+        fprintf( pFile, "P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT );
+        bReturn = ( aucRGB.size() == fwrite( aucRGB.data(), 1, aucRGB.size(), pFile ) );
+        fclose( pFile );
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool FramebufferDisplayBackend::bWritePNG( const std::string & sPath ) const
+{
+    static const uint8_t aucSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    const size_t ulRowBytes = DISPLAY_WIDTH * 3;
+    std::vector<uint8_t> aucRGB;
+    std::vector<uint8_t> aucRaw;
+    std::vector<uint8_t> aucHeader;
+    std::vector<uint8_t> aucData;
+    uint32_t ulAdlerA = 1;
+    uint32_t ulAdlerB = 0;
+    FILE * pFile = fopen( sPath.c_str(), "wb" );
+    bool bReturn = false;
+
+    if ( nullptr != pFile )
+    {
+        vToRGB888( aucRGB );
+
+        /* Every scanline is prefixed with filter type 0 (none). */
+        for ( int iY = 0; iY < DISPLAY_HEIGHT; iY++ )
+        {
+            aucRaw.push_back( 0x00 );
+            aucRaw.insert( aucRaw.end(), aucRGB.begin() + iY * ulRowBytes, aucRGB.begin() + ( iY + 1 ) * ulRowBytes );
+        }
+
+        vWriteBigEndian32( aucHeader, DISPLAY_WIDTH );
+        vWriteBigEndian32( aucHeader, DISPLAY_HEIGHT );
+        aucHeader.insert( aucHeader.end(), { 8, 2, 0, 0, 0 } );
+
+        /* Wrap the scanlines in a zlib stream made of uncompressed deflate blocks, so no codec is needed. */
+        aucData.insert( aucData.end(), { 0x78, 0x01 } );
+
+        for ( size_t ulOffset = 0; ulOffset < aucRaw.size(); ulOffset += 0xFFFF )
+        {
+            size_t ulLength = std::min<size_t>( 0xFFFF, aucRaw.size() - ulOffset );
+
+            aucData.push_back( ( ulOffset + ulLength == aucRaw.size() ) ? 0x01 : 0x00 );
+            aucData.push_back( static_cast<uint8_t>( ulLength & 0xFF ) );
+            aucData.push_back( static_cast<uint8_t>( ulLength >> 8 ) );
+            aucData.push_back( static_cast<uint8_t>( ~ulLength & 0xFF ) );
+            aucData.push_back( static_cast<uint8_t>( ( ~ulLength >> 8 ) & 0xFF ) );
+            aucData.insert( aucData.end(), aucRaw.begin() + ulOffset, aucRaw.begin() + ulOffset + ulLength );
+        }
+
+        for ( uint8_t ucByte : aucRaw )
+        {
+            ulAdlerA = ( ulAdlerA + ucByte ) % 65521;
+            ulAdlerB = ( ulAdlerB + ulAdlerA ) % 65521;
+        }
+
+        vWriteBigEndian32( aucData, ( ulAdlerB << 16 ) | ulAdlerA );
+
+        fwrite( aucSignature, 1, sizeof( aucSignature ), pFile );
+        vWritePNGChunk( pFile, "IHDR", aucHeader );
+        vWritePNGChunk( pFile, "IDAT", aucData );
+        vWritePNGChunk( pFile, "IEND", std::vector<uint8_t>() );
+        bReturn = ( 0 == ferror( pFile ) );
+        fclose( pFile );
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void FramebufferDisplayBackend::vToRGB888( std::vector<uint8_t> & aucRGB ) const
+{
+    aucRGB.resize( m_ausPixels.size() * 3 );
+
+    /* Expand each channel, replicating the high bits so that full intensity maps to 255. */
+    for ( size_t ulPixel = 0; ulPixel < m_ausPixels.size(); ulPixel++ )
+    {
+        int iX = static_cast<int>( ulPixel % DISPLAY_WIDTH );
+        int iY = static_cast<int>( ulPixel / DISPLAY_WIDTH );
+
+        /* What the panel shows at a column of the scrolling area comes from its memory, offset columns on. */
+        if ( ( m_xScrollArea.iX <= iX ) && ( m_xScrollArea.iX + m_xScrollArea.iWidth > iX ) )
+        {
+            iX = m_xScrollArea.iX + ( iX - m_xScrollArea.iX + m_xScrollArea.iOffset ) % m_xScrollArea.iWidth;
+        }
+
+        uint16_t usPixel = m_ausPixels.at( iY * DISPLAY_WIDTH + iX );
+        uint8_t ucRed = static_cast<uint8_t>( ( usPixel >> 11 ) & 0x1F );
+        uint8_t ucGreen = static_cast<uint8_t>( ( usPixel >> 5 ) & 0x3F );
+        uint8_t ucBlue = static_cast<uint8_t>( usPixel & 0x1F );
+
+        aucRGB[ ulPixel * 3 + 0 ] = static_cast<uint8_t>( ( ucRed << 3 ) | ( ucRed >> 2 ) );
+        aucRGB[ ulPixel * 3 + 1 ] = static_cast<uint8_t>( ( ucGreen << 2 ) | ( ucGreen >> 4 ) );
+        aucRGB[ ulPixel * 3 + 2 ] = static_cast<uint8_t>( ( ucBlue << 3 ) | ( ucBlue >> 2 ) );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vWriteBigEndian32( std::vector<uint8_t> & aucBuffer, uint32_t ulValue )
+{
+    aucBuffer.push_back( static_cast<uint8_t>( ulValue >> 24 ) );
+    aucBuffer.push_back( static_cast<uint8_t>( ulValue >> 16 ) );
+    aucBuffer.push_back( static_cast<uint8_t>( ulValue >> 8 ) );
+    aucBuffer.push_back( static_cast<uint8_t>( ulValue ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vWritePNGChunk( FILE * pFile, const char * pcType, const std::vector<uint8_t> & aucData )
+{
+    std::vector<uint8_t> aucChunk;
+    uint32_t ulCRC = 0;
+
+    vWriteBigEndian32( aucChunk, static_cast<uint32_t>( aucData.size() ) );
+    aucChunk.insert( aucChunk.end(), pcType, pcType + 4 );
+    aucChunk.insert( aucChunk.end(), aucData.begin(), aucData.end() );
+
+    /* The CRC covers the chunk type and data, but not the length. */
+    ulCRC = ulCRC32( 0, &aucChunk[ 4 ], aucChunk.size() - 4 );
+    vWriteBigEndian32( aucChunk, ulCRC );
+
+    fwrite( aucChunk.data(), 1, aucChunk.size(), pFile );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t ulCRC32( uint32_t ulCRC, const uint8_t * pucData, size_t ulLength )
+{
+    ulCRC = ~ulCRC;
+
+    for ( size_t ulByte = 0; ulByte < ulLength; ulByte++ )
+    {
+        ulCRC ^= pucData[ ulByte ];
+
+        for ( int iBit = 0; iBit < 8; iBit++ )
+        {
+            ulCRC = ( ulCRC >> 1 ) ^ ( 0xEDB88320 & ( 0 - ( ulCRC & 1 ) ) );
+        }
+    }
+
+    return ~ulCRC;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
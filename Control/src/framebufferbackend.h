@@ -0,0 +1,43 @@
+#ifndef FRAMEBUFFERBACKEND_H
+#define FRAMEBUFFERBACKEND_H
+
+#include <string>
+#include <vector>
+
+#include "displaybackend.h"
+
+class FramebufferDisplayBackend : public DisplayBackend
+{
+public:
+    FramebufferDisplayBackend();
+
+    bool bInit() override;
+    void vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride ) override;
+    void vEndFrame() override;
+    const char * pcGetName() const override;
+    bool bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const override;
+    bool bSupportsScroll() const override;
+    void vScroll( const xScrollArea_t & xArea ) override;
+
+    void vSetDumpDirectory( const std::string & sDirectory, bool bPNG );
+    /* The panel's memory; within a scrolled area the picture shows it rotated, as the dumps do. */
+    const uint16_t * pusGetPixels() const;
+    /* What the panel shows, as 8-bit RGB. */
+    void vToRGB888( std::vector<uint8_t> & aucRGB ) const;
+
+    bool bWritePPM( const std::string & sPath ) const;
+    bool bWritePNG( const std::string & sPath ) const;
+
+protected:
+    std::vector<uint16_t> m_ausPixels;
+
+private:
+    /* 12-bit regions are packed as for the panel and unpacked again, so the framebuffer shows what the panel would. */
+    std::vector<uint8_t> m_aucPacked;
+    std::vector<uint16_t> m_ausUnpacked;
+
+    std::string m_sDumpDirectory;
+    bool m_bDumpPNG;
+};
+
+#endif // FRAMEBUFFERBACKEND_H
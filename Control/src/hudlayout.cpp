@@ -0,0 +1,37 @@
+#include "hudlayout.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const int HUDLayout::READING_X;
+const int HUDLayout::READING_Y;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void HUDLayout::vDrawSplash( DisplayCompositor & Compositor )
+{
+    uint16_t usColor = DisplayCompositor::usRGB565( 255, 255, 255 );
+
+    Compositor.vDrawText( 42, 24, "HUD", usColor );
+    Compositor.vDrawText( 30, 62, "View", usColor );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void HUDLayout::vDrawReading( DisplayCompositor & Compositor, int iX, const char * pcText, uint16_t usColor )
+{
+    Compositor.vDrawText( iX, READING_Y, pcText, usColor );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void HUDLayout::vDrawRearAlert( DisplayCompositor & Compositor )
+{
+    /* Something closing in from behind takes priority over the light level: always bright red, beneath the reading. */
+    Compositor.vDrawText( 17, 88, "REAR!", DisplayCompositor::usRGB565( 255, 0, 0 ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void HUDLayout::vDrawHeadlightMarker( DisplayCompositor & Compositor, const xHUDViewHeadlightsMarker_t & xMarker )
+{
+    /* Leave a little room around the vehicle's lights. */
+    Compositor.vDrawCameraBox( xMarker.iX - 2, xMarker.iY - 2, xMarker.iWidth + 4, xMarker.iHeight + 4,
+                               xMarker.bClosing ? DisplayCompositor::usRGB565( 255, 0, 0 )
+                                                : DisplayCompositor::usRGB565( 255, 160, 0 ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,22 @@
+#ifndef HUDLAYOUT_H
+#define HUDLAYOUT_H
+
+#include <cstdint>
+
+#include "displaycompositor.h"
+#include "hudview_headlights.h"
+
+/* Where each screen puts its text and markers, apart from the engine so the bench's golden frames draw the same. */
+class HUDLayout
+{
+public:
+    static const int READING_X = 16;
+    static const int READING_Y = 48;
+
+    static void vDrawSplash( DisplayCompositor & Compositor );
+    static void vDrawReading( DisplayCompositor & Compositor, int iX, const char * pcText, uint16_t usColor );
+    static void vDrawRearAlert( DisplayCompositor & Compositor );
+    static void vDrawHeadlightMarker( DisplayCompositor & Compositor, const xHUDViewHeadlightsMarker_t & xMarker );
+};
+
+#endif // HUDLAYOUT_H
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <string.h>
+#include <QDebug>
+
+#include "latencytracer.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const int LatencyTracer::MAXIMUM_PENDING_RECORDS;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint64_t ullSince( uint64_t ullFrom, uint64_t ullTo );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+LatencyTracer::LatencyTracer()
+{
+    memset( m_axSources, 0, sizeof( m_axSources ) );
+    m_axPending.reserve( MAXIMUM_PENDING_RECORDS );
+    m_axHistograms.resize( ControlEngine::eHUDViewComponentIDMax * eStageMax );
+    memset( m_axHistograms.data(), 0, m_axHistograms.size() * sizeof( xHUDViewHistogram_t ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+LatencyTracer::~LatencyTracer()
+{
+    vClose();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool LatencyTracer::bOpen( const QString & sPath )
+{
+    bool bReturn = false;
+
+    vClose();
+    m_File.setFileName( sPath );
+
+    if ( m_File.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        m_File.write( "component,sequence,lost,source_ns,source_to_handler_us,handler_to_parse_us,parse_and_update_us,"
+                      "update_to_render_us,render_to_spi_us,total_us,pushed\n" );
+        bReturn = true;
+    }
+    else
+    {
+        qDebug() << "Failed to create latency trace: " << sPath;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool LatencyTracer::bIsOpen() const
+{
+    return m_File.isOpen();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void LatencyTracer::vClose()
+{
+    if ( m_File.isOpen() )
+    {
+        m_File.close();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void LatencyTracer::vNoteRecord( ControlEngine::eHUDViewComponentID_t eID, const xHUDViewTraceStamp_t & xStamp,
+                                 uint64_t ullArrival, uint64_t ullParseStart, uint64_t ullUpdated, bool bApplied )
+{
+    xSourceStatistics_t * pxSource = nullptr;
+    xPendingRecord_t xRecord;
+
+    if ( ( ControlEngine::eHUDViewComponentIDMin > eID ) || ( ControlEngine::eHUDViewComponentIDMax <= eID ) )
+    {
+        return;
+    }
+
+    pxSource = &m_axSources[ eID ];
+    xRecord.ulLost = 0;
+
+    /* A component counts its records from one again each time it starts, so going back is a restart, not a loss. */
+    if ( ( 0 != pxSource->ulLastSequence ) && ( xStamp.ulSequence <= pxSource->ulLastSequence ) )
+    {
+        pxSource->ulRestarts++;
+    }
+    else if ( 0 != pxSource->ulLastSequence )
+    {
+        xRecord.ulLost = xStamp.ulSequence - pxSource->ulLastSequence - 1;
+        pxSource->ulLost += xRecord.ulLost;
+    }
+
+    pxSource->ulLastSequence = xStamp.ulSequence;
+
+    /* A record that did not reach the data model cannot reach the panel either. */
+    if ( !bApplied )
+    {
+        return;
+    }
+
+    if ( MAXIMUM_PENDING_RECORDS <= static_cast<int>( m_axPending.size() ) )
+    {
+        pxSource->ulUntraced++;
+        return;
+    }
+
+    xRecord.eID = eID;
+    xRecord.ulSequence = xStamp.ulSequence;
+    xRecord.ullSource = xStamp.ullSourceNanoseconds;
+    xRecord.ullArrival = ullArrival;
+    xRecord.ullParseStart = ullParseStart;
+    xRecord.ullUpdated = ullUpdated;
+    m_axPending.push_back( xRecord );
+    pxSource->ulRecords++;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void LatencyTracer::vNoteRendered( uint64_t ullRenderStart, uint64_t ullSPIComplete, bool bPushed )
+{
+    uint64_t aullStages[ eStageMax ];
+    char acLine[ 256 ];
+
+    for ( const xPendingRecord_t & xRecord : m_axPending )
+    {
+        xSourceStatistics_t & xSource = m_axSources[ xRecord.eID ];
+
+        aullStages[ eStage_SourceToHandler ] = ullSince( xRecord.ullSource, xRecord.ullArrival );
+        aullStages[ eStage_HandlerToParse ] = ullSince( xRecord.ullArrival, xRecord.ullParseStart );
+        aullStages[ eStage_ParseAndUpdate ] = ullSince( xRecord.ullParseStart, xRecord.ullUpdated );
+        aullStages[ eStage_UpdateToRender ] = ullSince( xRecord.ullUpdated, ullRenderStart );
+        aullStages[ eStage_RenderToSPI ] = ullSince( ullRenderStart, ullSPIComplete );
+        aullStages[ eStage_Total ] = ullSince( xRecord.ullSource, ullSPIComplete );
+
+        /* A frame that changed no pixel showed the rider nothing new, so there was no photon to time. */
+        if ( bPushed )
+        {
+            xSource.ulShown++;
+
+            for ( int iStage = 0; iStage < eStageMax; iStage++ )
+            {
+                vHUDViewHistogramRecord( &xGetHistogram( xRecord.eID, static_cast<eStage_t>( iStage ) ),
+                                         aullStages[ iStage ] );
+            }
+        }
+        else
+        {
+            xSource.ulUnchanged++;
+        }
+
+        if ( m_File.isOpen() )
+        {
+            int iLength = snprintf( acLine, sizeof( acLine ), "%s,%u,%u,%llu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%d\n",
+                                    ControlEngine::sEnumValueToComponentName( xRecord.eID ).toLatin1().constData(),
+                                    static_cast<unsigned int>( xRecord.ulSequence ),
+                                    static_cast<unsigned int>( xRecord.ulLost ),
+                                    static_cast<unsigned long long>( xRecord.ullSource ),
+                                    aullStages[ eStage_SourceToHandler ] / 1e3,
+                                    aullStages[ eStage_HandlerToParse ] / 1e3,
+                                    aullStages[ eStage_ParseAndUpdate ] / 1e3,
+                                    aullStages[ eStage_UpdateToRender ] / 1e3,
+                                    aullStages[ eStage_RenderToSPI ] / 1e3, aullStages[ eStage_Total ] / 1e3,
+                                    bPushed ? 1 : 0 );
+
+            m_File.write( acLine, qMin( iLength, static_cast<int>( sizeof( acLine ) ) - 1 ) );
+        }
+    }
+
+    m_axPending.clear();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void LatencyTracer::vReportStatistics() const
+{
+    for ( int iComponent = ControlEngine::eHUDViewComponentIDMin; ControlEngine::eHUDViewComponentIDMax > iComponent;
+          iComponent++ )
+    {
+        ControlEngine::eHUDViewComponentID_t eID = static_cast<ControlEngine::eHUDViewComponentID_t>( iComponent );
+        const xSourceStatistics_t & xSource = m_axSources[ iComponent ];
+
+        if ( ( 0 == xSource.ulRecords ) && ( 0 == xSource.ulLost ) )
+        {
+            continue;
+        }
+
+        qDebug() << "Input to photon:" << ControlEngine::sEnumValueToComponentName( eID ) << ":" << xSource.ulShown
+                 << "records shown," << xSource.ulUnchanged << "changed nothing," << xSource.ulLost
+                 << "lost on the way," << xSource.ulUntraced << "untraced," << xSource.ulRestarts << "restarts";
+
+        for ( int iStage = 0; ( 0 < xSource.ulShown ) && ( iStage < eStageMax ); iStage++ )
+        {
+            const xHUDViewHistogram_t & xHistogram = xGetHistogram( eID, static_cast<eStage_t>( iStage ) );
+
+            /* A percentile is the middle of its bucket, which can lie past the largest value seen. */
+            qDebug() << "   " << pcGetStageName( static_cast<eStage_t>( iStage ) ) << ":"
+                     << qMin( ullHUDViewMetricsPercentile( &xHistogram, 50.0 ), xHistogram.ullMaximum ) / 1e6
+                     << "ms p50,"
+                     << qMin( ullHUDViewMetricsPercentile( &xHistogram, 99.0 ), xHistogram.ullMaximum ) / 1e6
+                     << "ms p99," << xHistogram.ullMaximum / 1e6 << "ms max";
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * LatencyTracer::pcGetStageName( eStage_t eStage )
+{
+    static const char * const apcNames[ eStageMax ] =
+    {
+        "source->handler", "handler->parse", "parse+update", "update->render", "render->spi", "total"
+    };
+
+    return ( ( 0 <= eStage ) && ( eStageMax > eStage ) ) ? apcNames[ eStage ] : "unknown";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+xHUDViewHistogram_t & LatencyTracer::xGetHistogram( ControlEngine::eHUDViewComponentID_t eID, eStage_t eStage )
+{
+    return m_axHistograms[ static_cast<size_t>( eID ) * eStageMax + eStage ];
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const xHUDViewHistogram_t & LatencyTracer::xGetHistogram( ControlEngine::eHUDViewComponentID_t eID,
+                                                          eStage_t eStage ) const
+{
+    return m_axHistograms[ static_cast<size_t>( eID ) * eStageMax + eStage ];
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint64_t ullSince( uint64_t ullFrom, uint64_t ullTo )
+{
+    /* Stamps from a component are on the same clock, but never let a stage go negative. */
+    return ( ullTo > ullFrom ) ? ullTo - ullFrom : 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
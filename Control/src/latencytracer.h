@@ -0,0 +1,81 @@
+#ifndef LATENCYTRACER_H
+#define LATENCYTRACER_H
+
+#include <cstdint>
+#include <vector>
+#include <QFile>
+#include <QString>
+
+#include "controlengine.h"
+#include "hudview_metrics.h"
+#include "hudview_trace.h"
+
+/* Follows every stamped record from the moment its component sensed it to the end of the SPI transfer of the first
+ * frame drawn from a data model that holds it, the time the rider waits to see it. */
+class LatencyTracer
+{
+public:
+    /* Where a record's time goes on its way to the panel. */
+    enum eStage_t {
+        eStage_SourceToHandler = 0,
+        eStage_HandlerToParse,
+        eStage_ParseAndUpdate,
+        eStage_UpdateToRender,
+        eStage_RenderToSPI,
+        eStage_Total,
+
+        eStageMax
+    };
+
+    /* Records waiting for the next frame; the splash holds them for at most a couple of seconds. */
+    static const int MAXIMUM_PENDING_RECORDS = 4096;
+
+    LatencyTracer();
+    ~LatencyTracer();
+
+    bool bOpen( const QString & sPath );
+    bool bIsOpen() const;
+    void vClose();
+
+    void vNoteRecord( ControlEngine::eHUDViewComponentID_t eID, const xHUDViewTraceStamp_t & xStamp,
+                      uint64_t ullArrival, uint64_t ullParseStart, uint64_t ullUpdated, bool bApplied );
+    void vNoteRendered( uint64_t ullRenderStart, uint64_t ullSPIComplete, bool bPushed );
+
+    void vReportStatistics() const;
+
+    static const char * pcGetStageName( eStage_t eStage );
+
+private:
+    struct xPendingRecord_t {
+        ControlEngine::eHUDViewComponentID_t eID;
+        uint32_t ulSequence;
+        uint32_t ulLost;
+        uint64_t ullSource;
+        uint64_t ullArrival;
+        uint64_t ullParseStart;
+        uint64_t ullUpdated;
+    };
+
+    struct xSourceStatistics_t {
+        unsigned long ulRecords;
+        unsigned long ulShown;
+        unsigned long ulUnchanged;
+        unsigned long ulLost;
+        unsigned long ulRestarts;
+        unsigned long ulUntraced;
+        uint32_t ulLastSequence;
+    } m_axSources[ ControlEngine::eHUDViewComponentIDMax ];
+
+    std::vector<xPendingRecord_t> m_axPending;
+
+    /* Records that reached the panel, a histogram a component and stage. */
+    std::vector<xHUDViewHistogram_t> m_axHistograms;
+
+    /* Every record's breakdown as CSV, when asked for with --latency-trace. */
+    QFile m_File;
+
+    xHUDViewHistogram_t & xGetHistogram( ControlEngine::eHUDViewComponentID_t eID, eStage_t eStage );
+    const xHUDViewHistogram_t & xGetHistogram( ControlEngine::eHUDViewComponentID_t eID, eStage_t eStage ) const;
+};
+
+#endif // LATENCYTRACER_H
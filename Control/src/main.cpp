@@ -1,5 +1,7 @@
 #include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QDebug>
+#include <QLoggingCategory>
 
 #include "controlengine.h"
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -17,10 +19,74 @@ int main( int argc, char * argv[] )
     QCommandLineOption ConfigFileOption( QStringList() << "c" << "config",
                                          QCoreApplication::translate( "main", "Use the specified configuration file." ),
                                          QCoreApplication::translate( "main", "path" ) );
+    QCommandLineOption DisplayOption( QStringList() << "d" << "display",
+                                      QCoreApplication::translate( "main", "Use the specified display backend "
+                                                                   "(st7735, spidev[:device|standin[:hz]], "
+                                                                   "framebuffer[:dir[:png]], timing[:hz[:sleep]])." ),
+                                      QCoreApplication::translate( "main", "backend" ) );
+    QCommandLineOption CameraOption( QStringList() << "k" << "camera",
+                                     QCoreApplication::translate( "main", "Orient, crop and scale the camera feed "
+                                                                  "from the specified capture geometry "
+                                                                  "(WIDTHxHEIGHT[:rotate=90|180|270][:hflip][:vflip]"
+                                                                  "[:crop=WxH+X+Y][:nearest|bilinear|area])." ),
+                                     QCoreApplication::translate( "main", "specification" ) );
+    QCommandLineOption CameraRateOption( QStringList() << "p" << "camera-fps",
+                                         QCoreApplication::translate( "main", "Run the camera at a fixed frame rate, "
+                                                                      "or let it follow the rear scene and the "
+                                                                      "rider's speed (auto, the default)." ),
+                                         QCoreApplication::translate( "main", "fps" ) );
+    QCommandLineOption CameraPixelsOption( QStringList() << "b" << "camera-pixels",
+                                           QCoreApplication::translate( "main", "Push the camera feed to the display "
+                                                                        "as rgb565 (the default), or as 12-bit "
+                                                                        "rgb444 or rgb444:dither where the backend "
+                                                                        "takes it." ),
+                                           QCoreApplication::translate( "main", "format" ) );
+    QCommandLineOption RecordOption( QStringList() << "r" << "record",
+                                     QCoreApplication::translate( "main", "Record timestamped component output "
+                                                                  "into the specified directory." ),
+                                     QCoreApplication::translate( "main", "directory" ) );
+    QCommandLineOption FlightRecorderOption( QStringList() << "f" << "flight-recorder",
+                                             QCoreApplication::translate( "main", "Keep the crash flight recording "
+                                                                          "in the specified file, or disable it "
+                                                                          "with an empty path." ),
+                                             QCoreApplication::translate( "main", "path" ) );
+    QCommandLineOption RideLogOption( QStringList() << "l" << "ride-log",
+                                      QCoreApplication::translate( "main", "Keep compressed ride logs in the specified "
+                                                                   "directory, or disable them with an empty path." ),
+                                      QCoreApplication::translate( "main", "directory" ) );
+    QCommandLineOption DashcamOption( QStringList() << "a" << "dashcam",
+                                      QCoreApplication::translate( "main", "Loop-record the camera into the specified "
+                                                                   "directory, keeping the clip around any impact, "
+                                                                   "or disable it with an empty path." ),
+                                      QCoreApplication::translate( "main", "directory" ) );
+    QCommandLineOption LatencyTraceOption( QStringList() << "t" << "latency-trace",
+                                           QCoreApplication::translate( "main", "Write where the time went for every "
+                                                                        "stamped component record, from its source "
+                                                                        "to the panel, as CSV to the specified "
+                                                                        "file." ),
+                                           QCoreApplication::translate( "main", "path" ) );
+    QCommandLineOption ExitOption( QStringList() << "x" << "exit-when-finished",
+                                   QCoreApplication::translate( "main", "Exit once every component process has "
+                                                                "finished, e.g. at the end of a replayed ride." ) );
+    /* -v is taken by --version. */
+    QCommandLineOption VerboseOption( QStringList() << "verbose",
+                                      QCoreApplication::translate( "main", "Log every record parsed from the "
+                                                                   "components." ) );
     Parser.setApplicationDescription( "HUDView Control Application" );
     Parser.addHelpOption();
     Parser.addVersionOption();
     Parser.addOption( ConfigFileOption );
+    Parser.addOption( DisplayOption );
+    Parser.addOption( CameraOption );
+    Parser.addOption( CameraRateOption );
+    Parser.addOption( CameraPixelsOption );
+    Parser.addOption( RecordOption );
+    Parser.addOption( FlightRecorderOption );
+    Parser.addOption( RideLogOption );
+    Parser.addOption( DashcamOption );
+    Parser.addOption( LatencyTraceOption );
+    Parser.addOption( ExitOption );
+    Parser.addOption( VerboseOption );
     Parser.process( App );
 
     if ( Parser.isSet( "config" ) )
@@ -28,6 +94,62 @@ int main( int argc, char * argv[] )
         Engine.vSetConfigFile( Parser.value( "config" ) );
     }
 
+    if ( Parser.isSet( "record" ) )
+    {
+        Engine.vSetRecordDirectory( Parser.value( "record" ) );
+    }
+
+    if ( Parser.isSet( "flight-recorder" ) )
+    {
+        Engine.vSetFlightRecorderPath( Parser.value( "flight-recorder" ) );
+    }
+
+    if ( Parser.isSet( "ride-log" ) )
+    {
+        Engine.vSetRideLogDirectory( Parser.value( "ride-log" ) );
+    }
+
+    if ( Parser.isSet( "dashcam" ) )
+    {
+        Engine.vSetDashcamDirectory( Parser.value( "dashcam" ) );
+    }
+
+    if ( Parser.isSet( "latency-trace" ) )
+    {
+        Engine.vSetLatencyTracePath( Parser.value( "latency-trace" ) );
+    }
+
+    Engine.vSetExitWhenFinished( Parser.isSet( "exit-when-finished" ) );
+
+    if ( Parser.isSet( "verbose" ) )
+    {
+        QLoggingCategory::setFilterRules( "hudview.records.debug=true" );
+    }
+
+    if ( Parser.isSet( "display" ) && !Engine.bSetDisplayBackend( Parser.value( "display" ) ) )
+    {
+        qDebug() << "Unsupported display backend: " << Parser.value( "display" );
+        return -1;
+    }
+
+    if ( Parser.isSet( "camera" ) && !Engine.bSetCameraTransform( Parser.value( "camera" ) ) )
+    {
+        qDebug() << "Unsupported camera specification: " << Parser.value( "camera" );
+        return -1;
+    }
+
+    if ( Parser.isSet( "camera-fps" ) && !Engine.bSetCameraFrameRate( Parser.value( "camera-fps" ) ) )
+    {
+        qDebug() << "Unsupported camera frame rate: " << Parser.value( "camera-fps" );
+        return -1;
+    }
+
+    if ( Parser.isSet( "camera-pixels" ) && !Engine.bSetCameraPixelFormat( Parser.value( "camera-pixels" ) ) )
+    {
+        qDebug() << "Unsupported camera pixel format: " << Parser.value( "camera-pixels" );
+        return -1;
+    }
+
     /* Release control to the engine. */
     return Engine.iRun( &App );
 }
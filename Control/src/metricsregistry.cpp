@@ -0,0 +1,52 @@
+#include <QDebug>
+
+#include "metricsregistry.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+MetricsRegistry::MetricsRegistry()
+{
+    m_pxPage = nullptr;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+MetricsRegistry::~MetricsRegistry()
+{
+    vClose();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool MetricsRegistry::bCreate()
+{
+    vClose();
+
+    /* The control application owns the page; components attach to it once they are started. */
+    m_pxPage = pxHUDViewMetricsAttach( 1, 1 );
+
+    if ( nullptr == m_pxPage )
+    {
+        qDebug() << "Failed to create metrics page: " << HUDVIEW_METRICS_SHM_NAME;
+    }
+
+    return ( nullptr != m_pxPage );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void MetricsRegistry::vClose()
+{
+    /* The page is left in place so the last run can still be inspected with hudview_metrics. */
+    vHUDViewMetricsDetach( m_pxPage );
+    m_pxPage = nullptr;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool MetricsRegistry::bIsOpen() const
+{
+    return ( nullptr != m_pxPage );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+xHUDViewMetricsComponent_t * MetricsRegistry::pxGetComponent( const char * pcName )
+{
+    return pxHUDViewMetricsComponent( m_pxPage, pcName );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
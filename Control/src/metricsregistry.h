@@ -0,0 +1,22 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include "hudview_metrics.h"
+
+class MetricsRegistry
+{
+public:
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    bool bCreate();
+    void vClose();
+    bool bIsOpen() const;
+
+    xHUDViewMetricsComponent_t * pxGetComponent( const char * pcName );
+
+private:
+    xHUDViewMetricsPage_t * m_pxPage;
+};
+
+#endif // METRICSREGISTRY_H
@@ -0,0 +1,93 @@
+#include <QtGlobal>
+
+#include "hudview_metrics.h"
+#include "motionestimator.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const int MotionEstimator::UPDATE_INTERVAL_MS;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llMonotonicMicroseconds();
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+MotionEstimator::MotionEstimator()
+{
+    vHUDViewFusionInit( &m_xFusion );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool MotionEstimator::bIsOpen() const
+{
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void MotionEstimator::vRecordAccelerometer( double dX, double dY, double dZ )
+{
+    Q_UNUSED( dZ );
+
+    /* The accelerometer reports g with x forward and y to the right. */
+    vHUDViewFusionAccelerometer( &m_xFusion, llMonotonicMicroseconds(), dX * HUDVIEW_FUSION_GRAVITY,
+                                 dY * HUDVIEW_FUSION_GRAVITY );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void MotionEstimator::vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection )
+{
+    Q_UNUSED( dLatitude );
+    Q_UNUSED( dLongitude );
+
+    /* Without a fix there is nothing to correct with; the estimate coasts on the accelerometer until it is too old. */
+    if ( bHasFix )
+    {
+        vHUDViewFusionGPS( &m_xFusion, llMonotonicMicroseconds(), dSpeed * HUDVIEW_FUSION_KNOTS_TO_METRES_PER_SECOND,
+                           dDirection );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void MotionEstimator::vRecordLightSensor( long lLux )
+{
+    Q_UNUSED( lLux );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void MotionEstimator::vRecordButtonPress( unsigned long ulPresses )
+{
+    Q_UNUSED( ulPresses );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+MotionEstimator::xEstimate_t MotionEstimator::xUpdate()
+{
+    int64_t llNow = llMonotonicMicroseconds();
+    xHUDViewFusionEstimate_t xFused;
+    xEstimate_t xEstimate;
+
+    /* Carry the estimate forward to now, so it keeps moving between samples and its uncertainty keeps growing. */
+    vHUDViewFusionPredict( &m_xFusion, llNow );
+    vHUDViewFusionEstimate( &m_xFusion, llNow, &xFused );
+
+    xEstimate.bValid = ( 0 != xFused.bValid );
+    xEstimate.bHeadingValid = ( 0 != xFused.bHeadingValid );
+    xEstimate.dSpeed = xFused.dSpeed / HUDVIEW_FUSION_KNOTS_TO_METRES_PER_SECOND;
+    xEstimate.dSpeedSigma = xFused.dSpeedSigma / HUDVIEW_FUSION_KNOTS_TO_METRES_PER_SECOND;
+    xEstimate.dDirection = xFused.dHeading;
+    xEstimate.dDirectionSigma = xFused.dHeadingSigma;
+    xEstimate.dGPSAgeSeconds = xFused.dGPSAgeSeconds;
+
+    return xEstimate;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long MotionEstimator::ulGetGPSRejected() const
+{
+    return m_xFusion.ulGPSRejected;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llMonotonicMicroseconds()
+{
+    return static_cast<int64_t>( ullHUDViewMetricsNow() / 1000ULL );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,42 @@
+#ifndef MOTIONESTIMATOR_H
+#define MOTIONESTIMATOR_H
+
+#include "hudview_fusion.h"
+#include "telemetrysink.h"
+
+/* Fuses the GPS fixes and accelerometer samples Control applies into speed and heading estimates for the HUD. */
+class MotionEstimator : public TelemetrySink
+{
+public:
+    /* Estimates are published at 20 Hz, as often as the accelerometer samples. */
+    static const int UPDATE_INTERVAL_MS = 50;
+
+    struct xEstimate_t {
+        bool bValid;
+        bool bHeadingValid;
+
+        /* Speed in knots, like the GPS reports it, and heading in degrees; each with its standard deviation. */
+        double dSpeed;
+        double dSpeedSigma;
+        double dDirection;
+        double dDirectionSigma;
+        double dGPSAgeSeconds;
+    };
+
+    MotionEstimator();
+
+    bool bIsOpen() const override;
+
+    void vRecordAccelerometer( double dX, double dY, double dZ ) override;
+    void vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection ) override;
+    void vRecordLightSensor( long lLux ) override;
+    void vRecordButtonPress( unsigned long ulPresses ) override;
+
+    xEstimate_t xUpdate();
+    unsigned long ulGetGPSRejected() const;
+
+private:
+    xHUDViewFusion_t m_xFusion;
+};
+
+#endif // MOTIONESTIMATOR_H
@@ -0,0 +1,122 @@
+#include <string.h>
+#include <time.h>
+#include <QDebug>
+
+#include "ridelog.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llRealtimeMicroseconds();
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+RideLog::RideLog()
+{
+    m_bOpen = false;
+    memset( &m_xWriter, 0, sizeof( m_xWriter ) );
+    m_xWriter.iDescriptor = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+RideLog::~RideLog()
+{
+    vClose();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool RideLog::bOpen( const QString & sPath )
+{
+    vClose();
+
+    if ( 0 != iHUDViewRideLogOpen( &m_xWriter, sPath.toLocal8Bit().constData() ) )
+    {
+        return false;
+    }
+
+    m_sPath = sPath;
+    m_bOpen = true;
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool RideLog::bIsOpen() const
+{
+    return m_bOpen;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideLog::vClose()
+{
+    if ( m_bOpen )
+    {
+        /* Closing writes the time index, which is what makes seeking in a finished ride cheap. */
+        if ( 0 != iHUDViewRideLogClose( &m_xWriter ) )
+        {
+            qDebug() << "Failed to finish ride log: " << m_sPath;
+        }
+        else if ( 0 < m_xWriter.ullSamples )
+        {
+            qDebug() << "Ride log closed: " << m_sPath << m_xWriter.ullSamples << "samples";
+        }
+
+        m_bOpen = false;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideLog::vRecordAccelerometer( double dX, double dY, double dZ )
+{
+    const double adValues[] = { dX, dY, dZ };
+
+    vAppend( eHUDViewRideLogStream_Accelerometer, adValues );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideLog::vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection )
+{
+    const double adValues[] = { bHasFix ? 1.0 : 0.0, dLatitude, dLongitude, dSpeed, dDirection };
+
+    vAppend( eHUDViewRideLogStream_GPS, adValues );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideLog::vRecordLightSensor( long lLux )
+{
+    const double adValues[] = { static_cast<double>( lLux ) };
+
+    vAppend( eHUDViewRideLogStream_LightSensor, adValues );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideLog::vRecordButtonPress( unsigned long ulPresses )
+{
+    Q_UNUSED( ulPresses );
+
+    /* Button presses are control input, not ride history; the flight recorder keeps them. */
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long long RideLog::ullGetSamplesWritten() const
+{
+    return m_xWriter.ullSamples;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideLog::vAppend( eHUDViewRideLogStream_t eStream, const double * pdValues )
+{
+    /* Samples are only buffered here; a whole chunk is written at once every 1024 samples or every minute. */
+    if ( m_bOpen && ( 0 != iHUDViewRideLogAppend( &m_xWriter, eStream, llRealtimeMicroseconds(), pdValues ) ) )
+    {
+        qDebug() << "Failed to write ride log chunk: " << m_sPath;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llRealtimeMicroseconds()
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_REALTIME, &xNow );
+
+    return static_cast<int64_t>( xNow.tv_sec ) * 1000000LL + xNow.tv_nsec / 1000;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,35 @@
+#ifndef RIDELOG_H
+#define RIDELOG_H
+
+#include <cstdint>
+#include <QString>
+
+#include "hudview_ridelog.h"
+#include "telemetrysink.h"
+
+class RideLog : public TelemetrySink
+{
+public:
+    RideLog();
+    ~RideLog() override;
+
+    bool bOpen( const QString & sPath );
+    bool bIsOpen() const override;
+    void vClose();
+
+    void vRecordAccelerometer( double dX, double dY, double dZ ) override;
+    void vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection ) override;
+    void vRecordLightSensor( long lLux ) override;
+    void vRecordButtonPress( unsigned long ulPresses ) override;
+
+    unsigned long long ullGetSamplesWritten() const;
+
+private:
+    bool m_bOpen;
+    QString m_sPath;
+    xHUDViewRideLogWriter_t m_xWriter;
+
+    void vAppend( eHUDViewRideLogStream_t eStream, const double * pdValues );
+};
+
+#endif // RIDELOG_H
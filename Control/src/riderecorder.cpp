@@ -0,0 +1,159 @@
+#include <QDebug>
+#include <QDir>
+
+#include "riderecorder.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+RideRecorder::RideRecorder()
+{
+    m_sDirectory = "";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+RideRecorder::~RideRecorder()
+{
+    vClose();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool RideRecorder::bOpen( const QString & sDirectory )
+{
+    bool bReturn = false;
+
+    vClose();
+
+    if ( QDir().mkpath( sDirectory ) )
+    {
+        m_sDirectory = sDirectory;
+        m_Timer.start();
+        bReturn = true;
+    }
+    else
+    {
+        qDebug() << "Failed to create ride recording directory: " << sDirectory;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool RideRecorder::bIsOpen() const
+{
+    return !m_sDirectory.isEmpty();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideRecorder::vClose()
+{
+    for ( QFile * pFile : m_hashTraceFiles )
+    {
+        pFile->close();
+        delete pFile;
+    }
+
+    for ( QFile * pFile : m_hashClipFiles )
+    {
+        pFile->close();
+        delete pFile;
+    }
+
+    m_hashTraceFiles.clear();
+    m_hashClipFiles.clear();
+    m_hashPendingData.clear();
+    m_sDirectory = "";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideRecorder::vRecord( const QString & sComponent, const QByteArray & Data )
+{
+    QFile * pFile = nullptr;
+    QByteArray & Pending = m_hashPendingData[ sComponent ];
+    QByteArray Timestamp;
+    int iEnd = -1;
+
+    if ( !bIsOpen() )
+    {
+        return;
+    }
+
+    pFile = pGetTraceFile( sComponent );
+    Pending.append( Data );
+    Timestamp = QByteArray::number( m_Timer.nsecsElapsed() / 1000 );
+
+    /* Stamp each complete line with the time it arrived; partial lines wait for the rest of their data. */
+    while ( -1 != ( iEnd = Pending.indexOf( '\n' ) ) )
+    {
+        if ( nullptr != pFile )
+        {
+            pFile->write( Timestamp );
+            pFile->write( " " );
+            pFile->write( Pending.constData(), iEnd + 1 );
+        }
+
+        Pending.remove( 0, iEnd + 1 );
+    }
+
+    if ( nullptr != pFile )
+    {
+        pFile->flush();
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void RideRecorder::vRecordFrame( const QString & sComponent, const uint8_t * pucFrame, int iBytes )
+{
+    QFile * pFile = nullptr;
+
+    if ( !bIsOpen() )
+    {
+        return;
+    }
+
+    pFile = m_hashClipFiles.value( sComponent, nullptr );
+
+    /* Frames are stored raw and back to back, as they came from the component, so a clip can be fed to the vision
+     * tools or back through the FIFO as is. */
+    if ( nullptr == pFile )
+    {
+        pFile = new QFile( QDir( m_sDirectory ).filePath( sComponent + ".rgb" ) );
+
+        if ( pFile->open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+        {
+            m_hashClipFiles.insert( sComponent, pFile );
+        }
+        else
+        {
+            qDebug() << "Failed to open clip file for component: " << sComponent;
+            delete pFile;
+            return;
+        }
+    }
+
+    pFile->write( reinterpret_cast<const char *>( pucFrame ), iBytes );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+QFile * RideRecorder::pGetTraceFile( const QString & sComponent )
+{
+    QFile * pFile = m_hashTraceFiles.value( sComponent, nullptr );
+
+    if ( nullptr == pFile )
+    {
+        pFile = new QFile( QDir( m_sDirectory ).filePath( sComponent + ".trace" ) );
+
+        if ( pFile->open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+        {
+            pFile->write( QByteArray( "# HUDView trace " ) + sComponent.toLocal8Bit() + "\n" );
+            m_hashTraceFiles.insert( sComponent, pFile );
+        }
+        else
+        {
+            qDebug() << "Failed to open trace file for component: " << sComponent;
+            delete pFile;
+            pFile = nullptr;
+        }
+    }
+
+    return pFile;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
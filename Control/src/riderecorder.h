@@ -0,0 +1,35 @@
+#ifndef RIDERECORDER_H
+#define RIDERECORDER_H
+
+#include <cstdint>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+class RideRecorder
+{
+public:
+    RideRecorder();
+    ~RideRecorder();
+
+    bool bOpen( const QString & sDirectory );
+    bool bIsOpen() const;
+    void vClose();
+
+    void vRecord( const QString & sComponent, const QByteArray & Data );
+    void vRecordFrame( const QString & sComponent, const uint8_t * pucFrame, int iBytes );
+
+private:
+    QString m_sDirectory;
+    QElapsedTimer m_Timer;
+    QHash<QString, QFile *> m_hashTraceFiles;
+    QHash<QString, QByteArray> m_hashPendingData;
+    QHash<QString, QFile *> m_hashClipFiles;
+
+    QFile * pGetTraceFile( const QString & sComponent );
+};
+
+#endif // RIDERECORDER_H
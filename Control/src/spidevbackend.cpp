@@ -0,0 +1,232 @@
+#include <cstring>
+
+#include "spidevbackend.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+constexpr const char * SpidevDisplayBackend::STAND_IN_DEVICE;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+SpidevDisplayBackend::SpidevDisplayBackend( const std::string & sDevice, unsigned long ulClockHz ) :
+    m_aucFrame( DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof( uint16_t ), 0 )
+{
+    m_sDevice = sDevice;
+    m_ulClockHz = ulClockHz;
+    m_bOpen = false;
+    memset( &m_xLink, 0, sizeof( m_xLink ) );
+    m_ulFrameBytes = 0;
+    m_ulFrameSwitches = 0;
+    m_lstRegions.reserve( DISPLAY_HEIGHT );
+    m_bScrollPending = false;
+    m_bDefineScrollArea = false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+SpidevDisplayBackend::~SpidevDisplayBackend()
+{
+    if ( m_bOpen )
+    {
+        vHUDViewSpidevClose( &m_xLink );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool SpidevDisplayBackend::bInit()
+{
+    unsigned long ulClockHz = ( 0 < m_ulClockHz ) ? m_ulClockHz : HUDVIEW_SPIDEV_DEFAULT_CLOCK_HZ;
+    int iResult = -1;
+
+    if ( STAND_IN_DEVICE == m_sDevice )
+    {
+        iResult = iHUDViewSpidevOpenStandIn( &m_xLink, ulClockHz, HUDVIEW_SPIDEV_DEFAULT_BUFSIZ );
+    }
+    else
+    {
+        iResult = iHUDViewSpidevOpen( &m_xLink, m_sDevice.c_str(), ulClockHz );
+    }
+
+    m_bOpen = ( 0 == iResult );
+
+    if ( m_bOpen && ( 0 == iHUDViewSpidevInitPanel( &m_xLink ) ) )
+    {
+        /* Probing needs the panel's MISO line; without it the default clock is kept. */
+        if ( 0 == m_ulClockHz )
+        {
+            ulClockHz = ulHUDViewSpidevProbeClock( &m_xLink, HUDVIEW_SPIDEV_MAXIMUM_CLOCK_HZ );
+            m_ulClockHz = ( 0 < ulClockHz ) ? ulClockHz : HUDVIEW_SPIDEV_DEFAULT_CLOCK_HZ;
+        }
+
+        iResult = iHUDViewSpidevSetClock( &m_xLink, m_ulClockHz );
+
+        /* Start from a black screen, sent a row band at a time from the zeroed frame buffer. */
+        for ( int iY = 0; ( 0 == iResult ) && ( iY < DISPLAY_HEIGHT ); iY += DISPLAY_HEIGHT / 4 )
+        {
+            iResult = iHUDViewSpidevWindow( &m_xLink, 0, iY, DISPLAY_WIDTH, DISPLAY_HEIGHT / 4 );
+
+            if ( 0 == iResult )
+            {
+                iResult = iHUDViewSpidevData( &m_xLink, m_aucFrame.data(), m_aucFrame.size() / 4 );
+            }
+        }
+
+        if ( 0 == iResult )
+        {
+            iResult = iHUDViewSpidevFlush( &m_xLink );
+        }
+    }
+    else
+    {
+        iResult = -1;
+    }
+
+    return ( 0 == iResult );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void SpidevDisplayBackend::vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride )
+{
+    size_t ulBytes = static_cast<size_t>( xRegion.iWidth ) * xRegion.iHeight * sizeof( uint16_t );
+    uint8_t * pucData = nullptr;
+    xHUDViewSpidevRegion_t xSpidevRegion;
+
+    /* The link sends COLMOD itself where the format changes between regions; this only counts it. */
+    if ( bSwitchPixelFormat() )
+    {
+        m_ulFrameSwitches++;
+    }
+
+    if ( ( m_ulFrameBytes + ulBytes ) > m_aucFrame.size() )
+    {
+        vFlushRegions();
+    }
+
+    pucData = &m_aucFrame[ m_ulFrameBytes ];
+
+    if ( ePixelFormat_RGB444 == m_ePixelFormat )
+    {
+        ulBytes = ulHUDViewRGB444Pack( &m_xPacker, pusPixels, iStride, xRegion.iX, xRegion.iY, xRegion.iWidth,
+                                       xRegion.iHeight, pucData );
+    }
+    else
+    {
+        /* The panel expects big-endian RGB565, so swap while gathering the region into the frame buffer. */
+        ulBytes = 0;
+
+        for ( int iY = 0; iY < xRegion.iHeight; iY++ )
+        {
+            const uint16_t * pusRow = &pusPixels[ iY * iStride ];
+
+            for ( int iX = 0; iX < xRegion.iWidth; iX++ )
+            {
+                pucData[ ulBytes++ ] = static_cast<uint8_t>( pusRow[ iX ] >> 8 );
+                pucData[ ulBytes++ ] = static_cast<uint8_t>( pusRow[ iX ] & 0xFF );
+            }
+        }
+    }
+
+    xSpidevRegion.iX = xRegion.iX;
+    xSpidevRegion.iY = xRegion.iY;
+    xSpidevRegion.iWidth = xRegion.iWidth;
+    xSpidevRegion.iHeight = xRegion.iHeight;
+    xSpidevRegion.b12Bit = ( ePixelFormat_RGB444 == m_ePixelFormat ) ? 1 : 0;
+    xSpidevRegion.pucData = pucData;
+    xSpidevRegion.ulBytes = ulBytes;
+    m_lstRegions.push_back( xSpidevRegion );
+    m_ulFrameBytes += ulBytes;
+
+    /* Command bytes are only known once the frame's windows have been merged, and are counted then. */
+    vCountTransfer( 0, ulBytes );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void SpidevDisplayBackend::vEndFrame()
+{
+    vFlushRegions();
+    vFlushScroll();
+    DisplayBackend::vEndFrame();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * SpidevDisplayBackend::pcGetName() const
+{
+    return "spidev";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool SpidevDisplayBackend::bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const
+{
+    return ( ePixelFormat_RGB565 == ePixelFormat ) || ( ePixelFormat_RGB444 == ePixelFormat );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long SpidevDisplayBackend::ulGetClockHz() const
+{
+    return m_ulClockHz;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool SpidevDisplayBackend::bSupportsScroll() const
+{
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void SpidevDisplayBackend::vScroll( const xScrollArea_t & xArea )
+{
+    m_bDefineScrollArea = bSwitchScrollArea( xArea ) || m_bDefineScrollArea;
+    m_bScrollPending = true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void SpidevDisplayBackend::vFlushRegions()
+{
+    xHUDViewSpidevStatistics_t xBefore = m_xLink.xStatistics;
+
+    if ( m_bOpen && !m_lstRegions.empty() )
+    {
+        /* A failed ioctl loses this frame's regions only; the next frame opens its windows afresh. */
+        ( void )iHUDViewSpidevPushRegions( &m_xLink, m_lstRegions.data(), static_cast<int>( m_lstRegions.size() ) );
+
+        /* What the link sent beyond the pixels, less the COLMOD bytes bSwitchPixelFormat() has counted already. */
+        m_xStatistics.ullCommandBytes += ( m_xLink.xStatistics.ullBytes - xBefore.ullBytes ) - m_ulFrameBytes
+                                         - m_ulFrameSwitches * PIXEL_FORMAT_COMMAND_BYTES;
+        m_xStatistics.ullSyscalls += ( m_xLink.xStatistics.ulMessages - xBefore.ulMessages ) +
+                                     ( m_xLink.xStatistics.ulLineChanges - xBefore.ulLineChanges );
+    }
+
+    m_lstRegions.clear();
+    m_ulFrameBytes = 0;
+    m_ulFrameSwitches = 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void SpidevDisplayBackend::vFlushScroll()
+{
+    xHUDViewSpidevStatistics_t xBefore = m_xLink.xStatistics;
+    int iResult = 0;
+
+    if ( m_bOpen && m_bScrollPending )
+    {
+        if ( m_bDefineScrollArea )
+        {
+            iResult = iHUDViewSpidevScrollArea( &m_xLink, m_xScrollArea.iX, m_xScrollArea.iWidth );
+        }
+
+        if ( 0 == iResult )
+        {
+            iResult = iHUDViewSpidevScroll( &m_xLink, m_xScrollArea.iX + m_xScrollArea.iOffset );
+        }
+
+        if ( 0 == iResult )
+        {
+            iResult = iHUDViewSpidevFlush( &m_xLink );
+        }
+
+        /* The bytes were counted with the scroll itself. */
+        m_xStatistics.ullSyscalls += ( m_xLink.xStatistics.ulMessages - xBefore.ulMessages ) +
+                                     ( m_xLink.xStatistics.ulLineChanges - xBefore.ulLineChanges );
+    }
+
+    m_bScrollPending = false;
+    m_bDefineScrollArea = false;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
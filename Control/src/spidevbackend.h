@@ -0,0 +1,49 @@
+#ifndef SPIDEVBACKEND_H
+#define SPIDEVBACKEND_H
+
+#include <string>
+#include <vector>
+
+#include "displaybackend.h"
+#include "hudview_spidev.h"
+
+class SpidevDisplayBackend : public DisplayBackend
+{
+public:
+    /* Stands in for the device on a desktop, counting the ioctls a real link would make. */
+    static constexpr const char * STAND_IN_DEVICE = "standin";
+
+    /* A clock of 0 probes for the fastest one the panel reads back cleanly. */
+    SpidevDisplayBackend( const std::string & sDevice, unsigned long ulClockHz );
+    ~SpidevDisplayBackend();
+
+    bool bInit() override;
+    void vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride ) override;
+    void vEndFrame() override;
+    const char * pcGetName() const override;
+    bool bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const override;
+    unsigned long ulGetClockHz() const override;
+    bool bSupportsScroll() const override;
+    void vScroll( const xScrollArea_t & xArea ) override;
+
+private:
+    std::string m_sDevice;
+    unsigned long m_ulClockHz;
+    bool m_bOpen;
+    xHUDViewSpidev_t m_xLink;
+
+    /* A frame's regions are gathered here, already in wire format, and sent together when the frame ends. */
+    std::vector<uint8_t> m_aucFrame;
+    size_t m_ulFrameBytes;
+    unsigned long m_ulFrameSwitches;
+    std::vector<xHUDViewSpidevRegion_t> m_lstRegions;
+
+    /* A scroll goes out after the frame's pixels, so the columns it exposes are already in place. */
+    bool m_bScrollPending;
+    bool m_bDefineScrollArea;
+
+    void vFlushRegions();
+    void vFlushScroll();
+};
+
+#endif // SPIDEVBACKEND_H
@@ -0,0 +1,125 @@
+#include <ssd1306.h>
+#include <intf/spi/ssd1306_spi.h>
+
+#include "st7735backend.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+St7735DisplayBackend::St7735DisplayBackend() :
+    m_aucTransferBuffer( DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof( uint16_t ), 0 )
+{
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool St7735DisplayBackend::bInit()
+{
+    st7735_128x160_spi_init( 22, 1, 23 );
+    ssd1306_setMode( LCD_MODE_NORMAL );
+    st7735_setRotation( 1 );
+    ssd1306_fillScreen8( 0x00 );
+
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void St7735DisplayBackend::vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride )
+{
+    size_t ulBytes = 0;
+
+    if ( bSwitchPixelFormat() )
+    {
+        vSendPixelFormat();
+    }
+
+    /* The display library only writes 16-bit pixels, so a 12-bit window is opened and streamed here instead. */
+    if ( ePixelFormat_RGB444 == m_ePixelFormat )
+    {
+        ulBytes = ulHUDViewRGB444Pack( &m_xPacker, pusPixels, iStride, xRegion.iX, xRegion.iY, xRegion.iWidth,
+                                       xRegion.iHeight, m_aucTransferBuffer.data() );
+        ssd1306_lcd.set_block( xRegion.iX, xRegion.iY, xRegion.iWidth );
+        ssd1306_intf.send_buffer( m_aucTransferBuffer.data(), ulBytes );
+        ssd1306_intf.stop();
+    }
+    else
+    {
+        /* The panel expects big-endian RGB565, so swap while gathering the region into a contiguous buffer. */
+        for ( int iY = 0; iY < xRegion.iHeight; iY++ )
+        {
+            const uint16_t * pusRow = &pusPixels[ iY * iStride ];
+
+            for ( int iX = 0; iX < xRegion.iWidth; iX++ )
+            {
+                m_aucTransferBuffer[ ulBytes++ ] = static_cast<uint8_t>( pusRow[ iX ] >> 8 );
+                m_aucTransferBuffer[ ulBytes++ ] = static_cast<uint8_t>( pusRow[ iX ] & 0xFF );
+            }
+        }
+
+        ssd1306_drawBitmap16( xRegion.iX, xRegion.iY, xRegion.iWidth, xRegion.iHeight, m_aucTransferBuffer.data() );
+    }
+
+    vCountTransfer( REGION_COMMAND_OVERHEAD_BYTES, ulBytes );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * St7735DisplayBackend::pcGetName() const
+{
+    return "st7735";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool St7735DisplayBackend::bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const
+{
+    return ( ePixelFormat_RGB565 == ePixelFormat ) || ( ePixelFormat_RGB444 == ePixelFormat );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+bool St7735DisplayBackend::bSupportsScroll() const
+{
+    return true;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void St7735DisplayBackend::vScroll( const xScrollArea_t & xArea )
+{
+    int iBottom = DISPLAY_WIDTH - xArea.iX - xArea.iWidth;
+    int iStart = xArea.iX + xArea.iOffset;
+    uint8_t aucArea[ 6 ] = { static_cast<uint8_t>( xArea.iX >> 8 ), static_cast<uint8_t>( xArea.iX ),
+                             static_cast<uint8_t>( xArea.iWidth >> 8 ), static_cast<uint8_t>( xArea.iWidth ),
+                             static_cast<uint8_t>( iBottom >> 8 ), static_cast<uint8_t>( iBottom ) };
+    uint8_t aucStart[ 2 ] = { static_cast<uint8_t>( iStart >> 8 ), static_cast<uint8_t>( iStart ) };
+
+    /* VSCRDEF gives the fixed lines before and after the scrolling ones; VSCSAD the line the scrolling area starts
+     * showing from. */
+    if ( bSwitchScrollArea( xArea ) )
+    {
+        vSendCommand( VSCRDEF_COMMAND, aucArea, sizeof( aucArea ) );
+    }
+
+    vSendCommand( VSCSAD_COMMAND, aucStart, sizeof( aucStart ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void St7735DisplayBackend::vSendPixelFormat()
+{
+    uint8_t ucColmod = ( ePixelFormat_RGB444 == m_ePixelFormat ) ? HUDVIEW_RGB444_COLMOD_12BIT
+                                                                  : HUDVIEW_RGB444_COLMOD_16BIT;
+
+    vSendCommand( HUDVIEW_RGB444_COLMOD_COMMAND, &ucColmod, 1 );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void St7735DisplayBackend::vSendCommand( uint8_t ucCommand, const uint8_t * pucArguments, int iArguments )
+{
+    /* The D/C line is low for the command and high for its arguments. */
+    ssd1306_intf.start();
+    ssd1306_spiDataMode( 0 );
+    ssd1306_intf.send( ucCommand );
+    ssd1306_spiDataMode( 1 );
+
+    for ( int iArgument = 0; iArgument < iArguments; iArgument++ )
+    {
+        ssd1306_intf.send( pucArguments[ iArgument ] );
+    }
+
+    ssd1306_intf.stop();
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
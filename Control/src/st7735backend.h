@@ -0,0 +1,30 @@
+#ifndef ST7735BACKEND_H
+#define ST7735BACKEND_H
+
+#include <vector>
+
+#include "displaybackend.h"
+
+class St7735DisplayBackend : public DisplayBackend
+{
+public:
+    St7735DisplayBackend();
+
+    bool bInit() override;
+    void vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride ) override;
+    const char * pcGetName() const override;
+    bool bSupportsPixelFormat( ePixelFormat_t ePixelFormat ) const override;
+    bool bSupportsScroll() const override;
+    void vScroll( const xScrollArea_t & xArea ) override;
+
+private:
+    static const uint8_t VSCRDEF_COMMAND = 0x33;
+    static const uint8_t VSCSAD_COMMAND = 0x37;
+
+    std::vector<uint8_t> m_aucTransferBuffer;
+
+    void vSendPixelFormat();
+    void vSendCommand( uint8_t ucCommand, const uint8_t * pucArguments, int iArguments );
+};
+
+#endif // ST7735BACKEND_H
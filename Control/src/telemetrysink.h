@@ -0,0 +1,18 @@
+#ifndef TELEMETRYSINK_H
+#define TELEMETRYSINK_H
+
+/* Receives every sample Control applies to its model, e.g. to keep a flight recording or a ride log. */
+class TelemetrySink
+{
+public:
+    virtual ~TelemetrySink() {}
+
+    virtual bool bIsOpen() const = 0;
+
+    virtual void vRecordAccelerometer( double dX, double dY, double dZ ) = 0;
+    virtual void vRecordGPS( bool bHasFix, double dLatitude, double dLongitude, double dSpeed, double dDirection ) = 0;
+    virtual void vRecordLightSensor( long lLux ) = 0;
+    virtual void vRecordButtonPress( unsigned long ulPresses ) = 0;
+};
+
+#endif // TELEMETRYSINK_H
@@ -0,0 +1,97 @@
+#include <time.h>
+
+#include "timingbackend.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+TimingDisplayBackend::TimingDisplayBackend( unsigned long ulClockHz, bool bSleep )
+{
+    m_ulClockHz = ulClockHz;
+    m_bSleep = bSleep;
+    m_ullSimulatedNanoseconds = 0;
+    m_ullFrameNanoseconds = 0;
+    m_ullLastFrameNanoseconds = 0;
+    m_ullMaximumFrameNanoseconds = 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void TimingDisplayBackend::vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride )
+{
+    unsigned long long ullBytes = ullGetTotalBytes();
+
+    FramebufferDisplayBackend::vPushRegion( xRegion, pusPixels, iStride );
+    vModelTransfer( ullGetTotalBytes() - ullBytes );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void TimingDisplayBackend::vEndFrame()
+{
+    FramebufferDisplayBackend::vEndFrame();
+
+    m_ullLastFrameNanoseconds = m_ullFrameNanoseconds;
+
+    if ( m_ullFrameNanoseconds > m_ullMaximumFrameNanoseconds )
+    {
+        m_ullMaximumFrameNanoseconds = m_ullFrameNanoseconds;
+    }
+
+    m_ullFrameNanoseconds = 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+const char * TimingDisplayBackend::pcGetName() const
+{
+    return "timing";
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long TimingDisplayBackend::ulGetClockHz() const
+{
+    return m_ulClockHz;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void TimingDisplayBackend::vScroll( const xScrollArea_t & xArea )
+{
+    unsigned long long ullBytes = ullGetTotalBytes();
+
+    FramebufferDisplayBackend::vScroll( xArea );
+    vModelTransfer( ullGetTotalBytes() - ullBytes );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+double TimingDisplayBackend::dGetSimulatedSeconds() const
+{
+    return m_ullSimulatedNanoseconds / 1e9;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long long TimingDisplayBackend::ullGetLastFrameNanoseconds() const
+{
+    return m_ullLastFrameNanoseconds;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long long TimingDisplayBackend::ullGetMaximumFrameNanoseconds() const
+{
+    return m_ullMaximumFrameNanoseconds;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+void TimingDisplayBackend::vModelTransfer( unsigned long long ullBytes )
+{
+    unsigned long long ullNanoseconds = TRANSFER_OVERHEAD_NS + ( ullBytes * 8ULL * 1000000000ULL ) / m_ulClockHz;
+    struct timespec xDelay;
+
+    /* Model the wire time of the bytes just counted plus the fixed per-transfer cost. */
+    m_ullSimulatedNanoseconds += ullNanoseconds;
+    m_ullFrameNanoseconds += ullNanoseconds;
+
+    /* Optionally stall the caller for as long as the real bus would. */
+    if ( m_bSleep )
+    {
+        xDelay.tv_sec = static_cast<time_t>( ullNanoseconds / 1000000000ULL );
+        xDelay.tv_nsec = static_cast<long>( ullNanoseconds % 1000000000ULL );
+        nanosleep( &xDelay, nullptr );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,37 @@
+#ifndef TIMINGBACKEND_H
+#define TIMINGBACKEND_H
+
+#include "framebufferbackend.h"
+
+class TimingDisplayBackend : public FramebufferDisplayBackend
+{
+public:
+    static const unsigned long DEFAULT_SPI_CLOCK_HZ = 16000000;
+
+    /* Fixed cost of each transfer on the Pi: the syscall, chip-select toggles and D/C line switching. */
+    static const unsigned long TRANSFER_OVERHEAD_NS = 20000;
+
+    TimingDisplayBackend( unsigned long ulClockHz, bool bSleep );
+
+    void vPushRegion( const xDisplayRegion_t & xRegion, const uint16_t * pusPixels, int iStride ) override;
+    void vEndFrame() override;
+    const char * pcGetName() const override;
+    unsigned long ulGetClockHz() const override;
+    void vScroll( const xScrollArea_t & xArea ) override;
+
+    double dGetSimulatedSeconds() const;
+    unsigned long long ullGetLastFrameNanoseconds() const;
+    unsigned long long ullGetMaximumFrameNanoseconds() const;
+
+private:
+    unsigned long m_ulClockHz;
+    bool m_bSleep;
+    unsigned long long m_ullSimulatedNanoseconds;
+    unsigned long long m_ullFrameNanoseconds;
+    unsigned long long m_ullLastFrameNanoseconds;
+    unsigned long long m_ullMaximumFrameNanoseconds;
+
+    void vModelTransfer( unsigned long long ullBytes );
+};
+
+#endif // TIMINGBACKEND_H
@@ -17,6 +17,10 @@
 #include<sys/stat.h>
 #include<signal.h>
 
+#include "hudview_memlock.h"
+#include "hudview_metrics.h"
+#include "hudview_trace.h"
+
 typedef struct gps_slave {
 	char read_byte[1];
 	int sentence_length;
@@ -31,6 +35,13 @@ int serial_port;
 char read_byte[2];
 unsigned char buf;
 
+// Metrics slot in the control application's shared page, and when the current sentence started arriving
+xHUDViewMetricsComponent_t* metrics = NULL;
+uint64_t sentence_start_ns = 0;
+
+// Sentences printed so far, for the trace stamp
+uint32_t sentences_printed = 0;
+
 // State functions -------------------
 void read_first_byte(unsigned char nbyte, gps_slave* s);
 void read_nmea_sentence_header(unsigned char nbyte, gps_slave* s);
@@ -50,6 +61,7 @@ static void signalHandler(int signal);
 // Read in first byte, if it is not the `$` char then ignore
 void read_first_byte(unsigned char rbyte, gps_slave* slave) {
 	if(rbyte == 0x24) {
+		sentence_start_ns = ullHUDViewMetricsNow();
 		state_ptr=read_nmea_sentence_header;
 	}	
 }
@@ -116,7 +128,10 @@ void validate_checksum(unsigned char rbyte, gps_slave* slave) {
 		}
 			
 		if(given == checksum) {
-		        printf("%s\n", slave->sentence);
+		        printf(HUDVIEW_TRACE_STAMP_FORMAT "%s\n", ++sentences_printed, sentence_start_ns, slave->sentence);
+			uint64_t written_ns = ullHUDViewMetricsNow();
+			vHUDViewMetricsRecord(metrics, eHUDViewMetricsStage_SensorToStdout, written_ns - sentence_start_ns);
+			vHUDViewMetricsMarkWrite(metrics, written_ns);
 		        state_ptr=read_first_byte;
 			tcflush(serial_port, TCIFLUSH);
 			usleep(10 * 1000);
@@ -176,6 +191,13 @@ int main(int argc, char* argv[]) {
 
   setbuf( stdout, NULL );
 
+  // Keep every page resident if the control application asked for it
+  if(iHUDViewLockMemoryIfRequested() < 0) {
+    fprintf(stderr, "Failed to lock memory\n");
+  }
+
+  metrics = pxHUDViewMetricsComponent(pxHUDViewMetricsAttach(0, 1), "GPS");
+
   initialize_serial();
 
   size_t s = 255;
@@ -12,6 +12,9 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "hudview_memlock.h"
+#include "hudview_metrics.h"
+#include "hudview_trace.h"
 #include "tsl2561.h"
 /*--------------------------------------------------------------------------------------------------------------------*/
 
@@ -29,6 +32,10 @@ int main( int argc, char ** argv )
     const int iSensorAddress = 0x39;
     const char * const pcBus = "/dev/i2c-1";
     long lLuxReading = 0;
+    xHUDViewMetricsComponent_t * pxMetrics = NULL;
+    uint64_t ullReadStart = 0;
+    uint64_t ullWritten = 0;
+    uint32_t ulRecords = 0;
     int iReturn = -1;
 
     /* Install the Ctrl-C handler. */
@@ -37,6 +44,15 @@ int main( int argc, char ** argv )
     /* Disable buffering on standard output. */
     setbuf( stdout, NULL );
 
+    /* Keep every page resident if the control application asked for it, so sampling never waits on a page fault. */
+    if ( 0 > iHUDViewLockMemoryIfRequested() )
+    {
+        fprintf( stderr, "Failed to lock memory\n" );
+    }
+
+    /* Report read-to-stdout latency through the control application's metrics page, if it is running. */
+    pxMetrics = pxHUDViewMetricsComponent( pxHUDViewMetricsAttach( 0, 1 ), "LightSensor" );
+
     /* Attempt initialize the sensor. */
     pvSensor = tsl2561_init( iSensorAddress, pcBus );
 
@@ -49,8 +65,12 @@ int main( int argc, char ** argv )
      /* Periodically collect the lux reading and append it to the output file. */
         for ( ;; )
         {
+            ullReadStart = ullHUDViewMetricsNow();
             lLuxReading = tsl2561_lux( pvSensor );
-            printf( "%lu\n", lLuxReading );
+            printf( HUDVIEW_TRACE_STAMP_FORMAT "%lu\n", ++ulRecords, ullReadStart, lLuxReading );
+            ullWritten = ullHUDViewMetricsNow();
+            vHUDViewMetricsRecord( pxMetrics, eHUDViewMetricsStage_SensorToStdout, ullWritten - ullReadStart );
+            vHUDViewMetricsMarkWrite( pxMetrics, ullWritten );
             sleep( WAIT_TIME_SECONDS );
         }
 
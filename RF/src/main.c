@@ -0,0 +1,306 @@
+/** @file main.c
+ *  @brief HUDView handlebar button daemon.
+ *
+ *  Usage: receive_button [-c chip] [-l line] [-H] [-d debounce ms] [-L long ms] [-D double ms] [-s FIFO]
+ *
+ *  This program watches the handlebar button's GPIO line through the GPIO character device and prints a line for
+ *  each press for downstream consumption by the control application: "0" for a short press, "1" for a long press and
+ *  "2" for a double press. The kernel timestamps every edge as it happens, and the edges are debounced and decoded
+ *  on those timestamps (see hudview_button.h); between edges the program sleeps until the next decision is due, so
+ *  a press is printed within moments of becoming certain, and nothing runs while the button is idle. Each line is
+ *  stamped with the time of the press's first edge (see hudview_trace.h), so the control application can tell how
+ *  long the rider waited from pressing the button to seeing what it did.
+ *
+ *  The button is on BCM 26 of /dev/gpiochip0, pulling the line low against the pull-up when pressed; -H takes a
+ *  button that pulls it high against a pull-down instead. With -s the edges are read as struct gpio_v2_line_event
+ *  records from a FIFO instead of a GPIO line, as hudview_buttons latency sends them when there is no gpio-sim chip
+ *  to test against.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_button.h"
+#include "hudview_memlock.h"
+#include "hudview_metrics.h"
+#include "hudview_trace.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define DEFAULT_CHIP            "/dev/gpiochip0"
+#define DEFAULT_LINE            ( 26 )
+#define CONSUMER                "hudview-button"
+
+/* Edges the kernel queues until they are read, and how many are read at once; a bouncing contact makes dozens. */
+#define KERNEL_EVENTS           ( 64 )
+#define READ_EVENTS             ( 16 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iOpenLine( const char * pcChip, unsigned int uiLine, int bActiveHigh );
+static int iReadPressed( int iLine, int bActiveHigh, int * pbPressed );
+static void vSignalHandler( int iSignal );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    struct gpio_v2_line_event axEvents[ READ_EVENTS ];
+    xHUDViewButton_t xButton;
+    xHUDViewMetricsComponent_t * pxMetrics = NULL;
+    const char * pcChip = DEFAULT_CHIP;
+    const char * pcStandIn = NULL;
+    unsigned int uiLine = DEFAULT_LINE;
+    int bActiveHigh = 0;
+    uint64_t ullDebounce = HUDVIEW_BUTTON_DEBOUNCE_NS;
+    uint64_t ullLong = HUDVIEW_BUTTON_LONG_NS;
+    uint64_t ullDouble = HUDVIEW_BUTTON_DOUBLE_NS;
+    uint32_t ulLastSequence = 0;
+    uint32_t ulRecords = 0;
+    int bLost = 0;
+    int bPressed = 0;
+    int iLine = -1;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "c:l:Hd:L:D:s:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'c':
+            pcChip = optarg;
+            break;
+
+        case 'l':
+            uiLine = ( unsigned int )strtoul( optarg, NULL, 10 );
+            break;
+
+        case 'H':
+            bActiveHigh = 1;
+            break;
+
+        case 'd':
+            ullDebounce = strtoull( optarg, NULL, 10 ) * 1000000ULL;
+            break;
+
+        case 'L':
+            ullLong = strtoull( optarg, NULL, 10 ) * 1000000ULL;
+            break;
+
+        case 'D':
+            ullDouble = strtoull( optarg, NULL, 10 ) * 1000000ULL;
+            break;
+
+        case 's':
+            pcStandIn = optarg;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0 == ullLong ) || ( ullLong <= ullDebounce ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Install the Ctrl-C handler, and leave just as quietly when the control application stops us. */
+    signal( SIGINT, vSignalHandler );
+    signal( SIGTERM, vSignalHandler );
+
+    /* Disable buffering on standard output. */
+    setbuf( stdout, NULL );
+
+    /* Keep every page resident if the control application asked for it, so a press never waits on a page fault. */
+    if ( 0 > iHUDViewLockMemoryIfRequested() )
+    {
+        fprintf( stderr, "Failed to lock memory\n" );
+    }
+
+    /* Report press-to-stdout latency through the control application's metrics page, if it is running. */
+    pxMetrics = pxHUDViewMetricsComponent( pxHUDViewMetricsAttach( 0, 1 ), "HandlebarButtons" );
+
+    if ( NULL != pcStandIn )
+    {
+        iLine = open( pcStandIn, O_RDONLY | O_CLOEXEC );
+    }
+    else
+    {
+        iLine = iOpenLine( pcChip, uiLine, bActiveHigh );
+
+        if ( ( 0 <= iLine ) && ( 0 > iReadPressed( iLine, bActiveHigh, &bPressed ) ) )
+        {
+            close( iLine );
+            iLine = -1;
+        }
+    }
+
+    if ( 0 > iLine )
+    {
+        fprintf( stderr, "Failed to open the button line on %s: %s\n", ( NULL != pcStandIn ) ? pcStandIn : pcChip,
+                 strerror( errno ) );
+        return -1;
+    }
+
+    vHUDViewButtonInit( &xButton, ullDebounce, ullLong, ullDouble, bPressed );
+
+    for ( ;; )
+    {
+        struct pollfd xPoll = { iLine, POLLIN, 0 };
+        struct timespec xTimeout = { 0, 0 };
+        uint64_t ullDeadline = ullHUDViewButtonDeadline( &xButton );
+        uint64_t ullNow = ullHUDViewMetricsNow();
+        uint64_t ullPressed = 0;
+        uint64_t ullDecided = 0;
+        eHUDViewButtonEvent_t eEvent = eHUDViewButtonEvent_None;
+        ssize_t lRead = 0;
+        int iReady = 0;
+
+        /* Sleep until the next edge, or until the decoder next has something to decide. */
+        if ( ullDeadline > ullNow )
+        {
+            xTimeout.tv_sec = ( time_t )( ( ullDeadline - ullNow ) / 1000000000ULL );
+            xTimeout.tv_nsec = ( long )( ( ullDeadline - ullNow ) % 1000000000ULL );
+        }
+
+        iReady = ppoll( &xPoll, 1, ( 0 != ullDeadline ) ? &xTimeout : NULL, NULL );
+
+        if ( ( 0 > iReady ) && ( EINTR != errno ) )
+        {
+            fprintf( stderr, "Failed to wait for the button: %s\n", strerror( errno ) );
+            break;
+        }
+
+        if ( ( 0 < iReady ) && ( 0 != ( xPoll.revents & ( POLLIN | POLLHUP | POLLERR ) ) ) )
+        {
+            lRead = read( iLine, axEvents, sizeof( axEvents ) );
+
+            /* The stand-in's sender has gone. */
+            if ( 0 == lRead )
+            {
+                break;
+            }
+
+            for ( int iEvent = 0; iEvent < lRead / ( ssize_t )sizeof( axEvents[ 0 ] ); iEvent++ )
+            {
+                int bHigh = ( GPIO_V2_LINE_EVENT_RISING_EDGE == axEvents[ iEvent ].id );
+
+                /* A full kernel queue drops the newest edges, so the level they left the line at is read back. */
+                if ( ( 0 != ulLastSequence ) && ( ulLastSequence + 1 != axEvents[ iEvent ].line_seqno ) )
+                {
+                    bLost = 1;
+                }
+
+                ulLastSequence = axEvents[ iEvent ].line_seqno;
+                vHUDViewButtonEdge( &xButton, axEvents[ iEvent ].timestamp_ns, bHigh == bActiveHigh );
+            }
+
+            if ( bLost && ( NULL == pcStandIn ) && ( 0 == iReadPressed( iLine, bActiveHigh, &bPressed ) )
+                 && ( bPressed != xButton.bRawPressed ) )
+            {
+                vHUDViewButtonEdge( &xButton, ullHUDViewMetricsNow(), bPressed );
+            }
+
+            bLost = 0;
+        }
+
+        vHUDViewButtonAdvance( &xButton, ullHUDViewMetricsNow() );
+
+        while ( eHUDViewButtonEvent_None != ( eEvent = eHUDViewButtonNextEvent( &xButton, &ullPressed, &ullDecided ) ) )
+        {
+            printf( HUDVIEW_TRACE_STAMP_FORMAT "%s\n", ++ulRecords, ullPressed, pcHUDViewButtonRecord( eEvent ) );
+            ullNow = ullHUDViewMetricsNow();
+            vHUDViewMetricsRecord( pxMetrics, eHUDViewMetricsStage_SensorToStdout,
+                                   ( ullNow > ullDecided ) ? ullNow - ullDecided : 0 );
+            vHUDViewMetricsMarkWrite( pxMetrics, ullNow );
+        }
+    }
+
+    close( iLine );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iOpenLine( const char * pcChip, unsigned int uiLine, int bActiveHigh )
+{
+    struct gpio_v2_line_request xRequest;
+    int iChip = open( pcChip, O_RDWR | O_CLOEXEC );
+    int iReturn = -1;
+
+    if ( 0 > iChip )
+    {
+        return -1;
+    }
+
+    /* An input with both edges timestamped on CLOCK_MONOTONIC, the clock the metrics page and decoder use. */
+    memset( &xRequest, 0, sizeof( xRequest ) );
+    xRequest.offsets[ 0 ] = uiLine;
+    xRequest.num_lines = 1;
+    xRequest.event_buffer_size = KERNEL_EVENTS;
+    strncpy( xRequest.consumer, CONSUMER, sizeof( xRequest.consumer ) - 1 );
+    xRequest.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING
+                            | ( bActiveHigh ? GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN : GPIO_V2_LINE_FLAG_BIAS_PULL_UP );
+
+    if ( 0 == ioctl( iChip, GPIO_V2_GET_LINE_IOCTL, &xRequest ) )
+    {
+        iReturn = xRequest.fd;
+    }
+
+    close( iChip );
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iReadPressed( int iLine, int bActiveHigh, int * pbPressed )
+{
+    struct gpio_v2_line_values xValues;
+    int iReturn = -1;
+
+    memset( &xValues, 0, sizeof( xValues ) );
+    xValues.mask = 1;
+
+    if ( 0 == ioctl( iLine, GPIO_V2_LINE_GET_VALUES_IOCTL, &xValues ) )
+    {
+        *pbPressed = ( ( 0 != ( xValues.bits & 1 ) ) == bActiveHigh );
+        iReturn = 0;
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSignalHandler( int iSignal )
+{
+    /* Check for a signal to quit. */
+    if ( ( SIGINT == iSignal ) || ( SIGTERM == iSignal ) )
+    {
+        exit( 0 );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s [-c chip] [-l line] [-H] [-d debounce ms] [-L long ms] [-D double ms] [-s FIFO]\n",
+             pcProgram );
+    fprintf( stderr, "  -c  GPIO chip (default %s)\n", DEFAULT_CHIP );
+    fprintf( stderr, "  -l  line offset (default %d)\n", DEFAULT_LINE );
+    fprintf( stderr, "  -H  the button pulls the line high (default: low, against the pull-up)\n" );
+    fprintf( stderr, "  -d  debounce time (default %llu ms)\n", HUDVIEW_BUTTON_DEBOUNCE_NS / 1000000ULL );
+    fprintf( stderr, "  -L  long press time (default %llu ms)\n", HUDVIEW_BUTTON_LONG_NS / 1000000ULL );
+    fprintf( stderr, "  -D  double press time, 0 for none (default %llu ms)\n", HUDVIEW_BUTTON_DOUBLE_NS / 1000000ULL );
+    fprintf( stderr, "  -s  read edges from a FIFO instead of a GPIO line\n" );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,916 @@
+/** @file hudview_buttons.c
+ *  @brief HUDView handlebar button decoding and latency test tool.
+ *
+ *  Usage: hudview_buttons decode [-n presses] [-b bounce edges] [-g glitches] [-s seed]
+ *         hudview_buttons latency [-n presses] [-p receive_button] [-S]
+ *
+ *  The decode command makes up a run of short, long and double presses on a noisy line, every change of level
+ *  bouncing up to the given number of times and the idle line picking up the given number of spikes between
+ *  presses, and decodes it as the button daemon does. It reports how many presses of each kind were decoded right,
+ *  missed or made up, and how long after the press began each kind was reported; and, for comparison, how many
+ *  presses counting every rising edge, as the first button script did, would have seen.
+ *
+ *  The latency command runs the button daemon on a mock GPIO chip and presses its button: on a gpio-sim chip made
+ *  through configfs for the purpose when the kernel has gpio-sim (modprobe gpio-sim, as root), so the edges go
+ *  through the GPIO character device and are timestamped by the kernel, or otherwise (and with -S) through the
+ *  daemon's FIFO stand-in. Each press bounces and is preceded by a spike. It reports how long after each press could
+ *  first be told apart the daemon's line reached this tool, any press it got wrong, and the daemon's resident memory
+ *  next to that of a bare Python interpreter, which the first button script needed before it loaded RPi.GPIO.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_button.h"
+#include "hudview_metrics.h"
+#include "hudview_trace.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define DEFAULT_DAEMON          "/opt/hudview/rf/receive_button"
+#define GPIO_SIM_DIRECTORY      "/sys/kernel/config/gpio-sim"
+#define GPIO_SIM_NAME           "hudview-buttons"
+#define BUTTON_LINE             ( 26 )
+#define BUTTON_LINES            ( 32 )
+#define STAND_IN_FIFO           "/tmp/hudview_buttons.fifo"
+
+/* How presses are made: held this long for a short or double press, this far apart for a double, and how long
+ * past the daemon's long press time a long press is held. */
+#define HOLD_NS                 ( 80000000ULL )
+#define DOUBLE_GAP_NS           ( 120000000ULL )
+#define LONG_MARGIN_NS          ( 200000000ULL )
+
+/* Contact bounce comes 50 us to 1.5 ms apart; a spike lasts up to half a millisecond. */
+#define BOUNCE_MINIMUM_NS       ( 50000ULL )
+#define BOUNCE_MAXIMUM_NS       ( 1500000ULL )
+#define SPIKE_MAXIMUM_NS        ( 500000ULL )
+
+/* How long the latency test waits for a press it expects, and for one it does not. */
+#define REPLY_TIMEOUT_MS        ( 2000 )
+#define QUIET_TIMEOUT_MS        ( 50 )
+
+#define MAXIMUM_EDGES           ( 1 << 20 )
+#define MAXIMUM_PRESSES         ( 100000 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    uint64_t ullTimestamp;
+    int bPressed;
+} xEdge_t;
+
+/* A press made up by the test: what it was, when it began, and when the decoder could first have known. */
+typedef struct {
+    eHUDViewButtonEvent_t eEvent;
+    uint64_t ullStart;
+    uint64_t ullDecidable;
+} xPress_t;
+
+/* How the latency test works the line: a gpio-sim pull file, or the daemon's FIFO. */
+typedef struct {
+    int bStandIn;
+    int iLine;
+    uint32_t ulSequence;
+    char acChip[ 64 ];
+    char acPullPath[ 256 ];
+    uint64_t ullLastEdge;
+
+    /* Set when this tool was held up long enough for a bounce or spike to have become a level of its own. */
+    int bHeldUp;
+} xMockLine_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iDecode( int argc, char ** argv );
+static int iLatency( int argc, char ** argv );
+static int iAddTransition( xEdge_t * pxEdges, int iEdges, uint64_t * pullTime, int bPressed, int iBounces );
+static int iAddPress( xEdge_t * pxEdges, int iEdges, xPress_t * pxPress, uint64_t * pullTime, int iBounces );
+static int iOpenMock( xMockLine_t * pxMock, int bStandIn );
+static int iOpenStandIn( xMockLine_t * pxMock );
+static void vCloseMock( xMockLine_t * pxMock );
+static uint64_t ullDrive( xMockLine_t * pxMock, int bPressed, int iBounces );
+static void vSpike( xMockLine_t * pxMock );
+static int iSetLine( xMockLine_t * pxMock, int bPressed );
+static int iWriteFile( const char * pcPath, const char * pcValue );
+static int iReadFile( const char * pcPath, char * pcValue, size_t ulSize );
+static pid_t xSpawn( char * const * ppcArguments, int * piOutput );
+static long lResidentKilobytes( pid_t xProcess );
+static eHUDViewButtonEvent_t eReadPress( int iOutput, int iTimeoutMs, uint64_t * pullReceived );
+static void vSleepUntil( uint64_t ullTime );
+static int iCompare( const void * pvA, const void * pvB );
+static void vReport( const char * pcName, uint64_t * pullValues, int iValues );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    if ( 2 > argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Each command parses its own options after the command name. */
+    optind = 2;
+
+    if ( 0 == strcmp( argv[ 1 ], "decode" ) )
+    {
+        return iDecode( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "latency" ) )
+    {
+        return iLatency( argc, argv );
+    }
+
+    vUsage( argv[ 0 ] );
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iDecode( int argc, char ** argv )
+{
+    static xEdge_t axEdges[ MAXIMUM_EDGES ];
+    static xPress_t axPresses[ MAXIMUM_PRESSES ];
+    static uint64_t aaullDelays[ eHUDViewButtonEventMax ][ MAXIMUM_PRESSES ];
+    int aiDelays[ eHUDViewButtonEventMax ] = { 0 };
+    unsigned long aulRight[ eHUDViewButtonEventMax ] = { 0 };
+    unsigned long aulWrong[ eHUDViewButtonEventMax ] = { 0 };
+    unsigned long aulMadeUp[ eHUDViewButtonEventMax ] = { 0 };
+    unsigned long ulLate = 0;
+    xHUDViewButton_t xButton;
+    eHUDViewButtonEvent_t eEvent = eHUDViewButtonEvent_None;
+    uint64_t ullTime = 1000000000ULL;
+    uint64_t ullDecided = 0;
+    unsigned long ulRisingEdges = 0;
+    unsigned int uiSeed = 1;
+    int iPresses = 300;
+    int iBounces = 6;
+    int iGlitches = 2;
+    int iEdges = 0;
+    int iPress = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "n:b:g:s:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'n':
+            iPresses = atoi( optarg );
+            break;
+
+        case 'b':
+            iBounces = atoi( optarg );
+            break;
+
+        case 'g':
+            iGlitches = atoi( optarg );
+            break;
+
+        case 's':
+            uiSeed = ( unsigned int )strtoul( optarg, NULL, 10 );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0 >= iPresses ) || ( MAXIMUM_PRESSES < iPresses ) || ( 0 > iBounces ) || ( 0 > iGlitches ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    srand( uiSeed );
+
+    /* Each press is followed by long enough idle for the last one to be over, with spikes in it. */
+    for ( iPress = 0; ( iPress < iPresses ) && ( MAXIMUM_EDGES - 64 * ( iBounces + 1 + iGlitches ) > iEdges );
+          iPress++ )
+    {
+        axPresses[ iPress ].eEvent = ( eHUDViewButtonEvent_t )( eHUDViewButtonEvent_Short + rand() % 3 );
+        iEdges = iAddPress( axEdges, iEdges, &axPresses[ iPress ], &ullTime, iBounces );
+
+        for ( int iGlitch = 0; iGlitch < iGlitches; iGlitch++ )
+        {
+            ullTime += HUDVIEW_BUTTON_DOUBLE_NS / ( iGlitches + 1 );
+            axEdges[ iEdges ].ullTimestamp = ullTime;
+            axEdges[ iEdges++ ].bPressed = 1;
+            ullTime += 1 + ( uint64_t )rand() % SPIKE_MAXIMUM_NS;
+            axEdges[ iEdges ].ullTimestamp = ullTime;
+            axEdges[ iEdges++ ].bPressed = 0;
+        }
+
+        ullTime += HUDVIEW_BUTTON_DOUBLE_NS;
+    }
+
+    iPresses = iPress;
+
+    /* Decode the lot as the daemon would, and see what the first script would have made of it: it counted releases,
+     * the rising edges of a line that is pulled up, and nothing else. */
+    vHUDViewButtonInit( &xButton, HUDVIEW_BUTTON_DEBOUNCE_NS, HUDVIEW_BUTTON_LONG_NS, HUDVIEW_BUTTON_DOUBLE_NS, 0 );
+    iPress = 0;
+
+    for ( int iEdge = 0; iEdge <= iEdges; iEdge++ )
+    {
+        if ( iEdge < iEdges )
+        {
+            vHUDViewButtonEdge( &xButton, axEdges[ iEdge ].ullTimestamp, axEdges[ iEdge ].bPressed );
+            ulRisingEdges += ( ( 0 < iEdge ) && axEdges[ iEdge - 1 ].bPressed && !axEdges[ iEdge ].bPressed ) ? 1 : 0;
+        }
+        else
+        {
+            vHUDViewButtonAdvance( &xButton, ullTime + 10 * HUDVIEW_BUTTON_LONG_NS );
+        }
+
+        while ( eHUDViewButtonEvent_None != ( eEvent = eHUDViewButtonNextEvent( &xButton, NULL, &ullDecided ) ) )
+        {
+            /* Decoded presses are matched to made-up ones in order; one decoded before the next began is made up. */
+            if ( ( iPress >= iPresses ) || ( ullDecided < axPresses[ iPress ].ullStart ) )
+            {
+                aulMadeUp[ eEvent ]++;
+                continue;
+            }
+
+            if ( eEvent == axPresses[ iPress ].eEvent )
+            {
+                aulRight[ eEvent ]++;
+                aaullDelays[ eEvent ][ aiDelays[ eEvent ]++ ] = ullDecided - axPresses[ iPress ].ullStart;
+                ulLate += ( ullDecided > axPresses[ iPress ].ullDecidable ) ? 1 : 0;
+            }
+            else
+            {
+                aulWrong[ axPresses[ iPress ].eEvent ]++;
+            }
+
+            iPress++;
+        }
+    }
+
+    printf( "%d presses, %d edges, up to %d bounces a change of level and %d spikes between presses\n", iPresses,
+            iEdges, iBounces, iGlitches );
+    printf( "%-8s %8s %8s %8s %8s\n", "press", "made", "right", "wrong", "made up" );
+
+    for ( int iEvent = eHUDViewButtonEvent_Short; iEvent < eHUDViewButtonEventMax; iEvent++ )
+    {
+        int iMade = 0;
+
+        for ( int iIndex = 0; iIndex < iPresses; iIndex++ )
+        {
+            iMade += ( ( int )axPresses[ iIndex ].eEvent == iEvent ) ? 1 : 0;
+        }
+
+        printf( "%-8s %8d %8lu %8lu %8lu\n", pcHUDViewButtonEventName( ( eHUDViewButtonEvent_t )iEvent ), iMade,
+                aulRight[ iEvent ], aulWrong[ iEvent ], aulMadeUp[ iEvent ] );
+    }
+
+    printf( "%d presses missed, %lu decided later than they could have been; %lu bursts, %lu of them glitches\n",
+            iPresses - iPress, ulLate, xButton.xStatistics.ulBursts, xButton.xStatistics.ulGlitches );
+    printf( "Reported after the press began (ms):\n" );
+
+    for ( int iEvent = eHUDViewButtonEvent_Short; iEvent < eHUDViewButtonEventMax; iEvent++ )
+    {
+        vReport( pcHUDViewButtonEventName( ( eHUDViewButtonEvent_t )iEvent ), aaullDelays[ iEvent ],
+                 aiDelays[ iEvent ] );
+    }
+
+    printf( "Counting rising edges, as the first script did: %lu presses\n", ulRisingEdges );
+
+    return ( ( iPress == iPresses ) && ( 0 == ulLate ) ) ? 0 : 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iLatency( int argc, char ** argv )
+{
+    static uint64_t aaullLatencies[ eHUDViewButtonEventMax ][ MAXIMUM_PRESSES ];
+    int aiLatencies[ eHUDViewButtonEventMax ] = { 0 };
+    xMockLine_t xMock;
+    char acChip[ 80 ];
+    char acLine[ 16 ];
+    char * apcArguments[ 8 ] = { NULL };
+    const char * pcDaemon = DEFAULT_DAEMON;
+    char * apcPython[] = { "python3", "-c", "import time; time.sleep(10)", NULL };
+    eHUDViewButtonEvent_t eEvent = eHUDViewButtonEvent_None;
+    uint64_t ullDecidable = 0;
+    uint64_t ullReceived = 0;
+    unsigned long ulWrong = 0;
+    unsigned long ulMadeUp = 0;
+    unsigned long ulHeldUp = 0;
+    long lDaemonKilobytes = 0;
+    long lPythonKilobytes = 0;
+    pid_t xDaemon = -1;
+    pid_t xPython = -1;
+    int bStandIn = 0;
+    int iPresses = 30;
+    int iOutput = -1;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "n:p:S" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'n':
+            iPresses = atoi( optarg );
+            break;
+
+        case 'p':
+            pcDaemon = optarg;
+            break;
+
+        case 'S':
+            bStandIn = 1;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0 >= iPresses ) || ( MAXIMUM_PRESSES < iPresses ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    signal( SIGPIPE, SIG_IGN );
+    srand( 1 );
+
+    if ( 0 > iOpenMock( &xMock, bStandIn ) )
+    {
+        fprintf( stderr, "Failed to make a mock GPIO chip: %s\n", strerror( errno ) );
+        return -1;
+    }
+
+    /* The daemon takes its defaults, which the presses below are timed against. */
+    apcArguments[ 0 ] = ( char * )pcDaemon;
+
+    if ( xMock.bStandIn )
+    {
+        apcArguments[ 1 ] = "-s";
+        apcArguments[ 2 ] = STAND_IN_FIFO;
+    }
+    else
+    {
+        snprintf( acChip, sizeof( acChip ), "/dev/%s", xMock.acChip );
+        snprintf( acLine, sizeof( acLine ), "%d", BUTTON_LINE );
+        apcArguments[ 1 ] = "-c";
+        apcArguments[ 2 ] = acChip;
+        apcArguments[ 3 ] = "-l";
+        apcArguments[ 4 ] = acLine;
+    }
+
+    xDaemon = xSpawn( apcArguments, &iOutput );
+
+    if ( ( 0 > xDaemon ) || ( xMock.bStandIn && ( 0 > iOpenStandIn( &xMock ) ) ) )
+    {
+        fprintf( stderr, "Failed to start %s: %s\n", pcDaemon, strerror( errno ) );
+        vCloseMock( &xMock );
+        return -1;
+    }
+
+    /* Let the daemon settle on the line before the first press. */
+    usleep( 200000 );
+    printf( "Pressing the button %d times on %s\n", iPresses,
+            xMock.bStandIn ? "the daemon's FIFO stand-in" : "a gpio-sim chip" );
+
+    for ( int iPress = 0; iPress < iPresses; iPress++ )
+    {
+        eHUDViewButtonEvent_t eMade = ( eHUDViewButtonEvent_t )( eHUDViewButtonEvent_Short + iPress % 3 );
+        eHUDViewButtonEvent_t eExtra = eHUDViewButtonEvent_None;
+        uint64_t ullStart = 0;
+        uint64_t ullLast = 0;
+
+        /* A spike on the idle line first, which must come to nothing. */
+        xMock.bHeldUp = 0;
+        vSpike( &xMock );
+        ullStart = ullDrive( &xMock, 1, rand() % 4 );
+        ullLast = xMock.ullLastEdge;
+
+        switch ( eMade )
+        {
+        case eHUDViewButtonEvent_Long:
+            ullDecidable = ullStart + HUDVIEW_BUTTON_LONG_NS;
+            break;
+
+        case eHUDViewButtonEvent_Double:
+            vSleepUntil( ullStart + HOLD_NS );
+            ullStart = ullDrive( &xMock, 0, rand() % 4 );
+            vSleepUntil( ullStart + DOUBLE_GAP_NS );
+            ( void )ullDrive( &xMock, 1, rand() % 4 );
+            ullDecidable = xMock.ullLastEdge + HUDVIEW_BUTTON_DEBOUNCE_NS;
+            break;
+
+        default:
+            vSleepUntil( ullStart + HOLD_NS );
+            ullStart = ullDrive( &xMock, 0, rand() % 4 );
+            ullLast = xMock.ullLastEdge;
+            ullDecidable = ullStart + HUDVIEW_BUTTON_DOUBLE_NS;
+            break;
+        }
+
+        if ( ullDecidable < ullLast + HUDVIEW_BUTTON_DEBOUNCE_NS )
+        {
+            ullDecidable = ullLast + HUDVIEW_BUTTON_DEBOUNCE_NS;
+        }
+
+        eEvent = eReadPress( iOutput, REPLY_TIMEOUT_MS, &ullReceived );
+
+        /* Let go of a long or double press, which must not be reported again, and leave the double time behind. */
+        if ( eHUDViewButtonEvent_Short != eMade )
+        {
+            vSleepUntil( xMock.ullLastEdge + ( ( eHUDViewButtonEvent_Long == eMade ) ? LONG_MARGIN_NS : HOLD_NS ) );
+            ( void )ullDrive( &xMock, 0, rand() % 4 );
+        }
+
+        vSleepUntil( xMock.ullLastEdge + HUDVIEW_BUTTON_DOUBLE_NS + QUIET_TIMEOUT_MS * 1000000ULL );
+
+        while ( eHUDViewButtonEvent_None != ( eExtra = eReadPress( iOutput, QUIET_TIMEOUT_MS, NULL ) ) )
+        {
+            fprintf( stderr, "Press %d: got a %s press too\n", iPress, pcHUDViewButtonEventName( eExtra ) );
+            ulMadeUp += xMock.bHeldUp ? 0 : 1;
+        }
+
+        /* A spike or bounce that lasted as long as the debounce time was a press or release of its own, so the press
+         * was not the one intended. */
+        if ( xMock.bHeldUp )
+        {
+            fprintf( stderr, "Press %d: this tool was held up making it, not counted\n", iPress );
+            ulHeldUp++;
+        }
+        else if ( eEvent != eMade )
+        {
+            fprintf( stderr, "Press %d: made a %s press, got %s\n", iPress, pcHUDViewButtonEventName( eMade ),
+                     pcHUDViewButtonEventName( eEvent ) );
+            ulWrong++;
+        }
+        else
+        {
+            aaullLatencies[ eEvent ][ aiLatencies[ eEvent ]++ ] = ( ullReceived > ullDecidable )
+                                                                ? ullReceived - ullDecidable : 0;
+        }
+    }
+
+    lDaemonKilobytes = lResidentKilobytes( xDaemon );
+    xPython = xSpawn( apcPython, NULL );
+
+    if ( 0 < xPython )
+    {
+        usleep( 500000 );
+        lPythonKilobytes = lResidentKilobytes( xPython );
+        kill( xPython, SIGTERM );
+        waitpid( xPython, NULL, 0 );
+    }
+
+    kill( xDaemon, SIGTERM );
+    waitpid( xDaemon, NULL, 0 );
+    close( iOutput );
+    vCloseMock( &xMock );
+
+    printf( "%lu presses wrong or missed, %lu made up, %lu not counted\n", ulWrong, ulMadeUp, ulHeldUp );
+    printf( "Line received after the press could first be told apart (ms):\n" );
+
+    for ( int iEvent = eHUDViewButtonEvent_Short; iEvent < eHUDViewButtonEventMax; iEvent++ )
+    {
+        vReport( pcHUDViewButtonEventName( ( eHUDViewButtonEvent_t )iEvent ), aaullLatencies[ iEvent ],
+                 aiLatencies[ iEvent ] );
+    }
+
+    printf( "Resident memory: daemon %ld kB", lDaemonKilobytes );
+
+    if ( 0 < lPythonKilobytes )
+    {
+        printf( ", a bare python3 %ld kB", lPythonKilobytes );
+    }
+
+    printf( "\n" );
+
+    return ( ( 0 == ulWrong ) && ( 0 == ulMadeUp ) ) ? 0 : 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iAddTransition( xEdge_t * pxEdges, int iEdges, uint64_t * pullTime, int bPressed, int iBounces )
+{
+    int iEdgesMade = 1 + 2 * ( ( 0 < iBounces ) ? rand() % ( iBounces + 1 ) : 0 );
+
+    /* A bouncing contact goes back and forth an even number of times after the first edge, ending at the new level. */
+    for ( int iEdge = 0; iEdge < iEdgesMade; iEdge++ )
+    {
+        if ( 0 < iEdge )
+        {
+            *pullTime += BOUNCE_MINIMUM_NS + ( uint64_t )rand() % ( BOUNCE_MAXIMUM_NS - BOUNCE_MINIMUM_NS );
+        }
+
+        pxEdges[ iEdges ].ullTimestamp = *pullTime;
+        pxEdges[ iEdges++ ].bPressed = ( 0 == iEdge % 2 ) ? bPressed : !bPressed;
+    }
+
+    return iEdges;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iAddPress( xEdge_t * pxEdges, int iEdges, xPress_t * pxPress, uint64_t * pullTime, int iBounces )
+{
+    uint64_t ullLast = 0;
+
+    pxPress->ullStart = *pullTime;
+    iEdges = iAddTransition( pxEdges, iEdges, pullTime, 1, iBounces );
+    ullLast = *pullTime;
+
+    switch ( pxPress->eEvent )
+    {
+    case eHUDViewButtonEvent_Long:
+        pxPress->ullDecidable = pxPress->ullStart + HUDVIEW_BUTTON_LONG_NS;
+        *pullTime = pxPress->ullDecidable + LONG_MARGIN_NS;
+        iEdges = iAddTransition( pxEdges, iEdges, pullTime, 0, iBounces );
+        break;
+
+    case eHUDViewButtonEvent_Double:
+        *pullTime += HOLD_NS;
+        iEdges = iAddTransition( pxEdges, iEdges, pullTime, 0, iBounces );
+        *pullTime += DOUBLE_GAP_NS;
+        iEdges = iAddTransition( pxEdges, iEdges, pullTime, 1, iBounces );
+        ullLast = *pullTime;
+        pxPress->ullDecidable = ullLast + HUDVIEW_BUTTON_DEBOUNCE_NS;
+        *pullTime += HOLD_NS;
+        iEdges = iAddTransition( pxEdges, iEdges, pullTime, 0, iBounces );
+        break;
+
+    default:
+        *pullTime += HOLD_NS;
+        pxPress->ullDecidable = *pullTime + HUDVIEW_BUTTON_DOUBLE_NS;
+        iEdges = iAddTransition( pxEdges, iEdges, pullTime, 0, iBounces );
+        ullLast = *pullTime;
+        break;
+    }
+
+    if ( pxPress->ullDecidable < ullLast + HUDVIEW_BUTTON_DEBOUNCE_NS )
+    {
+        pxPress->ullDecidable = ullLast + HUDVIEW_BUTTON_DEBOUNCE_NS;
+    }
+
+    return iEdges;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iOpenMock( xMockLine_t * pxMock, int bStandIn )
+{
+    char acPath[ 256 ];
+    char acDevice[ 64 ];
+    int iReturn = -1;
+
+    memset( pxMock, 0, sizeof( *pxMock ) );
+    pxMock->iLine = -1;
+
+    /* A gpio-sim chip with one bank, the button line pulled up as the Pi's would be. */
+    if ( !bStandIn && ( 0 == access( GPIO_SIM_DIRECTORY, W_OK ) ) )
+    {
+        snprintf( acPath, sizeof( acPath ), "%s/%s", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+        ( void )mkdir( acPath, 0755 );
+        snprintf( acPath, sizeof( acPath ), "%s/%s/bank0", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+        ( void )mkdir( acPath, 0755 );
+        snprintf( acPath, sizeof( acPath ), "%s/%s/bank0/num_lines", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+        snprintf( acDevice, sizeof( acDevice ), "%d", BUTTON_LINES );
+
+        if ( 0 == iWriteFile( acPath, acDevice ) )
+        {
+            snprintf( acPath, sizeof( acPath ), "%s/%s/live", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+            iReturn = iWriteFile( acPath, "1" );
+        }
+
+        if ( 0 == iReturn )
+        {
+            snprintf( acPath, sizeof( acPath ), "%s/%s/dev_name", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+            iReturn = iReadFile( acPath, acDevice, sizeof( acDevice ) );
+            snprintf( acPath, sizeof( acPath ), "%s/%s/bank0/chip_name", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+            iReturn |= iReadFile( acPath, pxMock->acChip, sizeof( pxMock->acChip ) );
+        }
+
+        if ( 0 == iReturn )
+        {
+            snprintf( pxMock->acPullPath, sizeof( pxMock->acPullPath ), "/sys/devices/platform/%s/%s/sim_gpio%d/pull",
+                      acDevice, pxMock->acChip, BUTTON_LINE );
+            iReturn = iSetLine( pxMock, 0 );
+        }
+
+        if ( 0 != iReturn )
+        {
+            vCloseMock( pxMock );
+        }
+    }
+
+    /* Otherwise the daemon reads the edges this tool makes up, timestamped as the kernel would. */
+    if ( 0 != iReturn )
+    {
+        if ( !bStandIn )
+        {
+            printf( "No gpio-sim (modprobe gpio-sim, with configfs mounted, as root): using the FIFO stand-in\n" );
+        }
+
+        pxMock->bStandIn = 1;
+        ( void )unlink( STAND_IN_FIFO );
+        iReturn = mkfifo( STAND_IN_FIFO, 0600 );
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iOpenStandIn( xMockLine_t * pxMock )
+{
+    uint64_t ullGiveUp = ullHUDViewMetricsNow() + REPLY_TIMEOUT_MS * 1000000ULL;
+
+    /* Opening a FIFO to write fails until there is a reader, so wait for the daemon to open its end. */
+    while ( ( 0 > ( pxMock->iLine = open( STAND_IN_FIFO, O_WRONLY | O_NONBLOCK | O_CLOEXEC ) ) ) && ( ENXIO == errno )
+            && ( ullHUDViewMetricsNow() < ullGiveUp ) )
+    {
+        usleep( 1000 );
+    }
+
+    if ( 0 <= pxMock->iLine )
+    {
+        ( void )fcntl( pxMock->iLine, F_SETFL, 0 );
+    }
+
+    return ( 0 <= pxMock->iLine ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vCloseMock( xMockLine_t * pxMock )
+{
+    char acPath[ 256 ];
+
+    if ( pxMock->bStandIn )
+    {
+        if ( 0 <= pxMock->iLine )
+        {
+            close( pxMock->iLine );
+        }
+
+        ( void )unlink( STAND_IN_FIFO );
+    }
+    else
+    {
+        snprintf( acPath, sizeof( acPath ), "%s/%s/live", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+        ( void )iWriteFile( acPath, "0" );
+        snprintf( acPath, sizeof( acPath ), "%s/%s/bank0", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+        ( void )rmdir( acPath );
+        snprintf( acPath, sizeof( acPath ), "%s/%s", GPIO_SIM_DIRECTORY, GPIO_SIM_NAME );
+        ( void )rmdir( acPath );
+    }
+
+    pxMock->iLine = -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint64_t ullDrive( xMockLine_t * pxMock, int bPressed, int iBounces )
+{
+    uint64_t ullStart = ullHUDViewMetricsNow();
+
+    /* The first edge, then the contact bouncing back and forth before it comes to rest. */
+    ( void )iSetLine( pxMock, bPressed );
+
+    for ( int iBounce = 0; iBounce < 2 * iBounces; iBounce++ )
+    {
+        uint64_t ullPrevious = pxMock->ullLastEdge;
+
+        vSleepUntil( ullPrevious + BOUNCE_MINIMUM_NS + ( uint64_t )rand() % ( BOUNCE_MAXIMUM_NS - BOUNCE_MINIMUM_NS ) );
+        ( void )iSetLine( pxMock, ( 0 == iBounce % 2 ) ? !bPressed : bPressed );
+        pxMock->bHeldUp |= ( HUDVIEW_BUTTON_DEBOUNCE_NS <= pxMock->ullLastEdge - ullPrevious );
+    }
+
+    return ullStart;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSpike( xMockLine_t * pxMock )
+{
+    uint64_t ullStart = 0;
+
+    ( void )iSetLine( pxMock, 1 );
+    ullStart = pxMock->ullLastEdge;
+    vSleepUntil( ullStart + 1 + ( uint64_t )rand() % SPIKE_MAXIMUM_NS );
+    ( void )iSetLine( pxMock, 0 );
+    pxMock->bHeldUp |= ( HUDVIEW_BUTTON_DEBOUNCE_NS <= pxMock->ullLastEdge - ullStart );
+    vSleepUntil( pxMock->ullLastEdge + 2 * HUDVIEW_BUTTON_DEBOUNCE_NS );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iSetLine( xMockLine_t * pxMock, int bPressed )
+{
+    struct gpio_v2_line_event xEvent;
+    int iReturn = 0;
+
+    /* The button pulls the line low. */
+    pxMock->ullLastEdge = ullHUDViewMetricsNow();
+
+    if ( pxMock->bStandIn )
+    {
+        memset( &xEvent, 0, sizeof( xEvent ) );
+        xEvent.timestamp_ns = pxMock->ullLastEdge;
+        xEvent.id = bPressed ? GPIO_V2_LINE_EVENT_FALLING_EDGE : GPIO_V2_LINE_EVENT_RISING_EDGE;
+        xEvent.offset = BUTTON_LINE;
+        xEvent.seqno = ++pxMock->ulSequence;
+        xEvent.line_seqno = pxMock->ulSequence;
+        iReturn = ( ( ssize_t )sizeof( xEvent ) == write( pxMock->iLine, &xEvent, sizeof( xEvent ) ) ) ? 0 : -1;
+    }
+    else
+    {
+        iReturn = iWriteFile( pxMock->acPullPath, bPressed ? "pull-down" : "pull-up" );
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iWriteFile( const char * pcPath, const char * pcValue )
+{
+    int iFile = open( pcPath, O_WRONLY | O_CLOEXEC );
+    int iReturn = -1;
+
+    if ( 0 <= iFile )
+    {
+        iReturn = ( ( ssize_t )strlen( pcValue ) == write( iFile, pcValue, strlen( pcValue ) ) ) ? 0 : -1;
+        close( iFile );
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iReadFile( const char * pcPath, char * pcValue, size_t ulSize )
+{
+    int iFile = open( pcPath, O_RDONLY | O_CLOEXEC );
+    ssize_t lRead = -1;
+
+    if ( 0 <= iFile )
+    {
+        lRead = read( iFile, pcValue, ulSize - 1 );
+        close( iFile );
+    }
+
+    if ( 0 >= lRead )
+    {
+        return -1;
+    }
+
+    /* Without the newline. */
+    pcValue[ lRead ] = '\0';
+    pcValue[ strcspn( pcValue, "\n" ) ] = '\0';
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static pid_t xSpawn( char * const * ppcArguments, int * piOutput )
+{
+    int aiPipe[ 2 ] = { -1, -1 };
+    pid_t xProcess = -1;
+
+    if ( ( NULL != piOutput ) && ( 0 > pipe2( aiPipe, O_CLOEXEC ) ) )
+    {
+        return -1;
+    }
+
+    xProcess = fork();
+
+    if ( 0 == xProcess )
+    {
+        if ( NULL != piOutput )
+        {
+            dup2( aiPipe[ 1 ], STDOUT_FILENO );
+        }
+
+        execvp( ppcArguments[ 0 ], ppcArguments );
+        _exit( 127 );
+    }
+
+    if ( NULL != piOutput )
+    {
+        close( aiPipe[ 1 ] );
+        *piOutput = aiPipe[ 0 ];
+    }
+
+    return xProcess;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static long lResidentKilobytes( pid_t xProcess )
+{
+    char acPath[ 64 ];
+    char acLine[ 256 ];
+    FILE * pxStatus = NULL;
+    long lReturn = 0;
+
+    snprintf( acPath, sizeof( acPath ), "/proc/%d/status", ( int )xProcess );
+    pxStatus = fopen( acPath, "r" );
+
+    while ( ( NULL != pxStatus ) && ( NULL != fgets( acLine, sizeof( acLine ), pxStatus ) ) )
+    {
+        if ( 0 == strncmp( acLine, "VmRSS:", 6 ) )
+        {
+            lReturn = strtol( acLine + 6, NULL, 10 );
+        }
+    }
+
+    if ( NULL != pxStatus )
+    {
+        fclose( pxStatus );
+    }
+
+    return lReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static eHUDViewButtonEvent_t eReadPress( int iOutput, int iTimeoutMs, uint64_t * pullReceived )
+{
+    struct pollfd xPoll = { iOutput, POLLIN, 0 };
+    char acRecord[ 64 ];
+    size_t ulLength = 0;
+    size_t ulStamp = 0;
+    eHUDViewButtonEvent_t eReturn = eHUDViewButtonEvent_None;
+
+    /* A line a press, taken a byte at a time so nothing after it is read. */
+    while ( ( sizeof( acRecord ) - 1 > ulLength ) && ( 0 < poll( &xPoll, 1, iTimeoutMs ) )
+            && ( 1 == read( iOutput, &acRecord[ ulLength ], 1 ) ) && ( '\n' != acRecord[ ulLength ] ) )
+    {
+        ulLength++;
+    }
+
+    acRecord[ ulLength ] = '\0';
+    ulStamp = ulHUDViewTraceParse( acRecord, ulLength, NULL );
+
+    if ( ( 0 < ulLength ) && ( NULL != pullReceived ) )
+    {
+        *pullReceived = ullHUDViewMetricsNow();
+    }
+
+    for ( int iEvent = eHUDViewButtonEvent_Short; ( 0 < ulLength ) && ( iEvent < eHUDViewButtonEventMax ); iEvent++ )
+    {
+        if ( 0 == strcmp( &acRecord[ ulStamp ], pcHUDViewButtonRecord( ( eHUDViewButtonEvent_t )iEvent ) ) )
+        {
+            eReturn = ( eHUDViewButtonEvent_t )iEvent;
+        }
+    }
+
+    return eReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSleepUntil( uint64_t ullTime )
+{
+    struct timespec xTime;
+
+    xTime.tv_sec = ( time_t )( ullTime / 1000000000ULL );
+    xTime.tv_nsec = ( long )( ullTime % 1000000000ULL );
+
+    while ( EINTR == clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xTime, NULL ) )
+    {
+        /* Keep sleeping. */
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iCompare( const void * pvA, const void * pvB )
+{
+    uint64_t ullA = *( const uint64_t * )pvA;
+    uint64_t ullB = *( const uint64_t * )pvB;
+
+    return ( ullA > ullB ) - ( ullA < ullB );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vReport( const char * pcName, uint64_t * pullValues, int iValues )
+{
+    if ( 0 >= iValues )
+    {
+        printf( "  %-8s none\n", pcName );
+        return;
+    }
+
+    qsort( pullValues, ( size_t )iValues, sizeof( pullValues[ 0 ] ), iCompare );
+    printf( "  %-8s p50 %8.3f  p99 %8.3f  max %8.3f  (%d)\n", pcName, pullValues[ iValues / 2 ] / 1e6,
+            pullValues[ ( iValues * 99 ) / 100 ] / 1e6, pullValues[ iValues - 1 ] / 1e6, iValues );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s decode [-n presses] [-b bounce edges] [-g glitches] [-s seed]\n", pcProgram );
+    fprintf( stderr, "       %s latency [-n presses] [-p receive_button] [-S]\n", pcProgram );
+    fprintf( stderr, "  decode   decode a made-up run of bouncing presses and spikes as the button daemon does\n" );
+    fprintf( stderr, "  latency  press a mock GPIO chip's button under the daemon and time its reports\n" );
+    fprintf( stderr, "  -S       use the daemon's FIFO stand-in even if gpio-sim is there\n" );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,2739 @@
+/** @file hudview_camera.c
+ *  @brief HUDView camera pipeline test and benchmark tool.
+ *
+ *  Usage: hudview_camera transform [-s WIDTHxHEIGHT] [-n repeats] [specification ...]
+ *         hudview_camera mjpeg [-s WIDTHxHEIGHT] [-q quality] [-n frames] [specification ...]
+ *         hudview_camera dashcam [-d directory] [-t seconds] [-f fps] [-x speed] [-c specification]
+ *                                [-w stall ms] [-e stall every writes] [-i impact seconds] [-m segment MiB]
+ *                                [-g segments]
+ *         hudview_camera extract segment.hvd output.rgb
+ *         hudview_camera ring [-t seconds] [-f fps] [-c specification] [-k name:delay ms[:newest] ...]
+ *         hudview_camera consumers
+ *         hudview_camera tap [-t seconds] [-d delay ms] [-N] [-o output.rgb]
+ *         hudview_camera enhance [-n frames] [-d noise]
+ *         hudview_camera rate [-s SPI clock Hz] [-t seconds] [-r ride directory [-f recorded fps] [-c specification]]
+ *         hudview_camera pixels [-s SPI clock Hz] [-n frames]
+ *
+ *  The transform command times the single pass orientation, crop and scaling stage that turns raw camera frames into
+ *  the display picture, for each camera specification in the form Control takes with --camera (e.g.
+ *  "320x240:rotate=90:hflip:area"), or for a range of capture resolutions and orientations by default. Each is run
+ *  with the SIMD kernels, with the scalar fallback and as three separate passes (orient, scale, convert) over whole
+ *  frames, and all three must produce the same picture.
+ *
+ *  The mjpeg command compares the camera sending raw RGB888 with it sending MJPEG, for each capture specification:
+ *  a synthetic scene is encoded once, then pushed through a pipe frame after frame and turned into the display
+ *  picture as Control does, from raw frames, from JPEGs decoded at full size, from JPEGs decoded at the reduced
+ *  scale Control would pick, and (where no further transform is needed) from JPEGs decoded straight to RGB565. Each
+ *  reports bytes per frame, wall and CPU time per frame, the frame rate that allows, and how the picture compares.
+ *
+ *  The dashcam command loop-records synthetic raw frames of the given camera specification into a directory at the
+ *  camera's frame rate, or a multiple of it, optionally stalling every so many card writes to stand in for a slow SD
+ *  card, and reporting an impact part way through. It reports how long handing a frame over took (the cost to the
+ *  display path), frames dropped, write times and the sustained write bandwidth, and which segments were kept. The
+ *  extract command turns a loop or event segment back into a raw clip for hudview_vision.
+ *
+ *  The ring command publishes synthetic raw frames at the camera's frame rate into a frame ring of its own, shared
+ *  with consumer processes that each hold every frame they take for a given time, taking the next frame in order or
+ *  the newest; one holds its first frame for ten minutes by default. It reports the cost of publishing, and for each
+ *  consumer the frames read and dropped and how far behind it fell; every frame is stamped, and a frame that changed
+ *  while a consumer held it counts as torn. The consumers command lists the consumers of Control's frame ring, and
+ *  tap joins it as one more, optionally saving the frames as a raw clip.
+ *
+ *  The enhance command runs the low-light stage over a dark synthetic night scene with moving headlights and sensor
+ *  noise of the given amplitude, with the SIMD kernels, with the scalar fallback (which must give the same picture),
+ *  with the tone curve alone and with the temporal filter alone. It reports the time per frame against the stage's
+ *  budget, how much the filter brings the picture closer to the noiseless scene and how much the curve lifts the mean
+ *  luma, and fails if the stage is over budget.
+ *
+ *  The rate command replays a ride through the camera pipeline three times: with the camera fixed at 10 fps as it
+ *  was, fixed at 30 fps, and with the adaptive frame rate. The ride is the Camera.rgb and GPS.trace of one recorded
+ *  with "Control --record", or by default a synthetic one that waits at a light, rides through town and onto a fast
+ *  road and stops again, with cars coming up from behind along the way. Each frame is turned into the display picture,
+ *  measured for motion and, up to the rear vision's rate, run through the optical flow, as Control does. It reports
+ *  the frames, CPU time and SPI traffic each way, how long the adaptive rate spent at each step, and for every alert
+ *  raised at 30 fps how much later the other two raised it and how long the display took to show the next frame.
+ *
+ *  The pixels command pushes camera pictures to the display as RGB565 and packed to 12-bit RGB444, with and without
+ *  ordered dithering, each packed band by band as the compositor does, with the SIMD kernels and with the scalar
+ *  fallback (which must give the same bytes). It reports the SPI bytes a frame takes in each mode, commands included,
+ *  the frame rate the link allows at the given clock, the CPU time packing takes, and how close what the panel shows
+ *  comes to the RGB565 picture, both as it is and smoothed over 4x4 pixels as the eye sees banding in a smooth sky.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_dashcam.h"
+#include "hudview_enhance.h"
+#include "hudview_flow.h"
+#include "hudview_framerate.h"
+#include "hudview_framering.h"
+#include "hudview_jpeg.h"
+#include "hudview_rgb444.h"
+#include "hudview_transform.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define TRANSFORM_PATHS     ( 3 )
+
+/* Raw RGB888 as the camera sends it now, and MJPEG decoded at full size, at the planned scale, and to RGB565. */
+#define MJPEG_PATHS         ( 4 )
+#define MJPEG_PATH_RAW      ( 0 )
+#define MJPEG_PATH_FULL     ( 1 )
+#define MJPEG_PATH_SCALED   ( 2 )
+#define MJPEG_PATH_RGB565   ( 3 )
+
+#define RING_BENCH_SHM_NAME "/hudview_frames_bench"
+
+/* The low-light stage as Control runs it, with the scalar fallback, with the tone curve alone and the filter alone. */
+#define ENHANCE_RUNS        ( 4 )
+#define ENHANCE_RUN_SIMD    ( 0 )
+#define ENHANCE_RUN_SCALAR  ( 1 )
+#define ENHANCE_RUN_TONE    ( 2 )
+#define ENHANCE_RUN_FILTER  ( 3 )
+
+/* The camera fixed at its old rate and at the most the controller asks for, and the adaptive rate. */
+#define RATE_POLICIES       ( 3 )
+#define RATE_POLICY_ADAPTIVE ( 2 )
+#define RATE_MAXIMUM_ALERTS ( 64 )
+
+/* What Control pushes for a camera frame: the whole picture, a window of command bytes per 8-row band of tiles, and
+ * the time the Pi takes per transfer. */
+#define RATE_FRAME_BYTES    ( 160 * 120 * 2 + 15 * 11 )
+#define RATE_TRANSFERS      ( 15 )
+#define RATE_TRANSFER_NS    ( 20000 )
+
+/* The camera as RGB565, and packed to RGB444 plain and dithered, each with the SIMD kernels and the scalar fallback.
+ * Packing is timed band by band over the pictures the compositor pushes: a scene, and a smooth dusk sky. */
+#define PIXEL_RUNS          ( 5 )
+#define PIXEL_RUN_RGB565    ( 0 )
+#define PIXEL_PICTURES      ( 2 )
+#define PIXEL_BAND_ROWS     ( 8 )
+#define PIXEL_SMOOTHING     ( 4 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    int iDescriptor;
+    const uint8_t * pucPayload;
+    size_t ulBytes;
+    int iFrames;
+} xPipeWriter_t;
+
+/* A ride the frame rate is replayed over: a recorded clip and its GPS fixes, or a synthetic ride. */
+typedef struct {
+    double dSeconds;
+    xHUDViewTransform_t xTransform;
+    uint8_t * pucFrame;
+
+    /* The recorded clip, mapped, and the speed (m/s) of each fix; none for the synthetic ride. */
+    const uint8_t * pucClip;
+    size_t ulClipBytes;
+    size_t ulFrameBytes;
+    long lClipFrames;
+    double dClipFramesPerSecond;
+    double * pdFixSeconds;
+    double * pdFixSpeeds;
+    size_t ulFixes;
+
+    /* The synthetic ride's day scene. */
+    uint8_t * pucScene;
+} xRide_t;
+
+/* How one way of setting the frame rate did over a ride. */
+typedef struct {
+    unsigned long ulFrames;
+    unsigned long ulVisionFrames;
+    double dCPUSeconds;
+    double dSPIBytes;
+    double dSPISeconds;
+    int64_t allMicrosecondsAt[ HUDVIEW_FRAMERATE_STEPS ];
+    unsigned long ulChanges;
+    int iAlerts;
+    double adAlertSeconds[ RATE_MAXIMUM_ALERTS ];
+    double adFrameIntervals[ RATE_MAXIMUM_ALERTS ];
+} xRateOutcome_t;
+
+/* A consumer of the ring bench, which takes frames in order or the newest, and holds each for a while. */
+typedef struct {
+    char acName[ HUDVIEW_FRAMERING_NAME_LENGTH ];
+    int iDelayMilliseconds;
+    int bNewest;
+    pid_t xPid;
+} xRingConsumer_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/* The display's picture as shipped, quarter turns of a portrait capture, and larger captures scaled down. */
+static const char * apcDefaultSpecifications[] = {
+    "160x120",
+    "160x120:hflip",
+    "160x120:rotate=180",
+    "120x160:rotate=90",
+    "120x160:rotate=270:hflip",
+    "320x240:area",
+    "320x240:rotate=90:area",
+    "320x240:bilinear",
+    "640x480:area",
+    "640x480:rotate=270:area",
+    "1280x720:area",
+    "1280x720:rotate=90:bilinear",
+    NULL
+};
+
+/* The capture sizes the camera would send MJPEG at, as shipped (mirrored) and as they are. */
+static const char * apcMJPEGSpecifications[] = {
+    "320x240",
+    "320x240:hflip",
+    "640x480",
+    "640x480:hflip",
+    "1280x720",
+    NULL
+};
+
+static const char * apcMJPEGPaths[ MJPEG_PATHS ] = { "raw rgb888", "mjpeg 1/1", "mjpeg scaled", "mjpeg rgb565" };
+static const char * apcEnhanceRuns[ ENHANCE_RUNS ] = { "curve + filter", "scalar", "curve only", "filter only" };
+static const char * apcRatePolicies[ RATE_POLICIES ] = { "fixed 10 fps", "fixed 30 fps", "adaptive" };
+static const int aiRatePolicyFramesPerSecond[ RATE_POLICIES ] = { 10, HUDVIEW_FRAMERATE_MAXIMUM_FPS, 0 };
+static const char * apcPixelRuns[ PIXEL_RUNS ] = { "rgb565", "rgb444", "rgb444 scalar", "rgb444 dither",
+                                                   "rgb444 dither sc." };
+static const char * apcPixelPictures[ PIXEL_PICTURES ] = { "scene", "sky" };
+
+/* The synthetic ride: when cars come up from behind (s), and its speed (m/s) at each of these times (s). */
+static const double adApproachOnsets[] = { 20.0, 80.0, 145.0 };
+static const double adSpeedTimes[] = { 0.0, 40.0, 55.0, 110.0, 125.0, 160.0, 170.0, 180.0 };
+static const double adSpeeds[] = { 0.0, 0.0, 14.0, 14.0, 28.0, 28.0, 0.0, 0.0 };
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iTransform( int argc, char ** argv );
+static int iBenchTransform( const char * pcSpecification, int iWidth, int iHeight, int iRepeats );
+static void vThreePass( const xHUDViewTransformConfig_t * pxConfig, const uint8_t * pucSource, uint8_t * pucOriented,
+                        uint8_t * pucScaled, uint16_t * pusRGB565, uint8_t * pucLuma );
+static void vSample( const uint8_t * pucImage, int iWidth, int iHeight, eHUDViewTransformFilter_t eFilter, int iX,
+                     int iY, int iOutputWidth, int iOutputHeight, uint8_t * pucPixel );
+static void vAxis( eHUDViewTransformFilter_t eFilter, int iPosition, int iOutput, int iLength, int * piFirst,
+                   int * piWeight, int * piTaps );
+static int iMJPEG( int argc, char ** argv );
+static int iBenchMJPEG( const char * pcSpecification, int iWidth, int iHeight, int iQuality, int iFrames );
+static void * pvWritePipe( void * pvWriter );
+static void vSynthesizeScene( uint8_t * pucFrame, int iWidth, int iHeight, int iStride );
+static unsigned long ulEncodeJpeg( const uint8_t * pucFrame, int iWidth, int iHeight, int iStride, int iQuality,
+                                   uint8_t ** ppucJpeg );
+static int iDashcam( int argc, char ** argv );
+static int iExtract( int argc, char ** argv );
+static int iRing( int argc, char ** argv );
+static int iRunRingConsumer( const xRingConsumer_t * pxConsumer );
+static int iParseRingConsumer( const char * pcSpecification, xRingConsumer_t * pxConsumer );
+static int iConsumers( int argc, char ** argv );
+static int iTap( int argc, char ** argv );
+static int iEnhance( int argc, char ** argv );
+static void vNightScene( const uint8_t * pucScene, int iFrame, int iNoise, uint8_t * pucClean, uint8_t * pucNoisy,
+                         int iStride );
+static double dSquaredError( const uint16_t * pusA, const uint16_t * pusB, int iPixels );
+static int iRate( int argc, char ** argv );
+static int iLoadRide( xRide_t * pxRide, const char * pcDirectory, const char * pcFormat, double dFramesPerSecond );
+static void vFreeRide( xRide_t * pxRide );
+static double dRideSpeed( const xRide_t * pxRide, double dSeconds );
+static const uint8_t * pucRideFrame( xRide_t * pxRide, double dSeconds, long * plSource );
+static void vSimulateRide( xRide_t * pxRide, int iPolicy, double dClockHz, xRateOutcome_t * pxOutcome );
+static int iPixels( int argc, char ** argv );
+static void vDuskSky( uint16_t * pusPicture, int iWidth, int iHeight );
+static double dSmoothedError( const uint16_t * pusA, const uint16_t * pusB, int iWidth, int iHeight );
+static int iCompareDoubles( const void * pvA, const void * pvB );
+static double dNow( void );
+static double dCPUNow( void );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    if ( 2 > argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Each command parses its own options after the command name. */
+    optind = 2;
+
+    if ( 0 == strcmp( argv[ 1 ], "transform" ) )
+    {
+        return iTransform( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "mjpeg" ) )
+    {
+        return iMJPEG( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "ring" ) )
+    {
+        return iRing( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "consumers" ) )
+    {
+        return iConsumers( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "tap" ) )
+    {
+        return iTap( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "dashcam" ) )
+    {
+        return iDashcam( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "extract" ) )
+    {
+        return iExtract( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "enhance" ) )
+    {
+        return iEnhance( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "rate" ) )
+    {
+        return iRate( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "pixels" ) )
+    {
+        return iPixels( argc, argv );
+    }
+
+    vUsage( argv[ 0 ] );
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iTransform( int argc, char ** argv )
+{
+    int iWidth = 160;
+    int iHeight = 120;
+    int iRepeats = 200;
+    int iFailures = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:n:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 's':
+            if ( 2 != sscanf( optarg, "%dx%d", &iWidth, &iHeight ) )
+            {
+                vUsage( argv[ 0 ] );
+                return -1;
+            }
+            break;
+
+        case 'n':
+            iRepeats = atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( 0 >= iRepeats )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    printf( "Output %dx%d, %d frames each, %s kernels\n", iWidth, iHeight, iRepeats, pcHUDViewTransformKernels() );
+    printf( "  %-30s %-18s %9s %9s %9s %8s\n", "camera", "region", "single", "scalar", "3-pass", "speedup" );
+
+    if ( optind < argc )
+    {
+        for ( int iArgument = optind; iArgument < argc; iArgument++ )
+        {
+            iFailures += ( 0 != iBenchTransform( argv[ iArgument ], iWidth, iHeight, iRepeats ) ) ? 1 : 0;
+        }
+    }
+    else
+    {
+        for ( int iSpecification = 0; NULL != apcDefaultSpecifications[ iSpecification ]; iSpecification++ )
+        {
+            iFailures += ( 0 != iBenchTransform( apcDefaultSpecifications[ iSpecification ], iWidth, iHeight,
+                                                 iRepeats ) ) ? 1 : 0;
+        }
+    }
+
+    printf( "Times are per frame; speedup is of the single pass over three passes. %d failed\n", iFailures );
+
+    return ( 0 == iFailures ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBenchTransform( const char * pcSpecification, int iWidth, int iHeight, int iRepeats )
+{
+    static xHUDViewTransform_t axTransforms[ 2 ];
+    xHUDViewTransformConfig_t xConfig;
+    const xHUDViewTransformConfig_t * pxApplied = &axTransforms[ 0 ].xConfig;
+    size_t ulPixels = ( size_t )( iWidth * iHeight );
+    uint8_t * pucSource = NULL;
+    uint8_t * pucOriented = NULL;
+    uint8_t * pucScaled = NULL;
+    uint16_t * apusRGB565[ TRANSFORM_PATHS ] = { NULL };
+    uint8_t * apucLuma[ TRANSFORM_PATHS ] = { NULL };
+    double adMilliseconds[ TRANSFORM_PATHS ] = { 0.0 };
+    char acRegion[ 32 ];
+    int iSourceBytes = 0;
+    int iMismatches = 0;
+    int iReturn = 0;
+
+    vHUDViewTransformDefaultConfig( &xConfig, iWidth, iHeight );
+
+    if ( ( 0 != iHUDViewTransformParse( pcSpecification, &xConfig ) )
+         || ( 0 != iHUDViewTransformInit( &axTransforms[ 0 ], &xConfig ) )
+         || ( 0 != iHUDViewTransformInit( &axTransforms[ 1 ], &xConfig ) ) )
+    {
+        printf( "  %-30s invalid\n", pcSpecification );
+        return -1;
+    }
+
+    vHUDViewTransformSetScalar( &axTransforms[ 1 ], 1 );
+    iSourceBytes = iHUDViewTransformSourceBytes( &xConfig );
+    pucSource = malloc( ( size_t )iSourceBytes );
+    pucOriented = malloc( ( size_t )( pxApplied->iCropWidth * pxApplied->iCropHeight * 3 ) );
+    pucScaled = malloc( ulPixels * 3 );
+
+    for ( int iPath = 0; iPath < TRANSFORM_PATHS; iPath++ )
+    {
+        apusRGB565[ iPath ] = malloc( ulPixels * sizeof( uint16_t ) );
+        apucLuma[ iPath ] = malloc( ulPixels );
+    }
+
+    /* Noise rather than a picture, so that any pixel taken from the wrong place shows up as a mismatch. */
+    srand( 1 );
+
+    for ( int iByte = 0; iByte < iSourceBytes; iByte++ )
+    {
+        pucSource[ iByte ] = ( uint8_t )rand();
+    }
+
+    for ( int iPath = 0; iPath < TRANSFORM_PATHS; iPath++ )
+    {
+        double dStart = dNow();
+
+        for ( int iRepeat = 0; iRepeat < iRepeats; iRepeat++ )
+        {
+            if ( 2 > iPath )
+            {
+                vHUDViewTransformApply( &axTransforms[ iPath ], pucSource, apusRGB565[ iPath ], apucLuma[ iPath ] );
+            }
+            else
+            {
+                vThreePass( pxApplied, pucSource, pucOriented, pucScaled, apusRGB565[ iPath ], apucLuma[ iPath ] );
+            }
+        }
+
+        adMilliseconds[ iPath ] = ( dNow() - dStart ) * 1e3 / iRepeats;
+    }
+
+    for ( int iPath = 1; iPath < TRANSFORM_PATHS; iPath++ )
+    {
+        for ( size_t ulPixel = 0; ulPixel < ulPixels; ulPixel++ )
+        {
+            if ( ( apusRGB565[ 0 ][ ulPixel ] != apusRGB565[ iPath ][ ulPixel ] )
+                 || ( apucLuma[ 0 ][ ulPixel ] != apucLuma[ iPath ][ ulPixel ] ) )
+            {
+                iMismatches++;
+            }
+        }
+    }
+
+    snprintf( acRegion, sizeof( acRegion ), "%dx%d+%d+%d", pxApplied->iCropWidth, pxApplied->iCropHeight,
+              pxApplied->iCropX, pxApplied->iCropY );
+    printf( "  %-30s %-18s %6.3f ms %6.3f ms %6.3f ms %7.2fx", pcSpecification, acRegion, adMilliseconds[ 0 ],
+            adMilliseconds[ 1 ], adMilliseconds[ 2 ], adMilliseconds[ 2 ] / adMilliseconds[ 0 ] );
+
+    if ( 0 != iMismatches )
+    {
+        printf( "  %d pixels differ\n", iMismatches );
+        iReturn = -1;
+    }
+    else
+    {
+        printf( "\n" );
+    }
+
+    for ( int iPath = 0; iPath < TRANSFORM_PATHS; iPath++ )
+    {
+        free( apusRGB565[ iPath ] );
+        free( apucLuma[ iPath ] );
+    }
+
+    free( pucScaled );
+    free( pucOriented );
+    free( pucSource );
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vThreePass( const xHUDViewTransformConfig_t * pxConfig, const uint8_t * pucSource, uint8_t * pucOriented,
+                        uint8_t * pucScaled, uint16_t * pusRGB565, uint8_t * pucLuma )
+{
+    int bQuarter = ( 90 == pxConfig->iRotation ) || ( 270 == pxConfig->iRotation );
+    int iCropWidth = pxConfig->iCropWidth;
+    int iCropHeight = pxConfig->iCropHeight;
+    int iOrientedWidth = bQuarter ? iCropHeight : iCropWidth;
+    int iOrientedHeight = bQuarter ? iCropWidth : iCropHeight;
+    int iPixels = pxConfig->iDestinationWidth * pxConfig->iDestinationHeight;
+
+    /* Turn and mirror the region of interest a pixel at a time, the way it would be done without the tables. */
+    for ( int iY = 0; iY < iOrientedHeight; iY++ )
+    {
+        for ( int iX = 0; iX < iOrientedWidth; iX++ )
+        {
+            int iTurnedX = pxConfig->bFlipHorizontal ? iOrientedWidth - 1 - iX : iX;
+            int iTurnedY = pxConfig->bFlipVertical ? iOrientedHeight - 1 - iY : iY;
+            int iSourceX = iTurnedX;
+            int iSourceY = iTurnedY;
+            const uint8_t * pucPixel = NULL;
+
+            switch ( pxConfig->iRotation )
+            {
+            case 90:
+                iSourceX = iTurnedY;
+                iSourceY = iCropHeight - 1 - iTurnedX;
+                break;
+
+            case 180:
+                iSourceX = iCropWidth - 1 - iTurnedX;
+                iSourceY = iCropHeight - 1 - iTurnedY;
+                break;
+
+            case 270:
+                iSourceX = iCropWidth - 1 - iTurnedY;
+                iSourceY = iTurnedX;
+                break;
+
+            default:
+                break;
+            }
+
+            pucPixel = pucSource + ( pxConfig->iCropY + iSourceY ) * pxConfig->iSourceStride
+                       + ( pxConfig->iCropX + iSourceX ) * 3;
+            memcpy( &pucOriented[ ( iY * iOrientedWidth + iX ) * 3 ], pucPixel, 3 );
+        }
+    }
+
+    /* Then scale it to the output, and only then convert it. */
+    for ( int iY = 0; iY < pxConfig->iDestinationHeight; iY++ )
+    {
+        for ( int iX = 0; iX < pxConfig->iDestinationWidth; iX++ )
+        {
+            vSample( pucOriented, iOrientedWidth, iOrientedHeight, pxConfig->eFilter, iX, iY,
+                     pxConfig->iDestinationWidth, pxConfig->iDestinationHeight,
+                     &pucScaled[ ( iY * pxConfig->iDestinationWidth + iX ) * 3 ] );
+        }
+    }
+
+    for ( int iPixel = 0; iPixel < iPixels; iPixel++ )
+    {
+        const uint8_t * pucPixel = &pucScaled[ iPixel * 3 ];
+
+        pusRGB565[ iPixel ] = ( uint16_t )( ( ( pucPixel[ 0 ] & 0xF8 ) << 8 ) | ( ( pucPixel[ 1 ] & 0xFC ) << 3 )
+                                            | ( pucPixel[ 2 ] >> 3 ) );
+        pucLuma[ iPixel ] = HUDVIEW_FLOW_LUMA( pucPixel[ 0 ], pucPixel[ 1 ], pucPixel[ 2 ] );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSample( const uint8_t * pucImage, int iWidth, int iHeight, eHUDViewTransformFilter_t eFilter, int iX,
+                     int iY, int iOutputWidth, int iOutputHeight, uint8_t * pucPixel )
+{
+    int iFirstX = 0;
+    int iFirstY = 0;
+    int iWeightX = 0;
+    int iWeightY = 0;
+    int iTapsX = 1;
+    int iTapsY = 1;
+    int iNextX = ( 1 < iWidth ) ? 1 : 0;
+    int iNextY = ( 1 < iHeight ) ? 1 : 0;
+
+    /* The same size needs no filtering at all. */
+    if ( ( iWidth == iOutputWidth ) && ( iHeight == iOutputHeight ) )
+    {
+        eFilter = eHUDViewTransformFilter_Nearest;
+    }
+
+    vAxis( eFilter, iX, iOutputWidth, iWidth, &iFirstX, &iWeightX, &iTapsX );
+    vAxis( eFilter, iY, iOutputHeight, iHeight, &iFirstY, &iWeightY, &iTapsY );
+
+    for ( int iChannel = 0; iChannel < 3; iChannel++ )
+    {
+        const uint8_t * pucTop = &pucImage[ ( iFirstY * iWidth + iFirstX ) * 3 + iChannel ];
+        const uint8_t * pucBottom = pucTop + iNextY * iWidth * 3;
+        uint32_t ulSum = 0;
+
+        switch ( eFilter )
+        {
+        case eHUDViewTransformFilter_Bilinear:
+            ulSum = ( pucTop[ 0 ] * ( 256 - iWeightX ) + pucTop[ iNextX * 3 ] * iWeightX ) * ( 256 - iWeightY )
+                    + ( pucBottom[ 0 ] * ( 256 - iWeightX ) + pucBottom[ iNextX * 3 ] * iWeightX ) * iWeightY;
+            pucPixel[ iChannel ] = ( uint8_t )( ( ulSum + 32768 ) >> 16 );
+            break;
+
+        case eHUDViewTransformFilter_Area:
+            for ( int iTapY = 0; iTapY < iTapsY; iTapY++ )
+            {
+                for ( int iTapX = 0; iTapX < iTapsX; iTapX++ )
+                {
+                    ulSum += pucTop[ ( iTapY * iWidth + iTapX ) * 3 ];
+                }
+            }
+
+            pucPixel[ iChannel ] = ( uint8_t )( ( ulSum + iTapsX * iTapsY / 2 ) / ( iTapsX * iTapsY ) );
+            break;
+
+        default:
+            pucPixel[ iChannel ] = pucTop[ 0 ];
+            break;
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vAxis( eHUDViewTransformFilter_t eFilter, int iPosition, int iOutput, int iLength, int * piFirst,
+                   int * piWeight, int * piTaps )
+{
+    double dScale = ( double )iLength / iOutput;
+    int iFirst = 0;
+
+    switch ( eFilter )
+    {
+    case eHUDViewTransformFilter_Bilinear:
+        /* Centres aligned, in 1/256ths of a pixel; the last pixel is reached as the far end of the one before. */
+        iFirst = ( int )( ( ( 2 * ( long long )iPosition + 1 ) * iLength * 256 ) / ( 2 * iOutput ) ) - 128;
+        iFirst = ( 0 > iFirst ) ? 0 : ( ( ( iLength - 1 ) * 256 < iFirst ) ? ( iLength - 1 ) * 256 : iFirst );
+        *piWeight = iFirst & 255;
+        *piFirst = iFirst >> 8;
+
+        if ( *piFirst >= iLength - 1 )
+        {
+            *piFirst = ( 1 < iLength ) ? iLength - 2 : 0;
+            *piWeight = ( 1 < iLength ) ? 256 : 0;
+        }
+        break;
+
+    case eHUDViewTransformFilter_Area:
+        *piFirst = ( int )( ( long long )iPosition * iLength / iOutput );
+        *piFirst = ( *piFirst >= iLength ) ? iLength - 1 : *piFirst;
+        *piTaps = ( int )( ( ( long long )iPosition + 1 ) * iLength / iOutput ) - *piFirst;
+        *piTaps = ( 0 < *piTaps ) ? *piTaps : 1;
+        break;
+
+    default:
+        *piFirst = ( int )( ( iPosition + 0.5 ) * dScale );
+        *piFirst = ( *piFirst >= iLength ) ? iLength - 1 : *piFirst;
+        break;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iMJPEG( int argc, char ** argv )
+{
+    int iWidth = 160;
+    int iHeight = 120;
+    int iQuality = 85;
+    int iFrames = 200;
+    int iFailures = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:q:n:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 's':
+            if ( 2 != sscanf( optarg, "%dx%d", &iWidth, &iHeight ) )
+            {
+                vUsage( argv[ 0 ] );
+                return -1;
+            }
+            break;
+
+        case 'q':
+            iQuality = atoi( optarg );
+            break;
+
+        case 'n':
+            iFrames = atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0 >= iFrames ) || ( 1 > iQuality ) || ( 100 < iQuality ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    printf( "Output %dx%d, %d frames each through a pipe, JPEG quality %d, fast DCT\n", iWidth, iHeight, iFrames,
+            iQuality );
+
+    if ( optind < argc )
+    {
+        for ( int iArgument = optind; iArgument < argc; iArgument++ )
+        {
+            iFailures += ( 0 != iBenchMJPEG( argv[ iArgument ], iWidth, iHeight, iQuality, iFrames ) ) ? 1 : 0;
+        }
+    }
+    else
+    {
+        for ( int iSpecification = 0; NULL != apcMJPEGSpecifications[ iSpecification ]; iSpecification++ )
+        {
+            iFailures += ( 0 != iBenchMJPEG( apcMJPEGSpecifications[ iSpecification ], iWidth, iHeight, iQuality,
+                                             iFrames ) ) ? 1 : 0;
+        }
+    }
+
+    printf( "Times are per frame, from the camera's write to the display picture; CPU includes the writer. "
+            "PSNR is of the luma against the raw path. %d failed\n", iFailures );
+
+    return ( 0 == iFailures ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBenchMJPEG( const char * pcSpecification, int iWidth, int iHeight, int iQuality, int iFrames )
+{
+    static xHUDViewTransform_t xRawTransform;
+    static xHUDViewTransform_t xDecodedTransform;
+    xHUDViewTransformConfig_t xCapture;
+    xHUDViewTransformConfig_t xDecoded;
+    xHUDViewJpeg_t xJpeg;
+    xPipeWriter_t xWriter;
+    pthread_t xThread;
+    size_t ulPixels = ( size_t )( iWidth * iHeight );
+    size_t ulRawBytes = 0;
+    size_t ulDecodedBytes = 0;
+    unsigned long ulJpegBytes = 0;
+    uint8_t * pucRaw = NULL;
+    uint8_t * pucJpeg = NULL;
+    uint8_t * pucReceived = NULL;
+    uint8_t * pucFull = NULL;
+    uint8_t * pucScaled = NULL;
+    uint16_t * pusPicture = NULL;
+    uint8_t * apucLuma[ MJPEG_PATHS ] = { NULL };
+    int aiPipe[ 2 ] = { -1, -1 };
+    int iDenominator = 1;
+    int iFullStride = 0;
+    int iScaledStride = 0;
+    int iDecodedWidth = 0;
+    int iDecodedHeight = 0;
+    int bIdentity = 0;
+    int iErrors = 0;
+
+    vHUDViewTransformDefaultConfig( &xCapture, iWidth, iHeight );
+
+    if ( ( 0 != iHUDViewTransformParse( pcSpecification, &xCapture ) )
+         || ( 0 != iHUDViewTransformInit( &xRawTransform, &xCapture ) )
+         || ( 0 != iHUDViewJpegPlan( &xCapture, &xDecoded, &iDenominator ) )
+         || ( 0 != iHUDViewTransformInit( &xDecodedTransform, &xDecoded ) ) )
+    {
+        printf( "  %-30s invalid\n", pcSpecification );
+        return -1;
+    }
+
+    /* Straight to RGB565 only works where the decoded picture is already the display picture. */
+    bIdentity = xDecodedTransform.bExact && !xDecodedTransform.bTranspose && !xDecodedTransform.bReverseColumns
+                && !xDecodedTransform.bReverseRows && ( xDecoded.iCropWidth == xDecoded.iSourceWidth )
+                && ( xDecoded.iCropHeight == xDecoded.iSourceHeight );
+
+    ulRawBytes = ( size_t )iHUDViewTransformSourceBytes( &xCapture );
+    ulDecodedBytes = ( size_t )iHUDViewTransformSourceBytes( &xDecoded );
+    iFullStride = HUDVIEW_TRANSFORM_ALIGN( xCapture.iSourceWidth, HUDVIEW_TRANSFORM_CAPTURE_WIDTH_ALIGN ) * 3;
+    iScaledStride = HUDVIEW_TRANSFORM_ALIGN( xDecoded.iSourceWidth, HUDVIEW_TRANSFORM_CAPTURE_WIDTH_ALIGN ) * 3;
+    pucRaw = calloc( ulRawBytes, 1 );
+    pucReceived = malloc( ulRawBytes );
+    pucFull = malloc( ulRawBytes );
+    pucScaled = malloc( ulDecodedBytes );
+    pusPicture = malloc( ulPixels * sizeof( uint16_t ) );
+
+    for ( int iPath = 0; iPath < MJPEG_PATHS; iPath++ )
+    {
+        apucLuma[ iPath ] = calloc( ulPixels, 1 );
+    }
+
+    vSynthesizeScene( pucRaw, xCapture.iSourceWidth, xCapture.iSourceHeight, iFullStride );
+    ulJpegBytes = ulEncodeJpeg( pucRaw, xCapture.iSourceWidth, xCapture.iSourceHeight, iFullStride, iQuality,
+                                &pucJpeg );
+    iHUDViewJpegInit( &xJpeg, 1 );
+
+    printf( "  %s: %zu bytes raw, %lu bytes JPEG (%.1f:1), decoded at 1/%d as %dx%d\n", pcSpecification, ulRawBytes,
+            ulJpegBytes, ( double )ulRawBytes / ulJpegBytes, iDenominator, xDecoded.iSourceWidth,
+            xDecoded.iSourceHeight );
+    printf( "    %-14s %9s %10s %10s %9s %10s\n", "path", "bytes", "wall", "cpu", "fps", "psnr" );
+
+    for ( int iPath = 0; iPath < MJPEG_PATHS; iPath++ )
+    {
+        double dWall = 0.0;
+        double dCPU = 0.0;
+        double dMeanSquare = 0.0;
+
+        if ( ( MJPEG_PATH_RGB565 == iPath ) && !bIdentity )
+        {
+            printf( "    %-14s %9s   (the decoded picture still needs transforming)\n", apcMJPEGPaths[ iPath ], "-" );
+            continue;
+        }
+
+        /* The camera's side: frames written into a pipe as fast as it takes them, standing in for the FIFO. */
+        xWriter.pucPayload = ( MJPEG_PATH_RAW == iPath ) ? pucRaw : pucJpeg;
+        xWriter.ulBytes = ( MJPEG_PATH_RAW == iPath ) ? ulRawBytes : ulJpegBytes;
+        xWriter.iFrames = iFrames;
+
+        if ( 0 != pipe( aiPipe ) )
+        {
+            perror( "pipe" );
+            return -1;
+        }
+
+        xWriter.iDescriptor = aiPipe[ 1 ];
+        dWall = dNow();
+        dCPU = dCPUNow();
+        pthread_create( &xThread, NULL, pvWritePipe, &xWriter );
+
+        for ( int iFrame = 0; iFrame < iFrames; iFrame++ )
+        {
+            size_t ulReceived = 0;
+
+            while ( ulReceived < xWriter.ulBytes )
+            {
+                ssize_t lRead = read( aiPipe[ 0 ], pucReceived + ulReceived, xWriter.ulBytes - ulReceived );
+
+                if ( 0 >= lRead )
+                {
+                    break;
+                }
+
+                ulReceived += ( size_t )lRead;
+            }
+
+            /* As Control does, a compressed frame is only taken once its end marker has been found. */
+            if ( ( MJPEG_PATH_RAW != iPath )
+                 && ( ulReceived - 2 != ulHUDViewJpegFindMarker( pucReceived, ulReceived, 2,
+                                                                 HUDVIEW_JPEG_MARKER_EOI ) ) )
+            {
+                iErrors++;
+            }
+
+            switch ( iPath )
+            {
+            case MJPEG_PATH_RAW:
+                vHUDViewTransformApply( &xRawTransform, pucReceived, pusPicture, apucLuma[ iPath ] );
+                break;
+
+            case MJPEG_PATH_FULL:
+                iErrors += iHUDViewJpegDecode( &xJpeg, pucReceived, ulReceived, 1, eHUDViewJpegOutput_RGB888, pucFull,
+                                               iFullStride, xCapture.iSourceWidth, xCapture.iSourceHeight, NULL,
+                                               &iDecodedWidth, &iDecodedHeight ) ? 1 : 0;
+                vHUDViewTransformApply( &xRawTransform, pucFull, pusPicture, apucLuma[ iPath ] );
+                break;
+
+            case MJPEG_PATH_SCALED:
+                iErrors += iHUDViewJpegDecode( &xJpeg, pucReceived, ulReceived, iDenominator,
+                                               eHUDViewJpegOutput_RGB888, pucScaled, iScaledStride,
+                                               xDecoded.iSourceWidth, xDecoded.iSourceHeight, NULL, &iDecodedWidth,
+                                               &iDecodedHeight ) ? 1 : 0;
+                vHUDViewTransformApply( &xDecodedTransform, pucScaled, pusPicture, apucLuma[ iPath ] );
+                break;
+
+            default:
+                iErrors += iHUDViewJpegDecode( &xJpeg, pucReceived, ulReceived, iDenominator,
+                                               eHUDViewJpegOutput_RGB565, ( uint8_t * )pusPicture,
+                                               iWidth * ( int )sizeof( uint16_t ), iWidth, iHeight, apucLuma[ iPath ],
+                                               &iDecodedWidth, &iDecodedHeight ) ? 1 : 0;
+                break;
+            }
+        }
+
+        pthread_join( xThread, NULL );
+        dCPU = ( dCPUNow() - dCPU ) * 1e3 / iFrames;
+        dWall = ( dNow() - dWall ) * 1e3 / iFrames;
+        close( aiPipe[ 0 ] );
+        close( aiPipe[ 1 ] );
+
+        for ( size_t ulPixel = 0; ulPixel < ulPixels; ulPixel++ )
+        {
+            double dDifference = ( double )apucLuma[ iPath ][ ulPixel ] - apucLuma[ MJPEG_PATH_RAW ][ ulPixel ];
+
+            dMeanSquare += dDifference * dDifference / ulPixels;
+        }
+
+        printf( "    %-14s %9zu %7.3f ms %7.3f ms %9.0f", apcMJPEGPaths[ iPath ], xWriter.ulBytes, dWall, dCPU,
+                1e3 / dWall );
+
+        if ( MJPEG_PATH_RAW == iPath )
+        {
+            printf( " %10s\n", "-" );
+        }
+        else
+        {
+            printf( " %7.1f dB\n", ( 0.0 < dMeanSquare ) ? 10.0 * log10( 255.0 * 255.0 / dMeanSquare ) : 99.0 );
+        }
+    }
+
+    if ( 0 != iErrors )
+    {
+        printf( "    %d frames failed to decode: %s\n", iErrors, pcHUDViewJpegError( &xJpeg ) );
+    }
+
+    vHUDViewJpegDestroy( &xJpeg );
+
+    for ( int iPath = 0; iPath < MJPEG_PATHS; iPath++ )
+    {
+        free( apucLuma[ iPath ] );
+    }
+
+    free( pusPicture );
+    free( pucScaled );
+    free( pucFull );
+    free( pucReceived );
+    free( pucJpeg );
+    free( pucRaw );
+
+    return ( 0 == iErrors ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void * pvWritePipe( void * pvWriter )
+{
+    const xPipeWriter_t * pxWriter = ( const xPipeWriter_t * )pvWriter;
+
+    for ( int iFrame = 0; iFrame < pxWriter->iFrames; iFrame++ )
+    {
+        size_t ulWritten = 0;
+
+        while ( ulWritten < pxWriter->ulBytes )
+        {
+            ssize_t lWritten = write( pxWriter->iDescriptor, pxWriter->pucPayload + ulWritten,
+                                      pxWriter->ulBytes - ulWritten );
+
+            if ( 0 >= lWritten )
+            {
+                return NULL;
+            }
+
+            ulWritten += ( size_t )lWritten;
+        }
+    }
+
+    return NULL;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSynthesizeScene( uint8_t * pucFrame, int iWidth, int iHeight, int iStride )
+{
+    /* A rear view: sky fading to a grey road with lane markings, a couple of cars and a little sensor noise, so the
+     * JPEG is about as large as the camera's. */
+    srand( 1 );
+
+    for ( int iY = 0; iY < iHeight; iY++ )
+    {
+        for ( int iX = 0; iX < iWidth; iX++ )
+        {
+            uint8_t * pucPixel = pucFrame + iY * iStride + iX * 3;
+            int iNoise = rand() % 9 - 4;
+            int iRed = 0;
+            int iGreen = 0;
+            int iBlue = 0;
+
+            if ( iY < iHeight * 2 / 5 )
+            {
+                iRed = 120 + 80 * iY / iHeight;
+                iGreen = 160 + 60 * iY / iHeight;
+                iBlue = 230;
+            }
+            else
+            {
+                iRed = 90 + 40 * iY / iHeight;
+                iGreen = iRed;
+                iBlue = iRed + 5;
+
+                /* Dashed centre line converging on the horizon. */
+                if ( ( abs( iX - iWidth / 2 ) < 1 + iY * iWidth / ( iHeight * 80 ) ) && ( 0 == ( iY / 8 ) % 2 ) )
+                {
+                    iRed = iGreen = iBlue = 235;
+                }
+            }
+
+            /* Two cars, with darker windows. */
+            if ( ( iX > iWidth / 5 ) && ( iX < iWidth * 2 / 5 ) && ( iY > iHeight / 2 ) && ( iY < iHeight * 3 / 4 ) )
+            {
+                iRed = 170;
+                iGreen = 30;
+                iBlue = 35;
+
+                if ( iY < iHeight * 3 / 5 )
+                {
+                    iRed = iGreen = iBlue = 40;
+                }
+            }
+
+            if ( ( iX > iWidth * 3 / 5 ) && ( iX < iWidth * 7 / 10 ) && ( iY > iHeight * 9 / 20 )
+                 && ( iY < iHeight * 11 / 20 ) )
+            {
+                iRed = 30;
+                iGreen = 60;
+                iBlue = 140;
+            }
+
+            pucPixel[ 0 ] = ( uint8_t )( ( iRed + iNoise < 0 ) ? 0 : ( iRed + iNoise > 255 ) ? 255 : iRed + iNoise );
+            pucPixel[ 1 ] = ( uint8_t )( ( iGreen + iNoise < 0 ) ? 0 : ( iGreen + iNoise > 255 ) ? 255
+                                                                                                 : iGreen + iNoise );
+            pucPixel[ 2 ] = ( uint8_t )( ( iBlue + iNoise < 0 ) ? 0 : ( iBlue + iNoise > 255 ) ? 255 : iBlue + iNoise );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static unsigned long ulEncodeJpeg( const uint8_t * pucFrame, int iWidth, int iHeight, int iStride, int iQuality,
+                                   uint8_t ** ppucJpeg )
+{
+    struct jpeg_compress_struct xCompress;
+    struct jpeg_error_mgr xError;
+    unsigned long ulBytes = 0;
+    JSAMPROW pucRow = NULL;
+
+    /* 4:2:0 baseline, as the camera's MJPEG encoder produces. */
+    xCompress.err = jpeg_std_error( &xError );
+    jpeg_create_compress( &xCompress );
+    jpeg_mem_dest( &xCompress, ppucJpeg, &ulBytes );
+    xCompress.image_width = ( JDIMENSION )iWidth;
+    xCompress.image_height = ( JDIMENSION )iHeight;
+    xCompress.input_components = 3;
+    xCompress.in_color_space = JCS_RGB;
+    jpeg_set_defaults( &xCompress );
+    jpeg_set_quality( &xCompress, iQuality, TRUE );
+    jpeg_start_compress( &xCompress, TRUE );
+
+    while ( xCompress.next_scanline < xCompress.image_height )
+    {
+        pucRow = ( JSAMPROW )( pucFrame + xCompress.next_scanline * ( size_t )iStride );
+        jpeg_write_scanlines( &xCompress, &pucRow, 1 );
+    }
+
+    jpeg_finish_compress( &xCompress );
+    jpeg_destroy_compress( &xCompress );
+
+    return ulBytes;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iDashcam( int argc, char ** argv )
+{
+    xHUDViewDashcam_t * pxDashcam = NULL;
+    xHUDViewDashcamStatistics_t xStatistics;
+    xHUDViewTransformConfig_t xConfig;
+    const char * pcDirectory = "/tmp/hudview_dashcam";
+    const char * pcFormat = "160x120";
+    struct timespec xNext;
+    struct timespec xNow;
+    uint8_t * pucFrame = NULL;
+    double * pdEnqueueMicroseconds = NULL;
+    double dSeconds = 60.0;
+    double dFramesPerSecond = 10.0;
+    double dSpeed = 1.0;
+    double dImpactSeconds = -1.0;
+    double dElapsed = 0.0;
+    double dStart = 0.0;
+    int64_t llPeriodNanoseconds = 0;
+    int64_t llFirstNanoseconds = 0;
+    uint64_t ullSegmentMebibytes = 4;
+    size_t ulFrameBytes = 0;
+    int iSegments = 4;
+    int iStallMilliseconds = 0;
+    int iStallEvery = 10;
+    int iFrames = 0;
+    int iFrame = 0;
+    int bImpactReported = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "d:t:f:x:c:w:e:i:m:g:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'd':
+            pcDirectory = optarg;
+            break;
+
+        case 't':
+            dSeconds = atof( optarg );
+            break;
+
+        case 'f':
+            dFramesPerSecond = atof( optarg );
+            break;
+
+        case 'x':
+            dSpeed = atof( optarg );
+            break;
+
+        case 'c':
+            pcFormat = optarg;
+            break;
+
+        case 'w':
+            iStallMilliseconds = atoi( optarg );
+            break;
+
+        case 'e':
+            iStallEvery = atoi( optarg );
+            break;
+
+        case 'i':
+            dImpactSeconds = atof( optarg );
+            break;
+
+        case 'm':
+            ullSegmentMebibytes = strtoull( optarg, NULL, 10 );
+            break;
+
+        case 'g':
+            iSegments = atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    vHUDViewTransformDefaultConfig( &xConfig, 160, 120 );
+
+    if ( ( 0.0 >= dSeconds ) || ( 0.0 >= dFramesPerSecond ) || ( 0.0 >= dSpeed ) || ( 0 >= iStallEvery )
+         || ( 0 != iHUDViewTransformParse( pcFormat, &xConfig ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Frames are the camera's raw output for the format, as Control hands them to the dashcam. */
+    ulFrameBytes = ( size_t )iHUDViewTransformSourceBytes( &xConfig );
+    iFrames = ( int )( dSeconds * dFramesPerSecond );
+    llPeriodNanoseconds = ( int64_t )( 1e9 / dFramesPerSecond );
+    pxDashcam = malloc( sizeof( xHUDViewDashcam_t ) );
+    pucFrame = malloc( ulFrameBytes );
+    pdEnqueueMicroseconds = calloc( ( size_t )iFrames + 1, sizeof( double ) );
+
+    if ( ( NULL == pxDashcam ) || ( NULL == pucFrame ) || ( NULL == pdEnqueueMicroseconds ) )
+    {
+        perror( "malloc" );
+        return -1;
+    }
+
+    if ( ( 0 != mkdir( pcDirectory, 0755 ) ) && ( EEXIST != errno ) )
+    {
+        perror( pcDirectory );
+        return -1;
+    }
+
+    dStart = dNow();
+
+    if ( 0 != iHUDViewDashcamOpen( pxDashcam, pcDirectory, pcFormat, ( uint32_t )ulFrameBytes,
+                                   ullSegmentMebibytes * 1024 * 1024, iSegments ) )
+    {
+        perror( pcDirectory );
+        return -1;
+    }
+
+    printf( "Dashcam %s: %d x %llu MiB segments preallocated in %.1f ms\n", pcDirectory, iSegments,
+            ( unsigned long long )ullSegmentMebibytes, ( dNow() - dStart ) * 1e3 );
+    printf( "Recording %d frames of %s (%zu bytes) at %.1f fps x%.1f, %.2f MiB/s", iFrames, pcFormat, ulFrameBytes,
+            dFramesPerSecond, dSpeed, ulFrameBytes * dFramesPerSecond * dSpeed / 1048576.0 );
+
+    if ( 0 < iStallMilliseconds )
+    {
+        printf( ", every %d writes stalled by %d ms", iStallEvery, iStallMilliseconds );
+        vHUDViewDashcamInjectStalls( pxDashcam, iStallEvery, iStallMilliseconds );
+    }
+
+    printf( "\n" );
+
+    /* Frame times are the ride's, a frame period apart whatever the speed, so the pre-roll is in ride time. */
+    clock_gettime( CLOCK_REALTIME, &xNow );
+    llFirstNanoseconds = ( int64_t )xNow.tv_sec * 1000000000LL + xNow.tv_nsec;
+    clock_gettime( CLOCK_MONOTONIC, &xNext );
+    dStart = dNow();
+
+    for ( iFrame = 0; iFrame < iFrames; iFrame++ )
+    {
+        int64_t llFrameNanoseconds = llFirstNanoseconds + iFrame * llPeriodNanoseconds;
+        double dEnqueue = 0.0;
+
+        /* A different picture each frame, so nothing downstream can get away with writing the same one. */
+        memset( pucFrame, iFrame & 0xFF, ulFrameBytes );
+        memcpy( pucFrame, &iFrame, sizeof( iFrame ) );
+
+        dEnqueue = dNow();
+        ( void )iHUDViewDashcamRecordFrame( pxDashcam, pucFrame, llFrameNanoseconds );
+        pdEnqueueMicroseconds[ iFrame ] = ( dNow() - dEnqueue ) * 1e6;
+
+        if ( ( 0.0 <= dImpactSeconds ) && !bImpactReported && ( iFrame >= dImpactSeconds * dFramesPerSecond ) )
+        {
+            printf( "Impact at %.1f s\n", iFrame / dFramesPerSecond );
+            vHUDViewDashcamReportImpact( pxDashcam, llFrameNanoseconds );
+            bImpactReported = 1;
+        }
+
+        xNext.tv_nsec += ( long )( llPeriodNanoseconds / dSpeed );
+
+        while ( 1000000000L <= xNext.tv_nsec )
+        {
+            xNext.tv_nsec -= 1000000000L;
+            xNext.tv_sec++;
+        }
+
+        clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xNext, NULL );
+    }
+
+    /* Closing writes out the queue and keeps the last segment; the writer has finished, so its counts are final. */
+    ( void )iHUDViewDashcamClose( pxDashcam );
+    dElapsed = dNow() - dStart;
+    xStatistics = pxDashcam->xStatistics;
+    qsort( pdEnqueueMicroseconds, ( size_t )iFrames, sizeof( double ), iCompareDoubles );
+
+    printf( "Frames: %llu offered, %llu written, %llu dropped\n", ( unsigned long long )xStatistics.ullFramesOffered,
+            ( unsigned long long )xStatistics.ullFramesWritten, ( unsigned long long )xStatistics.ullFramesDropped );
+    printf( "Enqueue: %.1f us median, %.1f us p99, %.1f us max\n", pdEnqueueMicroseconds[ iFrames / 2 ],
+            pdEnqueueMicroseconds[ iFrames * 99 / 100 ], pdEnqueueMicroseconds[ iFrames - 1 ] );
+    printf( "Writes: %llu %s, %.2f ms mean, %.2f ms max, queue high water %d of %d\n",
+            ( unsigned long long )xStatistics.ullWrites, xStatistics.bDirect ? "direct" : "buffered",
+            ( 0 < xStatistics.ullWrites ) ? xStatistics.llWriteNanoseconds / 1e6 / xStatistics.ullWrites : 0.0,
+            xStatistics.llMaximumWriteNanoseconds / 1e6, xStatistics.iQueueHighWater, HUDVIEW_DASHCAM_QUEUE_FRAMES );
+    printf( "Sustained: %.2f MiB/s over %.1f s, %lu segments completed, %lu impacts, %lu segments kept\n",
+            xStatistics.ullBytesWritten / dElapsed / 1048576.0, dElapsed, xStatistics.ulSegmentsCompleted,
+            xStatistics.ulEvents, xStatistics.ulSegmentsKept );
+
+    free( pdEnqueueMicroseconds );
+    free( pucFrame );
+    free( pxDashcam );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iExtract( int argc, char ** argv )
+{
+    xHUDViewDashcamHeader_t xHeader;
+    xHUDViewDashcamFrameHeader_t xFrameHeader;
+    uint8_t * pucFrame = NULL;
+    FILE * pxOutput = NULL;
+    uint64_t ullOffset = HUDVIEW_DASHCAM_BLOCK_BYTES;
+    uint64_t ullFrames = 0;
+    int64_t llFirstNanoseconds = 0;
+    int64_t llLastNanoseconds = 0;
+    int iDescriptor = -1;
+
+    if ( optind + 2 != argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    iDescriptor = open( argv[ optind ], O_RDONLY );
+
+    if ( ( 0 > iDescriptor ) || ( 0 != iHUDViewDashcamReadHeader( iDescriptor, &xHeader ) ) )
+    {
+        fprintf( stderr, "%s: not a dashcam segment\n", argv[ optind ] );
+        return -1;
+    }
+
+    pucFrame = malloc( xHeader.ulFrameBytes );
+    pxOutput = fopen( argv[ optind + 1 ], "wb" );
+
+    if ( ( NULL == pucFrame ) || ( NULL == pxOutput ) )
+    {
+        perror( argv[ optind + 1 ] );
+        close( iDescriptor );
+        free( pucFrame );
+        return -1;
+    }
+
+    /* A closed segment says how many frames it holds; one cut off by a power loss ends where the sequence breaks. */
+    while ( ( !xHeader.ulClosed || ( ullFrames < xHeader.ullFrames ) )
+            && ( ullOffset + xHeader.ulRecordBytes <= xHeader.ullSegmentBytes )
+            && ( sizeof( xFrameHeader ) == pread( iDescriptor, &xFrameHeader, sizeof( xFrameHeader ),
+                                                  ( off_t )ullOffset ) )
+            && ( xHeader.ullFirstSequence + ullFrames == xFrameHeader.ullSequence )
+            && ( xHeader.ulFrameBytes == pread( iDescriptor, pucFrame, xHeader.ulFrameBytes,
+                                                ( off_t )( ullOffset + sizeof( xFrameHeader ) ) ) ) )
+    {
+        if ( 0 == ullFrames )
+        {
+            llFirstNanoseconds = xFrameHeader.llNanoseconds;
+        }
+
+        llLastNanoseconds = xFrameHeader.llNanoseconds;
+        fwrite( pucFrame, 1, xHeader.ulFrameBytes, pxOutput );
+        ullOffset += xHeader.ulRecordBytes;
+        ullFrames++;
+    }
+
+    printf( "%s: %s, %llu frames of %u bytes over %.1f s, %s", argv[ optind ], xHeader.acFormat,
+            ( unsigned long long )ullFrames, xHeader.ulFrameBytes, ( llLastNanoseconds - llFirstNanoseconds ) / 1e9,
+            xHeader.ulClosed ? "closed" : "never closed" );
+
+    if ( 0 != xHeader.llEventNanoseconds )
+    {
+        printf( ", impact %.1f s in", ( xHeader.llEventNanoseconds - llFirstNanoseconds ) / 1e9 );
+    }
+
+    printf( "\n" );
+
+    fclose( pxOutput );
+    close( iDescriptor );
+    free( pucFrame );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iRing( int argc, char ** argv )
+{
+    static xRingConsumer_t axDefaultConsumers[] = {
+        { "display", 2, 1, 0 },
+        { "detector", 45, 1, 0 },
+        { "dashcam", 5, 0, 0 },
+        { "stuck", 600000, 0, 0 }
+    };
+    xRingConsumer_t axConsumers[ HUDVIEW_FRAMERING_MAX_CONSUMERS ];
+    xHUDViewFrameRingConsumer_t axStatistics[ HUDVIEW_FRAMERING_MAX_CONSUMERS ];
+    xHUDViewTransformConfig_t xConfig;
+    xHUDViewFrameRing_t xRing;
+    const char * pcFormat = "160x120:hflip";
+    struct timespec xNext;
+    uint8_t * pucScene = NULL;
+    uint8_t * pucSlot = NULL;
+    double * pdPublishMicroseconds = NULL;
+    double dSeconds = 5.0;
+    double dFramesPerSecond = 30.0;
+    double dStart = 0.0;
+    int64_t llPeriodNanoseconds = 0;
+    uint64_t ullSequence = 0;
+    uint64_t ullPublished = 0;
+    size_t ulFrameBytes = 0;
+    int iConsumers = 0;
+    int iFrames = 0;
+    int iPublished = 0;
+    int iReady = 0;
+    int iStatus = 0;
+    int iTorn = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "t:f:c:k:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 't':
+            dSeconds = atof( optarg );
+            break;
+
+        case 'f':
+            dFramesPerSecond = atof( optarg );
+            break;
+
+        case 'c':
+            pcFormat = optarg;
+            break;
+
+        case 'k':
+            if ( ( HUDVIEW_FRAMERING_MAX_CONSUMERS <= iConsumers )
+                 || ( 0 != iParseRingConsumer( optarg, &axConsumers[ iConsumers ] ) ) )
+            {
+                vUsage( argv[ 0 ] );
+                return -1;
+            }
+
+            iConsumers++;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    vHUDViewTransformDefaultConfig( &xConfig, 160, 120 );
+
+    if ( ( 0.0 >= dSeconds ) || ( 0.0 >= dFramesPerSecond ) || ( 0 != iHUDViewTransformParse( pcFormat, &xConfig ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    if ( 0 == iConsumers )
+    {
+        iConsumers = ( int )( sizeof( axDefaultConsumers ) / sizeof( axDefaultConsumers[ 0 ] ) );
+        memcpy( axConsumers, axDefaultConsumers, sizeof( axDefaultConsumers ) );
+    }
+
+    ulFrameBytes = ( size_t )iHUDViewTransformSourceBytes( &xConfig );
+    iFrames = ( int )( dSeconds * dFramesPerSecond );
+    llPeriodNanoseconds = ( int64_t )( 1e9 / dFramesPerSecond );
+    pucScene = malloc( ulFrameBytes );
+    pdPublishMicroseconds = calloc( ( size_t )iFrames + 1, sizeof( double ) );
+
+    if ( ( NULL == pucScene ) || ( NULL == pdPublishMicroseconds ) )
+    {
+        perror( "malloc" );
+        return -1;
+    }
+
+    vSynthesizeScene( pucScene, xConfig.iSourceWidth, xConfig.iSourceHeight,
+                      HUDVIEW_TRANSFORM_ALIGN( xConfig.iSourceWidth, HUDVIEW_TRANSFORM_CAPTURE_WIDTH_ALIGN ) * 3 );
+
+    /* A ring of its own, so a running Control is left alone. */
+    if ( 0 != iHUDViewFrameRingCreate( &xRing, RING_BENCH_SHM_NAME, pcFormat, ( uint32_t )ulFrameBytes ) )
+    {
+        perror( RING_BENCH_SHM_NAME );
+        return -1;
+    }
+
+    for ( int iConsumer = 0; iConsumer < iConsumers; iConsumer++ )
+    {
+        axConsumers[ iConsumer ].xPid = fork();
+
+        if ( 0 == axConsumers[ iConsumer ].xPid )
+        {
+            exit( iRunRingConsumer( &axConsumers[ iConsumer ] ) );
+        }
+    }
+
+    /* Every consumer is given a second to attach before the first frame. */
+    for ( int iWait = 0; ( iWait < 100 ) && ( iReady < iConsumers ); iWait++ )
+    {
+        usleep( 10000 );
+        iReady = 0;
+
+        for ( int iConsumer = 0; iConsumer < HUDVIEW_FRAMERING_MAX_CONSUMERS; iConsumer++ )
+        {
+            iReady += ( HUDVIEW_FRAMERING_CONSUMER_READY
+                        == __atomic_load_n( &xRing.pxHeader->axConsumers[ iConsumer ].ulState, __ATOMIC_ACQUIRE ) );
+        }
+    }
+
+    printf( "Ring of %d slots of %zu bytes (%s), %d consumers attached, %d frames at %.1f fps\n",
+            HUDVIEW_FRAMERING_SLOTS, ulFrameBytes, pcFormat, iReady, iFrames, dFramesPerSecond );
+
+    clock_gettime( CLOCK_MONOTONIC, &xNext );
+    dStart = dNow();
+
+    for ( int iFrame = 0; iFrame < iFrames; iFrame++ )
+    {
+        double dPublish = dNow();
+
+        /* The frame is written into the slot in place, as Control reads the camera's, and stamped with the sequence
+         * it will be published as so that consumers can tell if it changes under them. */
+        pucSlot = pucHUDViewFrameRingBeginWrite( &xRing );
+
+        if ( NULL != pucSlot )
+        {
+            ullSequence = xRing.pxHeader->ullPublished + 1;
+            memcpy( pucSlot, pucScene, ulFrameBytes );
+            memcpy( pucSlot, &ullSequence, sizeof( ullSequence ) );
+            vHUDViewFrameRingCommit( &xRing, ( uint32_t )ulFrameBytes, ( int64_t )( dNow() * 1e9 ) );
+            pdPublishMicroseconds[ iPublished++ ] = ( dNow() - dPublish ) * 1e6;
+        }
+
+        xNext.tv_nsec += ( long )llPeriodNanoseconds;
+
+        while ( 1000000000L <= xNext.tv_nsec )
+        {
+            xNext.tv_nsec -= 1000000000L;
+            xNext.tv_sec++;
+        }
+
+        clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xNext, NULL );
+    }
+
+    /* The consumers have a moment to take the last frame before their counts are read and the ring is closed. */
+    usleep( 100000 );
+
+    for ( int iConsumer = 0; iConsumer < HUDVIEW_FRAMERING_MAX_CONSUMERS; iConsumer++ )
+    {
+        vHUDViewFrameRingGetConsumer( &xRing, iConsumer, &axStatistics[ iConsumer ] );
+    }
+
+    ullPublished = xRing.pxHeader->ullPublished;
+
+    /* Publishing includes filling the slot, a copy of the frame, the cost Control's read already pays. */
+    qsort( pdPublishMicroseconds, ( size_t )iPublished, sizeof( double ), iCompareDoubles );
+    printf( "Producer: %llu published in %.1f s, %llu without a free slot, publish %.1f us median, %.1f us p99, "
+            "%.1f us max\n", ( unsigned long long )xRing.pxHeader->ullPublished, dNow() - dStart,
+            ( unsigned long long )xRing.pxHeader->ullProducerDropped, pdPublishMicroseconds[ iPublished / 2 ],
+            pdPublishMicroseconds[ iPublished * 99 / 100 ], pdPublishMicroseconds[ ( 0 < iPublished ) ? iPublished - 1
+                                                                                                    : 0 ] );
+
+    vHUDViewFrameRingDestroy( &xRing );
+
+    printf( "  %-12s %10s %7s %8s %8s %8s %9s %9s %6s\n", "consumer", "delay", "takes", "read", "dropped", "behind",
+            "max lag", "max age", "torn" );
+
+    for ( int iConsumer = 0; iConsumer < iConsumers; iConsumer++ )
+    {
+        const xHUDViewFrameRingConsumer_t * pxStatistics = NULL;
+
+        waitpid( axConsumers[ iConsumer ].xPid, &iStatus, 0 );
+        iTorn += WIFEXITED( iStatus ) ? WEXITSTATUS( iStatus ) : 1;
+
+        for ( int iEntry = 0; iEntry < HUDVIEW_FRAMERING_MAX_CONSUMERS; iEntry++ )
+        {
+            if ( ( HUDVIEW_FRAMERING_CONSUMER_READY == axStatistics[ iEntry ].ulState )
+                 && ( axConsumers[ iConsumer ].xPid == axStatistics[ iEntry ].lPid ) )
+            {
+                pxStatistics = &axStatistics[ iEntry ];
+            }
+        }
+
+        if ( NULL == pxStatistics )
+        {
+            printf( "  %-12s did not attach\n", axConsumers[ iConsumer ].acName );
+            continue;
+        }
+
+        printf( "  %-12s %7d ms %7s %8llu %8llu %8llu %9llu %6.1f ms %6d\n", axConsumers[ iConsumer ].acName,
+                axConsumers[ iConsumer ].iDelayMilliseconds, axConsumers[ iConsumer ].bNewest ? "newest" : "next",
+                ( unsigned long long )pxStatistics->ullFramesRead, ( unsigned long long )pxStatistics->ullFramesDropped,
+                ( unsigned long long )( ullPublished + 1 - pxStatistics->ullCursor ),
+                ( unsigned long long )pxStatistics->ullMaximumLag,
+                pxStatistics->llMaximumAgeNanoseconds / 1e6,
+                WIFEXITED( iStatus ) ? WEXITSTATUS( iStatus ) : -1 );
+    }
+
+    printf( "Dropped frames are those a consumer never saw, behind those published since the last it took; torn counts "
+            "frames that changed while held. %d torn\n", iTorn );
+
+    free( pdPublishMicroseconds );
+    free( pucScene );
+
+    return ( 0 == iTorn ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iRunRingConsumer( const xRingConsumer_t * pxConsumer )
+{
+    xHUDViewFrameRing_t xRing;
+    xHUDViewFrame_t xFrame;
+    uint64_t ullStamp = 0;
+    int iTorn = 0;
+
+    if ( 0 != iHUDViewFrameRingAttach( &xRing, RING_BENCH_SHM_NAME, pxConsumer->acName ) )
+    {
+        perror( pxConsumer->acName );
+        return 0;
+    }
+
+    /* Until the producer closes the ring: take a frame, hold it for the consumer's processing time, and check it was
+     * left alone meanwhile. */
+    while ( ( 0 == iHUDViewFrameRingWait( &xRing, 1000 ) ) || ( ETIMEDOUT == errno ) )
+    {
+        if ( 0 != iHUDViewFrameRingAcquire( &xRing, pxConsumer->bNewest, &xFrame ) )
+        {
+            continue;
+        }
+
+        memcpy( &ullStamp, xFrame.pucData, sizeof( ullStamp ) );
+        iTorn += ( ullStamp != xFrame.ullSequence );
+
+        for ( int iWaited = 0; ( iWaited < pxConsumer->iDelayMilliseconds )
+                               && ( 0 == __atomic_load_n( &xRing.pxHeader->ulClosed, __ATOMIC_ACQUIRE ) ); iWaited++ )
+        {
+            usleep( 1000 );
+        }
+
+        memcpy( &ullStamp, xFrame.pucData, sizeof( ullStamp ) );
+        iTorn += ( ullStamp != xFrame.ullSequence );
+        vHUDViewFrameRingRelease( &xRing );
+    }
+
+    vHUDViewFrameRingDetach( &xRing );
+
+    return ( 255 < iTorn ) ? 255 : iTorn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iParseRingConsumer( const char * pcSpecification, xRingConsumer_t * pxConsumer )
+{
+    const char * pcColon = strchr( pcSpecification, ':' );
+    char * pcEnd = NULL;
+
+    /* name:delay_ms[:newest] */
+    memset( pxConsumer, 0, sizeof( xRingConsumer_t ) );
+
+    if ( ( NULL == pcColon ) || ( pcColon == pcSpecification )
+         || ( HUDVIEW_FRAMERING_NAME_LENGTH <= pcColon - pcSpecification ) )
+    {
+        return -1;
+    }
+
+    memcpy( pxConsumer->acName, pcSpecification, ( size_t )( pcColon - pcSpecification ) );
+    pxConsumer->iDelayMilliseconds = ( int )strtol( pcColon + 1, &pcEnd, 10 );
+
+    if ( ( pcEnd == pcColon + 1 ) || ( 0 > pxConsumer->iDelayMilliseconds ) )
+    {
+        return -1;
+    }
+
+    if ( 0 == strcmp( pcEnd, ":newest" ) )
+    {
+        pxConsumer->bNewest = 1;
+    }
+    else if ( '\0' != *pcEnd )
+    {
+        return -1;
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iConsumers( int argc, char ** argv )
+{
+    xHUDViewFrameRing_t xRing;
+    xHUDViewFrameRingConsumer_t xConsumer;
+
+    ( void )argc;
+    ( void )argv;
+
+    /* Watched without taking a consumer entry. */
+    if ( 0 != iHUDViewFrameRingAttach( &xRing, HUDVIEW_FRAMERING_SHM_NAME, NULL ) )
+    {
+        perror( HUDVIEW_FRAMERING_SHM_NAME );
+        return -1;
+    }
+
+    printf( "%s: %s, %u slots of %u bytes, producer pid %d%s, %llu published, %llu without a free slot, "
+            "%llu consumers reclaimed\n", HUDVIEW_FRAMERING_SHM_NAME, xRing.pxHeader->acFormat, xRing.pxHeader->ulSlots,
+            xRing.pxHeader->ulFrameCapacity, xRing.pxHeader->lProducerPid,
+            xRing.pxHeader->ulClosed ? " (closed)" : "", ( unsigned long long )xRing.pxHeader->ullPublished,
+            ( unsigned long long )xRing.pxHeader->ullProducerDropped,
+            ( unsigned long long )xRing.pxHeader->ullReclaimed );
+    printf( "  %-24s %7s %8s %8s %8s %9s %9s %9s %5s\n", "consumer", "pid", "read", "dropped", "behind", "max lag",
+            "age", "max age", "slot" );
+
+    for ( int iConsumer = 0; iConsumer < HUDVIEW_FRAMERING_MAX_CONSUMERS; iConsumer++ )
+    {
+        vHUDViewFrameRingGetConsumer( &xRing, iConsumer, &xConsumer );
+
+        if ( HUDVIEW_FRAMERING_CONSUMER_READY == xConsumer.ulState )
+        {
+            /* A consumer that died is only reclaimed once a slot or an entry is short, so until then it shows. */
+            printf( "  %-24s %7d %8llu %8llu %8llu %9llu %6.1f ms %6.1f ms %5d%s\n", xConsumer.acName, xConsumer.lPid,
+                    ( unsigned long long )xConsumer.ullFramesRead, ( unsigned long long )xConsumer.ullFramesDropped,
+                    ( unsigned long long )( xRing.pxHeader->ullPublished + 1 - xConsumer.ullCursor ),
+                    ( unsigned long long )xConsumer.ullMaximumLag, xConsumer.llAgeNanoseconds / 1e6,
+                    xConsumer.llMaximumAgeNanoseconds / 1e6, xConsumer.lHeldSlot,
+                    ( ( 0 != kill( ( pid_t )xConsumer.lPid, 0 ) ) && ( ESRCH == errno ) ) ? " gone" : "" );
+        }
+    }
+
+    vHUDViewFrameRingDetach( &xRing );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iTap( int argc, char ** argv )
+{
+    xHUDViewFrameRing_t xRing;
+    xHUDViewFrameRingConsumer_t xStatistics;
+    xHUDViewFrame_t xFrame;
+    const char * pcOutput = NULL;
+    FILE * pxOutput = NULL;
+    double dSeconds = 10.0;
+    double dStart = 0.0;
+    int iDelayMilliseconds = 0;
+    int bNewest = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "t:d:No:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 't':
+            dSeconds = atof( optarg );
+            break;
+
+        case 'd':
+            iDelayMilliseconds = atoi( optarg );
+            break;
+
+        case 'N':
+            bNewest = 1;
+            break;
+
+        case 'o':
+            pcOutput = optarg;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( 0 != iHUDViewFrameRingAttach( &xRing, HUDVIEW_FRAMERING_SHM_NAME, "tap" ) )
+    {
+        perror( HUDVIEW_FRAMERING_SHM_NAME );
+        return -1;
+    }
+
+    if ( ( NULL != pcOutput ) && ( NULL == ( pxOutput = fopen( pcOutput, "wb" ) ) ) )
+    {
+        perror( pcOutput );
+        vHUDViewFrameRingDetach( &xRing );
+        return -1;
+    }
+
+    printf( "Tapping %s frames from %s for %.1f s\n", xRing.pxHeader->acFormat, HUDVIEW_FRAMERING_SHM_NAME, dSeconds );
+    dStart = dNow();
+
+    while ( ( dNow() - dStart < dSeconds )
+            && ( ( 0 == iHUDViewFrameRingWait( &xRing, 200 ) ) || ( ETIMEDOUT == errno ) ) )
+    {
+        if ( 0 != iHUDViewFrameRingAcquire( &xRing, bNewest, &xFrame ) )
+        {
+            continue;
+        }
+
+        /* Raw frames back to back, as hudview_vision takes them. */
+        if ( NULL != pxOutput )
+        {
+            fwrite( xFrame.pucData, 1, xFrame.ulBytes, pxOutput );
+        }
+
+        if ( 0 < iDelayMilliseconds )
+        {
+            usleep( ( useconds_t )iDelayMilliseconds * 1000 );
+        }
+
+        vHUDViewFrameRingRelease( &xRing );
+    }
+
+    vHUDViewFrameRingGetConsumer( &xRing, xRing.iConsumer, &xStatistics );
+    printf( "%llu frames read, %llu dropped, lag %llu frames max, %.1f ms oldest\n",
+            ( unsigned long long )xStatistics.ullFramesRead, ( unsigned long long )xStatistics.ullFramesDropped,
+            ( unsigned long long )xStatistics.ullMaximumLag, xStatistics.llMaximumAgeNanoseconds / 1e6 );
+
+    if ( NULL != pxOutput )
+    {
+        fclose( pxOutput );
+    }
+
+    vHUDViewFrameRingDetach( &xRing );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iEnhance( int argc, char ** argv )
+{
+    xHUDViewEnhance_t * apxEnhance[ ENHANCE_RUNS ] = { NULL };
+    double * apdMicroseconds[ ENHANCE_RUNS ] = { NULL };
+    double adSquaredError[ ENHANCE_RUNS ] = { 0.0 };
+    double adMeanLuma[ 2 ] = { 0.0 };
+    xHUDViewTransformConfig_t xConfig;
+    xHUDViewTransform_t xTransform;
+    const int iPixels = HUDVIEW_ENHANCE_PIXELS;
+    uint8_t * pucScene = NULL;
+    uint8_t * pucClean = NULL;
+    uint8_t * pucNoisy = NULL;
+    uint8_t * pucLuma = NULL;
+    uint16_t * pusClean = NULL;
+    uint16_t * pusNoisy = NULL;
+    uint16_t * pusExpected = NULL;
+    uint16_t * pusPicture = NULL;
+    double dNoisyError = 0.0;
+    int iFrames = 300;
+    int iNoise = 6;
+    int iMismatches = 0;
+    int iReturn = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "n:d:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'n':
+            iFrames = atoi( optarg );
+            break;
+
+        case 'd':
+            iNoise = atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0 >= iFrames ) || ( 0 > iNoise ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* The camera's own geometry, so the picture and luma come from the transform Control uses. */
+    vHUDViewTransformDefaultConfig( &xConfig, HUDVIEW_ENHANCE_WIDTH, HUDVIEW_ENHANCE_HEIGHT );
+
+    if ( 0 != iHUDViewTransformInit( &xTransform, &xConfig ) )
+    {
+        fprintf( stderr, "Cannot set up the camera transform\n" );
+        return -1;
+    }
+
+    pucScene = malloc( ( size_t )iPixels * 3 );
+    pucClean = calloc( 1, ( size_t )iHUDViewTransformSourceBytes( &xConfig ) );
+    pucNoisy = calloc( 1, ( size_t )iHUDViewTransformSourceBytes( &xConfig ) );
+    pucLuma = malloc( ( size_t )iPixels );
+    pusClean = malloc( ( size_t )iPixels * sizeof( uint16_t ) );
+    pusNoisy = malloc( ( size_t )iPixels * sizeof( uint16_t ) );
+    pusExpected = malloc( ( size_t )iPixels * sizeof( uint16_t ) );
+    pusPicture = malloc( ( size_t )iPixels * sizeof( uint16_t ) );
+
+    for ( int iRun = 0; iRun < ENHANCE_RUNS; iRun++ )
+    {
+        apxEnhance[ iRun ] = malloc( sizeof( xHUDViewEnhance_t ) );
+        apdMicroseconds[ iRun ] = malloc( ( size_t )iFrames * sizeof( double ) );
+        vHUDViewEnhanceInit( apxEnhance[ iRun ] );
+    }
+
+    vHUDViewEnhanceSetScalar( apxEnhance[ ENHANCE_RUN_SCALAR ], 1 );
+    vHUDViewEnhanceSetDenoise( apxEnhance[ ENHANCE_RUN_TONE ], 0, 0 );
+
+    /* With no strength the curve stays the identity, so the filter's effect can be measured against the scene. */
+    apxEnhance[ ENHANCE_RUN_FILTER ]->fStrength = 0.0f;
+    vSynthesizeScene( pucScene, HUDVIEW_ENHANCE_WIDTH, HUDVIEW_ENHANCE_HEIGHT, HUDVIEW_ENHANCE_WIDTH * 3 );
+    srand( 2 );
+
+    for ( int iFrame = 0; iFrame < iFrames; iFrame++ )
+    {
+        vNightScene( pucScene, iFrame, iNoise, pucClean, pucNoisy, xTransform.xConfig.iSourceStride );
+        vHUDViewTransformApply( &xTransform, pucClean, pusClean, pucLuma );
+        vHUDViewTransformApply( &xTransform, pucNoisy, pusNoisy, pucLuma );
+        dNoisyError += dSquaredError( pusNoisy, pusClean, iPixels );
+
+        for ( int iRun = 0; iRun < ENHANCE_RUNS; iRun++ )
+        {
+            double dStart = 0.0;
+
+            memcpy( pusPicture, pusNoisy, ( size_t )iPixels * sizeof( uint16_t ) );
+            dStart = dNow();
+            vHUDViewEnhanceProcess( apxEnhance[ iRun ], pucLuma, pusPicture );
+            apdMicroseconds[ iRun ][ iFrame ] = ( dNow() - dStart ) * 1e6;
+            adSquaredError[ iRun ] += dSquaredError( pusPicture, pusClean, iPixels );
+
+            if ( ENHANCE_RUN_SIMD == iRun )
+            {
+                memcpy( pusExpected, pusPicture, ( size_t )iPixels * sizeof( uint16_t ) );
+                adMeanLuma[ 0 ] += apxEnhance[ iRun ]->fMeanBefore;
+                adMeanLuma[ 1 ] += apxEnhance[ iRun ]->fMeanAfter;
+            }
+            else if ( ( ENHANCE_RUN_SCALAR == iRun ) && ( 0 != memcmp( pusExpected, pusPicture,
+                                                                         ( size_t )iPixels * sizeof( uint16_t ) ) ) )
+            {
+                iMismatches++;
+            }
+        }
+    }
+
+    printf( "Low-light stage, %s kernels, %dx%d, %d frames, noise +-%d, budget %d us (%.1f%% of a frame at 15 fps)\n",
+            pcHUDViewEnhanceKernels(), HUDVIEW_ENHANCE_WIDTH, HUDVIEW_ENHANCE_HEIGHT, iFrames, iNoise,
+            HUDVIEW_ENHANCE_BUDGET_US, HUDVIEW_ENHANCE_BUDGET_US * 15.0 / 1e4 );
+    printf( "  %-16s %10s %10s %10s %10s\n", "", "mean us", "p99 us", "max us", "PSNR dB" );
+    printf( "  %-16s %10s %10s %10s %10.2f\n", "camera", "", "", "",
+            10.0 * log10( 255.0 * 255.0 * 3 * iPixels * iFrames / dNoisyError ) );
+
+    for ( int iRun = 0; iRun < ENHANCE_RUNS; iRun++ )
+    {
+        double dTotal = 0.0;
+
+        qsort( apdMicroseconds[ iRun ], ( size_t )iFrames, sizeof( double ), iCompareDoubles );
+
+        for ( int iFrame = 0; iFrame < iFrames; iFrame++ )
+        {
+            dTotal += apdMicroseconds[ iRun ][ iFrame ];
+        }
+
+        printf( "  %-16s %10.1f %10.1f %10.1f", apcEnhanceRuns[ iRun ], dTotal / iFrames,
+                apdMicroseconds[ iRun ][ iFrames * 99 / 100 ], apdMicroseconds[ iRun ][ iFrames - 1 ] );
+
+        /* Only the filter alone keeps the scene's levels, so only its PSNR says anything about the noise. */
+        if ( ENHANCE_RUN_FILTER == iRun )
+        {
+            printf( " %10.2f", 10.0 * log10( 255.0 * 255.0 * 3 * iPixels * iFrames / adSquaredError[ iRun ] ) );
+        }
+
+        printf( "\n" );
+    }
+
+    /* The odd preempted frame is the scheduler's; the stage is over budget if one frame in a hundred is. */
+    if ( HUDVIEW_ENHANCE_BUDGET_US < apdMicroseconds[ ENHANCE_RUN_SIMD ][ iFrames * 99 / 100 ] )
+    {
+        printf( "  over budget\n" );
+        iReturn = -1;
+    }
+
+    printf( "  mean luma %.1f -> %.1f, %d frames where the scalar fallback differs\n", adMeanLuma[ 0 ] / iFrames,
+            adMeanLuma[ 1 ] / iFrames, iMismatches );
+
+    if ( 0 != iMismatches )
+    {
+        iReturn = -1;
+    }
+
+    for ( int iRun = 0; iRun < ENHANCE_RUNS; iRun++ )
+    {
+        free( apxEnhance[ iRun ] );
+        free( apdMicroseconds[ iRun ] );
+    }
+
+    free( pucScene );
+    free( pucClean );
+    free( pucNoisy );
+    free( pucLuma );
+    free( pusClean );
+    free( pusNoisy );
+    free( pusExpected );
+    free( pusPicture );
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vNightScene( const uint8_t * pucScene, int iFrame, int iNoise, uint8_t * pucClean, uint8_t * pucNoisy,
+                         int iStride )
+{
+    /* The day scene at a sixth of its level, a street lamp, and a car's headlights drawing nearer from the left. */
+    int iLightX = 20 + ( iFrame * 2 ) % 100;
+    int iLightY = 70 + ( iFrame % 100 ) / 10;
+    int iRadius = 2 + ( iFrame % 100 ) / 40;
+
+    for ( int iY = 0; iY < HUDVIEW_ENHANCE_HEIGHT; iY++ )
+    {
+        for ( int iX = 0; iX < HUDVIEW_ENHANCE_WIDTH; iX++ )
+        {
+            const uint8_t * pucPixel = pucScene + ( iY * HUDVIEW_ENHANCE_WIDTH + iX ) * 3;
+            uint8_t * pucCleanPixel = pucClean + iY * iStride + iX * 3;
+            uint8_t * pucNoisyPixel = pucNoisy + iY * iStride + iX * 3;
+            int bLight = ( ( iX - 140 ) * ( iX - 140 ) + ( iY - 20 ) * ( iY - 20 ) <= 9 );
+
+            for ( int iOffset = -12; iOffset <= 12; iOffset += 24 )
+            {
+                bLight |= ( ( iX - iLightX - iOffset ) * ( iX - iLightX - iOffset )
+                            + ( iY - iLightY ) * ( iY - iLightY ) <= iRadius * iRadius );
+            }
+
+            for ( int iChannel = 0; iChannel < 3; iChannel++ )
+            {
+                int iValue = bLight ? 250 : pucPixel[ iChannel ] / 6;
+                int iGrain = 0;
+
+                /* Three uniform draws make a roughly Gaussian grain. */
+                if ( 0 < iNoise )
+                {
+                    iGrain = ( rand() % ( 2 * iNoise + 1 ) + rand() % ( 2 * iNoise + 1 ) + rand() % ( 2 * iNoise + 1 )
+                               - 3 * iNoise ) * 2 / 3;
+                }
+
+                pucCleanPixel[ iChannel ] = ( uint8_t )iValue;
+                iValue += iGrain;
+                pucNoisyPixel[ iChannel ] = ( uint8_t )( ( 0 > iValue ) ? 0 : ( 255 < iValue ) ? 255 : iValue );
+            }
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dSquaredError( const uint16_t * pusA, const uint16_t * pusB, int iPixels )
+{
+    double dError = 0.0;
+
+    /* Each RGB565 channel widened to 8 bits, as the display shows it. */
+    for ( int iPixel = 0; iPixel < iPixels; iPixel++ )
+    {
+        int aiA[ 3 ] = { ( pusA[ iPixel ] >> 11 ) << 3, ( ( pusA[ iPixel ] >> 5 ) & 0x3F ) << 2,
+                         ( pusA[ iPixel ] & 0x1F ) << 3 };
+        int aiB[ 3 ] = { ( pusB[ iPixel ] >> 11 ) << 3, ( ( pusB[ iPixel ] >> 5 ) & 0x3F ) << 2,
+                         ( pusB[ iPixel ] & 0x1F ) << 3 };
+
+        for ( int iChannel = 0; iChannel < 3; iChannel++ )
+        {
+            dError += ( double )( aiA[ iChannel ] - aiB[ iChannel ] ) * ( aiA[ iChannel ] - aiB[ iChannel ] );
+        }
+    }
+
+    return dError;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iRate( int argc, char ** argv )
+{
+    static xRateOutcome_t axOutcomes[ RATE_POLICIES ];
+    xRide_t xRide;
+    const char * pcDirectory = NULL;
+    const char * pcFormat = "160x120:hflip";
+    double dClockHz = 16000000.0;
+    double dSeconds = 0.0;
+    double dFramesPerSecond = 10.0;
+    double dPushSeconds = 0.0;
+    double adReferences[ RATE_MAXIMUM_ALERTS ];
+    int iReferences = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:t:r:f:c:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 's':
+            dClockHz = atof( optarg );
+            break;
+
+        case 't':
+            dSeconds = atof( optarg );
+            break;
+
+        case 'r':
+            pcDirectory = optarg;
+            break;
+
+        case 'f':
+            dFramesPerSecond = atof( optarg );
+            break;
+
+        case 'c':
+            pcFormat = optarg;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0.0 >= dClockHz ) || ( 0.0 > dSeconds ) || ( 0.0 >= dFramesPerSecond )
+         || ( 0 != iLoadRide( &xRide, pcDirectory, pcFormat, dFramesPerSecond ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    if ( ( 0.0 < dSeconds ) && ( dSeconds < xRide.dSeconds ) )
+    {
+        xRide.dSeconds = dSeconds;
+    }
+
+    dPushSeconds = RATE_FRAME_BYTES * 8.0 / dClockHz + RATE_TRANSFERS * RATE_TRANSFER_NS / 1e9;
+    printf( "Ride: %s, %.0f s; SPI at %.1f MHz, %.1f ms to push a camera frame, so at most %.0f fps for the camera\n",
+            ( NULL != pcDirectory ) ? pcDirectory : "synthetic", xRide.dSeconds, dClockHz / 1e6, dPushSeconds * 1e3,
+            HUDVIEW_FRAMERATE_LINK_SHARE / dPushSeconds );
+
+    for ( int iPolicy = 0; iPolicy < RATE_POLICIES; iPolicy++ )
+    {
+        vSimulateRide( &xRide, iPolicy, dClockHz, &axOutcomes[ iPolicy ] );
+    }
+
+    printf( "\n  %-14s %8s %8s %8s %10s %10s %10s %8s\n", "", "frames", "mean fps", "vision", "CPU ms/s", "SPI KiB/s",
+            "SPI busy", "alerts" );
+
+    for ( int iPolicy = 0; iPolicy < RATE_POLICIES; iPolicy++ )
+    {
+        const xRateOutcome_t * pxOutcome = &axOutcomes[ iPolicy ];
+
+        printf( "  %-14s %8lu %8.1f %8lu %10.2f %10.1f %9.1f%% %8d\n", apcRatePolicies[ iPolicy ], pxOutcome->ulFrames,
+                pxOutcome->ulFrames / xRide.dSeconds, pxOutcome->ulVisionFrames,
+                pxOutcome->dCPUSeconds * 1e3 / xRide.dSeconds, pxOutcome->dSPIBytes / 1024.0 / xRide.dSeconds,
+                100.0 * pxOutcome->dSPISeconds / xRide.dSeconds, pxOutcome->iAlerts );
+    }
+
+    printf( "\n  adaptive rate: %lu changes;", axOutcomes[ RATE_POLICY_ADAPTIVE ].ulChanges );
+
+    for ( int iStep = 0; iStep < HUDVIEW_FRAMERATE_STEPS; iStep++ )
+    {
+        printf( " %d fps %.0f%%", iHUDViewFrameRateStep( iStep ),
+                100.0 * axOutcomes[ RATE_POLICY_ADAPTIVE ].allMicrosecondsAt[ iStep ] / ( xRide.dSeconds * 1e6 ) );
+    }
+
+    /* Against each approach, the synthetic ride's onsets or else each alert the fastest camera raised: how long each
+     * policy took to raise its alert, and how long the display then went before the next frame. */
+    if ( NULL == pcDirectory )
+    {
+        iReferences = ( int )( sizeof( adApproachOnsets ) / sizeof( adApproachOnsets[ 0 ] ) );
+        memcpy( adReferences, adApproachOnsets, sizeof( adApproachOnsets ) );
+    }
+    else
+    {
+        iReferences = axOutcomes[ 1 ].iAlerts;
+        memcpy( adReferences, axOutcomes[ 1 ].adAlertSeconds, sizeof( adReferences ) );
+    }
+
+    printf( "\n\n  %-12s", ( NULL == pcDirectory ) ? "approach at" : "alert at" );
+
+    for ( int iPolicy = 0; iPolicy < RATE_POLICIES; iPolicy++ )
+    {
+        printf( " %24s", apcRatePolicies[ iPolicy ] );
+    }
+
+    printf( "\n" );
+
+    for ( int iReference = 0; iReference < iReferences; iReference++ )
+    {
+        double dAt = adReferences[ iReference ];
+
+        printf( "  %10.2f s", dAt );
+
+        for ( int iPolicy = 0; iPolicy < RATE_POLICIES; iPolicy++ )
+        {
+            const xRateOutcome_t * pxOutcome = &axOutcomes[ iPolicy ];
+            int iMatch = -1;
+
+            for ( int iAlert = 0; ( 0 > iMatch ) && ( iAlert < pxOutcome->iAlerts ); iAlert++ )
+            {
+                if ( ( pxOutcome->adAlertSeconds[ iAlert ] > dAt - 1.0 )
+                     && ( pxOutcome->adAlertSeconds[ iAlert ] < dAt + 6.0 ) )
+                {
+                    iMatch = iAlert;
+                }
+            }
+
+            if ( 0 > iMatch )
+            {
+                printf( " %24s", "missed" );
+            }
+            else
+            {
+                printf( "    %+6.0f ms, next %4.0f ms", ( pxOutcome->adAlertSeconds[ iMatch ] - dAt ) * 1e3,
+                        pxOutcome->adFrameIntervals[ iMatch ] * 1e3 );
+            }
+        }
+
+        printf( "\n" );
+    }
+
+    vFreeRide( &xRide );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iLoadRide( xRide_t * pxRide, const char * pcDirectory, const char * pcFormat, double dFramesPerSecond )
+{
+    xHUDViewTransformConfig_t xConfig;
+    char acPath[ 4096 ];
+    char * pcLine = NULL;
+    size_t ulLineLength = 0;
+    size_t ulCapacity = 0;
+    struct stat xStat;
+    FILE * pxTrace = NULL;
+    int iDescriptor = -1;
+
+    memset( pxRide, 0, sizeof( *pxRide ) );
+    vHUDViewTransformDefaultConfig( &xConfig, 160, 120 );
+
+    if ( ( 0 != iHUDViewTransformParse( ( NULL != pcDirectory ) ? pcFormat : "160x120", &xConfig ) )
+         || ( 0 != iHUDViewTransformInit( &pxRide->xTransform, &xConfig ) ) )
+    {
+        return -1;
+    }
+
+    pxRide->ulFrameBytes = ( size_t )iHUDViewTransformSourceBytes( &xConfig );
+    pxRide->pucFrame = calloc( 1, pxRide->ulFrameBytes );
+
+    /* The synthetic ride draws each frame from the day scene as it goes. */
+    if ( NULL == pcDirectory )
+    {
+        pxRide->dSeconds = adSpeedTimes[ sizeof( adSpeedTimes ) / sizeof( adSpeedTimes[ 0 ] ) - 1 ];
+        pxRide->pucScene = malloc( 160 * 120 * 3 );
+        vSynthesizeScene( pxRide->pucScene, 160, 120, 160 * 3 );
+        return 0;
+    }
+
+    /* The clip holds raw frames back to back, a frame period apart. */
+    snprintf( acPath, sizeof( acPath ), "%s/Camera.rgb", pcDirectory );
+    iDescriptor = open( acPath, O_RDONLY );
+
+    if ( ( 0 > iDescriptor ) || ( 0 != fstat( iDescriptor, &xStat ) )
+         || ( ( off_t )pxRide->ulFrameBytes > xStat.st_size )
+         || ( MAP_FAILED == ( pxRide->pucClip = mmap( NULL, ( size_t )xStat.st_size, PROT_READ, MAP_PRIVATE,
+                                                      iDescriptor, 0 ) ) ) )
+    {
+        perror( acPath );
+        pxRide->pucClip = NULL;
+        return -1;
+    }
+
+    close( iDescriptor );
+    pxRide->ulClipBytes = ( size_t )xStat.st_size;
+    pxRide->lClipFrames = ( long )( pxRide->ulClipBytes / pxRide->ulFrameBytes );
+    pxRide->dClipFramesPerSecond = dFramesPerSecond;
+    pxRide->dSeconds = pxRide->lClipFrames / dFramesPerSecond;
+
+    /* Speeds from the GPS fixes, timed from the start of the recording like the clip. */
+    snprintf( acPath, sizeof( acPath ), "%s/GPS.trace", pcDirectory );
+    pxTrace = fopen( acPath, "r" );
+
+    if ( NULL == pxTrace )
+    {
+        fprintf( stderr, "No GPS trace, riding without speeds: %s\n", acPath );
+        return 0;
+    }
+
+    while ( -1 != getline( &pcLine, &ulLineLength, pxTrace ) )
+    {
+        const char * pcField = strstr( pcLine, "GPRMC," );
+        int iField = 0;
+
+        /* $GPRMC,time,status,latitude,N,longitude,W,speed,... with status A for a valid fix and speed in knots. */
+        for ( iField = 0; ( NULL != pcField ) && ( 7 > iField ); iField++ )
+        {
+            pcField = ( ( 2 == iField ) && ( 'A' != *pcField ) ) ? NULL : strchr( pcField, ',' );
+            pcField = ( NULL != pcField ) ? pcField + 1 : NULL;
+        }
+
+        if ( NULL == pcField )
+        {
+            continue;
+        }
+
+        if ( pxRide->ulFixes == ulCapacity )
+        {
+            ulCapacity = ( 0 == ulCapacity ) ? 1024 : ulCapacity * 2;
+            pxRide->pdFixSeconds = realloc( pxRide->pdFixSeconds, ulCapacity * sizeof( double ) );
+            pxRide->pdFixSpeeds = realloc( pxRide->pdFixSpeeds, ulCapacity * sizeof( double ) );
+        }
+
+        pxRide->pdFixSeconds[ pxRide->ulFixes ] = strtoll( pcLine, NULL, 10 ) / 1e6;
+        pxRide->pdFixSpeeds[ pxRide->ulFixes ] = atof( pcField ) * 0.514444;
+        pxRide->ulFixes++;
+    }
+
+    free( pcLine );
+    fclose( pxTrace );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vFreeRide( xRide_t * pxRide )
+{
+    if ( NULL != pxRide->pucClip )
+    {
+        munmap( ( void * )pxRide->pucClip, pxRide->ulClipBytes );
+    }
+
+    free( pxRide->pucFrame );
+    free( pxRide->pdFixSeconds );
+    free( pxRide->pdFixSpeeds );
+    free( pxRide->pucScene );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dRideSpeed( const xRide_t * pxRide, double dSeconds )
+{
+    size_t ulPoint = 0;
+    double dSpeed = -1.0;
+
+    if ( NULL == pxRide->pucScene )
+    {
+        /* The last fix so far; none yet means no speed at all, as for Control without a fix. */
+        for ( ulPoint = 0; ( ulPoint < pxRide->ulFixes ) && ( pxRide->pdFixSeconds[ ulPoint ] <= dSeconds ); ulPoint++ )
+        {
+            dSpeed = pxRide->pdFixSpeeds[ ulPoint ];
+        }
+
+        return dSpeed;
+    }
+
+    while ( ( ulPoint + 2 < sizeof( adSpeedTimes ) / sizeof( adSpeedTimes[ 0 ] ) )
+            && ( adSpeedTimes[ ulPoint + 1 ] <= dSeconds ) )
+    {
+        ulPoint++;
+    }
+
+    return adSpeeds[ ulPoint ] + ( adSpeeds[ ulPoint + 1 ] - adSpeeds[ ulPoint ] )
+                                 * ( dSeconds - adSpeedTimes[ ulPoint ] )
+                                 / ( adSpeedTimes[ ulPoint + 1 ] - adSpeedTimes[ ulPoint ] );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const uint8_t * pucRideFrame( xRide_t * pxRide, double dSeconds, long * plSource )
+{
+    const int iWidth = 160;
+    const int iHeight = 120;
+    int iStride = pxRide->xTransform.xConfig.iSourceStride;
+    double dHalfSize = 0.0;
+
+    /* A recorded frame is the one showing at that time; asked again for it, the caller sees the same source. */
+    if ( NULL == pxRide->pucScene )
+    {
+        *plSource = ( long )( dSeconds * pxRide->dClipFramesPerSecond );
+        *plSource = ( *plSource < pxRide->lClipFrames ) ? *plSource : pxRide->lClipFrames - 1;
+
+        return pxRide->pucClip + ( size_t )*plSource * pxRide->ulFrameBytes;
+    }
+
+    *plSource = -1;
+
+    /* After each onset a car closes in at a steady speed, six seconds from contact, and pulls out after five; its
+     * apparent size goes as the inverse of its distance. */
+    for ( size_t ulOnset = 0; ulOnset < sizeof( adApproachOnsets ) / sizeof( adApproachOnsets[ 0 ] ); ulOnset++ )
+    {
+        double dSince = dSeconds - adApproachOnsets[ ulOnset ];
+
+        if ( ( 0.0 <= dSince ) && ( 5.0 > dSince ) )
+        {
+            dHalfSize = 4.0 * 6.0 / ( 6.0 - dSince );
+        }
+    }
+
+    /* The scene behind, with fresh sensor noise every frame. */
+    for ( int iY = 0; iY < iHeight; iY++ )
+    {
+        for ( int iX = 0; iX < iWidth; iX++ )
+        {
+            const uint8_t * pucSource = pxRide->pucScene + ( iY * iWidth + iX ) * 3;
+            uint8_t * pucPixel = pxRide->pucFrame + iY * iStride + iX * 3;
+            double dX = iX - iWidth / 2;
+            double dY = iY - iHeight * 3 / 5;
+            int iNoise = rand() % 5 - 2;
+
+            for ( int iChannel = 0; iChannel < 3; iChannel++ )
+            {
+                int iValue = pucSource[ iChannel ] + iNoise;
+
+                /* The car: a dark window band over a checked grille, scaling with it so there is texture to track. */
+                if ( ( 0.0 < dHalfSize ) && ( fabs( dX ) < 1.5 * dHalfSize ) && ( fabs( dY ) < dHalfSize ) )
+                {
+                    int iU = ( int )floor( dX * 4.0 / dHalfSize );
+                    int iV = ( int )floor( dY * 3.0 / dHalfSize );
+
+                    iValue = ( -1 > iV ) ? 40 + iNoise : ( 0 == ( ( iU + iV ) & 1 ) ) ? 220 + iNoise : 90 + iNoise;
+                }
+
+                pucPixel[ iChannel ] = ( uint8_t )( ( 0 > iValue ) ? 0 : ( 255 < iValue ) ? 255 : iValue );
+            }
+        }
+    }
+
+    return pxRide->pucFrame;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSimulateRide( xRide_t * pxRide, int iPolicy, double dClockHz, xRateOutcome_t * pxOutcome )
+{
+    static xHUDViewFlow_t xFlow;
+    static uint16_t ausPicture[ 160 * 120 ];
+    static uint8_t aaucLuma[ 2 ][ 160 * 120 ];
+    xHUDViewFrameRate_t xRate;
+    xHUDViewFlowResult_t xResult;
+    double dPushSeconds = RATE_FRAME_BYTES * 8.0 / dClockHz + RATE_TRANSFERS * RATE_TRANSFER_NS / 1e9;
+    double dSeconds = 0.0;
+    double dLastVision = -1.0;
+    double dMotion = 0.0;
+    long lLastSource = -2;
+    int iCurrent = 0;
+    int iFramesPerSecond = ( RATE_POLICY_ADAPTIVE == iPolicy ) ? HUDVIEW_FRAMERATE_DEFAULT_FPS
+                                                               : aiRatePolicyFramesPerSecond[ iPolicy ];
+    int bAlert = 0;
+
+    memset( pxOutcome, 0, sizeof( *pxOutcome ) );
+    vHUDViewFrameRateInit( &xRate );
+    vHUDViewFlowInit( &xFlow );
+    srand( 3 );
+
+    /* The camera delivers a frame, Control handles it, and the next comes a frame period later at whatever rate it
+     * was asked for meanwhile. */
+    while ( dSeconds < pxRide->dSeconds )
+    {
+        long lSource = 0;
+        const uint8_t * pucFrame = pucRideFrame( pxRide, dSeconds, &lSource );
+        double dStart = dCPUNow();
+
+        iCurrent ^= 1;
+        vHUDViewTransformApply( &pxRide->xTransform, pucFrame, ausPicture, aaucLuma[ iCurrent ] );
+
+        /* A recorded frame shown twice, above the rate it was recorded at, has not stopped moving. */
+        if ( ( 0 < pxOutcome->ulFrames ) && ( lSource != lLastSource || 0 > lSource ) )
+        {
+            dMotion = dHUDViewFrameRateMotion( aaucLuma[ iCurrent ^ 1 ], aaucLuma[ iCurrent ], 160, 120 );
+        }
+
+        lLastSource = lSource;
+
+        if ( dSeconds - dLastVision >= 0.9 / 15.0 )
+        {
+            dLastVision = dSeconds;
+            iHUDViewFlowProcess( &xFlow, aaucLuma[ iCurrent ], ( int64_t )( dSeconds * 1e6 ), &xResult );
+            pxOutcome->ulVisionFrames++;
+
+            if ( xFlow.bAlert && !bAlert && ( RATE_MAXIMUM_ALERTS > pxOutcome->iAlerts ) )
+            {
+                pxOutcome->adAlertSeconds[ pxOutcome->iAlerts++ ] = dSeconds;
+            }
+
+            bAlert = xFlow.bAlert;
+        }
+
+        pxOutcome->dCPUSeconds += dCPUNow() - dStart;
+        pxOutcome->ulFrames++;
+        pxOutcome->dSPIBytes += RATE_FRAME_BYTES;
+        pxOutcome->dSPISeconds += dPushSeconds;
+        vHUDViewFrameRatePushed( &xRate, ( uint64_t )( dPushSeconds * 1e9 ) );
+
+        if ( RATE_POLICY_ADAPTIVE == iPolicy )
+        {
+            iFramesPerSecond = iHUDViewFrameRateUpdate( &xRate, ( int64_t )( dSeconds * 1e6 ), dMotion,
+                                                        dRideSpeed( pxRide, dSeconds ), bAlert );
+        }
+
+        /* The wait for the next frame, which is as long as the display shows an alert without news of it. */
+        if ( bAlert && ( 0 < pxOutcome->iAlerts )
+             && ( dSeconds == pxOutcome->adAlertSeconds[ pxOutcome->iAlerts - 1 ] ) )
+        {
+            pxOutcome->adFrameIntervals[ pxOutcome->iAlerts - 1 ] = 1.0 / iFramesPerSecond;
+        }
+
+        dSeconds += 1.0 / iFramesPerSecond;
+    }
+
+    /* The fixed rates spend all their time at one step; the adaptive rate says where its went. */
+    if ( RATE_POLICY_ADAPTIVE == iPolicy )
+    {
+        iHUDViewFrameRateUpdate( &xRate, ( int64_t )( pxRide->dSeconds * 1e6 ), dMotion, 0.0, 0 );
+        memcpy( pxOutcome->allMicrosecondsAt, xRate.allMicrosecondsAt, sizeof( pxOutcome->allMicrosecondsAt ) );
+        pxOutcome->ulChanges = xRate.ulChanges;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iPixels( int argc, char ** argv )
+{
+    static xHUDViewRGB444_t axPackers[ PIXEL_RUNS ];
+    double * apdMicroseconds[ PIXEL_RUNS ] = { NULL };
+    double aadError[ PIXEL_RUNS ][ PIXEL_PICTURES ] = { { 0.0 } };
+    double aadSmoothedError[ PIXEL_RUNS ][ PIXEL_PICTURES ] = { { 0.0 } };
+    uint16_t * apusPictures[ PIXEL_PICTURES ] = { NULL };
+    xHUDViewTransformConfig_t xConfig;
+    xHUDViewTransform_t xTransform;
+    const int iWidth = 160;
+    const int iHeight = 120;
+    const int iBands = iHeight / PIXEL_BAND_ROWS;
+    const unsigned long ulPixels = ( unsigned long )iWidth * iHeight;
+    uint8_t * pucScene = NULL;
+    uint8_t * pucLuma = NULL;
+    uint8_t * pucPacked = NULL;
+    uint8_t * pucExpected = NULL;
+    uint16_t * pusShown = NULL;
+    double dClockHz = 16000000.0;
+    int iFrames = 1000;
+    int iMismatches = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:n:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 's':
+            dClockHz = atof( optarg );
+            break;
+
+        case 'n':
+            iFrames = atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0.0 >= dClockHz ) || ( 0 >= iFrames ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    vHUDViewTransformDefaultConfig( &xConfig, iWidth, iHeight );
+
+    if ( 0 != iHUDViewTransformInit( &xTransform, &xConfig ) )
+    {
+        fprintf( stderr, "Cannot set up the camera transform\n" );
+        return -1;
+    }
+
+    pucScene = calloc( 1, ( size_t )iHUDViewTransformSourceBytes( &xConfig ) );
+    pucLuma = malloc( ulPixels );
+    pucPacked = malloc( HUDVIEW_RGB444_BYTES( ulPixels ) );
+    pucExpected = malloc( HUDVIEW_RGB444_BYTES( ulPixels ) );
+    pusShown = malloc( ulPixels * sizeof( uint16_t ) );
+
+    for ( int iPicture = 0; iPicture < PIXEL_PICTURES; iPicture++ )
+    {
+        apusPictures[ iPicture ] = malloc( ulPixels * sizeof( uint16_t ) );
+    }
+
+    /* The scene goes through the camera transform as Control's pictures do; the sky is made in RGB565 directly. */
+    vSynthesizeScene( pucScene, iWidth, iHeight, xTransform.xConfig.iSourceStride );
+    vHUDViewTransformApply( &xTransform, pucScene, apusPictures[ 0 ], pucLuma );
+    vDuskSky( apusPictures[ 1 ], iWidth, iHeight );
+
+    for ( int iRun = 0; iRun < PIXEL_RUNS; iRun++ )
+    {
+        apdMicroseconds[ iRun ] = calloc( ( size_t )iFrames, sizeof( double ) );
+        vHUDViewRGB444Init( &axPackers[ iRun ], ( 3 <= iRun ) );
+        vHUDViewRGB444SetScalar( &axPackers[ iRun ], ( 2 == iRun ) || ( 4 == iRun ) );
+    }
+
+    for ( int iFrame = 0; iFrame < iFrames; iFrame++ )
+    {
+        const uint16_t * pusPicture = apusPictures[ iFrame % PIXEL_PICTURES ];
+
+        /* RGB565 goes out as it is, so only the packing runs have any work to time. */
+        for ( int iRun = PIXEL_RUN_RGB565 + 1; iRun < PIXEL_RUNS; iRun++ )
+        {
+            unsigned long ulBytes = 0;
+            double dStart = dNow();
+
+            for ( int iBand = 0; iBand < iBands; iBand++ )
+            {
+                int iY = iBand * PIXEL_BAND_ROWS;
+
+                ulBytes += ulHUDViewRGB444Pack( &axPackers[ iRun ], pusPicture + iY * iWidth, iWidth, 0, iY, iWidth,
+                                                PIXEL_BAND_ROWS, pucPacked + ulBytes );
+            }
+
+            apdMicroseconds[ iRun ][ iFrame ] = ( dNow() - dStart ) * 1e6;
+
+            /* Each scalar run follows its SIMD run, whose bytes it must match. */
+            if ( ( 1 == iRun ) || ( 3 == iRun ) )
+            {
+                memcpy( pucExpected, pucPacked, ulBytes );
+            }
+            else if ( 0 != memcmp( pucExpected, pucPacked, ulBytes ) )
+            {
+                iMismatches++;
+            }
+
+            if ( iFrame < PIXEL_PICTURES )
+            {
+                vHUDViewRGB444Unpack( pucPacked, ulPixels, pusShown );
+                aadError[ iRun ][ iFrame ] = dSquaredError( pusShown, pusPicture, ( int )ulPixels );
+                aadSmoothedError[ iRun ][ iFrame ] = dSmoothedError( pusShown, pusPicture, iWidth, iHeight );
+            }
+        }
+    }
+
+    printf( "Camera pixels, %s kernels, %dx%d in %d bands, %d frames, SPI at %.1f MHz, %d us a transfer\n",
+            pcHUDViewRGB444Kernels(), iWidth, iHeight, iBands, iFrames, dClockHz / 1e6, RATE_TRANSFER_NS / 1000 );
+    printf( "  %-18s %11s %8s %9s %9s", "", "SPI B/frame", "max fps", "pack us", "p99 us" );
+
+    for ( int iPicture = 0; iPicture < PIXEL_PICTURES; iPicture++ )
+    {
+        printf( " %9s %9s", apcPixelPictures[ iPicture ], "smoothed" );
+    }
+
+    printf( "\n" );
+
+    for ( int iRun = 0; iRun < PIXEL_RUNS; iRun++ )
+    {
+        /* Every band is a window of its own; with the HUD up, RGB444 also costs a COLMOD switch a frame, as the
+         * compositor pushes the camera and the HUD's text in their own formats. */
+        double dBytes = ( PIXEL_RUN_RGB565 == iRun ) ? ulPixels * 2.0 : ( double )HUDVIEW_RGB444_BYTES( ulPixels );
+        int iTransfers = iBands;
+        double dTotal = 0.0;
+
+        dBytes += iBands * ( RATE_FRAME_BYTES - 160 * 120 * 2 ) / RATE_TRANSFERS;
+
+        if ( PIXEL_RUN_RGB565 != iRun )
+        {
+            dBytes += 2;
+            iTransfers++;
+        }
+
+        qsort( apdMicroseconds[ iRun ], ( size_t )iFrames, sizeof( double ), iCompareDoubles );
+
+        for ( int iFrame = 0; iFrame < iFrames; iFrame++ )
+        {
+            dTotal += apdMicroseconds[ iRun ][ iFrame ];
+        }
+
+        printf( "  %-18s %11.0f %8.1f", apcPixelRuns[ iRun ], dBytes,
+                1.0 / ( dBytes * 8.0 / dClockHz + iTransfers * RATE_TRANSFER_NS / 1e9 ) );
+
+        if ( PIXEL_RUN_RGB565 == iRun )
+        {
+            printf( " %9s %9s", "-", "-" );
+        }
+        else
+        {
+            printf( " %9.1f %9.1f", dTotal / iFrames, apdMicroseconds[ iRun ][ iFrames * 99 / 100 ] );
+        }
+
+        /* PSNR against the RGB565 picture, which RGB565 itself shows exactly. */
+        for ( int iPicture = 0; iPicture < PIXEL_PICTURES; iPicture++ )
+        {
+            if ( PIXEL_RUN_RGB565 == iRun )
+            {
+                printf( " %9s %9s", "exact", "exact" );
+            }
+            else
+            {
+                printf( " %9.2f %9.2f", 10.0 * log10( 255.0 * 255.0 * 3 * ulPixels / aadError[ iRun ][ iPicture ] ),
+                        10.0 * log10( 255.0 * 255.0 * 3 * ulPixels / aadSmoothedError[ iRun ][ iPicture ] ) );
+            }
+        }
+
+        printf( "\n" );
+    }
+
+    printf( "  %d frames where the scalar fallback differs\n", iMismatches );
+
+    for ( int iRun = 0; iRun < PIXEL_RUNS; iRun++ )
+    {
+        free( apdMicroseconds[ iRun ] );
+    }
+
+    for ( int iPicture = 0; iPicture < PIXEL_PICTURES; iPicture++ )
+    {
+        free( apusPictures[ iPicture ] );
+    }
+
+    free( pucScene );
+    free( pucLuma );
+    free( pucPacked );
+    free( pucExpected );
+    free( pusShown );
+
+    return ( 0 == iMismatches ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDuskSky( uint16_t * pusPicture, int iWidth, int iHeight )
+{
+    /* Orange at the horizon shading to deep blue overhead, lighter towards the sun on the right: gradients of a few
+     * RGB565 steps across the whole picture, where a 4-bit channel bands worst. */
+    for ( int iY = 0; iY < iHeight; iY++ )
+    {
+        for ( int iX = 0; iX < iWidth; iX++ )
+        {
+            int iRed = 40 + 190 * iY / iHeight + 20 * iX / iWidth;
+            int iGreen = 50 + 90 * iY / iHeight + 30 * iX / iWidth;
+            int iBlue = 140 - 80 * iY / iHeight;
+
+            pusPicture[ iY * iWidth + iX ] = ( uint16_t )( ( ( iRed >> 3 ) << 11 ) | ( ( iGreen >> 2 ) << 5 )
+                                                           | ( iBlue >> 3 ) );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dSmoothedError( const uint16_t * pusA, const uint16_t * pusB, int iWidth, int iHeight )
+{
+    double dError = 0.0;
+
+    /* The squared error of each channel averaged over 4x4 blocks, so dithering's fine pattern cancels out and only
+     * the bands remain; scaled to a per pixel sum to compare with dSquaredError(). */
+    for ( int iY = 0; iY + PIXEL_SMOOTHING <= iHeight; iY += PIXEL_SMOOTHING )
+    {
+        for ( int iX = 0; iX + PIXEL_SMOOTHING <= iWidth; iX += PIXEL_SMOOTHING )
+        {
+            double adDifference[ 3 ] = { 0.0 };
+
+            for ( int iRow = iY; iRow < iY + PIXEL_SMOOTHING; iRow++ )
+            {
+                for ( int iColumn = iX; iColumn < iX + PIXEL_SMOOTHING; iColumn++ )
+                {
+                    uint16_t usA = pusA[ iRow * iWidth + iColumn ];
+                    uint16_t usB = pusB[ iRow * iWidth + iColumn ];
+
+                    adDifference[ 0 ] += ( ( usA >> 11 ) << 3 ) - ( ( usB >> 11 ) << 3 );
+                    adDifference[ 1 ] += ( ( ( usA >> 5 ) & 0x3F ) << 2 ) - ( ( ( usB >> 5 ) & 0x3F ) << 2 );
+                    adDifference[ 2 ] += ( ( usA & 0x1F ) << 3 ) - ( ( usB & 0x1F ) << 3 );
+                }
+            }
+
+            for ( int iChannel = 0; iChannel < 3; iChannel++ )
+            {
+                double dMean = adDifference[ iChannel ] / ( PIXEL_SMOOTHING * PIXEL_SMOOTHING );
+
+                dError += dMean * dMean * PIXEL_SMOOTHING * PIXEL_SMOOTHING;
+            }
+        }
+    }
+
+    return dError;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iCompareDoubles( const void * pvA, const void * pvB )
+{
+    double dA = *( const double * )pvA;
+    double dB = *( const double * )pvB;
+
+    return ( dA > dB ) - ( dA < dB );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return xNow.tv_sec + xNow.tv_nsec / 1e9;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dCPUNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &xNow );
+
+    return xNow.tv_sec + xNow.tv_nsec / 1e9;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s transform [-s WIDTHxHEIGHT] [-n repeats] [specification ...]\n"
+                     "       %s mjpeg [-s WIDTHxHEIGHT] [-q quality] [-n frames] [specification ...]\n"
+                     "       %s dashcam [-d directory] [-t seconds] [-f fps] [-x speed] [-c specification]\n"
+                     "                  [-w stall ms] [-e stall every writes] [-i impact seconds] [-m segment MiB]\n"
+                     "                  [-g segments]\n"
+                     "       %s extract segment.hvd output.rgb\n"
+                     "       %s ring [-t seconds] [-f fps] [-c specification] [-k name:delay ms[:newest] ...]\n"
+                     "       %s consumers\n"
+                     "       %s tap [-t seconds] [-d delay ms] [-N] [-o output.rgb]\n"
+                     "       %s enhance [-n frames] [-d noise]\n"
+                     "       %s rate [-s SPI clock Hz] [-t seconds] [-r ride directory [-f recorded fps]\n"
+                     "               [-c specification]]\n"
+                     "       %s pixels [-s SPI clock Hz] [-n frames]\n", pcProgram, pcProgram, pcProgram, pcProgram,
+             pcProgram, pcProgram, pcProgram, pcProgram, pcProgram, pcProgram );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
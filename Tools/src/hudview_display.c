@@ -0,0 +1,391 @@
+/** @file hudview_display.c
+ *  @brief HUDView display link test and benchmark tool.
+ *
+ *  Usage: hudview_display bench [-d device] [-s SPI clock Hz] [-b bufsiz] [-n frames]
+ *         hudview_display probe [-d device] [-m maximum clock Hz]
+ *
+ *  Both commands drive the ST7735 through the spidev link Control's spidev backend uses, on the given device (e.g.
+ *  /dev/spidev0.1 on the Pi) or by default on the link's stand-in, which counts the ioctls a real link would make.
+ *
+ *  The bench command pushes frames as the compositor hands them over: the HUD clock ticking over, a camera frame in
+ *  RGB565, and a camera frame in RGB444 with the HUD's text in RGB565 beside it. Each is pushed per call, every
+ *  region a window of its own and every call a message of its own, as a generic SPI path does, and batched as the
+ *  spidev backend does, with regions that continue one another down the panel joined into one window, a window's
+ *  columns only sent when they change, and messages only ended where D/C changes or bufsiz is full. It reports SPI
+ *  messages, D/C line changes and their sum (the syscalls a frame costs), bytes, the wire time a frame takes at the
+ *  given clock with each ioctl's fixed cost, and the frame rate that allows; on a device also the time each frame
+ *  really took.
+ *
+ *  The probe command brings the panel up and finds the highest clock it reads back a test pattern at, a step down
+ *  for margin. The stand-in garbles writes above its own stable clock, so it shows where probing settles.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_rgb444.h"
+#include "hudview_spidev.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define TILE_SIZE           ( 8 )
+#define PICTURE_HEIGHT      ( 120 )
+#define MAXIMUM_REGIONS     ( 64 )
+
+/* The HUD clock's digits, as the compositor pushes their tiles. */
+#define TEXT_X              ( 16 )
+#define TEXT_Y              ( 48 )
+#define TEXT_WIDTH          ( 48 )
+#define TEXT_HEIGHT         ( 24 )
+
+#define WORKLOADS           ( 3 )
+#define WORKLOAD_HUD        ( 0 )
+#define WORKLOAD_CAMERA     ( 1 )
+#define WORKLOAD_RGB444     ( 2 )
+#define MODES               ( 2 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const char * apcWorkloads[ WORKLOADS ] = { "HUD tick", "camera rgb565", "camera rgb444 + HUD" };
+static const char * apcModes[ MODES ] = { "per call", "batched" };
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBench( int argc, char ** argv );
+static int iProbe( int argc, char ** argv );
+static int iOpen( xHUDViewSpidev_t * pxLink, const char * pcDevice, unsigned long ulClockHz, size_t ulBufferSize );
+static int iMakeRegions( int iWorkload, int iFrame, xHUDViewSpidevRegion_t * pxRegions );
+static void vAddRegion( xHUDViewSpidevRegion_t * pxRegions, int * piRegions, int iX, int iY, int iWidth, int b12Bit );
+static double dNow( void );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    if ( 2 > argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Each command parses its own options after the command name. */
+    optind = 2;
+
+    if ( 0 == strcmp( argv[ 1 ], "bench" ) )
+    {
+        return iBench( argc, argv );
+    }
+
+    if ( 0 == strcmp( argv[ 1 ], "probe" ) )
+    {
+        return iProbe( argc, argv );
+    }
+
+    vUsage( argv[ 0 ] );
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBench( int argc, char ** argv )
+{
+    static uint16_t ausPicture[ HUDVIEW_SPIDEV_WIDTH * HUDVIEW_SPIDEV_HEIGHT ];
+    static uint8_t aucFrame[ HUDVIEW_SPIDEV_WIDTH * HUDVIEW_SPIDEV_HEIGHT * 2 ];
+    xHUDViewSpidevRegion_t axRegions[ MAXIMUM_REGIONS ];
+    xHUDViewRGB444_t xPacker;
+    const char * pcDevice = NULL;
+    unsigned long ulClockHz = HUDVIEW_SPIDEV_DEFAULT_CLOCK_HZ;
+    size_t ulBufferSize = 0;
+    int iFrames = 300;
+    int iReturn = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "d:s:b:n:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'd':
+            pcDevice = optarg;
+            break;
+
+        case 's':
+            ulClockHz = strtoul( optarg, NULL, 10 );
+            break;
+
+        case 'b':
+            ulBufferSize = strtoul( optarg, NULL, 10 );
+            break;
+
+        case 'n':
+            iFrames = atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0 == ulClockHz ) || ( 0 >= iFrames ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* What is in the picture makes no difference to the link, only how much of it goes. */
+    for ( int iPixel = 0; iPixel < HUDVIEW_SPIDEV_WIDTH * HUDVIEW_SPIDEV_HEIGHT; iPixel++ )
+    {
+        ausPicture[ iPixel ] = ( uint16_t )( iPixel * 37 );
+    }
+
+    vHUDViewRGB444Init( &xPacker, 0 );
+    printf( "Display link on %s, SPI at %.2f MHz, %d frames, %d us an ioctl\n",
+            ( NULL != pcDevice ) ? pcDevice : "the stand-in", ulClockHz / 1e6, iFrames,
+            HUDVIEW_SPIDEV_IOCTL_NS / 1000 );
+    printf( "  %-20s %-9s %9s %9s %9s %9s %9s %9s %9s", "", "", "bufsiz", "messages", "D/C", "syscalls", "KiB",
+            "wire ms", "max fps" );
+
+    if ( NULL != pcDevice )
+    {
+        printf( " %9s", "real ms" );
+    }
+
+    printf( "\n" );
+
+    for ( int iWorkload = 0; ( 0 == iReturn ) && ( iWorkload < WORKLOADS ); iWorkload++ )
+    {
+        for ( int iMode = 0; ( 0 == iReturn ) && ( iMode < MODES ); iMode++ )
+        {
+            xHUDViewSpidev_t xLink;
+            xHUDViewSpidevStatistics_t xBefore;
+            double dStart = 0.0;
+            double dSeconds = 0.0;
+
+            if ( 0 != iOpen( &xLink, pcDevice, ulClockHz, ulBufferSize ) )
+            {
+                fprintf( stderr, "Cannot open the display link\n" );
+                return -1;
+            }
+
+            /* The device's own bufsiz unless a smaller one is asked for. */
+            if ( ( NULL != pcDevice ) && ( 0 < ulBufferSize ) && ( ulBufferSize < xLink.ulBufferSize ) )
+            {
+                xLink.ulBufferSize = ulBufferSize;
+            }
+
+            iReturn = iHUDViewSpidevInitPanel( &xLink );
+            vHUDViewSpidevSetBatch( &xLink, iMode );
+            xBefore = xLink.xStatistics;
+            dStart = dNow();
+
+            for ( int iFrame = 0; ( 0 == iReturn ) && ( iFrame < iFrames ); iFrame++ )
+            {
+                int iRegions = iMakeRegions( iWorkload, iFrame, axRegions );
+                size_t ulOffset = 0;
+
+                /* Gathered into one buffer as the backend does, big-endian RGB565 or packed to 12 bits. */
+                for ( int iRegion = 0; iRegion < iRegions; iRegion++ )
+                {
+                    xHUDViewSpidevRegion_t * pxRegion = &axRegions[ iRegion ];
+                    const uint16_t * pusPixels = &ausPicture[ pxRegion->iY * HUDVIEW_SPIDEV_WIDTH + pxRegion->iX ];
+
+                    pxRegion->pucData = &aucFrame[ ulOffset ];
+
+                    if ( pxRegion->b12Bit )
+                    {
+                        ulOffset += ulHUDViewRGB444Pack( &xPacker, pusPixels, HUDVIEW_SPIDEV_WIDTH, pxRegion->iX,
+                                                         pxRegion->iY, pxRegion->iWidth, pxRegion->iHeight,
+                                                         &aucFrame[ ulOffset ] );
+                    }
+                    else
+                    {
+                        for ( int iY = 0; iY < pxRegion->iHeight; iY++ )
+                        {
+                            const uint16_t * pusRow = &pusPixels[ iY * HUDVIEW_SPIDEV_WIDTH ];
+
+                            for ( int iX = 0; iX < pxRegion->iWidth; iX++ )
+                            {
+                                aucFrame[ ulOffset++ ] = ( uint8_t )( pusRow[ iX ] >> 8 );
+                                aucFrame[ ulOffset++ ] = ( uint8_t )pusRow[ iX ];
+                            }
+                        }
+                    }
+
+                    pxRegion->ulBytes = ( size_t )( &aucFrame[ ulOffset ] - pxRegion->pucData );
+                }
+
+                iReturn = iHUDViewSpidevPushRegions( &xLink, axRegions, iRegions );
+            }
+
+            dSeconds = dNow() - dStart;
+
+            if ( 0 == iReturn )
+            {
+                double dMessages = ( double )( xLink.xStatistics.ulMessages - xBefore.ulMessages ) / iFrames;
+                double dLines = ( double )( xLink.xStatistics.ulLineChanges - xBefore.ulLineChanges ) / iFrames;
+                double dWire = ( xLink.xStatistics.dWireSeconds - xBefore.dWireSeconds ) / iFrames;
+
+                printf( "  %-20s %-9s %9zu %9.1f %9.1f %9.1f %9.2f %9.2f %9.1f",
+                        ( 0 == iMode ) ? apcWorkloads[ iWorkload ] : "", apcModes[ iMode ], xLink.ulBufferSize,
+                        dMessages, dLines, dMessages + dLines,
+                        ( xLink.xStatistics.ullBytes - xBefore.ullBytes ) / 1024.0 / iFrames, dWire * 1e3,
+                        1.0 / dWire );
+
+                if ( NULL != pcDevice )
+                {
+                    printf( " %9.2f", dSeconds * 1e3 / iFrames );
+                }
+
+                printf( "\n" );
+            }
+            else
+            {
+                perror( "Display link" );
+            }
+
+            vHUDViewSpidevClose( &xLink );
+        }
+    }
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iProbe( int argc, char ** argv )
+{
+    xHUDViewSpidev_t xLink;
+    const char * pcDevice = NULL;
+    unsigned long ulMaximumHz = HUDVIEW_SPIDEV_MAXIMUM_CLOCK_HZ;
+    unsigned long ulClockHz = 0;
+    double dStart = 0.0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "d:m:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'd':
+            pcDevice = optarg;
+            break;
+
+        case 'm':
+            ulMaximumHz = strtoul( optarg, NULL, 10 );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0 != iOpen( &xLink, pcDevice, HUDVIEW_SPIDEV_DEFAULT_CLOCK_HZ, HUDVIEW_SPIDEV_DEFAULT_BUFSIZ ) )
+         || ( 0 != iHUDViewSpidevInitPanel( &xLink ) ) )
+    {
+        perror( "Display link" );
+        return -1;
+    }
+
+    dStart = dNow();
+    ulClockHz = ulHUDViewSpidevProbeClock( &xLink, ulMaximumHz );
+
+    if ( NULL == pcDevice )
+    {
+        printf( "Stand-in panel, stable up to %.2f MHz\n", HUDVIEW_SPIDEV_STANDIN_STABLE_HZ / 1e6 );
+    }
+
+    if ( 0 < ulClockHz )
+    {
+        printf( "Highest stable clock %.2f MHz, with a step of margin, probed in %.1f ms\n", ulClockHz / 1e6,
+                ( dNow() - dStart ) * 1e3 );
+    }
+    else
+    {
+        printf( "The panel does not read back; keep the default %.2f MHz\n", HUDVIEW_SPIDEV_DEFAULT_CLOCK_HZ / 1e6 );
+    }
+
+    vHUDViewSpidevClose( &xLink );
+
+    return ( 0 < ulClockHz ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iOpen( xHUDViewSpidev_t * pxLink, const char * pcDevice, unsigned long ulClockHz, size_t ulBufferSize )
+{
+    return ( NULL != pcDevice ) ? iHUDViewSpidevOpen( pxLink, pcDevice, ulClockHz )
+                                : iHUDViewSpidevOpenStandIn( pxLink, ulClockHz, ulBufferSize );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iMakeRegions( int iWorkload, int iFrame, xHUDViewSpidevRegion_t * pxRegions )
+{
+    int b12Bit = ( WORKLOAD_RGB444 == iWorkload );
+    int iRegions = 0;
+    int iText = 0;
+
+    /* A run of tiles a band of the picture; at 12 bits the text's tiles go apart in RGB565. Only the tiles under the
+     * digits change on a HUD tick. */
+    for ( int iY = 0; ( WORKLOAD_HUD != iWorkload ) && ( iY < PICTURE_HEIGHT ); iY += TILE_SIZE )
+    {
+        if ( b12Bit && ( TEXT_Y <= iY ) && ( TEXT_Y + TEXT_HEIGHT > iY ) )
+        {
+            vAddRegion( pxRegions, &iRegions, 0, iY, TEXT_X, 1 );
+            vAddRegion( pxRegions, &iRegions, TEXT_X + TEXT_WIDTH, iY, HUDVIEW_SPIDEV_WIDTH - TEXT_X - TEXT_WIDTH, 1 );
+        }
+        else
+        {
+            vAddRegion( pxRegions, &iRegions, 0, iY, HUDVIEW_SPIDEV_WIDTH, b12Bit );
+        }
+    }
+
+    for ( int iY = TEXT_Y; ( WORKLOAD_CAMERA != iWorkload ) && ( iY < TEXT_Y + TEXT_HEIGHT ); iY += TILE_SIZE )
+    {
+        vAddRegion( pxRegions, &iRegions, TEXT_X, iY, TEXT_WIDTH, 0 );
+        iText++;
+    }
+
+    /* The compositor pushes whichever group is in the panel's format first, so the order alternates. */
+    if ( b12Bit && ( 0 != iFrame % 2 ) )
+    {
+        xHUDViewSpidevRegion_t axText[ MAXIMUM_REGIONS ];
+
+        memcpy( axText, &pxRegions[ iRegions - iText ], iText * sizeof( xHUDViewSpidevRegion_t ) );
+        memmove( &pxRegions[ iText ], pxRegions, ( iRegions - iText ) * sizeof( xHUDViewSpidevRegion_t ) );
+        memcpy( pxRegions, axText, iText * sizeof( xHUDViewSpidevRegion_t ) );
+    }
+
+    return iRegions;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vAddRegion( xHUDViewSpidevRegion_t * pxRegions, int * piRegions, int iX, int iY, int iWidth, int b12Bit )
+{
+    xHUDViewSpidevRegion_t * pxRegion = &pxRegions[ ( *piRegions )++ ];
+
+    memset( pxRegion, 0, sizeof( *pxRegion ) );
+    pxRegion->iX = iX;
+    pxRegion->iY = iY;
+    pxRegion->iWidth = iWidth;
+    pxRegion->iHeight = TILE_SIZE;
+    pxRegion->b12Bit = b12Bit;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return xNow.tv_sec + xNow.tv_nsec / 1e9;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s bench [-d device] [-s SPI clock Hz] [-b bufsiz] [-n frames]\n"
+                     "       %s probe [-d device] [-m maximum clock Hz]\n", pcProgram, pcProgram );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
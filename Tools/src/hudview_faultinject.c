@@ -0,0 +1,428 @@
+/** @file hudview_faultinject.c
+ *  @brief HUDView component fault injection tool.
+ *
+ *  This program breaks a component of a running control application on purpose and measures how the supervisor
+ *  recovers. The component is the child of the control application whose command line contains the given pattern,
+ *  e.g. "gps_slave" on the bike or "-m GPS" for a replay stand-in.
+ *
+ *  Usage: hudview_faultinject [-p pid] [-n trials] [-i interval_ms] [-t timeout_ms] [-l limit_ms] kill|stall pattern
+ *
+ *  kill sends SIGKILL, as a crash would, and reports the time until a new instance of the component is running.
+ *  stall sends SIGSTOP, which wedges the component the way a blocked serial read or a looping sensor driver does,
+ *  and reports the time until the control application kills it and the time from then until the new instance is
+ *  running. A stall that is not detected within the timeout is released with SIGCONT and counted as a failure.
+ *
+ *  The first restart after a fault is immediate, but faults repeated within the supervisor's stable period are
+ *  backed off exponentially, so trials spaced closer than that measure the backoff rather than the restart latency.
+ *  The exit status is non-zero if any trial failed or, with -l, if any restart took longer than the limit.
+ */
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <dirent.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define CONTROL_PROCESS_NAME "Control"
+#define POLL_INTERVAL_US ( 500 )
+#define NANOSECONDS_PER_MILLISECOND ( 1000000LL )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef enum {
+    eFaultMin = 0,
+
+    eFault_Kill,
+    eFault_Stall,
+
+    eFaultMax
+} eFault_t;
+
+typedef struct {
+    long long llCount;
+    long long llTotal;
+    long long llMinimum;
+    long long llMaximum;
+} xLatencySummary_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static long long llNow( void );
+static int iReadFile( const char * pcPath, char * pcBuffer, size_t ulSize );
+static pid_t xFindControl( void );
+static pid_t xFindComponent( pid_t xParent, const char * pcPattern, pid_t xExclude );
+static int bIsAlive( pid_t xPid );
+static pid_t xWaitForComponent( pid_t xParent, const char * pcPattern, pid_t xExclude, long long llDeadline );
+static void vAddLatency( xLatencySummary_t * pxSummary, long long llNanoseconds );
+static void vPrintSummary( const char * pcName, const xLatencySummary_t * pxSummary );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    pid_t xControl = 0;
+    pid_t xComponent = 0;
+    pid_t xReplacement = 0;
+    int iTrials = 1;
+    long long llIntervalMs = 0;
+    long long llTimeoutMs = 60000;
+    long long llLimitMs = 0;
+    eFault_t eFault = eFaultMin;
+    const char * pcPattern = NULL;
+    int iOption = 0;
+    int iTrial = 0;
+    int iFailures = 0;
+    long long llInjected = 0;
+    long long llDetected = 0;
+    long long llRestarted = 0;
+    xLatencySummary_t xDetection = { 0, 0, 0, 0 };
+    xLatencySummary_t xRestart = { 0, 0, 0, 0 };
+
+    while ( -1 != ( iOption = getopt( argc, argv, "p:n:i:t:l:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'p':
+            xControl = ( pid_t )atoi( optarg );
+            break;
+
+        case 'n':
+            iTrials = atoi( optarg );
+            break;
+
+        case 'i':
+            llIntervalMs = atoll( optarg );
+            break;
+
+        case 't':
+            llTimeoutMs = atoll( optarg );
+            break;
+
+        case 'l':
+            llLimitMs = atoll( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( optind + 2 ) != argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    if ( 0 == strcmp( argv[ optind ], "kill" ) )
+    {
+        eFault = eFault_Kill;
+    }
+    else if ( 0 == strcmp( argv[ optind ], "stall" ) )
+    {
+        eFault = eFault_Stall;
+    }
+    else
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    pcPattern = argv[ optind + 1 ];
+
+    if ( 0 >= xControl )
+    {
+        xControl = xFindControl();
+    }
+
+    if ( 0 >= xControl )
+    {
+        fprintf( stderr, "No running %s process found\n", CONTROL_PROCESS_NAME );
+        return -1;
+    }
+
+    for ( iTrial = 1; iTrials >= iTrial; iTrial++ )
+    {
+        xComponent = xWaitForComponent( xControl, pcPattern, 0, llNow() + llTimeoutMs * NANOSECONDS_PER_MILLISECOND );
+
+        if ( 0 >= xComponent )
+        {
+            fprintf( stderr, "No component of process %d matches: %s\n", ( int )xControl, pcPattern );
+            iFailures++;
+            break;
+        }
+
+        llInjected = llNow();
+        llDetected = llInjected;
+
+        if ( eFault_Kill == eFault )
+        {
+            kill( xComponent, SIGKILL );
+        }
+        else
+        {
+            /* The process keeps its pipe open while stopped, so only the data timeout can catch it. */
+            kill( xComponent, SIGSTOP );
+
+            while ( bIsAlive( xComponent ) && ( ( llInjected + llTimeoutMs * NANOSECONDS_PER_MILLISECOND ) > llNow() ) )
+            {
+                usleep( POLL_INTERVAL_US );
+            }
+
+            if ( bIsAlive( xComponent ) )
+            {
+                kill( xComponent, SIGCONT );
+                printf( "Trial %d: stall of process %d not detected within %lld ms\n", iTrial, ( int )xComponent,
+                        llTimeoutMs );
+                iFailures++;
+                continue;
+            }
+
+            llDetected = llNow();
+            vAddLatency( &xDetection, llDetected - llInjected );
+        }
+
+        xReplacement = xWaitForComponent( xControl, pcPattern, xComponent,
+                                          llDetected + llTimeoutMs * NANOSECONDS_PER_MILLISECOND );
+
+        if ( 0 >= xReplacement )
+        {
+            printf( "Trial %d: process %d not restarted within %lld ms\n", iTrial, ( int )xComponent, llTimeoutMs );
+            iFailures++;
+            continue;
+        }
+
+        llRestarted = llNow();
+        vAddLatency( &xRestart, llRestarted - llDetected );
+
+        if ( eFault_Kill == eFault )
+        {
+            printf( "Trial %d: killed %d, replaced by %d after %.3f ms\n", iTrial, ( int )xComponent,
+                    ( int )xReplacement, ( double )( llRestarted - llDetected ) / NANOSECONDS_PER_MILLISECOND );
+        }
+        else
+        {
+            printf( "Trial %d: stalled %d, detected after %.3f ms, replaced by %d after a further %.3f ms\n", iTrial,
+                    ( int )xComponent, ( double )( llDetected - llInjected ) / NANOSECONDS_PER_MILLISECOND,
+                    ( int )xReplacement, ( double )( llRestarted - llDetected ) / NANOSECONDS_PER_MILLISECOND );
+        }
+
+        if ( ( 0 < llLimitMs ) && ( ( llRestarted - llDetected ) > ( llLimitMs * NANOSECONDS_PER_MILLISECOND ) ) )
+        {
+            iFailures++;
+        }
+
+        if ( ( iTrials > iTrial ) && ( 0 < llIntervalMs ) )
+        {
+            usleep( ( useconds_t )( llIntervalMs * 1000 ) );
+        }
+    }
+
+    if ( eFault_Stall == eFault )
+    {
+        vPrintSummary( "Stall detection", &xDetection );
+    }
+
+    vPrintSummary( "Restart", &xRestart );
+    printf( "%d of %d trials failed\n", iFailures, iTrials );
+
+    return ( 0 == iFailures ) ? 0 : 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static long long llNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( long long )xNow.tv_sec * 1000000000LL + xNow.tv_nsec;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iReadFile( const char * pcPath, char * pcBuffer, size_t ulSize )
+{
+    FILE * pxFile = fopen( pcPath, "r" );
+    size_t ulRead = 0;
+
+    if ( NULL == pxFile )
+    {
+        return -1;
+    }
+
+    ulRead = fread( pcBuffer, 1, ulSize - 1, pxFile );
+    pcBuffer[ ulRead ] = '\0';
+    fclose( pxFile );
+
+    return ( int )ulRead;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static pid_t xFindControl( void )
+{
+    DIR * pxProc = opendir( "/proc" );
+    struct dirent * pxEntry = NULL;
+    char acPath[ 64 ];
+    char acName[ 64 ];
+    pid_t xReturn = 0;
+
+    while ( ( NULL != pxProc ) && ( NULL != ( pxEntry = readdir( pxProc ) ) ) )
+    {
+        if ( !isdigit( ( unsigned char )pxEntry->d_name[ 0 ] ) )
+        {
+            continue;
+        }
+
+        snprintf( acPath, sizeof( acPath ), "/proc/%d/comm", atoi( pxEntry->d_name ) );
+
+        if ( ( 0 < iReadFile( acPath, acName, sizeof( acName ) ) )
+             && ( 0 == strncmp( acName, CONTROL_PROCESS_NAME "\n", sizeof( CONTROL_PROCESS_NAME ) ) ) )
+        {
+            xReturn = ( pid_t )atoi( pxEntry->d_name );
+            break;
+        }
+    }
+
+    if ( NULL != pxProc )
+    {
+        closedir( pxProc );
+    }
+
+    return xReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static pid_t xFindComponent( pid_t xParent, const char * pcPattern, pid_t xExclude )
+{
+    DIR * pxProc = opendir( "/proc" );
+    struct dirent * pxEntry = NULL;
+    char acPath[ 64 ];
+    char acBuffer[ 4096 ];
+    char * pcField = NULL;
+    char cState = 0;
+    int iParent = 0;
+    int iLength = 0;
+    int i = 0;
+    pid_t xPid = 0;
+    pid_t xReturn = 0;
+
+    while ( ( NULL != pxProc ) && ( NULL != ( pxEntry = readdir( pxProc ) ) ) )
+    {
+        if ( !isdigit( ( unsigned char )pxEntry->d_name[ 0 ] ) )
+        {
+            continue;
+        }
+
+        xPid = ( pid_t )atoi( pxEntry->d_name );
+
+        if ( xExclude == xPid )
+        {
+            continue;
+        }
+
+        /* The command name may hold spaces and parentheses, so the fields are found after the last ')'. */
+        snprintf( acPath, sizeof( acPath ), "/proc/%d/stat", ( int )xPid );
+
+        if ( ( 0 >= iReadFile( acPath, acBuffer, sizeof( acBuffer ) ) )
+             || ( NULL == ( pcField = strrchr( acBuffer, ')' ) ) )
+             || ( 2 != sscanf( pcField + 1, " %c %d", &cState, &iParent ) )
+             || ( xParent != ( pid_t )iParent ) || ( 'Z' == cState ) )
+        {
+            continue;
+        }
+
+        /* Between fork and exec a new component still carries the control application's command line. */
+        snprintf( acPath, sizeof( acPath ), "/proc/%d/cmdline", ( int )xPid );
+        iLength = iReadFile( acPath, acBuffer, sizeof( acBuffer ) );
+
+        for ( i = 0; iLength > i; i++ )
+        {
+            if ( '\0' == acBuffer[ i ] )
+            {
+                acBuffer[ i ] = ' ';
+            }
+        }
+
+        if ( ( 0 < iLength ) && ( NULL != strstr( acBuffer, pcPattern ) ) )
+        {
+            xReturn = xPid;
+            break;
+        }
+    }
+
+    if ( NULL != pxProc )
+    {
+        closedir( pxProc );
+    }
+
+    return xReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bIsAlive( pid_t xPid )
+{
+    char acPath[ 64 ];
+    char acBuffer[ 512 ];
+    char * pcField = NULL;
+    char cState = 0;
+
+    /* A zombie has already been killed, it is only waiting for the control application to reap it. */
+    snprintf( acPath, sizeof( acPath ), "/proc/%d/stat", ( int )xPid );
+
+    return ( 0 < iReadFile( acPath, acBuffer, sizeof( acBuffer ) ) )
+           && ( NULL != ( pcField = strrchr( acBuffer, ')' ) ) )
+           && ( 1 == sscanf( pcField + 1, " %c", &cState ) ) && ( 'Z' != cState ) && ( 'X' != cState );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static pid_t xWaitForComponent( pid_t xParent, const char * pcPattern, pid_t xExclude, long long llDeadline )
+{
+    pid_t xReturn = 0;
+
+    while ( ( 0 >= ( xReturn = xFindComponent( xParent, pcPattern, xExclude ) ) ) && ( llDeadline > llNow() ) )
+    {
+        usleep( POLL_INTERVAL_US );
+    }
+
+    return xReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vAddLatency( xLatencySummary_t * pxSummary, long long llNanoseconds )
+{
+    if ( ( 0 == pxSummary->llCount ) || ( llNanoseconds < pxSummary->llMinimum ) )
+    {
+        pxSummary->llMinimum = llNanoseconds;
+    }
+
+    if ( ( 0 == pxSummary->llCount ) || ( llNanoseconds > pxSummary->llMaximum ) )
+    {
+        pxSummary->llMaximum = llNanoseconds;
+    }
+
+    pxSummary->llCount++;
+    pxSummary->llTotal += llNanoseconds;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPrintSummary( const char * pcName, const xLatencySummary_t * pxSummary )
+{
+    if ( 0 < pxSummary->llCount )
+    {
+        printf( "%s: %lld samples, min %.3f ms, mean %.3f ms, max %.3f ms\n", pcName, pxSummary->llCount,
+                ( double )pxSummary->llMinimum / NANOSECONDS_PER_MILLISECOND,
+                ( double )pxSummary->llTotal / pxSummary->llCount / NANOSECONDS_PER_MILLISECOND,
+                ( double )pxSummary->llMaximum / NANOSECONDS_PER_MILLISECOND );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s [-p pid] [-n trials] [-i interval_ms] [-t timeout_ms] [-l limit_ms] kill|stall "
+             "pattern\n", pcProgram );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,249 @@
+/** @file hudview_flightdump.c
+ *  @brief HUDView flight recorder extraction tool.
+ *
+ *  This program reads a flight recording written by the control application and prints the telemetry records from a
+ *  chosen time window as CSV, oldest first. Every intact record is recovered, including those written after the last
+ *  header sync; torn records from a power loss are skipped and counted.
+ *
+ *  Usage: hudview_flightdump [-s start] [-e end] [-l seconds] [-t type] flight_file
+ *
+ *  Start and end are UNIX times in (fractional) seconds. -l selects the last N seconds before the newest record,
+ *  which is usually the window leading up to a crash. -t limits the output to accelerometer, gps, light or button
+ *  records.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hudview_flightrecord.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define NANOSECONDS_PER_SECOND ( 1000000000LL )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const char * const apcTypeNames[ eHUDViewFlightRecordTypeMax ] =
+{
+    "", "accelerometer", "gps", "light", "button"
+};
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iCompareSequence( const void * pvLeft, const void * pvRight );
+static void vPrintRecord( const xHUDViewFlightRecord_t * pxRecord );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    long long llStart = 0;
+    long long llEnd = 0;
+    double dLastSeconds = 0.0;
+    int bHasStart = 0;
+    int bHasEnd = 0;
+    int iType = eHUDViewFlightRecordTypeMin;
+    int iOption = 0;
+    int iDescriptor = -1;
+    struct stat xStat;
+    const uint8_t * pucFile = NULL;
+    const xHUDViewFlightHeader_t * pxHeader = NULL;
+    const xHUDViewFlightRecord_t * pxRecords = NULL;
+    const xHUDViewFlightRecord_t ** ppxValid = NULL;
+    uint64_t ullSlot = 0;
+    uint64_t ullValid = 0;
+    uint64_t ullTorn = 0;
+    uint64_t ullUnsynced = 0;
+    uint64_t ullPrinted = 0;
+    uint64_t ullRecord = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:e:l:t:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 's':
+            llStart = ( long long )( atof( optarg ) * NANOSECONDS_PER_SECOND );
+            bHasStart = 1;
+            break;
+
+        case 'e':
+            llEnd = ( long long )( atof( optarg ) * NANOSECONDS_PER_SECOND );
+            bHasEnd = 1;
+            break;
+
+        case 'l':
+            dLastSeconds = atof( optarg );
+            break;
+
+        case 't':
+            for ( iType = eHUDViewFlightRecordTypeMin + 1; iType < eHUDViewFlightRecordTypeMax; iType++ )
+            {
+                if ( 0 == strcmp( optarg, apcTypeNames[ iType ] ) )
+                {
+                    break;
+                }
+            }
+
+            if ( eHUDViewFlightRecordTypeMax == iType )
+            {
+                vUsage( argv[ 0 ] );
+                return -1;
+            }
+
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( optind >= argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    iDescriptor = open( argv[ optind ], O_RDONLY );
+
+    if ( ( 0 > iDescriptor ) || ( 0 != fstat( iDescriptor, &xStat ) ) )
+    {
+        fprintf( stderr, "Failed to open flight recording: %s\n", argv[ optind ] );
+        return -1;
+    }
+
+    pucFile = mmap( NULL, ( size_t )xStat.st_size, PROT_READ, MAP_PRIVATE, iDescriptor, 0 );
+    close( iDescriptor );
+
+    if ( MAP_FAILED == pucFile )
+    {
+        fprintf( stderr, "Failed to map flight recording: %s\n", argv[ optind ] );
+        return -1;
+    }
+
+    pxHeader = pxHUDViewFlightValidHeader( pucFile, ( size_t )xStat.st_size );
+
+    if ( NULL == pxHeader )
+    {
+        fprintf( stderr, "No intact header in flight recording: %s\n", argv[ optind ] );
+        return -1;
+    }
+
+    pxRecords = ( const xHUDViewFlightRecord_t * )( pucFile + pxHeader->ulDataOffset );
+    ppxValid = malloc( pxHeader->ullCapacity * sizeof( *ppxValid ) );
+
+    if ( NULL == ppxValid )
+    {
+        fprintf( stderr, "Out of memory\n" );
+        return -1;
+    }
+
+    /* Collect every intact record; the header only says how far the writer had synced, not where data ends. */
+    for ( ullSlot = 0; ullSlot < pxHeader->ullCapacity; ullSlot++ )
+    {
+        if ( bHUDViewFlightRecordValid( &pxRecords[ ullSlot ], pxHeader->ullCapacity, ullSlot ) )
+        {
+            ppxValid[ ullValid++ ] = &pxRecords[ ullSlot ];
+
+            if ( pxRecords[ ullSlot ].ullSequence > pxHeader->ullSyncedSequence )
+            {
+                ullUnsynced++;
+            }
+        }
+        else if ( 0 != pxRecords[ ullSlot ].ullSequence )
+        {
+            ullTorn++;
+        }
+    }
+
+    qsort( ppxValid, ullValid, sizeof( *ppxValid ), iCompareSequence );
+
+    /* The window for -l ends at the newest record recovered. */
+    if ( ( 0.0 < dLastSeconds ) && ( 0 < ullValid ) )
+    {
+        llEnd = ppxValid[ ullValid - 1 ]->llTimestampNanoseconds;
+        llStart = llEnd - ( long long )( dLastSeconds * NANOSECONDS_PER_SECOND );
+        bHasStart = 1;
+        bHasEnd = 1;
+    }
+
+    printf( "sequence,time,type,x,y,z,fix,latitude,longitude,speed,direction,lux,presses\n" );
+
+    for ( ullRecord = 0; ullRecord < ullValid; ullRecord++ )
+    {
+        const xHUDViewFlightRecord_t * pxRecord = ppxValid[ ullRecord ];
+
+        if ( ( bHasStart && ( pxRecord->llTimestampNanoseconds < llStart ) )
+             || ( bHasEnd && ( pxRecord->llTimestampNanoseconds > llEnd ) )
+             || ( ( eHUDViewFlightRecordTypeMin != iType ) && ( iType != pxRecord->usType ) ) )
+        {
+            continue;
+        }
+
+        vPrintRecord( pxRecord );
+        ullPrinted++;
+    }
+
+    fprintf( stderr, "%llu intact records (%llu beyond the last sync), %llu torn, %llu printed\n",
+             ( unsigned long long )ullValid, ( unsigned long long )ullUnsynced, ( unsigned long long )ullTorn,
+             ( unsigned long long )ullPrinted );
+
+    free( ppxValid );
+    munmap( ( void * )pucFile, ( size_t )xStat.st_size );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iCompareSequence( const void * pvLeft, const void * pvRight )
+{
+    uint64_t ullLeft = ( *( const xHUDViewFlightRecord_t * const * )pvLeft )->ullSequence;
+    uint64_t ullRight = ( *( const xHUDViewFlightRecord_t * const * )pvRight )->ullSequence;
+
+    return ( ullLeft > ullRight ) - ( ullLeft < ullRight );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vPrintRecord( const xHUDViewFlightRecord_t * pxRecord )
+{
+    printf( "%llu,%lld.%09lld,%s,", ( unsigned long long )pxRecord->ullSequence,
+            ( long long )( pxRecord->llTimestampNanoseconds / NANOSECONDS_PER_SECOND ),
+            ( long long )( pxRecord->llTimestampNanoseconds % NANOSECONDS_PER_SECOND ),
+            apcTypeNames[ pxRecord->usType ] );
+
+    switch ( pxRecord->usType )
+    {
+    case eHUDViewFlightRecordType_Accelerometer:
+        printf( "%f,%f,%f,,,,,,,\n", pxRecord->xData.xAccelerometer.fX, pxRecord->xData.xAccelerometer.fY,
+                pxRecord->xData.xAccelerometer.fZ );
+        break;
+
+    case eHUDViewFlightRecordType_GPS:
+        printf( ",,,%u,%.6f,%.6f,%.2f,%.2f,,\n", pxRecord->xData.xGPS.ucHasFix, pxRecord->xData.xGPS.dLatitude,
+                pxRecord->xData.xGPS.dLongitude, pxRecord->xData.xGPS.fSpeed, pxRecord->xData.xGPS.fDirection );
+        break;
+
+    case eHUDViewFlightRecordType_LightSensor:
+        printf( ",,,,,,,,%d,\n", pxRecord->xData.xLightSensor.lLux );
+        break;
+
+    case eHUDViewFlightRecordType_ButtonPress:
+        printf( ",,,,,,,,,%u\n", pxRecord->xData.xButtonPress.ulPresses );
+        break;
+
+    default:
+        printf( ",,,,,,,,,\n" );
+        break;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s [-s start] [-e end] [-l seconds] [-t accelerometer|gps|light|button] flight_file\n",
+             pcProgram );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
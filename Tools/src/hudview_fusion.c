@@ -0,0 +1,720 @@
+/** @file hudview_fusion.c
+ *  @brief HUDView GPS and accelerometer fusion accuracy and cost benchmark.
+ *
+ *  This program runs the fusion filter the control application uses over a ride and compares it with simply holding
+ *  the last GPS fix, which is what the HUD showed before.
+ *
+ *  Usage: hudview_fusion bench [-s seconds] [-d dropout_seconds] [-e every_seconds] [-l] [-r seed]
+ *         hudview_fusion replay [-d dropout_seconds] [-e every_seconds] record_directory
+ *
+ *  The bench command simulates a ride with known ground truth: a 20 Hz accelerometer with noise and a drifting
+ *  mounting bias, 1 Hz GPS fixes with noise, and a GPS dropout of the given length (a tunnel) every so often. With -l
+ *  the lateral axis sees none of the turns, as on a leaning two-wheeler. Speed and heading are scored against the
+ *  truth at 20 Hz, overall and within dropouts, along with how often the truth lies within two reported standard
+ *  deviations; the heading only while it is reported valid. It fails if the fused estimates are worse than the last
+ *  fix or their standard deviations cover the truth too rarely.
+ *
+ *  The replay command runs over the GPS.trace and Accelerometer.trace of a ride recorded with "Control --record".
+ *  Recorded rides have no ground truth, so the GPS fixes themselves are scored: fixes inside the simulated dropouts
+ *  are withheld from the filter and compared with its dead-reckoned estimate, and every other fix is compared with
+ *  the prediction made just before it was applied.
+ *
+ *  Both commands finish by timing each kind of filter update, to show that the cost per update is small and fixed.
+ */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_fusion.h"
+#include "hudview_trace.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define MICROSECONDS_PER_SECOND ( 1000000LL )
+#define OUTPUT_PERIOD_US        ( 50000LL )
+#define ACCELEROMETER_PERIOD_US ( 50000LL )
+#define GPS_PERIOD_US           ( 1000000LL )
+#define TRUTH_STEP_US           ( 1000LL )
+#define TIMING_UPDATES          ( 1000000 )
+#define TIMING_SAMPLES          ( 1024 )
+
+/* Two standard deviations cover 95% of a normal error; the bench allows some slack below that. */
+#define MINIMUM_COVERAGE_PERCENT ( 90.0 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    double dSquares;
+    unsigned long ulCount;
+    unsigned long ulCovered;
+} xError_t;
+
+typedef struct {
+    int64_t llMicroseconds;
+    double adValues[ 3 ];
+} xSample_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBench( int argc, char ** argv );
+static int iReplay( int argc, char ** argv );
+static int bInDropout( int64_t llMicroseconds, double dDropout, double dEvery );
+static xSample_t * pxLoadTrace( const char * pcDirectory, const char * pcComponent, int bGPS, size_t * pulCount );
+static int bParseRMC( const char * pcRecord, double * pdSpeed, double * pdCourse );
+static void vAddError( xError_t * pxError, double dError, double dSigma );
+static double dHeadingError( double dEstimate, double dTruth );
+static double dRMS( const xError_t * pxError );
+static double dCoverage( const xError_t * pxError );
+static int bCheckError( const char * pcName, const xError_t * pxFused, const xError_t * pxHeld );
+static double dGaussian( void );
+static void vTimeUpdates( void );
+static double dNow( void );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    if ( 2 > argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Each command parses its own options after the command name. */
+    optind = 2;
+
+    if ( 0 == strcmp( argv[ 1 ], "bench" ) )
+    {
+        return iBench( argc, argv );
+    }
+    else if ( 0 == strcmp( argv[ 1 ], "replay" ) )
+    {
+        return iReplay( argc, argv );
+    }
+
+    vUsage( argv[ 0 ] );
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBench( int argc, char ** argv )
+{
+    xHUDViewFusion_t xFusion;
+    xHUDViewFusionEstimate_t xEstimate;
+    xError_t xFusedSpeed = { 0 };
+    xError_t xHeldSpeed = { 0 };
+    xError_t xFusedHeading = { 0 };
+    xError_t xHeldHeading = { 0 };
+    xError_t xFusedDropoutSpeed = { 0 };
+    xError_t xHeldDropoutSpeed = { 0 };
+    xError_t xFusedDropoutHeading = { 0 };
+    xError_t xHeldDropoutHeading = { 0 };
+    double dSeconds = 600.0;
+    double dDropout = 20.0;
+    double dEvery = 120.0;
+    int bLeaning = 0;
+    unsigned int uiSeed = 1;
+    int64_t llDuration = 0;
+    int64_t llTime = 0;
+    int64_t llNextAccelerometer = 0;
+    int64_t llNextGPS = 0;
+    double dSpeed = 0.0;
+    double dHeading = 0.0;
+    double dAcceleration = 0.0;
+    double dYawRate = 0.0;
+    double dTargetSpeed = 0.0;
+    double dTurnEnd = 0.0;
+    double dBias = 0.3;
+    double dHeldSpeed = 0.0;
+    double dHeldHeading = 0.0;
+    int bHeldSpeed = 0;
+    int bHeldHeading = 0;
+    int bDropout = 0;
+    unsigned long ulOutputs = 0;
+    unsigned long ulDropoutOutputs = 0;
+    unsigned long ulDropoutValid = 0;
+    unsigned long ulDropoutMoving = 0;
+    unsigned long ulDropoutHeadingValid = 0;
+    double dMaximumSigma = 0.0;
+    int bPassed = 1;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:d:e:lr:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 's':
+            dSeconds = atof( optarg );
+            break;
+
+        case 'd':
+            dDropout = atof( optarg );
+            break;
+
+        case 'e':
+            dEvery = atof( optarg );
+            break;
+
+        case 'l':
+            bLeaning = 1;
+            break;
+
+        case 'r':
+            uiSeed = ( unsigned int )atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0.0 >= dSeconds ) || ( 0.0 > dDropout ) || ( dDropout >= dEvery ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    srand( uiSeed );
+    vHUDViewFusionInit( &xFusion );
+    llDuration = ( int64_t )( dSeconds * MICROSECONDS_PER_SECOND );
+
+    /* Integrate the true motion in 1 ms steps; sensors sample it and the estimate is scored at the output rate. */
+    for ( llTime = TRUTH_STEP_US; llTime <= llDuration; llTime += TRUTH_STEP_US )
+    {
+        double dTime = llTime / ( double )MICROSECONDS_PER_SECOND;
+
+        /* A new target speed every 25 s, now and then a stop, reached at a rider's pace. */
+        if ( 0 == llTime % ( 25 * MICROSECONDS_PER_SECOND ) )
+        {
+            dTargetSpeed = ( 0 == rand() % 8 ) ? 0.0 : 3.0 + 17.0 * rand() / ( double )RAND_MAX;
+        }
+
+        dAcceleration = fmax( -4.0, fmin( 2.5, ( dTargetSpeed - dSpeed ) * 0.5 ) );
+        dSpeed = fmax( 0.0, dSpeed + dAcceleration * TRUTH_STEP_US / 1e6 );
+
+        /* A turn of a few seconds now and then, only while moving. */
+        if ( dTime >= dTurnEnd )
+        {
+            dYawRate = 0.0;
+
+            if ( ( 0 == llTime % ( 10 * MICROSECONDS_PER_SECOND ) ) && ( 3.0 < dSpeed ) && ( 0 != rand() % 3 ) )
+            {
+                dYawRate = ( ( 0 == rand() % 2 ) ? 1.0 : -1.0 ) * ( 0.1 + 0.2 * rand() / ( double )RAND_MAX );
+                dTurnEnd = dTime + 3.0 + 5.0 * rand() / ( double )RAND_MAX;
+            }
+        }
+
+        dHeading = fmod( dHeading + dYawRate * TRUTH_STEP_US / 1e6 + 2.0 * M_PI, 2.0 * M_PI );
+        dBias += 0.002 * dGaussian() * sqrt( TRUTH_STEP_US / 1e6 );
+        bDropout = bInDropout( llTime, dDropout, dEvery );
+
+        if ( llTime >= llNextAccelerometer )
+        {
+            double dLateral = bLeaning ? 0.0 : dSpeed * dYawRate;
+
+            vHUDViewFusionAccelerometer( &xFusion, llTime, dAcceleration + dBias + 0.5 * dGaussian(),
+                                         dLateral + 0.5 * dGaussian() );
+            llNextAccelerometer += ACCELEROMETER_PERIOD_US;
+        }
+
+        if ( llTime >= llNextGPS )
+        {
+            if ( !bDropout )
+            {
+                double dMeasuredSpeed = fmax( 0.0, dSpeed + HUDVIEW_FUSION_GPS_SPEED_SIGMA * dGaussian() );
+                double dCourse = dHeading + HUDVIEW_FUSION_GPS_SPEED_SIGMA / fmax( dSpeed, 0.3 ) * dGaussian();
+
+                dCourse = fmod( dCourse * 180.0 / M_PI + 720.0, 360.0 );
+                vHUDViewFusionGPS( &xFusion, llTime, dMeasuredSpeed, dCourse );
+                dHeldSpeed = dMeasuredSpeed;
+                bHeldSpeed = 1;
+
+                if ( HUDVIEW_FUSION_MINIMUM_COURSE_SPEED <= dMeasuredSpeed )
+                {
+                    dHeldHeading = dCourse;
+                    bHeldHeading = 1;
+                }
+            }
+
+            llNextGPS += GPS_PERIOD_US;
+        }
+
+        if ( ( 0 != llTime % OUTPUT_PERIOD_US ) || !bHeldSpeed )
+        {
+            continue;
+        }
+
+        vHUDViewFusionPredict( &xFusion, llTime );
+        vHUDViewFusionEstimate( &xFusion, llTime, &xEstimate );
+        ulOutputs++;
+
+        vAddError( &xFusedSpeed, xEstimate.dSpeed - dSpeed, xEstimate.dSpeedSigma );
+        vAddError( &xHeldSpeed, dHeldSpeed - dSpeed, 0.0 );
+
+        if ( bDropout )
+        {
+            ulDropoutOutputs++;
+            ulDropoutValid += xEstimate.bValid ? 1 : 0;
+            dMaximumSigma = fmax( dMaximumSigma, xEstimate.dSpeedSigma );
+            vAddError( &xFusedDropoutSpeed, xEstimate.dSpeed - dSpeed, xEstimate.dSpeedSigma );
+            vAddError( &xHeldDropoutSpeed, dHeldSpeed - dSpeed, 0.0 );
+        }
+
+        /* Heading is only defined while moving. */
+        if ( bDropout && ( HUDVIEW_FUSION_MINIMUM_TURN_SPEED < dSpeed ) && bHeldHeading )
+        {
+            ulDropoutMoving++;
+            ulDropoutHeadingValid += xEstimate.bHeadingValid ? 1 : 0;
+        }
+
+        if ( ( HUDVIEW_FUSION_MINIMUM_TURN_SPEED < dSpeed ) && xEstimate.bHeadingValid && bHeldHeading )
+        {
+            double dTruth = dHeading * 180.0 / M_PI;
+
+            vAddError( &xFusedHeading, dHeadingError( xEstimate.dHeading, dTruth ), xEstimate.dHeadingSigma );
+            vAddError( &xHeldHeading, dHeadingError( dHeldHeading, dTruth ), 0.0 );
+
+            if ( bDropout )
+            {
+                vAddError( &xFusedDropoutHeading, dHeadingError( xEstimate.dHeading, dTruth ),
+                           xEstimate.dHeadingSigma );
+                vAddError( &xHeldDropoutHeading, dHeadingError( dHeldHeading, dTruth ), 0.0 );
+            }
+        }
+    }
+
+    printf( "Ride: %.0f s, %.0f s GPS dropout every %.0f s, %s lateral axis, %lu estimates at %lld Hz\n", dSeconds,
+            dDropout, dEvery, bLeaning ? "leaning" : "upright", ulOutputs, MICROSECONDS_PER_SECOND / OUTPUT_PERIOD_US );
+    printf( "GPS fixes: %lu applied, %lu rejected\n", xFusion.ulGPSUpdates, xFusion.ulGPSRejected );
+    printf( "\n%-22s %14s %14s %14s\n", "", "last fix RMS", "fused RMS", "fused in 2sd" );
+    printf( "%-22s %11.3f m/s %11.3f m/s %13.1f%%\n", "Speed", dRMS( &xHeldSpeed ), dRMS( &xFusedSpeed ),
+            dCoverage( &xFusedSpeed ) );
+    printf( "%-22s %11.3f m/s %11.3f m/s %13.1f%%\n", "Speed in dropouts", dRMS( &xHeldDropoutSpeed ),
+            dRMS( &xFusedDropoutSpeed ), dCoverage( &xFusedDropoutSpeed ) );
+    printf( "%-22s %11.2f deg %11.2f deg %13.1f%%\n", "Heading", dRMS( &xHeldHeading ), dRMS( &xFusedHeading ),
+            dCoverage( &xFusedHeading ) );
+    printf( "%-22s %11.2f deg %11.2f deg %13.1f%%\n", "Heading in dropouts", dRMS( &xHeldDropoutHeading ),
+            dRMS( &xFusedDropoutHeading ), dCoverage( &xFusedDropoutHeading ) );
+    printf( "\nEstimates valid in dropouts: %.1f%% speed, %.1f%% heading while moving, largest speed sigma %.2f m/s\n",
+            ( 0 < ulDropoutOutputs ) ? 100.0 * ulDropoutValid / ulDropoutOutputs : 0.0,
+            ( 0 < ulDropoutMoving ) ? 100.0 * ulDropoutHeadingValid / ulDropoutMoving : 0.0, dMaximumSigma );
+
+    bPassed = bCheckError( "Speed", &xFusedSpeed, &xHeldSpeed ) & bPassed;
+    bPassed = bCheckError( "Speed in dropouts", &xFusedDropoutSpeed, &xHeldDropoutSpeed ) & bPassed;
+    bPassed = bCheckError( "Heading", &xFusedHeading, &xHeldHeading ) & bPassed;
+    bPassed = bCheckError( "Heading in dropouts", &xFusedDropoutHeading, &xHeldDropoutHeading ) & bPassed;
+
+    vTimeUpdates();
+
+    return bPassed ? 0 : 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iReplay( int argc, char ** argv )
+{
+    xHUDViewFusion_t xFusion;
+    xHUDViewFusionEstimate_t xEstimate;
+    xError_t xFusedSpeed = { 0 };
+    xError_t xHeldSpeed = { 0 };
+    xError_t xFusedHeading = { 0 };
+    xError_t xHeldHeading = { 0 };
+    xError_t xFusedWithheldSpeed = { 0 };
+    xError_t xHeldWithheldSpeed = { 0 };
+    xError_t xFusedWithheldHeading = { 0 };
+    xError_t xHeldWithheldHeading = { 0 };
+    xSample_t * pxGPS = NULL;
+    xSample_t * pxAccelerometer = NULL;
+    size_t ulGPS = 0;
+    size_t ulAccelerometer = 0;
+    size_t ulNextGPS = 0;
+    size_t ulNextAccelerometer = 0;
+    double dDropout = 10.0;
+    double dEvery = 60.0;
+    double dHeldSpeed = 0.0;
+    double dHeldHeading = 0.0;
+    int bHeldSpeed = 0;
+    int bHeldHeading = 0;
+    unsigned long ulWithheld = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "d:e:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'd':
+            dDropout = atof( optarg );
+            break;
+
+        case 'e':
+            dEvery = atof( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( optind >= argc ) || ( 0.0 > dDropout ) || ( dDropout >= dEvery ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    pxGPS = pxLoadTrace( argv[ optind ], "GPS", 1, &ulGPS );
+    pxAccelerometer = pxLoadTrace( argv[ optind ], "Accelerometer", 0, &ulAccelerometer );
+
+    if ( ( NULL == pxGPS ) || ( 0 == ulGPS ) )
+    {
+        fprintf( stderr, "No GPS fixes in: %s\n", argv[ optind ] );
+        return -1;
+    }
+
+    vHUDViewFusionInit( &xFusion );
+
+    /* Feed both streams in the order they arrived. */
+    while ( ulNextGPS < ulGPS )
+    {
+        const xSample_t * pxFix = &pxGPS[ ulNextGPS ];
+        double dSpeed = pxFix->adValues[ 0 ] * HUDVIEW_FUSION_KNOTS_TO_METRES_PER_SECOND;
+        double dCourse = pxFix->adValues[ 1 ];
+        int bScoreHeading = 0;
+
+        if ( ( ulNextAccelerometer < ulAccelerometer )
+             && ( pxAccelerometer[ ulNextAccelerometer ].llMicroseconds <= pxFix->llMicroseconds ) )
+        {
+            const xSample_t * pxSample = &pxAccelerometer[ ulNextAccelerometer++ ];
+
+            vHUDViewFusionAccelerometer( &xFusion, pxSample->llMicroseconds,
+                                         pxSample->adValues[ 0 ] * HUDVIEW_FUSION_GRAVITY,
+                                         pxSample->adValues[ 1 ] * HUDVIEW_FUSION_GRAVITY );
+            continue;
+        }
+
+        ulNextGPS++;
+
+        /* Score the estimate made without this fix against it, once the filter has had a fix to start from. */
+        if ( bHeldSpeed )
+        {
+            int bWithheld = bInDropout( pxFix->llMicroseconds, dDropout, dEvery );
+
+            vHUDViewFusionPredict( &xFusion, pxFix->llMicroseconds );
+            vHUDViewFusionEstimate( &xFusion, pxFix->llMicroseconds, &xEstimate );
+            bScoreHeading = ( HUDVIEW_FUSION_MINIMUM_TURN_SPEED < dSpeed ) && xEstimate.bHeadingValid && bHeldHeading;
+
+            /* The fix is itself noisy, so it is expected within two standard deviations of the difference. */
+            vAddError( bWithheld ? &xFusedWithheldSpeed : &xFusedSpeed, xEstimate.dSpeed - dSpeed,
+                       hypot( xEstimate.dSpeedSigma, HUDVIEW_FUSION_GPS_SPEED_SIGMA ) );
+            vAddError( bWithheld ? &xHeldWithheldSpeed : &xHeldSpeed, dHeldSpeed - dSpeed, 0.0 );
+
+            if ( bScoreHeading )
+            {
+                vAddError( bWithheld ? &xFusedWithheldHeading : &xFusedHeading,
+                           dHeadingError( xEstimate.dHeading, dCourse ),
+                           hypot( xEstimate.dHeadingSigma, HUDVIEW_FUSION_GPS_SPEED_SIGMA / dSpeed * 180.0 / M_PI ) );
+                vAddError( bWithheld ? &xHeldWithheldHeading : &xHeldHeading, dHeadingError( dHeldHeading, dCourse ),
+                           0.0 );
+            }
+
+            if ( bWithheld )
+            {
+                ulWithheld++;
+                continue;
+            }
+        }
+
+        vHUDViewFusionGPS( &xFusion, pxFix->llMicroseconds, dSpeed, dCourse );
+        dHeldSpeed = dSpeed;
+        bHeldSpeed = 1;
+
+        if ( HUDVIEW_FUSION_MINIMUM_COURSE_SPEED <= dSpeed )
+        {
+            dHeldHeading = dCourse;
+            bHeldHeading = 1;
+        }
+    }
+
+    printf( "Ride: %zu GPS fixes (%lu withheld in %.0f s dropouts every %.0f s), %zu accelerometer samples\n", ulGPS,
+            ulWithheld, dDropout, dEvery, ulAccelerometer );
+    printf( "GPS fixes: %lu applied, %lu rejected\n", xFusion.ulGPSUpdates, xFusion.ulGPSRejected );
+    printf( "\n%-22s %14s %14s %14s\n", "", "last fix RMS", "fused RMS", "fused in 2sd" );
+    printf( "%-22s %11.3f m/s %11.3f m/s %13.1f%%\n", "Speed, next fix", dRMS( &xHeldSpeed ), dRMS( &xFusedSpeed ),
+            dCoverage( &xFusedSpeed ) );
+    printf( "%-22s %11.3f m/s %11.3f m/s %13.1f%%\n", "Speed, withheld fixes", dRMS( &xHeldWithheldSpeed ),
+            dRMS( &xFusedWithheldSpeed ), dCoverage( &xFusedWithheldSpeed ) );
+    printf( "%-22s %11.2f deg %11.2f deg %13.1f%%\n", "Heading, next fix", dRMS( &xHeldHeading ),
+            dRMS( &xFusedHeading ), dCoverage( &xFusedHeading ) );
+    printf( "%-22s %11.2f deg %11.2f deg %13.1f%%\n", "Heading, withheld", dRMS( &xHeldWithheldHeading ),
+            dRMS( &xFusedWithheldHeading ), dCoverage( &xFusedWithheldHeading ) );
+
+    free( pxGPS );
+    free( pxAccelerometer );
+
+    vTimeUpdates();
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bInDropout( int64_t llMicroseconds, double dDropout, double dEvery )
+{
+    /* The last part of every period, so the filter has settled before the first one. */
+    double dPhase = fmod( llMicroseconds / ( double )MICROSECONDS_PER_SECOND, dEvery );
+
+    return dPhase >= dEvery - dDropout;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static xSample_t * pxLoadTrace( const char * pcDirectory, const char * pcComponent, int bGPS, size_t * pulCount )
+{
+    xSample_t * pxSamples = NULL;
+    xSample_t * pxGrown = NULL;
+    size_t ulCapacity = 0;
+    char * pcLine = NULL;
+    char * pcRecord = NULL;
+    size_t ulLineLength = 0;
+    char acPath[ 4096 ];
+    FILE * pxTrace = NULL;
+    xSample_t xSample;
+
+    *pulCount = 0;
+    snprintf( acPath, sizeof( acPath ), "%s/%s.trace", pcDirectory, pcComponent );
+    pxTrace = fopen( acPath, "r" );
+
+    if ( NULL == pxTrace )
+    {
+        fprintf( stderr, "Failed to open trace file: %s\n", acPath );
+        return NULL;
+    }
+
+    while ( -1 != getline( &pcLine, &ulLineLength, pxTrace ) )
+    {
+        memset( &xSample, 0, sizeof( xSample ) );
+
+        /* Skip comments and anything that does not carry a timestamp. */
+        if ( '#' == pcLine[ 0 ] )
+        {
+            continue;
+        }
+
+        xSample.llMicroseconds = strtoll( pcLine, &pcRecord, 10 );
+
+        if ( pcRecord == pcLine )
+        {
+            continue;
+        }
+
+        /* Rides recorded from stamped components carry the stamp ahead of the record. */
+        pcRecord += strspn( pcRecord, " \t" );
+        pcRecord += ulHUDViewTraceParse( pcRecord, strlen( pcRecord ), NULL );
+
+        /* Only fixes are kept from the GPS; the accelerometer prints x,y,z in g. */
+        if ( bGPS ? !bParseRMC( pcRecord, &xSample.adValues[ 0 ], &xSample.adValues[ 1 ] )
+                  : ( 3 != sscanf( pcRecord, " %lf,%lf,%lf", &xSample.adValues[ 0 ], &xSample.adValues[ 1 ],
+                                   &xSample.adValues[ 2 ] ) ) )
+        {
+            continue;
+        }
+
+        if ( *pulCount == ulCapacity )
+        {
+            ulCapacity = ( 0 == ulCapacity ) ? 4096 : ulCapacity * 2;
+            pxGrown = realloc( pxSamples, ulCapacity * sizeof( xSample_t ) );
+
+            if ( NULL == pxGrown )
+            {
+                fprintf( stderr, "Out of memory\n" );
+                break;
+            }
+
+            pxSamples = pxGrown;
+        }
+
+        pxSamples[ ( *pulCount )++ ] = xSample;
+    }
+
+    free( pcLine );
+    fclose( pxTrace );
+
+    return pxSamples;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bParseRMC( const char * pcRecord, double * pdSpeed, double * pdCourse )
+{
+    const char * pcField = strstr( pcRecord, "GPRMC," );
+    int iField = 0;
+
+    if ( NULL == pcField )
+    {
+        return 0;
+    }
+
+    /* $GPRMC,time,status,latitude,N,longitude,W,speed,course,... with status A for a valid fix. */
+    for ( iField = 0; ( NULL != pcField ) && ( 8 >= iField ); iField++ )
+    {
+        if ( ( 2 == iField ) && ( 'A' != *pcField ) )
+        {
+            return 0;
+        }
+        else if ( 7 == iField )
+        {
+            *pdSpeed = atof( pcField );
+        }
+        else if ( 8 == iField )
+        {
+            *pdCourse = atof( pcField );
+            return 1;
+        }
+
+        pcField = strchr( pcField, ',' );
+        pcField = ( NULL != pcField ) ? pcField + 1 : NULL;
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vAddError( xError_t * pxError, double dError, double dSigma )
+{
+    pxError->dSquares += dError * dError;
+    pxError->ulCount++;
+    pxError->ulCovered += ( fabs( dError ) <= 2.0 * dSigma ) ? 1 : 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dHeadingError( double dEstimate, double dTruth )
+{
+    return fmod( dEstimate - dTruth + 540.0, 360.0 ) - 180.0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dRMS( const xError_t * pxError )
+{
+    return ( 0 < pxError->ulCount ) ? sqrt( pxError->dSquares / pxError->ulCount ) : 0.0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dCoverage( const xError_t * pxError )
+{
+    return ( 0 < pxError->ulCount ) ? 100.0 * pxError->ulCovered / pxError->ulCount : 0.0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bCheckError( const char * pcName, const xError_t * pxFused, const xError_t * pxHeld )
+{
+    int bReturn = 1;
+
+    /* Nothing scored is nothing wrong, as for a heading never valid within a dropout. A filter that holds the last
+     * course, as on a leaning two-wheeler, ties with it up to rounding. */
+    if ( ( 0 < pxFused->ulCount ) && ( dRMS( pxFused ) > dRMS( pxHeld ) * ( 1.0 + 1e-6 ) ) )
+    {
+        fprintf( stderr, "FAIL: %s fused RMS %.3f is worse than the last fix's %.3f\n", pcName, dRMS( pxFused ),
+                 dRMS( pxHeld ) );
+        bReturn = 0;
+    }
+
+    if ( ( 0 < pxFused->ulCount ) && ( MINIMUM_COVERAGE_PERCENT > dCoverage( pxFused ) ) )
+    {
+        fprintf( stderr, "FAIL: %s truth within two reported standard deviations %.1f%% of the time, below %.0f%%\n",
+                 pcName, dCoverage( pxFused ), MINIMUM_COVERAGE_PERCENT );
+        bReturn = 0;
+    }
+
+    return bReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dGaussian( void )
+{
+    double dU1 = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+    double dU2 = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+
+    return sqrt( -2.0 * log( dU1 ) ) * cos( 2.0 * M_PI * dU2 );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vTimeUpdates( void )
+{
+    static double adLongitudinal[ TIMING_SAMPLES ];
+    static double adLateral[ TIMING_SAMPLES ];
+    static double adSpeed[ TIMING_SAMPLES ];
+    xHUDViewFusion_t xFusion;
+    xHUDViewFusionEstimate_t xEstimate;
+    double dChecksum = 0.0;
+    double dStart = 0.0;
+    double adNanoseconds[ 3 ];
+    int64_t llTime = 0;
+    int iUpdate = 0;
+
+    /* Noise is generated up front so only the filter is timed. */
+    for ( iUpdate = 0; iUpdate < TIMING_SAMPLES; iUpdate++ )
+    {
+        adLongitudinal[ iUpdate ] = 0.5 * dGaussian();
+        adLateral[ iUpdate ] = 0.5 * dGaussian();
+        adSpeed[ iUpdate ] = 10.0 + dGaussian();
+    }
+
+    vHUDViewFusionInit( &xFusion );
+    vHUDViewFusionGPS( &xFusion, 1, 10.0, 90.0 );
+
+    dStart = dNow();
+
+    for ( iUpdate = 0; iUpdate < TIMING_UPDATES; iUpdate++ )
+    {
+        llTime += ACCELEROMETER_PERIOD_US;
+        vHUDViewFusionAccelerometer( &xFusion, llTime, adLongitudinal[ iUpdate % TIMING_SAMPLES ],
+                                     adLateral[ iUpdate % TIMING_SAMPLES ] );
+    }
+
+    adNanoseconds[ 0 ] = ( dNow() - dStart ) * 1e9 / TIMING_UPDATES;
+    dStart = dNow();
+
+    for ( iUpdate = 0; iUpdate < TIMING_UPDATES; iUpdate++ )
+    {
+        llTime += GPS_PERIOD_US;
+        vHUDViewFusionGPS( &xFusion, llTime, adSpeed[ iUpdate % TIMING_SAMPLES ],
+                           90.0 + adLateral[ iUpdate % TIMING_SAMPLES ] );
+    }
+
+    adNanoseconds[ 1 ] = ( dNow() - dStart ) * 1e9 / TIMING_UPDATES;
+    dStart = dNow();
+
+    for ( iUpdate = 0; iUpdate < TIMING_UPDATES; iUpdate++ )
+    {
+        llTime += OUTPUT_PERIOD_US;
+        vHUDViewFusionPredict( &xFusion, llTime );
+        vHUDViewFusionEstimate( &xFusion, llTime, &xEstimate );
+        dChecksum += xEstimate.dSpeed;
+    }
+
+    adNanoseconds[ 2 ] = ( dNow() - dStart ) * 1e9 / TIMING_UPDATES;
+
+    printf( "\nCost per update (%d updates each, checksum %.0f):\n", TIMING_UPDATES, dChecksum );
+    printf( "  accelerometer sample   %8.1f ns\n", adNanoseconds[ 0 ] );
+    printf( "  GPS fix                %8.1f ns\n", adNanoseconds[ 1 ] );
+    printf( "  predict and estimate   %8.1f ns\n", adNanoseconds[ 2 ] );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return xNow.tv_sec + xNow.tv_nsec / 1e9;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s bench [-s seconds] [-d dropout_seconds] [-e every_seconds] [-l] [-r seed]\n",
+             pcProgram );
+    fprintf( stderr, "       %s replay [-d dropout_seconds] [-e every_seconds] record_directory\n", pcProgram );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,251 @@
+/** @file hudview_metrics.c
+ *  @brief HUDView live latency and throughput viewer.
+ *
+ *  This program attaches to the metrics page published by the control application and prints, for every component
+ *  and pipeline stage, the number of samples along with the p50, p99 and maximum latency. By default each report
+ *  covers only the samples recorded since the previous one, so the figures follow the system live; -c reports the
+ *  totals since the control application started instead.
+ *
+ *  Usage: hudview_metrics [-i interval_seconds] [-c] [-1]
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_metrics.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define DEFAULT_INTERVAL_SECONDS ( 1 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static volatile sig_atomic_t bRunning = 1;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSignalHandler( int iSignal );
+static void vSnapshot( const xHUDViewMetricsPage_t * pxPage, xHUDViewMetricsPage_t * pxSnapshot );
+static void vReport( const xHUDViewMetricsPage_t * pxCurrent, const xHUDViewMetricsPage_t * pxPrevious,
+                     double dSeconds );
+static void vDifference( const xHUDViewHistogram_t * pxCurrent, const xHUDViewHistogram_t * pxPrevious,
+                         xHUDViewHistogram_t * pxDifference );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    const xHUDViewMetricsPage_t * pxPage = NULL;
+    xHUDViewMetricsPage_t * pxCurrent = NULL;
+    xHUDViewMetricsPage_t * pxPrevious = NULL;
+    unsigned int uiInterval = DEFAULT_INTERVAL_SECONDS;
+    int bCumulative = 0;
+    int bOnce = 0;
+    int iOption = 0;
+    uint64_t ullLastReport = 0;
+    uint64_t ullNow = 0;
+
+    /* Install the Ctrl-C handler. */
+    signal( SIGINT, vSignalHandler );
+
+    while ( -1 != ( iOption = getopt( argc, argv, "i:c1" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'i':
+            uiInterval = ( unsigned int )atoi( optarg );
+            break;
+
+        case 'c':
+            bCumulative = 1;
+            break;
+
+        case '1':
+            bOnce = 1;
+            break;
+
+        default:
+            fprintf( stderr, "Usage: %s [-i interval_seconds] [-c] [-1]\n", argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( 0 == uiInterval )
+    {
+        uiInterval = DEFAULT_INTERVAL_SECONDS;
+    }
+
+    pxPage = pxHUDViewMetricsAttach( 0, 0 );
+
+    if ( NULL == pxPage )
+    {
+        fprintf( stderr, "No metrics page found at %s; is the control application running?\n",
+                 HUDVIEW_METRICS_SHM_NAME );
+        return -1;
+    }
+
+    /* Snapshots are private copies so each report works from a consistent view of a page that keeps changing. */
+    pxCurrent = calloc( 1, sizeof( xHUDViewMetricsPage_t ) );
+    pxPrevious = calloc( 1, sizeof( xHUDViewMetricsPage_t ) );
+
+    if ( ( NULL == pxCurrent ) || ( NULL == pxPrevious ) )
+    {
+        fprintf( stderr, "Out of memory\n" );
+        return -1;
+    }
+
+    /* A single report, or the first of a cumulative series, covers everything since the page was created. */
+    ullLastReport = pxPage->ullCreatedNanoseconds;
+
+    if ( !bOnce && !bCumulative )
+    {
+        vSnapshot( pxPage, pxPrevious );
+        ullLastReport = ullHUDViewMetricsNow();
+        sleep( uiInterval );
+    }
+
+    while ( bRunning )
+    {
+        vSnapshot( pxPage, pxCurrent );
+        ullNow = ullHUDViewMetricsNow();
+        vReport( pxCurrent, pxPrevious, ( ullNow - ullLastReport ) / 1e9 );
+
+        if ( bOnce )
+        {
+            break;
+        }
+
+        if ( !bCumulative )
+        {
+            memcpy( pxPrevious, pxCurrent, sizeof( xHUDViewMetricsPage_t ) );
+            ullLastReport = ullNow;
+        }
+
+        sleep( uiInterval );
+    }
+
+    free( pxCurrent );
+    free( pxPrevious );
+    vHUDViewMetricsDetach( ( xHUDViewMetricsPage_t * )pxPage );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSignalHandler( int iSignal )
+{
+    /* Check for a signal to quit. */
+    if ( SIGINT == iSignal )
+    {
+        bRunning = 0;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSnapshot( const xHUDViewMetricsPage_t * pxPage, xHUDViewMetricsPage_t * pxSnapshot )
+{
+    /* Writers only ever add to the page, so a plain copy is a good enough snapshot for reporting. */
+    memcpy( pxSnapshot, pxPage, sizeof( xHUDViewMetricsPage_t ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vReport( const xHUDViewMetricsPage_t * pxCurrent, const xHUDViewMetricsPage_t * pxPrevious,
+                     double dSeconds )
+{
+    static xHUDViewHistogram_t xHistogram;
+    const xHUDViewMetricsComponent_t * pxComponent = NULL;
+    const xHUDViewMetricsComponent_t * pxBaseline = NULL;
+    uint64_t aullCounters[ eHUDViewMetricsCounterMax ];
+    int iComponent = 0;
+    int iStage = 0;
+    int iCounter = 0;
+
+    printf( "--- %.1f s ---------------------------------------------------------------------------\n", dSeconds );
+    printf( "%-18s %-16s %10s %12s %12s %12s\n", "component", "stage", "samples", "p50 us", "p99 us", "max us" );
+
+    for ( iComponent = 0; iComponent < HUDVIEW_METRICS_MAX_COMPONENTS; iComponent++ )
+    {
+        pxComponent = &pxCurrent->axComponents[ iComponent ];
+        pxBaseline = &pxPrevious->axComponents[ iComponent ];
+
+        if ( HUDVIEW_METRICS_SLOT_READY != pxComponent->ulState )
+        {
+            continue;
+        }
+
+        for ( iCounter = 0; iCounter < eHUDViewMetricsCounterMax; iCounter++ )
+        {
+            aullCounters[ iCounter ] = pxComponent->aullCounters[ iCounter ] - pxBaseline->aullCounters[ iCounter ];
+        }
+
+        for ( iStage = 0; iStage < eHUDViewMetricsStageMax; iStage++ )
+        {
+            vDifference( &pxComponent->axHistograms[ iStage ], &pxBaseline->axHistograms[ iStage ], &xHistogram );
+
+            if ( 0 == xHistogram.ullCount )
+            {
+                continue;
+            }
+
+            printf( "%-18s %-16s %10llu %12.1f %12.1f %12.1f\n", pxComponent->acName,
+                    pcHUDViewMetricsStageName( ( eHUDViewMetricsStage_t )iStage ),
+                    ( unsigned long long )xHistogram.ullCount,
+                    ullHUDViewMetricsPercentile( &xHistogram, 50.0 ) / 1000.0,
+                    ullHUDViewMetricsPercentile( &xHistogram, 99.0 ) / 1000.0,
+                    xHistogram.ullMaximum / 1000.0 );
+        }
+
+        if ( 0 != ( aullCounters[ eHUDViewMetricsCounter_RecordsIn ] | aullCounters[ eHUDViewMetricsCounter_Bytes ] ) )
+        {
+            printf( "%-18s %llu records in, %llu applied, %llu dropped, %.1f records/s, %.1f B/s\n",
+                    pxComponent->acName,
+                    ( unsigned long long )aullCounters[ eHUDViewMetricsCounter_RecordsIn ],
+                    ( unsigned long long )aullCounters[ eHUDViewMetricsCounter_RecordsApplied ],
+                    ( unsigned long long )( ( aullCounters[ eHUDViewMetricsCounter_RecordsIn ]
+                                              > aullCounters[ eHUDViewMetricsCounter_RecordsApplied ] )
+                                            ? aullCounters[ eHUDViewMetricsCounter_RecordsIn ]
+                                              - aullCounters[ eHUDViewMetricsCounter_RecordsApplied ] : 0 ),
+                    ( 0.0 < dSeconds ) ? aullCounters[ eHUDViewMetricsCounter_RecordsIn ] / dSeconds : 0.0,
+                    ( 0.0 < dSeconds ) ? aullCounters[ eHUDViewMetricsCounter_Bytes ] / dSeconds : 0.0 );
+        }
+
+        if ( 0 != aullCounters[ eHUDViewMetricsCounter_FramesPushed ] )
+        {
+            printf( "%-18s %llu frames pushed, %.1f frames/s\n", pxComponent->acName,
+                    ( unsigned long long )aullCounters[ eHUDViewMetricsCounter_FramesPushed ],
+                    ( 0.0 < dSeconds ) ? aullCounters[ eHUDViewMetricsCounter_FramesPushed ] / dSeconds : 0.0 );
+        }
+    }
+
+    fflush( stdout );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vDifference( const xHUDViewHistogram_t * pxCurrent, const xHUDViewHistogram_t * pxPrevious,
+                         xHUDViewHistogram_t * pxDifference )
+{
+    uint32_t ulBucket = 0;
+
+    pxDifference->ullCount = pxCurrent->ullCount - pxPrevious->ullCount;
+    pxDifference->ullSum = pxCurrent->ullSum - pxPrevious->ullSum;
+    pxDifference->ullMaximum = 0;
+
+    /* The maximum is not differentiable, so report the highest bucket hit during the interval. */
+    for ( ulBucket = 0; ulBucket < HUDVIEW_METRICS_BUCKETS; ulBucket++ )
+    {
+        pxDifference->aullBuckets[ ulBucket ] = pxCurrent->aullBuckets[ ulBucket ] - pxPrevious->aullBuckets[ ulBucket ];
+
+        if ( 0 != pxDifference->aullBuckets[ ulBucket ] )
+        {
+            pxDifference->ullMaximum = ullHUDViewMetricsBucketValue( ulBucket );
+        }
+    }
+
+    /* Without an earlier sample the exact maximum is known. */
+    if ( 0 == pxPrevious->ullCount )
+    {
+        pxDifference->ullMaximum = pxCurrent->ullMaximum;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
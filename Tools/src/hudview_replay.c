@@ -0,0 +1,195 @@
+/** @file hudview_replay.c
+ *  @brief HUDView recorded-ride replay stand-in.
+ *
+ *  This program stands in for a sensor component by playing back a trace recorded by the control application
+ *  (--record). Each trace line holds the microsecond offset at which the original component printed a record,
+ *  followed by the record itself. Records are printed to stdout at real-time, N times real-time, or as fast as
+ *  possible, so the control application can be driven without sensor hardware.
+ *
+ *  Usage: hudview_replay [-s speed] [-l] [-m component] trace_file
+ *
+ *  A speed of 0 replays as fast as possible. The HUDVIEW_REPLAY_SPEED environment variable overrides -s so every
+ *  stand-in listed in a config file can be switched at once. With -m, each write is stamped into the named
+ *  component's slot of the metrics page so pipe latency can be measured during a replay.
+ *
+ *  Records are stamped as the components stamp them (see hudview_trace.h), with the time each is printed: the times
+ *  in a recorded stamp are from the ride's own clock, so any stamp in the trace is replaced rather than passed on.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_memlock.h"
+#include "hudview_metrics.h"
+#include "hudview_trace.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define NANOSECONDS_PER_SECOND ( 1000000000LL )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSignalHandler( int iSignal );
+static void vWaitUntil( const struct timespec * pxStart, long long llOffsetNanoseconds );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    const char * pcSpeed = getenv( "HUDVIEW_REPLAY_SPEED" );
+    double dSpeed = 1.0;
+    int bLoop = 0;
+    int iOption = 0;
+    FILE * pxTrace = NULL;
+    char * pcLine = NULL;
+    size_t ulLineLength = 0;
+    char * pcRecord = NULL;
+    long long llTimestamp = 0;
+    long long llLoopOffset = 0;
+    long long llLastTimestamp = 0;
+    unsigned long ulRecords = 0;
+    uint64_t ullWritten = 0;
+    struct timespec xStart;
+    xHUDViewMetricsComponent_t * pxMetrics = NULL;
+    int iReturn = 0;
+
+    /* Install the Ctrl-C handler. */
+    signal( SIGINT, vSignalHandler );
+
+    /* Disable buffering on standard output so each record reaches the control application immediately. */
+    setbuf( stdout, NULL );
+
+    /* Honour the same memory locking request as the components being stood in for. */
+    if ( 0 > iHUDViewLockMemoryIfRequested() )
+    {
+        fprintf( stderr, "Failed to lock memory\n" );
+    }
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:lm:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 's':
+            dSpeed = atof( optarg );
+            break;
+
+        case 'l':
+            bLoop = 1;
+            break;
+
+        case 'm':
+            pxMetrics = pxHUDViewMetricsComponent( pxHUDViewMetricsAttach( 0, 1 ), optarg );
+            break;
+
+        default:
+            fprintf( stderr, "Usage: %s [-s speed] [-l] [-m component] trace_file\n", argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( NULL != pcSpeed )
+    {
+        dSpeed = atof( pcSpeed );
+    }
+
+    if ( ( optind >= argc ) || ( 0.0 > dSpeed ) )
+    {
+        fprintf( stderr, "Usage: %s [-s speed] [-l] [-m component] trace_file\n", argv[ 0 ] );
+        return -1;
+    }
+
+    pxTrace = fopen( argv[ optind ], "r" );
+
+    if ( NULL == pxTrace )
+    {
+        fprintf( stderr, "Failed to open trace file: %s\n", argv[ optind ] );
+        return -1;
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+    for ( ;; )
+    {
+        if ( -1 == getline( &pcLine, &ulLineLength, pxTrace ) )
+        {
+            /* Start over, keeping time moving forward, or stop at the end of the ride. */
+            if ( bLoop && ( 0 < ulRecords ) )
+            {
+                llLoopOffset += llLastTimestamp;
+                rewind( pxTrace );
+                continue;
+            }
+
+            break;
+        }
+
+        /* Skip comments and anything that does not carry a timestamp. */
+        if ( '#' == pcLine[ 0 ] )
+        {
+            continue;
+        }
+
+        llTimestamp = strtoll( pcLine, &pcRecord, 10 );
+
+        if ( ( pcRecord == pcLine ) || ( ( ' ' != *pcRecord ) && ( '\t' != *pcRecord ) ) )
+        {
+            continue;
+        }
+
+        pcRecord++;
+        pcRecord += ulHUDViewTraceParse( pcRecord, strlen( pcRecord ), NULL );
+        llLastTimestamp = llTimestamp;
+
+        if ( 0.0 < dSpeed )
+        {
+            vWaitUntil( &xStart, ( long long )( ( llLoopOffset + llTimestamp ) * 1000LL / dSpeed ) );
+        }
+
+        ullWritten = ullHUDViewMetricsNow();
+
+        if ( 0 > printf( HUDVIEW_TRACE_STAMP_FORMAT "%s", ( uint32_t )( ulRecords + 1 ), ullWritten, pcRecord ) )
+        {
+            /* The control application went away. */
+            iReturn = -1;
+            break;
+        }
+
+        vHUDViewMetricsMarkWrite( pxMetrics, ullWritten );
+        ulRecords++;
+    }
+
+    free( pcLine );
+    fclose( pxTrace );
+    fprintf( stderr, "Replayed %lu records from %s\n", ulRecords, argv[ optind ] );
+
+    return iReturn;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vSignalHandler( int iSignal )
+{
+    /* Check for a signal to quit. */
+    if ( SIGINT == iSignal )
+    {
+        exit( 0 );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vWaitUntil( const struct timespec * pxStart, long long llOffsetNanoseconds )
+{
+    struct timespec xDeadline;
+    long long llNanoseconds = pxStart->tv_nsec + llOffsetNanoseconds;
+
+    xDeadline.tv_sec = pxStart->tv_sec + ( time_t )( llNanoseconds / NANOSECONDS_PER_SECOND );
+    xDeadline.tv_nsec = ( long )( llNanoseconds % NANOSECONDS_PER_SECOND );
+
+    /* Sleep against an absolute deadline so scheduling delays do not accumulate over the ride. */
+    while ( EINTR == clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xDeadline, NULL ) )
+    {
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
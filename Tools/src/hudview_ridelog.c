@@ -0,0 +1,814 @@
+/** @file hudview_ridelog.c
+ *  @brief HUDView ride log query, export and benchmark tool.
+ *
+ *  This program maps a ride log written by the control application and answers queries over it without reading more
+ *  of the file than needed: the chunk index is binary searched for the start of the requested window and only the
+ *  chunks overlapping it are decoded.
+ *
+ *  Usage: hudview_ridelog info ride_file
+ *         hudview_ridelog csv [-s start] [-e end] [-t accelerometer|gps|light] ride_file
+ *         hudview_ridelog gpx [-s start] [-e end] ride_file
+ *         hudview_ridelog bench [-H hours] [-r accelerometer_hz] [-o ride_file]
+ *
+ *  Start and end are UNIX times in (fractional) seconds. CSV output merges the selected streams in time order; GPX
+ *  output is a track of every GPS fix. The bench command writes a synthetic ride of the given length and reports the
+ *  compression ratio per stream, encode and full-scan decode throughput, and the latency of a random seek.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_ridelog.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define MICROSECONDS_PER_SECOND ( 1000000LL )
+#define KNOTS_TO_METRES_PER_SECOND ( 0.514444 )
+#define BENCH_DEFAULT_PATH "hudview_ridelog_bench.hrl"
+#define BENCH_SEEKS ( 10000 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    const uint8_t * pucFile;
+    size_t ulSize;
+    xHUDViewRideLogIndexEntry_t * pxEntries;
+    uint32_t ulEntries;
+    int bIndexed;
+
+    /* Entries of each stream in time order, for binary searching. */
+    xHUDViewRideLogIndexEntry_t * apxStreamEntries[ eHUDViewRideLogStreamMax ];
+    uint32_t aulStreamEntries[ eHUDViewRideLogStreamMax ];
+} xRideLogFile_t;
+
+/* Position within one stream of a query; holds the decoded chunk under it. */
+typedef struct {
+    const xRideLogFile_t * pxFile;
+    eHUDViewRideLogStream_t eStream;
+    uint32_t ulChunk;
+    int iSamples;
+    int iSample;
+    int64_t allMicroseconds[ HUDVIEW_RIDELOG_CHUNK_SAMPLES ];
+    double adValues[ HUDVIEW_RIDELOG_CHUNK_SAMPLES * HUDVIEW_RIDELOG_MAX_COLUMNS ];
+} xCursor_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iInfo( int argc, char ** argv );
+static int iExportCSV( int argc, char ** argv );
+static int iExportGPX( int argc, char ** argv );
+static int iBench( int argc, char ** argv );
+static int iParseWindow( int iOption, int64_t * pllStart, int64_t * pllEnd );
+static int iOpenFile( const char * pcPath, xRideLogFile_t * pxFile );
+static void vCloseFile( xRideLogFile_t * pxFile );
+static void vCursorStart( xCursor_t * pxCursor, const xRideLogFile_t * pxFile, eHUDViewRideLogStream_t eStream,
+                          int64_t llStart );
+static int bCursorValid( const xCursor_t * pxCursor );
+static int64_t llCursorTime( const xCursor_t * pxCursor );
+static const double * pdCursorValues( const xCursor_t * pxCursor );
+static void vCursorNext( xCursor_t * pxCursor );
+static double dNMEAToDegrees( double dNMEA );
+static double dNow();
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    if ( 2 > argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Each command parses its own options after the command name. */
+    optind = 2;
+
+    if ( 0 == strcmp( argv[ 1 ], "info" ) )
+    {
+        return iInfo( argc, argv );
+    }
+    else if ( 0 == strcmp( argv[ 1 ], "csv" ) )
+    {
+        return iExportCSV( argc, argv );
+    }
+    else if ( 0 == strcmp( argv[ 1 ], "gpx" ) )
+    {
+        return iExportGPX( argc, argv );
+    }
+    else if ( 0 == strcmp( argv[ 1 ], "bench" ) )
+    {
+        return iBench( argc, argv );
+    }
+
+    vUsage( argv[ 0 ] );
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iInfo( int argc, char ** argv )
+{
+    xRideLogFile_t xFile;
+    const xHUDViewRideLogHeader_t * pxHeader = NULL;
+    unsigned long long aullSamples[ eHUDViewRideLogStreamMax ] = { 0 };
+    unsigned long long aullBytes[ eHUDViewRideLogStreamMax ] = { 0 };
+    unsigned long long ullRawBytes = 0;
+    const xHUDViewRideLogIndexEntry_t * pxFirst = NULL;
+    const xHUDViewRideLogIndexEntry_t * pxLast = NULL;
+    uint32_t ulEntry = 0;
+    int iStream = 0;
+
+    if ( ( optind >= argc ) || ( 0 != iOpenFile( argv[ optind ], &xFile ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    pxHeader = ( const xHUDViewRideLogHeader_t * )xFile.pucFile;
+    printf( "Created:  %lld.%06lld\n", ( long long )( pxHeader->llCreatedMicroseconds / MICROSECONDS_PER_SECOND ),
+            ( long long )( pxHeader->llCreatedMicroseconds % MICROSECONDS_PER_SECOND ) );
+    printf( "Size:     %zu bytes in %u chunks (%s)\n", xFile.ulSize, xFile.ulEntries,
+            xFile.bIndexed ? "indexed" : "index rebuilt, log was not closed" );
+
+    for ( ulEntry = 0; ulEntry < xFile.ulEntries; ulEntry++ )
+    {
+        const xHUDViewRideLogIndexEntry_t * pxEntry = &xFile.pxEntries[ ulEntry ];
+        const xHUDViewRideLogChunk_t * pxChunk =
+            ( const xHUDViewRideLogChunk_t * )( xFile.pucFile + pxEntry->ullOffset );
+
+        aullSamples[ pxEntry->usStream ] += pxEntry->ulSamples;
+        aullBytes[ pxEntry->usStream ] += sizeof( xHUDViewRideLogChunk_t ) + pxChunk->ulPayloadBytes;
+    }
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        if ( 0 == xFile.aulStreamEntries[ iStream ] )
+        {
+            continue;
+        }
+
+        pxFirst = &xFile.apxStreamEntries[ iStream ][ 0 ];
+        pxLast = &xFile.apxStreamEntries[ iStream ][ xFile.aulStreamEntries[ iStream ] - 1 ];
+        ullRawBytes = aullSamples[ iStream ] * ( 8 + 8 * iHUDViewRideLogColumns( ( eHUDViewRideLogStream_t )iStream ) );
+
+        printf( "%-14s %10llu samples %8u chunks  %lld.%06lld - %lld.%06lld  %5.1f bytes/sample  %5.2fx\n",
+                pcHUDViewRideLogStreamName( ( eHUDViewRideLogStream_t )iStream ), aullSamples[ iStream ],
+                xFile.aulStreamEntries[ iStream ],
+                ( long long )( pxFirst->llFirstMicroseconds / MICROSECONDS_PER_SECOND ),
+                ( long long )( pxFirst->llFirstMicroseconds % MICROSECONDS_PER_SECOND ),
+                ( long long )( pxLast->llLastMicroseconds / MICROSECONDS_PER_SECOND ),
+                ( long long )( pxLast->llLastMicroseconds % MICROSECONDS_PER_SECOND ),
+                ( double )aullBytes[ iStream ] / ( double )aullSamples[ iStream ],
+                ( double )ullRawBytes / ( double )aullBytes[ iStream ] );
+    }
+
+    vCloseFile( &xFile );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iExportCSV( int argc, char ** argv )
+{
+    xRideLogFile_t xFile;
+    xCursor_t * pxCursors = NULL;
+    xCursor_t * pxNext = NULL;
+    const double * pdValues = NULL;
+    int64_t llStart = INT64_MIN;
+    int64_t llEnd = INT64_MAX;
+    int64_t llTime = 0;
+    int iSelected = eHUDViewRideLogStreamMin;
+    int iStream = 0;
+    int iOption = 0;
+    unsigned long long ullPrinted = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:e:t:" ) ) )
+    {
+        if ( 't' == iOption )
+        {
+            for ( iSelected = eHUDViewRideLogStreamMin + 1; iSelected < eHUDViewRideLogStreamMax; iSelected++ )
+            {
+                if ( 0 == strcmp( optarg, pcHUDViewRideLogStreamName( ( eHUDViewRideLogStream_t )iSelected ) ) )
+                {
+                    break;
+                }
+            }
+
+            if ( eHUDViewRideLogStreamMax == iSelected )
+            {
+                vUsage( argv[ 0 ] );
+                return -1;
+            }
+        }
+        else if ( 0 != iParseWindow( iOption, &llStart, &llEnd ) )
+        {
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( optind >= argc ) || ( 0 != iOpenFile( argv[ optind ], &xFile ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    pxCursors = malloc( eHUDViewRideLogStreamMax * sizeof( xCursor_t ) );
+
+    if ( NULL == pxCursors )
+    {
+        fprintf( stderr, "Out of memory\n" );
+        return -1;
+    }
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        vCursorStart( &pxCursors[ iStream ], &xFile, ( eHUDViewRideLogStream_t )iStream, llStart );
+    }
+
+    printf( "time,stream,x,y,z,fix,latitude,longitude,speed,direction,lux\n" );
+
+    /* Merge the streams in time order. */
+    for ( ;; )
+    {
+        pxNext = NULL;
+
+        for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+        {
+            if ( ( ( eHUDViewRideLogStreamMin == iSelected ) || ( iSelected == iStream ) )
+                 && bCursorValid( &pxCursors[ iStream ] )
+                 && ( ( NULL == pxNext ) || ( llCursorTime( &pxCursors[ iStream ] ) < llCursorTime( pxNext ) ) ) )
+            {
+                pxNext = &pxCursors[ iStream ];
+            }
+        }
+
+        if ( ( NULL == pxNext ) || ( llCursorTime( pxNext ) > llEnd ) )
+        {
+            break;
+        }
+
+        llTime = llCursorTime( pxNext );
+        pdValues = pdCursorValues( pxNext );
+        printf( "%lld.%06lld,%s,", ( long long )( llTime / MICROSECONDS_PER_SECOND ),
+                ( long long )( llTime % MICROSECONDS_PER_SECOND ), pcHUDViewRideLogStreamName( pxNext->eStream ) );
+
+        switch ( pxNext->eStream )
+        {
+        case eHUDViewRideLogStream_Accelerometer:
+            printf( "%f,%f,%f,,,,,,\n", pdValues[ 0 ], pdValues[ 1 ], pdValues[ 2 ] );
+            break;
+
+        case eHUDViewRideLogStream_GPS:
+            printf( ",,,%d,%.6f,%.6f,%.2f,%.2f,\n", ( int )pdValues[ 0 ], dNMEAToDegrees( pdValues[ 1 ] ),
+                    -dNMEAToDegrees( pdValues[ 2 ] ), pdValues[ 3 ], pdValues[ 4 ] );
+            break;
+
+        default:
+            printf( ",,,,,,,,%.0f\n", pdValues[ 0 ] );
+            break;
+        }
+
+        ullPrinted++;
+        vCursorNext( pxNext );
+    }
+
+    fprintf( stderr, "%llu samples printed\n", ullPrinted );
+
+    free( pxCursors );
+    vCloseFile( &xFile );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iExportGPX( int argc, char ** argv )
+{
+    xRideLogFile_t xFile;
+    xCursor_t * pxCursor = NULL;
+    const double * pdValues = NULL;
+    int64_t llStart = INT64_MIN;
+    int64_t llEnd = INT64_MAX;
+    int64_t llTime = 0;
+    time_t xSeconds = 0;
+    struct tm xTime;
+    char acTime[ 32 ];
+    int iOption = 0;
+    unsigned long long ullPoints = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "s:e:" ) ) )
+    {
+        if ( 0 != iParseWindow( iOption, &llStart, &llEnd ) )
+        {
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( optind >= argc ) || ( 0 != iOpenFile( argv[ optind ], &xFile ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    pxCursor = malloc( sizeof( xCursor_t ) );
+
+    if ( NULL == pxCursor )
+    {
+        fprintf( stderr, "Out of memory\n" );
+        return -1;
+    }
+
+    /* GPX 1.0, since 1.1 dropped the per-point speed and course. */
+    printf( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
+    printf( "<gpx version=\"1.0\" creator=\"hudview_ridelog\" xmlns=\"http://www.topografix.com/GPX/1/0\">\n" );
+    printf( "<trk><name>HUDView ride</name><trkseg>\n" );
+
+    for ( vCursorStart( pxCursor, &xFile, eHUDViewRideLogStream_GPS, llStart );
+          bCursorValid( pxCursor ) && ( llCursorTime( pxCursor ) <= llEnd ); vCursorNext( pxCursor ) )
+    {
+        pdValues = pdCursorValues( pxCursor );
+
+        if ( 0.0 == pdValues[ 0 ] )
+        {
+            continue;
+        }
+
+        llTime = llCursorTime( pxCursor );
+        xSeconds = ( time_t )( llTime / MICROSECONDS_PER_SECOND );
+        gmtime_r( &xSeconds, &xTime );
+        strftime( acTime, sizeof( acTime ), "%Y-%m-%dT%H:%M:%S", &xTime );
+
+        /* The GPS component reports NMEA ddmm.mmmm with the hemispheres fixed at north and west. */
+        printf( "<trkpt lat=\"%.7f\" lon=\"%.7f\"><time>%s.%03dZ</time><course>%.2f</course><speed>%.3f</speed>"
+                "</trkpt>\n", dNMEAToDegrees( pdValues[ 1 ] ), -dNMEAToDegrees( pdValues[ 2 ] ), acTime,
+                ( int )( ( llTime % MICROSECONDS_PER_SECOND ) / 1000 ), pdValues[ 4 ],
+                pdValues[ 3 ] * KNOTS_TO_METRES_PER_SECOND );
+        ullPoints++;
+    }
+
+    printf( "</trkseg></trk>\n</gpx>\n" );
+    fprintf( stderr, "%llu track points printed\n", ullPoints );
+
+    free( pxCursor );
+    vCloseFile( &xFile );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBench( int argc, char ** argv )
+{
+    xHUDViewRideLogWriter_t xWriter;
+    xRideLogFile_t xFile;
+    xCursor_t * pxCursor = NULL;
+    const char * pcPath = BENCH_DEFAULT_PATH;
+    double dHours = 3.0;
+    double dRate = 100.0;
+    int64_t * apllTimes[ eHUDViewRideLogStreamMax ] = { NULL };
+    double * apdValues[ eHUDViewRideLogStreamMax ] = { NULL };
+    size_t aulCounts[ eHUDViewRideLogStreamMax ] = { 0 };
+    size_t aulNext[ eHUDViewRideLogStreamMax ] = { 0 };
+    unsigned long long aullSamples[ eHUDViewRideLogStreamMax ] = { 0 };
+    unsigned long long aullBytes[ eHUDViewRideLogStreamMax ] = { 0 };
+    unsigned long long ullDecoded = 0;
+    unsigned long long ullTotalRaw = 0;
+    int64_t llStart = 1700000000LL * MICROSECONDS_PER_SECOND;
+    int64_t llDuration = 0;
+    int64_t llPeriod = 0;
+    int64_t llTime = 0;
+    double dHeading = 0.0;
+    double dLatitude = 4807.0380;
+    double dLongitude = 1131.0000;
+    double dSpeed = 0.0;
+    double dStart = 0.0;
+    double dSeconds = 0.0;
+    double dChecksum = 0.0;
+    double * pdValues = NULL;
+    char acText[ 32 ];
+    int bKeep = 0;
+    int iOption = 0;
+    int iStream = 0;
+    int iNext = 0;
+    int iAxis = 0;
+    int iSeek = 0;
+    uint32_t ulEntry = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "H:r:o:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'H':
+            dHours = atof( optarg );
+            break;
+
+        case 'r':
+            dRate = atof( optarg );
+            break;
+
+        case 'o':
+            pcPath = optarg;
+            bKeep = 1;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( 0.0 >= dHours ) || ( 0.0 >= dRate ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    llDuration = ( int64_t )( dHours * 3600.0 * MICROSECONDS_PER_SECOND );
+    llPeriod = ( int64_t )( MICROSECONDS_PER_SECOND / dRate );
+    aulCounts[ eHUDViewRideLogStream_Accelerometer ] = ( size_t )( llDuration / llPeriod ) + 1;
+    aulCounts[ eHUDViewRideLogStream_GPS ] = ( size_t )( llDuration / MICROSECONDS_PER_SECOND ) + 1;
+    aulCounts[ eHUDViewRideLogStream_LightSensor ] = ( size_t )( llDuration / ( 5 * MICROSECONDS_PER_SECOND ) ) + 1;
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        apllTimes[ iStream ] = malloc( aulCounts[ iStream ] * sizeof( int64_t ) );
+        apdValues[ iStream ] = malloc( aulCounts[ iStream ] * sizeof( double )
+                                       * iHUDViewRideLogColumns( ( eHUDViewRideLogStream_t )iStream ) );
+
+        if ( ( NULL == apllTimes[ iStream ] ) || ( NULL == apdValues[ iStream ] ) )
+        {
+            fprintf( stderr, "Out of memory\n" );
+            return -1;
+        }
+
+        aulCounts[ iStream ] = 0;
+    }
+
+    /* A synthetic ride with the precision the components actually deliver: 14-bit accelerometer counts printed with
+     * %f, one NMEA fix per second and an integer lux reading every five seconds. Sample times carry scheduling jitter.
+     * It is generated up front so only the encoder is timed. */
+    srand( 1 );
+
+    for ( llTime = 0; llTime < llDuration; llTime += llPeriod )
+    {
+        int64_t llStamp = llStart + llTime + ( rand() % 401 ) - 200;
+
+        iStream = eHUDViewRideLogStream_Accelerometer;
+        pdValues = &apdValues[ iStream ][ aulCounts[ iStream ] * 3 ];
+        apllTimes[ iStream ][ aulCounts[ iStream ]++ ] = llStamp;
+
+        for ( iAxis = 0; iAxis < 3; iAxis++ )
+        {
+            int iCounts = ( 2 == iAxis ) ? 4096 : 0;
+
+            iCounts += ( int )( 300.0 * sin( ( double )llTime / ( 1.7e6 + iAxis * 0.4e6 ) ) ) + ( rand() % 61 ) - 30;
+            snprintf( acText, sizeof( acText ), "%f", iCounts * 9.80665 / 4096.0 );
+            pdValues[ iAxis ] = strtod( acText, NULL );
+        }
+
+        if ( ( int64_t )aulCounts[ eHUDViewRideLogStream_GPS ] * MICROSECONDS_PER_SECOND <= llTime )
+        {
+            iStream = eHUDViewRideLogStream_GPS;
+            pdValues = &apdValues[ iStream ][ aulCounts[ iStream ] * 5 ];
+            apllTimes[ iStream ][ aulCounts[ iStream ]++ ] = llStamp;
+
+            dSpeed = 25.0 + 10.0 * sin( ( double )llTime / 300e6 );
+            dHeading = fmod( dHeading + ( rand() % 5 ) - 2 + 360.0, 360.0 );
+            dLatitude += dSpeed * cos( dHeading * M_PI / 180.0 ) / 3600.0;
+            dLongitude += dSpeed * sin( dHeading * M_PI / 180.0 ) / 3600.0;
+            pdValues[ 0 ] = 1.0;
+            snprintf( acText, sizeof( acText ), "%.4f", dLatitude );
+            pdValues[ 1 ] = strtod( acText, NULL );
+            snprintf( acText, sizeof( acText ), "%.4f", dLongitude );
+            pdValues[ 2 ] = strtod( acText, NULL );
+            snprintf( acText, sizeof( acText ), "%.1f", dSpeed );
+            pdValues[ 3 ] = strtod( acText, NULL );
+            snprintf( acText, sizeof( acText ), "%.1f", dHeading );
+            pdValues[ 4 ] = strtod( acText, NULL );
+        }
+
+        if ( ( int64_t )aulCounts[ eHUDViewRideLogStream_LightSensor ] * 5 * MICROSECONDS_PER_SECOND <= llTime )
+        {
+            iStream = eHUDViewRideLogStream_LightSensor;
+            apdValues[ iStream ][ aulCounts[ iStream ] ] = ( double )( 400 + rand() % 50 );
+            apllTimes[ iStream ][ aulCounts[ iStream ]++ ] = llStamp;
+        }
+    }
+
+    if ( 0 != iHUDViewRideLogOpen( &xWriter, pcPath ) )
+    {
+        fprintf( stderr, "Failed to create ride log: %s\n", pcPath );
+        return -1;
+    }
+
+    /* Feed the streams interleaved in time order, as Control does. */
+    dStart = dNow();
+
+    for ( ;; )
+    {
+        iNext = eHUDViewRideLogStreamMin;
+
+        for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+        {
+            if ( ( aulNext[ iStream ] < aulCounts[ iStream ] )
+                 && ( ( eHUDViewRideLogStreamMin == iNext )
+                      || ( apllTimes[ iStream ][ aulNext[ iStream ] ] < apllTimes[ iNext ][ aulNext[ iNext ] ] ) ) )
+            {
+                iNext = iStream;
+            }
+        }
+
+        if ( eHUDViewRideLogStreamMin == iNext )
+        {
+            break;
+        }
+
+        iHUDViewRideLogAppend( &xWriter, ( eHUDViewRideLogStream_t )iNext, apllTimes[ iNext ][ aulNext[ iNext ] ],
+                               &apdValues[ iNext ][ aulNext[ iNext ]
+                                                    * iHUDViewRideLogColumns( ( eHUDViewRideLogStream_t )iNext ) ] );
+        aulNext[ iNext ]++;
+    }
+
+    iHUDViewRideLogClose( &xWriter );
+    dSeconds = dNow() - dStart;
+
+    printf( "Synthetic ride: %.1f hours, accelerometer at %.0f Hz\n", dHours, dRate );
+    printf( "Encode:        %.2f M samples/s, %.1f MB/s of raw samples, including writes\n",
+            xWriter.ullSamples / dSeconds / 1e6, xWriter.ullRawBytes / dSeconds / 1e6 );
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        free( apllTimes[ iStream ] );
+        free( apdValues[ iStream ] );
+    }
+
+    if ( 0 != iOpenFile( pcPath, &xFile ) )
+    {
+        return -1;
+    }
+
+    pxCursor = malloc( sizeof( xCursor_t ) );
+
+    if ( NULL == pxCursor )
+    {
+        fprintf( stderr, "Out of memory\n" );
+        return -1;
+    }
+
+    for ( ulEntry = 0; ulEntry < xFile.ulEntries; ulEntry++ )
+    {
+        const xHUDViewRideLogIndexEntry_t * pxEntry = &xFile.pxEntries[ ulEntry ];
+        const xHUDViewRideLogChunk_t * pxChunk =
+            ( const xHUDViewRideLogChunk_t * )( xFile.pucFile + pxEntry->ullOffset );
+
+        aullSamples[ pxEntry->usStream ] += pxEntry->ulSamples;
+        aullBytes[ pxEntry->usStream ] += sizeof( xHUDViewRideLogChunk_t ) + pxChunk->ulPayloadBytes;
+    }
+
+    printf( "%-14s %10s %12s %12s %8s %14s\n", "stream", "samples", "raw bytes", "log bytes", "ratio", "scan Msps" );
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        unsigned long long ullRaw = aullSamples[ iStream ]
+                                    * ( 8 + 8 * iHUDViewRideLogColumns( ( eHUDViewRideLogStream_t )iStream ) );
+
+        /* A full scan decodes every chunk of the stream through the same path the exporters use. */
+        ullDecoded = 0;
+        dStart = dNow();
+
+        for ( vCursorStart( pxCursor, &xFile, ( eHUDViewRideLogStream_t )iStream, INT64_MIN ); bCursorValid( pxCursor );
+              vCursorNext( pxCursor ) )
+        {
+            dChecksum += pdCursorValues( pxCursor )[ 0 ];
+            ullDecoded++;
+        }
+
+        dSeconds = dNow() - dStart;
+        ullTotalRaw += ullRaw;
+
+        printf( "%-14s %10llu %12llu %12llu %7.2fx %14.2f\n",
+                pcHUDViewRideLogStreamName( ( eHUDViewRideLogStream_t )iStream ), aullSamples[ iStream ], ullRaw,
+                aullBytes[ iStream ], ( double )ullRaw / ( double )aullBytes[ iStream ], ullDecoded / dSeconds / 1e6 );
+    }
+
+    printf( "%-14s %10s %12llu %12zu %7.2fx\n", "total", "", ullTotalRaw, xFile.ulSize,
+            ( double )ullTotalRaw / ( double )xFile.ulSize );
+
+    /* A seek is a binary search of the index plus decoding the one chunk it lands in. */
+    dStart = dNow();
+
+    for ( iSeek = 0; iSeek < BENCH_SEEKS; iSeek++ )
+    {
+        vCursorStart( pxCursor, &xFile, eHUDViewRideLogStream_Accelerometer,
+                      llStart + ( int64_t )( ( double )rand() / RAND_MAX * llDuration ) );
+        dChecksum += bCursorValid( pxCursor ) ? pdCursorValues( pxCursor )[ 0 ] : 0.0;
+    }
+
+    dSeconds = dNow() - dStart;
+    printf( "Random seek:   %.2f us over %u accelerometer chunks (checksum %g)\n", dSeconds / BENCH_SEEKS * 1e6,
+            xFile.aulStreamEntries[ eHUDViewRideLogStream_Accelerometer ], dChecksum );
+
+    free( pxCursor );
+    vCloseFile( &xFile );
+
+    if ( !bKeep )
+    {
+        unlink( pcPath );
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iParseWindow( int iOption, int64_t * pllStart, int64_t * pllEnd )
+{
+    switch ( iOption )
+    {
+    case 's':
+        *pllStart = ( int64_t )( atof( optarg ) * MICROSECONDS_PER_SECOND );
+        return 0;
+
+    case 'e':
+        *pllEnd = ( int64_t )( atof( optarg ) * MICROSECONDS_PER_SECOND );
+        return 0;
+
+    default:
+        return -1;
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iOpenFile( const char * pcPath, xRideLogFile_t * pxFile )
+{
+    struct stat xStat;
+    int iDescriptor = open( pcPath, O_RDONLY );
+    uint32_t ulEntry = 0;
+    int iStream = 0;
+
+    memset( pxFile, 0, sizeof( xRideLogFile_t ) );
+
+    if ( ( 0 > iDescriptor ) || ( 0 != fstat( iDescriptor, &xStat ) ) || ( 0 == xStat.st_size ) )
+    {
+        fprintf( stderr, "Failed to open ride log: %s\n", pcPath );
+        return -1;
+    }
+
+    pxFile->ulSize = ( size_t )xStat.st_size;
+    pxFile->pucFile = mmap( NULL, pxFile->ulSize, PROT_READ, MAP_PRIVATE, iDescriptor, 0 );
+    close( iDescriptor );
+
+    if ( MAP_FAILED == pxFile->pucFile )
+    {
+        fprintf( stderr, "Failed to map ride log: %s\n", pcPath );
+        return -1;
+    }
+
+    if ( 0 != iHUDViewRideLogLoadIndex( pxFile->pucFile, pxFile->ulSize, &pxFile->pxEntries, &pxFile->ulEntries ) )
+    {
+        fprintf( stderr, "Not a ride log: %s\n", pcPath );
+        munmap( ( void * )pxFile->pucFile, pxFile->ulSize );
+        return -1;
+    }
+
+    pxFile->bIndexed = ( sizeof( xHUDViewRideLogFooter_t ) <= pxFile->ulSize )
+                       && ( HUDVIEW_RIDELOG_INDEX_MAGIC
+                            == ( ( const xHUDViewRideLogFooter_t * )( pxFile->pucFile + pxFile->ulSize
+                                                                    - sizeof( xHUDViewRideLogFooter_t ) ) )->ulMagic );
+
+    /* Split the index by stream; each stream's chunks were written, and so appear, in time order. */
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        pxFile->apxStreamEntries[ iStream ] =
+            malloc( ( pxFile->ulEntries + 1 ) * sizeof( xHUDViewRideLogIndexEntry_t ) );
+
+        if ( NULL == pxFile->apxStreamEntries[ iStream ] )
+        {
+            fprintf( stderr, "Out of memory\n" );
+            vCloseFile( pxFile );
+            return -1;
+        }
+    }
+
+    for ( ulEntry = 0; ulEntry < pxFile->ulEntries; ulEntry++ )
+    {
+        iStream = pxFile->pxEntries[ ulEntry ].usStream;
+
+        if ( ( eHUDViewRideLogStreamMin < iStream ) && ( eHUDViewRideLogStreamMax > iStream ) )
+        {
+            pxFile->apxStreamEntries[ iStream ][ pxFile->aulStreamEntries[ iStream ]++ ] = pxFile->pxEntries[ ulEntry ];
+        }
+    }
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vCloseFile( xRideLogFile_t * pxFile )
+{
+    int iStream = 0;
+
+    for ( iStream = eHUDViewRideLogStreamMin + 1; iStream < eHUDViewRideLogStreamMax; iStream++ )
+    {
+        free( pxFile->apxStreamEntries[ iStream ] );
+    }
+
+    free( pxFile->pxEntries );
+    munmap( ( void * )pxFile->pucFile, pxFile->ulSize );
+    memset( pxFile, 0, sizeof( xRideLogFile_t ) );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vCursorStart( xCursor_t * pxCursor, const xRideLogFile_t * pxFile, eHUDViewRideLogStream_t eStream,
+                          int64_t llStart )
+{
+    pxCursor->pxFile = pxFile;
+    pxCursor->eStream = eStream;
+    pxCursor->ulChunk = ulHUDViewRideLogSeek( pxFile->apxStreamEntries[ eStream ], pxFile->aulStreamEntries[ eStream ],
+                                              llStart );
+    pxCursor->iSamples = 0;
+    pxCursor->iSample = 0;
+
+    /* Decode the chunk the seek landed in and skip forward to the first sample in the window. */
+    if ( pxCursor->ulChunk < pxFile->aulStreamEntries[ eStream ] )
+    {
+        pxCursor->iSamples = iHUDViewRideLogDecode( pxFile->pucFile, pxFile->ulSize,
+                                                    &pxFile->apxStreamEntries[ eStream ][ pxCursor->ulChunk ],
+                                                    pxCursor->allMicroseconds, pxCursor->adValues );
+
+        while ( bCursorValid( pxCursor ) && ( llCursorTime( pxCursor ) < llStart ) )
+        {
+            vCursorNext( pxCursor );
+        }
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int bCursorValid( const xCursor_t * pxCursor )
+{
+    return pxCursor->iSample < pxCursor->iSamples;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int64_t llCursorTime( const xCursor_t * pxCursor )
+{
+    return pxCursor->allMicroseconds[ pxCursor->iSample ];
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static const double * pdCursorValues( const xCursor_t * pxCursor )
+{
+    return &pxCursor->adValues[ pxCursor->iSample * iHUDViewRideLogColumns( pxCursor->eStream ) ];
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vCursorNext( xCursor_t * pxCursor )
+{
+    const xRideLogFile_t * pxFile = pxCursor->pxFile;
+
+    pxCursor->iSample++;
+
+    /* Move on to the next chunk of the stream, skipping any that fail to decode. */
+    while ( ( pxCursor->iSample >= pxCursor->iSamples )
+            && ( pxCursor->ulChunk + 1 < pxFile->aulStreamEntries[ pxCursor->eStream ] ) )
+    {
+        pxCursor->ulChunk++;
+        pxCursor->iSample = 0;
+        pxCursor->iSamples = iHUDViewRideLogDecode( pxFile->pucFile, pxFile->ulSize,
+                                                    &pxFile->apxStreamEntries[ pxCursor->eStream ][ pxCursor->ulChunk ],
+                                                    pxCursor->allMicroseconds, pxCursor->adValues );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dNMEAToDegrees( double dNMEA )
+{
+    double dDegrees = floor( dNMEA / 100.0 );
+
+    return dDegrees + ( dNMEA - dDegrees * 100.0 ) / 60.0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dNow()
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( double )xNow.tv_sec + ( double )xNow.tv_nsec / 1e9;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s info ride_file\n"
+                     "       %s csv [-s start] [-e end] [-t accelerometer|gps|light] ride_file\n"
+                     "       %s gpx [-s start] [-e end] ride_file\n"
+                     "       %s bench [-H hours] [-r accelerometer_hz] [-o ride_file]\n",
+             pcProgram, pcProgram, pcProgram, pcProgram );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
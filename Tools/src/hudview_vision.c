@@ -0,0 +1,753 @@
+/** @file hudview_vision.c
+ *  @brief HUDView rear camera vision test and benchmark tool.
+ *
+ *  Clips are raw camera output as it arrives on the camera FIFO: 160x128 RGB888 frames, of which the top 120 rows
+ *  are the picture. "Control --record <dir>" saves the camera feed of a ride as <dir>/Camera.rgb.
+ *
+ *  Usage: hudview_vision synth [-t time_to_contact] [-n frames] [-f fps] [-r seed] [-N] -o clip
+ *         hudview_vision run [-t time_to_contact] [-f fps] [-N] [-v] clip
+ *         hudview_vision bench [-f fps] [-n repeats] [-b budget_ms] clip
+ *
+ *  The synth command renders a clip of a textured road scene receding behind a rider, with a textured object closing
+ *  in from behind that would reach the camera the given number of seconds after the first frame (none if zero);
+ *  with -N it is a night scene of street lights and the headlights of the approaching vehicle instead. The run
+ *  command processes a clip as Control does, with the optical flow or with -N the headlight tracker, and reports
+ *  every alert; given the clip's true time to contact it also scores the estimates against it and reports how much
+ *  warning the alert gave. The bench command times both detectors per frame with the SIMD kernels and with the
+ *  scalar fallback, and checks that the two agree and that the p99 of the detectors Control runs stays within the
+ *  per-frame budget (30 ms by default), which leaves the rest of a frame to the display path.
+ */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hudview_flow.h"
+#include "hudview_headlights.h"
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#define CLIP_WIDTH              ( 160 )
+#define CLIP_HEIGHT             ( 120 )
+#define CLIP_PADDED_HEIGHT      ( 128 )
+#define CLIP_FRAME_BYTES        ( CLIP_WIDTH * CLIP_PADDED_HEIGHT * 3 )
+#define TEXTURE_SIZE            ( 256 )
+#define SYNTH_OBJECT_HALF_SIZE  ( 8.0 )
+#define SYNTH_OBJECT_MAXIMUM    ( 40.0 )
+#define SYNTH_RECEDE_PER_FRAME  ( 0.004 )
+#define BENCH_PATHS             ( 4 )
+#define BENCH_BUDGET_MS         ( 30.0 )
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+typedef struct {
+    uint8_t * pucFrames;
+    int iFrames;
+} xClip_t;
+
+/* What either detector made of a frame, in common terms. */
+typedef struct {
+    int bValid;
+    int bApproaching;
+    int bAlert;
+    int bAlertChanged;
+    double dTimeToContact;
+    int iRegionX;
+    int iRegionY;
+    int iRegionWidth;
+    int iRegionHeight;
+    char acDetail[ 64 ];
+} xOutcome_t;
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iSynth( int argc, char ** argv );
+static int iRun( int argc, char ** argv );
+static int iBench( int argc, char ** argv );
+static void vProcessFrame( int bNight, xHUDViewFlow_t * pxFlow, xHUDViewHeadlights_t * pxHeadlights,
+                           const uint8_t * pucLuma, int64_t llMicroseconds, xOutcome_t * pxOutcome );
+static int iLoadClip( const char * pcPath, xClip_t * pxClip );
+static double dNightPixel( double dX, double dY, double dScale, double dHalfSize );
+static void vMakeTexture( uint8_t * pucTexture, int iSpacing );
+static double dSampleTexture( const uint8_t * pucTexture, double dU, double dV );
+static double dGaussian( void );
+static double dNow( void );
+static int iCompareDoubles( const void * pvA, const void * pvB );
+static void vUsage( const char * pcProgram );
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    if ( 2 > argc )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* Each command parses its own options after the command name. */
+    optind = 2;
+
+    if ( 0 == strcmp( argv[ 1 ], "synth" ) )
+    {
+        return iSynth( argc, argv );
+    }
+    else if ( 0 == strcmp( argv[ 1 ], "run" ) )
+    {
+        return iRun( argc, argv );
+    }
+    else if ( 0 == strcmp( argv[ 1 ], "bench" ) )
+    {
+        return iBench( argc, argv );
+    }
+
+    vUsage( argv[ 0 ] );
+
+    return -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iSynth( int argc, char ** argv )
+{
+    static uint8_t aucBackground[ TEXTURE_SIZE * TEXTURE_SIZE ];
+    static uint8_t aucObject[ TEXTURE_SIZE * TEXTURE_SIZE ];
+    static uint8_t aucFrame[ CLIP_FRAME_BYTES ];
+    const char * pcPath = NULL;
+    double dTimeToContact = 5.0;
+    double dFramesPerSecond = 10.0;
+    int iFrames = 0;
+    unsigned int uiSeed = 1;
+    int bNight = 0;
+    FILE * pxClip = NULL;
+    int iOption = 0;
+    int iFrame = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "t:n:f:r:No:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'N':
+            bNight = 1;
+            break;
+
+        case 't':
+            dTimeToContact = atof( optarg );
+            break;
+
+        case 'n':
+            iFrames = atoi( optarg );
+            break;
+
+        case 'f':
+            dFramesPerSecond = atof( optarg );
+            break;
+
+        case 'r':
+            uiSeed = ( unsigned int )atoi( optarg );
+            break;
+
+        case 'o':
+            pcPath = optarg;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( NULL == pcPath ) || ( 0.0 > dTimeToContact ) || ( 0.0 >= dFramesPerSecond ) || ( 0 > iFrames ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    /* By default, run until the object fills a good part of the picture, or for ten seconds without one. */
+    if ( 0 == iFrames )
+    {
+        double dSeconds = ( 0.0 < dTimeToContact )
+                          ? ( 1.0 - SYNTH_OBJECT_HALF_SIZE / SYNTH_OBJECT_MAXIMUM ) * dTimeToContact
+                          : 10.0;
+
+        iFrames = ( int )( dSeconds * dFramesPerSecond );
+    }
+
+    pxClip = fopen( pcPath, "wb" );
+
+    if ( NULL == pxClip )
+    {
+        fprintf( stderr, "Failed to create clip: %s\n", pcPath );
+        return -1;
+    }
+
+    srand( uiSeed );
+    vMakeTexture( aucBackground, 4 );
+    vMakeTexture( aucObject, 2 );
+
+    for ( iFrame = 0; iFrame < iFrames; iFrame++ )
+    {
+        double dTime = iFrame / dFramesPerSecond;
+        double dScale = pow( 1.0 - SYNTH_RECEDE_PER_FRAME, iFrame );
+        double dHalfSize = 0.0;
+        double dJitterX = 0.5 * dGaussian();
+        double dJitterY = 0.5 * dGaussian();
+
+        /* Apparent size is inversely proportional to distance, which shrinks linearly at a constant closing speed. */
+        if ( ( 0.0 < dTimeToContact ) && ( dTime < dTimeToContact ) )
+        {
+            dHalfSize = fmin( SYNTH_OBJECT_MAXIMUM,
+                              SYNTH_OBJECT_HALF_SIZE * dTimeToContact / ( dTimeToContact - dTime ) );
+        }
+
+        memset( aucFrame, 0, sizeof( aucFrame ) );
+
+        for ( int iY = 0; iY < CLIP_HEIGHT; iY++ )
+        {
+            for ( int iX = 0; iX < CLIP_WIDTH; iX++ )
+            {
+                double dX = iX - CLIP_WIDTH / 2 + dJitterX;
+                double dY = iY - CLIP_HEIGHT / 2 + dJitterY;
+                double dValue = 0.0;
+                uint8_t * pucPixel = &aucFrame[ ( iY * CLIP_WIDTH + iX ) * 3 ];
+
+                if ( bNight )
+                {
+                    dValue = dNightPixel( dX, dY, dScale, dHalfSize );
+                }
+                else if ( ( fabs( dX ) <= dHalfSize ) && ( fabs( dY - 4.0 ) <= dHalfSize ) )
+                {
+                    dValue = dSampleTexture( aucObject, dX * SYNTH_OBJECT_HALF_SIZE / dHalfSize + TEXTURE_SIZE / 2,
+                                             ( dY - 4.0 ) * SYNTH_OBJECT_HALF_SIZE / dHalfSize + TEXTURE_SIZE / 2 );
+                }
+                else
+                {
+                    dValue = dSampleTexture( aucBackground, dX / dScale + TEXTURE_SIZE / 2,
+                                             dY / dScale + TEXTURE_SIZE / 2 );
+                }
+
+                dValue = fmax( 0.0, fmin( 255.0, dValue + 2.0 * dGaussian() ) );
+                pucPixel[ 0 ] = pucPixel[ 1 ] = pucPixel[ 2 ] = ( uint8_t )dValue;
+            }
+        }
+
+        if ( 1 != fwrite( aucFrame, sizeof( aucFrame ), 1, pxClip ) )
+        {
+            fprintf( stderr, "Failed to write clip: %s\n", pcPath );
+            fclose( pxClip );
+            return -1;
+        }
+    }
+
+    fclose( pxClip );
+    printf( "Wrote %d frames at %.0f fps to %s\n", iFrames, dFramesPerSecond, pcPath );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iRun( int argc, char ** argv )
+{
+    static xHUDViewFlow_t xFlow;
+    static xHUDViewHeadlights_t xHeadlights;
+    static uint8_t aucLuma[ CLIP_WIDTH * CLIP_HEIGHT ];
+    xOutcome_t xOutcome;
+    xClip_t xClip;
+    double dTimeToContact = 0.0;
+    double dFramesPerSecond = 10.0;
+    double * pdErrors = NULL;
+    double dWarning = -1.0;
+    double dTotal = 0.0;
+    double dMaximum = 0.0;
+    int iScored = 0;
+    int iApproachFrames = 0;
+    unsigned long ulAlerts = 0;
+    int bNight = 0;
+    int bVerbose = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "t:f:Nv" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 't':
+            dTimeToContact = atof( optarg );
+            break;
+
+        case 'f':
+            dFramesPerSecond = atof( optarg );
+            break;
+
+        case 'N':
+            bNight = 1;
+            break;
+
+        case 'v':
+            bVerbose = 1;
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( optind >= argc ) || ( 0.0 >= dFramesPerSecond ) || ( 0 != iLoadClip( argv[ optind ], &xClip ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    pdErrors = malloc( ( size_t )xClip.iFrames * sizeof( double ) );
+
+    if ( NULL == pdErrors )
+    {
+        fprintf( stderr, "Out of memory\n" );
+        free( xClip.pucFrames );
+        return -1;
+    }
+
+    vHUDViewFlowInit( &xFlow );
+    vHUDViewHeadlightsInit( &xHeadlights );
+
+    for ( int iFrame = 0; iFrame < xClip.iFrames; iFrame++ )
+    {
+        double dTime = iFrame / dFramesPerSecond;
+        double dTruth = dTimeToContact - dTime;
+        double dStart = dNow();
+        double dMilliseconds = 0.0;
+
+        vHUDViewFlowLumaFromRGB888( &xClip.pucFrames[ ( size_t )iFrame * CLIP_FRAME_BYTES ], aucLuma,
+                                    CLIP_WIDTH * CLIP_HEIGHT );
+        vProcessFrame( bNight, &xFlow, &xHeadlights, aucLuma, ( int64_t )( dTime * 1e6 ) + 1, &xOutcome );
+        dMilliseconds = ( dNow() - dStart ) * 1e3;
+        dTotal += dMilliseconds;
+        dMaximum = fmax( dMaximum, dMilliseconds );
+
+        if ( !xOutcome.bValid )
+        {
+            continue;
+        }
+
+        iApproachFrames += xOutcome.bApproaching ? 1 : 0;
+
+        if ( bVerbose )
+        {
+            printf( "%5d %7.2f s  %s  ttc %6.2f s", iFrame, dTime, xOutcome.acDetail, xOutcome.dTimeToContact );
+
+            if ( 0.0 < dTimeToContact )
+            {
+                printf( " (true %5.2f s)", dTruth );
+            }
+
+            printf( "%s\n", xOutcome.bAlert ? "  ALERT" : "" );
+        }
+
+        /* Score the estimate while the truth is within alert range, which is where it matters. Single frames can be
+         * far off while the object is still small, so the median relative error is what is reported. */
+        if ( ( 0.0 < dTimeToContact ) && ( 0.0 < dTruth ) && ( HUDVIEW_FLOW_ALERT_SECONDS >= dTruth )
+             && ( 0.0 < xOutcome.dTimeToContact ) )
+        {
+            pdErrors[ iScored++ ] = fabs( xOutcome.dTimeToContact - dTruth ) / dTruth;
+        }
+
+        if ( xOutcome.bAlertChanged )
+        {
+            printf( "Frame %d (%.2f s): alert %s, time to contact %.2f s at %d,%d %dx%d\n", iFrame, dTime,
+                    xOutcome.bAlert ? "raised" : "cleared", xOutcome.dTimeToContact, xOutcome.iRegionX,
+                    xOutcome.iRegionY, xOutcome.iRegionWidth, xOutcome.iRegionHeight );
+
+            if ( xOutcome.bAlert )
+            {
+                ulAlerts++;
+
+                if ( ( 0.0 > dWarning ) && ( 0.0 < dTimeToContact ) )
+                {
+                    dWarning = dTruth;
+                }
+            }
+        }
+    }
+
+    printf( "%d frames, %d approaching, %lu alerts (%s); %.2f ms per frame on average, %.2f ms at most\n",
+            xClip.iFrames, iApproachFrames, ulAlerts, bNight ? "headlights" : "optical flow",
+            ( 0 < xClip.iFrames ) ? dTotal / xClip.iFrames : 0.0, dMaximum );
+
+    if ( 0.0 < dTimeToContact )
+    {
+        qsort( pdErrors, ( size_t )iScored, sizeof( double ), iCompareDoubles );
+        printf( "Time to contact median error within %.0f s of contact: %.0f%% over %d frames\n",
+                HUDVIEW_FLOW_ALERT_SECONDS, ( 0 < iScored ) ? 100.0 * pdErrors[ iScored / 2 ] : 0.0, iScored );
+
+        if ( 0.0 <= dWarning )
+        {
+            printf( "First alert %.2f s before contact\n", dWarning );
+        }
+        else
+        {
+            printf( "No alert before contact\n" );
+        }
+    }
+
+    free( pdErrors );
+    free( xClip.pucFrames );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iBench( int argc, char ** argv )
+{
+    static xHUDViewFlow_t axFlows[ 2 ];
+    static xHUDViewHeadlights_t axHeadlights[ 2 ];
+    static uint8_t aucLuma[ CLIP_WIDTH * CLIP_HEIGHT ];
+    xHUDViewFlowResult_t axFlowResults[ 2 ];
+    xHUDViewHeadlightsResult_t axHeadlightsResults[ 2 ];
+    xClip_t xClip;
+    double dFramesPerSecond = 10.0;
+    double dBudgetMilliseconds = BENCH_BUDGET_MS;
+    double * apdMilliseconds[ BENCH_PATHS ] = { NULL };
+    const char * apcNames[ BENCH_PATHS ] = { "flow", "flow", "lights", "lights" };
+    const char * apcKernels[ BENCH_PATHS ] = { pcHUDViewFlowKernels(), "scalar", pcHUDViewHeadlightsKernels(),
+                                               "scalar" };
+    double adMean[ BENCH_PATHS ] = { 0.0 };
+    int iRepeats = 20;
+    int iSamples = 0;
+    unsigned long aulMismatches[ 2 ] = { 0, 0 };
+    int iOverBudget = 0;
+    int iOption = 0;
+
+    while ( -1 != ( iOption = getopt( argc, argv, "b:f:n:" ) ) )
+    {
+        switch ( iOption )
+        {
+        case 'b':
+            dBudgetMilliseconds = atof( optarg );
+            break;
+
+        case 'f':
+            dFramesPerSecond = atof( optarg );
+            break;
+
+        case 'n':
+            iRepeats = atoi( optarg );
+            break;
+
+        default:
+            vUsage( argv[ 0 ] );
+            return -1;
+        }
+    }
+
+    if ( ( optind >= argc ) || ( 0.0 >= dFramesPerSecond ) || ( 0 >= iRepeats ) || ( 0.0 >= dBudgetMilliseconds )
+         || ( 0 != iLoadClip( argv[ optind ], &xClip ) ) )
+    {
+        vUsage( argv[ 0 ] );
+        return -1;
+    }
+
+    for ( int iPath = 0; iPath < BENCH_PATHS; iPath++ )
+    {
+        apdMilliseconds[ iPath ] = malloc( ( size_t )xClip.iFrames * iRepeats * sizeof( double ) );
+
+        if ( NULL == apdMilliseconds[ iPath ] )
+        {
+            fprintf( stderr, "Out of memory\n" );
+            return -1;
+        }
+    }
+
+    vHUDViewFlowInit( &axFlows[ 0 ] );
+    vHUDViewFlowInit( &axFlows[ 1 ] );
+    vHUDViewFlowSetScalar( &axFlows[ 1 ], 1 );
+    vHUDViewHeadlightsInit( &axHeadlights[ 0 ] );
+    vHUDViewHeadlightsInit( &axHeadlights[ 1 ] );
+    vHUDViewHeadlightsSetScalar( &axHeadlights[ 1 ], 1 );
+
+    /* All paths see the same frames: the day path (optical flow) and the night path (headlights), each with the SIMD
+     * and the scalar kernels. Control gets luma with the RGB565 conversion, so only the detectors are timed. */
+    for ( int iRepeat = 0; iRepeat < iRepeats; iRepeat++ )
+    {
+        for ( int iFrame = 0; iFrame < xClip.iFrames; iFrame++ )
+        {
+            int64_t llMicroseconds = ( int64_t )( ( iRepeat * xClip.iFrames + iFrame ) * 1e6 / dFramesPerSecond ) + 1;
+
+            vHUDViewFlowLumaFromRGB888( &xClip.pucFrames[ ( size_t )iFrame * CLIP_FRAME_BYTES ], aucLuma,
+                                        CLIP_WIDTH * CLIP_HEIGHT );
+
+            for ( int iPath = 0; iPath < BENCH_PATHS; iPath++ )
+            {
+                double dStart = dNow();
+
+                if ( 2 > iPath )
+                {
+                    iHUDViewFlowProcess( &axFlows[ iPath ], aucLuma, llMicroseconds, &axFlowResults[ iPath ] );
+                }
+                else
+                {
+                    iHUDViewHeadlightsProcess( &axHeadlights[ iPath - 2 ], aucLuma, llMicroseconds,
+                                               &axHeadlightsResults[ iPath - 2 ] );
+                }
+
+                apdMilliseconds[ iPath ][ iSamples ] = ( dNow() - dStart ) * 1e3;
+                adMean[ iPath ] += apdMilliseconds[ iPath ][ iSamples ];
+            }
+
+            /* The kernels must agree exactly: same pyramid, same costs, same flow; same mask, same blobs. */
+            if ( ( 0 != memcmp( axFlows[ 0 ].afFlowX, axFlows[ 1 ].afFlowX, sizeof( axFlows[ 0 ].afFlowX ) ) )
+                 || ( 0 != memcmp( axFlows[ 0 ].afFlowY, axFlows[ 1 ].afFlowY, sizeof( axFlows[ 0 ].afFlowY ) ) )
+                 || ( axFlowResults[ 0 ].bLooming != axFlowResults[ 1 ].bLooming ) )
+            {
+                aulMismatches[ 0 ]++;
+            }
+
+            if ( 0 != memcmp( &axHeadlightsResults[ 0 ], &axHeadlightsResults[ 1 ],
+                              sizeof( axHeadlightsResults[ 0 ] ) ) )
+            {
+                aulMismatches[ 1 ]++;
+            }
+
+            iSamples++;
+        }
+    }
+
+    printf( "%d frames x %d repeats at %.0f fps, budget %g ms per frame\n", xClip.iFrames, iRepeats,
+            dFramesPerSecond, dBudgetMilliseconds );
+
+    for ( int iPath = 0; iPath < BENCH_PATHS; iPath++ )
+    {
+        double dP99 = 0.0;
+
+        qsort( apdMilliseconds[ iPath ], ( size_t )iSamples, sizeof( double ), iCompareDoubles );
+        dP99 = apdMilliseconds[ iPath ][ ( int )( iSamples * 0.99 ) ];
+        printf( "  %-6s %-7s mean %6.3f ms  p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms\n", apcNames[ iPath ],
+                apcKernels[ iPath ], adMean[ iPath ] / iSamples, apdMilliseconds[ iPath ][ iSamples / 2 ], dP99,
+                apdMilliseconds[ iPath ][ iSamples - 1 ] );
+
+        /* Only the kernels Control runs count against the budget; the forced scalar paths are for comparison. */
+        if ( ( 0 == ( iPath % 2 ) ) && ( dP99 > dBudgetMilliseconds ) )
+        {
+            fprintf( stderr, "FAIL: %s p99 %.3f ms over the %g ms budget\n", apcNames[ iPath ], dP99,
+                     dBudgetMilliseconds );
+            iOverBudget++;
+        }
+    }
+
+    printf( "  flow speedup %.2fx, %lu frames where the kernels disagree\n", adMean[ 1 ] / adMean[ 0 ],
+            aulMismatches[ 0 ] );
+    printf( "  lights speedup %.2fx, %lu frames where the kernels disagree; %.1fx cheaper than flow\n",
+            adMean[ 3 ] / adMean[ 2 ], aulMismatches[ 1 ], adMean[ 0 ] / adMean[ 2 ] );
+
+    for ( int iPath = 0; iPath < BENCH_PATHS; iPath++ )
+    {
+        free( apdMilliseconds[ iPath ] );
+    }
+
+    free( xClip.pucFrames );
+
+    return ( ( 0 == aulMismatches[ 0 ] ) && ( 0 == aulMismatches[ 1 ] ) && ( 0 == iOverBudget ) ) ? 0 : -1;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vProcessFrame( int bNight, xHUDViewFlow_t * pxFlow, xHUDViewHeadlights_t * pxHeadlights,
+                           const uint8_t * pucLuma, int64_t llMicroseconds, xOutcome_t * pxOutcome )
+{
+    memset( pxOutcome, 0, sizeof( *pxOutcome ) );
+
+    if ( bNight )
+    {
+        xHUDViewHeadlightsResult_t xResult;
+
+        pxOutcome->bValid = iHUDViewHeadlightsProcess( pxHeadlights, pucLuma, llMicroseconds, &xResult );
+        pxOutcome->bApproaching = xResult.bClosing;
+        pxOutcome->bAlert = xResult.bAlert;
+        pxOutcome->bAlertChanged = xResult.bAlertChanged;
+        snprintf( pxOutcome->acDetail, sizeof( pxOutcome->acDetail ), "%2d blobs  %d vehicles", xResult.iBlobs,
+                  xResult.iMarkers );
+
+        /* Report the nearest vehicle that is getting closer at all, not only one close enough to alert for. */
+        for ( int iMarker = 0; iMarker < xResult.iMarkers; iMarker++ )
+        {
+            const xHUDViewHeadlightsMarker_t * pxMarker = &xResult.axMarkers[ iMarker ];
+            double dNearest = pxOutcome->dTimeToContact;
+            double dMarker = pxMarker->dTimeToContact;
+
+            if ( ( 0.0 < dMarker ) && ( ( 0.0 == dNearest ) || ( dMarker < dNearest ) ) )
+            {
+                pxOutcome->dTimeToContact = pxMarker->dTimeToContact;
+                pxOutcome->iRegionX = pxMarker->iX;
+                pxOutcome->iRegionY = pxMarker->iY;
+                pxOutcome->iRegionWidth = pxMarker->iWidth;
+                pxOutcome->iRegionHeight = pxMarker->iHeight;
+            }
+        }
+    }
+    else
+    {
+        xHUDViewFlowResult_t xResult;
+
+        pxOutcome->bValid = iHUDViewFlowProcess( pxFlow, pucLuma, llMicroseconds, &xResult );
+        pxOutcome->bApproaching = xResult.bLooming;
+        pxOutcome->bAlert = xResult.bAlert;
+        pxOutcome->bAlertChanged = xResult.bAlertChanged;
+        pxOutcome->dTimeToContact = xResult.dTimeToContact;
+        pxOutcome->iRegionX = xResult.iRegionX;
+        pxOutcome->iRegionY = xResult.iRegionY;
+        pxOutcome->iRegionWidth = xResult.iRegionWidth;
+        pxOutcome->iRegionHeight = xResult.iRegionHeight;
+        snprintf( pxOutcome->acDetail, sizeof( pxOutcome->acDetail ), "%3d blocks  divergence %+.4f",
+                  xResult.iTrackedBlocks, xResult.dDivergence );
+    }
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iLoadClip( const char * pcPath, xClip_t * pxClip )
+{
+    FILE * pxFile = fopen( pcPath, "rb" );
+    long lSize = 0;
+
+    memset( pxClip, 0, sizeof( *pxClip ) );
+
+    if ( NULL == pxFile )
+    {
+        fprintf( stderr, "Failed to open clip: %s\n", pcPath );
+        return -1;
+    }
+
+    /* A trailing partial frame, e.g. from a recording cut short, is ignored. */
+    fseek( pxFile, 0, SEEK_END );
+    lSize = ftell( pxFile );
+    rewind( pxFile );
+    pxClip->iFrames = ( int )( lSize / CLIP_FRAME_BYTES );
+    pxClip->pucFrames = malloc( ( size_t )pxClip->iFrames * CLIP_FRAME_BYTES + 1 );
+
+    if ( ( NULL == pxClip->pucFrames ) || ( 0 == pxClip->iFrames )
+         || ( ( size_t )pxClip->iFrames != fread( pxClip->pucFrames, CLIP_FRAME_BYTES, ( size_t )pxClip->iFrames,
+                                                   pxFile ) ) )
+    {
+        fprintf( stderr, "Failed to read clip: %s\n", pcPath );
+        free( pxClip->pucFrames );
+        pxClip->pucFrames = NULL;
+        fclose( pxFile );
+        return -1;
+    }
+
+    fclose( pxFile );
+
+    return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vMakeTexture( uint8_t * pucTexture, int iSpacing )
+{
+    int iCells = TEXTURE_SIZE / iSpacing + 1;
+    uint8_t * pucGrid = malloc( ( size_t )( iCells * iCells ) );
+
+    /* Value noise: random levels on a coarse grid, interpolated in between, so there is texture at every scale. */
+    for ( int iCell = 0; iCell < iCells * iCells; iCell++ )
+    {
+        pucGrid[ iCell ] = ( uint8_t )( 32 + rand() % 192 );
+    }
+
+    for ( int iY = 0; iY < TEXTURE_SIZE; iY++ )
+    {
+        for ( int iX = 0; iX < TEXTURE_SIZE; iX++ )
+        {
+            int iCellX = iX / iSpacing;
+            int iCellY = iY / iSpacing;
+            double dFractionX = ( iX % iSpacing ) / ( double )iSpacing;
+            double dFractionY = ( iY % iSpacing ) / ( double )iSpacing;
+            double dTop = pucGrid[ iCellY * iCells + iCellX ] * ( 1.0 - dFractionX )
+                          + pucGrid[ iCellY * iCells + iCellX + 1 ] * dFractionX;
+            double dBottom = pucGrid[ ( iCellY + 1 ) * iCells + iCellX ] * ( 1.0 - dFractionX )
+                             + pucGrid[ ( iCellY + 1 ) * iCells + iCellX + 1 ] * dFractionX;
+
+            pucTexture[ iY * TEXTURE_SIZE + iX ] = ( uint8_t )( dTop * ( 1.0 - dFractionY ) + dBottom * dFractionY );
+        }
+    }
+
+    free( pucGrid );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dSampleTexture( const uint8_t * pucTexture, double dU, double dV )
+{
+    int iU = ( int )floor( dU );
+    int iV = ( int )floor( dV );
+    double dFractionU = dU - iU;
+    double dFractionV = dV - iV;
+    int iU0 = ( ( iU % TEXTURE_SIZE ) + TEXTURE_SIZE ) % TEXTURE_SIZE;
+    int iV0 = ( ( iV % TEXTURE_SIZE ) + TEXTURE_SIZE ) % TEXTURE_SIZE;
+    int iU1 = ( iU0 + 1 ) % TEXTURE_SIZE;
+    int iV1 = ( iV0 + 1 ) % TEXTURE_SIZE;
+
+    return ( pucTexture[ iV0 * TEXTURE_SIZE + iU0 ] * ( 1.0 - dFractionU )
+             + pucTexture[ iV0 * TEXTURE_SIZE + iU1 ] * dFractionU ) * ( 1.0 - dFractionV )
+           + ( pucTexture[ iV1 * TEXTURE_SIZE + iU0 ] * ( 1.0 - dFractionU )
+               + pucTexture[ iV1 * TEXTURE_SIZE + iU1 ] * dFractionU ) * dFractionV;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dNightPixel( double dX, double dY, double dScale, double dHalfSize )
+{
+    /* Street lights fixed in the scene behind, receding with it, and the headlights of the approaching vehicle. */
+    static const double aadLamps[ 4 ][ 2 ] = { { -60.0, -40.0 }, { 55.0, -35.0 }, { -25.0, -50.0 }, { 30.0, 20.0 } };
+    double dValue = 12.0;
+
+    for ( int iLamp = 0; iLamp < 4; iLamp++ )
+    {
+        double dDistance = hypot( dX - aadLamps[ iLamp ][ 0 ] * dScale, dY - aadLamps[ iLamp ][ 1 ] * dScale );
+
+        dValue = fmax( dValue, 255.0 * fmin( 1.0, fmax( 0.0, 1.0 - ( dDistance - 2.5 * dScale ) / 2.0 ) ) );
+    }
+
+    /* The lights are a fixed fraction of the vehicle's apparent size apart, with a soft edge like a real glare. */
+    if ( 0.0 < dHalfSize )
+    {
+        for ( int iSide = -1; iSide <= 1; iSide += 2 )
+        {
+            double dDistance = hypot( dX - iSide * 1.5 * dHalfSize, dY - 4.0 );
+
+            dValue = fmax( dValue, 255.0 * fmin( 1.0, fmax( 0.0, 1.0 - ( dDistance - 0.35 * dHalfSize ) / 2.0 ) ) );
+        }
+    }
+
+    return dValue;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dGaussian( void )
+{
+    double dU1 = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+    double dU2 = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+
+    return sqrt( -2.0 * log( dU1 ) ) * cos( 2.0 * M_PI * dU2 );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static double dNow( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return xNow.tv_sec + xNow.tv_nsec / 1e9;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static int iCompareDoubles( const void * pvA, const void * pvB )
+{
+    double dA = *( const double * )pvA;
+    double dB = *( const double * )pvB;
+
+    return ( dA > dB ) - ( dA < dB );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+static void vUsage( const char * pcProgram )
+{
+    fprintf( stderr, "Usage: %s synth [-t time_to_contact] [-n frames] [-f fps] [-r seed] [-N] -o clip\n",
+             pcProgram );
+    fprintf( stderr, "       %s run [-t time_to_contact] [-f fps] [-N] [-v] clip\n", pcProgram );
+    fprintf( stderr, "       %s bench [-f fps] [-n repeats] [-b budget_ms] clip\n", pcProgram );
+}
+/*--------------------------------------------------------------------------------------------------------------------*/